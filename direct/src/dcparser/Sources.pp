@@ -31,6 +31,7 @@
      dcPacker.h dcPacker.I \
      dcPackerCatalog.h dcPackerCatalog.I \
      dcPackerInterface.h dcPackerInterface.I \
+     dcPackProgram.h dcPackProgram.I \
      dcParameter.h dcClassParameter.h dcArrayParameter.h \
      dcSimpleParameter.h dcSwitchParameter.h \
      dcNumericRange.h dcNumericRange.I \
@@ -50,6 +51,7 @@
      dcPacker.cxx \
      dcPackerCatalog.cxx \
      dcPackerInterface.cxx \
+     dcPackProgram.cxx \
      dcParameter.cxx dcClassParameter.cxx dcArrayParameter.cxx \
      dcSimpleParameter.cxx dcSwitchParameter.cxx \
      dcSwitch.cxx \
@@ -62,3 +64,13 @@
 
   #define IGATESCAN all
 #end lib_target
+
+#begin test_bin_target
+  #define TARGET test_dcPackProgram
+  #define LOCAL_LIBS p3dcparser $[LOCAL_LIBS]
+  #define OTHER_LIBS $[OTHER_LIBS] p3pystub
+
+  #define SOURCES \
+    test_dcPackProgram.cxx
+
+#end test_bin_target
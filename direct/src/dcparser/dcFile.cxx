@@ -19,6 +19,7 @@
 #include "dcLexerDefs.h"
 #include "dcTypedef.h"
 #include "dcKeyword.h"
+#include "dcPackProgram.h"
 #include "hashGenerator.h"
 
 #ifdef WITHIN_PANDA
@@ -185,11 +186,17 @@ read(Filename filename) {
 bool DCFile::
 read(istream &in, const string &filename) {
   cerr << "DCFile::read of " << filename << "\n";
+  int first_new_field = (int)_fields_by_index.size();
   dc_init_parser(in, filename, *this);
   dcyyparse();
   dc_cleanup_parser();
 
-  return (dc_error_count() == 0);
+  if (dc_error_count() != 0) {
+    return false;
+  }
+
+  make_pack_programs(first_new_field);
+  return true;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -688,6 +695,30 @@ set_new_index_number(DCField *field) {
   _fields_by_index.push_back(field);
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: DCFile::make_pack_programs
+//       Access: Private
+//  Description: Precomputes the DCPackProgram for each atomic and
+//               molecular field defined since the indicated field
+//               index, so that DCPacker can pack and unpack those
+//               with a fixed layout without walking their
+//               definitions each time.
+////////////////////////////////////////////////////////////////////
+void DCFile::
+make_pack_programs(int first_field) {
+  if (!dc_pack_programs) {
+    return;
+  }
+
+  for (int i = first_field; i < (int)_fields_by_index.size(); ++i) {
+    DCField *field = _fields_by_index[i];
+    if (field->as_atomic_field() != (DCAtomicField *)NULL ||
+        field->as_molecular_field() != (DCMolecularField *)NULL) {
+      field->make_pack_program();
+    }
+  }
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: DCFile::setup_default_keywords
 //       Access: Private
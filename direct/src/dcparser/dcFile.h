@@ -89,6 +89,7 @@ public:
 private:
   void setup_default_keywords();
   void rebuild_inherited_fields();
+  void make_pack_programs(int first_field);
 
   typedef pvector<DCClass *> Classes;
   Classes _classes;
@@ -0,0 +1,161 @@
+// Filename: dcPackProgram.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "dcPackProgram.h"
+#include "dcField.h"
+#include "dcParameter.h"
+#include "dcSimpleParameter.h"
+
+#ifdef WITHIN_PANDA
+
+ConfigVariableBool dc_pack_programs
+("dc-pack-programs", true,
+ PRC_DESC("Set this true to precompute a flat packing program for each "
+          "field in the dc file whose packed form has a fixed size, which "
+          "DCPacker can follow much more quickly than it can walk the "
+          "field's definition.  The packed data is the same either way."));
+
+#endif  // WITHIN_PANDA
+
+////////////////////////////////////////////////////////////////////
+//     Function: DCPackProgram::Constructor
+//       Access: Private
+//  Description:
+////////////////////////////////////////////////////////////////////
+DCPackProgram::
+DCPackProgram() {
+  _fixed_byte_size = 0;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: DCPackProgram::make_program
+//       Access: Public, Static
+//  Description: Returns a newly-allocated program for packing the
+//               indicated field, or NULL if the field's layout is not
+//               fixed (or is too large to be worth flattening).
+////////////////////////////////////////////////////////////////////
+DCPackProgram *DCPackProgram::
+make_program(const DCPackerInterface *root) {
+  if (!root->has_fixed_byte_size() || !root->has_fixed_structure() ||
+      !root->has_nested_fields()) {
+    return NULL;
+  }
+
+  DCPackProgram *program = new DCPackProgram;
+  if (!program->r_add_steps(root, NULL, 0, 0)) {
+    delete program;
+    return NULL;
+  }
+
+  // After the root has been popped, DCPacker is left with nothing
+  // current, one past the root.
+  program->add_step(SK_end, NULL, NULL, 1, 0);
+  program->_steps.back()._next = (int)program->_steps.size() - 1;
+  program->_fixed_byte_size = root->get_fixed_byte_size();
+
+  return program;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: DCPackProgram::r_add_steps
+//       Access: Private
+//  Description: Appends the steps for packing the indicated field,
+//               which is the field_indexth nested field of parent,
+//               and recurses into its nested fields.  Returns true on
+//               success, or false if the field cannot be flattened.
+////////////////////////////////////////////////////////////////////
+bool DCPackProgram::
+r_add_steps(const DCPackerInterface *field, const DCPackerInterface *parent,
+            int field_index, int num_nested_fields) {
+  if ((int)_steps.size() >= max_steps) {
+    return false;
+  }
+
+  if (!field->has_nested_fields()) {
+    add_step(SK_value, field, parent, field_index, num_nested_fields);
+
+    // If the value is a plain number, DCPacker may pack it itself.
+    const DCField *as_field = field->as_field();
+    const DCParameter *parameter =
+      (as_field == (DCField *)NULL) ? NULL : as_field->as_parameter();
+    const DCSimpleParameter *simple =
+      (parameter == (DCParameter *)NULL) ? NULL : parameter->as_simple_parameter();
+    if (simple != (DCSimpleParameter *)NULL &&
+        !simple->has_modulus() && !simple->has_range()) {
+      switch (simple->get_type()) {
+      case ST_int8:
+      case ST_int16:
+      case ST_int32:
+      case ST_char:
+      case ST_uint8:
+      case ST_uint16:
+      case ST_uint32:
+      case ST_float64:
+        _steps.back()._fast_type = simple->get_type();
+        _steps.back()._divisor = simple->get_divisor();
+        break;
+
+      default:
+        break;
+      }
+    }
+    return true;
+  }
+
+  // A fixed layout shouldn't have any length prefixes or switches,
+  // but we check anyway, since DCPacker won't be looking for them.
+  if (field->get_num_length_bytes() != 0 ||
+      field->as_switch_parameter() != (DCSwitchParameter *)NULL) {
+    return false;
+  }
+  int num_nested = field->get_num_nested_fields();
+  if (num_nested < 0 || !field->validate_num_nested_fields(num_nested)) {
+    return false;
+  }
+
+  int push_index = (int)_steps.size();
+  add_step(SK_push, field, parent, field_index, num_nested_fields);
+
+  for (int i = 0; i < num_nested; ++i) {
+    if (!r_add_steps(field->get_nested_field(i), field, i, num_nested)) {
+      return false;
+    }
+  }
+
+  add_step(SK_pop, NULL, field, num_nested, num_nested);
+  _steps[push_index]._next = (int)_steps.size();
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: DCPackProgram::add_step
+//       Access: Private
+//  Description: Appends a new step to the program.
+////////////////////////////////////////////////////////////////////
+void DCPackProgram::
+add_step(StepKind kind, const DCPackerInterface *field,
+         const DCPackerInterface *parent, int field_index,
+         int num_nested_fields) {
+  Step step;
+  step._kind = kind;
+  step._field = field;
+  step._parent = parent;
+  step._field_index = field_index;
+  step._num_nested_fields = num_nested_fields;
+  step._next = (int)_steps.size() + 1;
+  step._fast_type = ST_invalid;
+  step._divisor = 1;
+  _steps.push_back(step);
+}
@@ -0,0 +1,122 @@
+// Filename: dcPackProgram.h
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef DCPACKPROGRAM_H
+#define DCPACKPROGRAM_H
+
+#include "dcbase.h"
+#include "dcSubatomicType.h"
+#include "dcPackerInterface.h"
+#include "dcPackData.h"
+#include <math.h>
+
+#ifdef WITHIN_PANDA
+#include "configVariableBool.h"
+
+extern ConfigVariableBool dc_pack_programs;
+
+#else  // WITHIN_PANDA
+
+static const bool dc_pack_programs = true;
+
+#endif  // WITHIN_PANDA
+
+////////////////////////////////////////////////////////////////////
+//       Class : DCPackProgram
+// Description : This is a precomputed, flattened description of the
+//               layout of a field whose packed form has a fixed size
+//               and structure.  It lists, in the order that DCPacker
+//               visits them, each push(), value and pop() of the
+//               field, along with the state that DCPacker would
+//               otherwise have to compute by walking the
+//               DCPackerInterface tree.
+//
+//               DCFile makes one of these for each DCAtomicField and
+//               DCMolecularField that qualifies, after the file has
+//               been read; DCPacker then follows it instead of the
+//               tree, without changing the results.  Its ownership is
+//               retained by the field so it must not be deleted.
+////////////////////////////////////////////////////////////////////
+class EXPCL_DIRECT DCPackProgram {
+private:
+  DCPackProgram();
+
+public:
+  static DCPackProgram *make_program(const DCPackerInterface *root);
+
+  enum StepKind {
+    SK_push,
+    SK_value,
+    SK_pop,
+    SK_end
+  };
+
+  // Each Step records what DCPacker's _current_field, _current_parent,
+  // _current_field_index and _num_nested_fields would be at that
+  // point of a tree walk.
+  class Step {
+  public:
+    StepKind _kind;
+    const DCPackerInterface *_field;
+    const DCPackerInterface *_parent;
+    int _field_index;
+    int _num_nested_fields;
+
+    // The step that follows this element; for a push step, this skips
+    // over all of its nested fields.
+    int _next;
+
+    // For a value step that is a plain number (no range or modulus),
+    // this is its type, and the value may be packed or unpacked here
+    // directly; otherwise it is ST_invalid.
+    DCSubatomicType _fast_type;
+    unsigned int _divisor;
+  };
+
+  INLINE int get_num_steps() const;
+  INLINE const Step &get_step(int n) const;
+  INLINE size_t get_fixed_byte_size() const;
+
+  INLINE static void pack_double(const Step &step, DCPackData &pack_data,
+                                 double value, bool &pack_error,
+                                 bool &range_error);
+  INLINE static void pack_int(const Step &step, DCPackData &pack_data,
+                              int value, bool &pack_error, bool &range_error);
+  INLINE static void unpack_double(const Step &step, const char *data,
+                                   size_t length, size_t &p, double &value,
+                                   bool &pack_error, bool &range_error);
+  INLINE static void unpack_int(const Step &step, const char *data,
+                                size_t length, size_t &p, int &value,
+                                bool &pack_error, bool &range_error);
+
+private:
+  bool r_add_steps(const DCPackerInterface *field,
+                   const DCPackerInterface *parent, int field_index,
+                   int num_nested_fields);
+  void add_step(StepKind kind, const DCPackerInterface *field,
+                const DCPackerInterface *parent, int field_index,
+                int num_nested_fields);
+
+  typedef pvector<Step> Steps;
+  Steps _steps;
+  size_t _fixed_byte_size;
+
+  // A field with more elements than this (a large fixed-size array,
+  // for instance) isn't worth flattening.
+  static const int max_steps = 1024;
+};
+
+#include "dcPackProgram.I"
+
+#endif
@@ -44,6 +44,9 @@ DCPacker() {
   _pack_error = false;
   _range_error = false;
   _stack = NULL;
+  _program = NULL;
+  _program_index = 0;
+  _program_step = NULL;
   
   clear();
 }
@@ -89,6 +92,11 @@ begin_pack(const DCPackerInterface *root) {
   _current_parent = NULL;
   _current_field_index = 0;
   _num_nested_fields = 0;
+
+  _program = root->get_pack_program();
+  if (_program != (DCPackProgram *)NULL) {
+    set_program_step(0);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -182,6 +190,11 @@ begin_unpack(const DCPackerInterface *root) {
   _current_parent = NULL;
   _current_field_index = 0;
   _num_nested_fields = 0;
+
+  _program = root->get_pack_program();
+  if (_program != (DCPackProgram *)NULL) {
+    set_program_step(0);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -347,8 +360,10 @@ seek(int seek_index) {
     const DCPackerCatalog::Entry &entry = _live_catalog->get_entry(seek_index);
 
     // If we are seeking, we don't need to remember our current stack
-    // position.
+    // position (or our place in the program).
     clear_stack();
+    _program = NULL;
+    _program_step = NULL;
     _current_field = entry._field;
     _current_parent = entry._parent;
     _current_field_index = entry._field_index;
@@ -446,6 +461,18 @@ seek(int seek_index) {
 ////////////////////////////////////////////////////////////////////
 void DCPacker::
 push() {
+  if (_program != (DCPackProgram *)NULL) {
+    if (_program_step->_kind == DCPackProgram::SK_push) {
+      // A fixed layout has no length prefix to reserve or read, and
+      // the program already knows the first nested field.
+      _push_marker = (_mode == M_unpack) ? _unpack_p : _pack_data.get_length();
+      _pop_marker = 0;
+      set_program_step(_program_index + 1);
+      return;
+    }
+    leave_program();
+  }
+
   if (!has_nested_fields()) {
     _pack_error = true;
 
@@ -535,6 +562,14 @@ push() {
 ////////////////////////////////////////////////////////////////////
 void DCPacker::
 pop() {
+  if (_program != (DCPackProgram *)NULL) {
+    if (_program_step->_kind == DCPackProgram::SK_pop) {
+      set_program_step(_program_step->_next);
+      return;
+    }
+    leave_program();
+  }
+
   if (_current_field != NULL && _num_nested_fields >= 0) {
     // Oops, didn't pack or unpack enough values.
     _pack_error = true;
@@ -1204,6 +1239,49 @@ output_hex_string(ostream &out, const string &str) {
   out << '>';
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: DCPacker::leave_program
+//       Access: Private
+//  Description: Stops following the current DCPackProgram, because
+//               the caller has done something other than what it
+//               expects next (which is usually an error).  The stack
+//               that walking the tree would have built up to this
+//               point is reconstructed, so that push() and pop() can
+//               carry on from here as if the program had never been
+//               used.
+////////////////////////////////////////////////////////////////////
+void DCPacker::
+leave_program() {
+  nassertv(_program != (DCPackProgram *)NULL && _stack == (StackElement *)NULL);
+
+  // Every push step before this one that hasn't yet been matched by
+  // its pop step is still on the stack.
+  pvector<int> open_steps;
+  for (int i = 0; i < _program_index; ++i) {
+    const DCPackProgram::Step &step = _program->get_step(i);
+    if (step._kind == DCPackProgram::SK_push) {
+      open_steps.push_back(i);
+    } else if (step._kind == DCPackProgram::SK_pop) {
+      open_steps.pop_back();
+    }
+  }
+
+  pvector<int>::const_iterator si;
+  for (si = open_steps.begin(); si != open_steps.end(); ++si) {
+    const DCPackProgram::Step &step = _program->get_step(*si);
+    StackElement *element = new StackElement;
+    element->_current_parent = step._parent;
+    element->_current_field_index = step._field_index;
+    element->_push_marker = 0;
+    element->_pop_marker = 0;
+    element->_next = _stack;
+    _stack = element;
+  }
+
+  _program = NULL;
+  _program_step = NULL;
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: DCPacker::handle_switch
 //       Access: Private
@@ -1260,6 +1338,9 @@ handle_switch(const DCSwitchParameter *switch_parameter) {
 void DCPacker::
 clear() {
   clear_stack();
+  _program = NULL;
+  _program_index = 0;
+  _program_step = NULL;
   _current_field = NULL;
   _current_parent = NULL;
   _current_field_index = 0;
@@ -20,6 +20,7 @@
 #include "dcSubatomicType.h"
 #include "dcPackData.h"
 #include "dcPackerCatalog.h"
+#include "dcPackProgram.h"
 #include "dcPython.h"
 
 class DCClass;
@@ -188,6 +189,8 @@ public:
 
 private:
   INLINE void advance();
+  INLINE void set_program_step(int n);
+  void leave_program();
   void handle_switch(const DCSwitchParameter *switch_parameter);
   void clear();
   void clear_stack();
@@ -254,6 +257,13 @@ private:
   int _num_nested_fields;
   const DCSwitchParameter *_last_switch;
 
+  // If the root field has a DCPackProgram, we follow it instead of
+  // walking the tree until something happens that it doesn't cover,
+  // at which point we rebuild the stack and carry on without it.
+  const DCPackProgram *_program;
+  int _program_index;
+  const DCPackProgram::Step *_program_step;
+
   bool _parse_error;
   bool _pack_error;
   bool _range_error;
@@ -14,6 +14,7 @@
 
 #include "dcPackerInterface.h"
 #include "dcPackerCatalog.h"
+#include "dcPackProgram.h"
 #include "dcField.h"
 #include "dcParserDefs.h"
 #include "dcLexerDefs.h"
@@ -36,6 +37,7 @@ DCPackerInterface(const string &name) :
   _num_nested_fields = -1;
   _pack_type = PT_invalid;
   _catalog = NULL;
+  _pack_program = NULL;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -56,6 +58,7 @@ DCPackerInterface(const DCPackerInterface &copy) :
   _pack_type(copy._pack_type)
 {
   _catalog = NULL;
+  _pack_program = NULL;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -68,6 +71,9 @@ DCPackerInterface::
   if (_catalog != (DCPackerCatalog *)NULL) {
     delete _catalog;
   }
+  if (_pack_program != (DCPackProgram *)NULL) {
+    delete _pack_program;
+  }
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -462,6 +468,24 @@ get_catalog() const {
   return _catalog;
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: DCPackerInterface::make_pack_program
+//       Access: Public
+//  Description: Computes the DCPackProgram for this field, if its
+//               packed form has a fixed size and structure.  This is
+//               normally called by DCFile for each atomic and
+//               molecular field once the file has been read; it
+//               should not be called while a DCPacker is using the
+//               field.
+////////////////////////////////////////////////////////////////////
+void DCPackerInterface::
+make_pack_program() {
+  if (_pack_program != (DCPackProgram *)NULL) {
+    delete _pack_program;
+  }
+  _pack_program = DCPackProgram::make_program(this);
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: DCPackerInterface::do_check_match_simple_parameter
 //       Access: Protected, Virtual
@@ -28,6 +28,7 @@ class DCAtomicField;
 class DCMolecularField;
 class DCPackData;
 class DCPackerCatalog;
+class DCPackProgram;
 
 BEGIN_PUBLISH
 // This enumerated type is returned by get_pack_type() and represents
@@ -169,6 +170,8 @@ public:
                                             bool &range_error);
 
   const DCPackerCatalog *get_catalog() const;
+  INLINE const DCPackProgram *get_pack_program() const;
+  void make_pack_program();
 
 protected:
   virtual bool do_check_match(const DCPackerInterface *other) const=0;
@@ -200,6 +203,7 @@ protected:
 
 private:
   DCPackerCatalog *_catalog;
+  DCPackProgram *_pack_program;
 };
 
 #include "dcPackerInterface.I"
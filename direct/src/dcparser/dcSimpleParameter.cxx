@@ -328,6 +328,17 @@ is_numeric_type() const {
   return !(_pack_type == PT_string || _pack_type == PT_blob);
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: DCSimpleParameter::has_range
+//       Access: Public
+//  Description: Returns true if there is a range associated, false
+//               otherwise.
+////////////////////////////////////////////////////////////////////
+bool DCSimpleParameter::
+has_range() const {
+  return !_orig_range.is_empty();
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: DCSimpleParameter::set_modulus
 //       Access: Public
@@ -47,6 +47,7 @@ PUBLISHED:
 
 public:
   bool is_numeric_type() const;
+  bool has_range() const;
   bool set_modulus(double modulus);
   bool set_divisor(unsigned int divisor);
   bool set_range(const DCDoubleRange &range);
@@ -29,8 +29,12 @@
 #define STATESERVER_OBJECT_CREATE_WITH_REQUIRED_CONTEXT   2050
 #define STATESERVER_OBJECT_CREATE_WITH_REQUIR_OTHER_CONTEXT  2051
 #define STATESERVER_BOUNCE_MESSAGE                        2086
+#define STATESERVER_BOUNCE_MESSAGE_COMPRESSED             2087
+#define STATESERVER_REQUEST_BUNDLE_COMPRESSION            2088
+#define STATESERVER_ACCEPT_BUNDLE_COMPRESSION             2089
 
 #define CLIENT_OBJECT_GENERATE_CMU                        9002
+#define OBJECT_UPDATE_FIELD_CMU                           9004
 
 #endif
 
@@ -0,0 +1,508 @@
+// Filename: test_dcPackProgram.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "dcbase.h"
+#include "dcFile.h"
+#include "dcField.h"
+#include "dcPacker.h"
+#include "dcPackerCatalog.h"
+#include "dcPackProgram.h"
+#include "filename.h"
+#include "testCheck.h"
+
+#include <sstream>
+
+// This program reads each dc file twice, once with dc-pack-programs
+// on and once with it off, and packs and unpacks every field of the
+// two copies side by side: once through the DCPackProgram, and once
+// through the DCPackerInterface tree.  It checks that both give the
+// same bytes, the same values and the same packer state after every
+// call.  Some of the runs also make calls that don't fit the field,
+// truncate or pad the data, or seek, to exercise the fallback from
+// the program to the tree.
+//
+// The dc files named on the command line are read; with no arguments,
+// the dc files in the source tree are read, if they can be found from
+// the current directory, along with a built-in file that covers each
+// of the numeric types.
+
+static const char *const builtin_dc =
+  "struct Pt {\n"
+  "  int16 / 10 x;\n"
+  "  int16 / 10 y;\n"
+  "  uint8 flags;\n"
+  "};\n"
+  "\n"
+  "struct Rec {\n"
+  "  Pt a;\n"
+  "  Pt b[2];\n"
+  "  char c;\n"
+  "  float64 f;\n"
+  "  int32 / 100 big;\n"
+  "};\n"
+  "\n"
+  "dclass Foo {\n"
+  "  setA(int8 a, int16 b, int32 c, uint8 d, uint16 e, uint32 f, float64 g, char h) broadcast;\n"
+  "  setB(int16 % 360 h, uint16(0-100) pct, int8(-5-5) small, int32 / 1000 % 10 m) broadcast;\n"
+  "  setC(Pt p, Pt q[3]) ram;\n"
+  "  setD(Rec r) ram;\n"
+  "  setE(int64 a, uint64 b, int64 / 10 c) ram;\n"
+  "  setF(uint8[4] quad, int16 / 4[2] pair, string(4) tag, blob(3) bits) ram;\n"
+  "  setG() ram;\n"
+  "  setH(uint32 / 7 u, uint8 / 3 v, float64 / 2 w) ram;\n"
+  "  setI(uint8[4] quad, int16 / 4[2] pair, char[3] cs) ram;\n"
+  "  setJ(string s, uint16[] list) ram;\n"
+  "  setAB : setA, setB;\n"
+  "  setCG : setC, setG, setH;\n"
+  "};\n";
+
+static const char *const source_dc_files[] = {
+  "direct/src/distributed/direct.dc",
+  "direct/src/doc/sample.dc",
+};
+static const int num_source_dc_files =
+  sizeof(source_dc_files) / sizeof(source_dc_files[0]);
+
+static const int num_runs = 200;
+static const int max_calls = 400;
+
+static TestCheck check;
+static int num_fields = 0;
+static int num_programs = 0;
+
+static unsigned int random_seed = 3777;
+
+////////////////////////////////////////////////////////////////////
+//     Function: random_number
+//  Description: Returns a pseudo-random number, the same sequence on
+//               every run.
+////////////////////////////////////////////////////////////////////
+static unsigned int
+random_number() {
+  random_seed = random_seed * 1103515245 + 12345;
+  return random_seed >> 8;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: random_value
+//  Description: Returns a value to pack, sometimes in range for the
+//               field and sometimes not.
+////////////////////////////////////////////////////////////////////
+static double
+random_value() {
+  switch (random_number() % 6) {
+  case 0:
+    return (double)(int)(random_number() % 200) - 100;
+  case 1:
+    return ((double)(random_number() % 20000) - 10000) / 7.0;
+  case 2:
+    return (double)(random_number() % 70000);
+  case 3:
+    return -(double)(random_number() % 70000);
+  case 4:
+    return (double)(int)random_number() * 3;
+  default:
+    return (double)(random_number() % 2000) / 100.0;
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: describe_state
+//  Description: Returns a string that describes everything about the
+//               packer that a caller can see.
+////////////////////////////////////////////////////////////////////
+static string
+describe_state(DCPacker &packer) {
+  ostringstream strm;
+  const DCPackerInterface *field = packer.get_current_field();
+  const DCPackerInterface *parent = packer.get_current_parent();
+  strm << (field != (DCPackerInterface *)NULL ? field->get_name() : "(none)")
+       << " type " << (int)packer.get_pack_type()
+       << " parent "
+       << (parent != (DCPackerInterface *)NULL ? parent->get_name() : "(none)")
+       << " nested " << packer.get_num_nested_fields()
+       << " more " << packer.more_nested_fields()
+       << " has " << packer.has_nested_fields()
+       << " errors " << packer.had_pack_error() << packer.had_range_error();
+  return strm.str();
+}
+
+enum Call {
+  C_double,
+  C_int,
+  C_uint,
+  C_int64,
+  C_string,
+  C_push,
+  C_pop,
+  C_other,   // pack_default_value() or unpack_skip()
+  C_literal, // pack_literal_value() or unpack_validate()
+  C_num_calls
+};
+
+////////////////////////////////////////////////////////////////////
+//     Function: choose_call
+//  Description: Returns the call that fits the packer's current
+//               field, or, if wild is true, occasionally any call at
+//               all.  When packing, a variable-length array is ended
+//               after a random number of elements.
+////////////////////////////////////////////////////////////////////
+static Call
+choose_call(DCPacker &packer, bool packing, bool wild) {
+  if (wild && random_number() % 8 == 0) {
+    return (Call)(random_number() % C_num_calls);
+  }
+  if (!packer.more_nested_fields()) {
+    return C_pop;
+  }
+  if (packing && packer.get_num_nested_fields() < 0 &&
+      random_number() % 8 == 0) {
+    return C_pop;
+  }
+  switch (packer.get_pack_type()) {
+  case PT_double:
+    return (random_number() % 2 == 0) ? C_double : C_int;
+  case PT_int:
+    return (random_number() % 3 == 0) ? C_double : C_int;
+  case PT_uint:
+    return (random_number() % 3 == 0) ? C_uint : C_int;
+  case PT_int64:
+  case PT_uint64:
+    return C_int64;
+  case PT_string:
+  case PT_blob:
+    return C_string;
+  default:
+    return C_push;
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: make_pack_call
+//  Description: Makes the indicated packing call.
+////////////////////////////////////////////////////////////////////
+static void
+make_pack_call(DCPacker &packer, Call call, double value) {
+  switch (call) {
+  case C_double:
+    packer.pack_double(value);
+    break;
+  case C_int:
+    packer.pack_int((int)value);
+    break;
+  case C_uint:
+    packer.pack_uint((unsigned int)(int)value);
+    break;
+  case C_int64:
+    packer.pack_int64((PN_int64)value);
+    break;
+  case C_string:
+    packer.pack_string("ab");
+    break;
+  case C_push:
+    packer.push();
+    break;
+  case C_pop:
+    packer.pop();
+    break;
+  case C_other:
+    packer.pack_default_value();
+    break;
+  case C_literal:
+    packer.pack_literal_value("xy");
+    break;
+  default:
+    break;
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: make_unpack_call
+//  Description: Makes the indicated unpacking call, and returns a
+//               description of what it unpacked.
+////////////////////////////////////////////////////////////////////
+static string
+make_unpack_call(DCPacker &packer, Call call) {
+  ostringstream strm;
+  switch (call) {
+  case C_double:
+    strm << packer.unpack_double();
+    break;
+  case C_int:
+    strm << packer.unpack_int();
+    break;
+  case C_uint:
+    strm << packer.unpack_uint();
+    break;
+  case C_int64:
+    strm << packer.unpack_int64();
+    break;
+  case C_string:
+    strm << packer.unpack_string();
+    break;
+  case C_push:
+    packer.push();
+    break;
+  case C_pop:
+    packer.pop();
+    break;
+  case C_other:
+    packer.unpack_skip();
+    break;
+  case C_literal:
+    packer.unpack_validate();
+    break;
+  default:
+    break;
+  }
+  strm << " at " << packer.get_num_unpacked_bytes();
+  return strm.str();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: is_finished
+//  Description: Returns true if the packer has reached the end of
+//               the field.
+////////////////////////////////////////////////////////////////////
+static bool
+is_finished(DCPacker &packer) {
+  return !packer.more_nested_fields() &&
+    packer.get_current_parent() == (DCPackerInterface *)NULL;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: compare_pack
+//  Description: Packs the same values into both fields, and checks
+//               that the packers agree after each call.  Returns the
+//               packed data, or the empty string if they disagreed.
+////////////////////////////////////////////////////////////////////
+static string
+compare_pack(DCField *flat, DCField *tree, bool wild,
+             const string &description) {
+  DCPacker flat_packer, tree_packer;
+  flat_packer.begin_pack(flat);
+  tree_packer.begin_pack(tree);
+
+  for (int i = 0; i < max_calls; ++i) {
+    if (is_finished(tree_packer) && (!wild || random_number() % 2 == 0)) {
+      break;
+    }
+    Call call = choose_call(tree_packer, true, wild);
+    double value = random_value();
+    make_pack_call(flat_packer, call, value);
+    make_pack_call(tree_packer, call, value);
+
+    string flat_state = describe_state(flat_packer);
+    string tree_state = describe_state(tree_packer);
+    if (flat_state != tree_state) {
+      ostringstream strm;
+      strm << description << ": pack call " << i << " (" << (int)call
+           << ") leaves '" << flat_state << "', not '" << tree_state << "'";
+      check(false, strm.str());
+      return string();
+    }
+  }
+
+  bool flat_ok = flat_packer.end_pack();
+  bool tree_ok = tree_packer.end_pack();
+  check(flat_ok == tree_ok, description + ": end_pack()");
+  if (flat_ok != tree_ok) {
+    return string();
+  }
+  if (!tree_ok) {
+    // After a failed pack, the length of an unfinished array may
+    // never have been filled in, so only the sizes must agree.
+    check(flat_packer.get_length() == tree_packer.get_length(),
+          description + ": packed length");
+    return tree_packer.get_string();
+  }
+
+  check(flat_packer.get_string() == tree_packer.get_string(),
+        description + ": packed bytes");
+  if (flat_packer.get_string() != tree_packer.get_string()) {
+    return string();
+  }
+  return tree_packer.get_string();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: compare_unpack
+//  Description: Unpacks the data from both fields, and checks that
+//               the packers agree after each call.
+////////////////////////////////////////////////////////////////////
+static void
+compare_unpack(DCField *flat, DCField *tree, const string &data, bool wild,
+               const string &description) {
+  DCPacker flat_packer, tree_packer;
+  flat_packer.set_unpack_data(data);
+  tree_packer.set_unpack_data(data);
+  flat_packer.begin_unpack(flat);
+  tree_packer.begin_unpack(tree);
+  int num_entries = tree->get_catalog()->get_num_entries();
+
+  for (int i = 0; i < max_calls; ++i) {
+    if (is_finished(tree_packer) && (!wild || random_number() % 2 == 0)) {
+      break;
+    }
+    Call call = choose_call(tree_packer, false, wild);
+    string flat_result = make_unpack_call(flat_packer, call);
+    string tree_result = make_unpack_call(tree_packer, call);
+    flat_result += " " + describe_state(flat_packer);
+    tree_result += " " + describe_state(tree_packer);
+
+    if (wild && num_entries > 0 && random_number() % 50 == 0) {
+      int n = random_number() % num_entries;
+      flat_result += flat_packer.seek(n) ? " seek" : " no seek";
+      tree_result += tree_packer.seek(n) ? " seek" : " no seek";
+      flat_result += " " + describe_state(flat_packer);
+      tree_result += " " + describe_state(tree_packer);
+    }
+
+    if (flat_result != tree_result) {
+      ostringstream strm;
+      strm << description << ": unpack call " << i << " (" << (int)call
+           << ") gives '" << flat_result << "', not '" << tree_result << "'";
+      check(false, strm.str());
+      return;
+    }
+  }
+
+  check(flat_packer.end_unpack() == tree_packer.end_unpack(),
+        description + ": end_unpack()");
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: compare_field
+//  Description: Packs and unpacks the field a number of times through
+//               both copies.
+////////////////////////////////////////////////////////////////////
+static void
+compare_field(DCField *flat, DCField *tree, const string &filename) {
+  ++num_fields;
+  if (flat->get_pack_program() != (DCPackProgram *)NULL) {
+    ++num_programs;
+  }
+  check(tree->get_pack_program() == (DCPackProgram *)NULL,
+        filename + " " + tree->get_name() +
+        ": no program with dc-pack-programs off");
+
+  int failed_before = check.get_num_failed();
+  for (int run = 0;
+       run < num_runs && check.get_num_failed() == failed_before;
+       ++run) {
+    bool wild = (run % 3 == 0);
+    ostringstream strm;
+    strm << filename << " " << flat->get_name() << " run " << run;
+    string description = strm.str();
+
+    string data = compare_pack(flat, tree, wild, description);
+    if (check.get_num_failed() != failed_before) {
+      break;
+    }
+
+    if (!wild) {
+      // A well-formed record formats the same way from both.
+      check(flat->format_data(data) == tree->format_data(data),
+            description + ": format_data()");
+    } else {
+      if (!data.empty() && random_number() % 2 == 0) {
+        data = data.substr(0, random_number() % data.size());
+      }
+      if (random_number() % 3 == 0) {
+        data += "zz";
+      }
+    }
+    if (!data.empty()) {
+      compare_unpack(flat, tree, data, wild, description);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: compare_file
+//  Description: Reads the dc file with and without pack programs,
+//               and compares every field.  Returns true if the file
+//               could be read.
+////////////////////////////////////////////////////////////////////
+static bool
+compare_file(istream &in, const string &filename) {
+  DCFile flat, tree;
+
+  dc_pack_programs = true;
+  bool flat_ok = flat.read(in, filename);
+  in.clear();
+  in.seekg(0);
+  dc_pack_programs = false;
+  bool tree_ok = tree.read(in, filename);
+  dc_pack_programs = true;
+
+  check(flat_ok && tree_ok, "read " + filename);
+  if (!flat_ok || !tree_ok) {
+    return false;
+  }
+
+  for (int i = 0; flat.get_field_by_index(i) != (DCField *)NULL; ++i) {
+    DCField *tree_field = tree.get_field_by_index(i);
+    check(tree_field != (DCField *)NULL, filename + ": same fields");
+    if (tree_field == (DCField *)NULL) {
+      return true;
+    }
+    compare_field(flat.get_field_by_index(i), tree_field, filename);
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: compare_filename
+//  Description: Reads the named dc file and compares it.  Returns
+//               true if it could be read.
+////////////////////////////////////////////////////////////////////
+static bool
+compare_filename(Filename filename) {
+  filename.set_text();
+  pifstream in;
+  if (!filename.open_read(in)) {
+    return false;
+  }
+  ostringstream contents;
+  contents << in.rdbuf();
+  istringstream strm(contents.str());
+  return compare_file(strm, filename.get_basename());
+}
+
+int
+main(int argc, char *argv[]) {
+  if (argc > 1) {
+    for (int i = 1; i < argc; ++i) {
+      check(compare_filename(Filename::from_os_specific(argv[i])),
+            string("open ") + argv[i]);
+    }
+
+  } else {
+    istringstream in(builtin_dc);
+    compare_file(in, "builtin.dc");
+    check(num_programs > 0, "built-in file has pack programs");
+
+    for (int i = 0; i < num_source_dc_files; ++i) {
+      if (!compare_filename(Filename(source_dc_files[i]))) {
+        nout << "Skipping " << source_dc_files[i]
+             << "; run from the top of the source tree to include it.\n";
+      }
+    }
+  }
+
+  nout << num_fields << " fields compared, " << num_programs
+       << " with pack programs.\n";
+  return check.report();
+}
@@ -13,16 +13,33 @@
 
   #define SOURCES \
     config_deadrec.h \
-    smoothMover.h smoothMover.I
+    smoothMover.h smoothMover.I \
+    smoothMoverGroup.h smoothMoverGroup.I
   
   #define INCLUDED_SOURCES \  
     config_deadrec.cxx \
-    smoothMover.cxx
+    smoothMover.cxx \
+    smoothMoverGroup.cxx
 
   #define INSTALL_HEADERS \
     config_deadrec.h \
-    smoothMover.h smoothMover.I
+    smoothMover.h smoothMover.I \
+    smoothMoverGroup.h smoothMoverGroup.I
 
   #define IGATESCAN \
     all
 #end lib_target
+
+#begin test_bin_target
+  #define TARGET test_smoothMoverGroup
+  #define LOCAL_LIBS \
+    p3deadrec p3directbase
+  #define OTHER_LIBS \
+    p3express:c pandaexpress:m panda:m \
+    p3interrogatedb:c p3dconfig:c p3dtoolconfig:m \
+    p3dtoolutil:c p3dtoolbase:c p3dtool:m p3prc:c p3pystub
+
+  #define SOURCES \
+    test_smoothMoverGroup.cxx
+
+#end test_bin_target
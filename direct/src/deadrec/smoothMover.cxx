@@ -15,6 +15,7 @@
 #include "smoothMover.h"
 #include "pnotify.h"
 #include "config_deadrec.h"
+#include "smoothMoverGroup.h"
 
 ////////////////////////////////////////////////////////////////////
 //     Function: SmoothMover::Constructor
@@ -69,6 +70,9 @@ SmoothMover() {
 ////////////////////////////////////////////////////////////////////
 SmoothMover::
 ~SmoothMover() {
+  if (_group_membership._group != (SmoothMoverGroup *)NULL) {
+    _group_membership._group->remove_mover(this);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////
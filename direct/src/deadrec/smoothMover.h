@@ -22,6 +22,8 @@
 #include "nodePath.h"
 #include "pdeque.h"
 
+class SmoothMoverGroup;
+
 static const int max_position_reports = 10;
 static const int max_timestamp_delays = 10;
 
@@ -212,6 +214,21 @@ private:
   double _reset_velocity_age;
   bool _directional_velocity;
   bool _default_to_standing_still;
+
+  // The SmoothMoverGroup this mover has been added to, if any, and
+  // its index within the group.  This is not copied with the mover.
+  class GroupMembership {
+  public:
+    INLINE GroupMembership();
+    INLINE GroupMembership(const GroupMembership &copy);
+    INLINE void operator = (const GroupMembership &copy);
+
+    SmoothMoverGroup *_group;
+    int _index;
+  };
+  GroupMembership _group_membership;
+
+  friend class SmoothMoverGroup;
 };
 
 #include "smoothMover.I"
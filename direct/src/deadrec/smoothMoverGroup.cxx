@@ -0,0 +1,160 @@
+// Filename: smoothMoverGroup.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "smoothMoverGroup.h"
+
+////////////////////////////////////////////////////////////////////
+//     Function: SmoothMoverGroup::Constructor
+//       Access: Published
+//  Description:
+////////////////////////////////////////////////////////////////////
+SmoothMoverGroup::
+SmoothMoverGroup() {
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: SmoothMoverGroup::Destructor
+//       Access: Published
+//  Description:
+////////////////////////////////////////////////////////////////////
+SmoothMoverGroup::
+~SmoothMoverGroup() {
+  clear_movers();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: SmoothMoverGroup::add_mover
+//       Access: Published
+//  Description: Adds the indicated SmoothMover to the group.  Each
+//               subsequent call to compute_and_apply_smooth_pos_hpr()
+//               will apply its smoothed position to pos_node and its
+//               smoothed orientation to hpr_node, which may be the
+//               same node.
+//
+//               If the mover was already in a group, it is moved to
+//               this one, with the new nodes.
+////////////////////////////////////////////////////////////////////
+void SmoothMoverGroup::
+add_mover(SmoothMover *mover, const NodePath &pos_node,
+          const NodePath &hpr_node) {
+  nassertv(mover != (SmoothMover *)NULL);
+  nassertv(!pos_node.is_empty() && !hpr_node.is_empty());
+
+  SmoothMover::GroupMembership &membership = mover->_group_membership;
+  if (membership._group == this) {
+    _pos_nodes[membership._index] = pos_node;
+    _hpr_nodes[membership._index] = hpr_node;
+    return;
+  }
+  if (membership._group != (SmoothMoverGroup *)NULL) {
+    membership._group->remove_mover(mover);
+  }
+
+  membership._group = this;
+  membership._index = (int)_movers.size();
+  _movers.push_back(mover);
+  _pos_nodes.push_back(pos_node);
+  _hpr_nodes.push_back(hpr_node);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: SmoothMoverGroup::remove_mover
+//       Access: Published
+//  Description: Removes the indicated SmoothMover from the group.
+//               Returns true if it is removed, or false if it was not
+//               in the group.  The last mover in the group takes its
+//               place.
+////////////////////////////////////////////////////////////////////
+bool SmoothMoverGroup::
+remove_mover(SmoothMover *mover) {
+  SmoothMover::GroupMembership &membership = mover->_group_membership;
+  if (membership._group != this) {
+    return false;
+  }
+
+  int index = membership._index;
+  int last = (int)_movers.size() - 1;
+  nassertr(index >= 0 && index <= last && _movers[index] == mover, false);
+
+  if (index != last) {
+    _movers[index] = _movers[last];
+    _pos_nodes[index] = _pos_nodes[last];
+    _hpr_nodes[index] = _hpr_nodes[last];
+    _movers[index]->_group_membership._index = index;
+  }
+  _movers.pop_back();
+  _pos_nodes.pop_back();
+  _hpr_nodes.pop_back();
+
+  membership._group = NULL;
+  membership._index = -1;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: SmoothMoverGroup::clear_movers
+//       Access: Published
+//  Description: Removes all of the SmoothMovers from the group.
+////////////////////////////////////////////////////////////////////
+void SmoothMoverGroup::
+clear_movers() {
+  Movers::const_iterator mi;
+  for (mi = _movers.begin(); mi != _movers.end(); ++mi) {
+    (*mi)->_group_membership._group = NULL;
+    (*mi)->_group_membership._index = -1;
+  }
+  _movers.clear();
+  _pos_nodes.clear();
+  _hpr_nodes.clear();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: SmoothMoverGroup::compute_and_apply_smooth_pos_hpr
+//       Access: Published
+//  Description: Computes the smoothed position of each SmoothMover
+//               in the group at the indicated time, and applies it to
+//               the mover's nodes if it has changed.  Returns the
+//               number of movers whose position changed.
+//
+//               This has the same effect as calling
+//               SmoothMover::compute_and_apply_smooth_pos_hpr() on
+//               each mover in turn, but all of the positions are
+//               computed before any of the nodes are touched, and a
+//               mover whose position and orientation go to the same
+//               node updates its transform only once.
+////////////////////////////////////////////////////////////////////
+int SmoothMoverGroup::
+compute_and_apply_smooth_pos_hpr(double timestamp) {
+  _changed.clear();
+  int num_movers = (int)_movers.size();
+  for (int i = 0; i < num_movers; ++i) {
+    if (_movers[i]->compute_smooth_position(timestamp)) {
+      _changed.push_back(i);
+    }
+  }
+
+  Indices::const_iterator ci;
+  for (ci = _changed.begin(); ci != _changed.end(); ++ci) {
+    int i = (*ci);
+    const SmoothMover *mover = _movers[i];
+    if (_pos_nodes[i] == _hpr_nodes[i]) {
+      _pos_nodes[i].set_pos_hpr(mover->get_smooth_pos(),
+                                mover->get_smooth_hpr());
+    } else {
+      mover->apply_smooth_pos_hpr(_pos_nodes[i], _hpr_nodes[i]);
+    }
+  }
+
+  return _changed.size();
+}
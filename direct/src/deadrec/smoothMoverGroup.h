@@ -0,0 +1,78 @@
+// Filename: smoothMoverGroup.h
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef SMOOTHMOVERGROUP_H
+#define SMOOTHMOVERGROUP_H
+
+#include "directbase.h"
+#include "smoothMover.h"
+#include "nodePath.h"
+#include "pvector.h"
+
+////////////////////////////////////////////////////////////////////
+//       Class : SmoothMoverGroup
+// Description : This class computes and applies the smoothed
+//               positions of many SmoothMovers at once, so that
+//               smoothing a world full of remote avatars takes one
+//               call per frame instead of one task per avatar.
+//
+//               Each SmoothMover is added along with the NodePaths
+//               that receive its position and orientation, exactly
+//               as would be passed to
+//               SmoothMover::compute_and_apply_smooth_pos_hpr().  The
+//               group does not own the SmoothMovers; a SmoothMover
+//               removes itself from its group when it is destructed.
+//               A SmoothMover may be in only one group at a time.
+////////////////////////////////////////////////////////////////////
+class EXPCL_DIRECT SmoothMoverGroup {
+PUBLISHED:
+  SmoothMoverGroup();
+  ~SmoothMoverGroup();
+
+  void add_mover(SmoothMover *mover, const NodePath &pos_node,
+                 const NodePath &hpr_node);
+  bool remove_mover(SmoothMover *mover);
+  INLINE bool has_mover(const SmoothMover *mover) const;
+  void clear_movers();
+
+  INLINE int get_num_movers() const;
+  INLINE SmoothMover *get_mover(int n) const;
+  MAKE_SEQ(get_movers, get_num_movers, get_mover);
+
+  INLINE int compute_and_apply_smooth_pos_hpr();
+  int compute_and_apply_smooth_pos_hpr(double timestamp);
+
+private:
+  SmoothMoverGroup(const SmoothMoverGroup &copy);
+  void operator = (const SmoothMoverGroup &copy);
+
+  // The movers and their nodes are kept in parallel arrays, so that
+  // the pass that computes the smoothed positions doesn't have to
+  // step over the NodePaths.
+  typedef pvector<SmoothMover *> Movers;
+  Movers _movers;
+  typedef pvector<NodePath> NodePaths;
+  NodePaths _pos_nodes;
+  NodePaths _hpr_nodes;
+
+  // The indices of the movers whose smoothed position changed in the
+  // current pass.  This is kept between calls only to avoid
+  // reallocating it every frame.
+  typedef pvector<int> Indices;
+  Indices _changed;
+};
+
+#include "smoothMoverGroup.I"
+
+#endif
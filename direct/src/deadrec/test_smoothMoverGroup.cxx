@@ -0,0 +1,241 @@
+// Filename: test_smoothMoverGroup.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "directbase.h"
+#include "smoothMoverGroup.h"
+#include "clockObject.h"
+#include "nodePath.h"
+#include "pvector.h"
+#include "testCheck.h"
+
+#include <sstream>
+
+// This program feeds the same stream of position reports to two
+// copies of each of a number of SmoothMovers, with every combination
+// of smooth and prediction mode.  Each frame, one copy of each is
+// smoothed by calling compute_and_apply_smooth_pos_hpr() on it
+// directly, and the other by a SmoothMoverGroup, and the program
+// checks that the nodes they drive end up with the same position and
+// orientation.  It also checks that movers leave the group when they
+// are removed or destructed.
+
+static const int num_movers = 64;
+static const int num_frames = 300;
+
+static TestCheck check;
+
+static unsigned int random_seed = 9127;
+
+////////////////////////////////////////////////////////////////////
+//     Function: random_number
+//  Description: Returns a pseudo-random number, the same sequence on
+//               every run.
+////////////////////////////////////////////////////////////////////
+static unsigned int
+random_number() {
+  random_seed = random_seed * 1103515245 + 12345;
+  return random_seed >> 8;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: random_float
+//  Description: Returns a pseudo-random number in the range [0, 1).
+////////////////////////////////////////////////////////////////////
+static double
+random_float() {
+  return (double)(random_number() % 10000) / 10000.0;
+}
+
+// The two copies of one SmoothMover, and the nodes they drive.  When
+// same_node is true, the position and orientation go to one node.
+class MoverPair {
+public:
+  SmoothMover *_reference;
+  SmoothMover *_grouped;
+  NodePath _ref_pos, _ref_hpr;
+  NodePath _group_pos, _group_hpr;
+  bool _same_node;
+  LPoint3 _pos;
+  LVecBase3 _hpr;
+  LVector3 _velocity;
+};
+typedef pvector<MoverPair> Pairs;
+
+////////////////////////////////////////////////////////////////////
+//     Function: setup_mover
+//  Description: Sets the modes of the mover according to its index.
+////////////////////////////////////////////////////////////////////
+static void
+setup_mover(SmoothMover *mover, int i) {
+  mover->set_smooth_mode((i & 1) ? SmoothMover::SM_on : SmoothMover::SM_off);
+  mover->set_prediction_mode((i & 2) ? SmoothMover::PM_on : SmoothMover::PM_off);
+  mover->set_directional_velocity((i & 4) != 0);
+  mover->set_delay((i & 8) ? 0.1 : 0.0);
+  mover->set_max_position_age(0.5);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: check_nodes
+//  Description: Checks that each grouped node matches its reference
+//               node.
+////////////////////////////////////////////////////////////////////
+static void
+check_nodes(const Pairs &pairs, const string &description) {
+  for (int i = 0; i < (int)pairs.size(); ++i) {
+    const MoverPair &pair = pairs[i];
+    ostringstream strm;
+    strm << description << ", mover " << i;
+    check(pair._group_pos.get_pos() == pair._ref_pos.get_pos(),
+          strm.str() + ": pos");
+    check(pair._group_hpr.get_hpr() == pair._ref_hpr.get_hpr(),
+          strm.str() + ": hpr");
+    check(pair._grouped->get_smooth_pos() == pair._reference->get_smooth_pos(),
+          strm.str() + ": smooth pos");
+  }
+}
+
+int
+main(int argc, char *argv[]) {
+  ClockObject *clock = ClockObject::get_global_clock();
+  clock->set_mode(ClockObject::M_slave);
+  double now = 10.0;
+  clock->set_frame_time(now);
+
+  NodePath root("root");
+  SmoothMoverGroup group;
+  Pairs pairs(num_movers);
+  for (int i = 0; i < num_movers; ++i) {
+    MoverPair &pair = pairs[i];
+    pair._reference = new SmoothMover;
+    pair._grouped = new SmoothMover;
+    setup_mover(pair._reference, i);
+    setup_mover(pair._grouped, i);
+
+    pair._same_node = (i & 16) == 0;
+    pair._ref_pos = root.attach_new_node("ref");
+    pair._group_pos = root.attach_new_node("group");
+    if (pair._same_node) {
+      pair._ref_hpr = pair._ref_pos;
+      pair._group_hpr = pair._group_pos;
+    } else {
+      pair._ref_hpr = pair._ref_pos.attach_new_node("ref_hpr");
+      pair._group_hpr = pair._group_pos.attach_new_node("group_hpr");
+    }
+    pair._pos.set(i * 3.0f, 0.0f, 0.0f);
+    pair._hpr.set(i * 10.0f, 0.0f, 0.0f);
+    pair._velocity.set((i % 5) - 2.0f, (i % 3) - 1.0f, 0.0f);
+
+    group.add_mover(pair._grouped, pair._group_pos, pair._group_hpr);
+  }
+  check(group.get_num_movers() == num_movers, "all movers added");
+
+  for (int frame = 0; frame < num_frames; ++frame) {
+    now += 0.01 + random_float() * 0.03;
+    clock->set_frame_time(now);
+
+    for (int i = 0; i < num_movers; ++i) {
+      MoverPair &pair = pairs[i];
+      // Each mover reports its position at its own irregular rate, and
+      // a few of them go quiet for a while now and then.
+      if ((frame / 50 + i) % 7 == 0 || random_number() % 4 != 0) {
+        continue;
+      }
+      pair._pos += pair._velocity * 0.1f;
+      pair._hpr[0] += (PN_stdfloat)(i % 4) * 5.0f;
+      if (random_number() % 10 == 0) {
+        pair._velocity.set(random_float() * 4.0 - 2.0,
+                           random_float() * 4.0 - 2.0, 0.0f);
+      }
+      double timestamp = now - random_float() * 0.05;
+
+      SmoothMover *movers[2] = { pair._reference, pair._grouped };
+      for (int m = 0; m < 2; ++m) {
+        movers[m]->set_pos_hpr(pair._pos, pair._hpr);
+        movers[m]->set_timestamp(timestamp);
+        movers[m]->mark_position();
+      }
+    }
+
+    // Now and then the application moves a node itself; the next
+    // change to the smoothed position puts it back.
+    if (frame % 37 == 0) {
+      int i = random_number() % num_movers;
+      pairs[i]._ref_pos.set_pos(0.0f, 0.0f, 100.0f);
+      pairs[i]._group_pos.set_pos(0.0f, 0.0f, 100.0f);
+    }
+
+    for (int i = 0; i < num_movers; ++i) {
+      pairs[i]._reference->compute_and_apply_smooth_pos_hpr(pairs[i]._ref_pos,
+                                                            pairs[i]._ref_hpr);
+    }
+    int num_changed = group.compute_and_apply_smooth_pos_hpr();
+    check(num_changed >= 0 && num_changed <= num_movers,
+          "number of changed movers");
+
+    ostringstream strm;
+    strm << "frame " << frame;
+    check_nodes(pairs, strm.str());
+  }
+
+  // An explicit timestamp works the same way as the frame time.
+  for (int i = 0; i < num_movers; ++i) {
+    if (pairs[i]._reference->compute_smooth_position(now + 0.2)) {
+      pairs[i]._reference->apply_smooth_pos_hpr(pairs[i]._ref_pos,
+                                                pairs[i]._ref_hpr);
+    }
+  }
+  group.compute_and_apply_smooth_pos_hpr(now + 0.2);
+  check_nodes(pairs, "explicit timestamp");
+
+  // Removing a mover moves the last one into its place.
+  SmoothMover *last = group.get_mover(num_movers - 1);
+  check(group.remove_mover(pairs[0]._grouped), "remove_mover()");
+  check(!group.remove_mover(pairs[0]._grouped), "second remove_mover()");
+  check(!group.has_mover(pairs[0]._grouped), "removed mover not in group");
+  check(group.get_num_movers() == num_movers - 1, "one mover removed");
+  check(group.get_mover(0) == last, "last mover moved up");
+
+  // Adding it to another group takes it out of this one.
+  SmoothMoverGroup other;
+  other.add_mover(pairs[1]._grouped, pairs[1]._group_pos, pairs[1]._group_hpr);
+  check(!group.has_mover(pairs[1]._grouped) &&
+        other.has_mover(pairs[1]._grouped), "mover moved to other group");
+  check(group.get_num_movers() == num_movers - 2, "two movers removed");
+
+  // A copy of a mover is not in any group.
+  SmoothMover copy(*pairs[2]._grouped);
+  check(!group.has_mover(&copy), "copy not in group");
+  check(group.get_num_movers() == num_movers - 2, "copy not added");
+
+  // Destructing a mover takes it out of its group.
+  delete pairs[2]._grouped;
+  pairs[2]._grouped = NULL;
+  check(group.get_num_movers() == num_movers - 3, "deleted mover removed");
+  for (int n = 0; n < group.get_num_movers(); ++n) {
+    check(group.get_mover(n) != (SmoothMover *)NULL, "no deleted mover");
+  }
+  group.compute_and_apply_smooth_pos_hpr();
+
+  group.clear_movers();
+  check(group.get_num_movers() == 0, "clear_movers()");
+  check(!other.has_mover(pairs[3]._grouped), "clear_movers() on other group");
+
+  for (int i = 0; i < num_movers; ++i) {
+    delete pairs[i]._reference;
+    delete pairs[i]._grouped;
+  }
+  check(other.get_num_movers() == 0, "deleted mover removed from other group");
+
+  return check.report();
+}
@@ -46,6 +46,9 @@ class ConnectionRepository(
         # where it currently is located')
         CConnectionRepository.__init__(self, hasOwnerView, threadedNet)
         self.setWantMessageBundling(config.GetBool('want-message-bundling', 1))
+        # If want-bundle-compression is set, we ask the server to
+        # accept compressed message bundles each time we connect; see
+        # requestBundleCompression().
         # DoInterestManager.__init__ relies on CConnectionRepository being
         # initialized
         DoInterestManager.__init__(self)
@@ -493,6 +496,7 @@ class ConnectionRepository(
             for url in serverList:
                 self.notify.info("Connecting to %s via NET interface." % (url))
                 if self.tryConnectNet(url):
+                    self.requestBundleCompression()
                     self.startReaderPollTask()
                     if successCallback:
                         successCallback(*successArgs)
@@ -505,6 +509,7 @@ class ConnectionRepository(
             for url in serverList:
                 self.notify.info("Connecting to %s via Native interface." % (url))
                 if self.connectNative(url):
+                    self.requestBundleCompression()
                     self.startReaderPollTask()
                     if successCallback:
                         successCallback(*successArgs)
@@ -555,6 +560,7 @@ class ConnectionRepository(
             ##     self.tcpConn.userManagesMemory = 0
             ##     self.tcpConn = stream
 
+            self.requestBundleCompression()
             self.startReaderPollTask()
             if successCallback:
                 successCallback(*successArgs)
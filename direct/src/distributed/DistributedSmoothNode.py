@@ -29,6 +29,17 @@ EnablePrediction = base.config.GetBool("smooth-enable-prediction", 1)
 Lag = base.config.GetDouble("smooth-lag", 0.2)
 PredictionLag = base.config.GetDouble("smooth-prediction-lag", 0.0)
 
+# When this is true, the DistributedSmoothNodes that don't override
+# smoothPosition() are all smoothed together by SmoothGroup, from one
+# task, rather than each from a task of its own.
+BatchSmoothing = base.config.GetBool("smooth-batch", 1)
+SmoothGroup = SmoothMoverGroup()
+SmoothGroupTaskName = "smoothGroup"
+
+def doSmoothGroupTask(task):
+    SmoothGroup.computeAndApplySmoothPosHpr()
+    return cont
+
 
 GlobalSmoothing = 0
 GlobalPrediction = 0
@@ -118,6 +129,16 @@ class DistributedSmoothNode(DistributedNode.DistributedNode,
         self.smoothPosition()
         return cont
 
+    def canBatchSmooth(self):
+        # Returns true if this node may be smoothed by SmoothGroup,
+        # which does exactly what smoothPosition() does, below.  A
+        # derived class that specializes smoothPosition() or
+        # doSmoothTask() still gets a task of its own.
+        cls = self.__class__
+        return BatchSmoothing and \
+               cls.smoothPosition == DistributedSmoothNode.smoothPosition and \
+               cls.doSmoothTask == DistributedSmoothNode.doSmoothTask
+
     def wantsSmoothing(self):
         # Override this function to return 0 if this particular kind
         # of smooth node doesn't really want to be smoothed.
@@ -136,7 +157,12 @@ class DistributedSmoothNode(DistributedNode.DistributedNode,
             taskName = self.taskName("smooth")
             taskMgr.remove(taskName)
             self.reloadPosition()
-            taskMgr.add(self.doSmoothTask, taskName)
+            if self.canBatchSmooth():
+                SmoothGroup.addMover(self.smoother, self, self)
+                if not taskMgr.hasTaskNamed(SmoothGroupTaskName):
+                    taskMgr.add(doSmoothGroupTask, SmoothGroupTaskName)
+            else:
+                taskMgr.add(self.doSmoothTask, taskName)
             self.smoothStarted = 1
 
     def stopSmooth(self):
@@ -147,6 +173,9 @@ class DistributedSmoothNode(DistributedNode.DistributedNode,
         if self.smoothStarted:
             taskName = self.taskName("smooth")
             taskMgr.remove(taskName)
+            SmoothGroup.removeMover(self.smoother)
+            if SmoothGroup.getNumMovers() == 0:
+                taskMgr.remove(SmoothGroupTaskName)
             self.forceToTruePosition()
             self.smoothStarted = 0
 
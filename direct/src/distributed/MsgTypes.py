@@ -101,6 +101,9 @@ MsgName2Id = {
     'STATESERVER_OBJECT_CREATE_WITH_REQUIRED_CONTEXT':     2050,
     'STATESERVER_OBJECT_CREATE_WITH_REQUIR_OTHER_CONTEXT': 2051,
     'STATESERVER_BOUNCE_MESSAGE':                          2086,
+    'STATESERVER_BOUNCE_MESSAGE_COMPRESSED':               2087,
+    'STATESERVER_REQUEST_BUNDLE_COMPRESSION':              2088,
+    'STATESERVER_ACCEPT_BUNDLE_COMPRESSION':               2089,
     }
 
 # create id->name table for debugging
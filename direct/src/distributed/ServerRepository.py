@@ -94,6 +94,11 @@ class ServerRepository:
         self.qcr = QueuedConnectionReader(self.qcm, numThreads)
         self.cw = ConnectionWriter(self.qcm, numThreads)
 
+        # The C++ index of the clients interested in each zone, which
+        # sends messages to a whole zone at once.  It mirrors
+        # zonesToClients, below.
+        self.fanout = CZoneFanout(self.cw)
+
         taskMgr.setupTaskChain('flushTask')
         if threadedNet:
             taskMgr.setupTaskChain('flushTask', numThreads = 1,
@@ -152,6 +157,7 @@ class ServerRepository:
         self.needsFlush = set()
         for client in flush:
             client.connection.flush()
+        self.fanout.flush()
 
         return task.again
 
@@ -314,6 +320,7 @@ class ServerRepository:
             client = self.Client(newConnection, netAddress, doIdBase)
             self.clientsByConnection[client.connection] = client
             self.clientsByDoIdBase[client.doIdBase] = client
+            self.fanout.addClient(client.connection, client.doIdBase)
 
             # Now we can start listening to that new connection.
             self.qcr.addConnection(newConnection)
@@ -469,6 +476,22 @@ class ServerRepository:
                     object.dclass.getName(), dcfield.getName(), doId, client.doIdBase))
                 return
 
+        if not targeted and not dcfield.hasKeyword('p2p'):
+            # The fanout object reformats the message, as below, just
+            # once for the whole zone.
+            if dcfield.hasKeyword('broadcast'):
+                # Broadcast: to everyone except orig sender
+                self.fanout.sendUpdateField(
+                    object.zoneId, client.doIdBase, doId, fieldId, dgi,
+                    client.connection)
+                return
+
+            elif dcfield.hasKeyword('reflect'):
+                # Reflect: broadcast to everyone including orig sender
+                self.fanout.sendUpdateField(
+                    object.zoneId, client.doIdBase, doId, fieldId, dgi)
+                return
+
         # We reformat the message slightly to insert the sender's
         # doIdBase.
         dg = PyDatagram()
@@ -495,14 +518,6 @@ class ServerRepository:
             self.cw.send(dg, owner.connection)
             self.needsFlush.add(owner)
                         
-        elif dcfield.hasKeyword('broadcast'):
-            # Broadcast: to everyone except orig sender
-            self.sendToZoneExcept(object.zoneId, dg, [client])
-            
-        elif dcfield.hasKeyword('reflect'):
-            # Reflect: broadcast to everyone including orig sender
-            self.sendToZoneExcept(object.zoneId, dg, [])
-
         else:
             self.notify.warning(
                 "Message is not broadcast or p2p")
@@ -610,6 +625,7 @@ class ServerRepository:
                 del self.zonesToClients[zoneId]
             else:
                 self.zonesToClients[zoneId].remove(client)
+        self.fanout.removeClient(client.connection)
 
         for object in client.objectsByDoId.values():
             #create and send delete message
@@ -662,6 +678,7 @@ class ServerRepository:
 
         for zoneId in addedZoneIds:
             self.zonesToClients.setdefault(zoneId, set()).add(client)
+            self.fanout.addInterest(client.connection, zoneId)
 
             # The client is opening interest in this zone. Need to get
             # all of the data from clients who may have objects in
@@ -675,6 +692,7 @@ class ServerRepository:
         datagram.addUint16(OBJECT_DISABLE_CMU)
         for zoneId in removedZoneIds:
             self.zonesToClients[zoneId].remove(client)
+            self.fanout.removeInterest(client.connection, zoneId)
 
             # The client is abandoning interest in this zone.  Any
             # objects in this zone should be disabled for the client.
@@ -701,12 +719,21 @@ class ServerRepository:
             self.notify.debug(
                 "ServerRepository sending to all in zone %s except %s:" % (zoneId, [c.doIdBase for c in exceptionList]))
             #datagram.dumpHex(ostream)
+            for client in self.zonesToClients.get(zoneId, []):
+                if client not in exceptionList:
+                    self.notify.debug(
+                        "  -> %s" % (client.doIdBase))
+
+        if len(exceptionList) <= 1:
+            # The common case is handled entirely in C++.
+            exceptConnection = None
+            if exceptionList:
+                exceptConnection = exceptionList[0].connection
+            self.fanout.sendToZone(zoneId, datagram, exceptConnection)
+            return
 
         for client in self.zonesToClients.get(zoneId, []):
             if client not in exceptionList:
-                if self.notify.getDebug():
-                    self.notify.debug(
-                        "  -> %s" % (client.doIdBase))
                 self.cw.send(datagram, client.connection)
                 self.needsFlush.add(client)
 
@@ -718,11 +745,19 @@ class ServerRepository:
             self.notify.debug(
                 "ServerRepository sending to all except %s:" % ([c.doIdBase for c in exceptionList],))
             #datagram.dumpHex(ostream)
+            for client in self.clientsByConnection.values():
+                if client not in exceptionList:
+                    self.notify.debug(
+                        "  -> %s" % (client.doIdBase))
+
+        if len(exceptionList) <= 1:
+            exceptConnection = None
+            if exceptionList:
+                exceptConnection = exceptionList[0].connection
+            self.fanout.sendToAll(datagram, exceptConnection)
+            return
 
         for client in self.clientsByConnection.values():
             if client not in exceptionList:
-                if self.notify.getDebug():
-                    self.notify.debug(
-                        "  -> %s" % (client.doIdBase))
                 self.cw.send(datagram, client.connection)
                 self.needsFlush.add(client)
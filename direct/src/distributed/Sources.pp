@@ -2,7 +2,7 @@
 
 #begin lib_target
   #define BUILD_TARGET $[HAVE_PYTHON]
-  #define USE_PACKAGES openssl native_net net
+  #define USE_PACKAGES openssl native_net net zlib
 
   #define TARGET p3distributed
   #define LOCAL_LIBS \
@@ -16,10 +16,60 @@
 
   #define SOURCES \
     config_distributed.cxx config_distributed.h \
+    cBundleCompressor.cxx cBundleCompressor.I cBundleCompressor.h \
     cConnectionRepository.cxx cConnectionRepository.I \
     cConnectionRepository.h \
     cDistributedSmoothNodeBase.cxx cDistributedSmoothNodeBase.I \
-    cDistributedSmoothNodeBase.h
+    cDistributedSmoothNodeBase.h \
+    cZoneFanout.cxx cZoneFanout.I cZoneFanout.h
 
   #define IGATESCAN all
 #end lib_target
+
+#begin test_bin_target
+  #define BUILD_TARGET $[and $[HAVE_PYTHON],$[HAVE_NET]]
+  #define USE_PACKAGES native_net net
+  #define TARGET test_zone_fanout
+  #define LOCAL_LIBS \
+    p3distributed p3dcparser p3directbase
+  #define OTHER_LIBS \
+    p3express:c pandaexpress:m p3net:c panda:m \
+    p3interrogatedb:c p3dconfig:c p3dtoolconfig:m \
+    p3dtoolutil:c p3dtoolbase:c p3dtool:m p3prc:c p3pystub
+
+  #define SOURCES \
+    test_zone_fanout.cxx
+
+#end test_bin_target
+
+#begin test_bin_target
+  #define BUILD_TARGET $[HAVE_PYTHON]
+  #define USE_PACKAGES zlib
+  #define TARGET test_bundle_compressor
+  #define LOCAL_LIBS \
+    p3distributed p3dcparser p3directbase
+  #define OTHER_LIBS \
+    p3express:c pandaexpress:m panda:m \
+    p3interrogatedb:c p3dconfig:c p3dtoolconfig:m \
+    p3dtoolutil:c p3dtoolbase:c p3dtool:m p3prc:c p3pystub
+
+  #define SOURCES \
+    test_bundle_compressor.cxx
+
+#end test_bin_target
+
+#begin test_bin_target
+  #define BUILD_TARGET $[and $[HAVE_PYTHON],$[HAVE_NET]]
+  #define USE_PACKAGES zlib native_net net
+  #define TARGET test_bundle_negotiation
+  #define LOCAL_LIBS \
+    p3distributed p3dcparser p3directbase
+  #define OTHER_LIBS \
+    p3express:c pandaexpress:m p3net:c p3downloader:c panda:m \
+    p3interrogatedb:c p3dconfig:c p3dtoolconfig:m \
+    p3dtoolutil:c p3dtoolbase:c p3dtool:m p3prc:c p3pystub
+
+  #define SOURCES \
+    test_bundle_negotiation.cxx
+
+#end test_bin_target
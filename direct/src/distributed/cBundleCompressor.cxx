@@ -0,0 +1,434 @@
+// Filename: cBundleCompressor.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "cBundleCompressor.h"
+#include "config_distributed.h"
+#include "dcmsgtypes.h"
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+// A delta message refers to the field it updates by a 16-bit index,
+// so we can remember no more than this many fields.  Once the
+// history is full, each new field takes the place of the one least
+// recently updated.
+static const int max_history = 0x10000;
+
+// zlib can never compress better than about 1032 to 1, so a bundle
+// that claims to expand by more than this is corrupt.
+static const size_t max_deflate_ratio = 1032;
+
+// Bundles smaller than this are never worth running through zlib,
+// whose own header and checksum take up 6 bytes.
+static const size_t min_deflate_size = 32;
+
+// Bundles are small, so we give zlib a small window and hash table;
+// deflateReset() has to clear the hash table before each bundle, and
+// with zlib's defaults that costs more than the compression itself.
+static const int deflate_window_bits = 12;
+static const int deflate_mem_level = 4;
+
+////////////////////////////////////////////////////////////////////
+//     Function: get_field_update
+//  Description: If the indicated message, in the server format
+//               (beginning with its list of channels), is a
+//               STATESERVER_OBJECT_UPDATE_FIELD message, fills in the
+//               doId and field index it updates and returns true.
+//               Otherwise, returns false.
+////////////////////////////////////////////////////////////////////
+static bool
+get_field_update(const string &message, DOID_TYPE &do_id,
+                 unsigned int &field_id) {
+  const unsigned char *data = (const unsigned char *)message.data();
+  size_t size = message.size();
+  if (size < 1) {
+    return false;
+  }
+
+  // Skip the channels and the sender.
+  size_t p = 1 + (data[0] + 1) * sizeof(CHANNEL_TYPE);
+  if (p + 8 > size) {
+    return false;
+  }
+
+  unsigned int msg_type = data[p] | (data[p + 1] << 8);
+  if (msg_type != STATESERVER_OBJECT_UPDATE_FIELD) {
+    return false;
+  }
+
+  do_id = ((DOID_TYPE)data[p + 2] | ((DOID_TYPE)data[p + 3] << 8) |
+           ((DOID_TYPE)data[p + 4] << 16) | ((DOID_TYPE)data[p + 5] << 24));
+  field_id = data[p + 6] | (data[p + 7] << 8);
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CBundleCompressor::Constructor
+//       Access: Published
+//  Description:
+////////////////////////////////////////////////////////////////////
+CBundleCompressor::
+CBundleCompressor() {
+#ifdef HAVE_ZLIB
+  _deflate = (z_stream *)NULL;
+  _deflate_level = 0;
+  _inflate = (z_stream *)NULL;
+#endif  // HAVE_ZLIB
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CBundleCompressor::Destructor
+//       Access: Published
+//  Description:
+////////////////////////////////////////////////////////////////////
+CBundleCompressor::
+~CBundleCompressor() {
+#ifdef HAVE_ZLIB
+  if (_deflate != (z_stream *)NULL) {
+    deflateEnd(_deflate);
+    delete _deflate;
+  }
+  if (_inflate != (z_stream *)NULL) {
+    inflateEnd(_inflate);
+    delete _inflate;
+  }
+#endif  // HAVE_ZLIB
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CBundleCompressor::clear
+//       Access: Published
+//  Description: Forgets all of the field updates seen so far, so
+//               that the next bundle is packed or unpacked as if it
+//               were the first.  This must be done at both ends at
+//               the same time.
+////////////////////////////////////////////////////////////////////
+void CBundleCompressor::
+clear() {
+  _history_index.clear();
+  _history.clear();
+  _lru.clear();
+  _messages.clear();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CBundleCompressor::unpack_bundle
+//       Access: Published
+//  Description: Unpacks the body of a
+//               STATESERVER_BOUNCE_MESSAGE_COMPRESSED message sent to
+//               the indicated channel, which the iterator should be
+//               positioned at the start of.  The messages it
+//               contained may then be retrieved with
+//               get_num_messages() and get_message().
+//
+//               Returns true on success, or false if the bundle is
+//               invalid, in which case this end can no longer follow
+//               the other, and the connection should be dropped.
+////////////////////////////////////////////////////////////////////
+bool CBundleCompressor::
+unpack_bundle(CHANNEL_TYPE channel, DatagramIterator &di) {
+  _messages.clear();
+
+  if (di.get_remaining_size() < 3) {
+    distributed_cat.error()
+      << "Truncated compressed message bundle.\n";
+    return false;
+  }
+  int flags = di.get_uint8();
+  int num_messages = di.get_uint16();
+
+  Datagram body;
+  if ((flags & BF_deflate) != 0) {
+#ifdef HAVE_ZLIB
+    if (di.get_remaining_size() < 4) {
+      distributed_cat.error()
+        << "Truncated compressed message bundle.\n";
+      return false;
+    }
+    size_t body_length = di.get_uint32();
+    size_t payload_length = di.get_remaining_size();
+    if (body_length > payload_length * max_deflate_ratio) {
+      distributed_cat.error()
+        << "Invalid length in compressed message bundle.\n";
+      return false;
+    }
+
+    if (_inflate == (z_stream *)NULL) {
+      z_stream *stream = new z_stream;
+      memset(stream, 0, sizeof(z_stream));
+      if (inflateInit(stream) != Z_OK) {
+        delete stream;
+        distributed_cat.error()
+          << "Unable to initialize zlib.\n";
+        return false;
+      }
+      _inflate = stream;
+    }
+    inflateReset(_inflate);
+
+    _buffer.resize(max(body_length, (size_t)1));
+    _inflate->next_in = (Bytef *)((const unsigned char *)di.get_datagram().get_data() +
+                                  di.get_current_index());
+    _inflate->avail_in = payload_length;
+    _inflate->next_out = &_buffer[0];
+    _inflate->avail_out = body_length;
+    int result = inflate(_inflate, Z_FINISH);
+    if (result != Z_STREAM_END || _inflate->total_out != body_length) {
+      distributed_cat.error()
+        << "Unable to decompress message bundle.\n";
+      return false;
+    }
+    di.skip_bytes(payload_length);
+    body = Datagram(&_buffer[0], body_length);
+#else
+    distributed_cat.error()
+      << "Cannot decompress message bundle; zlib not available.\n";
+    return false;
+#endif  // HAVE_ZLIB
+
+  } else {
+    body = Datagram(di.extract_bytes(di.get_remaining_size()));
+  }
+
+  DatagramIterator scan(body);
+  for (int i = 0; i < num_messages; ++i) {
+    if (scan.get_remaining_size() < 3) {
+      break;
+    }
+    int kind = scan.get_uint8();
+
+    if (kind == MK_literal) {
+      size_t length = scan.get_uint16();
+      if ((size_t)scan.get_remaining_size() < length) {
+        break;
+      }
+      _messages.push_back(scan.extract_bytes(length));
+      const string &message = _messages.back();
+      int index = find_history(channel, message);
+      if (index >= 0) {
+        _history[index]._message = message;
+      }
+
+    } else if (kind == MK_delta) {
+      int index = scan.get_uint16();
+      if (index >= (int)_history.size() ||
+          !unpack_delta(_history[index]._message, scan)) {
+        break;
+      }
+      // The other end found this slot with find_history(), which
+      // marked it used; we must do the same to keep step.
+      touch_history(index);
+      _messages.push_back(_history[index]._message);
+
+    } else {
+      break;
+    }
+  }
+
+  if ((int)_messages.size() != num_messages ||
+      scan.get_remaining_size() != 0) {
+    distributed_cat.error()
+      << "Invalid message in compressed message bundle.\n";
+    _messages.clear();
+    return false;
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CBundleCompressor::pack_bundle
+//       Access: Public
+//  Description: Appends the body of a
+//               STATESERVER_BOUNCE_MESSAGE_COMPRESSED message
+//               containing the indicated messages, each in the server
+//               format, to the datagram.  The channel is the one the
+//               bundle is being sent to.
+//
+//               compression_level is the zlib compression level to
+//               use, from 1 (fastest) to 9 (smallest); 0 sends the
+//               bundle uncompressed, although the field updates in it
+//               are still sent as differences.
+////////////////////////////////////////////////////////////////////
+void CBundleCompressor::
+pack_bundle(Datagram &dg, CHANNEL_TYPE channel, const Messages &messages,
+            int compression_level) {
+  nassertv(messages.size() <= 0xffff);
+
+  Datagram body;
+  Messages::const_iterator mi;
+  for (mi = messages.begin(); mi != messages.end(); ++mi) {
+    const string &message = (*mi);
+    int index = find_history(channel, message);
+
+    if (index >= 0 && _history[index]._message.size() == message.size()) {
+      // Send only the bytes that differ from the last update to this
+      // field.
+      body.add_uint8(MK_delta);
+      body.add_uint16(index);
+      pack_delta(body, _history[index]._message, message);
+      _history[index]._message = message;
+
+    } else {
+      body.add_uint8(MK_literal);
+      body.add_string(message);
+      if (index >= 0) {
+        _history[index]._message = message;
+      }
+    }
+  }
+
+#ifdef HAVE_ZLIB
+  if (compression_level > 0 && body.get_length() > min_deflate_size) {
+    // We keep the same zlib stream from one bundle to the next, since
+    // setting one up costs much more than compressing a small bundle.
+    // Each bundle is still compressed independently.
+    if (_deflate != (z_stream *)NULL && _deflate_level != compression_level) {
+      deflateEnd(_deflate);
+      delete _deflate;
+      _deflate = (z_stream *)NULL;
+    }
+    if (_deflate == (z_stream *)NULL) {
+      z_stream *stream = new z_stream;
+      memset(stream, 0, sizeof(z_stream));
+      if (deflateInit2(stream, compression_level, Z_DEFLATED,
+                       deflate_window_bits, deflate_mem_level,
+                       Z_DEFAULT_STRATEGY) == Z_OK) {
+        _deflate = stream;
+        _deflate_level = compression_level;
+      } else {
+        delete stream;
+      }
+    }
+
+    if (_deflate != (z_stream *)NULL) {
+      deflateReset(_deflate);
+      _buffer.resize(deflateBound(_deflate, body.get_length()));
+      _deflate->next_in = (Bytef *)body.get_data();
+      _deflate->avail_in = body.get_length();
+      _deflate->next_out = &_buffer[0];
+      _deflate->avail_out = _buffer.size();
+      int result = deflate(_deflate, Z_FINISH);
+      size_t length = _deflate->total_out;
+      if (result == Z_STREAM_END && length + 4 < body.get_length()) {
+        dg.add_uint8(BF_deflate);
+        dg.add_uint16(messages.size());
+        dg.add_uint32(body.get_length());
+        dg.append_data(&_buffer[0], length);
+        return;
+      }
+    }
+  }
+#endif  // HAVE_ZLIB
+
+  dg.add_uint8(0);
+  dg.add_uint16(messages.size());
+  dg.append_data(body.get_data(), body.get_length());
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CBundleCompressor::pack_delta
+//       Access: Private, Static
+//  Description: Appends to the datagram the difference between the
+//               two messages, which must be the same length: a bit
+//               mask with one bit for each byte of the message,
+//               followed by the new value of each byte whose bit is
+//               set.
+////////////////////////////////////////////////////////////////////
+void CBundleCompressor::
+pack_delta(Datagram &dg, const string &last, const string &message) {
+  size_t size = message.size();
+  string mask((size + 7) / 8, '\0');
+  string changed;
+  for (size_t i = 0; i < size; ++i) {
+    if (last[i] != message[i]) {
+      mask[i >> 3] |= (1 << (i & 7));
+      changed += message[i];
+    }
+  }
+  dg.append_data(mask);
+  dg.append_data(changed);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CBundleCompressor::unpack_delta
+//       Access: Private, Static
+//  Description: Applies to the message the difference written by
+//               pack_delta(), reading it from the iterator.  Returns
+//               true on success, false if the difference is
+//               truncated.
+////////////////////////////////////////////////////////////////////
+bool CBundleCompressor::
+unpack_delta(string &message, DatagramIterator &scan) {
+  size_t size = message.size();
+  size_t mask_size = (size + 7) / 8;
+  if ((size_t)scan.get_remaining_size() < mask_size) {
+    return false;
+  }
+  string mask = scan.extract_bytes(mask_size);
+
+  for (size_t i = 0; i < size; ++i) {
+    if ((mask[i >> 3] & (1 << (i & 7))) != 0) {
+      if (scan.get_remaining_size() < 1) {
+        return false;
+      }
+      message[i] = scan.get_uint8();
+    }
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CBundleCompressor::find_history
+//       Access: Private
+//  Description: Returns the index of the last update seen to the
+//               field updated by the indicated message, and marks it
+//               the most recently used.  A field not seen before is
+//               given a new, empty entry; if the history is full, the
+//               entry of the field least recently updated is emptied
+//               and given to the new field instead.  Returns -1 if
+//               the message is not a field update.
+////////////////////////////////////////////////////////////////////
+int CBundleCompressor::
+find_history(CHANNEL_TYPE channel, const string &message) {
+  DOID_TYPE do_id;
+  unsigned int field_id;
+  if (!get_field_update(message, do_id, field_id)) {
+    return -1;
+  }
+
+  HistoryKey key(channel, do_id, field_id);
+  HistoryIndex::iterator hi = _history_index.find(key);
+  if (hi != _history_index.end()) {
+    int index = (*hi).second;
+    touch_history(index);
+    return index;
+  }
+
+  int index;
+  if ((int)_history.size() < max_history) {
+    index = (int)_history.size();
+    _history.push_back(HistoryEntry());
+    _history[index]._lru_pos = _lru.insert(_lru.end(), index);
+  } else {
+    index = _lru.front();
+    _history_index.erase(_history[index]._index_pos);
+    _history[index]._message = string();
+    touch_history(index);
+  }
+  _history[index]._index_pos =
+    _history_index.insert(HistoryIndex::value_type(key, index)).first;
+  return index;
+}
@@ -0,0 +1,145 @@
+// Filename: cBundleCompressor.h
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef CBUNDLECOMPRESSOR_H
+#define CBUNDLECOMPRESSOR_H
+
+#include "directbase.h"
+#include "dcbase.h"
+#include "datagram.h"
+#include "datagramIterator.h"
+#include "pvector.h"
+#include "pmap.h"
+#include "plist.h"
+
+#ifdef HAVE_ZLIB
+// We keep zlib's streams by pointer, so that zlib.h need not be
+// included here.
+struct z_stream_s;
+#endif
+
+////////////////////////////////////////////////////////////////////
+//       Class : CBundleCompressor
+// Description : This class packs the messages of a message bundle
+//               (see CConnectionRepository::start_message_bundle())
+//               into the body of a
+//               STATESERVER_BOUNCE_MESSAGE_COMPRESSED message, and
+//               unpacks them again at the other end.
+//
+//               Each field update in a bundle is sent as the
+//               difference from the last update sent for the same
+//               field of the same object to the same channel, if
+//               there was one of the same length; since most updates
+//               (position broadcasts, for instance) change only a few
+//               bytes from one frame to the next, this is usually
+//               much smaller than the update itself.  Larger bundles
+//               are then compressed with zlib, if that makes them
+//               smaller still.
+//
+//               Only the max_history most recently updated fields
+//               are remembered; once that many have been seen, an
+//               update to a new field displaces the one that has gone
+//               the longest without an update, so that long-running
+//               connections on which objects come and go do not run
+//               out of room.
+//
+//               Since each end remembers the updates it has seen, the
+//               two ends must pack and unpack exactly the same
+//               bundles in exactly the same order, and must be
+//               clear()ed together, for instance when a new
+//               connection is made.
+////////////////////////////////////////////////////////////////////
+class EXPCL_DIRECT CBundleCompressor {
+PUBLISHED:
+  CBundleCompressor();
+  ~CBundleCompressor();
+
+  void clear();
+
+  bool unpack_bundle(CHANNEL_TYPE channel, DatagramIterator &di);
+  INLINE int get_num_messages() const;
+  INLINE Datagram get_message(int n) const;
+
+public:
+  typedef pvector<string> Messages;
+
+  void pack_bundle(Datagram &dg, CHANNEL_TYPE channel,
+                   const Messages &messages, int compression_level);
+  INLINE const Messages &get_messages() const;
+
+private:
+  CBundleCompressor(const CBundleCompressor &copy);
+  void operator = (const CBundleCompressor &copy);
+
+  int find_history(CHANNEL_TYPE channel, const string &message);
+  INLINE void touch_history(int index);
+  static void pack_delta(Datagram &dg, const string &last,
+                         const string &message);
+  static bool unpack_delta(string &message, DatagramIterator &scan);
+
+  enum BundleFlags {
+    BF_deflate = 0x01
+  };
+
+  enum MessageKind {
+    MK_literal = 0,
+    MK_delta = 1
+  };
+
+  class HistoryKey {
+  public:
+    INLINE HistoryKey(CHANNEL_TYPE channel, DOID_TYPE do_id,
+                      unsigned int field_id);
+    INLINE bool operator < (const HistoryKey &other) const;
+
+    CHANNEL_TYPE _channel;
+    DOID_TYPE _do_id;
+    unsigned int _field_id;
+  };
+
+  // The last message seen for each field.  A field keeps the same
+  // slot in _history for as long as it is remembered; the slot number
+  // is what a delta message refers to.  _lru lists the slots in the
+  // order they were last used, least recently first, and is used to
+  // choose the slot to reuse once the history is full.
+  typedef pmap<HistoryKey, int> HistoryIndex;
+  typedef plist<int> LRU;
+
+  class HistoryEntry {
+  public:
+    string _message;
+    HistoryIndex::iterator _index_pos;
+    LRU::iterator _lru_pos;
+  };
+  typedef pvector<HistoryEntry> History;
+
+  HistoryIndex _history_index;
+  History _history;
+  LRU _lru;
+
+  // The messages most recently unpacked by unpack_bundle().
+  Messages _messages;
+
+#ifdef HAVE_ZLIB
+  // These are NULL until they are first needed.
+  z_stream_s *_deflate;
+  int _deflate_level;
+  z_stream_s *_inflate;
+  pvector<unsigned char> _buffer;
+#endif  // HAVE_ZLIB
+};
+
+#include "cBundleCompressor.I"
+
+#endif  // CBUNDLECOMPRESSOR_H
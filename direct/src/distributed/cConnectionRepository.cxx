@@ -31,6 +31,11 @@
 
 const string CConnectionRepository::_overflow_event_name = "CRDatagramOverflow";
 
+// The version of the compressed message bundle format, sent with
+// STATESERVER_REQUEST_BUNDLE_COMPRESSION.  It must change whenever
+// CBundleCompressor changes the way it packs bundles.
+static const int bundle_compression_version = 1;
+
 #ifndef CPPPARSER
 PStatCollector CConnectionRepository::_update_pcollector("App:Show code:readerPollTask:Update");
 #endif  // CPPPARSER
@@ -69,7 +74,13 @@ CConnectionRepository(bool has_owner_view, bool threaded_net) :
   _handle_c_updates(true),
   _want_message_bundling(true),
   _bundling_msgs(0),
-  _in_quiet_zone(0)
+  _in_quiet_zone(0),
+  _want_bundle_compression(want_bundle_compression),
+  _peer_accepts_bundle_compression(false),
+  _accepts_bundle_compression(false),
+  _num_bundles_sent(0),
+  _bundle_bytes_uncompressed(0),
+  _bundle_bytes_sent(0)
 {
 #if defined(HAVE_NET) && defined(SIMULATE_NETWORK_DELAY)
   if (min_lag != 0.0 || max_lag != 0.0) {
@@ -324,6 +335,27 @@ check_datagram() {
     }
 
     _msg_type = _di.get_uint16();
+
+    if (!_client_datagram) {
+      // These messages concern the connection itself, so we always
+      // handle them here.
+      switch (_msg_type) {
+      case STATESERVER_REQUEST_BUNDLE_COMPRESSION:
+        handle_request_bundle_compression();
+        continue;
+
+      case STATESERVER_ACCEPT_BUNDLE_COMPRESSION:
+        handle_accept_bundle_compression();
+        continue;
+
+      case STATESERVER_BOUNCE_MESSAGE_COMPRESSED:
+        if (!unpack_message_bundle()) {
+          return false;
+        }
+        break;
+      }
+    }
+
     // Is this a message that we can process directly?
     if (!_handle_datagrams_internally) {
       return true;
@@ -518,13 +550,30 @@ send_message_bundle(unsigned int channel, unsigned int sender_channel) {
     dg.add_int8(1);
     dg.add_uint64(channel);
     dg.add_uint64(sender_channel);
-    dg.add_uint16(STATESERVER_BOUNCE_MESSAGE);
-    // add each bundled message
+
+    // count the size of the bundle as it would be uncompressed
+    size_t uncompressed_size = dg.get_length() + 2;
     BundledMsgVector::const_iterator bmi;
     for (bmi = _bundle_msgs.begin(); bmi != _bundle_msgs.end(); bmi++) {
-      dg.add_string(*bmi);
+      uncompressed_size += 2 + (*bmi).size();
     }
 
+    if (is_compressing_bundles()) {
+      dg.add_uint16(STATESERVER_BOUNCE_MESSAGE_COMPRESSED);
+      _bundle_compressor.pack_bundle(dg, channel, _bundle_msgs,
+                                     bundle_compression_level);
+    } else {
+      dg.add_uint16(STATESERVER_BOUNCE_MESSAGE);
+      // add each bundled message
+      for (bmi = _bundle_msgs.begin(); bmi != _bundle_msgs.end(); bmi++) {
+        dg.add_string(*bmi);
+      }
+    }
+
+    ++_num_bundles_sent;
+    _bundle_bytes_uncompressed += uncompressed_size;
+    _bundle_bytes_sent += dg.get_length();
+
     send_datagram(dg);
   }
 }
@@ -557,6 +606,72 @@ bundle_msg(const Datagram &dg) {
   _bundle_msgs.push_back(dg.get_message());
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: CConnectionRepository::request_bundle_compression
+//       Access: Published
+//  Description: Asks the other end of the current connection whether
+//               it will accept compressed message bundles
+//               (STATESERVER_BOUNCE_MESSAGE_COMPRESSED), by sending
+//               it a STATESERVER_REQUEST_BUNDLE_COMPRESSION message.
+//               This should be called once, just after the
+//               connection is made.
+//
+//               If the other end agrees, it answers with
+//               STATESERVER_ACCEPT_BUNDLE_COMPRESSION, which
+//               check_datagram() handles by calling
+//               set_peer_accepts_bundle_compression(); until then,
+//               bundles are sent uncompressed.  Another
+//               CConnectionRepository at the other end agrees
+//               automatically, and unpacks the bundles it receives.
+//
+//               Returns true if the request was sent, or false if
+//               bundle compression is not wanted at this end, or the
+//               connection does not use the server message format.
+////////////////////////////////////////////////////////////////////
+bool CConnectionRepository::
+request_bundle_compression() {
+  ReMutexHolder holder(_lock);
+  nassertr(_bundling_msgs == 0, false);
+
+  if (!_want_bundle_compression || _client_datagram) {
+    return false;
+  }
+
+  // This message is meant for the other end of the connection itself,
+  // not for any channel, so it is addressed to no channels.
+  Datagram dg;
+  dg.add_int8(0);
+  dg.add_uint64(0);
+  dg.add_uint16(STATESERVER_REQUEST_BUNDLE_COMPRESSION);
+  dg.add_uint8(bundle_compression_version);
+  return send_datagram(dg);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CConnectionRepository::set_peer_accepts_bundle_compression
+//       Access: Published
+//  Description: Indicates whether the other end of the current
+//               connection has agreed to accept compressed message
+//               bundles (STATESERVER_BOUNCE_MESSAGE_COMPRESSED).  This
+//               is set true automatically when the other end answers
+//               request_bundle_compression(), but the application may
+//               set it directly if it has agreed on compression some
+//               other way.  It is reset to false when the connection
+//               is closed.
+//
+//               Each compressed bundle depends on the ones sent
+//               before it, so the other end must start unpacking from
+//               the first bundle sent after this call.
+////////////////////////////////////////////////////////////////////
+void CConnectionRepository::
+set_peer_accepts_bundle_compression(bool flag) {
+  ReMutexHolder holder(_lock);
+  // don't allow enable/disable while bundling
+  nassertv(_bundling_msgs == 0);
+  _peer_accepts_bundle_compression = flag;
+  _bundle_compressor.clear();
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: CConnectionRepository::consider_flush
 //       Access: Published
@@ -657,6 +772,10 @@ disconnect() {
   #endif  // HAVE_OPENSSL
 
   _simulated_disconnect = false;
+  _peer_accepts_bundle_compression = false;
+  _bundle_compressor.clear();
+  _accepts_bundle_compression = false;
+  _bundle_decompressor.clear();
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -925,6 +1044,127 @@ handle_update_field_owner() {
   return true;
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: CConnectionRepository::handle_request_bundle_compression
+//       Access: Private
+//  Description: Handles a STATESERVER_REQUEST_BUNDLE_COMPRESSION
+//               message from the other end of the connection.  If we
+//               can unpack the bundle format it asks for, we start
+//               unpacking from scratch and answer with
+//               STATESERVER_ACCEPT_BUNDLE_COMPRESSION; otherwise we
+//               say nothing, and the other end goes on sending
+//               bundles uncompressed.
+////////////////////////////////////////////////////////////////////
+void CConnectionRepository::
+handle_request_bundle_compression() {
+  int version = 0;
+  if (_di.get_remaining_size() >= 1) {
+    version = _di.get_uint8();
+  }
+
+#ifdef HAVE_ZLIB
+  if (version == bundle_compression_version) {
+    _accepts_bundle_compression = true;
+    _bundle_decompressor.clear();
+
+    Datagram dg;
+    dg.add_int8(0);
+    dg.add_uint64(0);
+    dg.add_uint16(STATESERVER_ACCEPT_BUNDLE_COMPRESSION);
+    dg.add_uint8(version);
+    send_datagram(dg);
+    return;
+  }
+#endif  // HAVE_ZLIB
+
+  distributed_cat.info()
+    << "Not accepting compressed message bundles, version " << version
+    << ".\n";
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CConnectionRepository::handle_accept_bundle_compression
+//       Access: Private
+//  Description: Handles a STATESERVER_ACCEPT_BUNDLE_COMPRESSION
+//               message, the answer to request_bundle_compression().
+////////////////////////////////////////////////////////////////////
+void CConnectionRepository::
+handle_accept_bundle_compression() {
+  int version = 0;
+  if (_di.get_remaining_size() >= 1) {
+    version = _di.get_uint8();
+  }
+  if (version != bundle_compression_version) {
+    distributed_cat.warning()
+      << "Ignoring acceptance of compressed message bundles, version "
+      << version << ".\n";
+    return;
+  }
+
+  if (distributed_cat.is_debug()) {
+    distributed_cat.debug()
+      << "Other end accepts compressed message bundles.\n";
+  }
+
+  // A bundle may be in progress, but it is not packed until it is
+  // sent, so it is safe to start compressing now.
+  _peer_accepts_bundle_compression = true;
+  _bundle_compressor.clear();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CConnectionRepository::unpack_message_bundle
+//       Access: Private
+//  Description: Unpacks the STATESERVER_BOUNCE_MESSAGE_COMPRESSED
+//               message in _dg, and replaces it with the
+//               STATESERVER_BOUNCE_MESSAGE message it would have been
+//               if it had been sent uncompressed, so that the caller
+//               need not know the difference.
+//
+//               Returns true on success.  If the bundle cannot be
+//               unpacked, we can no longer follow the other end, so
+//               the connection is closed and false is returned.
+////////////////////////////////////////////////////////////////////
+bool CConnectionRepository::
+unpack_message_bundle() {
+  // The other end packed the bundle against the channel it sent it
+  // to.
+  CHANNEL_TYPE channel = 0;
+  if (!_msg_channels.empty()) {
+    channel = _msg_channels[0];
+  }
+
+  if (!_accepts_bundle_compression ||
+      !_bundle_decompressor.unpack_bundle(channel, _di)) {
+    distributed_cat.error()
+      << "Unable to unpack compressed message bundle; closing connection.\n";
+    disconnect();
+    return false;
+  }
+
+  Datagram dg;
+  dg.add_int8(_msg_channels.size());
+  std::vector<CHANNEL_TYPE>::const_iterator ci;
+  for (ci = _msg_channels.begin(); ci != _msg_channels.end(); ++ci) {
+    dg.add_uint64(*ci);
+  }
+  dg.add_uint64(_msg_sender);
+  dg.add_uint16(STATESERVER_BOUNCE_MESSAGE);
+  size_t header_length = dg.get_length();
+
+  const CBundleCompressor::Messages &messages =
+    _bundle_decompressor.get_messages();
+  CBundleCompressor::Messages::const_iterator mi;
+  for (mi = messages.begin(); mi != messages.end(); ++mi) {
+    dg.add_string(*mi);
+  }
+
+  _dg = dg;
+  _di = DatagramIterator(_dg, header_length);
+  _msg_type = STATESERVER_BOUNCE_MESSAGE;
+  return true;
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: CConnectionRepository::describe_message
 //       Access: Private
@@ -26,6 +26,7 @@
 #include "clockObject.h"
 #include "reMutex.h"
 #include "reMutexHolder.h"
+#include "cBundleCompressor.h"
 
 #ifdef HAVE_NET
 #include "queuedConnectionManager.h"
@@ -57,6 +58,12 @@ class SocketStream;
 //               handled entirely within the C++ layer, while server
 //               messages that are not understood by the C++ layer are
 //               returned up to the Python layer for processing.
+//
+//               The negotiation of compressed message bundles (see
+//               request_bundle_compression()) is also handled here,
+//               and compressed bundles received are unpacked and
+//               passed up as ordinary STATESERVER_BOUNCE_MESSAGE
+//               bundles.
 ////////////////////////////////////////////////////////////////////
 class EXPCL_DIRECT CConnectionRepository {
 PUBLISHED:
@@ -144,6 +151,18 @@ PUBLISHED:
   BLOCKING void abandon_message_bundles();
   BLOCKING void bundle_msg(const Datagram &dg);
 
+  BLOCKING INLINE void set_want_bundle_compression(bool flag);
+  BLOCKING INLINE bool get_want_bundle_compression() const;
+  BLOCKING bool request_bundle_compression();
+  BLOCKING void set_peer_accepts_bundle_compression(bool flag);
+  BLOCKING INLINE bool get_peer_accepts_bundle_compression() const;
+  BLOCKING INLINE bool is_compressing_bundles() const;
+
+  BLOCKING INLINE int get_num_bundles_sent() const;
+  BLOCKING INLINE PN_uint64 get_bundle_bytes_uncompressed() const;
+  BLOCKING INLINE PN_uint64 get_bundle_bytes_sent() const;
+  BLOCKING INLINE void reset_bundle_statistics();
+
   BLOCKING bool consider_flush();
   BLOCKING bool flush();
 
@@ -164,6 +183,9 @@ private:
   bool do_check_datagram();
   bool handle_update_field();
   bool handle_update_field_owner();
+  void handle_request_bundle_compression();
+  void handle_accept_bundle_compression();
+  bool unpack_message_bundle();
 
   void describe_message(ostream &out, const string &prefix,
                         const Datagram &dg) const;
@@ -213,9 +235,18 @@ private:
 
   bool _want_message_bundling;
   unsigned int _bundling_msgs;
-  typedef std::vector< string > BundledMsgVector;
+  typedef CBundleCompressor::Messages BundledMsgVector;
   BundledMsgVector _bundle_msgs;
 
+  bool _want_bundle_compression;
+  bool _peer_accepts_bundle_compression;
+  CBundleCompressor _bundle_compressor;
+  bool _accepts_bundle_compression;
+  CBundleCompressor _bundle_decompressor;
+  int _num_bundles_sent;
+  PN_uint64 _bundle_bytes_uncompressed;
+  PN_uint64 _bundle_bytes_sent;
+
   static PStatCollector _update_pcollector;
 };
 
@@ -0,0 +1,423 @@
+// Filename: cZoneFanout.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "cZoneFanout.h"
+
+#ifdef HAVE_NET
+
+#include "config_distributed.h"
+#include "dcPacker.h"
+#include "dcmsgtypes.h"
+#include "lightMutexHolder.h"
+
+////////////////////////////////////////////////////////////////////
+//     Function: CZoneFanout::Constructor
+//       Access: Published
+//  Description: The ConnectionWriter is used to send all messages; it
+//               is not owned by this object, and must persist for as
+//               long as this object does.
+////////////////////////////////////////////////////////////////////
+CZoneFanout::
+CZoneFanout(ConnectionWriter *writer) :
+  _writer(writer),
+  _num_datagrams_sent(0)
+{
+  nassertv(_writer != (ConnectionWriter *)NULL);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CZoneFanout::Destructor
+//       Access: Published
+//  Description:
+////////////////////////////////////////////////////////////////////
+CZoneFanout::
+~CZoneFanout() {
+  Clients::iterator ci;
+  for (ci = _clients.begin(); ci != _clients.end(); ++ci) {
+    delete (*ci).second;
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CZoneFanout::add_client
+//       Access: Published
+//  Description: Adds a new client, identified by the connection it
+//               is reached through, with no interest in any zone.
+//               The client_id is for the caller's own bookkeeping
+//               (ServerRepository passes the client's doIdBase).
+//               Returns true if the client is added, or false if
+//               there was already a client on this connection.
+////////////////////////////////////////////////////////////////////
+bool CZoneFanout::
+add_client(Connection *connection, unsigned int client_id) {
+  nassertr(connection != (Connection *)NULL, false);
+  LightMutexHolder holder(_lock);
+
+  pair<Clients::iterator, bool> result =
+    _clients.insert(Clients::value_type(connection, (Client *)NULL));
+  if (!result.second) {
+    return false;
+  }
+
+  Client *client = new Client;
+  client->_connection = connection;
+  client->_client_id = client_id;
+  client->_needs_flush = false;
+  (*result.first).second = client;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CZoneFanout::remove_client
+//       Access: Published
+//  Description: Removes the client on the indicated connection, along
+//               with all of its interest.  Any messages still
+//               collected on the connection are not flushed.  Returns
+//               true if the client is removed, or false if there was
+//               no such client.
+////////////////////////////////////////////////////////////////////
+bool CZoneFanout::
+remove_client(Connection *connection) {
+  LightMutexHolder holder(_lock);
+  Clients::iterator ci = _clients.find(connection);
+  if (ci == _clients.end()) {
+    return false;
+  }
+
+  Client *client = (*ci).second;
+  pset<ZONEID_TYPE>::const_iterator zi;
+  for (zi = client->_zone_ids.begin(); zi != client->_zone_ids.end(); ++zi) {
+    Zones::iterator si = _zones.find(*zi);
+    nassertd(si != _zones.end()) continue;
+    remove_subscriber((*si).second, client);
+    if ((*si).second.empty()) {
+      _zones.erase(si);
+    }
+  }
+
+  if (client->_needs_flush) {
+    remove_subscriber(_needs_flush, client);
+  }
+
+  _clients.erase(ci);
+  delete client;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CZoneFanout::add_interest
+//       Access: Published
+//  Description: Records that the client on the indicated connection
+//               is interested in the indicated zone, so that it will
+//               receive the messages sent to it.  Returns true if the
+//               interest is added, or false if the client is unknown
+//               or was already interested in the zone.
+////////////////////////////////////////////////////////////////////
+bool CZoneFanout::
+add_interest(Connection *connection, ZONEID_TYPE zone_id) {
+  LightMutexHolder holder(_lock);
+  Client *client = find_client(connection);
+  if (client == (Client *)NULL) {
+    return false;
+  }
+
+  if (!client->_zone_ids.insert(zone_id).second) {
+    return false;
+  }
+
+  _zones[zone_id].push_back(client);
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CZoneFanout::remove_interest
+//       Access: Published
+//  Description: Removes the client's interest in the indicated zone.
+//               Returns true if the interest is removed, or false if
+//               the client is unknown or was not interested in the
+//               zone.
+////////////////////////////////////////////////////////////////////
+bool CZoneFanout::
+remove_interest(Connection *connection, ZONEID_TYPE zone_id) {
+  LightMutexHolder holder(_lock);
+  Client *client = find_client(connection);
+  if (client == (Client *)NULL) {
+    return false;
+  }
+
+  if (client->_zone_ids.erase(zone_id) == 0) {
+    return false;
+  }
+
+  Zones::iterator si = _zones.find(zone_id);
+  nassertr(si != _zones.end(), true);
+  remove_subscriber((*si).second, client);
+  if ((*si).second.empty()) {
+    _zones.erase(si);
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CZoneFanout::has_interest
+//       Access: Published
+//  Description: Returns true if the client on the indicated
+//               connection is interested in the indicated zone.
+////////////////////////////////////////////////////////////////////
+bool CZoneFanout::
+has_interest(Connection *connection, ZONEID_TYPE zone_id) const {
+  LightMutexHolder holder(_lock);
+  Client *client = find_client(connection);
+  if (client == (Client *)NULL) {
+    return false;
+  }
+
+  return client->_zone_ids.count(zone_id) != 0;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CZoneFanout::get_num_interested
+//       Access: Published
+//  Description: Returns the number of clients interested in the
+//               indicated zone.
+////////////////////////////////////////////////////////////////////
+int CZoneFanout::
+get_num_interested(ZONEID_TYPE zone_id) const {
+  LightMutexHolder holder(_lock);
+  Zones::const_iterator si = _zones.find(zone_id);
+  if (si == _zones.end()) {
+    return 0;
+  }
+  return (*si).second.size();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CZoneFanout::send_to_zone
+//       Access: Published
+//  Description: Sends the indicated datagram to every client
+//               interested in the indicated zone, except the client
+//               on the except connection, if any.  Returns the number
+//               of clients it was sent to.
+////////////////////////////////////////////////////////////////////
+int CZoneFanout::
+send_to_zone(ZONEID_TYPE zone_id, const Datagram &datagram,
+             Connection *except) {
+  LightMutexHolder holder(_lock);
+  Zones::const_iterator si = _zones.find(zone_id);
+  if (si == _zones.end()) {
+    return 0;
+  }
+  return send_to_subscribers((*si).second, datagram, except);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CZoneFanout::send_to_all
+//       Access: Published
+//  Description: Sends the indicated datagram to every client, whether
+//               or not it has any interest, except the client on the
+//               except connection, if any.  Returns the number of
+//               clients it was sent to.
+////////////////////////////////////////////////////////////////////
+int CZoneFanout::
+send_to_all(const Datagram &datagram, Connection *except) {
+  LightMutexHolder holder(_lock);
+  Subscribers subscribers;
+  subscribers.reserve(_clients.size());
+  Clients::const_iterator ci;
+  for (ci = _clients.begin(); ci != _clients.end(); ++ci) {
+    subscribers.push_back((*ci).second);
+  }
+  return send_to_subscribers(subscribers, datagram, except);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CZoneFanout::send_update_field
+//       Access: Published
+//  Description: Builds an OBJECT_UPDATE_FIELD_CMU message, with the
+//               indicated sender, doId and field, whose arguments are
+//               the remaining data in the iterator, and sends it to
+//               every client interested in the indicated zone (except
+//               the client on the except connection).  The iterator
+//               is not advanced.
+//
+//               This is the same message that
+//               ServerRepository.handleClientObjectUpdateField()
+//               relays, but the message is built only once, in C++,
+//               for all of the recipients.  Returns the number of
+//               clients it was sent to.
+////////////////////////////////////////////////////////////////////
+int CZoneFanout::
+send_update_field(ZONEID_TYPE zone_id, unsigned int sender_id,
+                  DOID_TYPE do_id, int field_id,
+                  const DatagramIterator &args, Connection *except) {
+  LightMutexHolder holder(_lock);
+  Zones::const_iterator si = _zones.find(zone_id);
+  if (si == _zones.end()) {
+    return 0;
+  }
+
+  const Datagram &source = args.get_datagram();
+  size_t index = args.get_current_index();
+  nassertr(index <= source.get_length(), 0);
+
+  Datagram datagram;
+  add_update_field_header(datagram, sender_id, do_id, field_id);
+  datagram.append_data((const char *)source.get_data() + index,
+                       source.get_length() - index);
+  return send_to_subscribers((*si).second, datagram, except);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CZoneFanout::send_update_field
+//       Access: Published
+//  Description: Builds an OBJECT_UPDATE_FIELD_CMU message, with the
+//               indicated sender, doId and field, whose arguments are
+//               the data packed so far by the DCPacker, and sends it
+//               to every client interested in the indicated zone
+//               (except the client on the except connection).
+//               Returns the number of clients it was sent to.
+////////////////////////////////////////////////////////////////////
+int CZoneFanout::
+send_update_field(ZONEID_TYPE zone_id, unsigned int sender_id,
+                  DOID_TYPE do_id, int field_id,
+                  const DCPacker &packer, Connection *except) {
+  LightMutexHolder holder(_lock);
+  Zones::const_iterator si = _zones.find(zone_id);
+  if (si == _zones.end()) {
+    return 0;
+  }
+
+  Datagram datagram;
+  add_update_field_header(datagram, sender_id, do_id, field_id);
+  datagram.append_data(packer.get_data(), packer.get_length());
+  return send_to_subscribers((*si).second, datagram, except);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CZoneFanout::flush
+//       Access: Published
+//  Description: Flushes the connection of each client that has been
+//               sent a message since the last call to flush().  This
+//               is only necessary if collect-tcp is in effect.
+////////////////////////////////////////////////////////////////////
+void CZoneFanout::
+flush() {
+  // We don't hold the lock while we flush, since that may block;
+  // holding a reference to each connection keeps it valid even if
+  // its client is removed in the meantime.
+  pvector< PT(Connection) > connections;
+  {
+    LightMutexHolder holder(_lock);
+    connections.reserve(_needs_flush.size());
+    Subscribers::const_iterator ci;
+    for (ci = _needs_flush.begin(); ci != _needs_flush.end(); ++ci) {
+      Client *client = (*ci);
+      client->_needs_flush = false;
+      connections.push_back(client->_connection);
+    }
+    _needs_flush.clear();
+  }
+
+  pvector< PT(Connection) >::const_iterator ci;
+  for (ci = connections.begin(); ci != connections.end(); ++ci) {
+    (*ci)->flush();
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CZoneFanout::add_update_field_header
+//       Access: Private
+//  Description: Adds the header of an OBJECT_UPDATE_FIELD_CMU message
+//               to the datagram, up to the field's arguments.
+////////////////////////////////////////////////////////////////////
+void CZoneFanout::
+add_update_field_header(Datagram &datagram, unsigned int sender_id,
+                        DOID_TYPE do_id, int field_id) {
+  datagram.add_uint16(OBJECT_UPDATE_FIELD_CMU);
+  datagram.add_uint32(sender_id);
+  datagram.add_uint32(do_id);
+  datagram.add_uint16(field_id);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CZoneFanout::send_to_subscribers
+//       Access: Private
+//  Description: Sends the datagram to each of the indicated clients
+//               but the one on the except connection.  Returns the
+//               number of clients it was sent to.
+////////////////////////////////////////////////////////////////////
+int CZoneFanout::
+send_to_subscribers(const Subscribers &subscribers, const Datagram &datagram,
+                    Connection *except) {
+  int num_sent = 0;
+  Subscribers::const_iterator ci;
+  for (ci = subscribers.begin(); ci != subscribers.end(); ++ci) {
+    Client *client = (*ci);
+    if (client->_connection == except) {
+      continue;
+    }
+
+    if (!_writer->send(datagram, client->_connection)) {
+      distributed_cat.warning()
+        << "Unable to send datagram to client " << client->_client_id
+        << "\n";
+      continue;
+    }
+
+    ++num_sent;
+    if (!client->_needs_flush) {
+      client->_needs_flush = true;
+      _needs_flush.push_back(client);
+    }
+  }
+
+  _num_datagrams_sent += num_sent;
+  return num_sent;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CZoneFanout::find_client
+//       Access: Private
+//  Description: Returns the client on the indicated connection, or
+//               NULL if there is no such client.
+////////////////////////////////////////////////////////////////////
+CZoneFanout::Client *CZoneFanout::
+find_client(Connection *connection) const {
+  Clients::const_iterator ci = _clients.find(connection);
+  if (ci == _clients.end()) {
+    return NULL;
+  }
+  return (*ci).second;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CZoneFanout::remove_subscriber
+//       Access: Private, Static
+//  Description: Removes the indicated client from the list, which
+//               does not preserve the order of the remaining clients.
+////////////////////////////////////////////////////////////////////
+void CZoneFanout::
+remove_subscriber(Subscribers &subscribers, Client *client) {
+  Subscribers::iterator ci;
+  for (ci = subscribers.begin(); ci != subscribers.end(); ++ci) {
+    if ((*ci) == client) {
+      (*ci) = subscribers.back();
+      subscribers.pop_back();
+      return;
+    }
+  }
+  nassertv(false);
+}
+
+#endif  // HAVE_NET
@@ -0,0 +1,131 @@
+// Filename: cZoneFanout.h
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef CZONEFANOUT_H
+#define CZONEFANOUT_H
+
+#include "directbase.h"
+#include "dcbase.h"
+
+#ifdef HAVE_NET
+
+#include "connectionWriter.h"
+#include "connection.h"
+#include "datagram.h"
+#include "datagramIterator.h"
+#include "pointerTo.h"
+#include "pvector.h"
+#include "pmap.h"
+#include "pset.h"
+#include "lightMutex.h"
+
+class DCPacker;
+
+////////////////////////////////////////////////////////////////////
+//       Class : CZoneFanout
+// Description : This class implements the C++ side of the zone
+//               broadcasting done by ServerRepository.  It keeps an
+//               index from each zone to the connections of the
+//               clients that have interest in it, so that a message
+//               for a zone (typically a field update from one of the
+//               objects in it) can be sent to all of them in one
+//               call, rather than in a loop in Python.
+//
+//               Clients are identified by their connection, and must
+//               be added with add_client() before interest can be
+//               opened for them; each zone's interest is then
+//               maintained with add_interest() and remove_interest().
+//
+//               Messages are sent through the indicated
+//               ConnectionWriter, which must persist for the lifetime
+//               of this object.  If collect-tcp is in effect, call
+//               flush() periodically to send them; this may be done
+//               from a different thread, as ServerRepository's
+//               flushTask may be.
+////////////////////////////////////////////////////////////////////
+class EXPCL_DIRECT CZoneFanout {
+PUBLISHED:
+  CZoneFanout(ConnectionWriter *writer);
+  ~CZoneFanout();
+
+  bool add_client(Connection *connection, unsigned int client_id);
+  bool remove_client(Connection *connection);
+  INLINE int get_num_clients() const;
+
+  bool add_interest(Connection *connection, ZONEID_TYPE zone_id);
+  bool remove_interest(Connection *connection, ZONEID_TYPE zone_id);
+  bool has_interest(Connection *connection, ZONEID_TYPE zone_id) const;
+  int get_num_interested(ZONEID_TYPE zone_id) const;
+
+  int send_to_zone(ZONEID_TYPE zone_id, const Datagram &datagram,
+                   Connection *except = NULL);
+  int send_to_all(const Datagram &datagram, Connection *except = NULL);
+
+  int send_update_field(ZONEID_TYPE zone_id, unsigned int sender_id,
+                        DOID_TYPE do_id, int field_id,
+                        const DatagramIterator &args,
+                        Connection *except = NULL);
+  int send_update_field(ZONEID_TYPE zone_id, unsigned int sender_id,
+                        DOID_TYPE do_id, int field_id,
+                        const DCPacker &packer,
+                        Connection *except = NULL);
+
+  void flush();
+
+  INLINE int get_num_datagrams_sent() const;
+
+private:
+  CZoneFanout(const CZoneFanout &copy);
+  void operator = (const CZoneFanout &copy);
+
+  class Client;
+  typedef pvector<Client *> Subscribers;
+
+  void add_update_field_header(Datagram &datagram, unsigned int sender_id,
+                               DOID_TYPE do_id, int field_id);
+  int send_to_subscribers(const Subscribers &subscribers,
+                          const Datagram &datagram, Connection *except);
+  Client *find_client(Connection *connection) const;
+  static void remove_subscriber(Subscribers &subscribers, Client *client);
+
+  class Client {
+  public:
+    PT(Connection) _connection;
+    unsigned int _client_id;
+    pset<ZONEID_TYPE> _zone_ids;
+    bool _needs_flush;
+  };
+
+  ConnectionWriter *_writer;
+
+  typedef pmap<Connection *, Client *> Clients;
+  Clients _clients;
+
+  // The clients with interest in each zone, in no particular order.
+  typedef pmap<ZONEID_TYPE, Subscribers> Zones;
+  Zones _zones;
+
+  // The clients that have been sent something since the last flush().
+  Subscribers _needs_flush;
+
+  int _num_datagrams_sent;
+
+  mutable LightMutex _lock;
+};
+
+#include "cZoneFanout.I"
+
+#endif  // HAVE_NET
+
+#endif  // CZONEFANOUT_H
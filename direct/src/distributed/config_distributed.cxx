@@ -47,6 +47,19 @@ ConfigVariableBool handle_datagrams_internally
           "for performance reasons.  When it is false, all datagrams "
           "are handled by the Python implementation."));
 
+ConfigVariableBool want_bundle_compression
+("want-bundle-compression", false,
+ PRC_DESC("Set this true to allow the cConnectionRepository to send "
+          "message bundles compressed, once the other end of the "
+          "connection has agreed to accept them; see "
+          "CConnectionRepository::request_bundle_compression()."));
+
+ConfigVariableInt bundle_compression_level
+("bundle-compression-level", 1,
+ PRC_DESC("Specifies the zlib compression level to use when compressing "
+          "message bundles, from 1 (fastest) to 9 (smallest), or 0 to send "
+          "only the differences between field updates, without zlib."));
+
 ////////////////////////////////////////////////////////////////////
 //     Function: init_libdistributed
 //  Description: Initializes the library.  This must be called at
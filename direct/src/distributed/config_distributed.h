@@ -28,6 +28,8 @@ extern ConfigVariableInt game_server_timeout_ms;
 extern ConfigVariableDouble min_lag;
 extern ConfigVariableDouble max_lag;
 extern ConfigVariableBool handle_datagrams_internally;
+extern ConfigVariableBool want_bundle_compression;
+extern ConfigVariableInt bundle_compression_level;
 
 extern EXPCL_DIRECT void init_libdistributed();
 
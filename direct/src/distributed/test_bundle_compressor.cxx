@@ -0,0 +1,309 @@
+// Filename: test_bundle_compressor.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "directbase.h"
+#include "cBundleCompressor.h"
+#include "dcmsgtypes.h"
+#include "datagram.h"
+#include "datagramIterator.h"
+#include "testCheck.h"
+
+#include <sstream>
+
+// This program packs a series of message bundles with one
+// CBundleCompressor and unpacks them with another, as the two ends of
+// a connection would, and checks that each bundle comes out as it
+// went in.  The bundles mix field updates that repeat from one bundle
+// to the next (sent as differences), updates that change length, and
+// other messages, and are packed with and without zlib.  It also
+// checks that a damaged bundle is rejected, and that updates are
+// still sent as differences once more fields have been seen than the
+// history can hold.
+
+static TestCheck check;
+
+////////////////////////////////////////////////////////////////////
+//     Function: make_update
+//  Description: Returns a STATESERVER_OBJECT_UPDATE_FIELD message, in
+//               the server format, for the indicated field of the
+//               object, with num_args arguments that change from
+//               frame to frame.
+////////////////////////////////////////////////////////////////////
+static string
+make_update(DOID_TYPE do_id, int field_id, int frame, int num_args) {
+  Datagram dg;
+  dg.add_int8(1);
+  dg.add_uint64(4000 + do_id % 10);
+  dg.add_uint64(do_id);
+  dg.add_uint16(STATESERVER_OBJECT_UPDATE_FIELD);
+  dg.add_uint32(do_id);
+  dg.add_uint16(field_id);
+  for (int a = 0; a < num_args; ++a) {
+    // Most arguments change slowly, so that consecutive updates share
+    // most of their bytes.
+    dg.add_int16((PN_int16)((a == 0) ? frame * 7 : (frame / 8) * a));
+  }
+  return dg.get_message();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: make_other
+//  Description: Returns a message that is not a field update.
+////////////////////////////////////////////////////////////////////
+static string
+make_other(int frame) {
+  Datagram dg;
+  dg.add_int8(1);
+  dg.add_uint64(4000);
+  dg.add_uint64(1);
+  dg.add_uint16(STATESERVER_OBJECT_GENERATE_WITH_REQUIRED);
+  dg.add_uint32(frame);
+  return dg.get_message();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: round_trip
+//  Description: Packs the messages with the packer and unpacks them
+//               with the unpacker, and checks that they match.
+//               Returns the packed bundle.
+////////////////////////////////////////////////////////////////////
+static Datagram
+round_trip(CBundleCompressor &packer, CBundleCompressor &unpacker,
+           CHANNEL_TYPE channel, const CBundleCompressor::Messages &messages,
+           int level, const string &description) {
+  Datagram dg;
+  packer.pack_bundle(dg, channel, messages, level);
+
+  DatagramIterator di(dg);
+  bool ok = unpacker.unpack_bundle(channel, di);
+  check(ok, description + ": unpacked");
+  if (!ok) {
+    return dg;
+  }
+  check(di.get_remaining_size() == 0, description + ": whole bundle read");
+  check(unpacker.get_num_messages() == (int)messages.size(),
+        description + ": number of messages");
+  check(unpacker.get_messages() == messages, description + ": messages");
+  if (unpacker.get_num_messages() > 0) {
+    check(unpacker.get_message(0).get_message() == messages[0],
+          description + ": get_message()");
+  }
+  return dg;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: run_series
+//  Description: Sends a series of bundles at the indicated zlib
+//               level, and returns the total number of bytes packed.
+////////////////////////////////////////////////////////////////////
+static size_t
+run_series(int level, bool &any_deflated) {
+  CBundleCompressor packer, unpacker;
+  size_t total = 0;
+
+  for (int frame = 0; frame < 50; ++frame) {
+    CBundleCompressor::Messages messages;
+    for (DOID_TYPE do_id = 1000; do_id < 1000 + (frame % 5) * 4; ++do_id) {
+      messages.push_back(make_update(do_id, 170, frame, 6));
+      if (frame % 3 == 0) {
+        // This field changes length, so it can't always be a delta.
+        messages.push_back(make_update(do_id, 171, frame, 1 + frame % 4));
+      }
+    }
+    if (frame % 4 == 0) {
+      messages.push_back(make_other(frame));
+    }
+
+    // Two channels, which have separate histories.
+    for (CHANNEL_TYPE channel = 4000; channel < 4002; ++channel) {
+      ostringstream strm;
+      strm << "level " << level << ", frame " << frame
+           << ", channel " << channel;
+      Datagram dg = round_trip(packer, unpacker, channel, messages, level,
+                               strm.str());
+      total += dg.get_length();
+      if (dg.get_length() > 0 &&
+          (((const unsigned char *)dg.get_data())[0] & 0x01) != 0) {
+        any_deflated = true;
+      }
+    }
+  }
+
+  // After both ends are cleared, packing starts over.
+  packer.clear();
+  unpacker.clear();
+  CBundleCompressor::Messages messages;
+  messages.push_back(make_update(1000, 170, 99, 6));
+  round_trip(packer, unpacker, 4000, messages, level, "after clear()");
+
+  // An empty bundle is allowed.
+  round_trip(packer, unpacker, 4000, CBundleCompressor::Messages(), level,
+             "empty bundle");
+
+  return total;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: check_damaged
+//  Description: Checks that a bundle that has been truncated, or
+//               that refers to history the unpacker doesn't have, is
+//               rejected.
+////////////////////////////////////////////////////////////////////
+static void
+check_damaged(int level) {
+  ostringstream strm;
+  strm << "level " << level;
+  string description = strm.str();
+
+  CBundleCompressor packer;
+  CBundleCompressor::Messages messages;
+  for (DOID_TYPE do_id = 1000; do_id < 1020; ++do_id) {
+    messages.push_back(make_update(do_id, 170, 0, 6));
+  }
+  Datagram first;
+  packer.pack_bundle(first, 4000, messages, level);
+
+  for (size_t length = 0; length < first.get_length(); length += 7) {
+    CBundleCompressor unpacker;
+    Datagram truncated(first.get_data(), length);
+    DatagramIterator di(truncated);
+    ostringstream strm;
+    strm << description << ": bundle truncated to " << length << " bytes";
+    check(!unpacker.unpack_bundle(4000, di), strm.str() + " rejected");
+  }
+
+  // The second bundle is all deltas against the first, so an unpacker
+  // that missed the first can't follow it.
+  messages.clear();
+  for (DOID_TYPE do_id = 1000; do_id < 1020; ++do_id) {
+    messages.push_back(make_update(do_id, 170, 1, 6));
+  }
+  Datagram second;
+  packer.pack_bundle(second, 4000, messages, level);
+  CBundleCompressor unpacker;
+  DatagramIterator di(second);
+  check(!unpacker.unpack_bundle(4000, di),
+        description + ": bundle without its history rejected");
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: get_message_kind
+//  Description: Returns the kind of the first message in a bundle
+//               packed without zlib: 0 for a whole message, 1 for a
+//               difference.
+////////////////////////////////////////////////////////////////////
+static int
+get_message_kind(const Datagram &dg) {
+  if (dg.get_length() < 4) {
+    return -1;
+  }
+  return ((const unsigned char *)dg.get_data())[3];
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: check_history_full
+//  Description: Sends updates to more distinct fields than the
+//               history can hold, and checks that the bundles still
+//               unpack, that recently updated fields are still sent
+//               as differences, and that the fields pushed out of the
+//               history are sent whole again.
+////////////////////////////////////////////////////////////////////
+static void
+check_history_full() {
+  static const int num_fields = 0x10000 + 5000;
+  static const int bundle_size = 4096;
+  static const DOID_TYPE first_do_id = 100000;
+  static const DOID_TYPE busy_do_id = 1;
+
+  CBundleCompressor packer, unpacker;
+  int frame = 0;
+  for (int begin = 0; begin < num_fields; begin += bundle_size) {
+    // One object is updated in every bundle, so it should never be
+    // pushed out.
+    CBundleCompressor::Messages messages;
+    messages.push_back(make_update(busy_do_id, 170, frame, 6));
+    int end = min(begin + bundle_size, num_fields);
+    for (int i = begin; i < end; ++i) {
+      messages.push_back(make_update(first_do_id + i, 170, frame, 6));
+    }
+
+    ostringstream strm;
+    strm << "history full, fields " << begin << " to " << end;
+    round_trip(packer, unpacker, 4000, messages, 0, strm.str());
+    ++frame;
+  }
+
+  CBundleCompressor::Messages messages;
+  messages.push_back(make_update(busy_do_id, 170, frame, 6));
+  Datagram dg = round_trip(packer, unpacker, 4000, messages, 0,
+                           "history full, busy field");
+  check(get_message_kind(dg) == 1,
+        "history full: busy field sent as a difference");
+
+  messages.clear();
+  messages.push_back(make_update(first_do_id + num_fields - 1, 170, frame, 6));
+  dg = round_trip(packer, unpacker, 4000, messages, 0,
+                  "history full, newest field");
+  check(get_message_kind(dg) == 1,
+        "history full: newest field sent as a difference");
+
+  // The first fields were pushed out to make room for the last ones.
+  messages.clear();
+  messages.push_back(make_update(first_do_id, 170, frame, 6));
+  dg = round_trip(packer, unpacker, 4000, messages, 0,
+                  "history full, oldest field");
+  check(get_message_kind(dg) == 0,
+        "history full: oldest field sent whole");
+
+  // But having been sent again, it is remembered again.
+  messages.clear();
+  messages.push_back(make_update(first_do_id, 170, frame + 1, 6));
+  dg = round_trip(packer, unpacker, 4000, messages, 0,
+                  "history full, oldest field again");
+  check(get_message_kind(dg) == 1,
+        "history full: oldest field sent again as a difference");
+
+  // A mixed bundle after all that still comes through intact.
+  messages.clear();
+  for (int i = 0; i < 200; ++i) {
+    messages.push_back(make_update(first_do_id + i * 331 % num_fields, 170,
+                                   frame + 2, 6));
+  }
+  messages.push_back(make_update(busy_do_id, 170, frame + 2, 6));
+  round_trip(packer, unpacker, 4000, messages, 0, "history full, mixed");
+}
+
+int
+main(int argc, char *argv[]) {
+  bool deflated_at_0 = false;
+  size_t size_0 = run_series(0, deflated_at_0);
+  check(!deflated_at_0, "level 0 never deflates");
+  check_damaged(0);
+  check_history_full();
+
+#ifdef HAVE_ZLIB
+  bool deflated_at_1 = false;
+  size_t size_1 = run_series(1, deflated_at_1);
+  check(deflated_at_1, "level 1 deflates some bundles");
+  check(size_1 < size_0, "level 1 is smaller than level 0");
+  check_damaged(1);
+
+  bool deflated_at_9 = false;
+  run_series(9, deflated_at_9);
+  check(deflated_at_9, "level 9 deflates some bundles");
+  check_damaged(9);
+#endif  // HAVE_ZLIB
+
+  return check.report();
+}
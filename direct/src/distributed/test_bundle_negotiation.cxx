@@ -0,0 +1,294 @@
+// Filename: test_bundle_negotiation.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "directbase.h"
+#include "cConnectionRepository.h"
+#include "cBundleCompressor.h"
+#include "dcmsgtypes.h"
+#include "queuedConnectionManager.h"
+#include "queuedConnectionListener.h"
+#include "queuedConnectionReader.h"
+#include "connectionWriter.h"
+#include "netDatagram.h"
+#include "urlSpec.h"
+#include "trueClock.h"
+#include "testCheck.h"
+
+#include <sstream>
+
+// This program connects a CConnectionRepository to a server on the
+// loopback interface, and plays the part of the server at the other
+// end of the connection.  It checks that the repository asks for
+// compressed message bundles and starts sending them once the server
+// agrees, and that, asked in turn by the server, it agrees and
+// unpacks the compressed bundles it is sent, passing them up as
+// ordinary bundles.  It also checks that a damaged bundle closes the
+// connection.
+
+static TestCheck check;
+
+static const CHANNEL_TYPE client_channel = 77;
+static const CHANNEL_TYPE server_channel = 88;
+
+////////////////////////////////////////////////////////////////////
+//     Function: make_update
+//  Description: Returns a STATESERVER_OBJECT_UPDATE_FIELD message, in
+//               the server format, for the indicated object.
+////////////////////////////////////////////////////////////////////
+static string
+make_update(DOID_TYPE do_id, CHANNEL_TYPE sender, int frame) {
+  Datagram dg;
+  dg.add_int8(1);
+  dg.add_uint64(do_id);
+  dg.add_uint64(sender);
+  dg.add_uint16(STATESERVER_OBJECT_UPDATE_FIELD);
+  dg.add_uint32(do_id);
+  dg.add_uint16(170);
+  for (int a = 0; a < 6; ++a) {
+    dg.add_int16((PN_int16)(frame * a));
+  }
+  return dg.get_message();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: make_control
+//  Description: Returns one of the bundle compression messages, which
+//               are addressed to no channel.
+////////////////////////////////////////////////////////////////////
+static Datagram
+make_control(int msg_type) {
+  Datagram dg;
+  dg.add_int8(0);
+  dg.add_uint64(0);
+  dg.add_uint16(msg_type);
+  dg.add_uint8(1);
+  return dg;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: server_receive
+//  Description: Waits a few seconds for the server end to receive a
+//               datagram.  Returns true if it did.
+////////////////////////////////////////////////////////////////////
+static bool
+server_receive(QueuedConnectionReader &reader, NetDatagram &dg) {
+  TrueClock *clock = TrueClock::get_global_ptr();
+  double stop = clock->get_short_time() + 5.0;
+  while (clock->get_short_time() < stop) {
+    if (reader.data_available() && reader.get_data(dg)) {
+      return true;
+    }
+    Thread::sleep(0.005);
+  }
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: client_receive
+//  Description: Polls the repository for a while, and returns true as
+//               soon as it passes up a datagram, or false if it
+//               passes up none.
+////////////////////////////////////////////////////////////////////
+static bool
+client_receive(CConnectionRepository &repository, double wait) {
+  TrueClock *clock = TrueClock::get_global_ptr();
+  double stop = clock->get_short_time() + wait;
+  while (clock->get_short_time() < stop) {
+    if (repository.check_datagram()) {
+      return true;
+    }
+    Thread::sleep(0.005);
+  }
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: check_sending
+//  Description: Checks that the repository asks to compress its
+//               bundles, and does so once the server agrees.
+////////////////////////////////////////////////////////////////////
+static void
+check_sending(CConnectionRepository &repository, QueuedConnectionReader &reader,
+              ConnectionWriter &writer, Connection *connection) {
+  check(repository.request_bundle_compression(), "request sent");
+
+  NetDatagram dg;
+  if (!check(server_receive(reader, dg), "server received request")) {
+    return;
+  }
+  DatagramIterator di(dg);
+  check(di.get_uint8() == 0, "request addressed to no channel");
+  di.get_uint64();
+  check(di.get_uint16() == STATESERVER_REQUEST_BUNDLE_COMPRESSION,
+        "request message type");
+  check(di.get_uint8() == 1, "request version");
+
+  // Until the server answers, bundles go out uncompressed.
+  check(!repository.is_compressing_bundles(), "not compressing before accept");
+  writer.send(make_control(STATESERVER_ACCEPT_BUNDLE_COMPRESSION), connection);
+  check(!client_receive(repository, 0.5), "accept not passed up");
+  check(repository.is_compressing_bundles(), "compressing after accept");
+
+  CBundleCompressor unpacker;
+  for (int frame = 0; frame < 3; ++frame) {
+    ostringstream strm;
+    strm << "sent bundle " << frame;
+    string description = strm.str();
+
+    CBundleCompressor::Messages messages;
+    repository.start_message_bundle();
+    for (DOID_TYPE do_id = 1000; do_id < 1005; ++do_id) {
+      messages.push_back(make_update(do_id, client_channel, frame));
+      repository.bundle_msg(Datagram(messages.back()));
+    }
+    repository.send_message_bundle(4000, client_channel);
+
+    if (!check(server_receive(reader, dg), description + ": received")) {
+      return;
+    }
+    DatagramIterator di(dg);
+    di.get_uint8();
+    CHANNEL_TYPE channel = di.get_uint64();
+    di.get_uint64();
+    check(di.get_uint16() == STATESERVER_BOUNCE_MESSAGE_COMPRESSED,
+          description + ": compressed");
+    check(unpacker.unpack_bundle(channel, di) &&
+          unpacker.get_messages() == messages,
+          description + ": messages");
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: check_receiving
+//  Description: Checks that the repository agrees to receive
+//               compressed bundles, and unpacks them.
+////////////////////////////////////////////////////////////////////
+static void
+check_receiving(CConnectionRepository &repository, QueuedConnectionReader &reader,
+                ConnectionWriter &writer, Connection *connection) {
+  writer.send(make_control(STATESERVER_REQUEST_BUNDLE_COMPRESSION), connection);
+  check(!client_receive(repository, 0.5), "request not passed up");
+
+  NetDatagram dg;
+  if (!check(server_receive(reader, dg), "server received accept")) {
+    return;
+  }
+  DatagramIterator di(dg);
+  check(di.get_uint8() == 0, "accept addressed to no channel");
+  di.get_uint64();
+  check(di.get_uint16() == STATESERVER_ACCEPT_BUNDLE_COMPRESSION,
+        "accept message type");
+
+  CBundleCompressor packer;
+  for (int frame = 0; frame < 3; ++frame) {
+    ostringstream strm;
+    strm << "received bundle " << frame;
+    string description = strm.str();
+
+    CBundleCompressor::Messages messages;
+    for (DOID_TYPE do_id = 2000; do_id < 2005; ++do_id) {
+      messages.push_back(make_update(do_id, server_channel, frame));
+    }
+    Datagram bundle;
+    bundle.add_int8(1);
+    bundle.add_uint64(5000);
+    bundle.add_uint64(server_channel);
+    bundle.add_uint16(STATESERVER_BOUNCE_MESSAGE_COMPRESSED);
+    packer.pack_bundle(bundle, 5000, messages, frame % 2);
+    writer.send(bundle, connection);
+
+    if (!check(client_receive(repository, 5.0), description + ": passed up")) {
+      return;
+    }
+    check(repository.get_msg_type() == STATESERVER_BOUNCE_MESSAGE,
+          description + ": passed up uncompressed");
+    check(repository.get_msg_channel_count() == 1 &&
+          repository.get_msg_channel(0) == 5000 &&
+          repository.get_msg_sender() == server_channel,
+          description + ": header");
+
+    DatagramIterator di;
+    repository.get_datagram_iterator(di);
+    CBundleCompressor::Messages received;
+    while (di.get_remaining_size() > 0) {
+      received.push_back(di.get_string());
+    }
+    check(received == messages, description + ": messages");
+  }
+
+  // A delta against a field the repository has never seen can't be
+  // unpacked, so it must drop the connection.
+  Datagram bundle;
+  bundle.add_int8(1);
+  bundle.add_uint64(5000);
+  bundle.add_uint64(server_channel);
+  bundle.add_uint16(STATESERVER_BOUNCE_MESSAGE_COMPRESSED);
+  bundle.add_uint8(0);
+  bundle.add_uint16(1);
+  bundle.add_uint8(1);
+  bundle.add_uint16(999);
+  writer.send(bundle, connection);
+  check(!client_receive(repository, 0.5), "damaged bundle not passed up");
+  check(!repository.is_connected(), "damaged bundle closes connection");
+}
+
+int
+main(int argc, char *argv[]) {
+  QueuedConnectionManager manager;
+  QueuedConnectionListener listener(&manager, 0);
+  QueuedConnectionReader reader(&manager, 0);
+  ConnectionWriter writer(&manager, 0);
+
+  // Find a free port to listen on.
+  PT(Connection) rendezvous;
+  int port;
+  for (port = 47311; port < 47341 && rendezvous == (Connection *)NULL; ++port) {
+    rendezvous = manager.open_TCP_server_rendezvous(port, 5);
+  }
+  if (!check(rendezvous != (Connection *)NULL, "open server")) {
+    return check.report();
+  }
+  listener.add_connection(rendezvous);
+
+  ostringstream url;
+  url << "http://127.0.0.1:" << port - 1;
+
+  CConnectionRepository repository;
+  repository.set_client_datagram(false);
+  repository.set_want_bundle_compression(true);
+  if (!check(repository.try_connect_net(URLSpec(url.str())), "connect")) {
+    return check.report();
+  }
+
+  PT(Connection) connection;
+  TrueClock *clock = TrueClock::get_global_ptr();
+  double stop = clock->get_short_time() + 5.0;
+  while (connection == (Connection *)NULL && clock->get_short_time() < stop) {
+    if (listener.new_connection_available()) {
+      NetAddress address;
+      listener.get_new_connection(rendezvous, address, connection);
+    } else {
+      Thread::sleep(0.005);
+    }
+  }
+  if (!check(connection != (Connection *)NULL, "accept connection")) {
+    return check.report();
+  }
+  reader.add_connection(connection);
+
+  check_sending(repository, reader, writer, connection);
+  check_receiving(repository, reader, writer, connection);
+
+  return check.report();
+}
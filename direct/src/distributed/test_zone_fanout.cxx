@@ -0,0 +1,228 @@
+// Filename: test_zone_fanout.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "directbase.h"
+#include "cZoneFanout.h"
+#include "dcFile.h"
+#include "dcClass.h"
+#include "dcField.h"
+#include "dcPacker.h"
+#include "dcmsgtypes.h"
+
+#include "queuedConnectionManager.h"
+#include "queuedConnectionListener.h"
+#include "queuedConnectionReader.h"
+#include "connectionWriter.h"
+#include "netAddress.h"
+#include "connection.h"
+#include "netDatagram.h"
+#include "datagramIterator.h"
+#include "trueClock.h"
+#include "thread.h"
+#include "pvector.h"
+#include "pmap.h"
+
+#include <sstream>
+
+// This program measures CZoneFanout relaying field updates among many
+// TCP clients, all in the same process, much as ServerRepository
+// relays a broadcast field update to the other clients in the
+// object's zone.  Client i has interest in zones i % zones and
+// (i + 1) % zones, and each update is sent by one client to the
+// other clients in its own zone.  The fan-out is timed separately
+// from reading the updates back, which verifies that each was
+// delivered to exactly the clients that should have it.
+//
+// Usage: test_zone_fanout port [clients [zones [updates]]]
+
+static const char *dc_text =
+  "dclass Avatar {\n"
+  "  setPosHpr(int16 / 10, int16 / 10, int16 / 10, "
+  "int16 % 360 / 10, int16 % 360 / 10, int16 % 360 / 10) broadcast;\n"
+  "};\n";
+
+int
+main(int argc, char *argv[]) {
+  if (argc < 2) {
+    nout << "test_zone_fanout port [clients [zones [updates]]]\n";
+    exit(1);
+  }
+
+  int port = atoi(argv[1]);
+  int num_clients = (argc > 2) ? atoi(argv[2]) : 1000;
+  int num_zones = (argc > 3) ? atoi(argv[3]) : 50;
+  int num_updates = (argc > 4) ? atoi(argv[4]) : 10000;
+  if (num_clients < 2 || num_zones < 1) {
+    nout << "Need at least 2 clients and 1 zone.\n";
+    exit(1);
+  }
+
+  DCFile dc_file;
+  istringstream dc_in(dc_text);
+  if (!dc_file.read(dc_in, "test_zone_fanout")) {
+    exit(1);
+  }
+  DCField *field =
+    dc_file.get_class_by_name("Avatar")->get_field_by_name("setPosHpr");
+
+  QueuedConnectionManager cm;
+  PT(Connection) rendezvous = cm.open_TCP_server_rendezvous(port, 1024);
+  if (rendezvous.is_null()) {
+    nout << "Cannot grab port " << port << ".\n";
+    exit(1);
+  }
+
+  QueuedConnectionListener listener(&cm, 0);
+  listener.add_connection(rendezvous);
+  QueuedConnectionReader reader(&cm, 0);
+  ConnectionWriter writer(&cm, 0);
+  CZoneFanout fanout(&writer);
+
+  NetAddress host;
+  host.set_localhost(port);
+
+  // The client end of each connection is read here; its index is the
+  // client's id.  The server end of each connection is what
+  // CZoneFanout sends to; connections are accepted in the order they
+  // were opened, as we go, so as not to overflow the listen backlog.
+  typedef pmap<Connection *, int> ClientIndex;
+  ClientIndex client_index;
+  pvector< PT(Connection) > clients;
+  pvector< PT(Connection) > servers;
+  TrueClock *clock = TrueClock::get_global_ptr();
+  double start = clock->get_short_time();
+  while ((int)servers.size() < num_clients) {
+    if ((int)clients.size() < num_clients) {
+      PT(Connection) c = cm.open_TCP_client_connection(host, 5000);
+      if (c.is_null()) {
+        nout << "Could only open " << clients.size() << " connections.\n";
+        return 1;
+      }
+      client_index[c] = clients.size();
+      reader.add_connection(c);
+      clients.push_back(c);
+    }
+
+    PT(Connection) rv;
+    NetAddress address;
+    PT(Connection) new_connection;
+    while (listener.new_connection_available() &&
+           listener.get_new_connection(rv, address, new_connection)) {
+      int id = servers.size();
+      servers.push_back(new_connection);
+      fanout.add_client(new_connection, id);
+      fanout.add_interest(new_connection, id % num_zones);
+      fanout.add_interest(new_connection, (id + 1) % num_zones);
+    }
+    if ((int)clients.size() == num_clients) {
+      Thread::sleep(0.001);
+    }
+  }
+  double setup_time = clock->get_short_time() - start;
+
+  nout << num_clients << " clients, " << num_zones << " zones, "
+       << num_updates << " updates; " << setup_time * 1000.0
+       << " ms to connect and add interest\n";
+
+  // Each update is timed first with each datagram written as it is
+  // sent, and then with collect-tcp, in which case the datagrams for
+  // each client are written together by flush().
+  int num_failed = 0;
+  for (int collect = 0; collect < 2; ++collect) {
+    pvector< PT(Connection) >::const_iterator si;
+    for (si = servers.begin(); si != servers.end(); ++si) {
+      (*si)->set_collect_tcp(collect != 0);
+      (*si)->set_collect_tcp_interval(1.0);
+    }
+
+    // Each round sends one update from a different client to each
+    // zone, and is read back before the next, so that the socket
+    // buffers never fill up.
+    int num_expected = 0;
+    int num_sent = 0;
+    int num_received = 0;
+    int num_errors = 0;
+    double fanout_time = 0.0;
+    DCPacker packer;
+
+    int update = 0;
+    while (update < num_updates) {
+      int round_end = min(update + num_zones, num_updates);
+
+      start = clock->get_short_time();
+      for (; update < round_end; ++update) {
+        int sender = (update * 7919) % num_clients;
+        ZONEID_TYPE zone_id = sender % num_zones;
+        num_expected += fanout.get_num_interested(zone_id) - 1;
+
+        packer.begin_pack(field);
+        packer.push();
+        while (packer.more_nested_fields()) {
+          packer.pack_double((update % 1000) * 0.1);
+        }
+        packer.pop();
+        packer.end_pack();
+        num_sent += fanout.send_update_field(zone_id, sender, 1000 + sender,
+                                             field->get_number(), packer,
+                                             servers[sender]);
+        packer.clear_data();
+      }
+      fanout.flush();
+      fanout_time += clock->get_short_time() - start;
+
+      while (num_received < num_sent) {
+        if (!reader.data_available()) {
+          Thread::sleep(0.0001);
+          continue;
+        }
+        NetDatagram datagram;
+        if (!reader.get_data(datagram)) {
+          continue;
+        }
+        ++num_received;
+
+        // Each update should reach every other client in the sender's
+        // zone, and nobody else.
+        int id = client_index[datagram.get_connection()];
+        DatagramIterator scan(datagram);
+        if (datagram.get_length() != 12 + field->get_fixed_byte_size() ||
+            scan.get_uint16() != OBJECT_UPDATE_FIELD_CMU) {
+          ++num_errors;
+          continue;
+        }
+        int sender = scan.get_uint32();
+        int zone_id = sender % num_zones;
+        if (sender == id ||
+            (id % num_zones != zone_id && (id + 1) % num_zones != zone_id)) {
+          ++num_errors;
+        }
+      }
+    }
+
+    nout << (collect ? "collect-tcp: " : "immediate: ")
+         << num_sent << " datagrams sent (" << num_expected
+         << " expected), " << num_received << " received, "
+         << num_errors << " misdelivered; "
+         << fanout_time * 1000000.0 / max(num_updates, 1)
+         << " us per update, "
+         << fanout_time * 1000000000.0 / max(num_sent, 1)
+         << " ns per recipient\n";
+
+    if (num_errors != 0 || num_sent != num_expected) {
+      ++num_failed;
+    }
+  }
+
+  return (num_failed != 0) ? 1 : 0;
+}
@@ -4873,13 +4873,17 @@ if (PkgSkip("DIRECT")==0):
 #
 
 if (PkgSkip("DIRECT")==0):
-  OPTS=['DIR:direct/src/distributed', 'DIR:direct/src/dcparser', 'WITHINPANDA', 'BUILDING:DIRECT', 'OPENSSL']
+  OPTS=['DIR:direct/src/distributed', 'DIR:direct/src/dcparser', 'WITHINPANDA', 'BUILDING:DIRECT', 'OPENSSL', 'ZLIB']
   TargetAdd('p3distributed_config_distributed.obj', opts=OPTS, input='config_distributed.cxx')
+  TargetAdd('p3distributed_cBundleCompressor.obj', opts=OPTS, input='cBundleCompressor.cxx')
   TargetAdd('p3distributed_cConnectionRepository.obj', opts=OPTS, input='cConnectionRepository.cxx')
+  TargetAdd('p3distributed_cZoneFanout.obj', opts=OPTS, input='cZoneFanout.cxx')
   TargetAdd('p3distributed_cDistributedSmoothNodeBase.obj', opts=OPTS, input='cDistributedSmoothNodeBase.cxx')
 
   OPTS=['DIR:direct/src/distributed', 'WITHINPANDA', 'OPENSSL']
   IGATEFILES=GetDirectoryContents('direct/src/distributed', ["*.h", "*.cxx"])
+  IGATEFILES.remove('test_zone_fanout.cxx')
+  IGATEFILES.remove('test_bundle_compressor.cxx')
   TargetAdd('libp3distributed.in', opts=OPTS, input=IGATEFILES)
   TargetAdd('libp3distributed.in', opts=['IMOD:panda3d.direct', 'ILIB:libp3distributed', 'SRCDIR:direct/src/distributed'])
   TargetAdd('libp3distributed_igate.obj', input='libp3distributed.in', opts=["DEPENDENCYONLY"])
@@ -4934,10 +4938,12 @@ if (PkgSkip("DIRECT")==0):
   TargetAdd('libp3direct.dll', input='p3deadrec_composite1.obj')
   TargetAdd('libp3direct.dll', input='p3interval_composite1.obj')
   TargetAdd('libp3direct.dll', input='p3distributed_config_distributed.obj')
+  TargetAdd('libp3direct.dll', input='p3distributed_cBundleCompressor.obj')
   TargetAdd('libp3direct.dll', input='p3distributed_cConnectionRepository.obj')
+  TargetAdd('libp3direct.dll', input='p3distributed_cZoneFanout.obj')
   TargetAdd('libp3direct.dll', input='p3distributed_cDistributedSmoothNodeBase.obj')
   TargetAdd('libp3direct.dll', input=COMMON_PANDA_LIBS)
-  TargetAdd('libp3direct.dll', opts=['ADVAPI',  'OPENSSL', 'WINUSER', 'WINGDI'])
+  TargetAdd('libp3direct.dll', opts=['ADVAPI',  'OPENSSL', 'ZLIB', 'WINUSER', 'WINGDI'])
 
   OPTS=['DIR:direct/metalibs/direct']
   TargetAdd('direct_module.obj', input='libp3dcparser.in')
@@ -5686,6 +5692,14 @@ if (PkgSkip("PANDATOOL")==0):
   TargetAdd('image-trans.exe', input='libp3pystub.lib')
   TargetAdd('image-trans.exe', opts=['ADVAPI'])
 
+  TargetAdd('tex2ktx_texToKtx.obj', opts=OPTS, input='texToKtx.cxx')
+  TargetAdd('tex2ktx.exe', input='tex2ktx_texToKtx.obj')
+  TargetAdd('tex2ktx.exe', input='libp3progbase.lib')
+  TargetAdd('tex2ktx.exe', input='libp3pandatoolbase.lib')
+  TargetAdd('tex2ktx.exe', input=COMMON_PANDA_LIBS)
+  TargetAdd('tex2ktx.exe', input='libp3pystub.lib')
+  TargetAdd('tex2ktx.exe', opts=['ADVAPI'])
+
 #
 # DIRECTORY: pandatool/src/pfmprogs/
 #
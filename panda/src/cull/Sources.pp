@@ -44,3 +44,13 @@
   #define IGATESCAN all
 
 #end lib_target
+
+#begin test_bin_target
+  #define TARGET test_cull_sort
+  #define LOCAL_LIBS p3mathutil p3express
+  #define OTHER_LIBS $[OTHER_LIBS] p3pystub
+
+  #define SOURCES \
+    test_cull_sort.cxx
+
+#end test_bin_target
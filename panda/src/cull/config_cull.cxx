@@ -30,6 +30,15 @@ ConfigureFn(config_cull) {
   init_libcull();
 }
 
+ConfigVariableBool state_sort_cost_model
+("state-sort-cost-model", true,
+ PRC_DESC("When this is true, the state-sorted cull bins order their "
+          "objects by a key that reflects the relative cost of each "
+          "kind of state change (shader, then textures, then other "
+          "state, then transform), using a radix sort.  Set it false "
+          "to use the older comparison sort, which groups objects by "
+          "transform first."));
+
 ////////////////////////////////////////////////////////////////////
 //     Function: init_libcull
 //  Description: Initializes the library.  This must be called at
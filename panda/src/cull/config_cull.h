@@ -27,6 +27,8 @@ class DSearchPath;
 ConfigureDecl(config_cull, EXPCL_PANDA_CULL, EXPTP_PANDA_CULL);
 NotifyCategoryDecl(cull, EXPCL_PANDA_CULL, EXPTP_PANDA_CULL);
 
+extern ConfigVariableBool state_sort_cost_model;
+
 extern EXPCL_PANDA_CULL void init_libcull();
 
 #endif
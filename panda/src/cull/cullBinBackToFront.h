@@ -22,6 +22,7 @@
 #include "transformState.h"
 #include "renderState.h"
 #include "pointerTo.h"
+#include "radixSort.h"
 
 ////////////////////////////////////////////////////////////////////
 //       Class : CullBinBackToFront
@@ -54,10 +55,10 @@ private:
   class ObjectData {
   public:
     INLINE ObjectData(CullableObject *object, PN_stdfloat dist);
-    INLINE bool operator < (const ObjectData &other) const;
     
     CullableObject *_object;
     PN_stdfloat _dist;
+    PN_uint32 _sort_key;
   };
 
   typedef pvector<ObjectData> Objects;
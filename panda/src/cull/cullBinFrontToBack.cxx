@@ -87,7 +87,15 @@ add_object(CullableObject *object, Thread *current_thread) {
 void CullBinFrontToBack::
 finish_cull(SceneSetup *, Thread *current_thread) {
   PStatTimer timer(_cull_this_pcollector, current_thread);
-  sort(_objects.begin(), _objects.end());
+  if (_objects.size() < 2) {
+    return;
+  }
+
+  // The distances have already been converted to integer keys in
+  // nearest to furthest order, so we can use a linear-time radix sort.
+  Objects scratch(_objects);
+  radix_sort(&_objects[0], &_objects[0] + _objects.size(), &scratch[0],
+             &ObjectData::_sort_key);
 }
 
 ////////////////////////////////////////////////////////////////////
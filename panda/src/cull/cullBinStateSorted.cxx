@@ -17,10 +17,13 @@
 #include "cullableObject.h"
 #include "cullHandler.h"
 #include "pStatTimer.h"
+#include "config_cull.h"
+#include "shaderAttrib.h"
+#include "textureAttrib.h"
+#include "radixSort.h"
 
 #include <algorithm>
 
-
 TypeHandle CullBinStateSorted::_type_handle;
 
 ////////////////////////////////////////////////////////////////////
@@ -71,7 +74,19 @@ add_object(CullableObject *object, Thread *current_thread) {
 void CullBinStateSorted::
 finish_cull(SceneSetup *, Thread *current_thread) {
   PStatTimer timer(_cull_this_pcollector, current_thread);
-  sort(_objects.begin(), _objects.end());
+  if (_objects.size() < 2) {
+    return;
+  }
+
+  if (state_sort_cost_model) {
+    make_sort_keys();
+
+    Objects scratch(_objects);
+    radix_sort(&_objects[0], &_objects[0] + _objects.size(), &scratch[0],
+               &ObjectData::_sort_key);
+  } else {
+    sort(_objects.begin(), _objects.end());
+  }
 }
 
 
@@ -84,10 +99,88 @@ finish_cull(SceneSetup *, Thread *current_thread) {
 void CullBinStateSorted::
 draw(bool force, Thread *current_thread) {
   PStatTimer timer(_draw_this_pcollector, current_thread);
-  Objects::const_iterator oi;
+
+  if (!_gsg->get_supports_multi_draw_indirect()) {
+    Objects::const_iterator oi;
+    for (oi = _objects.begin(); oi != _objects.end(); ++oi) {
+      CullableObject *object = (*oi)._object;
+      CullHandler::draw(object, _gsg, force, current_thread);
+    }
+    return;
+  }
+
+  // The GSG can draw several Geoms at once, so hand it each run of
+  // objects that share the same state and transform.  The sort has
+  // already brought these together.
+  pvector<CullableObject *> batch;
+  Objects::const_iterator oi = _objects.begin();
+  while (oi != _objects.end()) {
+    CullableObject *object = (*oi)._object;
+    Objects::const_iterator oj = oi + 1;
+    if (object->_draw_callback == (CallbackObject *)NULL) {
+      while (oj != _objects.end() &&
+             (*oj)._object->_draw_callback == (CallbackObject *)NULL &&
+             (*oj)._object->_state == object->_state &&
+             (*oj)._object->_internal_transform == object->_internal_transform) {
+        ++oj;
+      }
+    }
+
+    if (oj - oi == 1) {
+      CullHandler::draw(object, _gsg, force, current_thread);
+    } else {
+      batch.clear();
+      for (; oi != oj; ++oi) {
+        batch.push_back((*oi)._object);
+      }
+      _gsg->draw_batch(&batch[0], (int)batch.size(), force, current_thread);
+    }
+    oi = oj;
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullBinStateSorted::make_sort_keys
+//       Access: Private
+//  Description: Computes the _sort_key for each object in the bin.
+//               The key is made of four 16-bit fields, from most to
+//               least significant: the shader, the texture set, the
+//               complete render state, and the transform.  Each
+//               field holds an index into the set of distinct values
+//               seen in this bin, which is all we need to group equal
+//               values together.
+//
+//               This is ordered by the relative cost of changing
+//               each kind of state on the GSG: a shader bind is the
+//               most expensive, followed by texture binds and other
+//               state, while a transform change is typically just a
+//               uniform update.
+////////////////////////////////////////////////////////////////////
+void CullBinStateSorted::
+make_sort_keys() {
+  KeyIndex shaders, textures, states, transforms;
+
+  Objects::iterator oi;
   for (oi = _objects.begin(); oi != _objects.end(); ++oi) {
     CullableObject *object = (*oi)._object;
-    CullHandler::draw(object, _gsg, force, current_thread);
+    const RenderState *state = object->_state;
+
+    const ShaderAttrib *sa;
+    state->get_attrib_def(sa);
+    const void *shader = sa->get_shader();
+    if (sa->auto_shader()) {
+      // The shader generator makes a different shader for each state.
+      shader = state;
+    }
+
+    const TextureAttrib *ta;
+    state->get_attrib_def(ta);
+
+    (*oi)._sort_key =
+      (get_key_index(shaders, shader) << 48) |
+      (get_key_index(textures, ta) << 32) |
+      (get_key_index(states, state) << 16) |
+      get_key_index(transforms, object->_internal_transform);
   }
 }
 
@@ -23,6 +23,7 @@
 #include "transformState.h"
 #include "renderState.h"
 #include "pointerTo.h"
+#include "simpleHashMap.h"
 
 ////////////////////////////////////////////////////////////////////
 //       Class : CullBinStateSorted
@@ -31,10 +32,16 @@
 //               minimal state changes are required on the GSG to
 //               render them.
 //
-//               This also sorts objects front-to-back within a
-//               particular state, to take advantage of hierarchical
-//               Z-buffer algorithms which can early-out when an
-//               object appears behind another one.
+//               By default, the objects are ordered by a 64-bit key
+//               that models the relative cost of the state changes
+//               on the GSG: objects are grouped first by shader, then
+//               by texture set, then by the remaining state, and
+//               finally by transform.  The keys are sorted with a
+//               linear-time radix sort.  Set state-sort-cost-model
+//               false to revert to a comparison sort that groups by
+//               transform first, as in previous versions; the
+//               "State changes" PStats collectors can be used to
+//               compare the two.
 ////////////////////////////////////////////////////////////////////
 class EXPCL_PANDA_CULL CullBinStateSorted : public CullBin {
 public:
@@ -55,17 +62,26 @@ protected:
   virtual void fill_result_graph(ResultGraphBuilder &builder);
 
 private:
+  void make_sort_keys();
+
   class ObjectData {
   public:
     INLINE ObjectData(CullableObject *object);
     INLINE bool operator < (const ObjectData &other) const;
     
     CullableObject *_object;
+    PN_uint64 _sort_key;
   };
 
   typedef pvector<ObjectData> Objects;
   Objects _objects;
 
+  // Used by make_sort_keys() to assign a small, dense index to each
+  // distinct shader, texture set, state, and transform in the bin.
+  // This is a hash map, so that the keys can be made in linear time.
+  typedef SimpleHashMap<const void *, PN_uint64, pointer_hash> KeyIndex;
+  static INLINE PN_uint64 get_key_index(KeyIndex &index, const void *pointer);
+
 public:
   static TypeHandle get_class_type() {
     return _type_handle;
@@ -0,0 +1,147 @@
+// Filename: test_cull_sort.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "pandabase.h"
+#include "radixSort.h"
+#include "trueClock.h"
+#include "pvector.h"
+#include "randomizer.h"
+
+#include <algorithm>
+
+// This program compares the sort used by the back-to-front and
+// front-to-back cull bins in previous versions (std::sort on the
+// distance) against the radix sort on integer keys that they use now,
+// for a range of bin sizes.  It also checks that both produce the
+// same order.
+
+class ObjectData {
+public:
+  PN_stdfloat _dist;
+  PN_uint32 _sort_key;
+  int _index;
+};
+
+class BackToFront {
+public:
+  bool operator () (const ObjectData &a, const ObjectData &b) const {
+    return a._dist > b._dist;
+  }
+};
+
+typedef pvector<ObjectData> Objects;
+
+static const int num_frames = 20;
+
+////////////////////////////////////////////////////////////////////
+//     Function: make_objects
+//  Description: Fills the array with the indicated number of objects
+//               at random distances from the camera.
+////////////////////////////////////////////////////////////////////
+static void
+make_objects(Objects &objects, int num_objects, Randomizer &random) {
+  objects.resize(num_objects);
+  for (int i = 0; i < num_objects; ++i) {
+    objects[i]._dist = (PN_stdfloat)random.random_real(1000.0);
+    objects[i]._sort_key = radix_sort_key_reverse((float)objects[i]._dist);
+    objects[i]._index = i;
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: time_comparison_sort
+//  Description: Returns the average time in seconds to sort a fresh
+//               copy of the objects with std::sort.
+////////////////////////////////////////////////////////////////////
+static double
+time_comparison_sort(const Objects &objects, Objects &result) {
+  TrueClock *clock = TrueClock::get_global_ptr();
+  double total = 0.0;
+  for (int f = 0; f < num_frames; ++f) {
+    result = objects;
+    double start = clock->get_short_time();
+    sort(result.begin(), result.end(), BackToFront());
+    total += clock->get_short_time() - start;
+  }
+  return total / num_frames;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: time_radix_sort
+//  Description: Returns the average time in seconds to sort a fresh
+//               copy of the objects with radix_sort(), including the
+//               allocation of the scratch buffer, as the cull bins
+//               do it.
+////////////////////////////////////////////////////////////////////
+static double
+time_radix_sort(const Objects &objects, Objects &result) {
+  TrueClock *clock = TrueClock::get_global_ptr();
+  double total = 0.0;
+  for (int f = 0; f < num_frames; ++f) {
+    result = objects;
+    double start = clock->get_short_time();
+    Objects scratch(result);
+    radix_sort(&result[0], &result[0] + result.size(), &scratch[0],
+               &ObjectData::_sort_key);
+    total += clock->get_short_time() - start;
+  }
+  return total / num_frames;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: same_order
+//  Description: Returns true if the two sorted arrays have their
+//               distances in the same order.  Objects at exactly
+//               equal distances may legitimately appear in either
+//               order, since std::sort isn't stable.
+////////////////////////////////////////////////////////////////////
+static bool
+same_order(const Objects &a, const Objects &b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (a[i]._dist != b[i]._dist) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int
+main(int argc, char *argv[]) {
+  static const int sizes[] = { 1000, 10000, 100000 };
+  static const int num_sizes = sizeof(sizes) / sizeof(sizes[0]);
+
+  Randomizer random(1);
+  bool all_ok = true;
+
+  cerr << "objects   std::sort (ms)   radix_sort (ms)   speedup\n";
+  for (int si = 0; si < num_sizes; ++si) {
+    Objects objects, comparison_result, radix_result;
+    make_objects(objects, sizes[si], random);
+
+    double comparison_time = time_comparison_sort(objects, comparison_result);
+    double radix_time = time_radix_sort(objects, radix_result);
+    bool ok = same_order(comparison_result, radix_result);
+    all_ok = all_ok && ok;
+
+    cerr << sizes[si] << "\t  " << comparison_time * 1000.0
+         << "\t\t   " << radix_time * 1000.0
+         << "\t     " << comparison_time / radix_time
+         << (ok ? "" : "   MISMATCH") << "\n";
+  }
+
+  return all_ok ? 0 : 1;
+}
@@ -57,6 +57,7 @@
 #include "clipPlaneAttrib.h"
 #include "fogAttrib.h"
 #include "config_pstats.h"
+#include "cullableObject.h"
 
 #include <algorithm>
 #include <limits.h>
@@ -85,6 +86,7 @@ PStatCollector GraphicsStateGuardian::_vertices_other_pcollector("Vertices:Other
 PStatCollector GraphicsStateGuardian::_state_pcollector("State changes");
 PStatCollector GraphicsStateGuardian::_transform_state_pcollector("State changes:Transforms");
 PStatCollector GraphicsStateGuardian::_texture_state_pcollector("State changes:Textures");
+PStatCollector GraphicsStateGuardian::_shader_state_pcollector("State changes:Shaders");
 PStatCollector GraphicsStateGuardian::_draw_primitive_pcollector("Draw:Primitive:Draw");
 PStatCollector GraphicsStateGuardian::_draw_set_state_pcollector("Draw:Set State");
 PStatCollector GraphicsStateGuardian::_clear_pcollector("Draw:Clear");
@@ -243,6 +245,7 @@ GraphicsStateGuardian(CoordinateSystem internal_coordinate_system,
   _supports_stencil_wrap = false;
   _supports_two_sided_stencil = false;
   _supports_geometry_instancing = false;
+  _supports_multi_draw_indirect = false;
 
   // Assume a maximum of 1 render target in absence of MRT.
   _max_color_targets = 1;
@@ -1896,6 +1899,7 @@ end_frame(Thread *current_thread) {
 
   _state_pcollector.flush_level();
   _texture_state_pcollector.flush_level();
+  _shader_state_pcollector.flush_level();
   _transform_state_pcollector.flush_level();
   _draw_primitive_pcollector.flush_level();
 
@@ -2138,6 +2142,23 @@ finish_decal() {
   // No need to do anything special here.
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: GraphicsStateGuardian::draw_batch
+//       Access: Public, Virtual
+//  Description: Draws a run of objects that all share the same
+//               state and transform.  The default implementation
+//               simply draws them one at a time; a GSG that can
+//               submit several Geoms with a single call may do
+//               better.
+////////////////////////////////////////////////////////////////////
+void GraphicsStateGuardian::
+draw_batch(CullableObject *const *objects, int num_objects,
+           bool force, Thread *current_thread) {
+  for (int i = 0; i < num_objects; ++i) {
+    objects[i]->draw(this, force, current_thread);
+  }
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: GraphicsStateGuardian::begin_draw_primitives()
 //       Access: Public, Virtual
@@ -2735,6 +2756,7 @@ init_frame_pstats() {
     _state_pcollector.clear_level();
     _transform_state_pcollector.clear_level();
     _texture_state_pcollector.clear_level();
+    _shader_state_pcollector.clear_level();
   }
 }
 #endif  // DO_PSTATS
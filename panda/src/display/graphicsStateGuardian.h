@@ -158,6 +158,7 @@ PUBLISHED:
   INLINE bool get_supports_stencil() const;
   INLINE bool get_supports_two_sided_stencil() const;
   INLINE bool get_supports_geometry_instancing() const;
+  INLINE bool get_supports_multi_draw_indirect() const;
 
   INLINE bool get_supports_occlusion_query() const;
   INLINE bool get_supports_timer_query() const;
@@ -287,6 +288,9 @@ public:
   virtual CPT(RenderState) begin_decal_base_second();
   virtual void finish_decal();
 
+  virtual void draw_batch(CullableObject *const *objects, int num_objects,
+                          bool force, Thread *current_thread);
+
   virtual bool begin_draw_primitives(const GeomPipelineReader *geom_reader,
                                      const GeomMunger *munger,
                                      const GeomVertexDataPipelineReader *data_reader,
@@ -535,6 +539,7 @@ protected:
   bool _supports_stencil_wrap;
   bool _supports_two_sided_stencil;
   bool _supports_geometry_instancing;
+  bool _supports_multi_draw_indirect;
 
   int _max_color_targets;
 
@@ -588,6 +593,7 @@ public:
   static PStatCollector _state_pcollector;
   static PStatCollector _transform_state_pcollector;
   static PStatCollector _texture_state_pcollector;
+  static PStatCollector _shader_state_pcollector;
   static PStatCollector _draw_primitive_pcollector;
   static PStatCollector _draw_set_state_pcollector;
   static PStatCollector _clear_pcollector;
@@ -27,6 +27,7 @@
     httpCookie.I httpCookie.h \
     httpDate.I httpDate.h \
     httpDigestAuthorization.I httpDigestAuthorization.h \
+    httpDownloadManager.I httpDownloadManager.h \
     httpEntityTag.I httpEntityTag.h \
     httpEnum.h \
     identityStream.I identityStream.h \
@@ -59,6 +60,7 @@
     httpCookie.cxx \
     httpDate.cxx \
     httpDigestAuthorization.cxx \
+    httpDownloadManager.cxx \
     httpEntityTag.cxx \
     httpEnum.cxx \
     identityStream.cxx identityStreamBuf.cxx \
@@ -89,6 +91,7 @@
     httpCookie.I httpCookie.h \
     httpDate.I httpDate.h \
     httpDigestAuthorization.I httpDigestAuthorization.h \
+    httpDownloadManager.I httpDownloadManager.h \
     httpEntityTag.I httpEntityTag.h \
     httpEnum.h \
     identityStream.I identityStream.h \
@@ -106,3 +109,13 @@
   #define IGATESCAN all
 
 #end lib_target
+
+#begin test_bin_target
+  #define TARGET test_httpDownloadManager
+  #define LOCAL_LIBS p3downloader p3nativenet p3pipeline $[LOCAL_LIBS]
+  #define OTHER_LIBS $[OTHER_LIBS] p3pystub
+
+  #define SOURCES \
+    test_httpDownloadManager.cxx
+
+#end test_bin_target
@@ -56,7 +56,14 @@ BioPtr(const URLSpec &url) {
     _server_name = url.get_server();
     _port = url.get_port();
     _bio = BIO_new_connect((char *)_server_name.c_str());
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+    // OpenSSL 1.1 takes the port only as a string.
+    ostringstream port_strm;
+    port_strm << _port;
+    BIO_set_conn_port(_bio, port_strm.str().c_str());
+#else
     BIO_set_conn_int_port(_bio, &_port);
+#endif
   }
 }
 
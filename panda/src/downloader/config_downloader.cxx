@@ -106,6 +106,34 @@ ConfigVariableInt http_max_connect_count
           "prevent the code from attempting runaway connections; this limit "
           "should never be reached in practice."));
 
+ConfigVariableInt http_download_max_channels
+("http-download-max-channels", 8,
+ PRC_DESC("This is the default number of HTTPChannels an "
+          "HTTPDownloadManager will use at once.  Each channel keeps its "
+          "own persistent connection to the server."));
+
+ConfigVariableInt http_download_chunk_size
+("http-download-chunk-size", 4194304,
+ PRC_DESC("This is the default size of the chunks in which an "
+          "HTTPDownloadManager downloads a large file of known size, with "
+          "a separate range request for each chunk.  It is also the "
+          "granularity at which an interrupted download may be resumed.  "
+          "Set this to 0 to download each file in a single request."));
+
+ConfigVariableInt http_download_max_retries
+("http-download-max-retries", 3,
+ PRC_DESC("This is the number of times an HTTPDownloadManager will retry "
+          "a request that fails with a lost connection or a server error "
+          "before giving up on the file."));
+
+ConfigVariableDouble http_download_poll_interval
+("http-download-poll-interval", 0.01,
+ PRC_DESC("This is the longest time, in seconds, that "
+          "HTTPDownloadManager::download_all() waits for data to arrive "
+          "on its connections before it runs them again.  It bounds the "
+          "delay for a connection that is waiting to send rather than "
+          "to receive."));
+
 ConfigVariableInt tcp_header_size
 ("tcp-header-size", 2,
  PRC_DESC("Specifies the number of bytes to use to specify the datagram "
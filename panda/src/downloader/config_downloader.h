@@ -44,6 +44,10 @@ extern ConfigVariableDouble http_timeout;
 extern ConfigVariableInt http_skip_body_size;
 extern ConfigVariableDouble http_idle_timeout;
 extern ConfigVariableInt http_max_connect_count;
+extern ConfigVariableInt http_download_max_channels;
+extern ConfigVariableInt http_download_chunk_size;
+extern ConfigVariableInt http_download_max_retries;
+extern ConfigVariableDouble http_download_poll_interval;
 
 extern EXPCL_PANDAEXPRESS ConfigVariableInt tcp_header_size;
 
@@ -856,6 +856,25 @@ downcase(const string &s) {
   return result;
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: HTTPChannel::get_socket
+//       Access: Public
+//  Description: Returns the operating system's handle to the socket
+//               of the channel's current connection, so that the
+//               caller may wait for data to arrive on it, or -1 if
+//               there is no connection.  The socket must not be read
+//               from or written to directly.
+////////////////////////////////////////////////////////////////////
+int HTTPChannel::
+get_socket() const {
+  if (_bio.is_null()) {
+    return -1;
+  }
+  int fd = -1;
+  BIO_get_fd(*_bio, &fd);
+  return fd;
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: HTTPChannel::body_stream_destructs
 //       Access: Public
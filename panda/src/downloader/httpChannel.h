@@ -201,6 +201,7 @@ PUBLISHED:
 public:
   static string downcase(const string &s);
   void body_stream_destructs(ISocketStream *stream);
+  int get_socket() const;
 
 private:
   bool reached_done_state();
@@ -0,0 +1,674 @@
+// Filename: httpDownloadManager.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "httpDownloadManager.h"
+#include "config_downloader.h"
+
+#ifdef HAVE_OPENSSL
+
+#if defined(WIN32_VC) || defined(WIN64_VC)
+  #include <WinSock2.h>
+  #include <windows.h>  // for select()
+  #undef X509_NAME
+#endif  // WIN32_VC
+
+////////////////////////////////////////////////////////////////////
+//     Function: HTTPDownloadManager::Constructor
+//       Access: Published
+//  Description: Creates a new manager that makes its channels with
+//               the indicated HTTPClient, or with the global
+//               HTTPClient if client is NULL.
+////////////////////////////////////////////////////////////////////
+HTTPDownloadManager::
+HTTPDownloadManager(HTTPClient *client) :
+  _client(client),
+  _max_channels(max((int)http_download_max_channels, 1)),
+  _chunk_size(max((int)http_download_chunk_size, 0)),
+  _max_retries(http_download_max_retries),
+  _num_active(0),
+  _num_complete(0),
+  _num_failed(0),
+  _bytes_finished(0)
+{
+  if (_client == (HTTPClient *)NULL) {
+    _client = HTTPClient::get_global_ptr();
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: HTTPDownloadManager::Destructor
+//       Access: Published
+//  Description: Abandons any downloads still in progress.  Their
+//               completed chunks remain recorded in their resume
+//               files.
+////////////////////////////////////////////////////////////////////
+HTTPDownloadManager::
+~HTTPDownloadManager() {
+  Slots::iterator si;
+  for (si = _slots.begin(); si != _slots.end(); ++si) {
+    // The body stream refers to the channel, so it must go first.
+    if ((*si)._body != (ISocketStream *)NULL) {
+      (*si)._channel->close_read_body((*si)._body);
+      (*si)._body = NULL;
+    }
+    (*si)._channel.clear();
+    if ((*si)._stream != (pfstream *)NULL) {
+      delete (*si)._stream;
+      (*si)._stream = NULL;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: HTTPDownloadManager::add_download
+//       Access: Published
+//  Description: Adds a document to be downloaded to the indicated
+//               file, and returns its index, which may be passed to
+//               get_download_status() and related methods.
+//               Downloads are started in the order they are added,
+//               as channels become available.
+//
+//               If file_size is given, and it is larger than the
+//               chunk size, the file will be split into chunks
+//               downloaded in parallel, and if a previous attempt to
+//               download the same document to this file was
+//               interrupted, only its missing chunks are downloaded
+//               now.  Otherwise, the file is downloaded in one
+//               request, from the beginning.
+////////////////////////////////////////////////////////////////////
+int HTTPDownloadManager::
+add_download(const DocumentSpec &url, const Filename &filename,
+             size_t file_size) {
+  int index = (int)_downloads.size();
+  _downloads.push_back(Download());
+  Download &download = _downloads.back();
+  download._url = url;
+  download._filename = filename;
+  download._filename.set_binary();
+  download._file_size = file_size;
+  download._chunk_size = 0;
+  download._status = DS_pending;
+  download._status_code = 0;
+  download._num_chunks_done = 0;
+  download._num_chunks_resumed = 0;
+  download._num_active = 0;
+  download._file_prepared = false;
+
+  if (_chunk_size != 0 && file_size > _chunk_size) {
+    download._chunk_size = _chunk_size;
+    size_t num_chunks = (file_size + _chunk_size - 1) / _chunk_size;
+    download._chunks_done = string(num_chunks, '0');
+    read_resume_file(download);
+
+    if (download._num_chunks_done == (int)num_chunks) {
+      // It was all there already.
+      download._status = DS_complete;
+      ++_num_complete;
+      get_resume_filename(download).unlink();
+      return index;
+    }
+  }
+
+  Request request;
+  request._download = index;
+  request._retries = 0;
+  if (download._chunk_size == 0) {
+    request._chunk = 0;
+    _requests.push_back(request);
+  } else {
+    for (size_t ci = 0; ci < download._chunks_done.size(); ++ci) {
+      if (download._chunks_done[ci] != '1') {
+        request._chunk = (int)ci;
+        _requests.push_back(request);
+      }
+    }
+  }
+
+  return index;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: HTTPDownloadManager::run()
+//       Access: Published
+//  Description: Gives each of the active channels a chance to do
+//               some work, and starts new requests on the channels
+//               that have finished.  This should be called repeatedly
+//               until it returns false, which indicates that all of
+//               the downloads are complete or have failed.
+////////////////////////////////////////////////////////////////////
+bool HTTPDownloadManager::
+run() {
+  for (int i = 0; i < (int)_slots.size(); ++i) {
+    Slot &slot = _slots[i];
+    if (!slot._busy) {
+      continue;
+    }
+    if (slot._body != (ISocketStream *)NULL) {
+      if (!run_body(slot)) {
+        finish_request(i);
+      }
+    } else if (!slot._channel->run()) {
+      if (!start_body(slot)) {
+        finish_request(i);
+      }
+    }
+  }
+
+  start_requests();
+  return (_num_active != 0 || !_requests.empty());
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: HTTPDownloadManager::download_all
+//       Access: Published
+//  Description: Calls run() until all of the downloads are complete
+//               or have failed.  Returns true if they all completed
+//               successfully, false if any failed.
+//
+//               Between calls to run(), this waits until one of the
+//               connections has data to read, or until
+//               http-download-poll-interval has elapsed, rather than
+//               spinning.
+////////////////////////////////////////////////////////////////////
+bool HTTPDownloadManager::
+download_all() {
+  while (run()) {
+    wait_for_data(http_download_poll_interval);
+  }
+  return (_num_failed == 0);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: HTTPDownloadManager::get_bytes_downloaded
+//       Access: Published
+//  Description: Returns the total number of bytes received so far,
+//               by all of the requests made by this manager,
+//               including those still in progress.  This does not
+//               count the chunks that were resumed from a previous
+//               attempt.
+////////////////////////////////////////////////////////////////////
+size_t HTTPDownloadManager::
+get_bytes_downloaded() const {
+  size_t bytes = _bytes_finished;
+  Slots::const_iterator si;
+  for (si = _slots.begin(); si != _slots.end(); ++si) {
+    if ((*si)._busy) {
+      bytes += (*si)._bytes_written;
+    }
+  }
+  return bytes;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: HTTPDownloadManager::wait_for_data
+//       Access: Private
+//  Description: Blocks until one of the busy channels has data
+//               waiting on its socket, or until the timeout, in
+//               seconds, has elapsed.  A channel that is waiting to
+//               connect or to send is not waited on; it will be run
+//               again after the timeout.
+////////////////////////////////////////////////////////////////////
+void HTTPDownloadManager::
+wait_for_data(double timeout) const {
+#if defined(HAVE_THREADS) && defined(SIMPLE_THREADS)
+  // In SIMPLE_THREADS mode, instead of blocking, simply yield the
+  // thread.
+  thread_yield();
+#else
+  fd_set rset;
+  FD_ZERO(&rset);
+  int max_fd = -1;
+
+  Slots::const_iterator si;
+  for (si = _slots.begin(); si != _slots.end(); ++si) {
+    const Slot &slot = (*si);
+    if (slot._busy) {
+      int fd = slot._channel->get_socket();
+      if (fd >= 0) {
+        FD_SET(fd, &rset);
+        max_fd = max(max_fd, fd);
+      }
+    }
+  }
+
+  struct timeval tv;
+  tv.tv_sec = (long)timeout;
+  tv.tv_usec = (long)((timeout - (double)tv.tv_sec) * 1000000.0);
+  select(max_fd + 1, &rset, NULL, NULL, &tv);
+#endif  // SIMPLE_THREADS
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: HTTPDownloadManager::start_requests
+//       Access: Private
+//  Description: Starts the next queued requests on each idle channel.
+////////////////////////////////////////////////////////////////////
+void HTTPDownloadManager::
+start_requests() {
+  while ((int)_slots.size() < _max_channels) {
+    Slot slot;
+    slot._busy = false;
+    slot._stream = NULL;
+    slot._body = NULL;
+    slot._first_byte = 0;
+    slot._bytes_written = 0;
+    slot._write_failed = false;
+    _slots.push_back(slot);
+  }
+
+  for (int i = 0; i < _max_channels && !_requests.empty(); ++i) {
+    if (_slots[i]._busy) {
+      continue;
+    }
+
+    while (!_requests.empty()) {
+      Request request = _requests.front();
+      _requests.pop_front();
+
+      const Download &download = _downloads[request._download];
+      if (download._status == DS_complete || download._status == DS_failed) {
+        continue;
+      }
+      if (download._chunk_size != 0 &&
+          download._chunks_done[request._chunk] == '1') {
+        // Some other request already delivered this chunk.
+        continue;
+      }
+      if (start_request(i, request)) {
+        break;
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: HTTPDownloadManager::start_request
+//       Access: Private
+//  Description: Begins the indicated request on the indicated
+//               channel.  Returns true if it is started, or false if
+//               the download has failed instead.
+////////////////////////////////////////////////////////////////////
+bool HTTPDownloadManager::
+start_request(int slot_index, const Request &request) {
+  Download &download = _downloads[request._download];
+  if (!download._file_prepared) {
+    if (!prepare_file(download)) {
+      fail_request(request, HTTPChannel::SC_download_open_error, false);
+      return false;
+    }
+  }
+
+  Slot &slot = _slots[slot_index];
+  if (slot._channel == (HTTPChannel *)NULL) {
+    slot._channel = _client->make_channel(true);
+  }
+  HTTPChannel *channel = slot._channel;
+
+  // We don't ask the channel to download the body itself, since it
+  // would write the body of an error response into the file too.
+  // Instead, run() reads just the headers here, and start_body()
+  // opens the file only if the response is good.
+  if (download._chunk_size == 0) {
+    channel->begin_get_document(download._url);
+
+  } else {
+    size_t first_byte = (size_t)request._chunk * download._chunk_size;
+    size_t last_byte = min(first_byte + download._chunk_size,
+                           download._file_size) - 1;
+    channel->begin_get_subdocument(download._url, first_byte, last_byte);
+  }
+
+  slot._busy = true;
+  slot._request = request;
+  slot._first_byte = 0;
+  slot._bytes_written = 0;
+  slot._write_failed = false;
+  ++_num_active;
+  ++download._num_active;
+  download._status = DS_downloading;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: HTTPDownloadManager::finish_request
+//       Access: Private
+//  Description: Called when the channel in the indicated slot has
+//               finished its request, successfully or otherwise.
+////////////////////////////////////////////////////////////////////
+void HTTPDownloadManager::
+finish_request(int slot_index) {
+  Slot &slot = _slots[slot_index];
+  HTTPChannel *channel = slot._channel;
+  Request request = slot._request;
+  Download &download = _downloads[request._download];
+
+  slot._busy = false;
+  --_num_active;
+  --download._num_active;
+
+  bool complete = false;
+  if (slot._body != (ISocketStream *)NULL) {
+    complete = (slot._body->get_read_state() == ISocketStream::RS_complete);
+    channel->close_read_body(slot._body);
+    slot._body = NULL;
+  }
+  if (slot._stream != (pfstream *)NULL) {
+    slot._stream->close();
+  }
+
+  int status_code = channel->get_status_code();
+  size_t bytes = slot._bytes_written;
+  _bytes_finished += bytes;
+
+  if (slot._write_failed) {
+    status_code = HTTPChannel::SC_download_write_error;
+    complete = false;
+  }
+
+  if (download._status == DS_complete || download._status == DS_failed) {
+    // Another request has already settled this download.
+    return;
+  }
+  download._status_code = status_code;
+
+  if (!complete) {
+    // We retry if the failure might be temporary: the connection was
+    // lost, the body was cut short, or the server had a problem.
+    bool retry = (!slot._write_failed &&
+                  (status_code < HTTPChannel::SC_http_error_watermark ||
+                   status_code >= 500 || channel->is_valid()));
+    fail_request(request, status_code, retry);
+    return;
+  }
+
+  if (download._chunk_size == 0) {
+    download._status = DS_complete;
+    ++_num_complete;
+    return;
+  }
+
+  // Mark each chunk covered by what the server actually delivered.
+  // Normally this is just the chunk we asked for, but a server that
+  // doesn't do ranges will have sent (and we will have written) the
+  // whole file.
+  size_t first_byte = slot._first_byte;
+  size_t end_byte = first_byte + bytes;
+  size_t chunk_size = download._chunk_size;
+  size_t ci = (first_byte + chunk_size - 1) / chunk_size;
+  for (; ci < download._chunks_done.size(); ++ci) {
+    size_t chunk_end = min((ci + 1) * chunk_size, download._file_size);
+    if (chunk_end > end_byte) {
+      break;
+    }
+    if (download._chunks_done[ci] != '1') {
+      download._chunks_done[ci] = '1';
+      ++download._num_chunks_done;
+    }
+  }
+
+  if (download._chunks_done[request._chunk] != '1') {
+    downloader_cat.info()
+      << "Server delivered bytes " << first_byte << " to " << end_byte
+      << " of " << download._url << " for chunk " << request._chunk
+      << "\n";
+    fail_request(request, status_code, false);
+    return;
+  }
+
+  if (download._num_chunks_done == (int)download._chunks_done.size()) {
+    download._status = DS_complete;
+    ++_num_complete;
+    get_resume_filename(download).unlink();
+  } else {
+    write_resume_file(download);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: HTTPDownloadManager::start_body
+//       Access: Private
+//  Description: Called when the channel in the indicated slot has
+//               read the headers of its response.  If the response
+//               is good, opens the file, positioned where the body
+//               belongs, and the body stream to read it from, and
+//               returns true; otherwise, returns false, leaving the
+//               file alone.
+////////////////////////////////////////////////////////////////////
+bool HTTPDownloadManager::
+start_body(Slot &slot) {
+  HTTPChannel *channel = slot._channel;
+  if (!channel->is_valid()) {
+    return false;
+  }
+
+  const Download &download = _downloads[slot._request._download];
+
+  // A chunk is written into the file where the server says it
+  // belongs, without truncating the rest of the file.
+  bool whole_file = (download._chunk_size == 0);
+  if (!whole_file) {
+    slot._first_byte = channel->get_first_byte_delivered();
+  }
+
+  if (slot._stream == (pfstream *)NULL) {
+    slot._stream = new pfstream;
+  }
+  slot._stream->clear();
+  if (!download._filename.open_read_write(*slot._stream, whole_file)) {
+    downloader_cat.info()
+      << "Could not open " << download._filename << " for writing.\n";
+    slot._write_failed = true;
+    return false;
+  }
+  slot._stream->seekp(slot._first_byte);
+
+  slot._body = channel->open_read_body();
+  return (slot._body != (ISocketStream *)NULL);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: HTTPDownloadManager::run_body
+//       Access: Private
+//  Description: Copies whatever is available of the body being read
+//               in the indicated slot into the file.  Returns true if
+//               there is more to come, or false when the body has
+//               been read, or the file can't be written.
+////////////////////////////////////////////////////////////////////
+bool HTTPDownloadManager::
+run_body(Slot &slot) {
+  static const size_t buffer_size = 4096;
+  char buffer[buffer_size];
+
+  slot._body->read(buffer, buffer_size);
+  size_t count = slot._body->gcount();
+  while (count != 0) {
+    slot._stream->write(buffer, count);
+    slot._bytes_written += count;
+    slot._body->read(buffer, buffer_size);
+    count = slot._body->gcount();
+  }
+
+  if (slot._stream->fail()) {
+    downloader_cat.warning()
+      << "Error writing to "
+      << _downloads[slot._request._download]._filename << "\n";
+    slot._write_failed = true;
+    return false;
+  }
+
+  return !slot._body->is_closed();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: HTTPDownloadManager::fail_request
+//       Access: Private
+//  Description: Called when the indicated request could not be
+//               completed.  If retry is true and the request has been
+//               retried fewer than max_retries times, it is queued
+//               again; otherwise, its download is marked as failed.
+////////////////////////////////////////////////////////////////////
+void HTTPDownloadManager::
+fail_request(const Request &request, int status_code, bool retry) {
+  Download &download = _downloads[request._download];
+  download._status_code = status_code;
+
+  if (retry && request._retries < _max_retries) {
+    if (downloader_cat.is_debug()) {
+      downloader_cat.debug()
+        << "Retrying " << download._url << " after status "
+        << status_code << "\n";
+    }
+    Request again = request;
+    ++again._retries;
+    _requests.push_back(again);
+    if (download._num_active == 0) {
+      download._status = DS_pending;
+    }
+    return;
+  }
+
+  downloader_cat.warning()
+    << "Unable to download " << download._url << " to "
+    << download._filename << " (status " << status_code << ")\n";
+  download._status = DS_failed;
+  ++_num_failed;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: HTTPDownloadManager::prepare_file
+//       Access: Private
+//  Description: Gets the file ready to receive the first request of
+//               a download.  For a chunked download, this creates
+//               the file at its full size, so that the chunks may be
+//               written into it in any order, and records the (empty)
+//               resume file.  Returns true on success.
+////////////////////////////////////////////////////////////////////
+bool HTTPDownloadManager::
+prepare_file(Download &download) {
+  download._filename.make_dir();
+
+  if (download._chunk_size != 0) {
+    pofstream out;
+    if (!download._filename.open_write(out, true)) {
+      downloader_cat.info()
+        << "Could not open " << download._filename << " for writing.\n";
+      return false;
+    }
+    out.seekp(download._file_size - 1);
+    out.put('\0');
+    out.close();
+    if (out.fail()) {
+      downloader_cat.info()
+        << "Could not allocate " << download._file_size << " bytes for "
+        << download._filename << ".\n";
+      return false;
+    }
+
+    write_resume_file(download);
+  }
+
+  download._file_prepared = true;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: HTTPDownloadManager::read_resume_file
+//       Access: Private
+//  Description: Looks for the resume file left by a previous attempt
+//               at the indicated chunked download.  If it is there,
+//               and it describes the same document, file size and
+//               chunk size, the chunks it records as done are marked
+//               done in this download too.
+////////////////////////////////////////////////////////////////////
+void HTTPDownloadManager::
+read_resume_file(Download &download) {
+  Filename resume_filename = get_resume_filename(download);
+  pifstream in;
+  if (!resume_filename.open_read(in)) {
+    return;
+  }
+
+  string url;
+  size_t file_size = 0;
+  size_t chunk_size = 0;
+  string chunks_done;
+  getline(in, url);
+  in >> file_size >> chunk_size >> chunks_done;
+  if (in.fail() || url != download._url.get_url().get_url() ||
+      file_size != download._file_size ||
+      chunk_size != download._chunk_size ||
+      chunks_done.size() != download._chunks_done.size() ||
+      download._filename.get_file_size() != (streamsize)file_size) {
+    // It's not the same download, or the file has changed since.
+    downloader_cat.info()
+      << "Ignoring " << resume_filename << ".\n";
+    return;
+  }
+
+  int num_chunks_done = 0;
+  for (size_t ci = 0; ci < chunks_done.size(); ++ci) {
+    if (chunks_done[ci] == '1') {
+      ++num_chunks_done;
+    } else {
+      chunks_done[ci] = '0';
+    }
+  }
+
+  download._chunks_done = chunks_done;
+  download._num_chunks_done = num_chunks_done;
+  download._num_chunks_resumed = num_chunks_done;
+  download._file_prepared = true;
+
+  if (downloader_cat.is_debug()) {
+    downloader_cat.debug()
+      << "Resuming " << download._url << " with " << num_chunks_done
+      << " of " << chunks_done.size() << " chunks.\n";
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: HTTPDownloadManager::write_resume_file
+//       Access: Private
+//  Description: Records the chunks of the indicated download that
+//               have been completed so far.
+////////////////////////////////////////////////////////////////////
+void HTTPDownloadManager::
+write_resume_file(const Download &download) const {
+  Filename resume_filename = get_resume_filename(download);
+  pofstream out;
+  if (!resume_filename.open_write(out, true)) {
+    downloader_cat.info()
+      << "Could not write " << resume_filename << ".\n";
+    return;
+  }
+
+  out << download._url.get_url().get_url() << "\n"
+      << download._file_size << " " << download._chunk_size << "\n"
+      << download._chunks_done << "\n";
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: HTTPDownloadManager::get_resume_filename
+//       Access: Private
+//  Description: Returns the name of the file that records the
+//               progress of the indicated download.
+////////////////////////////////////////////////////////////////////
+Filename HTTPDownloadManager::
+get_resume_filename(const Download &download) const {
+  Filename resume_filename = download._filename.get_fullpath() + ".resume";
+  resume_filename.set_text();
+  return resume_filename;
+}
+
+#endif  // HAVE_OPENSSL
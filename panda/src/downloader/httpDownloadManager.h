@@ -0,0 +1,183 @@
+// Filename: httpDownloadManager.h
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef HTTPDOWNLOADMANAGER_H
+#define HTTPDOWNLOADMANAGER_H
+
+#include "pandabase.h"
+
+// This module requires OpenSSL to compile, since HTTPChannel does.
+
+#ifdef HAVE_OPENSSL
+
+#include "httpClient.h"
+#include "httpChannel.h"
+#include "documentSpec.h"
+#include "filename.h"
+#include "referenceCount.h"
+#include "pointerTo.h"
+#include "pvector.h"
+#include "pdeque.h"
+
+////////////////////////////////////////////////////////////////////
+//       Class : HTTPDownloadManager
+// Description : Downloads a list of documents to files, using several
+//               HTTPChannels at once.  Each channel keeps its
+//               connection open between documents, so that a long
+//               list of small files is downloaded over a handful of
+//               persistent connections rather than a new connection
+//               for each one.
+//
+//               A file whose size is given to add_download(), and is
+//               larger than the chunk size, is split into chunks that
+//               are requested separately with byte ranges, so that
+//               several channels can work on one large file at once.
+//               The chunks already downloaded are recorded in a small
+//               file alongside the download, named by appending
+//               ".resume" to its filename; if the download is
+//               interrupted, adding it again later resumes it from
+//               the chunks that were completed.
+//
+//               This is all done with nonblocking I/O: call run()
+//               repeatedly until it returns false, or call
+//               download_all() to do this for you, waiting on the
+//               connections between calls.
+////////////////////////////////////////////////////////////////////
+class EXPCL_PANDAEXPRESS HTTPDownloadManager : public ReferenceCount {
+PUBLISHED:
+  HTTPDownloadManager(HTTPClient *client = NULL);
+  ~HTTPDownloadManager();
+
+  enum DownloadStatus {
+    DS_pending,
+    DS_downloading,
+    DS_complete,
+    DS_failed
+  };
+
+  INLINE HTTPClient *get_client() const;
+
+  INLINE void set_max_channels(int max_channels);
+  INLINE int get_max_channels() const;
+
+  INLINE void set_chunk_size(size_t chunk_size);
+  INLINE size_t get_chunk_size() const;
+
+  INLINE void set_max_retries(int max_retries);
+  INLINE int get_max_retries() const;
+
+  int add_download(const DocumentSpec &url, const Filename &filename,
+                   size_t file_size = 0);
+
+  bool run();
+  BLOCKING bool download_all();
+
+  INLINE int get_num_downloads() const;
+  INLINE const DocumentSpec &get_download_url(int n) const;
+  INLINE const Filename &get_download_filename(int n) const;
+  INLINE DownloadStatus get_download_status(int n) const;
+  INLINE int get_download_status_code(int n) const;
+  INLINE int get_download_num_chunks(int n) const;
+  INLINE int get_download_num_chunks_resumed(int n) const;
+
+  INLINE int get_num_complete() const;
+  INLINE int get_num_failed() const;
+  INLINE int get_num_active_channels() const;
+  size_t get_bytes_downloaded() const;
+
+private:
+  class Download;
+  class Request;
+  class Slot;
+
+  void wait_for_data(double timeout) const;
+  void start_requests();
+  bool start_request(int slot_index, const Request &request);
+  bool start_body(Slot &slot);
+  bool run_body(Slot &slot);
+  void finish_request(int slot_index);
+  void fail_request(const Request &request, int status_code, bool retry);
+
+  bool prepare_file(Download &download);
+  void read_resume_file(Download &download);
+  void write_resume_file(const Download &download) const;
+  Filename get_resume_filename(const Download &download) const;
+
+  class Download {
+  public:
+    DocumentSpec _url;
+    Filename _filename;
+    size_t _file_size;
+    size_t _chunk_size;
+    DownloadStatus _status;
+    int _status_code;
+
+    // If _chunk_size is 0, the file is downloaded in one request;
+    // otherwise, each chunk in turn is downloaded with its own range
+    // request, and _chunks_done records a '1' for each chunk that has
+    // been completed.  This is also the format of the resume file.
+    string _chunks_done;
+    int _num_chunks_done;
+    int _num_chunks_resumed;
+    int _num_active;
+    bool _file_prepared;
+  };
+
+  class Request {
+  public:
+    int _download;
+    int _chunk;
+    int _retries;
+  };
+
+  class Slot {
+  public:
+    PT(HTTPChannel) _channel;
+    bool _busy;
+    Request _request;
+
+    // The file is opened, and the body read, only once the headers
+    // of a good response have come in.
+    pfstream *_stream;
+    ISocketStream *_body;
+    size_t _first_byte;
+    size_t _bytes_written;
+    bool _write_failed;
+  };
+
+  PT(HTTPClient) _client;
+  int _max_channels;
+  size_t _chunk_size;
+  int _max_retries;
+
+  typedef pvector<Download> Downloads;
+  Downloads _downloads;
+
+  typedef pdeque<Request> Requests;
+  Requests _requests;
+
+  typedef pvector<Slot> Slots;
+  Slots _slots;
+  int _num_active;
+
+  int _num_complete;
+  int _num_failed;
+  size_t _bytes_finished;
+};
+
+#include "httpDownloadManager.I"
+
+#endif  // HAVE_OPENSSL
+
+#endif
@@ -0,0 +1,711 @@
+// Filename: test_httpDownloadManager.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "pandabase.h"
+#include "httpDownloadManager.h"
+#include "config_downloader.h"
+#include "socket_tcp_listen.h"
+#include "socket_tcp.h"
+#include "socket_address.h"
+#include "thread.h"
+#include "pmutex.h"
+#include "mutexHolder.h"
+#include "pointerTo.h"
+#include "pvector.h"
+#include "pmap.h"
+#include "trueClock.h"
+#include "filename.h"
+#include "testCheck.h"
+
+#include <time.h>
+
+// This program runs a small HTTP/1.1 server on a thread of its own,
+// and downloads files from it with an HTTPDownloadManager.  (The
+// fake_http_server program in panda/src/net can't serve here: it is
+// a program of its own, which only prints the requests it receives
+// and never answers them, while these checks need a server in the
+// same process that answers Range requests, can be told to fail or
+// ignore Range, and counts the requests and connections it sees.)
+// It checks that:
+//
+//   a large file is split into range requests that are served in
+//   parallel over a few persistent connections;
+//
+//   a request answered with a 5xx error is retried, and a download
+//   is failed once it runs out of retries;
+//
+//   an interrupted download leaves a .resume file behind, and adding
+//   it again requests only the chunks that are still missing;
+//
+//   a server that ignores the Range header and answers 200 with the
+//   whole file still produces the right file;
+//
+//   download_all() waits for the server rather than spinning.
+
+#ifdef HAVE_OPENSSL
+
+static const size_t big_size = 1000000;
+static const size_t chunk_size = 65536;
+static const int num_chunks = (int)((big_size + chunk_size - 1) / chunk_size);
+
+static TestCheck check;
+
+////////////////////////////////////////////////////////////////////
+//       Class : FakeServer
+// Description : Serves a fixed set of documents over HTTP/1.1, with
+//               keep-alive and byte ranges, and with the faults that
+//               the test asks for.  Each connection is handled by a
+//               thread of its own.
+////////////////////////////////////////////////////////////////////
+class FakeServer {
+public:
+  FakeServer();
+  ~FakeServer();
+
+  bool start();
+  void stop();
+  void reset_counts();
+
+  string get_url(const string &path) const;
+  void handle_connection(Socket_TCP *socket);
+
+  class ListenThread : public Thread {
+  public:
+    ListenThread(FakeServer *server) :
+      Thread("listen", "listen"), _server(server) { }
+    virtual void thread_main();
+    FakeServer *_server;
+  };
+
+  class ConnectionThread : public Thread {
+  public:
+    ConnectionThread(FakeServer *server, SOCKET socket) :
+      Thread("connection", "connection"), _server(server), _socket(socket) { }
+    virtual void thread_main();
+    FakeServer *_server;
+    Socket_TCP _socket;
+  };
+
+  typedef pmap<string, string> Documents;
+  Documents _documents;
+
+  Socket_TCP_Listen _listen;
+  int _port;
+  PT(ListenThread) _listen_thread;
+  typedef pvector< PT(ConnectionThread) > Connections;
+  Connections _connections;
+
+  // The faults to introduce, and the counts, are protected by the
+  // lock.
+  Mutex _lock;
+  bool _stop;
+  bool _ignore_range;
+  int _num_unavailable;
+  size_t _missing_from;
+  double _delay;
+
+  int _num_requests;
+  int _num_range_requests;
+  int _num_full_requests;
+  int _num_unavailable_sent;
+  int _num_connections;
+  int _active;
+  int _max_active;
+  size_t _first_range_start;
+};
+
+////////////////////////////////////////////////////////////////////
+//     Function: FakeServer::Constructor
+//  Description:
+////////////////////////////////////////////////////////////////////
+FakeServer::
+FakeServer() {
+  _port = 0;
+  _stop = false;
+  _ignore_range = false;
+  _num_unavailable = 0;
+  _missing_from = big_size;
+  _delay = 0.0;
+  reset_counts();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: FakeServer::Destructor
+//  Description:
+////////////////////////////////////////////////////////////////////
+FakeServer::
+~FakeServer() {
+  stop();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: FakeServer::start
+//  Description: Opens the listening socket on a free port and starts
+//               the thread that accepts connections.
+////////////////////////////////////////////////////////////////////
+bool FakeServer::
+start() {
+  for (int port = 18900; port < 19000; ++port) {
+    Socket_Address address;
+    if (address.set_host("127.0.0.1", port) && _listen.OpenForListen(address)) {
+      _port = port;
+      _listen.SetNonBlocking();
+      _listen_thread = new ListenThread(this);
+      return _listen_thread->start(TP_normal, true);
+    }
+  }
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: FakeServer::stop
+//  Description: Stops accepting connections, and waits for the
+//               connections that are open to be closed by the client.
+////////////////////////////////////////////////////////////////////
+void FakeServer::
+stop() {
+  {
+    MutexHolder holder(_lock);
+    _stop = true;
+  }
+  if (_listen_thread != (ListenThread *)NULL) {
+    _listen_thread->join();
+    _listen_thread = NULL;
+  }
+  Connections::iterator ci;
+  for (ci = _connections.begin(); ci != _connections.end(); ++ci) {
+    (*ci)->join();
+  }
+  _connections.clear();
+  _listen.Close();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: FakeServer::reset_counts
+//  Description: Zeroes the request counts.
+////////////////////////////////////////////////////////////////////
+void FakeServer::
+reset_counts() {
+  MutexHolder holder(_lock);
+  _num_requests = 0;
+  _num_range_requests = 0;
+  _num_full_requests = 0;
+  _num_unavailable_sent = 0;
+  _num_connections = 0;
+  _max_active = 0;
+  _active = 0;
+  _first_range_start = big_size;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: FakeServer::get_url
+//  Description: Returns the URL of the indicated document.
+////////////////////////////////////////////////////////////////////
+string FakeServer::
+get_url(const string &path) const {
+  ostringstream strm;
+  strm << "http://127.0.0.1:" << _port << path;
+  return strm.str();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: FakeServer::ListenThread::thread_main
+//  Description: Accepts connections until the server is stopped.
+////////////////////////////////////////////////////////////////////
+void FakeServer::ListenThread::
+thread_main() {
+  while (true) {
+    {
+      MutexHolder holder(_server->_lock);
+      if (_server->_stop) {
+        return;
+      }
+    }
+    SOCKET socket;
+    Socket_Address address;
+    if (_server->_listen.GetIncomingConnection(socket, address)) {
+      PT(ConnectionThread) thread = new ConnectionThread(_server, socket);
+      thread->_socket.SetBlocking();
+      {
+        MutexHolder holder(_server->_lock);
+        ++_server->_num_connections;
+      }
+      _server->_connections.push_back(thread);
+      thread->start(TP_normal, true);
+    } else {
+      Thread::sleep(0.002);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: FakeServer::ConnectionThread::thread_main
+//  Description: Serves requests on the connection until the client
+//               closes it.
+////////////////////////////////////////////////////////////////////
+void FakeServer::ConnectionThread::
+thread_main() {
+  _server->handle_connection(&_socket);
+  _socket.Close();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: FakeServer::handle_connection
+//  Description: Reads each request on the socket and answers it.
+////////////////////////////////////////////////////////////////////
+void FakeServer::
+handle_connection(Socket_TCP *socket) {
+  string received;
+  while (true) {
+    size_t end = received.find("\r\n\r\n");
+    while (end == string::npos) {
+      char buffer[4096];
+      int count = socket->RecvData(buffer, sizeof(buffer));
+      if (count <= 0) {
+        // The client has closed the connection.
+        return;
+      }
+      received.append(buffer, count);
+      end = received.find("\r\n\r\n");
+    }
+    string request = received.substr(0, end);
+    received = received.substr(end + 4);
+
+    // "GET /path HTTP/1.1", then the headers.
+    size_t space1 = request.find(' ');
+    size_t space2 = request.find(' ', space1 + 1);
+    string path = request.substr(space1 + 1, space2 - space1 - 1);
+    bool has_range = false;
+    size_t first_byte = 0, last_byte = 0;
+    size_t range = request.find("\r\nRange: bytes=");
+    if (range != string::npos) {
+      istringstream strm(request.substr(range + 15));
+      char dash = '\0';
+      strm >> first_byte >> dash >> last_byte;
+      has_range = (!strm.fail() && dash == '-');
+    }
+
+    ostringstream reply;
+    string body;
+    double delay;
+    {
+      MutexHolder holder(_lock);
+      ++_num_requests;
+      ++_active;
+      _max_active = max(_max_active, _active);
+      delay = _delay;
+
+      Documents::const_iterator di = _documents.find(path);
+      if (_num_unavailable > 0) {
+        --_num_unavailable;
+        ++_num_unavailable_sent;
+        body = "try again later";
+        reply << "HTTP/1.1 503 Service Unavailable\r\n";
+
+      } else if (di == _documents.end() ||
+                 (has_range && first_byte >= _missing_from)) {
+        body = "not found";
+        reply << "HTTP/1.1 404 Not Found\r\n";
+
+      } else if (has_range && !_ignore_range) {
+        const string &document = (*di).second;
+        last_byte = min(last_byte, document.size() - 1);
+        body = document.substr(first_byte, last_byte - first_byte + 1);
+        ++_num_range_requests;
+        _first_range_start = min(_first_range_start, first_byte);
+        reply << "HTTP/1.1 206 Partial Content\r\n"
+              << "Content-Range: bytes " << first_byte << "-" << last_byte
+              << "/" << document.size() << "\r\n";
+
+      } else {
+        body = (*di).second;
+        ++_num_full_requests;
+        reply << "HTTP/1.1 200 OK\r\n";
+      }
+    }
+    reply << "Content-Type: application/octet-stream\r\n"
+          << "Content-Length: " << body.size() << "\r\n"
+          << "\r\n";
+
+    if (delay > 0.0) {
+      Thread::sleep(delay);
+    }
+    string message = reply.str() + body;
+    size_t sent = 0;
+    while (sent < message.size()) {
+      int count = socket->SendData(message.data() + sent,
+                                   (int)(message.size() - sent));
+      if (count <= 0) {
+        MutexHolder holder(_lock);
+        --_active;
+        return;
+      }
+      sent += count;
+    }
+
+    MutexHolder holder(_lock);
+    --_active;
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: make_document
+//  Description: Returns a document of the indicated size whose bytes
+//               depend on their position and the seed.
+////////////////////////////////////////////////////////////////////
+static string
+make_document(size_t size, int seed) {
+  string document(size, '\0');
+  unsigned int value = (unsigned int)seed;
+  for (size_t i = 0; i < size; ++i) {
+    value = value * 1103515245 + 12345;
+    document[i] = (char)(value >> 16);
+  }
+  return document;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: read_file
+//  Description: Returns the contents of the file, or the empty string
+//               if it can't be read.
+////////////////////////////////////////////////////////////////////
+static string
+read_file(Filename filename) {
+  filename.set_binary();
+  pifstream in;
+  if (!filename.open_read(in)) {
+    return string();
+  }
+  ostringstream contents;
+  contents << in.rdbuf();
+  return contents.str();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: resume_filename
+//  Description: Returns the name of the resume file of the download.
+////////////////////////////////////////////////////////////////////
+static Filename
+resume_filename(const Filename &filename) {
+  return Filename(filename.get_fullpath() + ".resume");
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: test_parallel
+//  Description: Downloads the big file in chunks over several
+//               channels, along with a few small files.
+////////////////////////////////////////////////////////////////////
+static void
+test_parallel(FakeServer &server, const Filename &dir) {
+  server.reset_counts();
+  {
+    MutexHolder holder(server._lock);
+    server._delay = 0.02;
+  }
+
+  HTTPDownloadManager manager;
+  manager.set_max_channels(4);
+  manager.set_chunk_size(chunk_size);
+  Filename big(dir, "parallel.bin");
+  int big_index = manager.add_download(server.get_url("/big"), big, big_size);
+  for (int i = 0; i < 6; ++i) {
+    ostringstream name;
+    name << "small" << i % 3 << ".txt";
+    manager.add_download(server.get_url("/" + name.str()),
+                         Filename(dir, name.str()));
+  }
+
+  check(manager.download_all(), "parallel: download_all()");
+  check(manager.get_num_complete() == 7, "parallel: all complete");
+  check(manager.get_download_num_chunks(big_index) == num_chunks,
+        "parallel: number of chunks");
+  check(read_file(big) == server._documents["/big"], "parallel: big file");
+  check(read_file(Filename(dir, "small1.txt")) == server._documents["/small1.txt"],
+        "parallel: small file");
+  check(!resume_filename(big).exists(), "parallel: resume file removed");
+
+  MutexHolder holder(server._lock);
+  check(server._num_range_requests == num_chunks,
+        "parallel: one range request per chunk");
+  check(server._max_active >= 2, "parallel: requests served in parallel");
+  check(server._num_connections <= 4,
+        "parallel: connections kept alive and reused");
+  check(manager.get_bytes_downloaded() == big_size + 6 * 100,
+        "parallel: bytes downloaded");
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: test_retry
+//  Description: Checks that 5xx errors are retried, up to the limit.
+////////////////////////////////////////////////////////////////////
+static void
+test_retry(FakeServer &server, const Filename &dir) {
+  server.reset_counts();
+  {
+    MutexHolder holder(server._lock);
+    server._delay = 0.0;
+    server._num_unavailable = 3;
+  }
+
+  {
+    HTTPDownloadManager manager;
+    manager.set_max_channels(2);
+    manager.set_chunk_size(chunk_size);
+    manager.set_max_retries(3);
+    Filename big(dir, "retry.bin");
+    manager.add_download(server.get_url("/big"), big, big_size);
+    check(manager.download_all(), "retry: download_all()");
+    check(read_file(big) == server._documents["/big"], "retry: big file");
+
+    MutexHolder holder(server._lock);
+    check(server._num_unavailable_sent == 3, "retry: 503s sent");
+    check(server._num_range_requests == num_chunks,
+          "retry: every chunk delivered once");
+  }
+
+  // With more failures than retries, the download is given up.
+  {
+    MutexHolder holder(server._lock);
+    server._num_unavailable = 1000;
+  }
+  {
+    HTTPDownloadManager manager;
+    manager.set_max_channels(1);
+    manager.set_max_retries(2);
+    Filename small(dir, "retry.txt");
+    int index = manager.add_download(server.get_url("/small0.txt"), small);
+    check(!manager.download_all(), "retry: download_all() fails");
+    check(manager.get_download_status(index) == HTTPDownloadManager::DS_failed,
+          "retry: download failed");
+    check(manager.get_download_status_code(index) == 503,
+          "retry: status code of failure");
+
+    MutexHolder holder(server._lock);
+    check(server._num_unavailable_sent == 3 + 3,
+          "retry: tried once and retried twice");
+    server._num_unavailable = 0;
+  }
+
+  // A 404 is not retried.
+  server.reset_counts();
+  {
+    HTTPDownloadManager manager;
+    manager.set_max_retries(3);
+    int index = manager.add_download(server.get_url("/nothing"),
+                                     Filename(dir, "nothing.txt"));
+    check(!manager.download_all(), "retry: missing document fails");
+    check(manager.get_download_status_code(index) == 404,
+          "retry: missing document status");
+    check(!Filename(dir, "nothing.txt").exists(),
+          "retry: error page not written to file");
+    MutexHolder holder(server._lock);
+    check(server._num_requests == 1, "retry: 404 not retried");
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: test_resume
+//  Description: Interrupts a download partway, then resumes it.
+////////////////////////////////////////////////////////////////////
+static void
+test_resume(FakeServer &server, const Filename &dir) {
+  static const int chunks_before_failure = 5;
+  Filename big(dir, "resume.bin");
+  string url = server.get_url("/big");
+
+  server.reset_counts();
+  {
+    MutexHolder holder(server._lock);
+    server._missing_from = chunks_before_failure * chunk_size;
+  }
+  {
+    // One channel, so the chunks arrive in order up to the failure.
+    HTTPDownloadManager manager;
+    manager.set_max_channels(1);
+    manager.set_chunk_size(chunk_size);
+    manager.set_max_retries(0);
+    manager.add_download(url, big, big_size);
+    check(!manager.download_all(), "resume: first attempt fails");
+  }
+  check(resume_filename(big).exists(), "resume: resume file left behind");
+  check(big.get_file_size() == (streamsize)big_size,
+        "resume: file allocated at full size");
+
+  server.reset_counts();
+  {
+    MutexHolder holder(server._lock);
+    server._missing_from = big_size;
+  }
+  {
+    HTTPDownloadManager manager;
+    manager.set_max_channels(3);
+    manager.set_chunk_size(chunk_size);
+    int index = manager.add_download(url, big, big_size);
+    check(manager.get_download_num_chunks_resumed(index) ==
+          chunks_before_failure, "resume: chunks resumed");
+    check(manager.download_all(), "resume: second attempt");
+    check(read_file(big) == server._documents["/big"], "resume: big file");
+    check(!resume_filename(big).exists(), "resume: resume file removed");
+
+    MutexHolder holder(server._lock);
+    check(server._num_range_requests == num_chunks - chunks_before_failure,
+          "resume: only missing chunks requested");
+    check(server._first_range_start == chunks_before_failure * chunk_size,
+          "resume: first chunk requested");
+  }
+
+  // A resume file for a different document is ignored.
+  {
+    pofstream out;
+    Filename other = resume_filename(big);
+    other.set_text();
+    other.open_write(out);
+    out << server.get_url("/other") << "\n" << big_size << " " << chunk_size
+        << "\n" << string(num_chunks, '1') << "\n";
+  }
+  server.reset_counts();
+  {
+    HTTPDownloadManager manager;
+    manager.set_chunk_size(chunk_size);
+    int index = manager.add_download(url, big, big_size);
+    check(manager.get_download_num_chunks_resumed(index) == 0,
+          "resume: other document's resume file ignored");
+    check(manager.download_all(), "resume: third attempt");
+    MutexHolder holder(server._lock);
+    check(server._num_range_requests == num_chunks,
+          "resume: every chunk requested again");
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: test_ignore_range
+//  Description: Downloads from a server that answers every range
+//               request with the whole file.
+////////////////////////////////////////////////////////////////////
+static void
+test_ignore_range(FakeServer &server, const Filename &dir) {
+  server.reset_counts();
+  {
+    MutexHolder holder(server._lock);
+    server._ignore_range = true;
+  }
+
+  HTTPDownloadManager manager;
+  manager.set_max_channels(1);
+  manager.set_chunk_size(chunk_size);
+  Filename big(dir, "norange.bin");
+  int index = manager.add_download(server.get_url("/big"), big, big_size);
+  check(manager.download_all(), "ignore range: download_all()");
+  check(manager.get_download_status(index) == HTTPDownloadManager::DS_complete,
+        "ignore range: complete");
+  check(read_file(big) == server._documents["/big"], "ignore range: big file");
+  check(!resume_filename(big).exists(), "ignore range: resume file removed");
+
+  MutexHolder holder(server._lock);
+  check(server._num_full_requests == 1,
+        "ignore range: whole file delivered once");
+  server._ignore_range = false;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: test_no_spin
+//  Description: Checks that download_all() sleeps while it waits for
+//               a slow server.
+////////////////////////////////////////////////////////////////////
+static void
+test_no_spin(FakeServer &server, const Filename &dir) {
+  server.reset_counts();
+  {
+    MutexHolder holder(server._lock);
+    server._delay = 0.1;
+  }
+
+  HTTPDownloadManager manager;
+  manager.set_max_channels(2);
+  manager.set_chunk_size(chunk_size);
+  for (int i = 0; i < 6; ++i) {
+    ostringstream name;
+    name << "slow" << i << ".txt";
+    manager.add_download(server.get_url("/small0.txt"),
+                         Filename(dir, name.str()));
+  }
+
+  TrueClock *true_clock = TrueClock::get_global_ptr();
+  double start = true_clock->get_short_time();
+  clock_t cpu_start = clock();
+  check(manager.download_all(), "no spin: download_all()");
+  double elapsed = true_clock->get_short_time() - start;
+  double cpu = (double)(clock() - cpu_start) / CLOCKS_PER_SEC;
+  {
+    MutexHolder holder(server._lock);
+    server._delay = 0.0;
+  }
+
+  check(elapsed >= 0.25, "no spin: server was slow");
+  check(cpu < elapsed * 0.5, "no spin: waited without spinning");
+  if (cpu >= elapsed * 0.5) {
+    nout << "Used " << cpu << " s of CPU in " << elapsed << " s.\n";
+  }
+}
+
+int
+main(int argc, char *argv[]) {
+  init_libdownloader();
+
+  FakeServer server;
+  server._documents["/big"] = make_document(big_size, 1);
+  for (int i = 0; i < 3; ++i) {
+    ostringstream name;
+    name << "/small" << i << ".txt";
+    server._documents[name.str()] = make_document(100, i + 2);
+  }
+  if (!server.start()) {
+    nout << "Could not open a port to listen on.\n";
+    return 1;
+  }
+
+  Filename dir = Filename::temporary("", "httpdl_");
+  dir.mkdir();
+
+  test_parallel(server, dir);
+  test_retry(server, dir);
+  test_resume(server, dir);
+  test_ignore_range(server, dir);
+  test_no_spin(server, dir);
+
+  server.stop();
+
+  static const char *const names[] = {
+    "parallel.bin", "retry.bin", "resume.bin", "norange.bin",
+    "small0.txt", "small1.txt", "small2.txt", "retry.txt", "nothing.txt",
+    "slow0.txt", "slow1.txt", "slow2.txt", "slow3.txt", "slow4.txt",
+    "slow5.txt", "resume.bin.resume", "retry.bin.resume",
+  };
+  for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+    Filename(dir, names[i]).unlink();
+  }
+  dir.rmdir();
+
+  return check.report();
+}
+
+#else  // HAVE_OPENSSL
+
+int
+main(int argc, char *argv[]) {
+  nout << "HTTPDownloadManager requires OpenSSL.\n";
+  return 0;
+}
+
+#endif  // HAVE_OPENSSL
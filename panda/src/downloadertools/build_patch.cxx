@@ -49,7 +49,19 @@ help() {
     "        input files appear to be multifiles.\n\n"
 
     "    -f footprint_length\n"
-    "        Specify the footprint length for the patching algorithm.\n\n";
+    "        Specify the footprint length for the patching algorithm.\n\n"
+
+    "    -b block_size\n"
+    "        Specify the block size used for files larger than\n"
+    "        patchfile-block-threshold, which are patched by matching blocks\n"
+    "        of the old file rather than reading both files into memory.\n"
+    "        Specify 0 to always use the footprint algorithm.\n\n"
+
+    "    -B\n"
+    "        Match blocks for all files, regardless of their size.\n\n"
+
+    "    -j num_threads\n"
+    "        Specify the number of threads that match blocks.\n\n";
 }
 
 int
@@ -60,10 +72,13 @@ main(int argc, char **argv) {
   Filename patch_file;
   bool complete_file = false;
   int footprint_length = 0;
+  int block_size = -1;
+  bool all_blocks = false;
+  int num_threads = 0;
 
   //  extern char *optarg;
   extern int optind;
-  static const char *optflags = "o:cf:h";
+  static const char *optflags = "o:cf:b:Bj:h";
   preprocess_argv(argc, argv);
   int flag = getopt(argc, argv, optflags);
   Filename rel_path;
@@ -81,6 +96,18 @@ main(int argc, char **argv) {
       footprint_length = atoi(optarg);
       break;
 
+    case 'b':
+      block_size = atoi(optarg);
+      break;
+
+    case 'B':
+      all_blocks = true;
+      break;
+
+    case 'j':
+      num_threads = atoi(optarg);
+      break;
+
     case 'h':
       help();
       return 1;
@@ -117,6 +144,15 @@ main(int argc, char **argv) {
     cerr << "Footprint length is " << footprint_length << "\n";
     pfile.set_footprint_length(footprint_length);
   }
+  if (block_size >= 0) {
+    pfile.set_block_size(block_size);
+  }
+  if (all_blocks) {
+    pfile.set_block_threshold(0);
+  }
+  if (num_threads != 0) {
+    pfile.set_num_threads(num_threads);
+  }
 
   cerr << "Building patch file to convert " << src_file << " to "
        << dest_file << endl;
@@ -44,7 +44,9 @@
      eggPolygon.h eggPolysetMaker.h eggPoolUniquifier.h \
      eggPrimitive.I eggPrimitive.h \
      eggRenderMode.I eggRenderMode.h  \
-     eggSAnimData.I eggSAnimData.h eggSurface.I eggSurface.h  \
+     eggSAnimData.I eggSAnimData.h \
+     eggStreamParser.I eggStreamParser.h \
+     eggSurface.I eggSurface.h  \
      eggSwitchCondition.h eggTable.I eggTable.h eggTexture.I  \
      eggTexture.h eggTextureCollection.I eggTextureCollection.h  \
      eggTriangleFan.I eggTriangleFan.h \
@@ -85,7 +87,8 @@
      eggPatch.cxx \
      eggPoint.cxx eggPolygon.cxx eggPolysetMaker.cxx  \
      eggPoolUniquifier.cxx eggPrimitive.cxx eggRenderMode.cxx  \
-     eggSAnimData.cxx eggSurface.cxx eggSwitchCondition.cxx  \
+     eggSAnimData.cxx eggStreamParser.cxx \
+     eggSurface.cxx eggSwitchCondition.cxx  \
      eggTable.cxx eggTexture.cxx eggTextureCollection.cxx  \
      eggTransform.cxx \
      eggTriangleFan.cxx \
@@ -122,7 +125,9 @@
     eggPoint.I eggPoint.h \
     eggPolygon.I eggPolygon.h eggPolysetMaker.h eggPoolUniquifier.h \
     eggPrimitive.I eggPrimitive.h eggRenderMode.I eggRenderMode.h \
-    eggSAnimData.I eggSAnimData.h eggSurface.I eggSurface.h \
+    eggSAnimData.I eggSAnimData.h \
+    eggStreamParser.I eggStreamParser.h \
+    eggSurface.I eggSurface.h \
     eggSwitchCondition.h eggTable.I eggTable.h eggTexture.I \
     eggTexture.h eggTextureCollection.I eggTextureCollection.h \
     eggTransform.I eggTransform.h \
@@ -154,3 +159,22 @@
 
 #end test_bin_target
 
+#begin test_bin_target
+  #define TARGET test_eggparse
+  #define LOCAL_LIBS \
+    p3egg p3putil p3mathutil
+
+  #define SOURCES \
+    test_eggparse.cxx
+
+#end test_bin_target
+
+#begin test_bin_target
+  #define TARGET test_eggmem
+  #define LOCAL_LIBS \
+    p3egg p3putil p3mathutil
+
+  #define SOURCES \
+    test_eggmem.cxx
+
+#end test_bin_target
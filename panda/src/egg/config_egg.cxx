@@ -160,6 +160,16 @@ ConfigVariableInt egg_recursion_limit
           "overflow.  Set it larger to run more efficiently if your stack "
           "allows it; set it lower if you experience stack overflows."));
 
+ConfigVariableBool egg_stream_parser
+("egg-stream-parser", false,
+ PRC_DESC("Set this true to read egg files with the hand-written streaming "
+          "parser, which reads the file directly from memory and is "
+          "several times faster than the bison parser on large files.  "
+          "Any file it cannot handle cleanly is quietly read again with "
+          "the bison parser, which reports the problems.  This is "
+          "experimental, and off by default; the bison parser remains "
+          "the reference."));
+
 ////////////////////////////////////////////////////////////////////
 //     Function: init_libegg
 //  Description: Initializes the library.  This must be called at
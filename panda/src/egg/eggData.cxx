@@ -26,6 +26,7 @@
 #include "virtualFileSystem.h"
 #include "lightMutexHolder.h"
 #include "zStream.h"
+#include "eggStreamParser.h"
 
 extern int eggyyparse();
 #include "parserDefs.h"
@@ -85,6 +86,21 @@ read(Filename filename, string display_name) {
   }
   set_egg_timestamp(vfile->get_timestamp());
 
+  if (egg_stream_parser) {
+    // Read the whole file into memory (or map it there), and hand it
+    // to the streaming parser.
+    EggStreamParser::FileBuffer buffer;
+    if (!buffer.read(vfile)) {
+      egg_cat.error() << "Unable to open " << display_name << "\n";
+      return false;
+    }
+
+    egg_cat.info()
+      << "Reading " << display_name << "\n";
+
+    return read_buffer(buffer.get_data(), buffer.get_size());
+  }
+
   istream *file = vfile->open_read_file(true);
   if (file == (istream *)NULL) {
     egg_cat.error() << "Unable to open " << display_name << "\n";
@@ -116,6 +132,15 @@ read(Filename filename, string display_name) {
 ////////////////////////////////////////////////////////////////////
 bool EggData::
 read(istream &in) {
+  if (egg_stream_parser) {
+    EggStreamParser::FileBuffer buffer;
+    if (!buffer.read(in)) {
+      egg_cat.error() << "Error reading " << get_egg_filename() << "\n";
+      return false;
+    }
+    return read_buffer(buffer.get_data(), buffer.get_size());
+  }
+
   // First, dispense with any children we had previously.  We will
   // replace them with the new data.
   clear();
@@ -142,6 +167,59 @@ read(istream &in) {
   return (error_count == 0);
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: EggData::read_buffer
+//       Access: Private
+//  Description: Parses the egg syntax contained in the indicated
+//               buffer, which holds the complete contents of an egg
+//               file.  This is the implementation of read() when
+//               egg-stream-parser is true.
+//
+//               The buffer is parsed first with the EggStreamParser.
+//               If that parser gives up, because the file contains
+//               errors or constructs it does not handle, the buffer
+//               is parsed again from the beginning with the bison
+//               parser, which reports the errors properly.
+////////////////////////////////////////////////////////////////////
+bool EggData::
+read_buffer(const char *buffer, size_t size) {
+  clear();
+
+  PT(EggData) data = new EggData(*this);
+
+  EggStreamParser parser(buffer, size);
+  PT(EggNode) node = parser.read_node();
+  while (node != (EggNode *)NULL) {
+    data->add_child(node);
+    node = parser.read_node();
+  }
+
+  int error_count = 0;
+  if (parser.is_failed()) {
+    if (egg_cat.is_debug()) {
+      egg_cat.debug()
+        << "Reading " << get_egg_filename() << " again with the bison parser.\n";
+    }
+
+    data = new EggData(*this);
+    EggStreamParser::BufferStreamBuf buf(buffer, size);
+    istream in(&buf);
+
+    LightMutexHolder holder(egg_lock);
+    egg_init_parser(in, get_egg_filename(), data, data);
+    eggyyparse();
+    egg_cleanup_parser();
+    error_count = egg_error_count();
+  }
+
+  data->post_read();
+
+  steal_children(*data);
+  (*this) = *data;
+
+  return (error_count == 0);
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: EggData::merge
 //       Access: Public
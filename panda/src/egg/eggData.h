@@ -80,6 +80,7 @@ protected:
   virtual void write(ostream &out, int indent_level = 0) const;
 
 private:
+  bool read_buffer(const char *buffer, size_t size);
   void post_read();
   void pre_write();
 
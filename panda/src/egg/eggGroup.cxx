@@ -94,7 +94,7 @@ operator = (const EggGroup &copy) {
   for (vri = _vref.begin(); vri != _vref.end(); ++vri) {
     EggVertex *vert = (*vri).first;
 
-    bool inserted = vert->_gref.insert(this).second;
+    bool inserted = vert->insert_gref(this);
     // Did the group not exist previously in the vertex's gref list?
     // If it was there already, we must be out of sync between
     // vertices and groups.
@@ -693,7 +693,7 @@ ref_vertex(EggVertex *vert, double membership) {
     if (membership != 0.0) {
       _vref[vert] = membership;
 
-      bool inserted = vert->_gref.insert(this).second;
+      bool inserted = vert->insert_gref(this);
       // Did the group not exist previously in the vertex's gref list?
       // If it was there already, we must be out of sync between
       // vertices and groups.
@@ -716,7 +716,7 @@ unref_vertex(EggVertex *vert) {
 
   if (vri != _vref.end()) {
     _vref.erase(vri);
-    int count = vert->_gref.erase(this);
+    int count = vert->erase_gref(this);
     // Did the group exist in the vertex's gref list?  If it didn't,
     // we must be out of sync between vertices and groups.
     nassertv(count == 1);
@@ -735,7 +735,7 @@ unref_all_vertices() {
   VertexRef::iterator vri;
   for (vri = _vref.begin(); vri != _vref.end(); ++vri) {
     EggVertex *vert = (*vri).first;
-    int count = vert->_gref.erase(this);
+    int count = vert->erase_gref(this);
     // Did the group exist in the vertex's gref list?  If it didn't,
     // we must be out of sync between vertices and groups.
     nassertv(count == 1);
@@ -787,7 +787,7 @@ set_vertex_membership(EggVertex *vert, double membership) {
     // The vertex was not already reffed; ref it.
     _vref[vert] = membership;
 
-    bool inserted = vert->_gref.insert(this).second;
+    bool inserted = vert->insert_gref(this);
     // Did the group not exist previously in the vertex's gref list?
     // If it was there already, we must be out of sync between
     // vertices and groups.
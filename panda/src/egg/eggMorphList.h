@@ -26,6 +26,11 @@
 ////////////////////////////////////////////////////////////////////
 //       Class : EggMorphList
 // Description : A collection of <Dxyz>'s or <Duv>'s or some such.
+//
+//               Most vertices have no morphs at all, so the list is
+//               stored out of line, and allocated only when the
+//               first morph is added; an empty list costs just one
+//               pointer.
 ////////////////////////////////////////////////////////////////////
 template<class MorphType>
 class EggMorphList {
@@ -62,7 +67,7 @@ public:
              const string &tag, int num_dimensions) const;
 
 private:
-  Morphs _morphs;
+  Morphs *_morphs;
 };
 
 typedef EggMorphList<EggMorphVertex> EggMorphVertexList;
@@ -23,7 +23,9 @@ TypeHandle EggObject::_type_handle;
 //  Description:
 ////////////////////////////////////////////////////////////////////
 EggObject::
-EggObject() {
+EggObject() :
+  _user_data(NULL)
+{
 }
 
 
@@ -35,7 +37,7 @@ EggObject() {
 EggObject::
 EggObject(const EggObject &copy) : 
   TypedReferenceCount(copy),
-  _user_data(copy._user_data),
+  _user_data(copy._user_data == NULL ? NULL : new UserData(*copy._user_data)),
   _default_user_data(copy._default_user_data)
 {
 }
@@ -49,7 +51,14 @@ EggObject(const EggObject &copy) :
 EggObject &EggObject::
 operator = (const EggObject &copy) {
   TypedReferenceCount::operator = (copy);
-  _user_data = copy._user_data;
+  if (copy._user_data == NULL) {
+    delete _user_data;
+    _user_data = NULL;
+  } else if (_user_data == NULL) {
+    _user_data = new UserData(*copy._user_data);
+  } else {
+    (*_user_data) = (*copy._user_data);
+  }
   _default_user_data = copy._default_user_data;
   return *this;
 }
@@ -61,6 +70,7 @@ operator = (const EggObject &copy) {
 ////////////////////////////////////////////////////////////////////
 EggObject::
 ~EggObject() {
+  delete _user_data;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -87,7 +97,10 @@ EggObject::
 ////////////////////////////////////////////////////////////////////
 void EggObject::
 set_user_data(EggUserData *user_data) {
-  _user_data[user_data->get_type()] = user_data;
+  if (_user_data == NULL) {
+    _user_data = new UserData;
+  }
+  (*_user_data)[user_data->get_type()] = user_data;
   _default_user_data = user_data;
 }
 
@@ -111,9 +124,12 @@ get_user_data() const {
 ////////////////////////////////////////////////////////////////////
 EggUserData *EggObject::
 get_user_data(TypeHandle type) const {
+  if (_user_data == NULL) {
+    return NULL;
+  }
   UserData::const_iterator ui;
-  ui = _user_data.find(type);
-  if (ui != _user_data.end()) {
+  ui = _user_data->find(type);
+  if (ui != _user_data->end()) {
     return (*ui).second;
   }
   return NULL;
@@ -139,9 +155,12 @@ has_user_data() const {
 ////////////////////////////////////////////////////////////////////
 bool EggObject::
 has_user_data(TypeHandle type) const {
+  if (_user_data == NULL) {
+    return false;
+  }
   UserData::const_iterator ui;
-  ui = _user_data.find(type);
-  return (ui != _user_data.end());
+  ui = _user_data->find(type);
+  return (ui != _user_data->end());
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -151,7 +170,8 @@ has_user_data(TypeHandle type) const {
 ////////////////////////////////////////////////////////////////////
 void EggObject::
 clear_user_data() {
-  _user_data.clear();
+  delete _user_data;
+  _user_data = NULL;
   _default_user_data.clear();
 }
 
@@ -162,13 +182,16 @@ clear_user_data() {
 ////////////////////////////////////////////////////////////////////
 void EggObject::
 clear_user_data(TypeHandle type) {
+  if (_user_data == NULL) {
+    return;
+  }
   UserData::iterator ui;
-  ui = _user_data.find(type);
-  if (ui != _user_data.end()) {
+  ui = _user_data->find(type);
+  if (ui != _user_data->end()) {
     if ((*ui).second == _default_user_data) {
       _default_user_data.clear();
     }
-    _user_data.erase(ui);
+    _user_data->erase(ui);
   }
 }
 
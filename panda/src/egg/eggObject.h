@@ -48,8 +48,10 @@ public:
   virtual EggTransform *as_transform();
 
 private:
+  // The user data table is allocated only when the first user data
+  // is stored, since most egg objects never have any.
   typedef pmap<TypeHandle, PT(EggUserData) > UserData;
-  UserData _user_data;
+  UserData *_user_data;
   PT(EggUserData) _default_user_data;
 
 public:
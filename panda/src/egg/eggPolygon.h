@@ -28,6 +28,7 @@ PUBLISHED:
   INLINE EggPolygon(const string &name = "");
   INLINE EggPolygon(const EggPolygon &copy);
   INLINE EggPolygon &operator = (const EggPolygon &copy);
+  ALLOC_DELETED_CHAIN(EggPolygon);
 
   virtual bool cleanup();
 
@@ -871,12 +871,11 @@ prepare_add_vertex(EggVertex *vertex, int i, int n) {
   // added.
   nassertv(empty() || vertex->get_pool() == get_pool());
 
-  // Since a given vertex might appear more than once in a particular
-  // primitive, we can't conclude anything about data integrity by
-  // inspecting the return value of insert().  (In fact, the vertex's
-  // pref is a multiset, so the insert() will always succeed.)
+  // A given vertex might appear more than once in a particular
+  // primitive, so the vertex's pref may list the same primitive more
+  // than once.
 
-  vertex->_pref.insert(this);
+  vertex->_pref.push_back(this);
 }
 
 
@@ -900,18 +899,19 @@ prepare_remove_vertex(EggVertex *vertex, int i, int n) {
   // We can't test integrity within this function, because it might be
   // called when the primitive is in an incomplete state.
 
-  // Now we must remove the primitive from the vertex's pref.  We
-  // can't just use the simple erase() function, since that will
-  // remove all instances of this primitive from the pref; instead, we
-  // must find one instance and remove that.
+  // Now we must remove the primitive from the vertex's pref.  The
+  // primitive may appear there more than once; we must find one
+  // instance and remove that.  We search from the end, since the
+  // primitive most recently added is the most likely to be removed.
 
-  EggVertex::PrimitiveRef::iterator pri = vertex->_pref.find(this);
+  EggVertex::PrimitiveRef::reverse_iterator pri =
+    ::find(vertex->_pref.rbegin(), vertex->_pref.rend(), this);
 
   // We should have found the primitive in the vertex's pref.  If we
   // did not, something's out of sync internally.
-  nassertv(pri != vertex->_pref.end());
+  nassertv(pri != vertex->_pref.rend());
 
-  vertex->_pref.erase(pri);
+  vertex->_pref.erase(pri.base() - 1);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -0,0 +1,2941 @@
+// Filename: eggStreamParser.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "eggStreamParser.h"
+#include "config_egg.h"
+#include "eggVertex.h"
+#include "eggVertexUV.h"
+#include "eggVertexAux.h"
+#include "eggPolygon.h"
+#include "eggCompositePrimitive.h"
+#include "eggTriangleFan.h"
+#include "eggTriangleStrip.h"
+#include "eggPatch.h"
+#include "eggPoint.h"
+#include "eggLine.h"
+#include "eggTable.h"
+#include "eggSAnimData.h"
+#include "eggXfmSAnim.h"
+#include "eggXfmAnimData.h"
+#include "eggTexture.h"
+#include "eggMaterial.h"
+#include "eggComment.h"
+#include "eggCoordinateSystem.h"
+#include "eggExternalReference.h"
+#include "eggAnimPreload.h"
+#include "eggTransform.h"
+#include "virtualFileSimple.h"
+#include "virtualFileMountSystem.h"
+#include "string_utils.h"
+#include "thread.h"
+#include "dcast.h"
+
+#include <math.h>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// The <Keyword> tokens recognized by the lexer, sorted by name, so
+// that we can look them up with a binary search.  The names are in
+// uppercase; the lookup is case-insensitive, as the lexer is.
+const EggStreamParser::KeywordDef EggStreamParser::_keywords[] = {
+  { "ANIMPRELOAD", K_animpreload },
+  { "AUX", K_aux },
+  { "BEZIERCURVE", K_beziercurve },
+  { "BFACE", K_bface },
+  { "BILLBOARD", K_billboard },
+  { "BILLBOARDCENTER", K_billboardcenter },
+  { "BINORMAL", K_binormal },
+  { "BUNDLE", K_bundle },
+  { "CHAR*", K_scalar },
+  { "CLOSED", K_closed },
+  { "COLLIDE", K_collide },
+  { "COMMENT", K_comment },
+  { "COMPONENT", K_component },
+  { "COORDINATESYSTEM", K_coordsystem },
+  { "CV", K_cv },
+  { "DART", K_dart },
+  { "DCS", K_dcs },
+  { "DEFAULTPOSE", K_defaultpose },
+  { "DISTANCE", K_distance },
+  { "DNORMAL", K_dnormal },
+  { "DRGBA", K_drgba },
+  { "DTREF", K_dtref },
+  { "DUV", K_duv },
+  { "DXYZ", K_dxyz },
+  { "DYNAMICVERTEXPOOL", K_dynamicvertexpool },
+  { "FILE", K_external_file },
+  { "GROUP", K_group },
+  { "INCLUDE", K_include },
+  { "INSTANCE", K_instance },
+  { "JOINT", K_joint },
+  { "KNOTS", K_knots },
+  { "LINE", K_line },
+  { "LOOP", K_loop },
+  { "MATERIAL", K_material },
+  { "MATRIX3", K_matrix3 },
+  { "MATRIX4", K_matrix4 },
+  { "MODEL", K_model },
+  { "MREF", K_mref },
+  { "NORMAL", K_normal },
+  { "NURBSCURVE", K_nurbscurve },
+  { "NURBSSURFACE", K_nurbssurface },
+  { "OBJECTTYPE", K_objecttype },
+  { "ORDER", K_order },
+  { "OUTTANGENT", K_outtangent },
+  { "PATCH", K_patch },
+  { "POINTLIGHT", K_pointlight },
+  { "POLYGON", K_polygon },
+  { "REF", K_ref },
+  { "RGBA", K_rgba },
+  { "ROTATE", K_rotate },
+  { "ROTX", K_rotx },
+  { "ROTY", K_roty },
+  { "ROTZ", K_rotz },
+  { "S$ANIM", K_sanim },
+  { "SCALAR", K_scalar },
+  { "SCALE", K_scale },
+  { "SEQUENCE", K_sequence },
+  { "SHADING", K_shading },
+  { "SWITCH", K_switch },
+  { "SWITCHCONDITION", K_switchcondition },
+  { "TABLE", K_table },
+  { "TAG", K_tag },
+  { "TANGENT", K_tangent },
+  { "TEXLIST", K_texlist },
+  { "TEXTURE", K_texture },
+  { "TLENGTHS", K_tlengths },
+  { "TRANSFORM", K_transform },
+  { "TRANSLATE", K_translate },
+  { "TREF", K_tref },
+  { "TRIANGLEFAN", K_trianglefan },
+  { "TRIANGLESTRIP", K_trianglestrip },
+  { "TRIM", K_trim },
+  { "TXT", K_txt },
+  { "U-KNOTS", K_uknots },
+  { "UV", K_uv },
+  { "U_KNOTS", K_uknots },
+  { "V", K_table_v },
+  { "V-KNOTS", K_vknots },
+  { "VERTEX", K_vertex },
+  { "VERTEXANIM", K_vertexanim },
+  { "VERTEXPOOL", K_vertexpool },
+  { "VERTEXREF", K_vertexref },
+  { "V_KNOTS", K_vknots },
+  { "XFM$ANIM", K_xfmanim },
+  { "XFM$ANIM_S$", K_xfmsanim },
+};
+
+const int EggStreamParser::_num_keywords =
+  sizeof(_keywords) / sizeof(_keywords[0]);
+
+// Returns true if the character ends an unquoted string.
+static inline bool
+is_delimiter(char c) {
+  return (c == ' ' || c == '\t' || c == '\n' || c == '\r' ||
+          c == '{' || c == '}' || c == '"');
+}
+
+static inline bool
+is_digit(char c) {
+  return (c >= '0' && c <= '9');
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::Constructor
+//       Access: Public
+//  Description: Prepares to parse the indicated buffer, which must
+//               remain valid for the lifetime of the parser.
+////////////////////////////////////////////////////////////////////
+EggStreamParser::
+EggStreamParser(const char *data, size_t size) :
+  _p(data),
+  _end(data + size),
+  _failed(false),
+  _finished(false)
+{
+  advance();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::Destructor
+//       Access: Public
+//  Description:
+////////////////////////////////////////////////////////////////////
+EggStreamParser::
+~EggStreamParser() {
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::read_node
+//       Access: Public
+//  Description: Parses and returns the next toplevel node of the egg
+//               file, or NULL at the end of the file or if the parse
+//               has failed; check is_failed() to tell the difference.
+//
+//               The caller should add each node to the EggData in
+//               turn.  Note that a vertex pool returned by this
+//               method may still receive new vertices, referenced
+//               by primitives that appear later in the file.
+////////////////////////////////////////////////////////////////////
+PT(EggNode) EggStreamParser::
+read_node() {
+  if (!_pending.empty()) {
+    PT(EggNode) node = _pending.front();
+    _pending.pop_front();
+    return node;
+  }
+
+  if (_failed || _finished) {
+    return NULL;
+  }
+
+  if (_token._type == TT_eof) {
+    _finished = true;
+    check_vertex_pools();
+
+    // Clean these out now, so we don't keep big memory structures
+    // around needlessly.
+    _vertex_pools.clear();
+    _textures.clear();
+    _materials.clear();
+    _groups.clear();
+    return NULL;
+  }
+
+  PT(EggNode) node = parse_node();
+  if (node == (EggNode *)NULL) {
+    fail();
+    _pending.clear();
+    return NULL;
+  }
+
+  if (!_pending.empty()) {
+    // Return the implicitly-defined textures first.
+    _pending.push_back(node);
+    node = _pending.front();
+    _pending.pop_front();
+  }
+  return node;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::advance
+//       Access: Private
+//  Description: Scans the next token from the buffer into _token,
+//               following the same rules as lexer.lxx.
+////////////////////////////////////////////////////////////////////
+void EggStreamParser::
+advance() {
+  while (true) {
+    while (_p < _end &&
+           (*_p == ' ' || *_p == '\t' || *_p == '\n' || *_p == '\r')) {
+      ++_p;
+    }
+
+    if (_p >= _end) {
+      _token._type = TT_eof;
+      return;
+    }
+
+    char c = *_p;
+    if (c == '{') {
+      ++_p;
+      _token._type = TT_open;
+      return;
+    }
+    if (c == '}') {
+      ++_p;
+      _token._type = TT_close;
+      return;
+    }
+
+    if (c == '"') {
+      // A quoted string runs to the next quotation mark; there are no
+      // escape sequences.
+      const char *start = ++_p;
+      while (_p < _end && *_p != '"') {
+        ++_p;
+      }
+      if (_p >= _end) {
+        // Unterminated.
+        fail();
+        _token._type = TT_eof;
+        return;
+      }
+      _token._type = TT_string;
+      _token._text = start;
+      _token._length = _p - start;
+      ++_p;
+      return;
+    }
+
+    // Anything else is an unquoted string, which may turn out to be a
+    // keyword, a number, or a comment.
+    const char *start = _p;
+    while (_p < _end && !is_delimiter(*_p)) {
+      ++_p;
+    }
+
+    if (_p - start >= 2 && start[0] == '/' && start[1] == '/') {
+      // A C++-style comment runs to the end of the line.
+      _p = start + 2;
+      while (_p < _end && *_p != '\n') {
+        ++_p;
+      }
+      continue;
+    }
+
+    if (_p - start == 2 && start[0] == '/' && start[1] == '*') {
+      // A C-style comment.  The lexer warns about nested comments, so
+      // we leave those to it.
+      char last_c = '\0';
+      while (_p < _end && !(last_c == '*' && *_p == '/')) {
+        if (last_c == '/' && *_p == '*') {
+          fail();
+        }
+        last_c = *_p;
+        ++_p;
+      }
+      if (_p >= _end) {
+        // Unclosed.
+        fail();
+        _token._type = TT_eof;
+        return;
+      }
+      ++_p;
+      continue;
+    }
+
+    scan_word(start, _p);
+    return;
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::scan_word
+//       Access: Private
+//  Description: Classifies the unquoted string between start and
+//               end, and stores the appropriate token in _token.
+////////////////////////////////////////////////////////////////////
+void EggStreamParser::
+scan_word(const char *start, const char *end) {
+  _token._text = start;
+  _token._length = end - start;
+
+  if (start[0] == '<' && end - start > 2 && end[-1] == '>') {
+    if (lookup_keyword(start + 1, end - start - 2, _token._keyword)) {
+      _token._type = TT_keyword;
+      return;
+    }
+
+  } else if (is_digit(start[0]) || start[0] == '-' || start[0] == '+' ||
+             start[0] == '.') {
+    if (scan_number(start, end)) {
+      _token._type = TT_number;
+      return;
+    }
+    if (scan_special(start, end)) {
+      return;
+    }
+
+  } else if (start[0] == 'i' || start[0] == 'I' ||
+             start[0] == 'n' || start[0] == 'N') {
+    if (scan_special(start, end)) {
+      return;
+    }
+  }
+
+  _token._type = TT_string;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::scan_number
+//       Access: Private
+//  Description: If the indicated word matches the lexer's NUMERIC
+//               pattern, stores its value in _token._number and
+//               returns true.
+//
+//               The value is computed with exactly the same
+//               arithmetic as pstrtod(), which the lexer uses, so
+//               that the two parsers produce identical results.
+////////////////////////////////////////////////////////////////////
+bool EggStreamParser::
+scan_number(const char *start, const char *end) {
+  const char *p = start;
+
+  char sign = '+';
+  if (*p == '+' || *p == '-') {
+    sign = *p;
+    ++p;
+  }
+
+  double value = 0.0;
+  bool found_digits = false;
+  while (p < end && is_digit(*p)) {
+    value = (value * 10.0) + (*p - '0');
+    found_digits = true;
+    ++p;
+  }
+
+  if (p < end && *p == '.') {
+    ++p;
+    double multiplicand = 0.1;
+    while (p < end && is_digit(*p)) {
+      value += (*p - '0') * multiplicand;
+      ++p;
+      found_digits = true;
+      multiplicand *= 0.1;
+    }
+  }
+
+  if (!found_digits) {
+    return false;
+  }
+
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    ++p;
+    char esign = '+';
+    if (p < end && (*p == '+' || *p == '-')) {
+      esign = *p;
+      ++p;
+    }
+    if (p >= end || !is_digit(*p)) {
+      return false;
+    }
+
+    double evalue = 0.0;
+    while (p < end && is_digit(*p)) {
+      evalue = (evalue * 10.0) + (*p - '0');
+      ++p;
+    }
+
+    if (esign == '-') {
+      value /= pow(10.0, evalue);
+    } else {
+      value *= pow(10.0, evalue);
+    }
+  }
+
+  if (p != end) {
+    return false;
+  }
+
+  if (sign == '-') {
+    value = -value;
+  }
+  _token._number = value;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::scan_special
+//       Access: Private
+//  Description: Recognizes the lexer's less common numeric forms:
+//               hexadecimal and binary integers, and the various
+//               spellings of infinity and not-a-number.  Stores the
+//               appropriate token and returns true if the word is one
+//               of these.
+////////////////////////////////////////////////////////////////////
+bool EggStreamParser::
+scan_special(const char *start, const char *end) {
+  // These are rare enough that we don't mind making a copy.
+  string word(start, end - start);
+  string lower = downcase(word);
+  size_t length = lower.length();
+
+  if (length >= 2 && lower[0] == '0' && (lower[1] == 'x' || lower[1] == 'b')) {
+    const char *digits = (lower[1] == 'x') ? "0123456789abcdef" : "01";
+    if (lower.find_first_not_of(digits, 2) != string::npos) {
+      return false;
+    }
+    _token._type = TT_ulong;
+    _token._ulong = strtoul(word.c_str() + 2, NULL, (lower[1] == 'x') ? 16 : 2);
+    return true;
+  }
+
+  if (length >= 5 && lower.substr(0, 5) == "nan0x") {
+    if (lower.find_first_not_of("0123456789abcdef", 5) != string::npos) {
+      return false;
+    }
+    double value;
+    memset(&value, 0, sizeof(value));
+    unsigned long bits = strtoul(word.c_str() + 3, NULL, 0);
+    memcpy(&value, &bits, sizeof(bits));
+    _token._type = TT_number;
+    _token._number = value;
+    return true;
+  }
+
+  if (lower == "inf" || lower == "1.#inf") {
+    _token._type = TT_number;
+    _token._number = HUGE_VAL;
+    return true;
+  }
+
+  if (lower == "-inf" || lower == "-1.#inf") {
+    _token._type = TT_number;
+    _token._number = -HUGE_VAL;
+    return true;
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::lookup_keyword
+//       Access: Private, Static
+//  Description: Looks up the name between the angle brackets of a
+//               <Keyword>, case-insensitively.  Returns true if it is
+//               found, and stores the keyword.
+////////////////////////////////////////////////////////////////////
+bool EggStreamParser::
+lookup_keyword(const char *start, size_t length, Keyword &keyword) {
+  int lo = 0;
+  int hi = _num_keywords;
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    const char *name = _keywords[mid]._name;
+
+    int cmp = 0;
+    size_t i = 0;
+    while (cmp == 0 && i < length && name[i] != '\0') {
+      cmp = toupper((unsigned char)start[i]) - (unsigned char)name[i];
+      ++i;
+    }
+    if (cmp == 0) {
+      if (i < length) {
+        cmp = 1;
+      } else if (name[i] != '\0') {
+        cmp = -1;
+      }
+    }
+
+    if (cmp == 0) {
+      keyword = _keywords[mid]._keyword;
+      return true;
+    } else if (cmp < 0) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::expect
+//       Access: Private
+//  Description: Consumes the current token if it is of the indicated
+//               type (usually an open or close brace) and returns
+//               true, or fails the parse.
+////////////////////////////////////////////////////////////////////
+bool EggStreamParser::
+expect(TokenType type) {
+  if (_token._type != type) {
+    return fail();
+  }
+  advance();
+  return !_failed;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::read_string
+//       Access: Private
+//  Description: Consumes a string (or a number, taken as a string)
+//               and returns true, or fails the parse.  This
+//               corresponds to the grammar's string, required_string,
+//               and required_name rules, none of which may be
+//               omitted in a valid egg file.
+////////////////////////////////////////////////////////////////////
+bool EggStreamParser::
+read_string(string &result) {
+  if (!is_string()) {
+    return fail();
+  }
+  result.assign(_token._text, _token._length);
+  advance();
+  return !_failed;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::read_optional_name
+//       Access: Private
+//  Description: Consumes a string if there is one, or sets the
+//               result to the empty string.
+////////////////////////////////////////////////////////////////////
+bool EggStreamParser::
+read_optional_name(string &result) {
+  if (!is_string()) {
+    result = string();
+    return true;
+  }
+  return read_string(result);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::read_repeated_string
+//       Access: Private
+//  Description: Consumes any number of strings, joined with newlines,
+//               as in a <Comment> or <Tag> body.
+////////////////////////////////////////////////////////////////////
+bool EggStreamParser::
+read_repeated_string(string &result) {
+  result = string();
+  bool first = true;
+  while (is_string()) {
+    if (!first) {
+      result += '\n';
+    }
+    result.append(_token._text, _token._length);
+    first = false;
+    advance();
+  }
+  return !_failed;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::read_real
+//       Access: Private
+//  Description: Consumes a number and returns true, or fails the
+//               parse.
+////////////////////////////////////////////////////////////////////
+bool EggStreamParser::
+read_real(double &result) {
+  if (_token._type == TT_number) {
+    result = _token._number;
+  } else if (_token._type == TT_ulong) {
+    result = _token._ulong;
+  } else {
+    return fail();
+  }
+  advance();
+  return !_failed;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::read_integer
+//       Access: Private
+//  Description: Consumes an integer and returns true, or fails the
+//               parse.  A number with a fractional part earns a
+//               warning from the bison parser, so it fails here.
+////////////////////////////////////////////////////////////////////
+bool EggStreamParser::
+read_integer(int &result) {
+  if (_token._type == TT_number) {
+    result = (int)_token._number;
+    if ((double)result != _token._number) {
+      return fail();
+    }
+  } else if (_token._type == TT_ulong) {
+    result = (int)(double)_token._ulong;
+  } else {
+    return fail();
+  }
+  advance();
+  return !_failed;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::read_reals
+//       Access: Private
+//  Description: Consumes up to max_count numbers into the indicated
+//               array, stopping at the first token that is not a
+//               number.  Returns the number read, or -1 if there
+//               were too many.
+////////////////////////////////////////////////////////////////////
+int EggStreamParser::
+read_reals(double *result, int max_count) {
+  int count = 0;
+  while (is_real()) {
+    if (count >= max_count) {
+      fail();
+      return -1;
+    }
+    read_real(result[count]);
+    ++count;
+  }
+  return _failed ? -1 : count;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::read_scalar
+//       Access: Private
+//  Description: Consumes a <Scalar> name { value } entry; the current
+//               token is the <Scalar> keyword.
+////////////////////////////////////////////////////////////////////
+bool EggStreamParser::
+read_scalar(string &name, ScalarValue &value) {
+  advance();
+  if (!read_string(name) || !expect(TT_open)) {
+    return false;
+  }
+
+  switch (_token._type) {
+  case TT_number:
+    value._number = _token._number;
+    value._ulong = (unsigned long)_token._number;
+    break;
+
+  case TT_ulong:
+    value._number = _token._ulong;
+    value._ulong = _token._ulong;
+    break;
+
+  case TT_string:
+    value._number = 0.0;
+    value._ulong = 0;
+    break;
+
+  default:
+    return fail();
+  }
+  value._string.assign(_token._text, _token._length);
+  advance();
+
+  return expect(TT_close);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::read_index_list
+//       Access: Private
+//  Description: Consumes the vertex index numbers of a <VertexRef>
+//               into _indices.
+////////////////////////////////////////////////////////////////////
+bool EggStreamParser::
+read_index_list() {
+  _indices.clear();
+  while (is_real()) {
+    int index;
+    if (!read_integer(index)) {
+      return false;
+    }
+    _indices.push_back(index);
+  }
+  return !_failed;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::read_pool_ref
+//       Access: Private
+//  Description: Consumes the <Ref> { pool } at the end of a
+//               <VertexRef>, including the <VertexRef>'s closing
+//               brace, and returns the named vertex pool.
+////////////////////////////////////////////////////////////////////
+EggVertexPool *EggStreamParser::
+read_pool_ref() {
+  if (!is_keyword(K_ref)) {
+    fail();
+    return NULL;
+  }
+  advance();
+
+  string name;
+  if (!expect(TT_open) || !read_string(name) || !expect(TT_close) ||
+      !expect(TT_close)) {
+    return NULL;
+  }
+
+  VertexPools::const_iterator vpi = _vertex_pools.find(name);
+  if (vpi != _vertex_pools.end()) {
+    return (*vpi).second;
+  }
+
+  // This will become a forward reference.
+  EggVertexPool *pool = new EggVertexPool(name);
+  // The egg syntax starts counting at 1 by convention.
+  pool->set_highest_index(0);
+  _vertex_pools[name] = pool;
+  return pool;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::parse_node
+//       Access: Private
+//  Description: Parses any node that may appear at the top level or
+//               within a group.  Returns NULL on failure.
+////////////////////////////////////////////////////////////////////
+PT(EggNode) EggStreamParser::
+parse_node() {
+  if (is_string()) {
+    // This can only be the obsolete "group <File> { ... }" syntax.
+    if (cmp_nocase_uh(string(_token._text, _token._length), "group") != 0) {
+      fail();
+      return NULL;
+    }
+    advance();
+    if (!is_keyword(K_external_file)) {
+      fail();
+      return NULL;
+    }
+    return parse_external_reference();
+  }
+
+  if (_token._type != TT_keyword) {
+    fail();
+    return NULL;
+  }
+
+  switch (_token._keyword) {
+  case K_coordsystem:
+    return parse_coordsystem();
+
+  case K_comment:
+    return parse_comment();
+
+  case K_texture:
+    return parse_texture();
+
+  case K_material:
+    return parse_material();
+
+  case K_external_file:
+    return parse_external_reference();
+
+  case K_vertexpool:
+    return parse_vertex_pool();
+
+  case K_group:
+  case K_joint:
+  case K_instance:
+    return parse_group();
+
+  case K_polygon:
+  case K_trianglefan:
+  case K_trianglestrip:
+  case K_patch:
+  case K_pointlight:
+  case K_line:
+    return parse_primitive();
+
+  case K_table:
+    return parse_table();
+
+  case K_animpreload:
+    return parse_anim_preload();
+
+  default:
+    // In particular, we don't handle NURBS curves and surfaces; files
+    // that contain them go to the bison parser.
+    fail();
+    return NULL;
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::parse_coordsystem
+//       Access: Private
+//  Description: <CoordinateSystem> { string }
+////////////////////////////////////////////////////////////////////
+PT(EggNode) EggStreamParser::
+parse_coordsystem() {
+  advance();
+  string strval;
+  if (!expect(TT_open) || !read_string(strval) || !expect(TT_close)) {
+    return NULL;
+  }
+
+  CoordinateSystem f = parse_coordinate_system_string(strval);
+  if (f == CS_invalid) {
+    fail();
+    return NULL;
+  }
+
+  PT(EggCoordinateSystem) cs = new EggCoordinateSystem;
+  cs->set_value(f);
+  return cs.p();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::parse_comment
+//       Access: Private
+//  Description: <Comment> [name] { strings }
+////////////////////////////////////////////////////////////////////
+PT(EggNode) EggStreamParser::
+parse_comment() {
+  advance();
+  string name, text;
+  if (!read_optional_name(name) || !expect(TT_open) ||
+      !read_repeated_string(text) || !expect(TT_close)) {
+    return NULL;
+  }
+  return new EggComment(name, text);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::parse_texture
+//       Access: Private
+//  Description: <Texture> name { filename [scalars] [transform] }
+////////////////////////////////////////////////////////////////////
+PT(EggNode) EggStreamParser::
+parse_texture() {
+  advance();
+  string tref_name, filename;
+  if (!read_string(tref_name) || !expect(TT_open) ||
+      !read_string(filename)) {
+    return NULL;
+  }
+
+  if (_textures.find(tref_name) != _textures.end()) {
+    // The bison parser warns about this.
+    fail();
+    return NULL;
+  }
+
+  PT(EggTexture) texture = new EggTexture(tref_name, filename);
+  _textures[tref_name] = texture;
+
+  while (_token._type != TT_close) {
+    if (is_keyword(K_scalar)) {
+      string name;
+      ScalarValue value;
+      if (!read_scalar(name, value) ||
+          !set_texture_scalar(texture, name, value)) {
+        return NULL;
+      }
+
+    } else if (is_keyword(K_transform)) {
+      if (!parse_transform(texture)) {
+        return NULL;
+      }
+
+    } else {
+      fail();
+      return NULL;
+    }
+  }
+  advance();
+
+  if (_failed) {
+    return NULL;
+  }
+  return texture.p();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::set_render_mode_scalar
+//       Access: Private
+//  Description: Applies the scalars shared by textures, groups, and
+//               primitives, which all inherit from EggRenderMode.
+//               Sets handled to true if the name is one of these.
+//               Returns false if the value is invalid.
+////////////////////////////////////////////////////////////////////
+bool EggStreamParser::
+set_render_mode_scalar(EggRenderMode *mode, const string &name,
+                       const ScalarValue &value, int int_value,
+                       bool &handled) {
+  handled = true;
+  const string &strval = value._string;
+
+  if (cmp_nocase_uh(name, "alpha") == 0) {
+    EggRenderMode::AlphaMode a = EggRenderMode::string_alpha_mode(strval);
+    if (a == EggRenderMode::AM_unspecified) {
+      return fail();
+    }
+    mode->set_alpha_mode(a);
+
+  } else if (cmp_nocase_uh(name, "depth_write") == 0) {
+    EggRenderMode::DepthWriteMode m =
+      EggRenderMode::string_depth_write_mode(strval);
+    if (m == EggRenderMode::DWM_unspecified) {
+      return fail();
+    }
+    mode->set_depth_write_mode(m);
+
+  } else if (cmp_nocase_uh(name, "depth_test") == 0) {
+    EggRenderMode::DepthTestMode m =
+      EggRenderMode::string_depth_test_mode(strval);
+    if (m == EggRenderMode::DTM_unspecified) {
+      return fail();
+    }
+    mode->set_depth_test_mode(m);
+
+  } else if (cmp_nocase_uh(name, "visibility") == 0) {
+    EggRenderMode::VisibilityMode m =
+      EggRenderMode::string_visibility_mode(strval);
+    if (m == EggRenderMode::VM_unspecified) {
+      return fail();
+    }
+    mode->set_visibility_mode(m);
+
+  } else if (cmp_nocase_uh(name, "depth_offset") == 0) {
+    mode->set_depth_offset(int_value);
+
+  } else if (cmp_nocase_uh(name, "draw_order") == 0) {
+    mode->set_draw_order(int_value);
+
+  } else if (cmp_nocase_uh(name, "bin") == 0) {
+    mode->set_bin(strval);
+
+  } else {
+    handled = false;
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::set_texture_scalar
+//       Access: Private
+//  Description: Applies one <Scalar> entry of a <Texture>, as the
+//               texture_body rule does.  Returns false (failing the
+//               parse) if the bison parser would have complained.
+////////////////////////////////////////////////////////////////////
+bool EggStreamParser::
+set_texture_scalar(EggTexture *texture, const string &name,
+                   const ScalarValue &value) {
+  double number = value._number;
+  const string &strval = value._string;
+
+  bool handled;
+  if (!set_render_mode_scalar(texture, name, value, (int)number, handled)) {
+    return false;
+  }
+  if (handled) {
+    return true;
+  }
+
+  if (cmp_nocase_uh(name, "type") == 0) {
+    EggTexture::TextureType tt = EggTexture::string_texture_type(strval);
+    if (tt == EggTexture::TT_unspecified) {
+      return fail();
+    }
+    texture->set_texture_type(tt);
+
+  } else if (cmp_nocase_uh(name, "format") == 0) {
+    EggTexture::Format f = EggTexture::string_format(strval);
+    if (f == EggTexture::F_unspecified) {
+      return fail();
+    }
+    texture->set_format(f);
+
+  } else if (cmp_nocase_uh(name, "compression") == 0) {
+    EggTexture::CompressionMode w = EggTexture::string_compression_mode(strval);
+    if (w == EggTexture::CM_default) {
+      return fail();
+    }
+    texture->set_compression_mode(w);
+
+  } else if (cmp_nocase_uh(name, "wrap") == 0 ||
+             cmp_nocase_uh(name, "wrapu") == 0 ||
+             cmp_nocase_uh(name, "wrapv") == 0) {
+    EggTexture::WrapMode w = EggTexture::string_wrap_mode(strval);
+    if (w == EggTexture::WM_unspecified) {
+      return fail();
+    }
+    if (cmp_nocase_uh(name, "wrapu") == 0) {
+      texture->set_wrap_u(w);
+    } else if (cmp_nocase_uh(name, "wrapv") == 0) {
+      texture->set_wrap_v(w);
+    } else {
+      texture->set_wrap_mode(w);
+    }
+
+  } else if (cmp_nocase_uh(name, "minfilter") == 0 ||
+             cmp_nocase_uh(name, "magfilter") == 0) {
+    EggTexture::FilterType f = EggTexture::string_filter_type(strval);
+    if (f == EggTexture::FT_unspecified) {
+      return fail();
+    }
+    if (cmp_nocase_uh(name, "minfilter") == 0) {
+      texture->set_minfilter(f);
+    } else {
+      texture->set_magfilter(f);
+    }
+
+  } else if (cmp_nocase_uh(name, "anisotropic_degree") == 0) {
+    texture->set_anisotropic_degree((int)number);
+
+  } else if (cmp_nocase_uh(name, "envtype") == 0) {
+    EggTexture::EnvType e = EggTexture::string_env_type(strval);
+    if (e == EggTexture::ET_unspecified) {
+      return fail();
+    }
+    texture->set_env_type(e);
+
+  } else if (cmp_nocase_uh(name, "combine-rgb") == 0 ||
+             cmp_nocase_uh(name, "combine-alpha") == 0) {
+    EggTexture::CombineChannel channel =
+      (cmp_nocase_uh(name, "combine-rgb") == 0) ?
+      EggTexture::CC_rgb : EggTexture::CC_alpha;
+    EggTexture::CombineMode cm = EggTexture::string_combine_mode(strval);
+    if (cm == EggTexture::CM_unspecified) {
+      return fail();
+    }
+    texture->set_combine_mode(channel, cm);
+
+  } else if (cmp_nocase_uh(name.substr(0, 8), "combine-") == 0) {
+    // combine-rgb-source0, combine-alpha-operand2, and so on.
+    EggTexture::CombineChannel channel;
+    int index;
+    bool is_source;
+    if (!parse_combine_name(name, channel, index, is_source)) {
+      return fail();
+    }
+
+    if (is_source) {
+      EggTexture::CombineSource cs = EggTexture::string_combine_source(strval);
+      if (cs == EggTexture::CS_unspecified) {
+        return fail();
+      }
+      texture->set_combine_source(channel, index, cs);
+
+    } else {
+      EggTexture::CombineOperand co = EggTexture::string_combine_operand(strval);
+      if (co == EggTexture::CO_unspecified) {
+        return fail();
+      }
+      texture->set_combine_operand(channel, index, co);
+    }
+
+  } else if (cmp_nocase_uh(name, "saved_result") == 0) {
+    texture->set_saved_result(((int)number) != 0);
+
+  } else if (cmp_nocase_uh(name, "tex_gen") == 0) {
+    EggTexture::TexGen tex_gen = EggTexture::string_tex_gen(strval);
+    if (tex_gen == EggTexture::TG_unspecified) {
+      return fail();
+    }
+    texture->set_tex_gen(tex_gen);
+
+  } else if (cmp_nocase_uh(name, "quality_level") == 0) {
+    EggTexture::QualityLevel quality_level = EggTexture::string_quality_level(strval);
+    if (quality_level == EggTexture::QL_unspecified) {
+      return fail();
+    }
+    texture->set_quality_level(quality_level);
+
+  } else if (cmp_nocase_uh(name, "stage_name") == 0) {
+    texture->set_stage_name(strval);
+
+  } else if (cmp_nocase_uh(name, "priority") == 0) {
+    texture->set_priority((int)number);
+
+  } else if (cmp_nocase_uh(name, "multiview") == 0) {
+    texture->set_multiview(((int)number) != 0);
+
+  } else if (cmp_nocase_uh(name, "num_views") == 0) {
+    int int_value = (int)number;
+    if (int_value < 1) {
+      return fail();
+    }
+    texture->set_num_views(int_value);
+
+  } else if (cmp_nocase_uh(name.substr(0, 5), "blend") == 0 &&
+             name.length() == 6) {
+    int n = color_component(name[5]);
+    if (n < 0) {
+      return fail();
+    }
+    LColor color = texture->get_color();
+    color[n] = number;
+    texture->set_color(color);
+
+  } else if (cmp_nocase_uh(name.substr(0, 6), "border") == 0 &&
+             name.length() == 7) {
+    int n = color_component(name[6]);
+    if (n < 0) {
+      return fail();
+    }
+    LColor border_color = texture->get_border_color();
+    border_color[n] = number;
+    texture->set_border_color(border_color);
+
+  } else if (cmp_nocase_uh(name, "uv_name") == 0) {
+    texture->set_uv_name(strval);
+
+  } else if (cmp_nocase_uh(name, "rgb_scale") == 0) {
+    int int_value = (int)number;
+    if (int_value != 1 && int_value != 2 && int_value != 4) {
+      return fail();
+    }
+    texture->set_rgb_scale(int_value);
+
+  } else if (cmp_nocase_uh(name, "alpha_scale") == 0) {
+    int int_value = (int)number;
+    if (int_value != 1 && int_value != 2 && int_value != 4) {
+      return fail();
+    }
+    texture->set_alpha_scale(int_value);
+
+  } else if (cmp_nocase_uh(name, "alpha_file") == 0) {
+    texture->set_alpha_filename(strval);
+
+  } else if (cmp_nocase_uh(name, "alpha_file_channel") == 0) {
+    texture->set_alpha_file_channel((int)number);
+
+  } else if (cmp_nocase_uh(name, "read_mipmaps") == 0) {
+    texture->set_read_mipmaps(((int)number) != 0);
+
+  } else if (cmp_nocase_uh(name, "min_lod") == 0) {
+    texture->set_min_lod(number);
+
+  } else if (cmp_nocase_uh(name, "max_lod") == 0) {
+    texture->set_max_lod(number);
+
+  } else if (cmp_nocase_uh(name, "lod_bias") == 0) {
+    texture->set_lod_bias(number);
+
+  } else {
+    return fail();
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::parse_material
+//       Access: Private
+//  Description: <Material> name { scalars }
+////////////////////////////////////////////////////////////////////
+PT(EggNode) EggStreamParser::
+parse_material() {
+  advance();
+  string mref_name;
+  if (!read_string(mref_name) || !expect(TT_open)) {
+    return NULL;
+  }
+
+  if (_materials.find(mref_name) != _materials.end()) {
+    fail();
+    return NULL;
+  }
+
+  PT(EggMaterial) material = new EggMaterial(mref_name);
+  _materials[mref_name] = material;
+
+  while (is_keyword(K_scalar)) {
+    string name;
+    ScalarValue value;
+    if (!read_scalar(name, value)) {
+      return NULL;
+    }
+    double number = value._number;
+
+    // The color components are named diffr, ambg, speca, and so on.
+    int n = -1;
+    if (name.length() == 5 || name.length() == 4) {
+      n = color_component(name[name.length() - 1]);
+    }
+    string prefix = name.substr(0, name.length() - 1);
+
+    if (n >= 0 && cmp_nocase_uh(prefix, "diff") == 0) {
+      LColor diff = material->get_diff();
+      diff[n] = number;
+      material->set_diff(diff);
+
+    } else if (n >= 0 && cmp_nocase_uh(prefix, "amb") == 0) {
+      LColor amb = material->get_amb();
+      amb[n] = number;
+      material->set_amb(amb);
+
+    } else if (n >= 0 && cmp_nocase_uh(prefix, "emit") == 0) {
+      LColor emit = material->get_emit();
+      emit[n] = number;
+      material->set_emit(emit);
+
+    } else if (n >= 0 && cmp_nocase_uh(prefix, "spec") == 0) {
+      LColor spec = material->get_spec();
+      spec[n] = number;
+      material->set_spec(spec);
+
+    } else if (cmp_nocase_uh(name, "shininess") == 0) {
+      material->set_shininess(number);
+
+    } else if (cmp_nocase_uh(name, "local") == 0) {
+      material->set_local(number != 0.0);
+
+    } else {
+      fail();
+      return NULL;
+    }
+  }
+
+  if (!expect(TT_close)) {
+    return NULL;
+  }
+  return material.p();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::parse_external_reference
+//       Access: Private
+//  Description: <File> [name] { filename }
+////////////////////////////////////////////////////////////////////
+PT(EggNode) EggStreamParser::
+parse_external_reference() {
+  advance();
+  string node_name, filename;
+  if (!read_optional_name(node_name) || !expect(TT_open) ||
+      !read_string(filename) || !expect(TT_close)) {
+    return NULL;
+  }
+  return new EggExternalReference(node_name, filename);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::parse_vertex_pool
+//       Access: Private
+//  Description: <VertexPool> name { vertices }
+////////////////////////////////////////////////////////////////////
+PT(EggNode) EggStreamParser::
+parse_vertex_pool() {
+  advance();
+  string name;
+  if (!read_string(name) || !expect(TT_open)) {
+    return NULL;
+  }
+
+  PT(EggVertexPool) pool;
+  VertexPools::const_iterator vpi = _vertex_pools.find(name);
+  if (vpi != _vertex_pools.end()) {
+    // It has been referenced already, but not defined.
+    pool = (*vpi).second;
+    if (pool->has_defined_vertices()) {
+      // A duplicate vertex pool name; the bison parser warns about
+      // this.
+      fail();
+      return NULL;
+    }
+  } else {
+    pool = new EggVertexPool(name);
+    // The egg syntax starts counting at 1 by convention.
+    pool->set_highest_index(0);
+    _vertex_pools[name] = pool;
+  }
+
+  while (is_keyword(K_vertex)) {
+    if (!parse_vertex(pool)) {
+      return NULL;
+    }
+  }
+
+  if (!expect(TT_close)) {
+    return NULL;
+  }
+  return pool.p();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::parse_vertex
+//       Access: Private
+//  Description: <Vertex> [index] { x [y [z [w]]] [attributes] }
+////////////////////////////////////////////////////////////////////
+bool EggStreamParser::
+parse_vertex(EggVertexPool *pool) {
+  advance();
+
+  int index = -1;
+  if (is_real()) {
+    if (!read_integer(index)) {
+      return false;
+    }
+    if (index < 0 || pool->has_vertex(index)) {
+      // The bison parser warns about these, and ignores the vertex.
+      return fail();
+    }
+  }
+
+  if (!expect(TT_open)) {
+    return false;
+  }
+
+  PT(EggVertex) vertex = new EggVertex;
+
+  double pos[4];
+  int num_pos = read_reals(pos, 4);
+  switch (num_pos) {
+  case 1:
+    vertex->set_pos(pos[0]);
+    break;
+
+  case 2:
+    vertex->set_pos(LPoint2d(pos[0], pos[1]));
+    break;
+
+  case 3:
+    vertex->set_pos(LPoint3d(pos[0], pos[1], pos[2]));
+    break;
+
+  case 4:
+    vertex->set_pos(LPoint4d(pos[0], pos[1], pos[2], pos[3]));
+    break;
+
+  default:
+    return fail();
+  }
+
+  while (_token._type != TT_close) {
+    if (_token._type != TT_keyword) {
+      return fail();
+    }
+
+    switch (_token._keyword) {
+    case K_uv:
+      if (!parse_vertex_uv(vertex)) {
+        return false;
+      }
+      break;
+
+    case K_aux:
+      if (!parse_vertex_aux(vertex)) {
+        return false;
+      }
+      break;
+
+    case K_normal:
+      if (!parse_normal(vertex)) {
+        return false;
+      }
+      break;
+
+    case K_rgba:
+      if (!parse_color(vertex)) {
+        return false;
+      }
+      break;
+
+    case K_dxyz:
+      {
+        string name;
+        double d[3];
+        if (parse_morph(name, d, 3, 3) < 0) {
+          return false;
+        }
+        if (!vertex->_dxyzs.insert(EggMorphVertex(name, LVector3d(d[0], d[1], d[2]))).second) {
+          return fail();
+        }
+      }
+      break;
+
+    default:
+      return fail();
+    }
+  }
+  advance();
+  if (_failed) {
+    return false;
+  }
+
+  if (index == -1) {
+    pool->add_vertex(vertex);
+  } else {
+    pool->add_vertex(vertex, index);
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::parse_vertex_uv
+//       Access: Private
+//  Description: <UV> [name] { u v [w] [tangent] [binormal] [morphs] }
+////////////////////////////////////////////////////////////////////
+bool EggStreamParser::
+parse_vertex_uv(EggVertex *vertex) {
+  advance();
+  string name;
+  if (!read_optional_name(name) || !expect(TT_open)) {
+    return false;
+  }
+
+  if (vertex->has_uv(name)) {
+    return fail();
+  }
+  PT(EggVertexUV) uv = new EggVertexUV(name, LTexCoordd::zero());
+  vertex->set_uv_obj(uv);
+
+  double d[3];
+  int num_uv = read_reals(d, 3);
+  if (num_uv == 2) {
+    uv->set_uv(LTexCoordd(d[0], d[1]));
+  } else if (num_uv == 3) {
+    uv->set_uvw(LVecBase3d(d[0], d[1], d[2]));
+  } else {
+    return fail();
+  }
+
+  while (_token._type != TT_close) {
+    if (is_keyword(K_tangent) || is_keyword(K_binormal)) {
+      bool is_tangent = is_keyword(K_tangent);
+      advance();
+      if (!expect(TT_open) || read_reals(d, 3) != 3 || !expect(TT_close)) {
+        return fail();
+      }
+      if (is_tangent) {
+        if (uv->has_tangent()) {
+          return fail();
+        }
+        uv->set_tangent(LNormald(d[0], d[1], d[2]));
+      } else {
+        if (uv->has_binormal()) {
+          return fail();
+        }
+        uv->set_binormal(LNormald(d[0], d[1], d[2]));
+      }
+
+    } else if (is_keyword(K_duv)) {
+      string morph_name;
+      int count = parse_morph(morph_name, d, 2, 3);
+      if (count < 0) {
+        return false;
+      }
+      LVector3d duv(d[0], d[1], (count == 3) ? d[2] : 0.0);
+      if (!uv->_duvs.insert(EggMorphTexCoord(morph_name, duv)).second) {
+        return fail();
+      }
+
+    } else {
+      return fail();
+    }
+  }
+  advance();
+  return !_failed;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::parse_vertex_aux
+//       Access: Private
+//  Description: <Aux> name { [x y z w] }
+////////////////////////////////////////////////////////////////////
+bool EggStreamParser::
+parse_vertex_aux(EggVertex *vertex) {
+  advance();
+  string name;
+  if (!read_string(name) || !expect(TT_open)) {
+    return false;
+  }
+
+  if (vertex->has_aux(name)) {
+    return fail();
+  }
+  PT(EggVertexAux) aux = new EggVertexAux(name, LVecBase4d::zero());
+  vertex->set_aux_obj(aux);
+
+  double d[4];
+  int count = read_reals(d, 4);
+  if (count == 4) {
+    aux->set_aux(LVecBase4d(d[0], d[1], d[2], d[3]));
+  } else if (count != 0) {
+    return fail();
+  }
+
+  return expect(TT_close);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::parse_normal
+//       Access: Private
+//  Description: <Normal> { x y z [morphs] }, on a vertex or a
+//               primitive.
+////////////////////////////////////////////////////////////////////
+bool EggStreamParser::
+parse_normal(EggAttributes *attrib) {
+  advance();
+  double d[3];
+  if (!expect(TT_open) || read_reals(d, 3) != 3) {
+    return fail();
+  }
+  attrib->set_normal(LNormald(d[0], d[1], d[2]));
+
+  while (is_keyword(K_dnormal)) {
+    string name;
+    if (parse_morph(name, d, 3, 3) < 0) {
+      return false;
+    }
+    if (!attrib->_dnormals.insert(EggMorphNormal(name, LVector3d(d[0], d[1], d[2]))).second) {
+      return fail();
+    }
+  }
+
+  return expect(TT_close);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::parse_color
+//       Access: Private
+//  Description: <RGBA> { r g b a [morphs] }, on a vertex or a
+//               primitive.
+////////////////////////////////////////////////////////////////////
+bool EggStreamParser::
+parse_color(EggAttributes *attrib) {
+  advance();
+  double d[4];
+  if (!expect(TT_open) || read_reals(d, 4) != 4) {
+    return fail();
+  }
+  attrib->set_color(LColor(d[0], d[1], d[2], d[3]));
+
+  while (is_keyword(K_drgba)) {
+    string name;
+    if (parse_morph(name, d, 4, 4) < 0) {
+      return false;
+    }
+    if (!attrib->_drgbas.insert(EggMorphColor(name, LVector4(d[0], d[1], d[2], d[3]))).second) {
+      return fail();
+    }
+  }
+
+  return expect(TT_close);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::parse_morph
+//       Access: Private
+//  Description: Parses a morph offset, which may be given in either
+//               of two forms: <Dxyz> name { x y z } or
+//               <Dxyz> { name x y z }.  Returns the number of values
+//               read, which must be between min_count and max_count,
+//               or -1 on failure.
+////////////////////////////////////////////////////////////////////
+int EggStreamParser::
+parse_morph(string &name, double *values, int min_count, int max_count) {
+  advance();
+  if (is_string()) {
+    if (!read_string(name) || !expect(TT_open)) {
+      return -1;
+    }
+  } else {
+    if (!expect(TT_open) || !read_string(name)) {
+      return -1;
+    }
+  }
+
+  int count = read_reals(values, max_count);
+  if (count < min_count || !expect(TT_close)) {
+    fail();
+    return -1;
+  }
+  return count;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::parse_group
+//       Access: Private
+//  Description: <Group>, <Joint>, or <Instance> [name] { body }
+////////////////////////////////////////////////////////////////////
+PT(EggNode) EggStreamParser::
+parse_group() {
+  Keyword keyword = _token._keyword;
+  advance();
+
+  string name;
+  if (!read_optional_name(name) || !expect(TT_open)) {
+    return NULL;
+  }
+
+  PT(EggGroup) group = new EggGroup(name);
+  if (keyword == K_joint) {
+    group->set_group_type(EggGroup::GT_joint);
+  } else if (keyword == K_instance) {
+    group->set_group_type(EggGroup::GT_instance);
+  }
+
+  while (_token._type != TT_close) {
+    if (!parse_group_entry(group)) {
+      return NULL;
+    }
+  }
+  advance();
+  if (_failed) {
+    return NULL;
+  }
+
+  if (keyword != K_joint && group->has_name()) {
+    _groups[group->get_name()] = group;
+  }
+  if (keyword == K_group) {
+    Thread::consider_yield();
+  }
+  return group.p();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::parse_group_entry
+//       Access: Private
+//  Description: Parses one entry of a group body: an attribute of the
+//               group, or a child node.
+////////////////////////////////////////////////////////////////////
+bool EggStreamParser::
+parse_group_entry(EggGroup *group) {
+  if (_token._type != TT_keyword) {
+    PT(EggNode) child = parse_node();
+    if (child == (EggNode *)NULL) {
+      return false;
+    }
+    group->add_child(child);
+    return true;
+  }
+
+  switch (_token._keyword) {
+  case K_scalar:
+    {
+      string name;
+      ScalarValue value;
+      return read_scalar(name, value) && set_group_scalar(group, name, value);
+    }
+
+  case K_billboard:
+    {
+      advance();
+      string strval;
+      if (!expect(TT_open) || !read_string(strval) || !expect(TT_close)) {
+        return false;
+      }
+      EggGroup::BillboardType f = EggGroup::string_billboard_type(strval);
+      if (f == EggGroup::BT_none) {
+        return fail();
+      }
+      group->set_billboard_type(f);
+    }
+    return true;
+
+  case K_billboardcenter:
+    {
+      advance();
+      double d[3];
+      if (!expect(TT_open) || read_reals(d, 3) != 3 || !expect(TT_close)) {
+        return fail();
+      }
+      group->set_billboard_center(LPoint3d(d[0], d[1], d[2]));
+    }
+    return true;
+
+  case K_collide:
+    {
+      advance();
+      string name, strval;
+      if (!read_optional_name(name) || !expect(TT_open) ||
+          !read_string(strval)) {
+        return false;
+      }
+      EggGroup::CollisionSolidType f = EggGroup::string_cs_type(strval);
+      if (f == EggGroup::CST_none) {
+        return fail();
+      }
+      if (f == EggGroup::CST_polyset && group->get_cs_type() != EggGroup::CST_none) {
+        // By convention, a CST_polyset doesn't replace any existing
+        // contradictory type.
+      } else {
+        group->set_cs_type(f);
+      }
+
+      while (is_string()) {
+        read_string(strval);
+        EggGroup::CollideFlags flags = EggGroup::string_collide_flags(strval);
+        if (flags == EggGroup::CF_none) {
+          return fail();
+        }
+        group->set_collide_flags(group->get_collide_flags() | flags);
+      }
+      if (!expect(TT_close)) {
+        return false;
+      }
+      group->set_collision_name(name);
+    }
+    return true;
+
+  case K_dcs:
+  case K_dart:
+    {
+      bool is_dcs = is_keyword(K_dcs);
+      advance();
+      if (!expect(TT_open)) {
+        return false;
+      }
+      if (_token._type == TT_string) {
+        // The special flavor, with { sync } or { nosync }.
+        string strval;
+        read_string(strval);
+        if (is_dcs) {
+          EggGroup::DCSType f = EggGroup::string_dcs_type(strval);
+          if (f == EggGroup::DC_unspecified) {
+            return fail();
+          }
+          group->set_dcs_type(f);
+        } else {
+          EggGroup::DartType f = EggGroup::string_dart_type(strval);
+          if (f == EggGroup::DT_none) {
+            return fail();
+          }
+          group->set_dart_type(f);
+        }
+      } else {
+        // The traditional flavor, with { 0 } or { 1 }.
+        int value;
+        if (!read_integer(value)) {
+          return false;
+        }
+        if (is_dcs) {
+          group->set_dcs_type(value != 0 ? EggGroup::DC_default : EggGroup::DC_none);
+        } else {
+          group->set_dart_type(value != 0 ? EggGroup::DT_default : EggGroup::DT_none);
+        }
+      }
+    }
+    return expect(TT_close);
+
+  case K_switch:
+  case K_model:
+  case K_texlist:
+    {
+      Keyword keyword = _token._keyword;
+      advance();
+      int value;
+      if (!expect(TT_open) || !read_integer(value) || !expect(TT_close)) {
+        return false;
+      }
+      if (keyword == K_switch) {
+        group->set_switch_flag(value != 0);
+      } else if (keyword == K_model) {
+        group->set_model_flag(value != 0);
+      } else {
+        group->set_texlist_flag(value != 0);
+      }
+    }
+    return true;
+
+  case K_objecttype:
+    {
+      advance();
+      string type;
+      if (!expect(TT_open) || !read_string(type) || !expect(TT_close)) {
+        return false;
+      }
+      group->add_object_type(type);
+    }
+    return true;
+
+  case K_tag:
+    {
+      advance();
+      string key, value;
+      if (!read_optional_name(key) || !expect(TT_open) ||
+          !read_repeated_string(value) || !expect(TT_close)) {
+        return false;
+      }
+      group->set_tag(key, value);
+    }
+    return true;
+
+  case K_transform:
+    return parse_transform(group);
+
+  case K_defaultpose:
+    if (group->get_group_type() != EggGroup::GT_joint) {
+      return fail();
+    }
+    return parse_transform(&group->modify_default_pose());
+
+  case K_vertexref:
+    return parse_group_vertex_ref(group);
+
+  case K_switchcondition:
+    {
+      advance();
+      if (!expect(TT_open) || !is_keyword(K_distance)) {
+        return fail();
+      }
+      advance();
+      double d[3], c[3];
+      int count;
+      if (!expect(TT_open) || (count = read_reals(d, 3)) < 2 ||
+          !is_keyword(K_vertex)) {
+        return fail();
+      }
+      advance();
+      if (!expect(TT_open) || read_reals(c, 3) != 3 || !expect(TT_close) ||
+          !expect(TT_close) || !expect(TT_close)) {
+        return fail();
+      }
+      if (count == 3) {
+        group->set_lod(EggSwitchConditionDistance(d[0], d[1], LPoint3d(c[0], c[1], c[2]), d[2]));
+      } else {
+        group->set_lod(EggSwitchConditionDistance(d[0], d[1], LPoint3d(c[0], c[1], c[2])));
+      }
+    }
+    return true;
+
+  case K_ref:
+    {
+      advance();
+      string name;
+      if (!expect(TT_open) || !read_string(name) || !expect(TT_close)) {
+        return false;
+      }
+      if (group->get_group_type() != EggGroup::GT_instance) {
+        return fail();
+      }
+      Groups::const_iterator gi = _groups.find(name);
+      if (gi == _groups.end()) {
+        return fail();
+      }
+      group->add_group_ref((*gi).second);
+    }
+    return true;
+
+  default:
+    {
+      PT(EggNode) child = parse_node();
+      if (child == (EggNode *)NULL) {
+        return false;
+      }
+      group->add_child(child);
+    }
+    return true;
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::set_group_scalar
+//       Access: Private
+//  Description: Applies one <Scalar> entry of a group, as the
+//               group_body rule does.
+////////////////////////////////////////////////////////////////////
+bool EggStreamParser::
+set_group_scalar(EggGroup *group, const string &name,
+                 const ScalarValue &value) {
+  double number = value._number;
+  unsigned long ulong_value = value._ulong;
+  const string &strval = value._string;
+
+  bool handled;
+  if (!set_render_mode_scalar(group, name, value, ulong_value, handled)) {
+    return false;
+  }
+  if (handled) {
+    return true;
+  }
+
+  if (cmp_nocase_uh(name, "fps") == 0) {
+    group->set_switch_fps(number);
+
+  } else if (cmp_nocase_uh(name, "no_fog") == 0) {
+    group->set_nofog_flag(number != 0);
+
+  } else if (cmp_nocase_uh(name, "decal") == 0) {
+    group->set_decal_flag(number != 0);
+
+  } else if (cmp_nocase_uh(name, "direct") == 0) {
+    group->set_direct_flag(number != 0);
+
+  } else if (cmp_nocase_uh(name, "collide_mask") == 0) {
+    group->set_collide_mask(group->get_collide_mask() | ulong_value);
+
+  } else if (cmp_nocase_uh(name, "from_collide_mask") == 0) {
+    group->set_from_collide_mask(group->get_from_collide_mask() | ulong_value);
+
+  } else if (cmp_nocase_uh(name, "into_collide_mask") == 0) {
+    group->set_into_collide_mask(group->get_into_collide_mask() | ulong_value);
+
+  } else if (cmp_nocase_uh(name, "portal") == 0) {
+    group->set_portal_flag(number != 0);
+
+  } else if (cmp_nocase_uh(name, "occluder") == 0) {
+    group->set_occluder_flag(number != 0);
+
+  } else if (cmp_nocase_uh(name, "polylight") == 0) {
+    group->set_polylight_flag(number != 0);
+
+  } else if (cmp_nocase_uh(name, "indexed") == 0) {
+    group->set_indexed_flag(number != 0);
+
+  } else if (cmp_nocase_uh(name, "scroll_u") == 0) {
+    group->set_scroll_u(number);
+
+  } else if (cmp_nocase_uh(name, "scroll_v") == 0) {
+    group->set_scroll_v(number);
+
+  } else if (cmp_nocase_uh(name, "scroll_w") == 0) {
+    group->set_scroll_w(number);
+
+  } else if (cmp_nocase_uh(name, "scroll_r") == 0) {
+    group->set_scroll_r(number);
+
+  } else if (cmp_nocase_uh(name, "blend") == 0) {
+    EggGroup::BlendMode blend_mode = EggGroup::string_blend_mode(strval);
+    if (blend_mode == EggGroup::BM_unspecified) {
+      return fail();
+    }
+    group->set_blend_mode(blend_mode);
+
+  } else if (cmp_nocase_uh(name, "blendop_a") == 0 ||
+             cmp_nocase_uh(name, "blendop_b") == 0) {
+    EggGroup::BlendOperand blend_operand = EggGroup::string_blend_operand(strval);
+    if (blend_operand == EggGroup::BO_unspecified) {
+      return fail();
+    }
+    if (cmp_nocase_uh(name, "blendop_a") == 0) {
+      group->set_blend_operand_a(blend_operand);
+    } else {
+      group->set_blend_operand_b(blend_operand);
+    }
+
+  } else if (cmp_nocase_uh(name.substr(0, 5), "blend") == 0 &&
+             name.length() == 6 && color_component(name[5]) >= 0) {
+    LColor color = group->get_blend_color();
+    color[color_component(name[5])] = number;
+    group->set_blend_color(color);
+
+  } else {
+    return fail();
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::parse_group_vertex_ref
+//       Access: Private
+//  Description: <VertexRef> { indices [membership] <Ref> { pool } }
+//               within a group.
+////////////////////////////////////////////////////////////////////
+bool EggStreamParser::
+parse_group_vertex_ref(EggGroup *group) {
+  advance();
+  if (!expect(TT_open) || !read_index_list()) {
+    return false;
+  }
+
+  double membership = 1.0;
+  while (is_keyword(K_scalar)) {
+    string name;
+    ScalarValue value;
+    if (!read_scalar(name, value)) {
+      return false;
+    }
+    if (cmp_nocase_uh(name, "membership") != 0) {
+      return fail();
+    }
+    membership = value._number;
+  }
+
+  EggVertexPool *pool = read_pool_ref();
+  if (pool == (EggVertexPool *)NULL) {
+    return false;
+  }
+
+  pvector<int>::const_iterator ii;
+  for (ii = _indices.begin(); ii != _indices.end(); ++ii) {
+    if ((*ii) < 0) {
+      return fail();
+    }
+    group->ref_vertex(pool->get_forward_vertex(*ii), membership);
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::parse_transform
+//       Access: Private
+//  Description: <Transform> { components }, or the equivalent
+//               <DefaultPose>.
+////////////////////////////////////////////////////////////////////
+bool EggStreamParser::
+parse_transform(EggTransform *transform) {
+  advance();
+  if (!expect(TT_open)) {
+    return false;
+  }
+  transform->clear_transform();
+
+  while (_token._type != TT_close) {
+    if (_token._type != TT_keyword) {
+      return fail();
+    }
+    Keyword keyword = _token._keyword;
+    advance();
+
+    double d[16];
+    if (!expect(TT_open)) {
+      return false;
+    }
+    int count = read_reals(d, 16);
+    if (count < 0 || !expect(TT_close)) {
+      return fail();
+    }
+
+    switch (keyword) {
+    case K_translate:
+      if (count == 2) {
+        transform->add_translate2d(LVector2d(d[0], d[1]));
+      } else if (count == 3) {
+        transform->add_translate3d(LVector3d(d[0], d[1], d[2]));
+      } else {
+        return fail();
+      }
+      break;
+
+    case K_rotate:
+      if (count == 1) {
+        transform->add_rotate2d(d[0]);
+      } else if (count == 4) {
+        transform->add_rotate3d(d[0], LVector3d(d[1], d[2], d[3]));
+      } else {
+        return fail();
+      }
+      break;
+
+    case K_rotx:
+    case K_roty:
+    case K_rotz:
+      if (count != 1) {
+        return fail();
+      }
+      if (keyword == K_rotx) {
+        transform->add_rotx(d[0]);
+      } else if (keyword == K_roty) {
+        transform->add_roty(d[0]);
+      } else {
+        transform->add_rotz(d[0]);
+      }
+      break;
+
+    case K_scale:
+      if (count == 1) {
+        transform->add_uniform_scale(d[0]);
+      } else if (count == 2) {
+        transform->add_scale2d(LVecBase2d(d[0], d[1]));
+      } else if (count == 3) {
+        transform->add_scale3d(LVecBase3d(d[0], d[1], d[2]));
+      } else {
+        return fail();
+      }
+      break;
+
+    case K_matrix3:
+      if (count == 9) {
+        transform->add_matrix3(LMatrix3d(d[0], d[1], d[2],
+                                         d[3], d[4], d[5],
+                                         d[6], d[7], d[8]));
+      } else if (count != 0) {
+        return fail();
+      }
+      break;
+
+    case K_matrix4:
+      if (count == 16) {
+        transform->add_matrix4(LMatrix4d(d[0], d[1], d[2], d[3],
+                                         d[4], d[5], d[6], d[7],
+                                         d[8], d[9], d[10], d[11],
+                                         d[12], d[13], d[14], d[15]));
+      } else if (count != 0) {
+        return fail();
+      }
+      break;
+
+    default:
+      return fail();
+    }
+  }
+
+  advance();
+  return !_failed;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::parse_primitive
+//       Access: Private
+//  Description: <Polygon>, <TriangleFan>, <TriangleStrip>, <Patch>,
+//               <PointLight>, or <Line> [name] { body }
+////////////////////////////////////////////////////////////////////
+PT(EggNode) EggStreamParser::
+parse_primitive() {
+  Keyword keyword = _token._keyword;
+  advance();
+
+  string name;
+  if (!read_optional_name(name) || !expect(TT_open)) {
+    return NULL;
+  }
+
+  PT(EggPrimitive) prim;
+  switch (keyword) {
+  case K_polygon:
+    prim = new EggPolygon(name);
+    break;
+
+  case K_trianglefan:
+    prim = new EggTriangleFan(name);
+    break;
+
+  case K_trianglestrip:
+    prim = new EggTriangleStrip(name);
+    break;
+
+  case K_patch:
+    prim = new EggPatch(name);
+    break;
+
+  case K_pointlight:
+    prim = new EggPoint(name);
+    break;
+
+  default:
+    prim = new EggLine(name);
+    break;
+  }
+
+  while (_token._type != TT_close) {
+    if (is_keyword(K_component)) {
+      if (!parse_component(prim)) {
+        return NULL;
+      }
+    } else if (!parse_primitive_entry(prim)) {
+      return NULL;
+    }
+  }
+  advance();
+
+  if (_failed) {
+    return NULL;
+  }
+  return prim.p();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::parse_component
+//       Access: Private
+//  Description: <Component> index { [normal] [color] }, within a
+//               composite primitive.
+////////////////////////////////////////////////////////////////////
+bool EggStreamParser::
+parse_component(EggPrimitive *prim) {
+  advance();
+  int index;
+  if (!read_integer(index) || !expect(TT_open)) {
+    return false;
+  }
+
+  if (!prim->is_of_type(EggCompositePrimitive::get_class_type())) {
+    return fail();
+  }
+  EggCompositePrimitive *comp = DCAST(EggCompositePrimitive, prim);
+  if (index < 0 || index >= comp->get_num_components()) {
+    return fail();
+  }
+
+  // As in the bison parser, a temporary EggPolygon receives the
+  // component attributes.
+  PT(EggPrimitive) attrib = new EggPolygon;
+  while (_token._type != TT_close) {
+    if (is_keyword(K_normal)) {
+      if (!parse_normal(attrib)) {
+        return false;
+      }
+    } else if (is_keyword(K_rgba)) {
+      if (!parse_color(attrib)) {
+        return false;
+      }
+    } else {
+      return fail();
+    }
+  }
+  advance();
+
+  comp->set_component(index, attrib);
+  return !_failed;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::parse_primitive_entry
+//       Access: Private
+//  Description: Parses one entry of a primitive body, other than a
+//               <Component>.
+////////////////////////////////////////////////////////////////////
+bool EggStreamParser::
+parse_primitive_entry(EggPrimitive *prim) {
+  if (_token._type != TT_keyword) {
+    return fail();
+  }
+
+  switch (_token._keyword) {
+  case K_vertexref:
+    {
+      advance();
+      if (!expect(TT_open) || !read_index_list()) {
+        return false;
+      }
+      EggVertexPool *pool = read_pool_ref();
+      if (pool == (EggVertexPool *)NULL) {
+        return false;
+      }
+
+      pvector<int>::const_iterator ii;
+      for (ii = _indices.begin(); ii != _indices.end(); ++ii) {
+        if ((*ii) < 0) {
+          return fail();
+        }
+        prim->add_vertex(pool->get_forward_vertex(*ii));
+      }
+    }
+    return true;
+
+  case K_tref:
+    {
+      advance();
+      string name;
+      if (!expect(TT_open) || !read_string(name) || !expect(TT_close)) {
+        return false;
+      }
+      Textures::const_iterator ti = _textures.find(name);
+      if (ti == _textures.end()) {
+        return fail();
+      }
+      prim->add_texture((*ti).second);
+    }
+    return true;
+
+  case K_texture:
+    {
+      // Defining a texture on-the-fly.
+      advance();
+      string name;
+      if (!expect(TT_open) || !read_string(name) || !expect(TT_close)) {
+        return false;
+      }
+      Filename filename = name;
+      string tref_name = filename.get_basename();
+
+      PT(EggTexture) texture;
+      Textures::const_iterator ti = _textures.find(tref_name);
+      if (ti == _textures.end()) {
+        // The texture was not yet defined.  Define it; it will be
+        // returned by read_node() ahead of the node that contains
+        // this primitive.
+        texture = new EggTexture(tref_name, filename);
+        _textures[tref_name] = texture;
+        _pending.push_back(texture.p());
+
+      } else {
+        texture = (*ti).second;
+        if (filename != texture->get_filename()) {
+          // The bison parser warns about this.
+          return fail();
+        }
+      }
+      prim->add_texture(texture);
+    }
+    return true;
+
+  case K_mref:
+    {
+      advance();
+      string name;
+      if (!expect(TT_open) || !read_string(name) || !expect(TT_close)) {
+        return false;
+      }
+      Materials::const_iterator mi = _materials.find(name);
+      if (mi == _materials.end()) {
+        return fail();
+      }
+      prim->set_material((*mi).second);
+    }
+    return true;
+
+  case K_normal:
+    return parse_normal(prim);
+
+  case K_rgba:
+    return parse_color(prim);
+
+  case K_bface:
+    {
+      advance();
+      int value;
+      if (!expect(TT_open) || !read_integer(value) || !expect(TT_close)) {
+        return false;
+      }
+      prim->set_bface_flag(value != 0);
+    }
+    return true;
+
+  case K_scalar:
+    {
+      string name;
+      ScalarValue value;
+      return read_scalar(name, value) && set_primitive_scalar(prim, name, value);
+    }
+
+  default:
+    return fail();
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::set_primitive_scalar
+//       Access: Private
+//  Description: Applies one <Scalar> entry of a primitive, as the
+//               primitive_body rule does.
+////////////////////////////////////////////////////////////////////
+bool EggStreamParser::
+set_primitive_scalar(EggPrimitive *prim, const string &name,
+                     const ScalarValue &value) {
+  double number = value._number;
+
+  bool handled;
+  if (!set_render_mode_scalar(prim, name, value, (int)number, handled)) {
+    return false;
+  }
+  if (handled) {
+    return true;
+  }
+
+  if (cmp_nocase_uh(name, "thick") == 0) {
+    if (prim->is_of_type(EggLine::get_class_type())) {
+      DCAST(EggLine, prim)->set_thick(number);
+    } else if (prim->is_of_type(EggPoint::get_class_type())) {
+      DCAST(EggPoint, prim)->set_thick(number);
+    } else {
+      return fail();
+    }
+
+  } else if (cmp_nocase_uh(name, "perspective") == 0) {
+    if (!prim->is_of_type(EggPoint::get_class_type())) {
+      return fail();
+    }
+    DCAST(EggPoint, prim)->set_perspective(number != 0);
+
+  } else {
+    return fail();
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::parse_table
+//       Access: Private
+//  Description: <Table> or <Bundle> [name] { children }
+////////////////////////////////////////////////////////////////////
+PT(EggNode) EggStreamParser::
+parse_table() {
+  Keyword keyword = _token._keyword;
+  advance();
+
+  string name;
+  if (!read_optional_name(name) || !expect(TT_open)) {
+    return NULL;
+  }
+
+  PT(EggTable) table = new EggTable(name);
+  table->set_table_type(keyword == K_table ? EggTable::TT_table : EggTable::TT_bundle);
+
+  while (_token._type != TT_close) {
+    if (_token._type != TT_keyword) {
+      fail();
+      return NULL;
+    }
+
+    PT(EggNode) child;
+    switch (_token._keyword) {
+    case K_table:
+    case K_bundle:
+      child = parse_table();
+      break;
+
+    case K_sanim:
+      child = parse_sanim();
+      break;
+
+    case K_xfmanim:
+      child = parse_xfmanim();
+      break;
+
+    case K_xfmsanim:
+      child = parse_xfm_s_anim();
+      break;
+
+    default:
+      fail();
+      return NULL;
+    }
+
+    if (child == (EggNode *)NULL) {
+      return NULL;
+    }
+    table->add_child(child);
+  }
+  advance();
+
+  if (_failed) {
+    return NULL;
+  }
+  if (keyword == K_table) {
+    Thread::consider_yield();
+  }
+  return table.p();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::read_table_data
+//       Access: Private
+//  Description: Consumes <V> { numbers }, the data of an animation
+//               table.
+////////////////////////////////////////////////////////////////////
+bool EggStreamParser::
+read_table_data(PTA_double &data) {
+  advance();
+  if (!expect(TT_open)) {
+    return false;
+  }
+
+  data = PTA_double::empty_array(0);
+  while (is_real()) {
+    double value;
+    read_real(value);
+    data.push_back(value);
+  }
+
+  return expect(TT_close);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::parse_sanim
+//       Access: Private
+//  Description: <S$Anim> [name] { [fps] <V> { data } }
+////////////////////////////////////////////////////////////////////
+PT(EggNode) EggStreamParser::
+parse_sanim() {
+  advance();
+  string name;
+  if (!read_optional_name(name) || !expect(TT_open)) {
+    return NULL;
+  }
+
+  PT(EggSAnimData) anim_data = new EggSAnimData(name);
+  while (_token._type != TT_close) {
+    if (is_keyword(K_scalar)) {
+      ScalarValue value;
+      if (!read_scalar(name, value)) {
+        return NULL;
+      }
+      if (cmp_nocase_uh(name, "fps") != 0) {
+        fail();
+        return NULL;
+      }
+      anim_data->set_fps(value._number);
+
+    } else if (is_keyword(K_table_v)) {
+      PTA_double data;
+      if (!read_table_data(data)) {
+        return NULL;
+      }
+      anim_data->set_data(data);
+
+    } else {
+      fail();
+      return NULL;
+    }
+  }
+  advance();
+
+  if (_failed) {
+    return NULL;
+  }
+  return anim_data.p();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::parse_xfmanim
+//       Access: Private
+//  Description: <Xfm$Anim> [name] { [scalars] <V> { data } }
+////////////////////////////////////////////////////////////////////
+PT(EggNode) EggStreamParser::
+parse_xfmanim() {
+  advance();
+  string name;
+  if (!read_optional_name(name) || !expect(TT_open)) {
+    return NULL;
+  }
+
+  PT(EggXfmAnimData) anim_data = new EggXfmAnimData(name);
+  while (_token._type != TT_close) {
+    if (is_keyword(K_scalar)) {
+      ScalarValue value;
+      if (!read_scalar(name, value)) {
+        return NULL;
+      }
+      if (cmp_nocase_uh(name, "fps") == 0) {
+        anim_data->set_fps(value._number);
+      } else if (cmp_nocase_uh(name, "order") == 0) {
+        anim_data->set_order(value._string);
+      } else if (cmp_nocase_uh(name, "contents") == 0) {
+        anim_data->set_contents(value._string);
+      } else {
+        fail();
+        return NULL;
+      }
+
+    } else if (is_keyword(K_table_v)) {
+      PTA_double data;
+      if (!read_table_data(data)) {
+        return NULL;
+      }
+      anim_data->set_data(data);
+
+    } else {
+      fail();
+      return NULL;
+    }
+  }
+  advance();
+
+  if (_failed) {
+    return NULL;
+  }
+  return anim_data.p();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::parse_xfm_s_anim
+//       Access: Private
+//  Description: <Xfm$Anim_S$> [name] { [scalars] <S$Anim> ... }
+////////////////////////////////////////////////////////////////////
+PT(EggNode) EggStreamParser::
+parse_xfm_s_anim() {
+  advance();
+  string name;
+  if (!read_optional_name(name) || !expect(TT_open)) {
+    return NULL;
+  }
+
+  PT(EggXfmSAnim) anim_group = new EggXfmSAnim(name);
+  while (_token._type != TT_close) {
+    if (is_keyword(K_scalar)) {
+      ScalarValue value;
+      if (!read_scalar(name, value)) {
+        return NULL;
+      }
+      if (cmp_nocase_uh(name, "fps") == 0) {
+        anim_group->set_fps(value._number);
+      } else if (cmp_nocase_uh(name, "order") == 0) {
+        anim_group->set_order(value._string);
+      } else {
+        fail();
+        return NULL;
+      }
+
+    } else if (is_keyword(K_sanim)) {
+      PT(EggNode) child = parse_sanim();
+      if (child == (EggNode *)NULL) {
+        return NULL;
+      }
+      anim_group->add_child(child);
+
+    } else {
+      fail();
+      return NULL;
+    }
+  }
+  advance();
+
+  if (_failed) {
+    return NULL;
+  }
+  return anim_group.p();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::parse_anim_preload
+//       Access: Private
+//  Description: <AnimPreload> [name] { scalars }
+////////////////////////////////////////////////////////////////////
+PT(EggNode) EggStreamParser::
+parse_anim_preload() {
+  advance();
+  string name;
+  if (!read_optional_name(name) || !expect(TT_open)) {
+    return NULL;
+  }
+
+  PT(EggAnimPreload) anim_preload = new EggAnimPreload(name);
+  while (is_keyword(K_scalar)) {
+    ScalarValue value;
+    if (!read_scalar(name, value)) {
+      return NULL;
+    }
+    if (cmp_nocase_uh(name, "fps") == 0) {
+      anim_preload->set_fps(value._number);
+    } else if (cmp_nocase_uh(name, "frames") == 0) {
+      anim_preload->set_num_frames((int)value._number);
+    } else {
+      fail();
+      return NULL;
+    }
+  }
+
+  if (!expect(TT_close)) {
+    return NULL;
+  }
+  return anim_preload.p();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::check_vertex_pools
+//       Access: Private
+//  Description: Called at the end of the file to verify that every
+//               vertex referenced was eventually defined.  If not,
+//               fails the parse, so that the bison parser can report
+//               the problem.
+////////////////////////////////////////////////////////////////////
+void EggStreamParser::
+check_vertex_pools() {
+  VertexPools::const_iterator vpi;
+  for (vpi = _vertex_pools.begin(); vpi != _vertex_pools.end(); ++vpi) {
+    if ((*vpi).second->has_forward_vertices()) {
+      fail();
+      return;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::parse_combine_name
+//       Access: Private, Static
+//  Description: Decodes a texture scalar name of the form
+//               combine-rgb-source0 or combine-alpha-operand2.
+//               Returns true if the name is one of these.
+////////////////////////////////////////////////////////////////////
+bool EggStreamParser::
+parse_combine_name(const string &name, EggTexture::CombineChannel &channel,
+                   int &index, bool &is_source) {
+  static const char *const channels[2] = { "rgb", "alpha" };
+  static const char *const kinds[2] = { "source", "operand" };
+
+  for (int c = 0; c < 2; ++c) {
+    for (int k = 0; k < 2; ++k) {
+      for (int i = 0; i < 3; ++i) {
+        ostringstream strm;
+        strm << "combine-" << channels[c] << "-" << kinds[k] << i;
+        if (cmp_nocase_uh(name, strm.str()) == 0) {
+          channel = (c == 0) ? EggTexture::CC_rgb : EggTexture::CC_alpha;
+          is_source = (k == 0);
+          index = i;
+          return true;
+        }
+      }
+    }
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::color_component
+//       Access: Private, Static
+//  Description: Returns 0, 1, 2, or 3 for the suffix letter r, g, b,
+//               or a of a color scalar name like "blendg", or -1 if
+//               the letter is none of these.
+////////////////////////////////////////////////////////////////////
+int EggStreamParser::
+color_component(char suffix) {
+  switch (tolower((unsigned char)suffix)) {
+  case 'r':
+    return 0;
+  case 'g':
+    return 1;
+  case 'b':
+    return 2;
+  case 'a':
+    return 3;
+  default:
+    return -1;
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::FileBuffer::Constructor
+//       Access: Public
+//  Description:
+////////////////////////////////////////////////////////////////////
+EggStreamParser::FileBuffer::
+FileBuffer() :
+  _data(NULL),
+  _size(0),
+  _map(NULL),
+  _map_size(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::FileBuffer::Destructor
+//       Access: Public
+//  Description:
+////////////////////////////////////////////////////////////////////
+EggStreamParser::FileBuffer::
+~FileBuffer() {
+  clear();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::FileBuffer::read
+//       Access: Public
+//  Description: Makes the contents of the indicated file available.
+//               If it is an ordinary uncompressed file on disk, it is
+//               mapped directly into memory; otherwise it is read
+//               into a buffer.  Returns true on success.
+////////////////////////////////////////////////////////////////////
+bool EggStreamParser::FileBuffer::
+read(VirtualFile *vfile) {
+  clear();
+  if (map_file(vfile)) {
+    return true;
+  }
+
+  if (!vfile->read_file(_string, true)) {
+    return false;
+  }
+  _data = _string.data();
+  _size = _string.size();
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::FileBuffer::read
+//       Access: Public
+//  Description: Reads the remaining contents of the indicated stream
+//               into the buffer.  Returns true on success.
+////////////////////////////////////////////////////////////////////
+bool EggStreamParser::FileBuffer::
+read(istream &in) {
+  clear();
+
+  // If the stream can tell us how much remains, we can read it all in
+  // one go.  Otherwise, we read it in increasingly large pieces.  In
+  // either case, the data is read straight into the buffer.
+  size_t chunk_size = 4096;
+  streampos start = in.tellg();
+  if (start != (streampos)-1) {
+    in.seekg(0, ios::end);
+    streampos end = in.tellg();
+    in.seekg(start);
+    if (end != (streampos)-1 && end > start) {
+      chunk_size = (size_t)(end - start);
+    }
+  }
+  in.clear(in.rdstate() & ~ios::failbit);
+
+  size_t size = 0;
+  while (in.good()) {
+    _string.resize(size + chunk_size);
+    in.read(&_string[size], chunk_size);
+    size += in.gcount();
+    if (in.peek() == EOF) {
+      break;
+    }
+    chunk_size = max(chunk_size, size);
+  }
+  _string.resize(size);
+
+  _data = _string.data();
+  _size = _string.size();
+  return !in.bad();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::FileBuffer::clear
+//       Access: Public
+//  Description: Releases the file contents.
+////////////////////////////////////////////////////////////////////
+void EggStreamParser::FileBuffer::
+clear() {
+#ifndef _WIN32
+  if (_map != NULL) {
+    munmap(_map, _map_size);
+  }
+#endif
+  _map = NULL;
+  _map_size = 0;
+  _string = string();
+  _data = NULL;
+  _size = 0;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::FileBuffer::map_file
+//       Access: Private
+//  Description: Attempts to map the indicated file directly into
+//               memory.  This is possible only for a plain file in a
+//               directory mounted from the operating system, which
+//               is not compressed.  Returns true on success.
+////////////////////////////////////////////////////////////////////
+bool EggStreamParser::FileBuffer::
+map_file(VirtualFile *vfile) {
+#ifdef _WIN32
+  // On Windows, we simply read the file into memory.
+  return false;
+
+#else
+  if (!vfile->is_of_type(VirtualFileSimple::get_class_type())) {
+    return false;
+  }
+  VirtualFileMount *mount = DCAST(VirtualFileSimple, vfile)->get_mount();
+  if (!mount->is_of_type(VirtualFileMountSystem::get_class_type())) {
+    return false;
+  }
+
+  SubfileInfo info;
+  if (!vfile->get_system_info(info) ||
+      info.get_filename().get_extension() == "pz" ||
+      info.get_size() <= 0) {
+    return false;
+  }
+
+  string os_specific = info.get_filename().to_os_specific();
+  int fd = open(os_specific.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  // The mapping must begin on a page boundary.
+  off_t start = (off_t)info.get_start();
+  off_t page_size = (off_t)sysconf(_SC_PAGESIZE);
+  off_t page_start = start - (start % page_size);
+  size_t map_size = (size_t)info.get_size() + (size_t)(start - page_start);
+
+  void *map = mmap(NULL, map_size, PROT_READ, MAP_PRIVATE, fd, page_start);
+  close(fd);
+  if (map == MAP_FAILED) {
+    return false;
+  }
+
+#ifdef MADV_SEQUENTIAL
+  madvise(map, map_size, MADV_SEQUENTIAL);
+#endif
+
+  _map = map;
+  _map_size = map_size;
+  _data = (const char *)map + (start - page_start);
+  _size = (size_t)info.get_size();
+  return true;
+#endif  // _WIN32
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggStreamParser::BufferStreamBuf::Constructor
+//       Access: Public
+//  Description: The buffer must remain valid for the lifetime of the
+//               BufferStreamBuf.
+////////////////////////////////////////////////////////////////////
+EggStreamParser::BufferStreamBuf::
+BufferStreamBuf(const char *data, size_t size) {
+  // The streambuf interface wants a non-const pointer, but nothing
+  // writes through the get area.
+  char *begin = (char *)data;
+  setg(begin, begin, begin + size);
+}
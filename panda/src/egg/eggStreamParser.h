@@ -0,0 +1,345 @@
+// Filename: eggStreamParser.h
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef EGGSTREAMPARSER_H
+#define EGGSTREAMPARSER_H
+
+#include "pandabase.h"
+
+#include "eggNode.h"
+#include "eggGroupNode.h"
+#include "eggGroup.h"
+#include "eggVertexPool.h"
+#include "eggTexture.h"
+#include "pt_EggTexture.h"
+#include "pt_EggMaterial.h"
+#include "pta_double.h"
+#include "pointerTo.h"
+#include "pmap.h"
+#include "pvector.h"
+#include "pdeque.h"
+
+class VirtualFile;
+class EggVertex;
+class EggAttributes;
+class EggRenderMode;
+class EggPrimitive;
+class EggTransform;
+
+////////////////////////////////////////////////////////////////////
+//       Class : EggStreamParser
+// Description : A hand-written reader for the egg syntax, which
+//               tokenizes directly from a buffer in memory (usually
+//               the egg file itself, mapped into the address space)
+//               rather than through the flex/bison parser.
+//
+//               It returns the toplevel nodes of the egg file one at
+//               a time, as each is completed, via read_node().  It
+//               shares no static state, so several of these may run
+//               at once in different threads.
+//
+//               It handles only syntactically and semantically clean
+//               egg files.  Whenever it encounters something the
+//               bison parser would complain about, or a construct it
+//               does not support, it stops and reports is_failed();
+//               the caller should then read the same buffer again
+//               with the bison parser, which will issue the
+//               appropriate diagnostics.
+//
+//               This is used internally by EggData::read().
+////////////////////////////////////////////////////////////////////
+class EXPCL_PANDAEGG EggStreamParser {
+public:
+  EggStreamParser(const char *data, size_t size);
+  ~EggStreamParser();
+
+  PT(EggNode) read_node();
+  INLINE bool is_failed() const;
+
+  ////////////////////////////////////////////////////////////////////
+  //       Class : EggStreamParser::FileBuffer
+  // Description : The complete contents of an egg file in memory,
+  //               either mapped directly from disk or read into a
+  //               string, as the file allows.
+  ////////////////////////////////////////////////////////////////////
+  class EXPCL_PANDAEGG FileBuffer {
+  public:
+    FileBuffer();
+    ~FileBuffer();
+
+    bool read(VirtualFile *vfile);
+    bool read(istream &in);
+    void clear();
+
+    INLINE const char *get_data() const;
+    INLINE size_t get_size() const;
+    INLINE bool is_mapped() const;
+
+  private:
+    bool map_file(VirtualFile *vfile);
+
+    string _string;
+    const char *_data;
+    size_t _size;
+
+    void *_map;
+    size_t _map_size;
+
+  private:
+    // Not copyable.
+    FileBuffer(const FileBuffer &copy);
+    void operator = (const FileBuffer &copy);
+  };
+
+  ////////////////////////////////////////////////////////////////////
+  //       Class : EggStreamParser::BufferStreamBuf
+  // Description : A streambuf that reads directly from a buffer in
+  //               memory, without copying it.  This lets the bison
+  //               parser read the same FileBuffer again when the
+  //               stream parser gives up.
+  ////////////////////////////////////////////////////////////////////
+  class EXPCL_PANDAEGG BufferStreamBuf : public streambuf {
+  public:
+    BufferStreamBuf(const char *data, size_t size);
+  };
+
+private:
+  enum TokenType {
+    TT_eof,
+    TT_open,
+    TT_close,
+    TT_number,
+    TT_ulong,
+    TT_string,
+    TT_keyword
+  };
+
+  // One for each distinct token returned by the lexer for a
+  // <Keyword>.
+  enum Keyword {
+    K_animpreload,
+    K_aux,
+    K_beziercurve,
+    K_bface,
+    K_billboard,
+    K_billboardcenter,
+    K_binormal,
+    K_bundle,
+    K_closed,
+    K_collide,
+    K_comment,
+    K_component,
+    K_coordsystem,
+    K_cv,
+    K_dart,
+    K_dnormal,
+    K_drgba,
+    K_duv,
+    K_dxyz,
+    K_dcs,
+    K_distance,
+    K_dtref,
+    K_dynamicvertexpool,
+    K_external_file,
+    K_group,
+    K_defaultpose,
+    K_joint,
+    K_knots,
+    K_include,
+    K_instance,
+    K_line,
+    K_loop,
+    K_material,
+    K_matrix3,
+    K_matrix4,
+    K_model,
+    K_mref,
+    K_normal,
+    K_nurbscurve,
+    K_nurbssurface,
+    K_objecttype,
+    K_order,
+    K_outtangent,
+    K_patch,
+    K_pointlight,
+    K_polygon,
+    K_ref,
+    K_rgba,
+    K_rotate,
+    K_rotx,
+    K_roty,
+    K_rotz,
+    K_sanim,
+    K_scalar,
+    K_scale,
+    K_sequence,
+    K_shading,
+    K_switch,
+    K_switchcondition,
+    K_table,
+    K_table_v,
+    K_tag,
+    K_tangent,
+    K_texlist,
+    K_texture,
+    K_tlengths,
+    K_transform,
+    K_translate,
+    K_tref,
+    K_trianglefan,
+    K_trianglestrip,
+    K_trim,
+    K_txt,
+    K_uknots,
+    K_uv,
+    K_vknots,
+    K_vertex,
+    K_vertexanim,
+    K_vertexpool,
+    K_vertexref,
+    K_xfmanim,
+    K_xfmsanim
+  };
+
+  class Token {
+  public:
+    TokenType _type;
+    Keyword _keyword;
+    double _number;
+    unsigned long _ulong;
+
+    // The text of the token, for strings and numbers.  This points
+    // into the buffer.
+    const char *_text;
+    size_t _length;
+  };
+
+  // The value of a <Scalar> entry, as the bison parser's
+  // real_or_string rule would have returned it.
+  class ScalarValue {
+  public:
+    double _number;
+    unsigned long _ulong;
+    string _string;
+  };
+
+  class KeywordDef {
+  public:
+    const char *_name;
+    Keyword _keyword;
+  };
+
+  // The tokenizer.
+  void advance();
+  void scan_word(const char *start, const char *end);
+  bool scan_number(const char *start, const char *end);
+  bool scan_special(const char *start, const char *end);
+  static bool lookup_keyword(const char *start, size_t length,
+                             Keyword &keyword);
+  INLINE bool is_keyword(Keyword keyword) const;
+  INLINE bool is_string() const;
+  INLINE bool is_real() const;
+  INLINE bool fail();
+
+  // Little pieces of the grammar.
+  bool expect(TokenType type);
+  bool read_string(string &result);
+  bool read_optional_name(string &result);
+  bool read_repeated_string(string &result);
+  bool read_real(double &result);
+  bool read_integer(int &result);
+  int read_reals(double *result, int max_count);
+  bool read_scalar(string &name, ScalarValue &value);
+  bool read_index_list();
+  EggVertexPool *read_pool_ref();
+  bool read_table_data(PTA_double &data);
+
+  // The grammar proper.
+  PT(EggNode) parse_node();
+  PT(EggNode) parse_coordsystem();
+  PT(EggNode) parse_comment();
+  PT(EggNode) parse_texture();
+  bool set_render_mode_scalar(EggRenderMode *mode, const string &name,
+                              const ScalarValue &value, int int_value,
+                              bool &handled);
+  bool set_texture_scalar(EggTexture *texture, const string &name,
+                          const ScalarValue &value);
+  PT(EggNode) parse_material();
+  PT(EggNode) parse_external_reference();
+  PT(EggNode) parse_vertex_pool();
+  bool parse_vertex(EggVertexPool *pool);
+  bool parse_vertex_uv(EggVertex *vertex);
+  bool parse_vertex_aux(EggVertex *vertex);
+  bool parse_normal(EggAttributes *attrib);
+  bool parse_color(EggAttributes *attrib);
+  int parse_morph(string &name, double *values, int min_count,
+                  int max_count);
+  PT(EggNode) parse_group();
+  bool parse_group_entry(EggGroup *group);
+  bool set_group_scalar(EggGroup *group, const string &name,
+                        const ScalarValue &value);
+  bool parse_group_vertex_ref(EggGroup *group);
+  bool parse_transform(EggTransform *transform);
+  PT(EggNode) parse_primitive();
+  bool parse_component(EggPrimitive *prim);
+  bool parse_primitive_entry(EggPrimitive *prim);
+  bool set_primitive_scalar(EggPrimitive *prim, const string &name,
+                            const ScalarValue &value);
+  PT(EggNode) parse_table();
+  PT(EggNode) parse_sanim();
+  PT(EggNode) parse_xfmanim();
+  PT(EggNode) parse_xfm_s_anim();
+  PT(EggNode) parse_anim_preload();
+  void check_vertex_pools();
+
+  static bool parse_combine_name(const string &name,
+                                 EggTexture::CombineChannel &channel,
+                                 int &index, bool &is_source);
+  static int color_component(char suffix);
+
+private:
+  const char *_p;
+  const char *_end;
+
+  Token _token;
+  bool _failed;
+  bool _finished;
+
+  // Scratch space for the vertex indices of a <VertexRef>.
+  pvector<int> _indices;
+
+  // Nodes that have been completed, but not yet returned by
+  // read_node().  These are the textures implicitly defined by a
+  // <Texture> entry within a primitive, which precede the toplevel
+  // node that contains them.
+  typedef pdeque<PT(EggNode) > Pending;
+  Pending _pending;
+
+  // The symbol tables, exactly as maintained by the bison parser.
+  typedef pmap<string, PT(EggVertexPool) > VertexPools;
+  VertexPools _vertex_pools;
+  typedef pmap<string, PT_EggTexture> Textures;
+  Textures _textures;
+  typedef pmap<string, PT_EggMaterial> Materials;
+  Materials _materials;
+  typedef pmap<string, PT(EggGroup) > Groups;
+  Groups _groups;
+
+  static const KeywordDef _keywords[];
+  static const int _num_keywords;
+};
+
+#include "eggStreamParser.I"
+
+#endif
@@ -30,6 +30,7 @@ PUBLISHED:
   INLINE EggTriangleFan(const string &name = "");
   INLINE EggTriangleFan(const EggTriangleFan &copy);
   INLINE EggTriangleFan &operator = (const EggTriangleFan &copy);
+  ALLOC_DELETED_CHAIN(EggTriangleFan);
   virtual ~EggTriangleFan();
 
   virtual void write(ostream &out, int indent_level) const;
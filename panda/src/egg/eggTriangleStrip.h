@@ -30,6 +30,7 @@ PUBLISHED:
   INLINE EggTriangleStrip(const string &name = "");
   INLINE EggTriangleStrip(const EggTriangleStrip &copy);
   INLINE EggTriangleStrip &operator = (const EggTriangleStrip &copy);
+  ALLOC_DELETED_CHAIN(EggTriangleStrip);
   virtual ~EggTriangleStrip();
 
   virtual void write(ostream &out, int indent_level) const;
@@ -28,6 +28,63 @@
 #include <algorithm>
 
 TypeHandle EggVertex::_type_handle;
+const EggVertex::GroupRef EggVertex::_empty_gref;
+
+////////////////////////////////////////////////////////////////////
+//       Class : CompareName
+// Description : An STL function object for searching the vectors of
+//               EggVertexUV or EggVertexAux objects, which are kept
+//               sorted by name.
+////////////////////////////////////////////////////////////////////
+class CompareName {
+public:
+  template<class Pointer>
+  bool operator () (const Pointer &a, const string &b) const {
+    return a->get_name() < b;
+  }
+  template<class Pointer>
+  bool operator () (const string &a, const Pointer &b) const {
+    return a < b->get_name();
+  }
+  template<class Pointer>
+  bool operator () (const Pointer &a, const Pointer &b) const {
+    return a->get_name() < b->get_name();
+  }
+};
+
+////////////////////////////////////////////////////////////////////
+//     Function: find_name
+//  Description: Returns the element of the sorted range with the
+//               indicated name, or end if there is no such element.
+////////////////////////////////////////////////////////////////////
+template<class Iterator>
+static Iterator
+find_name(Iterator begin, Iterator end, const string &name) {
+  Iterator it = lower_bound(begin, end, name, CompareName());
+  if (it != end && (*it)->get_name() == name) {
+    return it;
+  }
+  return end;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: store_named
+//  Description: Stores the indicated object in the sorted vector,
+//               replacing any object already there with the same
+//               name.
+////////////////////////////////////////////////////////////////////
+template<class List, class Object>
+static void
+store_named(List &list, Object *object) {
+  const string &name = object->get_name();
+  TYPENAME List::iterator it =
+    lower_bound(list.begin(), list.end(), name, CompareName());
+  if (it != list.end() && (*it)->get_name() == name) {
+    (*it) = object;
+  } else {
+    list.insert(it, object);
+  }
+}
 
 
 ////////////////////////////////////////////////////////////////////
@@ -38,6 +95,7 @@ TypeHandle EggVertex::_type_handle;
 EggVertex::
 EggVertex() {
   _pool = NULL;
+  _gref = NULL;
   _forward_reference = false;
   _index = -1;
   _external_index = -1;
@@ -61,10 +119,11 @@ EggVertex(const EggVertex &copy)
     _external_index2(copy._external_index2),
     _pos(copy._pos),
     _num_dimensions(copy._num_dimensions),
-    _uv_map(copy._uv_map),
-    _aux_map(copy._aux_map)
+    _uv_list(copy._uv_list),
+    _aux_list(copy._aux_list)
 {
   _pool = NULL;
+  _gref = NULL;
   _forward_reference = false;
   _index = -1;
   test_pref_integrity();
@@ -87,8 +146,8 @@ operator = (const EggVertex &copy) {
   _external_index2 = copy._external_index2;
   _pos = copy._pos;
   _num_dimensions = copy._num_dimensions;
-  _uv_map = copy._uv_map;
-  _aux_map = copy._aux_map;
+  _uv_list = copy._uv_list;
+  _aux_list = copy._aux_list;
 
   test_pref_integrity();
   test_gref_integrity();
@@ -110,7 +169,7 @@ EggVertex::
 
   // Also, a vertex shouldn't be destructed while it's being
   // referenced by a group or a primitive, for the same reason.
-  nassertv(_gref.empty());
+  nassertv(_gref == NULL);
   nassertv(_pref.empty());
 }
 
@@ -123,9 +182,10 @@ EggVertex::
 ////////////////////////////////////////////////////////////////////
 bool EggVertex::
 has_uv(const string &name) const {
-  UVMap::const_iterator ui = _uv_map.find(EggVertexUV::filter_name(name));
-  if (ui != _uv_map.end()) {
-    EggVertexUV *uv_obj = (*ui).second;
+  UVList::const_iterator ui =
+    find_name(_uv_list.begin(), _uv_list.end(), EggVertexUV::filter_name(name));
+  if (ui != _uv_list.end()) {
+    EggVertexUV *uv_obj = (*ui);
     return !uv_obj->has_w();
   }
   return false;
@@ -140,9 +200,10 @@ has_uv(const string &name) const {
 ////////////////////////////////////////////////////////////////////
 bool EggVertex::
 has_uvw(const string &name) const {
-  UVMap::const_iterator ui = _uv_map.find(EggVertexUV::filter_name(name));
-  if (ui != _uv_map.end()) {
-    EggVertexUV *uv_obj = (*ui).second;
+  UVList::const_iterator ui =
+    find_name(_uv_list.begin(), _uv_list.end(), EggVertexUV::filter_name(name));
+  if (ui != _uv_list.end()) {
+    EggVertexUV *uv_obj = (*ui);
     return uv_obj->has_w();
   }
   return false;
@@ -156,12 +217,9 @@ has_uvw(const string &name) const {
 ////////////////////////////////////////////////////////////////////
 bool EggVertex::
 has_aux(const string &name) const {
-  AuxMap::const_iterator xi = _aux_map.find(name);
-  if (xi != _aux_map.end()) {
-    EggVertexAux *aux_obj = (*xi).second;
-    return true;
-  }
-  return false;
+  AuxList::const_iterator xi =
+    find_name(_aux_list.begin(), _aux_list.end(), name);
+  return (xi != _aux_list.end());
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -173,9 +231,10 @@ has_aux(const string &name) const {
 ////////////////////////////////////////////////////////////////////
 LTexCoordd EggVertex::
 get_uv(const string &name) const {
-  UVMap::const_iterator ui = _uv_map.find(EggVertexUV::filter_name(name));
-  nassertr(ui != _uv_map.end(), LTexCoordd::zero());
-  return (*ui).second->get_uv();
+  UVList::const_iterator ui =
+    find_name(_uv_list.begin(), _uv_list.end(), EggVertexUV::filter_name(name));
+  nassertr(ui != _uv_list.end(), LTexCoordd::zero());
+  return (*ui)->get_uv();
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -187,9 +246,10 @@ get_uv(const string &name) const {
 ////////////////////////////////////////////////////////////////////
 const LTexCoord3d &EggVertex::
 get_uvw(const string &name) const {
-  UVMap::const_iterator ui = _uv_map.find(EggVertexUV::filter_name(name));
-  nassertr(ui != _uv_map.end(), LTexCoord3d::zero());
-  return (*ui).second->get_uvw();
+  UVList::const_iterator ui =
+    find_name(_uv_list.begin(), _uv_list.end(), EggVertexUV::filter_name(name));
+  nassertr(ui != _uv_list.end(), LTexCoord3d::zero());
+  return (*ui)->get_uvw();
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -201,9 +261,10 @@ get_uvw(const string &name) const {
 ////////////////////////////////////////////////////////////////////
 const LVecBase4d &EggVertex::
 get_aux(const string &name) const {
-  AuxMap::const_iterator xi = _aux_map.find(name);
-  nassertr(xi != _aux_map.end(), LVecBase4d::zero());
-  return (*xi).second->get_aux();
+  AuxList::const_iterator xi =
+    find_name(_aux_list.begin(), _aux_list.end(), name);
+  nassertr(xi != _aux_list.end(), LVecBase4d::zero());
+  return (*xi)->get_aux();
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -216,13 +277,13 @@ get_aux(const string &name) const {
 void EggVertex::
 set_uv(const string &name, const LTexCoordd &uv) {
   string fname = EggVertexUV::filter_name(name);
-  PT(EggVertexUV) &uv_obj = _uv_map[fname];
+  UVList::iterator ui = find_name(_uv_list.begin(), _uv_list.end(), fname);
 
-  if (uv_obj.is_null()) {
-    uv_obj = new EggVertexUV(fname, uv);
+  if (ui == _uv_list.end()) {
+    store_named(_uv_list, new EggVertexUV(fname, uv));
   } else {
-    uv_obj = new EggVertexUV(*uv_obj);
-    uv_obj->set_uv(uv);
+    (*ui) = new EggVertexUV(*(*ui));
+    (*ui)->set_uv(uv);
   }
 
   nassertv(get_uv(fname) == uv);
@@ -239,13 +300,13 @@ set_uv(const string &name, const LTexCoordd &uv) {
 void EggVertex::
 set_uvw(const string &name, const LTexCoord3d &uvw) {
   string fname = EggVertexUV::filter_name(name);
-  PT(EggVertexUV) &uv_obj = _uv_map[fname];
+  UVList::iterator ui = find_name(_uv_list.begin(), _uv_list.end(), fname);
 
-  if (uv_obj.is_null()) {
-    uv_obj = new EggVertexUV(fname, uvw);
+  if (ui == _uv_list.end()) {
+    store_named(_uv_list, new EggVertexUV(fname, uvw));
   } else {
-    uv_obj = new EggVertexUV(*uv_obj);
-    uv_obj->set_uvw(uvw);
+    (*ui) = new EggVertexUV(*(*ui));
+    (*ui)->set_uvw(uvw);
   }
 
   nassertv(get_uvw(fname) == uvw);
@@ -260,13 +321,13 @@ set_uvw(const string &name, const LTexCoord3d &uvw) {
 ////////////////////////////////////////////////////////////////////
 void EggVertex::
 set_aux(const string &name, const LVecBase4d &aux) {
-  PT(EggVertexAux) &aux_obj = _aux_map[name];
+  AuxList::iterator xi = find_name(_aux_list.begin(), _aux_list.end(), name);
 
-  if (aux_obj.is_null()) {
-    aux_obj = new EggVertexAux(name, aux);
+  if (xi == _aux_list.end()) {
+    store_named(_aux_list, new EggVertexAux(name, aux));
   } else {
-    aux_obj = new EggVertexAux(*aux_obj);
-    aux_obj->set_aux(aux);
+    (*xi) = new EggVertexAux(*(*xi));
+    (*xi)->set_aux(aux);
   }
 
   nassertv(get_aux(name) == aux);
@@ -284,9 +345,10 @@ set_aux(const string &name, const LVecBase4d &aux) {
 ////////////////////////////////////////////////////////////////////
 const EggVertexUV *EggVertex::
 get_uv_obj(const string &name) const {
-  UVMap::const_iterator ui = _uv_map.find(EggVertexUV::filter_name(name));
-  if (ui != _uv_map.end()) {
-    return (*ui).second;
+  UVList::const_iterator ui =
+    find_name(_uv_list.begin(), _uv_list.end(), EggVertexUV::filter_name(name));
+  if (ui != _uv_list.end()) {
+    return (*ui);
   }
   return NULL;
 }
@@ -302,9 +364,10 @@ get_uv_obj(const string &name) const {
 ////////////////////////////////////////////////////////////////////
 const EggVertexAux *EggVertex::
 get_aux_obj(const string &name) const {
-  AuxMap::const_iterator xi = _aux_map.find(name);
-  if (xi != _aux_map.end()) {
-    return (*xi).second;
+  AuxList::const_iterator xi =
+    find_name(_aux_list.begin(), _aux_list.end(), name);
+  if (xi != _aux_list.end()) {
+    return (*xi);
   }
   return NULL;
 }
@@ -319,13 +382,14 @@ get_aux_obj(const string &name) const {
 ////////////////////////////////////////////////////////////////////
 EggVertexUV *EggVertex::
 modify_uv_obj(const string &name) {
-  UVMap::iterator ui = _uv_map.find(EggVertexUV::filter_name(name));
-  if (ui != _uv_map.end()) {
-    if ((*ui).second->get_ref_count() != 1) {
+  UVList::iterator ui =
+    find_name(_uv_list.begin(), _uv_list.end(), EggVertexUV::filter_name(name));
+  if (ui != _uv_list.end()) {
+    if ((*ui)->get_ref_count() != 1) {
       // Copy on write.
-      (*ui).second = new EggVertexUV(*(*ui).second);
+      (*ui) = new EggVertexUV(*(*ui));
     }
-    return (*ui).second;
+    return (*ui);
   }
 
   return NULL;
@@ -341,13 +405,13 @@ modify_uv_obj(const string &name) {
 ////////////////////////////////////////////////////////////////////
 EggVertexAux *EggVertex::
 modify_aux_obj(const string &name) {
-  AuxMap::iterator xi = _aux_map.find(name);
-  if (xi != _aux_map.end()) {
-    if ((*xi).second->get_ref_count() != 1) {
+  AuxList::iterator xi = find_name(_aux_list.begin(), _aux_list.end(), name);
+  if (xi != _aux_list.end()) {
+    if ((*xi)->get_ref_count() != 1) {
       // Copy on write.
-      (*xi).second = new EggVertexAux(*(*xi).second);
+      (*xi) = new EggVertexAux(*(*xi));
     }
-    return (*xi).second;
+    return (*xi);
   }
 
   return NULL;
@@ -362,7 +426,7 @@ modify_aux_obj(const string &name) {
 ////////////////////////////////////////////////////////////////////
 void EggVertex::
 set_uv_obj(EggVertexUV *uv) {
-  _uv_map[uv->get_name()] = uv;
+  store_named(_uv_list, uv);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -374,7 +438,7 @@ set_uv_obj(EggVertexUV *uv) {
 ////////////////////////////////////////////////////////////////////
 void EggVertex::
 set_aux_obj(EggVertexAux *aux) {
-  _aux_map[aux->get_name()] = aux;
+  store_named(_aux_list, aux);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -385,7 +449,11 @@ set_aux_obj(EggVertexAux *aux) {
 ///////////////////////////////////////////////////////////////////
 void EggVertex::
 clear_uv(const string &name) {
-  _uv_map.erase(EggVertexUV::filter_name(name));
+  UVList::iterator ui =
+    find_name(_uv_list.begin(), _uv_list.end(), EggVertexUV::filter_name(name));
+  if (ui != _uv_list.end()) {
+    _uv_list.erase(ui);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -395,7 +463,10 @@ clear_uv(const string &name) {
 ///////////////////////////////////////////////////////////////////
 void EggVertex::
 clear_aux(const string &name) {
-  _aux_map.erase(name);
+  AuxList::iterator xi = find_name(_aux_list.begin(), _aux_list.end(), name);
+  if (xi != _aux_list.end()) {
+    _aux_list.erase(xi);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -438,8 +509,8 @@ make_average(const EggVertex *first, const EggVertex *second) {
   // that they have in common.
   const_uv_iterator it;
   for (it = first->uv_begin(); it != first->uv_end(); ++it) {
-    const EggVertexUV *first_uv = it->second;
-    const EggVertexUV *second_uv = second->get_uv_obj(it->first);
+    const EggVertexUV *first_uv = (*it);
+    const EggVertexUV *second_uv = second->get_uv_obj(first_uv->get_name());
 
     if (first_uv != NULL && second_uv != NULL) {
       middle->set_uv_obj(EggVertexUV::make_average(first_uv, second_uv));
@@ -449,8 +520,8 @@ make_average(const EggVertex *first, const EggVertex *second) {
   // Same for EggVertexAux.
   const_aux_iterator ai;
   for (ai = first->aux_begin(); ai != first->aux_end(); ++ai) {
-    const EggVertexAux *first_aux = ai->second;
-    const EggVertexAux *second_aux = second->get_aux_obj(ai->first);
+    const EggVertexAux *first_aux = (*ai);
+    const EggVertexAux *second_aux = second->get_aux_obj(first_aux->get_name());
 
     if (first_aux != NULL && second_aux != NULL) {
       middle->set_aux_obj(EggVertexAux::make_average(first_aux, second_aux));
@@ -492,10 +563,10 @@ make_average(const EggVertex *first, const EggVertex *second) {
   }
 
   // Now merge the vertex memberships.
-  GroupRef::iterator gi;
-  for (gi = first->_gref.begin(); gi != first->_gref.end(); ++gi) {
+  GroupRef::const_iterator gi;
+  for (gi = first->gref_begin(); gi != first->gref_end(); ++gi) {
     EggGroup *group = *gi;
-    if (second->_gref.count(group)) {
+    if (second->has_gref(group)) {
       group->set_vertex_membership(middle,
         (group->get_vertex_membership(first) +
          group->get_vertex_membership(second)) / 2.);
@@ -508,9 +579,9 @@ make_average(const EggVertex *first, const EggVertex *second) {
   }
   // Also assign memberships to the grefs in the second vertex that
   // aren't part of the first vertex.
-  for (gi = second->_gref.begin(); gi != second->_gref.end(); ++gi) {
+  for (gi = second->gref_begin(); gi != second->gref_end(); ++gi) {
     EggGroup *group = *gi;
-    if (second->_gref.count(group) == 0) {
+    if (!second->has_gref(group)) {
       group->set_vertex_membership(middle, group->get_vertex_membership(second));
     }
   }
@@ -567,14 +638,14 @@ write(ostream &out, int indent_level) const {
   }
   out << "\n";
 
-  UVMap::const_iterator ui;
-  for (ui = _uv_map.begin(); ui != _uv_map.end(); ++ui) {
-    (*ui).second->write(out, indent_level + 2);
+  UVList::const_iterator ui;
+  for (ui = _uv_list.begin(); ui != _uv_list.end(); ++ui) {
+    (*ui)->write(out, indent_level + 2);
   }
 
-  AuxMap::const_iterator xi;
-  for (xi = _aux_map.begin(); xi != _aux_map.end(); ++xi) {
-    (*xi).second->write(out, indent_level + 2);
+  AuxList::const_iterator xi;
+  for (xi = _aux_list.begin(); xi != _aux_list.end(); ++xi) {
+    (*xi)->write(out, indent_level + 2);
   }
 
   EggAttributes::write(out, indent_level+2);
@@ -583,12 +654,12 @@ write(ostream &out, int indent_level) const {
 
   // If the vertex is referenced by one or more groups, write that as
   // a helpful comment.
-  if (!_gref.empty()) {
+  if (_gref != NULL) {
     // We need to build a list of group entries.
     pset<GroupRefEntry> gre;
 
     GroupRef::const_iterator gi;
-    for (gi = _gref.begin(); gi != _gref.end(); ++gi) {
+    for (gi = _gref->begin(); gi != _gref->end(); ++gi) {
       gre.insert(GroupRefEntry(*gi, (*gi)->get_vertex_membership(this)));
     }
 
@@ -646,18 +717,18 @@ compare_to(const EggVertex &other) const {
   }
 
   // Merge-compare the uv maps.
-  UVMap::const_iterator ai, bi;
-  ai = _uv_map.begin();
-  bi = other._uv_map.begin();
-  while (ai != _uv_map.end() && bi != other._uv_map.end()) {
-    if ((*ai).first < (*bi).first) {
+  UVList::const_iterator ai, bi;
+  ai = _uv_list.begin();
+  bi = other._uv_list.begin();
+  while (ai != _uv_list.end() && bi != other._uv_list.end()) {
+    if ((*ai)->get_name() < (*bi)->get_name()) {
       return -1;
 
-    } else if ((*bi).first < (*ai).first) {
+    } else if ((*bi)->get_name() < (*ai)->get_name()) {
       return 1;
 
     } else {
-      int compare = (*ai).second->compare_to(*(*bi).second);
+      int compare = (*ai)->compare_to(*(*bi));
       if (compare != 0) {
         return compare;
       }
@@ -665,26 +736,26 @@ compare_to(const EggVertex &other) const {
     ++ai;
     ++bi;
   }
-  if (bi != other._uv_map.end()) {
+  if (bi != other._uv_list.end()) {
     return -1;
   }
-  if (ai != _uv_map.end()) {
+  if (ai != _uv_list.end()) {
     return 1;
   }
 
   // Merge-compare the aux maps.
-  AuxMap::const_iterator ci, di;
-  ci = _aux_map.begin();
-  di = other._aux_map.begin();
-  while (ci != _aux_map.end() && di != other._aux_map.end()) {
-    if ((*ci).first < (*di).first) {
+  AuxList::const_iterator ci, di;
+  ci = _aux_list.begin();
+  di = other._aux_list.begin();
+  while (ci != _aux_list.end() && di != other._aux_list.end()) {
+    if ((*ci)->get_name() < (*di)->get_name()) {
       return -1;
 
-    } else if ((*di).first < (*ci).first) {
+    } else if ((*di)->get_name() < (*ci)->get_name()) {
       return 1;
 
     } else {
-      int compare = (*ci).second->compare_to(*(*di).second);
+      int compare = (*ci)->compare_to(*(*di));
       if (compare != 0) {
         return compare;
       }
@@ -692,10 +763,10 @@ compare_to(const EggVertex &other) const {
     ++ci;
     ++di;
   }
-  if (di != other._aux_map.end()) {
+  if (di != other._aux_list.end()) {
     return -1;
   }
-  if (ci != _aux_map.end()) {
+  if (ci != _aux_list.end()) {
     return 1;
   }
 
@@ -765,9 +836,9 @@ transform(const LMatrix4d &mat) {
     morph.set_offset((*mi).get_offset() * mat);
   }
 
-  UVMap::iterator ui;
-  for (ui = _uv_map.begin(); ui != _uv_map.end(); ++ui) {
-    (*ui).second->transform(mat);
+  UVList::iterator ui;
+  for (ui = _uv_list.begin(); ui != _uv_list.end(); ++ui) {
+    (*ui)->transform(mat);
   }
 
   EggAttributes::transform(mat);
@@ -787,7 +858,7 @@ transform(const LMatrix4d &mat) {
 ////////////////////////////////////////////////////////////////////
 EggVertex::GroupRef::const_iterator EggVertex::
 gref_begin() const {
-  return _gref.begin();
+  return (_gref == NULL) ? _empty_gref.begin() : _gref->begin();
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -803,7 +874,7 @@ gref_begin() const {
 ////////////////////////////////////////////////////////////////////
 EggVertex::GroupRef::const_iterator EggVertex::
 gref_end() const {
-  return _gref.end();
+  return (_gref == NULL) ? _empty_gref.end() : _gref->end();
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -817,7 +888,7 @@ gref_end() const {
 ////////////////////////////////////////////////////////////////////
 EggVertex::GroupRef::size_type EggVertex::
 gref_size() const {
-  return _gref.size();
+  return (_gref == NULL) ? 0 : _gref->size();
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -828,7 +899,7 @@ gref_size() const {
 ////////////////////////////////////////////////////////////////////
 bool EggVertex::
 has_gref(const EggGroup *group) const {
-  return _gref.count((EggGroup *)group) != 0;
+  return _gref != NULL && _gref->count((EggGroup *)group) != 0;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -873,7 +944,10 @@ copy_grefs_from(const EggVertex &other) {
 ////////////////////////////////////////////////////////////////////
 void EggVertex::
 clear_grefs() {
-  GroupRef gref_copy = _gref;
+  if (_gref == NULL) {
+    return;
+  }
+  GroupRef gref_copy = *_gref;
   GroupRef::const_iterator gri;
   for (gri = gref_copy.begin(); gri != gref_copy.end(); ++gri) {
     EggGroup *group = *gri;
@@ -882,7 +956,7 @@ clear_grefs() {
   }
 
   // Now we should have no more refs.
-  nassertv(_gref.empty());
+  nassertv(_gref == NULL);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -939,7 +1013,43 @@ pref_size() const {
 ////////////////////////////////////////////////////////////////////
 int EggVertex::
 has_pref(const EggPrimitive *prim) const {
-  return _pref.count((EggPrimitive *)prim);
+  return (int)count(_pref.begin(), _pref.end(), (EggPrimitive *)prim);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggVertex::insert_gref
+//       Access: Private
+//  Description: Records that the indicated group references this
+//               vertex.  Returns true if it did not already, false
+//               if it did.  This is called only by EggGroup.
+////////////////////////////////////////////////////////////////////
+bool EggVertex::
+insert_gref(EggGroup *group) {
+  if (_gref == NULL) {
+    _gref = new GroupRef;
+  }
+  return _gref->insert(group).second;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggVertex::erase_gref
+//       Access: Private
+//  Description: Records that the indicated group no longer references
+//               this vertex.  Returns the number of references
+//               removed, which should be 1.  This is called only by
+//               EggGroup.
+////////////////////////////////////////////////////////////////////
+int EggVertex::
+erase_gref(EggGroup *group) {
+  if (_gref == NULL) {
+    return 0;
+  }
+  int count = _gref->erase(group);
+  if (_gref->empty()) {
+    delete _gref;
+    _gref = NULL;
+  }
+  return count;
 }
 
 #ifdef _DEBUG
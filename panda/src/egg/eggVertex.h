@@ -26,6 +26,7 @@
 #include "referenceCount.h"
 #include "luse.h"
 #include "pset.h"
+#include "pvector.h"
 #include "iterator_types.h"
 
 class EggVertexPool;
@@ -37,21 +38,29 @@ class EggPrimitive;
 //       Class : EggVertex
 // Description : Any one-, two-, three-, or four-component vertex,
 //               possibly with attributes such as a normal.
+//
+//               A large mesh may have millions of these, so the
+//               vertex is kept small: the named UV and aux objects
+//               are stored in vectors sorted by name (the name is
+//               stored only once, on the object itself), the
+//               primitives that reference the vertex are kept in a
+//               plain vector, and the group memberships and morph
+//               lists are allocated only when they are first needed.
 ////////////////////////////////////////////////////////////////////
 class EXPCL_PANDAEGG EggVertex : public EggObject, public EggAttributes {
 public:
   typedef pset<EggGroup *> GroupRef;
-  typedef pmultiset<EggPrimitive *> PrimitiveRef;
-  typedef pmap< string, PT(EggVertexUV) > UVMap;
-  typedef pmap< string, PT(EggVertexAux) > AuxMap;
+  typedef pvector<EggPrimitive *> PrimitiveRef;
+  typedef pvector< PT(EggVertexUV) > UVList;
+  typedef pvector< PT(EggVertexAux) > AuxList;
 
-  typedef second_of_pair_iterator<UVMap::const_iterator> uv_iterator;
+  typedef UVList::const_iterator uv_iterator;
   typedef uv_iterator const_uv_iterator;
-  typedef UVMap::size_type uv_size_type;
+  typedef UVList::size_type uv_size_type;
 
-  typedef second_of_pair_iterator<AuxMap::const_iterator> aux_iterator;
+  typedef AuxList::const_iterator aux_iterator;
   typedef aux_iterator const_aux_iterator;
-  typedef AuxMap::size_type aux_size_type;
+  typedef AuxList::size_type aux_size_type;
 
 
 PUBLISHED:
@@ -59,6 +68,7 @@ PUBLISHED:
   EggVertex(const EggVertex &copy);
   EggVertex &operator = (const EggVertex &copy);
   virtual ~EggVertex();
+  ALLOC_DELETED_CHAIN(EggVertex);
 
   INLINE EggVertexPool *get_pool() const;
 
@@ -167,6 +177,10 @@ PUBLISHED:
 
   EggMorphVertexList _dxyzs;
 
+private:
+  bool insert_gref(EggGroup *group);
+  int erase_gref(EggGroup *group);
+
 private:
   EggVertexPool *_pool;
   bool _forward_reference;
@@ -174,11 +188,13 @@ private:
   int _external_index, _external_index2;
   LPoint4d _pos;
   short _num_dimensions;
-  GroupRef _gref;
+  GroupRef *_gref;
   PrimitiveRef _pref;
 
-  UVMap _uv_map;
-  AuxMap _aux_map;
+  UVList _uv_list;
+  AuxList _aux_list;
+
+  static const GroupRef _empty_gref;
 
 public:
   static TypeHandle get_class_type() {
@@ -36,6 +36,7 @@ PUBLISHED:
   EggVertexUV(const EggVertexUV &copy);
   EggVertexUV &operator = (const EggVertexUV &copy);
   virtual ~EggVertexUV();
+  ALLOC_DELETED_CHAIN(EggVertexUV);
 
   INLINE static string filter_name(const string &name);
   INLINE void set_name(const string &name);
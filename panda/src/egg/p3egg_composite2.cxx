@@ -8,6 +8,7 @@
 #include "eggPrimitive.cxx"
 #include "eggRenderMode.cxx"
 #include "eggSAnimData.cxx"
+#include "eggStreamParser.cxx"
 #include "eggSurface.cxx"
 #include "eggSwitchCondition.cxx"
 #include "eggTable.cxx"
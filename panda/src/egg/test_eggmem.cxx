@@ -0,0 +1,230 @@
+// Filename: test_eggmem.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "pandabase.h"
+#include "eggData.h"
+#include "eggGroup.h"
+#include "eggPolygon.h"
+#include "eggVertex.h"
+#include "eggVertexPool.h"
+#include "dcast.h"
+#include "trueClock.h"
+#include "string_utils.h"
+#include "pvector.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#else
+#include <unistd.h>
+#endif
+
+// This program builds a large grid mesh in an EggVertexPool, with a
+// normal and a UV on each vertex and half of the vertices assigned
+// to a joint, and reports the memory consumed per vertex and the time
+// taken to build, write and destroy it.  If egg files are named on the
+// command line, it also reports the memory consumed per vertex by
+// reading each of them.
+//
+// Memory is measured as the growth in the resident size of the
+// process, which counts everything the allocator actually took from
+// the system, including its own overhead.
+//
+// Usage: test_eggmem [grid-size] [file.egg ...]
+
+////////////////////////////////////////////////////////////////////
+//     Function: get_resident_size
+//  Description: Returns the number of bytes of memory the process
+//               currently has resident, or 0 if this is not known on
+//               this platform.
+////////////////////////////////////////////////////////////////////
+static size_t
+get_resident_size() {
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS counters;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+    return counters.WorkingSetSize;
+  }
+  return 0;
+
+#elif defined(__APPLE__)
+  mach_task_basic_info_data_t info;
+  mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+  if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO,
+                (task_info_t)&info, &count) == KERN_SUCCESS) {
+    return info.resident_size;
+  }
+  return 0;
+
+#else
+  // The second field of /proc/self/statm is the resident size, in
+  // pages.
+  size_t total_pages = 0, resident_pages = 0;
+  FILE *file = fopen("/proc/self/statm", "r");
+  if (file == NULL) {
+    return 0;
+  }
+  int count = fscanf(file, "%zu %zu", &total_pages, &resident_pages);
+  fclose(file);
+  if (count != 2) {
+    return 0;
+  }
+  return resident_pages * (size_t)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: count_vertices
+//  Description: Returns the total number of vertices in all of the
+//               vertex pools at or below the indicated node.
+////////////////////////////////////////////////////////////////////
+static int
+count_vertices(EggNode *node) {
+  if (node->is_of_type(EggVertexPool::get_class_type())) {
+    return DCAST(EggVertexPool, node)->size();
+  }
+
+  int count = 0;
+  if (node->is_of_type(EggGroupNode::get_class_type())) {
+    EggGroupNode *group = DCAST(EggGroupNode, node);
+    EggGroupNode::const_iterator ci;
+    for (ci = group->begin(); ci != group->end(); ++ci) {
+      count += count_vertices(*ci);
+    }
+  }
+  return count;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: build_grid
+//  Description: Fills the egg data with a grid of size x size
+//               vertices and the quads that connect them.
+////////////////////////////////////////////////////////////////////
+static void
+build_grid(EggData *data, int size) {
+  PT(EggVertexPool) pool = new EggVertexPool("grid");
+  data->add_child(pool);
+
+  PT(EggGroup) character = new EggGroup("character");
+  character->set_dart_type(EggGroup::DT_default);
+  data->add_child(character);
+
+  PT(EggGroup) joint = new EggGroup("joint");
+  joint->set_group_type(EggGroup::GT_joint);
+  character->add_child(joint);
+
+  for (int yi = 0; yi < size; ++yi) {
+    for (int xi = 0; xi < size; ++xi) {
+      EggVertex *vertex = pool->add_vertex(new EggVertex, yi * size + xi);
+      vertex->set_pos(LPoint3d(xi, yi, 0.0));
+      vertex->set_normal(LNormald(0.0, 0.0, 1.0));
+      vertex->set_uv(LTexCoordd((double)xi / size, (double)yi / size));
+      if (xi < size / 2) {
+        joint->ref_vertex(vertex, 1.0);
+      }
+    }
+  }
+
+  PT(EggGroup) mesh = new EggGroup("mesh");
+  character->add_child(mesh);
+  for (int yi = 0; yi < size - 1; ++yi) {
+    for (int xi = 0; xi < size - 1; ++xi) {
+      PT(EggPolygon) poly = new EggPolygon;
+      poly->add_vertex(pool->get_vertex(yi * size + xi));
+      poly->add_vertex(pool->get_vertex(yi * size + xi + 1));
+      poly->add_vertex(pool->get_vertex((yi + 1) * size + xi + 1));
+      poly->add_vertex(pool->get_vertex((yi + 1) * size + xi));
+      mesh->add_child(poly);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: report
+//  Description: Writes one line of results.
+////////////////////////////////////////////////////////////////////
+static void
+report(const string &name, int num_vertices, size_t before, size_t after,
+       double elapsed) {
+  double bytes = (double)after - (double)before;
+  cerr << name << ": " << num_vertices << " vertices, "
+       << bytes / 1048576.0 << " MB, "
+       << bytes / max(num_vertices, 1) << " bytes per vertex, "
+       << elapsed << " s\n";
+}
+
+int
+main(int argc, char *argv[]) {
+  int size = 512;
+  int first_file = 1;
+  int arg_size;
+  if (argc > 1 && string_to_int(argv[1], arg_size)) {
+    size = arg_size;
+    first_file = 2;
+  }
+
+  if (get_resident_size() == 0) {
+    cerr << "Memory use cannot be measured on this platform.\n";
+  }
+
+  TrueClock *clock = TrueClock::get_global_ptr();
+
+  // Memory the process has once taken is not usually given back to
+  // the system, so each measurement must be of new growth: the files
+  // are read first, and kept until the end, and the grid is built last.
+  pvector<PT(EggData)> files;
+  for (int i = first_file; i < argc; ++i) {
+    Filename filename = Filename::from_os_specific(argv[i]);
+    size_t before = get_resident_size();
+    double start = clock->get_short_time();
+    PT(EggData) data = new EggData;
+    if (!data->read(filename)) {
+      cerr << "Unable to read " << filename << "\n";
+      return 1;
+    }
+    double elapsed = clock->get_short_time() - start;
+    report(filename.get_basename(), count_vertices(data), before,
+           get_resident_size(), elapsed);
+    files.push_back(data);
+  }
+
+  {
+    size_t before = get_resident_size();
+    double start = clock->get_short_time();
+    PT(EggData) data = new EggData;
+    build_grid(data, size);
+    double elapsed = clock->get_short_time() - start;
+    report("grid", count_vertices(data), before,
+           get_resident_size(), elapsed);
+
+    start = clock->get_short_time();
+    ostringstream out;
+    data->write_egg(out);
+    elapsed = clock->get_short_time() - start;
+    cerr << "  write: " << out.str().size() / 1024 << " KB, "
+         << elapsed << " s\n";
+
+    start = clock->get_short_time();
+    data.clear();
+    elapsed = clock->get_short_time() - start;
+    cerr << "  destroy: " << elapsed << " s\n";
+  }
+
+  return 0;
+}
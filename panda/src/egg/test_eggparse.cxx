@@ -0,0 +1,123 @@
+// Filename: test_eggparse.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "pandabase.h"
+#include "eggData.h"
+#include "config_egg.h"
+#include "virtualFileSystem.h"
+#include "trueClock.h"
+#include "string_utils.h"
+#include "vector_string.h"
+#include <algorithm>
+
+// This program reads each of the named egg files with the bison
+// parser and then with the streaming parser, reports the throughput
+// of each in megabytes of egg syntax per second, and verifies that
+// the two parsers produce exactly the same egg structure.
+//
+// Usage: test_eggparse file.egg [file.egg ...]
+
+static const int num_iterations = 5;
+
+////////////////////////////////////////////////////////////////////
+//     Function: sort_lines
+//  Description: Returns the lines of the indicated text in sorted
+//               order.  A joint writes its vertex references in
+//               pointer order, which varies from one read to the
+//               next, so we can only compare the written egg files
+//               line by line, not in sequence.
+////////////////////////////////////////////////////////////////////
+static string
+sort_lines(const string &text) {
+  vector_string lines;
+  tokenize(text, lines, "\n");
+  sort(lines.begin(), lines.end());
+
+  string result;
+  vector_string::const_iterator li;
+  for (li = lines.begin(); li != lines.end(); ++li) {
+    result += (*li);
+    result += '\n';
+  }
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: parse_egg
+//  Description: Parses the egg syntax with the indicated parser,
+//               several times, and returns the throughput in
+//               megabytes per second.  Fills in the written form of
+//               the result of the last parse.
+////////////////////////////////////////////////////////////////////
+static double
+parse_egg(const Filename &filename, const string &data, bool use_stream,
+          string &written, bool &read_ok) {
+  egg_stream_parser = use_stream;
+
+  TrueClock *clock = TrueClock::get_global_ptr();
+  double start = clock->get_short_time();
+  PT(EggData) egg;
+  for (int i = 0; i < num_iterations; ++i) {
+    egg = new EggData;
+    egg->set_egg_filename(filename);
+    istringstream in(data);
+    read_ok = egg->read(in);
+  }
+  double elapsed = clock->get_short_time() - start;
+
+  ostringstream out;
+  egg->write_egg(out);
+  written = sort_lines(out.str());
+
+  double megabytes = (double)data.size() * num_iterations / 1000000.0;
+  return megabytes / max(elapsed, 0.000001);
+}
+
+int
+main(int argc, char *argv[]) {
+  if (argc < 2) {
+    nout << "Specify one or more egg files to read.\n";
+    exit(1);
+  }
+
+  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+  bool all_match = true;
+
+  for (int i = 1; i < argc; ++i) {
+    Filename filename = Filename::text_filename(string(argv[i]));
+    string data;
+    if (!vfs->read_file(filename, data, true)) {
+      nout << "Unable to read " << filename << "\n";
+      all_match = false;
+      continue;
+    }
+
+    string bison_written, stream_written;
+    bool bison_ok, stream_ok;
+    double bison = parse_egg(filename, data, false, bison_written, bison_ok);
+    double stream = parse_egg(filename, data, true, stream_written, stream_ok);
+
+    bool match = (bison_written == stream_written && bison_ok == stream_ok);
+    if (!match) {
+      all_match = false;
+    }
+
+    cerr << filename.get_basename() << " (" << data.size() / 1024 << " KB): "
+         << bison << " MB/s bison, " << stream << " MB/s stream ("
+         << stream / bison << "x)"
+         << (match ? "" : "; RESULTS DIFFER") << "\n";
+  }
+
+  return all_match ? 0 : 1;
+}
@@ -52,3 +52,15 @@
   #define IGATESCAN load_egg_file.h save_egg_file.h
 
 #end lib_target
+
+#begin test_bin_target
+  #define TARGET test_eggLoader
+  #define LOCAL_LIBS \
+    p3egg2pg p3pnmimagetypes
+  #define OTHER_LIBS $[OTHER_LIBS] p3pystub
+
+  #define SOURCES \
+    test_eggLoader.cxx
+
+#end test_bin_target
+
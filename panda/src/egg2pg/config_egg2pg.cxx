@@ -191,6 +191,16 @@ ConfigVariableBool egg_implicit_alpha_binary
           "will automatically be downgraded to alpha type \"binary\" instead of "
           "whatever appears in the egg file."));
 
+ConfigVariableInt egg_load_threads
+("egg-load-threads", 1,
+ PRC_DESC("The number of threads that may be used to convert a single egg "
+          "file to a scene graph.  When this is greater than 1, the "
+          "textures named by the egg file are loaded at the same time, and "
+          "each toplevel group that stands on its own (one that contains no "
+          "<Ref> to another group and no animation tables, in an egg file "
+          "with no characters) is converted on a thread of its own.  Set "
+          "this to 1 to do all of the work on the loading thread."));
+
 ConfigureFn(config_egg2pg) {
   init_libegg2pg();
 }
@@ -93,6 +93,8 @@
 #include "transformBlend.h"
 #include "sparseArray.h"
 #include "bitArray.h"
+#include "mutexHolder.h"
+#include "parallelBands.h"
 #include "thread.h"
 #include "uvScrollNode.h"
 #include "textureStagePool.h"
@@ -206,17 +208,24 @@ build_graph() {
 
   // Then bin up the polysets and LOD nodes.
   _data->remove_invalid_primitives(true);
-  EggBinner binner(*this);
-  binner.make_bins(_data);
+  _root = new ModelRoot(_data->get_egg_filename(), _data->get_egg_timestamp());
 
-  //  ((EggGroupNode *)_data)->write(cerr, 0);
+  if (get_num_threads() > 1 && can_make_subtrees()) {
+    // Each toplevel group can be binned and converted on its own, so
+    // we can do several of them at a time.
+    make_subtrees();
 
-  // Now build up the scene graph.
-  _root = new ModelRoot(_data->get_egg_filename(), _data->get_egg_timestamp());
+  } else {
+    EggBinner binner(*this);
+    binner.make_bins(_data);
 
-  EggGroupNode::const_iterator ci;
-  for (ci = _data->begin(); ci != _data->end(); ++ci) {
-    make_node(*ci, _root);
+    //  ((EggGroupNode *)_data)->write(cerr, 0);
+
+    // Now build up the scene graph.
+    EggGroupNode::const_iterator ci;
+    for (ci = _data->begin(); ci != _data->end(); ++ci) {
+      make_node(*ci, _root);
+    }
   }
 
   reparent_decals();
@@ -345,8 +354,13 @@ make_polyset(EggBin *egg_bin, PandaNode *parent, const LMatrix4d *transform,
   // EggVertexPool translates directly to an optimal GeomVertexData
   // structure.
   EggVertexPools vertex_pools;
-  egg_bin->rebuild_vertex_pools(vertex_pools, (unsigned int)egg_max_vertices, 
-                                false);
+  {
+    // This removes the primitives from the original vertices, which
+    // may be shared with primitives being converted in other threads.
+    MutexHolder holder(_lock);
+    egg_bin->rebuild_vertex_pools(vertex_pools, (unsigned int)egg_max_vertices, 
+                                  false);
+  }
 
   if (egg_mesh) {
     // If we're using the mesher, mesh now.
@@ -616,6 +630,7 @@ make_transform(const EggTransform *egg_transform) {
   // additional uniquification step, but this is the egg loader so we
   // don't mind spending a little bit of extra time here to get a more
   // optimal result.
+  MutexHolder holder(_lock);
   TransformStates::iterator tsi = _transform_states.insert(TransformStates::value_type(ts->get_mat(), ts)).first;
   
   return (*tsi).second;
@@ -894,17 +909,39 @@ load_textures() {
   EggTextureCollection tc;
   tc.find_used_textures(_data);
 
+  // Load them all, as many at a time as egg-load-threads allows.
+  _texture_loads.clear();
+  _texture_loads.reserve(tc.get_num_textures());
   EggTextureCollection::iterator ti;
   for (ti = tc.begin(); ti != tc.end(); ++ti) {
-    PT_EggTexture egg_tex = (*ti);
+    _texture_loads.push_back(TextureLoad());
+    _texture_loads.back()._egg_tex = (*ti);
+    _texture_loads.back()._success = false;
+  }
 
-    TextureDef def;
-    if (load_texture(def, egg_tex)) {
+  run_parallel(&EggLoader::load_texture_item, (int)_texture_loads.size());
+
+  TextureLoads::const_iterator li;
+  for (li = _texture_loads.begin(); li != _texture_loads.end(); ++li) {
+    if ((*li)._success) {
       // Now associate the pointers, so we'll be able to look up the
       // Texture pointer given an EggTexture pointer, later.
-      _textures[egg_tex] = def;
+      _textures[(*li)._egg_tex] = (*li)._def;
     }
   }
+  _texture_loads.clear();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggLoader::load_texture_item
+//       Access: Private
+//  Description: Loads the nth texture collected by load_textures().
+//               This may be called from any of several threads.
+////////////////////////////////////////////////////////////////////
+void EggLoader::
+load_texture_item(int item) {
+  TextureLoad &load = _texture_loads[item];
+  load._success = load_texture(load._def, load._egg_tex);
 }
 
 
@@ -963,6 +1000,7 @@ load_texture(TextureDef &def, EggTexture *egg_tex) {
   // specified in the egg file), then we add the textures as
   // dependents for the egg file.
   if (_record != (BamCacheRecord *)NULL) {
+    MutexHolder holder(_lock);
     _record->add_dependent_file(egg_tex->get_fullpath());
     if (egg_tex->has_alpha_filename() && wanted_alpha) {
       _record->add_dependent_file(egg_tex->get_alpha_fullpath());
@@ -1733,6 +1771,236 @@ emulate_bface(EggNode *egg_node) {
   }
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: EggLoader::can_make_subtrees
+//       Access: Private
+//  Description: Returns true if the toplevel nodes of the egg file
+//               may be binned and converted one at a time, by
+//               make_subtrees(), or false if the whole file must be
+//               binned at once.
+//
+//               This requires that there be no primitives or LOD
+//               groups directly at the top of the file, which would
+//               have to be binned together, and no characters, whose
+//               joints are referenced by vertices throughout the
+//               file.
+////////////////////////////////////////////////////////////////////
+bool EggLoader::
+can_make_subtrees() {
+  EggBinner binner(*this);
+
+  EggGroupNode::const_iterator ci;
+  for (ci = _data->begin(); ci != _data->end(); ++ci) {
+    if (binner.get_bin_number(*ci) != EggBinner::BN_none) {
+      return false;
+    }
+  }
+
+  return !has_characters(_data);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggLoader::has_characters
+//       Access: Private, Static
+//  Description: Returns true if there is a <Dart> or a <Joint> group
+//               anywhere at or below the indicated group.
+////////////////////////////////////////////////////////////////////
+bool EggLoader::
+has_characters(const EggGroupNode *egg_group) {
+  EggGroupNode::const_iterator ci;
+  for (ci = egg_group->begin(); ci != egg_group->end(); ++ci) {
+    if ((*ci)->is_of_type(EggGroup::get_class_type())) {
+      const EggGroup *child = DCAST(EggGroup, *ci);
+      if (child->get_dart_type() != EggGroup::DT_none ||
+          child->get_group_type() == EggGroup::GT_joint) {
+        return true;
+      }
+    }
+    if ((*ci)->is_of_type(EggGroupNode::get_class_type())) {
+      if (has_characters(DCAST(EggGroupNode, *ci))) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggLoader::is_independent_subtree
+//       Access: Private, Static
+//  Description: Returns true if the indicated node may be converted
+//               at the same time as its neighbors, or false if it
+//               must be converted in order on the main thread.  A
+//               node is independent if nothing within it refers to
+//               another group (which might not have been converted
+//               yet), and it contains no animation tables.
+////////////////////////////////////////////////////////////////////
+bool EggLoader::
+is_independent_subtree(const EggNode *egg_node) {
+  if (egg_node->is_of_type(EggTable::get_class_type())) {
+    return false;
+  }
+  if (egg_node->is_of_type(EggGroup::get_class_type())) {
+    if (DCAST(EggGroup, egg_node)->get_num_group_refs() != 0) {
+      return false;
+    }
+  }
+
+  if (egg_node->is_of_type(EggGroupNode::get_class_type())) {
+    const EggGroupNode *egg_group = DCAST(EggGroupNode, egg_node);
+    EggGroupNode::const_iterator ci;
+    for (ci = egg_group->begin(); ci != egg_group->end(); ++ci) {
+      if (!is_independent_subtree(*ci)) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggLoader::make_subtrees
+//       Access: Private
+//  Description: Bins and converts each of the toplevel nodes of the
+//               egg file under _root, in the same order as
+//               build_graph() would.  Each run of consecutive
+//               independent groups is shared out among
+//               egg-load-threads threads; each of these is converted
+//               under a temporary node of its own, and the results
+//               are moved under _root in order afterwards.  Any other
+//               toplevel group is converted on this thread, after
+//               all of the groups that precede it.
+////////////////////////////////////////////////////////////////////
+void EggLoader::
+make_subtrees() {
+  EggBinner binner(*this);
+
+  EggGroupNode::const_iterator ci = _data->begin();
+  while (ci != _data->end()) {
+    _subtrees.clear();
+    while (ci != _data->end()) {
+      EggNode *egg_node = (*ci);
+      if (egg_node->is_of_type(EggGroupNode::get_class_type())) {
+        if (!egg_node->is_of_type(EggGroup::get_class_type()) ||
+            !is_independent_subtree(egg_node)) {
+          break;
+        }
+        _subtrees.push_back(Subtree());
+        _subtrees.back()._egg_node = egg_node;
+        _subtrees.back()._holder = new PandaNode("");
+      }
+
+      // Anything else at the top of the file (textures, vertex
+      // pools, comments) produces no node, and need not interrupt
+      // the run.
+      ++ci;
+    }
+
+    if (!_subtrees.empty()) {
+      run_parallel(&EggLoader::make_subtree_item, (int)_subtrees.size());
+
+      Subtrees::const_iterator si;
+      for (si = _subtrees.begin(); si != _subtrees.end(); ++si) {
+        _root->steal_children((*si)._holder);
+      }
+    }
+
+    if (ci != _data->end()) {
+      // This must go through make_node(EggNode *), so that an EggGroup
+      // is converted as a group, with its transform and instances.
+      EggNode *egg_node = (*ci);
+      binner.make_bins(DCAST(EggGroupNode, egg_node));
+      make_node(egg_node, _root);
+      ++ci;
+    }
+  }
+
+  _subtrees.clear();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggLoader::make_subtree_item
+//       Access: Private
+//  Description: Bins and converts the nth group collected by
+//               make_subtrees().  This may be called from any of
+//               several threads.
+////////////////////////////////////////////////////////////////////
+void EggLoader::
+make_subtree_item(int item) {
+  Subtree &subtree = _subtrees[item];
+
+  EggBinner binner(*this);
+  binner.make_bins(DCAST(EggGroupNode, subtree._egg_node));
+  make_node(subtree._egg_node, subtree._holder);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggLoader::run_parallel
+//       Access: Private
+//  Description: Calls the indicated method once for each item number
+//               from 0 to num_items - 1, on as many as
+//               egg-load-threads threads at once.  The items are
+//               handed out one at a time as each thread becomes free,
+//               since they may vary widely in size.  Returns when all
+//               of them have been processed.
+////////////////////////////////////////////////////////////////////
+void EggLoader::
+run_parallel(ItemMethod method, int num_items) {
+  ParallelWork work;
+  work._loader = this;
+  work._method = method;
+  work._num_items = num_items;
+  work._next_item = 0;
+
+  int num_threads = max(min(get_num_threads(), num_items), 1);
+  run_parallel_bands(&st_parallel_main, &work, num_threads, num_threads);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggLoader::st_parallel_main
+//       Access: Private, Static
+//  Description: The body of each thread started by run_parallel().
+//               The band numbers are ignored; each thread simply
+//               takes the next unclaimed item until there are none
+//               left.
+////////////////////////////////////////////////////////////////////
+void EggLoader::
+st_parallel_main(void *data, int, int) {
+  ParallelWork *work = (ParallelWork *)data;
+  EggLoader *loader = work->_loader;
+
+  while (true) {
+    int item;
+    {
+      MutexHolder holder(loader->_lock);
+      if (work->_next_item >= work->_num_items) {
+        return;
+      }
+      item = work->_next_item;
+      ++work->_next_item;
+    }
+
+    (loader->*(work->_method))(item);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: EggLoader::get_num_threads
+//       Access: Private, Static
+//  Description: Returns the number of threads that may be used to
+//               convert an egg file, or 1 if all of the work should
+//               be done on the calling thread.
+////////////////////////////////////////////////////////////////////
+int EggLoader::
+get_num_threads() {
+  if (!Thread::is_true_threads()) {
+    return 1;
+  }
+  return max((int)egg_load_threads, 1);
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: EggLoader::make_node
 //       Access: Private
@@ -1843,7 +2111,10 @@ make_lod(EggBin *egg_bin, PandaNode *parent) {
     lod_node->add_switch(instance._d->_switch_in, instance._d->_switch_out);
   }
 
-  _groups[egg_bin] = lod_node;
+  {
+    MutexHolder holder(_lock);
+    _groups[egg_bin] = lod_node;
+  }
   return create_group_arc(egg_bin, parent, lod_node);
 }
 
@@ -1880,7 +2151,13 @@ make_node(EggGroup *egg_group, PandaNode *parent) {
     // A collision group: create collision geometry.
     node = new CollisionNode(egg_group->get_name());
 
-    make_collision_solids(egg_group, egg_group, (CollisionNode *)node.p());
+    {
+      // Triangulating the collision polygons adds new primitives to
+      // the original vertices, which may be shared with other
+      // threads.
+      MutexHolder holder(_lock);
+      make_collision_solids(egg_group, egg_group, (CollisionNode *)node.p());
+    }
 
     // Transform all of the collision solids into local space.
     node->xform(LCAST(PN_stdfloat, egg_group->get_vertex_to_node()));
@@ -1955,6 +2232,7 @@ make_node(EggGroup *egg_group, PandaNode *parent) {
       // Create a sequence node.
       node = new SequenceNode(egg_group->get_name());
       ((SequenceNode *)node.p())->set_frame_rate(egg_group->get_switch_fps());
+      MutexHolder holder(_lock);
       _sequences.insert(node);
     } else {
       // Create a switch node.
@@ -2030,18 +2308,22 @@ make_node(EggGroup *egg_group, PandaNode *parent) {
     return NULL;
   }
 
-  // Associate any instances with this node.
-  int num_group_refs = egg_group->get_num_group_refs();
-  for (int gri = 0; gri < num_group_refs; ++gri) {
-    EggGroup *group_ref = egg_group->get_group_ref(gri);
-    Groups::const_iterator gi = _groups.find(group_ref);
-    if (gi != _groups.end()) {
-      PandaNode *node_ref = (*gi).second;
-      node->add_child(node_ref);
+  {
+    MutexHolder holder(_lock);
+
+    // Associate any instances with this node.
+    int num_group_refs = egg_group->get_num_group_refs();
+    for (int gri = 0; gri < num_group_refs; ++gri) {
+      EggGroup *group_ref = egg_group->get_group_ref(gri);
+      Groups::const_iterator gi = _groups.find(group_ref);
+      if (gi != _groups.end()) {
+        PandaNode *node_ref = (*gi).second;
+        node->add_child(node_ref);
+      }
     }
-  }
 
-  _groups[egg_group] = node;
+    _groups[egg_group] = node;
+  }
   return create_group_arc(egg_group, parent, node);
 }
 
@@ -2093,6 +2375,7 @@ create_group_arc(EggGroup *egg_group, PandaNode *parent, PandaNode *node) {
     // descendant groups will be decaled onto the geometry within
     // this group.  This means we'll need to reparent things a bit
     // afterward.
+    MutexHolder holder(_lock);
     _decals.insert(node);
   }
 
@@ -2133,6 +2416,7 @@ create_group_arc(EggGroup *egg_group, PandaNode *parent, PandaNode *node) {
   }
 
   if (def._flags != 0) {
+    MutexHolder holder(_lock);
     _deferred_nodes[node] = def;
   }
 
@@ -2242,10 +2526,13 @@ make_vertex_data(const EggRenderState *render_state,
   vpt._bake_in_uvs = render_state->_bake_in_uvs;
   vpt._transform = transform;
 
-  VertexPoolData::iterator di;
-  di = _vertex_pool_data.find(vpt);
-  if (di != _vertex_pool_data.end()) {
-    return (*di).second;
+  {
+    MutexHolder holder(_lock);
+    VertexPoolData::iterator di;
+    di = _vertex_pool_data.find(vpt);
+    if (di != _vertex_pool_data.end()) {
+      return (*di).second;
+    }
   }
 
   PT(GeomVertexArrayFormat) array_format = new GeomVertexArrayFormat;
@@ -2537,9 +2824,12 @@ make_vertex_data(const EggRenderState *render_state,
     }
   }
 
-  bool inserted = _vertex_pool_data.insert
-    (VertexPoolData::value_type(vpt, vertex_data)).second;
-  nassertr(inserted, vertex_data);
+  {
+    MutexHolder holder(_lock);
+    bool inserted = _vertex_pool_data.insert
+      (VertexPoolData::value_type(vpt, vertex_data)).second;
+    nassertr(inserted, vertex_data);
+  }
 
   Thread::consider_yield();
   return vertex_data;
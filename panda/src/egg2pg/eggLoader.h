@@ -38,6 +38,7 @@
 #include "geomVertexData.h"
 #include "geomPrimitive.h"
 #include "bamCacheRecord.h"
+#include "pmutex.h"
 
 class EggNode;
 class EggBin;
@@ -120,6 +121,7 @@ private:
                           const LMatrix4d &mat);
 
   void load_textures();
+  void load_texture_item(int item);
   bool load_texture(TextureDef &def, EggTexture *egg_tex);
   void apply_texture_attributes(Texture *tex, const EggTexture *egg_tex);
   Texture::CompressionMode convert_compression_mode(EggTexture::CompressionMode compression_mode) const;
@@ -129,6 +131,17 @@ private:
   void separate_switches(EggNode *egg_node);
   void emulate_bface(EggNode *egg_node);
 
+  bool can_make_subtrees();
+  static bool has_characters(const EggGroupNode *egg_group);
+  static bool is_independent_subtree(const EggNode *egg_node);
+  void make_subtrees();
+  void make_subtree_item(int item);
+
+  typedef void (EggLoader::*ItemMethod)(int item);
+  void run_parallel(ItemMethod method, int num_items);
+  static void st_parallel_main(void *data, int begin, int end);
+  static int get_num_threads();
+
   PandaNode *make_node(EggNode *egg_node, PandaNode *parent);
   PandaNode *make_node(EggBin *egg_bin, PandaNode *parent);
   PandaNode *make_polyset(EggBin *egg_bin, PandaNode *parent);
@@ -256,6 +269,37 @@ private:
 
   DeferredNodes _deferred_nodes;
 
+  // These hold the work in progress while load_textures() and
+  // make_subtrees() share it out among several threads.
+  class TextureLoad {
+  public:
+    PT_EggTexture _egg_tex;
+    TextureDef _def;
+    bool _success;
+  };
+  typedef pvector<TextureLoad> TextureLoads;
+  TextureLoads _texture_loads;
+
+  class Subtree {
+  public:
+    PT(EggNode) _egg_node;
+    PT(PandaNode) _holder;
+  };
+  typedef pvector<Subtree> Subtrees;
+  Subtrees _subtrees;
+
+  class ParallelWork {
+  public:
+    EggLoader *_loader;
+    ItemMethod _method;
+    int _num_items;
+    int _next_item;
+  };
+
+  // This protects the above tables, and the egg vertices shared
+  // between subtrees, while several threads are converting at once.
+  Mutex _lock;
+
 public:
   PT(PandaNode) _root;
   PT(EggData) _data;
@@ -37,6 +37,7 @@
 #include "materialPool.h"
 #include "config_gobj.h"
 #include "config_egg2pg.h"
+#include "mutexHolder.h"
 
 
 ////////////////////////////////////////////////////////////////////
@@ -108,8 +109,11 @@ fill_state(EggPrimitive *egg_prim) {
   for (int i = 0; i < num_textures; i++) {
     PT_EggTexture egg_tex = egg_prim->get_texture(i);
 
-    const TextureDef &def = _loader._textures[egg_tex];
-    if (def._texture != (const RenderAttrib *)NULL) {
+    // We use find() here rather than operator [], since several
+    // threads may be consulting this table at once.
+    Textures::const_iterator ti = _loader._textures.find(egg_tex);
+    if (ti != _loader._textures.end()) {
+      const TextureDef &def = (*ti).second;
       if (texture_attrib == (RenderAttrib *)NULL) {
         texture_attrib = def._texture;
       } else {
@@ -486,10 +490,13 @@ get_material_attrib(const EggMaterial *egg_mat, bool bface) {
     bface ? _loader._materials_bface : _loader._materials;
 
   // First, check whether we've seen this material before.
-  Materials::const_iterator mi;
-  mi = materials.find(egg_mat);
-  if (mi != materials.end()) {
-    return (*mi).second;
+  {
+    MutexHolder holder(_loader._lock);
+    Materials::const_iterator mi;
+    mi = materials.find(egg_mat);
+    if (mi != materials.end()) {
+      return (*mi).second;
+    }
   }
 
   // Ok, this is the first time we've seen this particular
@@ -524,9 +531,11 @@ get_material_attrib(const EggMaterial *egg_mat, bool bface) {
 
   // And create a MaterialAttrib for this Material.
   CPT(RenderAttrib) mt = MaterialAttrib::make(shared_mat);
-  materials.insert(Materials::value_type(egg_mat, mt));
 
-  return mt;
+  // Another thread may have made the same material in the meantime;
+  // if so, we keep the first one.
+  MutexHolder holder(_loader._lock);
+  return (*materials.insert(Materials::value_type(egg_mat, mt)).first).second;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -65,6 +65,7 @@ public:
 
   typedef EggLoader::BakeInUVs BakeInUVs;
   typedef EggLoader::TextureDef TextureDef;
+  typedef EggLoader::Textures Textures;
   typedef EggLoader::Materials Materials;
 
   BakeInUVs _bake_in_uvs;
@@ -0,0 +1,211 @@
+// Filename: test_eggLoader.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "pandabase.h"
+#include "load_egg_file.h"
+#include "config_egg2pg.h"
+#include "config_pnmimagetypes.h"
+#include "eggData.h"
+#include "geomNode.h"
+#include "geomVertexArrayData.h"
+#include "textureAttrib.h"
+#include "texturePool.h"
+#include "pnmImage.h"
+#include "filename.h"
+#include "testCheck.h"
+
+// This program converts an egg file made of several independent
+// toplevel groups, some of them textured and one of them referring to
+// another, with egg-load-threads set to 1 and then to 4, and checks
+// that both give the same scene graph, down to the vertex data.
+
+static const int num_groups = 12;
+
+static TestCheck check;
+
+////////////////////////////////////////////////////////////////////
+//     Function: make_egg_syntax
+//  Description: Returns the text of an egg file with the indicated
+//               textures, and num_groups toplevel groups of
+//               polygons.
+////////////////////////////////////////////////////////////////////
+static string
+make_egg_syntax(const Filename &tex_a, const Filename &tex_b) {
+  ostringstream egg;
+  egg << "<CoordinateSystem> { Z-up }\n"
+      << "<Texture> tex_a { \"" << tex_a << "\" }\n"
+      << "<Texture> tex_b { \"" << tex_b << "\" }\n";
+
+  for (int g = 0; g < num_groups; ++g) {
+    if (g == num_groups - 1) {
+      // The last group instances the first, so it must be converted on
+      // the loading thread.
+      egg << "<Instance> group" << g << " {\n"
+          << "  <Ref> { group0 }\n";
+    } else {
+      egg << "<Group> group" << g << " {\n";
+    }
+    egg << "  <Transform> { <Translate> { " << g * 3 << " 0 0 } }\n"
+        << "  <VertexPool> pool" << g << " {\n";
+    for (int v = 0; v < 4 * (g + 1); ++v) {
+      egg << "    <Vertex> " << v << " { " << v % 7 << " " << v / 7 << " "
+          << g << " <UV> { " << (v % 2) << " " << (v / 2) % 2 << " } }\n";
+    }
+    egg << "  }\n";
+    for (int p = 0; p < g + 1; ++p) {
+      egg << "  <Polygon> {\n";
+      if (g % 3 == 1) {
+        egg << "    <TRef> { tex_a }\n";
+      } else if (g % 3 == 2) {
+        egg << "    <TRef> { tex_b }\n";
+      }
+      egg << "    <RGBA> { " << (g % 2) << " 1 " << (p % 2) << " 1 }\n"
+          << "    <VertexRef> { " << p * 4 << " " << p * 4 + 1 << " "
+          << p * 4 + 2 << " " << p * 4 + 3 << " <Ref> { pool" << g << " } }\n"
+          << "  }\n";
+    }
+    egg << "}\n";
+  }
+  return egg.str();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: describe
+//  Description: Writes a description of the scene graph below the
+//               node, including the contents of every vertex array,
+//               in a form that can be compared between loads.
+////////////////////////////////////////////////////////////////////
+static void
+describe(ostream &out, PandaNode *node, int indent_level) {
+  indent(out, indent_level)
+    << node->get_type() << " " << node->get_name() << " "
+    << *node->get_transform() << " " << *node->get_state() << "\n";
+
+  if (node->is_geom_node()) {
+    GeomNode *gnode = DCAST(GeomNode, node);
+    for (int i = 0; i < gnode->get_num_geoms(); ++i) {
+      const Geom *geom = gnode->get_geom(i);
+      indent(out, indent_level + 2)
+        << "geom " << geom->get_primitive_type() << " "
+        << *gnode->get_geom_state(i) << "\n";
+
+      // Textures are shared through the TexturePool, so we identify
+      // them by name rather than by pointer.
+      const TextureAttrib *ta;
+      if (gnode->get_geom_state(i)->get_attrib(ta)) {
+        for (int s = 0; s < ta->get_num_on_stages(); ++s) {
+          indent(out, indent_level + 4)
+            << "texture " << ta->get_on_texture(ta->get_on_stage(s))->get_name()
+            << "\n";
+        }
+      }
+
+      for (int p = 0; p < geom->get_num_primitives(); ++p) {
+        CPT(GeomPrimitive) prim = geom->get_primitive(p);
+        indent(out, indent_level + 4)
+          << prim->get_type() << " " << prim->get_num_vertices() << ":";
+        for (int v = 0; v < prim->get_num_vertices(); ++v) {
+          out << " " << prim->get_vertex(v);
+        }
+        out << "\n";
+      }
+
+      CPT(GeomVertexData) vdata = geom->get_vertex_data();
+      indent(out, indent_level + 4)
+        << *vdata->get_format() << " " << vdata->get_num_rows() << " rows\n";
+      for (int a = 0; a < vdata->get_num_arrays(); ++a) {
+        CPT(GeomVertexArrayData) array = vdata->get_array(a);
+        string data = array->get_handle()->get_data();
+        indent(out, indent_level + 4) << "array " << a << ":" << hex;
+        for (size_t b = 0; b < data.size(); ++b) {
+          out << " " << (int)(unsigned char)data[b];
+        }
+        out << dec << "\n";
+      }
+    }
+  }
+
+  for (int i = 0; i < node->get_num_children(); ++i) {
+    describe(out, node->get_child(i), indent_level + 2);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: load
+//  Description: Converts the egg syntax with the indicated number of
+//               threads, and returns the description of the result.
+////////////////////////////////////////////////////////////////////
+static string
+load(const string &syntax, int num_threads) {
+  egg_load_threads = num_threads;
+
+  // Release the textures from the previous load, so that each load
+  // reads them again.
+  TexturePool::release_all_textures();
+
+  PT(EggData) data = new EggData;
+  istringstream in(syntax);
+  if (!data->read(in)) {
+    check(false, "egg syntax is valid");
+    return string();
+  }
+
+  PT(PandaNode) root = load_egg_data(data);
+  if (root == (PandaNode *)NULL) {
+    check(false, "egg data converted");
+    return string();
+  }
+
+  ostringstream out;
+  describe(out, root, 0);
+  return out.str();
+}
+
+int
+main(int argc, char *argv[]) {
+  init_libegg2pg();
+  init_libpnmimagetypes();
+
+  Filename dir = Filename::temporary("", "eggload_");
+  dir.mkdir();
+  Filename tex_a(dir, "tex_a.ppm");
+  Filename tex_b(dir, "tex_b.ppm");
+  PNMImage image(8, 8, 3);
+  image.fill(1.0f, 0.0f, 0.0f);
+  check(image.write(tex_a), "write tex_a");
+  image.fill(0.0f, 0.0f, 1.0f);
+  check(image.write(tex_b), "write tex_b");
+
+  string syntax = make_egg_syntax(tex_a, tex_b);
+  string serial = load(syntax, 1);
+  string threaded = load(syntax, 4);
+
+  check(!serial.empty(), "serial load");
+  check(serial == threaded, "threaded load matches serial load");
+  check(serial.find(tex_a.get_basename_wo_extension()) != string::npos &&
+        serial.find(tex_b.get_basename_wo_extension()) != string::npos,
+        "both textures applied");
+  if (serial != threaded) {
+    nout << "Serial:\n" << serial << "\nThreaded:\n" << threaded << "\n";
+  }
+
+  // Loading again on several threads gives the same result again.
+  check(load(syntax, 4) == threaded, "second threaded load matches");
+
+  tex_a.unlink();
+  tex_b.unlink();
+  dir.rmdir();
+
+  return check.report();
+}
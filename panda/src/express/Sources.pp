@@ -55,12 +55,14 @@
     pta_int.h \
     pta_uchar.h pta_double.h pta_float.h \
     pta_stdfloat.h \
+    radixSort.h radixSort.I radixSort.T \
     ramfile.I ramfile.h ramfile_ext.h \
     referenceCount.I referenceCount.h \
     subStream.I subStream.h subStreamBuf.h \
     subfileInfo.h subfileInfo.I \
     streamReader_ext.h \
     temporaryFile.h temporaryFile.I \
+    testCheck.h testCheck.I \
     threadSafePointerTo.I threadSafePointerTo.h \
     threadSafePointerToBase.I threadSafePointerToBase.h \
     trueClock.I trueClock.h \
@@ -185,11 +187,13 @@
     pta_int.h \
     pta_uchar.h pta_double.h pta_float.h \
     pta_stdfloat.h \
+    radixSort.h radixSort.I radixSort.T \
     ramfile.I ramfile.h \
     referenceCount.I referenceCount.h \
     subStream.I subStream.h subStreamBuf.h \
     subfileInfo.h subfileInfo.I \
     temporaryFile.h temporaryFile.I \
+    testCheck.h testCheck.I \
     threadSafePointerTo.I threadSafePointerTo.h \
     threadSafePointerToBase.I threadSafePointerToBase.h \
     trueClock.I trueClock.h \
@@ -275,3 +279,16 @@
 
 #end test_bin_target
 #endif
+
+#if $[HAVE_OPENSSL]
+#begin test_bin_target
+  #define TARGET test_patchfile
+  #define USE_PACKAGES openssl
+  #define LOCAL_LIBS $[LOCAL_LIBS] p3express
+  #define OTHER_LIBS p3dtoolutil:c p3dtool:m p3prc:c p3dtoolconfig:m p3pystub
+
+  #define SOURCES \
+    test_patchfile.cxx
+
+#end test_bin_target
+#endif
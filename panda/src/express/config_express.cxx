@@ -57,6 +57,25 @@ ConfigVariableInt patchfile_buffer_size
 ConfigVariableInt patchfile_zone_size
 ("patchfile-zone-size", 10000);
 
+ConfigVariableInt patchfile_block_size
+("patchfile-block-size", 256,
+ PRC_DESC("The size of the blocks into which the original file is divided "
+          "when building a patch by block matching.  See "
+          "patchfile-block-threshold."));
+
+ConfigVariableInt patchfile_block_threshold
+("patchfile-block-threshold", 67108864,
+ PRC_DESC("Files (or Multifile subfiles) at least this large are patched "
+          "by matching blocks of the original file with a rolling "
+          "checksum, reading both files a piece at a time, instead of by "
+          "the footprint algorithm, which needs both files entirely in "
+          "memory, plus four bytes per byte of the original file."));
+
+ConfigVariableInt patchfile_num_threads
+("patchfile-num-threads", 4,
+ PRC_DESC("The number of threads that hash and match blocks when building "
+          "a patch by block matching."));
+
 ConfigVariableBool keep_temporary_files
 ("keep-temporary-files", false,
  PRC_DESC("Set this true to keep around the temporary files from "
@@ -53,6 +53,9 @@ extern ConfigVariableInt patchfile_window_size;
 extern ConfigVariableInt patchfile_increment_size;
 extern ConfigVariableInt patchfile_buffer_size;
 extern ConfigVariableInt patchfile_zone_size;
+extern ConfigVariableInt patchfile_block_size;
+extern ConfigVariableInt patchfile_block_threshold;
+extern ConfigVariableInt patchfile_num_threads;
 
 extern ConfigVariableBool keep_temporary_files;
 extern ConfigVariableBool multifile_always_binary;
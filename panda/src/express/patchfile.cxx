@@ -24,9 +24,19 @@
 #include "multifile.h"
 #include "hashVal.h"
 #include "virtualFileSystem.h"
+#include "selectThreadImpl.h"
+
+#include "openSSLWrapper.h"  // must be included before any other openssl.
+#include "openssl/md5.h"
 
 #include <string.h>  // for strstr
 
+#if defined(THREAD_WIN32_IMPL)
+#include <windows.h>
+#elif defined(THREAD_POSIX_IMPL)
+#include <pthread.h>
+#endif
+
 #ifdef HAVE_TAR
 #include "libtar.h"
 #include <fcntl.h>  // for O_RDONLY
@@ -133,8 +143,12 @@ init(PT(Buffer) buffer) {
 
   _patch_stream = NULL;
   _origfile_stream = NULL;
+  _MD5_ofOutput = NULL;
 
   reset_footprint_length();
+  _block_size = max((int)patchfile_block_size, 0);
+  _block_threshold = max((int)patchfile_block_threshold, 0);
+  _num_threads = max((int)patchfile_num_threads, 1);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -182,6 +196,11 @@ cleanup() {
   }
   _write_stream.close();
 
+  if (_MD5_ofOutput != NULL) {
+    delete _MD5_ofOutput;
+    _MD5_ofOutput = NULL;
+  }
+
   _initiated = false;
 }
 
@@ -260,6 +279,12 @@ initiate(const Filename &patch_file, const Filename &orig_file,
   int result = internal_read_header(patch_file);
   _total_bytes_processed = 0;
 
+  // The result is hashed as it is written, so that it needn't be read
+  // back again to check it.
+  nassertr(_MD5_ofOutput == NULL, EU_error_abort);
+  _MD5_ofOutput = new MD5_CTX;
+  MD5_Init(_MD5_ofOutput);
+
   _initiated = true;
   return result;
 }
@@ -361,6 +386,7 @@ run() {
         return EU_error_file_invalid;
       }
       _write_stream.write(_buffer->_buffer, bytes_this_time);
+      MD5_Update(_MD5_ofOutput, _buffer->_buffer, bytes_this_time);
       bytes_left -= bytes_this_time;
     }
 
@@ -425,12 +451,17 @@ run() {
           return EU_error_file_invalid;
         }
         _write_stream.write(_buffer->_buffer, bytes_this_time);
+        MD5_Update(_MD5_ofOutput, _buffer->_buffer, bytes_this_time);
         bytes_left -= bytes_this_time;
       }
     }
 
     // if we got a pair of zero-length ADD and COPY blocks, we're done
     if ((0 == ADD_length) && (0 == COPY_length)) {
+      unsigned char md[16];
+      MD5_Final(md, _MD5_ofOutput);
+      _write_stream.flush();
+      bool write_failed = _write_stream.fail();
       cleanup();
 
       if (express_cat.is_debug()) {
@@ -439,10 +470,20 @@ run() {
           << " total bytes = " << _total_bytes_processed << endl;
       }
 
+      if (write_failed) {
+        express_cat.error()
+          << "Patchfile::run() - Failed to write " << _output_file << endl;
+        if (_rename_output_to_orig) {
+          _output_file.unlink();
+        }
+        return get_write_error();
+      }
+
       // check the MD5 from the patch file against the newly patched file
       {
         HashVal MD5_actual;
-        MD5_actual.hash_file(_output_file);
+        istringstream md_stream(string((char *)md, 16));
+        MD5_actual.input_binary(md_stream);
         if (_MD5_ofResult != MD5_actual) {
           // Whoops, patching screwed up somehow.
           if (_origfile_stream != NULL) {
@@ -944,6 +985,23 @@ cache_add_and_copy(ostream &write_stream,
     }
     // Add the string to the current cache.
     _cache_add_data += string(add_buffer, add_length);
+
+    static const size_t max_write = 65535;
+    static const size_t max_cache_add = max_write * 16;
+    if (_cache_add_data.size() > max_cache_add) {
+      // Don't let a long run of new data pile up in memory.  Since
+      // there's no copy pending, the whole ADD blocks at the front of
+      // the cache can be written now, exactly as cache_flush() would
+      // eventually write them; we keep back at least one byte for
+      // the last ADD.
+      size_t num_blocks = (_cache_add_data.size() - 1) / max_write;
+      const char *data = _cache_add_data.data();
+      for (size_t i = 0; i < num_blocks; ++i) {
+        emit_ADD(write_stream, max_write, data + i * max_write);
+        emit_COPY(write_stream, 0, 0);
+      }
+      _cache_add_data = _cache_add_data.substr(num_blocks * max_write);
+    }
   }
 
   if (copy_length != 0) {
@@ -980,6 +1038,29 @@ cache_flush(ostream &write_stream) {
   _cache_copy_length = 0;
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: Patchfile::cache_add_from_stream
+//       Access: Private
+//  Description: Adds the indicated range of the stream to the current
+//               ADD phase, a piece at a time, as for a subfile that
+//               is new in its entirety.
+////////////////////////////////////////////////////////////////////
+void Patchfile::
+cache_add_from_stream(ostream &write_stream, istream &stream,
+                      streampos start, size_t size) {
+  static const size_t buffer_size = 1024 * 1024;
+  char *buffer = (char *)PANDA_MALLOC_ARRAY(min(size, buffer_size));
+
+  stream.seekg(start, ios::beg);
+  while (size > 0) {
+    size_t length = min(size, buffer_size);
+    stream.read(buffer, length);
+    cache_add_and_copy(write_stream, length, buffer, 0, 0);
+    size -= length;
+  }
+
+  PANDA_FREE_ARRAY(buffer);
+}
 
 ////////////////////////////////////////////////////////////////////
 //     Function: Patchfile::write_header
@@ -1039,6 +1120,527 @@ write_terminator(ostream &write_stream) {
   emit_COPY(write_stream, 0, 0);
 }
 
+////////////////////////////////////////////////////////////////////
+//       Class : PatchfileBlockIndex
+// Description : The table of blocks of the original file, used by
+//               Patchfile::compute_block_patches().  Each full block
+//               of the original file is recorded with a weak rolling
+//               checksum, which can be updated a byte at a time as it
+//               slides along the new file, and a strong hash, which
+//               confirms a match when the checksums agree.
+//
+//               The blocks are then chained by checksum into a hash
+//               table, in the same way as the hash and link tables
+//               used by the footprint algorithm.
+////////////////////////////////////////////////////////////////////
+class PatchfileBlockIndex {
+public:
+  PatchfileBlockIndex(PN_uint32 block_size, PN_uint32 num_blocks);
+  ~PatchfileBlockIndex();
+
+  void build_hash_table();
+  PN_uint32 find_block(PN_uint32 checksum, const unsigned char *data,
+                       PN_uint32 expected_block) const;
+
+  static inline PN_uint32 calc_checksum(const unsigned char *data,
+                                        PN_uint32 length,
+                                        PN_uint32 &a, PN_uint32 &b);
+  static inline void roll_checksum(PN_uint32 length,
+                                   unsigned char out_byte,
+                                   unsigned char in_byte,
+                                   PN_uint32 &a, PN_uint32 &b);
+  static PN_uint64 calc_strong_hash(const unsigned char *data,
+                                    PN_uint32 length);
+
+  inline PN_uint32 get_bucket(PN_uint32 checksum) const;
+
+  static const PN_uint32 _NULL_VALUE;
+
+  PN_uint32 _block_size;
+  PN_uint32 _num_blocks;
+  PN_uint32 *_checksums;
+  PN_uint64 *_strong_hashes;
+
+  int _hash_bits;
+  PN_uint32 *_hash_table;
+  PN_uint32 *_link_table;
+};
+
+const PN_uint32 PatchfileBlockIndex::_NULL_VALUE = PN_uint32(0) - 1;
+
+////////////////////////////////////////////////////////////////////
+//     Function: PatchfileBlockIndex::Constructor
+//       Access: Public
+//  Description: Allocates room for the indicated number of blocks.
+//               Their checksums and hashes must then be filled in
+//               before build_hash_table() is called.
+////////////////////////////////////////////////////////////////////
+PatchfileBlockIndex::
+PatchfileBlockIndex(PN_uint32 block_size, PN_uint32 num_blocks) :
+  _block_size(block_size),
+  _num_blocks(num_blocks)
+{
+  // The hash table has at least twice as many entries as there are
+  // blocks, so that most chains are empty or very short.
+  _hash_bits = 10;
+  while (_hash_bits < 31 && (PN_uint32(1) << _hash_bits) < num_blocks * 2) {
+    ++_hash_bits;
+  }
+
+  size_t num_entries = max(num_blocks, (PN_uint32)1);
+  _checksums = (PN_uint32 *)PANDA_MALLOC_ARRAY(num_entries * sizeof(PN_uint32));
+  _strong_hashes = (PN_uint64 *)PANDA_MALLOC_ARRAY(num_entries * sizeof(PN_uint64));
+  _link_table = (PN_uint32 *)PANDA_MALLOC_ARRAY(num_entries * sizeof(PN_uint32));
+  _hash_table = (PN_uint32 *)PANDA_MALLOC_ARRAY((PN_uint32(1) << _hash_bits) * sizeof(PN_uint32));
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: PatchfileBlockIndex::Destructor
+//       Access: Public
+//  Description:
+////////////////////////////////////////////////////////////////////
+PatchfileBlockIndex::
+~PatchfileBlockIndex() {
+  PANDA_FREE_ARRAY(_checksums);
+  PANDA_FREE_ARRAY(_strong_hashes);
+  PANDA_FREE_ARRAY(_link_table);
+  PANDA_FREE_ARRAY(_hash_table);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: PatchfileBlockIndex::build_hash_table
+//       Access: Public
+//  Description: Chains the blocks into the hash table by checksum,
+//               once all of their checksums and hashes are known.
+////////////////////////////////////////////////////////////////////
+void PatchfileBlockIndex::
+build_hash_table() {
+  PN_uint32 table_size = PN_uint32(1) << _hash_bits;
+  for (PN_uint32 i = 0; i < table_size; ++i) {
+    _hash_table[i] = _NULL_VALUE;
+  }
+
+  for (PN_uint32 bi = 0; bi < _num_blocks; ++bi) {
+    PN_uint32 bucket = get_bucket(_checksums[bi]);
+    PN_uint32 head = _hash_table[bucket];
+    if (head != _NULL_VALUE && _checksums[head] == _checksums[bi] &&
+        _strong_hashes[head] == _strong_hashes[bi]) {
+      // This block is the same as the one before it in the chain
+      // (typically a run of padding); there's no need to chain it,
+      // which would only make the chain longer.
+      _link_table[bi] = _NULL_VALUE;
+      continue;
+    }
+    _link_table[bi] = head;
+    _hash_table[bucket] = bi;
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: PatchfileBlockIndex::find_block
+//       Access: Public
+//  Description: Returns the index of a block of the original file
+//               whose contents are the same as the block_size bytes
+//               at data, which have the indicated checksum, or
+//               _NULL_VALUE if there is no such block.
+//
+//               If expected_block is such a block, it is returned in
+//               preference to any other, so that a run of unchanged
+//               blocks is copied in one piece.
+////////////////////////////////////////////////////////////////////
+PN_uint32 PatchfileBlockIndex::
+find_block(PN_uint32 checksum, const unsigned char *data,
+           PN_uint32 expected_block) const {
+  PN_uint32 bi = _hash_table[get_bucket(checksum)];
+  if (bi == _NULL_VALUE) {
+    return _NULL_VALUE;
+  }
+
+  // The strong hash is only computed once a checksum matches.
+  bool have_hash = false;
+  PN_uint64 hash = 0;
+
+  if (expected_block < _num_blocks && _checksums[expected_block] == checksum) {
+    hash = calc_strong_hash(data, _block_size);
+    have_hash = true;
+    if (_strong_hashes[expected_block] == hash) {
+      return expected_block;
+    }
+  }
+
+  for (; bi != _NULL_VALUE; bi = _link_table[bi]) {
+    if (_checksums[bi] == checksum) {
+      if (!have_hash) {
+        hash = calc_strong_hash(data, _block_size);
+        have_hash = true;
+      }
+      if (_strong_hashes[bi] == hash) {
+        return bi;
+      }
+    }
+  }
+
+  return _NULL_VALUE;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: PatchfileBlockIndex::calc_checksum
+//       Access: Public, Static
+//  Description: Computes the rolling checksum of the indicated bytes.
+//               This is the checksum used by rsync: a is the sum of
+//               the bytes, and b is the sum of each byte weighted by
+//               its distance from the end, both modulo 2^16.  The
+//               two halves are returned combined, and also separately
+//               in a and b, for passing to roll_checksum().
+////////////////////////////////////////////////////////////////////
+inline PN_uint32 PatchfileBlockIndex::
+calc_checksum(const unsigned char *data, PN_uint32 length,
+              PN_uint32 &a, PN_uint32 &b) {
+  a = 0;
+  b = 0;
+  for (PN_uint32 i = 0; i < length; ++i) {
+    a += data[i];
+    b += a;
+  }
+  a &= 0xffff;
+  b &= 0xffff;
+  return a | (b << 16);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: PatchfileBlockIndex::roll_checksum
+//       Access: Public, Static
+//  Description: Slides the checksum computed by calc_checksum()
+//               along by one byte, removing out_byte from the front
+//               and adding in_byte to the end.
+////////////////////////////////////////////////////////////////////
+inline void PatchfileBlockIndex::
+roll_checksum(PN_uint32 length, unsigned char out_byte, unsigned char in_byte,
+              PN_uint32 &a, PN_uint32 &b) {
+  a = (a - out_byte + in_byte) & 0xffff;
+  b = (b - length * out_byte + a) & 0xffff;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: PatchfileBlockIndex::calc_strong_hash
+//       Access: Public, Static
+//  Description: Computes a 64-bit hash of the indicated bytes, which
+//               is much less likely than the rolling checksum to
+//               agree by accident.  This is a variant of FNV-1a that
+//               takes eight bytes at a time.  (Should it ever agree
+//               by accident anyway, the patch will fail its MD5 check
+//               when it is applied.)
+////////////////////////////////////////////////////////////////////
+PN_uint64 PatchfileBlockIndex::
+calc_strong_hash(const unsigned char *data, PN_uint32 length) {
+  static const PN_uint64 prime = ((PN_uint64)0x100 << 32) | 0x1b3;
+  PN_uint64 hash = ((PN_uint64)0xcbf29ce4 << 32) | 0x84222325;
+
+  PN_uint32 i = 0;
+  for (; i + 8 <= length; i += 8) {
+    PN_uint64 word;
+    memcpy(&word, data + i, 8);
+    hash = (hash ^ word) * prime;
+    hash ^= (hash >> 29);
+  }
+  for (; i < length; ++i) {
+    hash = (hash ^ data[i]) * prime;
+  }
+  return hash;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: PatchfileBlockIndex::get_bucket
+//       Access: Public
+//  Description: Returns the hash table entry for the indicated
+//               checksum.
+////////////////////////////////////////////////////////////////////
+inline PN_uint32 PatchfileBlockIndex::
+get_bucket(PN_uint32 checksum) const {
+  return (PN_uint32)(checksum * 2654435761U) >> (32 - _hash_bits);
+}
+
+////////////////////////////////////////////////////////////////////
+//       Class : PatchfileJob
+// Description : One piece of the work of building a patch by block
+//               matching, which may be done on a thread of its own.
+////////////////////////////////////////////////////////////////////
+class PatchfileJob {
+public:
+  virtual ~PatchfileJob() {}
+  virtual void do_job() = 0;
+
+#if defined(THREAD_WIN32_IMPL)
+  static DWORD WINAPI thread_main(LPVOID data);
+#elif defined(THREAD_POSIX_IMPL)
+  static void *thread_main(void *data);
+#endif
+};
+
+#if defined(THREAD_WIN32_IMPL)
+////////////////////////////////////////////////////////////////////
+//     Function: PatchfileJob::thread_main
+//       Access: Public, Static
+//  Description: The entry point of a thread started by run_jobs().
+////////////////////////////////////////////////////////////////////
+DWORD WINAPI PatchfileJob::
+thread_main(LPVOID data) {
+  ((PatchfileJob *)data)->do_job();
+  return 0;
+}
+#elif defined(THREAD_POSIX_IMPL)
+////////////////////////////////////////////////////////////////////
+//     Function: PatchfileJob::thread_main
+//       Access: Public, Static
+//  Description: The entry point of a thread started by run_jobs().
+////////////////////////////////////////////////////////////////////
+void *PatchfileJob::
+thread_main(void *data) {
+  ((PatchfileJob *)data)->do_job();
+  return NULL;
+}
+#endif
+
+////////////////////////////////////////////////////////////////////
+//     Function: run_jobs
+//  Description: Does the indicated jobs in parallel, each on its own
+//               thread, and returns when they are all finished.  The
+//               first job is done on the calling thread.
+//
+//               Patchfile lives below the pipeline library, so this
+//               uses the OS threads directly, rather than Thread.  If
+//               Panda was built without real threads, the jobs are
+//               simply done one after another.
+////////////////////////////////////////////////////////////////////
+static void
+run_jobs(PatchfileJob **jobs, int num_jobs) {
+  if (num_jobs == 0) {
+    return;
+  }
+
+#if defined(THREAD_WIN32_IMPL)
+  pvector<HANDLE> threads;
+  for (int i = 1; i < num_jobs; ++i) {
+    HANDLE thread = CreateThread(NULL, 0, &PatchfileJob::thread_main,
+                                 (LPVOID)jobs[i], 0, NULL);
+    if (thread == NULL) {
+      jobs[i]->do_job();
+    } else {
+      threads.push_back(thread);
+    }
+  }
+  jobs[0]->do_job();
+  for (size_t i = 0; i < threads.size(); ++i) {
+    WaitForSingleObject(threads[i], INFINITE);
+    CloseHandle(threads[i]);
+  }
+
+#elif defined(THREAD_POSIX_IMPL)
+  pvector<pthread_t> threads;
+  for (int i = 1; i < num_jobs; ++i) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, &PatchfileJob::thread_main,
+                       (void *)jobs[i]) != 0) {
+      jobs[i]->do_job();
+    } else {
+      threads.push_back(thread);
+    }
+  }
+  jobs[0]->do_job();
+  for (size_t i = 0; i < threads.size(); ++i) {
+    pthread_join(threads[i], NULL);
+  }
+
+#else
+  for (int i = 0; i < num_jobs; ++i) {
+    jobs[i]->do_job();
+  }
+#endif
+}
+
+////////////////////////////////////////////////////////////////////
+//       Class : PatchfileSignatureJob
+// Description : Computes the checksums and hashes of a range of
+//               blocks of the original file, which have been read
+//               into memory.
+////////////////////////////////////////////////////////////////////
+class PatchfileSignatureJob : public PatchfileJob {
+public:
+  virtual void do_job();
+
+  PatchfileBlockIndex *_index;
+  const unsigned char *_data;
+  PN_uint32 _first_block;
+  PN_uint32 _num_blocks;
+};
+
+////////////////////////////////////////////////////////////////////
+//     Function: PatchfileSignatureJob::do_job
+//       Access: Public, Virtual
+//  Description:
+////////////////////////////////////////////////////////////////////
+void PatchfileSignatureJob::
+do_job() {
+  PN_uint32 block_size = _index->_block_size;
+  const unsigned char *data = _data;
+  for (PN_uint32 bi = _first_block; bi < _first_block + _num_blocks; ++bi) {
+    PN_uint32 a, b;
+    _index->_checksums[bi] =
+      PatchfileBlockIndex::calc_checksum(data, block_size, a, b);
+    _index->_strong_hashes[bi] =
+      PatchfileBlockIndex::calc_strong_hash(data, block_size);
+    data += block_size;
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//       Class : PatchfileMatchJob
+// Description : Slides the rolling checksum along a range of the new
+//               file, which has been read into memory, and lists the
+//               blocks of the original file that it finds there.
+//               After each match, the search resumes at the end of
+//               the matched block.
+////////////////////////////////////////////////////////////////////
+class PatchfileMatchJob : public PatchfileJob {
+public:
+  virtual void do_job();
+
+  class Match {
+  public:
+    PN_uint32 _pos;
+    PN_uint32 _block;
+  };
+  typedef pvector<Match> Matches;
+
+  const PatchfileBlockIndex *_index;
+
+  // Matches may start anywhere from _start up to (but not including)
+  // _end, and may run past _end, up to _data_length.
+  const unsigned char *_data;
+  PN_uint32 _data_length;
+  PN_uint32 _start;
+  PN_uint32 _end;
+
+  Matches _matches;
+};
+
+////////////////////////////////////////////////////////////////////
+//     Function: PatchfileMatchJob::do_job
+//       Access: Public, Virtual
+//  Description:
+////////////////////////////////////////////////////////////////////
+void PatchfileMatchJob::
+do_job() {
+  _matches.clear();
+
+  PN_uint32 block_size = _index->_block_size;
+  if (_data_length < block_size) {
+    return;
+  }
+  PN_uint32 end = min(_end, _data_length - block_size + 1);
+
+  PN_uint32 pos = _start;
+  PN_uint32 expected_block = PatchfileBlockIndex::_NULL_VALUE;
+  PN_uint32 a = 0, b = 0;
+  bool need_checksum = true;
+
+  while (pos < end) {
+    if (need_checksum) {
+      PatchfileBlockIndex::calc_checksum(_data + pos, block_size, a, b);
+      need_checksum = false;
+    }
+
+    PN_uint32 block = _index->find_block(a | (b << 16), _data + pos,
+                                         expected_block);
+    if (block != PatchfileBlockIndex::_NULL_VALUE) {
+      Match match;
+      match._pos = pos;
+      match._block = block;
+      _matches.push_back(match);
+
+      expected_block = block + 1;
+      pos += block_size;
+      need_checksum = true;
+
+    } else {
+      // No match here; slide along by one byte.  (If pos + 1 is
+      // still short of end, there is a byte after the block to slide
+      // in.)
+      if (pos + 1 < end) {
+        PatchfileBlockIndex::roll_checksum(block_size, _data[pos],
+                                           _data[pos + block_size], a, b);
+      }
+      ++pos;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: extend_match_forward
+//  Description: Returns the number of bytes at data, up to
+//               max_length, that are the same as the bytes of the
+//               original file starting at orig_pos.  This extends a
+//               block match past the end of the block.
+////////////////////////////////////////////////////////////////////
+static PN_uint32
+extend_match_forward(istream &stream_orig, PN_uint32 orig_length,
+                     PN_uint32 orig_pos, const char *data,
+                     PN_uint32 max_length, char *buffer,
+                     PN_uint32 buffer_size) {
+  max_length = min(max_length, orig_length - orig_pos);
+
+  PN_uint32 length = 0;
+  while (length < max_length) {
+    PN_uint32 read_length = min(max_length - length, buffer_size);
+    stream_orig.clear();
+    stream_orig.seekg(orig_pos + length, ios::beg);
+    stream_orig.read(buffer, read_length);
+    PN_uint32 count = (PN_uint32)stream_orig.gcount();
+
+    PN_uint32 i = 0;
+    while (i < count && buffer[i] == data[length + i]) {
+      ++i;
+    }
+    length += i;
+    if (i < read_length) {
+      break;
+    }
+  }
+
+  return length;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: extend_match_backward
+//  Description: Returns the number of bytes before data_end, up to
+//               max_length, that are the same as the bytes of the
+//               original file before orig_pos.  This extends a block
+//               match back before the start of the block.
+////////////////////////////////////////////////////////////////////
+static PN_uint32
+extend_match_backward(istream &stream_orig, PN_uint32 orig_pos,
+                      const char *data_end, PN_uint32 max_length,
+                      char *buffer, PN_uint32 buffer_size) {
+  max_length = min(min(max_length, orig_pos), buffer_size);
+  if (max_length == 0) {
+    return 0;
+  }
+
+  stream_orig.clear();
+  stream_orig.seekg(orig_pos - max_length, ios::beg);
+  stream_orig.read(buffer, max_length);
+  if ((PN_uint32)stream_orig.gcount() != max_length) {
+    return 0;
+  }
+
+  PN_uint32 length = 0;
+  while (length < max_length &&
+         buffer[max_length - 1 - length] == data_end[-1 - (int)length]) {
+    ++length;
+  }
+  return length;
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: Patchfile::compute_file_patches
 //       Access: Private
@@ -1055,6 +1657,16 @@ compute_file_patches(ostream &write_stream,
   stream_orig.seekg(0, ios::end);
   nassertr(stream_orig, false);
   PN_uint32 source_file_length = stream_orig.tellg();
+
+  stream_new.seekg(0, ios::end);
+  nassertr(stream_new, false);
+  if (_block_size != 0 &&
+      max(source_file_length, (PN_uint32)stream_new.tellg()) >= _block_threshold) {
+    // This file is too big to hold in memory; match it a block at a
+    // time instead.
+    return compute_block_patches(write_stream, offset_orig, offset_new,
+                                 stream_orig, stream_new);
+  }
   if (express_cat.is_debug()) {
     express_cat.debug()
       << "Allocating " << source_file_length << " bytes to read orig\n";
@@ -1157,6 +1769,223 @@ compute_file_patches(ostream &write_stream,
   return true;
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: Patchfile::compute_block_patches
+//       Access: Private
+//  Description: Computes the patches for the entire file (or a
+//               single subfile) by block matching, in the manner of
+//               rsync.  Unlike compute_file_patches(), this never
+//               holds more than a window of either file in memory;
+//               the original file is represented by a table of the
+//               checksums of its blocks, about 20 bytes per block.
+//
+//               First, the original file is read a window at a time,
+//               and the checksums of its blocks are computed, in
+//               parallel.  Then the new file is read a window at a
+//               time, and each of several threads slides a rolling
+//               checksum along its own part of the window, looking
+//               for the blocks of the original file.  Each match is
+//               then extended byte-by-byte forward and backward,
+//               beyond the block boundaries, and emitted as a COPY;
+//               whatever is left over is emitted as an ADD.
+//
+//               Returns true if successful, false on error.
+////////////////////////////////////////////////////////////////////
+bool Patchfile::
+compute_block_patches(ostream &write_stream,
+                      PN_uint32 offset_orig, PN_uint32 offset_new,
+                      istream &stream_orig, istream &stream_new) {
+  stream_orig.seekg(0, ios::end);
+  nassertr(stream_orig, false);
+  PN_uint32 source_file_length = stream_orig.tellg();
+
+  stream_new.seekg(0, ios::end);
+  nassertr(stream_new, false);
+  PN_uint32 result_file_length = stream_new.tellg();
+
+  PN_uint32 block_size = _block_size;
+  nassertr(block_size > 0, false);
+  int num_threads = max(_num_threads, 1);
+
+  // Each thread works on a region of about this many bytes of each
+  // window.
+  static const PN_uint32 region_target_size = 4 * 1024 * 1024;
+  PN_uint32 region_blocks = max(region_target_size / block_size, (PN_uint32)1);
+  PN_uint32 region_size = region_blocks * block_size;
+  PN_uint32 window_size = region_size * num_threads;
+
+  if (express_cat.is_debug()) {
+    express_cat.debug()
+      << "Matching " << block_size << "-byte blocks of "
+      << source_file_length << "-byte file with " << num_threads
+      << " threads\n";
+  }
+
+  PatchfileBlockIndex index(block_size, source_file_length / block_size);
+
+  // The window has room for the start of one more block after its
+  // end, so that a match may start anywhere within it.
+  char *buffer = (char *)PANDA_MALLOC_ARRAY(window_size + block_size);
+  char *orig_buffer = (char *)PANDA_MALLOC_ARRAY(block_size);
+
+  pvector<PatchfileSignatureJob> signature_jobs(num_threads);
+  pvector<PatchfileMatchJob> match_jobs(num_threads);
+  pvector<PatchfileJob *> jobs(num_threads);
+
+  // Compute the checksums of the blocks of the original file.
+  stream_orig.seekg(0, ios::beg);
+  PN_uint32 next_block = 0;
+  while (next_block < index._num_blocks) {
+    PN_uint32 num_blocks = min(index._num_blocks - next_block,
+                               region_blocks * num_threads);
+    stream_orig.read(buffer, num_blocks * block_size);
+    if ((PN_uint32)stream_orig.gcount() != num_blocks * block_size) {
+      express_cat.error()
+        << "Unable to read original file.\n";
+      PANDA_FREE_ARRAY(buffer);
+      PANDA_FREE_ARRAY(orig_buffer);
+      return false;
+    }
+
+    int num_jobs = 0;
+    for (PN_uint32 first = 0; first < num_blocks; first += region_blocks) {
+      PatchfileSignatureJob &job = signature_jobs[num_jobs];
+      job._index = &index;
+      job._data = (const unsigned char *)buffer + first * block_size;
+      job._first_block = next_block + first;
+      job._num_blocks = min(region_blocks, num_blocks - first);
+      jobs[num_jobs] = &job;
+      ++num_jobs;
+    }
+    run_jobs(&jobs[0], num_jobs);
+    next_block += num_blocks;
+  }
+
+  index.build_hash_table();
+
+  // Now look for them in the new file.  new_pos is the start of the
+  // window: everything before it has been emitted already.  If the
+  // last thing emitted was a COPY, copy_end is where it ended in the
+  // original file, and we may be able to continue it.
+  PN_uint32 new_pos = 0;
+  PN_uint32 copy_end = 0;
+  bool extend_copy = false;
+
+  while (new_pos < result_file_length) {
+    PN_uint32 window_length = min(result_file_length - new_pos, window_size);
+    PN_uint32 data_length = min(result_file_length - new_pos,
+                                window_size + block_size - 1);
+    stream_new.clear();
+    stream_new.seekg(new_pos, ios::beg);
+    stream_new.read(buffer, data_length);
+    if ((PN_uint32)stream_new.gcount() != data_length) {
+      express_cat.error()
+        << "Unable to read new file.\n";
+      PANDA_FREE_ARRAY(buffer);
+      PANDA_FREE_ARRAY(orig_buffer);
+      return false;
+    }
+
+    int num_jobs = 0;
+    for (PN_uint32 start = 0; start < window_length; start += region_size) {
+      PatchfileMatchJob &job = match_jobs[num_jobs];
+      job._index = &index;
+      job._data = (const unsigned char *)buffer;
+      job._data_length = data_length;
+      job._start = start;
+      job._end = min(start + region_size, window_length);
+      jobs[num_jobs] = &job;
+      ++num_jobs;
+    }
+    run_jobs(&jobs[0], num_jobs);
+
+    // Emit the matches in order.  pos is the position within the
+    // window up to which we have emitted.
+    PN_uint32 pos = 0;
+    for (int ji = 0; ji < num_jobs; ++ji) {
+      const PatchfileMatchJob::Matches &matches = match_jobs[ji]._matches;
+      PatchfileMatchJob::Matches::const_iterator mi;
+      for (mi = matches.begin(); mi != matches.end(); ++mi) {
+        PN_uint32 match_pos = (*mi)._pos;
+        PN_uint32 match_orig = (*mi)._block * block_size;
+        PN_uint32 match_length = block_size;
+
+        if (match_pos < pos) {
+          // The previous match (found by the previous thread, or
+          // extended) overlaps this one.  Keep whatever is left.
+          PN_uint32 overlap = pos - match_pos;
+          if (overlap >= match_length) {
+            continue;
+          }
+          match_pos += overlap;
+          match_orig += overlap;
+          match_length -= overlap;
+        }
+
+        if (extend_copy && match_pos > pos) {
+          PN_uint32 length =
+            extend_match_forward(stream_orig, source_file_length, copy_end,
+                                 buffer + pos, match_pos - pos,
+                                 orig_buffer, block_size);
+          if (length != 0) {
+            cache_add_and_copy(write_stream, 0, NULL,
+                               length, copy_end + offset_orig);
+            pos += length;
+            copy_end += length;
+          }
+        }
+
+        if (match_pos > pos) {
+          PN_uint32 length =
+            extend_match_backward(stream_orig, match_orig, buffer + match_pos,
+                                  match_pos - pos, orig_buffer, block_size);
+          match_pos -= length;
+          match_orig -= length;
+          match_length += length;
+        }
+
+        cache_add_and_copy(write_stream, match_pos - pos, buffer + pos,
+                           match_length, match_orig + offset_orig);
+        pos = match_pos + match_length;
+        copy_end = match_orig + match_length;
+        extend_copy = true;
+      }
+    }
+
+    if (extend_copy && pos < data_length) {
+      PN_uint32 length =
+        extend_match_forward(stream_orig, source_file_length, copy_end,
+                             buffer + pos, data_length - pos,
+                             orig_buffer, block_size);
+      if (length != 0) {
+        cache_add_and_copy(write_stream, 0, NULL,
+                           length, copy_end + offset_orig);
+        pos += length;
+        copy_end += length;
+      }
+      // If it reached the end of the data, it may continue into the
+      // next window.
+      extend_copy = (pos == data_length);
+    }
+
+    if (pos < window_length) {
+      cache_add_and_copy(write_stream, window_length - pos, buffer + pos, 0, 0);
+      pos = window_length;
+      extend_copy = false;
+    }
+
+    new_pos += pos;
+  }
+
+  stream_orig.clear();
+  stream_new.clear();
+
+  PANDA_FREE_ARRAY(buffer);
+  PANDA_FREE_ARRAY(orig_buffer);
+
+  return true;
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: Patchfile::compute_mf_patches
 //       Access: Private
@@ -1217,11 +2046,7 @@ compute_mf_patches(ostream &write_stream,
 
       streampos new_start = mf_new.get_subfile_internal_start(ni);
       size_t new_size = mf_new.get_subfile_internal_length(ni);
-      char *buffer_new = (char *)PANDA_MALLOC_ARRAY(new_size);
-      stream_new.seekg(new_start, ios::beg);
-      stream_new.read(buffer_new, new_size);
-      cache_add_and_copy(write_stream, new_size, buffer_new, 0, 0);
-      PANDA_FREE_ARRAY(buffer_new);
+      cache_add_from_stream(write_stream, stream_new, new_start, new_size);
 
     } else {
       // This subfile exists in both the original and the new files.
@@ -1355,11 +2180,7 @@ compute_tar_patches(ostream &write_stream,
 
       streampos new_start = sf_new._header_start;
       size_t new_size = sf_new._end - sf_new._header_start;
-      char *buffer_new = (char *)PANDA_MALLOC_ARRAY(new_size);
-      stream_new.seekg(new_start, ios::beg);
-      stream_new.read(buffer_new, new_size);
-      cache_add_and_copy(write_stream, new_size, buffer_new, 0, 0);
-      PANDA_FREE_ARRAY(buffer_new);
+      cache_add_from_stream(write_stream, stream_new, new_start, new_size);
 
     } else {
       // This subfile exists in both the original and the new files.
@@ -1467,6 +2288,10 @@ tar_writefunc(int, const void *, size_t) {
 //               For an original file of size M and a new file of
 //               size N, this algorithm is O(M) in space and
 //               O(M*N) (worst-case) in time.
+//
+//               Files (or subfiles) larger than the block threshold
+//               are instead patched by block matching; see
+//               compute_block_patches().
 //               return false on error
 ////////////////////////////////////////////////////////////////////
 bool Patchfile::
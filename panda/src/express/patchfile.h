@@ -33,6 +33,7 @@
 
 #include <algorithm>
 
+struct MD5state_st;
 
 ////////////////////////////////////////////////////////////////////
 //       Class : Patchfile
@@ -65,6 +66,15 @@ PUBLISHED:
   INLINE int get_footprint_length();
   INLINE void reset_footprint_length();
 
+  INLINE void set_block_size(int block_size);
+  INLINE int get_block_size() const;
+
+  INLINE void set_block_threshold(int block_threshold);
+  INLINE int get_block_threshold() const;
+
+  INLINE void set_num_threads(int num_threads);
+  INLINE int get_num_threads() const;
+
   INLINE bool has_source_hash() const;
   INLINE const HashVal &get_source_hash() const;
   INLINE const HashVal &get_result_hash() const;
@@ -94,6 +104,8 @@ private:
                           PN_uint32 add_length, const char *add_buffer,
                           PN_uint32 copy_length, PN_uint32 copy_pos);
   void cache_flush(ostream &write_stream);
+  void cache_add_from_stream(ostream &write_stream, istream &stream,
+                             streampos start, size_t size);
 
   void write_header(ostream &write_stream, 
                     istream &stream_orig, istream &stream_new);
@@ -102,6 +114,9 @@ private:
   bool compute_file_patches(ostream &write_stream, 
                             PN_uint32 offset_orig, PN_uint32 offset_new,
                              istream &stream_orig, istream &stream_new);
+  bool compute_block_patches(ostream &write_stream,
+                             PN_uint32 offset_orig, PN_uint32 offset_new,
+                             istream &stream_orig, istream &stream_new);
   bool compute_mf_patches(ostream &write_stream, 
                           PN_uint32 offset_orig, PN_uint32 offset_new,
                           istream &stream_orig, istream &stream_new);
@@ -155,6 +170,9 @@ private:
 
   bool _allow_multifile;
   PN_uint32 _footprint_length;
+  PN_uint32 _block_size;
+  PN_uint32 _block_threshold;
+  int _num_threads;
 
   PN_uint32 *_hash_table;
 
@@ -177,6 +195,9 @@ private:
 
   HashVal _MD5_ofResult;  
 
+  // The MD5 of the output file, computed as it is written.
+  MD5state_st *_MD5_ofOutput;
+
   PN_uint32 _total_bytes_to_process;
   PN_uint32 _total_bytes_processed;
 
@@ -0,0 +1,51 @@
+// Filename: radixSort.h
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef RADIXSORT_H
+#define RADIXSORT_H
+
+#include "pandabase.h"
+#include "numeric_types.h"
+
+////////////////////////////////////////////////////////////////////
+//    Function : radix_sort
+// Description : Sorts the elements in the range [first, last) into
+//               ascending order of the indicated unsigned integer
+//               member, using a stable least-significant-digit radix
+//               sort on 8-bit digits.  This runs in linear time, and
+//               is intended for the per-frame sorts of large arrays
+//               with precomputed keys, such as the cull bins.
+//
+//               The scratch buffer must have room for at least as
+//               many elements as the range; its contents are
+//               undefined on return.  Passes in which every key has
+//               the same digit are skipped, so short keys cost less
+//               than the width of the key type would suggest.
+////////////////////////////////////////////////////////////////////
+#ifndef CPPPARSER
+template<class Element, class Key>
+void radix_sort(Element *first, Element *last, Element *scratch,
+                Key Element::*key);
+#endif  // CPPPARSER
+
+INLINE PN_uint32 radix_sort_key(float value);
+INLINE PN_uint32 radix_sort_key_reverse(float value);
+
+#include "radixSort.I"
+
+#ifndef CPPPARSER
+#include "radixSort.T"
+#endif  // CPPPARSER
+
+#endif
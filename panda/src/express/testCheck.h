@@ -0,0 +1,47 @@
+// Filename: testCheck.h
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef TESTCHECK_H
+#define TESTCHECK_H
+
+#include "pandabase.h"
+#include "pnotify.h"
+
+////////////////////////////////////////////////////////////////////
+//       Class : TestCheck
+// Description : A function object for the self-checking test
+//               programs.  Each call reports a condition that should
+//               be true; the ones that aren't are written to nout,
+//               and counted.  At the end, report() writes the summary
+//               and returns the program's exit status.
+//
+//               A test program typically makes one static instance,
+//               named check, so that a condition is tested with
+//               check(condition, "description").
+////////////////////////////////////////////////////////////////////
+class TestCheck {
+public:
+  INLINE TestCheck();
+
+  INLINE bool operator () (bool condition, const string &description);
+  INLINE int get_num_failed() const;
+  INLINE int report() const;
+
+private:
+  int _num_failed;
+};
+
+#include "testCheck.I"
+
+#endif
@@ -0,0 +1,444 @@
+// Filename: test_patchfile.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "pandabase.h"
+#include "patchfile.h"
+#include "multifile.h"
+#include "hashVal.h"
+#include "filename.h"
+#include "trueClock.h"
+#include "testCheck.h"
+
+// With no arguments, this program checks that patches built by block
+// matching apply correctly in the cases most likely to go wrong, on
+// small files: the subfiles of a Multifile, which are patched at
+// nonzero offsets within the file, and some of which are new; an
+// original file shorter than a block; empty files; and a copy that
+// continues from one window of the new file into the next.
+//
+// Given a size, it instead builds and applies patches between two
+// large synthetic files, timing each of the ways Patchfile can build
+// them: with the footprint algorithm (only for smaller files, since it
+// needs both files in memory), and by block matching, with one thread
+// and with several.  Each patch is applied and the result checked
+// against the new file.
+//
+// The new file is the original with an edit every 64K or so: a few
+// bytes changed, some bytes inserted or deleted, or a piece moved
+// from elsewhere in the file.
+//
+// Usage: test_patchfile [size_mb [threads [block_size]]]
+
+static TestCheck check;
+
+static PN_uint32 random_seed = 12345;
+
+static unsigned int
+random_number() {
+  // A xorshift generator; unlike a simple linear congruential one, its
+  // low bits don't repeat every few thousand bytes, which would make
+  // the data much easier to match than real data.
+  random_seed ^= random_seed << 13;
+  random_seed ^= random_seed >> 17;
+  random_seed ^= random_seed << 5;
+  return random_seed;
+}
+
+static void
+fill_random(string &data, size_t size) {
+  data.resize(size);
+  for (size_t i = 0; i < size; ++i) {
+    data[i] = (char)(random_number() & 0xff);
+  }
+}
+
+static bool
+write_file(const Filename &filename, const string &data) {
+  pofstream out;
+  if (!filename.open_write(out)) {
+    nout << "Couldn't write " << filename << "\n";
+    return false;
+  }
+  out.write(data.data(), data.size());
+  return !out.fail();
+}
+
+static bool
+try_patch(const string &description, Patchfile &patchfile,
+          const Filename &orig, const Filename &result,
+          const Filename &patch, const Filename &output,
+          const HashVal &result_hash) {
+  TrueClock *clock = TrueClock::get_global_ptr();
+  double start = clock->get_short_time();
+  if (!patchfile.build(orig, result, patch)) {
+    nout << description << ": build failed\n";
+    return false;
+  }
+  double build_time = clock->get_short_time() - start;
+
+  Filename patch_in = patch;
+  Filename orig_in = orig;
+  Patchfile applier;
+  start = clock->get_short_time();
+  bool applied = applier.apply(patch_in, orig_in, output);
+  double apply_time = clock->get_short_time() - start;
+
+  HashVal output_hash;
+  output_hash.hash_file(output);
+  bool ok = applied && output_hash == result_hash;
+
+  nout << description << ": build " << build_time << " s, apply "
+       << apply_time << " s, patch " << patch.get_file_size()
+       << " bytes" << (ok ? "" : " FAILED") << "\n";
+  output.unlink();
+  patch.unlink();
+  return ok;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: make_edited
+//  Description: Returns a copy of the data with an edit about every
+//               edit_spacing bytes.
+////////////////////////////////////////////////////////////////////
+static string
+make_edited(const string &orig_data, size_t edit_spacing) {
+  size_t size = orig_data.size();
+  string new_data;
+  new_data.reserve(size + size / 64);
+  size_t pos = 0;
+  while (pos < size) {
+    size_t run = min((size_t)(edit_spacing / 2 + random_number() % edit_spacing),
+                     size - pos);
+    new_data.append(orig_data, pos, run);
+    pos += run;
+
+    string extra;
+    switch (random_number() % 4) {
+    case 0:
+      // Change a few bytes.
+      fill_random(extra, 1 + random_number() % 16);
+      new_data += extra;
+      pos += extra.size();
+      break;
+
+    case 1:
+      // Insert some bytes.
+      fill_random(extra, 1 + random_number() % 1000);
+      new_data += extra;
+      break;
+
+    case 2:
+      // Delete some bytes.
+      pos += 1 + random_number() % 1000;
+      break;
+
+    case 3:
+      // Copy in a piece from somewhere else.
+      {
+        size_t from = random_number() % size;
+        new_data.append(orig_data, from, min((size_t)4096, size - from));
+      }
+      break;
+    }
+  }
+  return new_data;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: check_files
+//  Description: Builds a patch from orig to result by block matching,
+//               applies it, and checks that it produces new_data.
+//               Returns the size of the patch.
+//
+//               build() reports failure for a patch that copies
+//               nothing from the original, since it is no better
+//               than the new file itself; expect_copy says whether
+//               anything can be copied.  The patch is applied either
+//               way.
+////////////////////////////////////////////////////////////////////
+static size_t
+check_files(const string &description, const Filename &orig,
+            const Filename &result, const string &new_data,
+            int block_size, int num_threads, bool expect_copy) {
+  Filename patch = Filename::temporary("", "patch_", ".pch");
+  Filename output = Filename::temporary("", "output_", ".bin");
+  patch.set_binary();
+  output.set_binary();
+
+  Patchfile patchfile;
+  patchfile.set_block_threshold(0);
+  patchfile.set_block_size(block_size);
+  patchfile.set_num_threads(num_threads);
+  check(patchfile.build(orig, result, patch) == expect_copy,
+        description + ": build");
+  size_t patch_size = patch.get_file_size();
+
+  Filename patch_in = patch;
+  Filename orig_in = orig;
+  Patchfile applier;
+  check(applier.apply(patch_in, orig_in, output), description + ": apply");
+
+  HashVal expected_hash, output_hash;
+  expected_hash.hash_string(new_data);
+  output_hash.hash_file(output);
+  check(output.get_file_size() == (streamsize)new_data.size() &&
+        output_hash == expected_hash, description + ": result");
+
+  patch.unlink();
+  output.unlink();
+  return patch_size;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: check_data
+//  Description: As check_files(), for two files with the indicated
+//               contents.  Returns the size of the patch.
+////////////////////////////////////////////////////////////////////
+static size_t
+check_data(const string &description, const string &orig_data,
+           const string &new_data, int block_size, int num_threads,
+           bool expect_copy = true) {
+  Filename orig = Filename::temporary("", "orig_", ".bin");
+  Filename result = Filename::temporary("", "new_", ".bin");
+  orig.set_binary();
+  result.set_binary();
+  size_t patch_size = 0;
+  if (check(write_file(orig, orig_data) && write_file(result, new_data),
+            description + ": write files")) {
+    patch_size = check_files(description, orig, result, new_data,
+                             block_size, num_threads, expect_copy);
+  }
+  orig.unlink();
+  result.unlink();
+  return patch_size;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: write_multifile
+//  Description: Writes a Multifile holding the indicated subfiles,
+//               uncompressed, and returns its contents.
+////////////////////////////////////////////////////////////////////
+static string
+write_multifile(const Filename &filename, const pvector<string> &names,
+                const pvector<string> &contents) {
+  pvector<istringstream *> streams;
+  Multifile mf;
+  mf.set_record_timestamp(false);
+  if (!check(mf.open_write(filename), "open " + filename.get_basename())) {
+    return string();
+  }
+  for (size_t i = 0; i < names.size(); ++i) {
+    istringstream *stream = new istringstream(contents[i]);
+    streams.push_back(stream);
+    mf.add_subfile(names[i], stream, 0);
+  }
+  mf.close();
+  for (size_t i = 0; i < streams.size(); ++i) {
+    delete streams[i];
+  }
+
+  string data;
+  pifstream in;
+  if (filename.open_read(in)) {
+    ostringstream strm;
+    strm << in.rdbuf();
+    data = strm.str();
+  }
+  return data;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: check_multifile
+//  Description: Patches one Multifile into another.  One subfile is
+//               changed, one is unchanged, one is removed, and one is
+//               new, so the changed subfiles begin at different,
+//               nonzero offsets within the two files.
+////////////////////////////////////////////////////////////////////
+static void
+check_multifile(int num_threads) {
+  ostringstream strm;
+  strm << "multifile, " << num_threads << " threads";
+  string description = strm.str();
+
+  string removed, changed, same, added;
+  fill_random(removed, 3000);
+  fill_random(changed, 20000);
+  fill_random(same, 7000);
+  fill_random(added, 5000);
+
+  pvector<string> orig_names, orig_contents;
+  orig_names.push_back("a_removed");
+  orig_contents.push_back(removed);
+  orig_names.push_back("b_changed");
+  orig_contents.push_back(changed);
+  orig_names.push_back("c_same");
+  orig_contents.push_back(same);
+
+  pvector<string> new_names, new_contents;
+  new_names.push_back("a_added");
+  new_contents.push_back(added);
+  new_names.push_back("b_changed");
+  new_contents.push_back(make_edited(changed, 4000));
+  new_names.push_back("c_same");
+  new_contents.push_back(same);
+
+  Filename orig = Filename::temporary("", "orig_", ".mf");
+  Filename result = Filename::temporary("", "new_", ".mf");
+  orig.set_binary();
+  result.set_binary();
+  write_multifile(orig, orig_names, orig_contents);
+  string new_data = write_multifile(result, new_names, new_contents);
+
+  size_t patch_size = check_files(description, orig, result, new_data,
+                                  32, num_threads, true);
+
+  // The new subfile must be added whole, but the rest should be
+  // mostly copied.
+  check(patch_size < added.size() + 4000, description + ": patch size");
+
+  orig.unlink();
+  result.unlink();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: run_quick_checks
+//  Description: Checks the block matching on small files.
+////////////////////////////////////////////////////////////////////
+static void
+run_quick_checks() {
+  string orig_data, new_data, extra;
+
+  // An ordinary file, with one thread and several.
+  fill_random(orig_data, 200000);
+  new_data = make_edited(orig_data, 8000);
+  check_data("edited, 1 thread", orig_data, new_data, 32, 1);
+  check_data("edited, 3 threads", orig_data, new_data, 32, 3);
+
+  check_multifile(1);
+  check_multifile(3);
+
+  // An original shorter than one block has no blocks to match at
+  // all, so the new file is all added.
+  fill_random(orig_data, 10);
+  fill_random(extra, 5);
+  new_data = extra + orig_data;
+  fill_random(extra, 20);
+  new_data += extra;
+  check_data("original shorter than a block", orig_data, new_data, 16, 1,
+             false);
+  check_data("both shorter than a block", orig_data,
+             orig_data.substr(3, 4), 16, 1, false);
+
+  // But the last partial block of a longer original is still copied
+  // when a match runs into it.
+  fill_random(orig_data, 16 * 10 + 7);
+  check_data("partial last block", orig_data, orig_data, 16, 1);
+
+  // Empty files.
+  fill_random(new_data, 1000);
+  check_data("empty original", string(), new_data, 16, 1, false);
+  check_data("empty new file", new_data, string(), 16, 1, false);
+  check_data("both empty", string(), string(), 16, 1, false);
+
+  // The new file is read a window of 4 MB at a time, with one thread.
+  // Offset the new file from the original by less than a block, so
+  // that the window ends in the middle of a block of the original:
+  // the copy must carry on into the next window, rather than leaving
+  // the rest of the block to be sent whole.
+  fill_random(orig_data, 4 * 1024 * 1024 + 300 * 1024);
+  fill_random(extra, 100);
+  new_data = extra + orig_data;
+  size_t patch_size =
+    check_data("copy across window", orig_data, new_data, 1024, 1);
+  check(patch_size < 1000, "copy across window: patch size");
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: run_benchmark
+//  Description: Times the building and applying of patches between
+//               two large files.
+////////////////////////////////////////////////////////////////////
+static void
+run_benchmark(int size_mb, int num_threads, int block_size) {
+  size_t size = (size_t)size_mb * 1024 * 1024;
+
+  string orig_data;
+  fill_random(orig_data, size);
+  string new_data = make_edited(orig_data, 65536);
+
+  Filename orig = Filename::temporary("", "orig_", ".bin");
+  Filename result = Filename::temporary("", "new_", ".bin");
+  Filename patch = Filename::temporary("", "patch_", ".pch");
+  Filename output = Filename::temporary("", "output_", ".bin");
+  orig.set_binary();
+  result.set_binary();
+  patch.set_binary();
+  output.set_binary();
+  if (!check(write_file(orig, orig_data) && write_file(result, new_data),
+             "write files")) {
+    return;
+  }
+
+  HashVal result_hash;
+  result_hash.hash_file(result);
+
+  nout << size_mb << " MB original, " << new_data.size()
+       << " bytes new\n";
+  orig_data = string();
+  new_data = string();
+
+  if (size_mb <= 64) {
+    Patchfile patchfile;
+    patchfile.set_block_size(0);
+    check(try_patch("footprint", patchfile, orig, result, patch, output,
+                    result_hash), "footprint");
+  }
+
+  {
+    Patchfile patchfile;
+    patchfile.set_block_threshold(0);
+    patchfile.set_block_size(block_size);
+    patchfile.set_num_threads(1);
+    check(try_patch("blocks, 1 thread", patchfile, orig, result, patch,
+                    output, result_hash), "blocks, 1 thread");
+  }
+
+  if (num_threads > 1) {
+    Patchfile patchfile;
+    patchfile.set_block_threshold(0);
+    patchfile.set_block_size(block_size);
+    patchfile.set_num_threads(num_threads);
+    ostringstream description;
+    description << "blocks, " << num_threads << " threads";
+    check(try_patch(description.str(), patchfile, orig, result, patch,
+                    output, result_hash), description.str());
+  }
+
+  orig.unlink();
+  result.unlink();
+}
+
+int
+main(int argc, char *argv[]) {
+  if (argc > 1) {
+    int size_mb = atoi(argv[1]);
+    int num_threads = (argc > 2) ? atoi(argv[2]) : 4;
+    int block_size = (argc > 3) ? atoi(argv[3]) : 256;
+    run_benchmark(size_mb, num_threads, block_size);
+  } else {
+    run_quick_checks();
+  }
+
+  return check.report();
+}
@@ -646,7 +646,8 @@ load_model(const NodePath &parent, Filename filename) {
     if (model_type == (LoaderFileType *)NULL) {
       // The extension isn't a known model file type; is it a known
       // image file extension?
-      if (extension == "txo" || downcase(extension) == "dds") {
+      if (extension == "txo" || downcase(extension) == "dds" ||
+          downcase(extension) == "ktx") {
         // A texture object.  Not exactly an image, but certainly a
         // texture.
         is_image = true;
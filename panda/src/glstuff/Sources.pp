@@ -18,6 +18,9 @@
      glGeomMunger_src.I \
      glGeomMunger_src.cxx \
      glGeomMunger_src.h \
+     glGeomPool_src.I \
+     glGeomPool_src.cxx \
+     glGeomPool_src.h \
      glGraphicsStateGuardian_src.I \
      glGraphicsStateGuardian_src.cxx \
      glGraphicsStateGuardian_src.h \
@@ -36,6 +39,9 @@
      glShaderContext_src.I \
      glShaderContext_src.cxx \
      glShaderContext_src.h \
+     glStreamBuffer_src.I \
+     glStreamBuffer_src.cxx \
+     glStreamBuffer_src.h \
      glTextureContext_src.I \
      glTextureContext_src.cxx \
      glTextureContext_src.h \
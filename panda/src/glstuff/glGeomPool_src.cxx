@@ -0,0 +1,465 @@
+// Filename: glGeomPool_src.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "geomTriangles.h"
+
+#ifndef OPENGLES
+
+////////////////////////////////////////////////////////////////////
+//     Function: GLGeomPool::Constructor
+//       Access: Public
+//  Description: Creates an empty pool for data of the indicated
+//               format.  The GSG's context must be current.
+////////////////////////////////////////////////////////////////////
+CLP(GeomPool)::
+CLP(GeomPool)(CLP(GraphicsStateGuardian) *glgsg,
+              const GeomVertexFormat *format) :
+  _glgsg(glgsg),
+  _format(format),
+  _num_rows(0),
+  _index_buffer(0),
+  _indices_uploaded(0),
+  _indices_capacity(0),
+  _indirect_buffer(0),
+  _compacted_rows(0),
+  _compacted_indices(0)
+{
+  int num_arrays = format->get_num_arrays();
+  _arrays.resize(num_arrays);
+  for (int i = 0; i < num_arrays; ++i) {
+    ArrayBuffer &array = _arrays[i];
+    _glgsg->_glGenBuffers(1, &array._index);
+    array._stride = format->get_array(i)->get_stride();
+    array._uploaded = 0;
+    array._capacity = 0;
+  }
+  _glgsg->_glGenBuffers(1, &_index_buffer);
+  _glgsg->_glGenBuffers(1, &_indirect_buffer);
+
+  if (GLCAT.is_debug() && gl_debug_buffers) {
+    GLCAT.debug()
+      << "creating geom pool for " << *format << "\n";
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: GLGeomPool::Destructor
+//       Access: Public
+//  Description: As with GLStreamBuffer, the destructor leaves the
+//               GL resources alone; call release() first to free
+//               them explicitly.
+////////////////////////////////////////////////////////////////////
+CLP(GeomPool)::
+~CLP(GeomPool)() {
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: GLGeomPool::is_eligible
+//       Access: Public, Static
+//  Description: Returns true if the indicated object can be drawn
+//               from a pool: it must consist entirely of indexed or
+//               non-indexed GeomTriangles, and both it and its
+//               vertex data must be static.
+////////////////////////////////////////////////////////////////////
+bool CLP(GeomPool)::
+is_eligible(const CullableObject *object) {
+  if (object->_draw_callback != (CallbackObject *)NULL) {
+    return false;
+  }
+
+  const Geom *geom = object->_geom;
+  if (geom->get_primitive_type() != GeomPrimitive::PT_polygons ||
+      geom->get_usage_hint() != Geom::UH_static ||
+      object->_munged_data->get_usage_hint() != Geom::UH_static) {
+    return false;
+  }
+
+  int num_primitives = geom->get_num_primitives();
+  if (num_primitives == 0) {
+    return false;
+  }
+  for (int i = 0; i < num_primitives; ++i) {
+    CPT(GeomPrimitive) primitive = geom->get_primitive(i);
+    if (!primitive->is_exact_type(GeomTriangles::get_class_type())) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: GLGeomPool::add_object
+//       Access: Public
+//  Description: Makes sure the object's vertices and indices are
+//               packed into the pool, and appends a draw command to
+//               the list for each of its primitives.  The object
+//               must be eligible, and its vertex data must be of the
+//               pool's format.
+////////////////////////////////////////////////////////////////////
+bool CLP(GeomPool)::
+add_object(const CullableObject *object, Commands &commands,
+           Thread *current_thread) {
+  const GeomVertexData *data = object->_munged_data;
+  nassertr(data->get_format() == _format, false);
+
+  DataEntries::const_iterator di = _data_entries.find(data);
+  if (di == _data_entries.end() ||
+      (*di).second._data.was_deleted() ||
+      (*di).second._modified != data->get_modified(current_thread)) {
+    pack_data(data, current_thread);
+    di = _data_entries.find(data);
+    nassertr(di != _data_entries.end(), false);
+  }
+  const DataEntry &data_entry = (*di).second;
+
+  const Geom *geom = object->_geom;
+  int num_primitives = geom->get_num_primitives();
+  for (int i = 0; i < num_primitives; ++i) {
+    CPT(GeomPrimitive) primitive = geom->get_primitive(i);
+
+    PrimitiveEntries::const_iterator pi = _primitive_entries.find(primitive);
+    if (pi == _primitive_entries.end() ||
+        (*pi).second._primitive.was_deleted() ||
+        (*pi).second._modified != primitive->get_modified()) {
+      pack_primitive(primitive, current_thread);
+      pi = _primitive_entries.find(primitive);
+      nassertr(pi != _primitive_entries.end(), false);
+    }
+    const PrimitiveEntry &primitive_entry = (*pi).second;
+
+    if (primitive_entry._num_indices != 0) {
+      DrawCommand command;
+      command._count = primitive_entry._num_indices;
+      command._instance_count = 1;
+      command._first_index = primitive_entry._first_index;
+      command._base_vertex = data_entry._base_vertex;
+      command._base_instance = 0;
+      commands.push_back(command);
+    }
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: GLGeomPool::setup_array_data
+//       Access: Public
+//  Description: Called by the GSG in lieu of its own
+//               setup_array_data() while a batch from this pool is
+//               being drawn.  Binds the pool's buffer corresponding
+//               to the indicated array of the data being drawn, and
+//               sets client_pointer to the start of it.
+////////////////////////////////////////////////////////////////////
+bool CLP(GeomPool)::
+setup_array_data(const unsigned char *&client_pointer,
+                 const GeomVertexArrayDataHandle *array_reader,
+                 const GeomVertexDataPipelineReader *data_reader) {
+  int num_arrays = data_reader->get_num_arrays();
+  nassertr(num_arrays == (int)_arrays.size(), false);
+
+  for (int i = 0; i < num_arrays; ++i) {
+    if (data_reader->get_array_reader(i) == array_reader) {
+      GLuint index = _arrays[i]._index;
+      if (_glgsg->_current_vbuffer_index != index) {
+        _glgsg->_glBindBuffer(GL_ARRAY_BUFFER, index);
+        _glgsg->_current_vbuffer_index = index;
+      }
+      client_pointer = NULL;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: GLGeomPool::draw
+//       Access: Public
+//  Description: Issues the indicated draw commands.  The vertex
+//               arrays must already have been set up, by way of
+//               begin_draw_primitives().
+////////////////////////////////////////////////////////////////////
+void CLP(GeomPool)::
+draw(const Commands &commands) {
+  if (commands.empty()) {
+    return;
+  }
+  update_buffers();
+
+  if (_glgsg->_current_ibuffer_index != _index_buffer) {
+    _glgsg->_glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _index_buffer);
+    _glgsg->_current_ibuffer_index = _index_buffer;
+  }
+
+  // The commands change from one frame to the next, so we simply
+  // respecify the indirect buffer each time.
+  _glgsg->_glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _indirect_buffer);
+  _glgsg->_glBufferData(GL_DRAW_INDIRECT_BUFFER,
+                        commands.size() * sizeof(DrawCommand),
+                        &commands[0], GL_STREAM_DRAW);
+
+  _glgsg->_glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, NULL,
+                                       (GLsizei)commands.size(), 0);
+  _glgsg->_glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+  _glgsg->report_my_gl_errors();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: GLGeomPool::end_frame
+//       Access: Public
+//  Description: Called by the GSG at the end of each frame.  If the
+//               pool has doubled in size since it was last
+//               compacted, compacts it now, to reclaim the space held
+//               by data that has since been modified or deleted.
+////////////////////////////////////////////////////////////////////
+void CLP(GeomPool)::
+end_frame() {
+  static const int min_rows = 65536;
+  if (_num_rows > _compacted_rows * 2 + min_rows ||
+      _indices.size() > _compacted_indices * 2 + min_rows * 3) {
+    compact();
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: GLGeomPool::release
+//       Access: Public
+//  Description: Frees the GL resources held by the pool.  The GSG's
+//               context must be current.
+////////////////////////////////////////////////////////////////////
+void CLP(GeomPool)::
+release() {
+  Arrays::iterator ai;
+  for (ai = _arrays.begin(); ai != _arrays.end(); ++ai) {
+    if (_glgsg->_current_vbuffer_index == (*ai)._index) {
+      _glgsg->_glBindBuffer(GL_ARRAY_BUFFER, 0);
+      _glgsg->_current_vbuffer_index = 0;
+    }
+    _glgsg->_glDeleteBuffers(1, &(*ai)._index);
+    (*ai)._index = 0;
+  }
+
+  if (_glgsg->_current_ibuffer_index == _index_buffer) {
+    _glgsg->_glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    _glgsg->_current_ibuffer_index = 0;
+  }
+  _glgsg->_glDeleteBuffers(1, &_index_buffer);
+  _glgsg->_glDeleteBuffers(1, &_indirect_buffer);
+  _index_buffer = 0;
+  _indirect_buffer = 0;
+
+  _glgsg->report_my_gl_errors();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: GLGeomPool::pack_data
+//       Access: Private
+//  Description: Appends the rows of the indicated vertex data to the
+//               end of the pool.
+////////////////////////////////////////////////////////////////////
+void CLP(GeomPool)::
+pack_data(const GeomVertexData *data, Thread *current_thread) {
+  GeomVertexDataPipelineReader reader(data, current_thread);
+  reader.check_array_readers();
+
+  int num_arrays = reader.get_num_arrays();
+  nassertv(num_arrays == (int)_arrays.size());
+
+  // Get all of the pointers first, so that we don't pack a partial
+  // row if one of the arrays is unavailable.
+  int num_rows = reader.get_num_rows();
+  pvector<const unsigned char *> pointers(num_arrays);
+  for (int i = 0; i < num_arrays; ++i) {
+    pointers[i] = reader.get_array_reader(i)->get_read_pointer(true);
+    nassertv(pointers[i] != NULL);
+  }
+
+  for (int i = 0; i < num_arrays; ++i) {
+    ArrayBuffer &array = _arrays[i];
+    array._shadow.insert(array._shadow.end(), pointers[i],
+                         pointers[i] + num_rows * array._stride);
+  }
+
+  DataEntry &entry = _data_entries[data];
+  entry._data = data;
+  entry._modified = reader.get_modified();
+  entry._base_vertex = _num_rows;
+  entry._num_rows = num_rows;
+  _num_rows += num_rows;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: GLGeomPool::pack_primitive
+//       Access: Private
+//  Description: Appends the vertex indices of the indicated
+//               primitive to the end of the pool's index buffer.
+//               All indices are stored as 32-bit integers, so that
+//               primitives with different index types can be drawn
+//               together.
+////////////////////////////////////////////////////////////////////
+void CLP(GeomPool)::
+pack_primitive(const GeomPrimitive *primitive, Thread *current_thread) {
+  GeomPrimitivePipelineReader reader(primitive, current_thread);
+  int num_vertices = reader.get_num_vertices();
+
+  PrimitiveEntry &entry = _primitive_entries[primitive];
+  entry._primitive = primitive;
+  entry._modified = reader.get_modified();
+  entry._first_index = (int)_indices.size();
+  entry._num_indices = num_vertices;
+
+  _indices.reserve(_indices.size() + num_vertices);
+  for (int i = 0; i < num_vertices; ++i) {
+    _indices.push_back((GLuint)reader.get_vertex(i));
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: GLGeomPool::update_buffers
+//       Access: Private
+//  Description: Copies whatever has been packed since the last call
+//               into the buffer objects.
+////////////////////////////////////////////////////////////////////
+void CLP(GeomPool)::
+update_buffers() {
+  Arrays::iterator ai;
+  for (ai = _arrays.begin(); ai != _arrays.end(); ++ai) {
+    ArrayBuffer &array = (*ai);
+    if (!array._shadow.empty()) {
+      upload_buffer(GL_ARRAY_BUFFER, array._index, &array._shadow[0],
+                    array._shadow.size(), array._uploaded, array._capacity);
+    }
+  }
+
+  if (!_indices.empty()) {
+    upload_buffer(GL_ELEMENT_ARRAY_BUFFER, _index_buffer,
+                  (const unsigned char *)&_indices[0],
+                  _indices.size() * sizeof(GLuint),
+                  _indices_uploaded, _indices_capacity);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: GLGeomPool::upload_buffer
+//       Access: Private
+//  Description: Copies the part of the indicated data that has not
+//               yet been uploaded into the buffer object, growing
+//               the buffer object first (and copying all of the data
+//               again) if it is not large enough.
+////////////////////////////////////////////////////////////////////
+void CLP(GeomPool)::
+upload_buffer(GLenum target, GLuint index,
+              const unsigned char *data, size_t num_bytes,
+              size_t &uploaded, size_t &capacity) {
+  if (uploaded == num_bytes) {
+    return;
+  }
+
+  if (target == GL_ELEMENT_ARRAY_BUFFER) {
+    if (_glgsg->_current_ibuffer_index != index) {
+      _glgsg->_glBindBuffer(target, index);
+      _glgsg->_current_ibuffer_index = index;
+    }
+  } else {
+    if (_glgsg->_current_vbuffer_index != index) {
+      _glgsg->_glBindBuffer(target, index);
+      _glgsg->_current_vbuffer_index = index;
+    }
+  }
+
+  if (num_bytes > capacity) {
+    // Grow geometrically, so that packing many Geoms one at a time
+    // doesn't mean copying the whole pool each time.
+    capacity = max(num_bytes, capacity * 2);
+    _glgsg->_glBufferData(target, capacity, NULL, GL_STATIC_DRAW);
+    uploaded = 0;
+  }
+
+  _glgsg->_glBufferSubData(target, uploaded, num_bytes - uploaded,
+                           data + uploaded);
+  _glgsg->_data_transferred_pcollector.add_level(num_bytes - uploaded);
+  uploaded = num_bytes;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: GLGeomPool::compact
+//       Access: Private
+//  Description: Rebuilds the pool from only those entries whose data
+//               still exists and is unmodified, dropping the rest.
+//               Everything will be uploaded again the next time the
+//               pool is drawn.
+////////////////////////////////////////////////////////////////////
+void CLP(GeomPool)::
+compact() {
+  int num_arrays = (int)_arrays.size();
+  pvector< pvector<unsigned char> > shadows(num_arrays);
+  int num_rows = 0;
+
+  DataEntries::iterator di = _data_entries.begin();
+  while (di != _data_entries.end()) {
+    DataEntry &entry = (*di).second;
+    if (entry._data.was_deleted() ||
+        entry._modified != entry._data->get_modified()) {
+      _data_entries.erase(di++);
+      continue;
+    }
+
+    for (int i = 0; i < num_arrays; ++i) {
+      const ArrayBuffer &array = _arrays[i];
+      const unsigned char *begin = &array._shadow[0] + entry._base_vertex * array._stride;
+      shadows[i].insert(shadows[i].end(), begin, begin + entry._num_rows * array._stride);
+    }
+    entry._base_vertex = num_rows;
+    num_rows += entry._num_rows;
+    ++di;
+  }
+
+  pvector<GLuint> indices;
+  PrimitiveEntries::iterator pi = _primitive_entries.begin();
+  while (pi != _primitive_entries.end()) {
+    PrimitiveEntry &entry = (*pi).second;
+    if (entry._primitive.was_deleted() ||
+        entry._modified != entry._primitive->get_modified()) {
+      _primitive_entries.erase(pi++);
+      continue;
+    }
+
+    pvector<GLuint>::const_iterator begin = _indices.begin() + entry._first_index;
+    indices.insert(indices.end(), begin, begin + entry._num_indices);
+    entry._first_index = (int)indices.size() - entry._num_indices;
+    ++pi;
+  }
+
+  if (GLCAT.is_debug() && gl_debug_buffers) {
+    GLCAT.debug()
+      << "compacting geom pool from " << _num_rows << " to " << num_rows
+      << " vertices and from " << _indices.size() << " to "
+      << indices.size() << " indices\n";
+  }
+
+  for (int i = 0; i < num_arrays; ++i) {
+    _arrays[i]._shadow.swap(shadows[i]);
+    _arrays[i]._uploaded = 0;
+  }
+  _indices.swap(indices);
+  _indices_uploaded = 0;
+
+  _num_rows = num_rows;
+  _compacted_rows = num_rows;
+  _compacted_indices = _indices.size();
+}
+
+#endif  // OPENGLES
@@ -0,0 +1,139 @@
+// Filename: glGeomPool_src.h
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "pandabase.h"
+#include "geomVertexFormat.h"
+#include "geomVertexData.h"
+#include "geomPrimitive.h"
+#include "cullableObject.h"
+#include "weakPointerTo.h"
+#include "updateSeq.h"
+#include "pmap.h"
+#include "pvector.h"
+
+class CLP(GraphicsStateGuardian);
+
+#ifndef OPENGLES  // Indirect drawing is not supported by OpenGL ES.
+
+////////////////////////////////////////////////////////////////////
+//       Class : GLGeomPool
+// Description : A set of buffer objects into which the vertices and
+//               indices of many static Geoms sharing the same vertex
+//               format are packed, one after the other, so that any
+//               number of them can be drawn with a single call to
+//               glMultiDrawElementsIndirect.  Each Geom is drawn with
+//               a base vertex pointing to its own vertices within the
+//               pool.
+//
+//               The pool keeps a copy of everything it has packed in
+//               system memory, from which the buffer objects are
+//               (re)filled as they grow, and from which it is
+//               compacted once enough of its contents belong to data
+//               that has since been modified or deleted.
+////////////////////////////////////////////////////////////////////
+class EXPCL_GL CLP(GeomPool) {
+public:
+  CLP(GeomPool)(CLP(GraphicsStateGuardian) *glgsg,
+                const GeomVertexFormat *format);
+  ~CLP(GeomPool)();
+
+  // This is the layout of a command in the indirect buffer, as
+  // defined by ARB_draw_indirect.
+  class DrawCommand {
+  public:
+    GLuint _count;
+    GLuint _instance_count;
+    GLuint _first_index;
+    GLint _base_vertex;
+    GLuint _base_instance;
+  };
+  typedef pvector<DrawCommand> Commands;
+
+  INLINE const GeomVertexFormat *get_format() const;
+
+  static bool is_eligible(const CullableObject *object);
+  bool add_object(const CullableObject *object, Commands &commands,
+                  Thread *current_thread);
+
+  bool setup_array_data(const unsigned char *&client_pointer,
+                        const GeomVertexArrayDataHandle *array_reader,
+                        const GeomVertexDataPipelineReader *data_reader);
+  void draw(const Commands &commands);
+  void end_frame();
+  void release();
+
+private:
+  void pack_data(const GeomVertexData *data, Thread *current_thread);
+  void pack_primitive(const GeomPrimitive *primitive, Thread *current_thread);
+  void update_buffers();
+  void upload_buffer(GLenum target, GLuint index,
+                     const unsigned char *data, size_t num_bytes,
+                     size_t &uploaded, size_t &capacity);
+  void compact();
+
+  CLP(GraphicsStateGuardian) *_glgsg;
+  CPT(GeomVertexFormat) _format;
+
+  // Where each GeomVertexData and GeomPrimitive has been packed.  The
+  // weak pointers tell us when the object has gone away (and another
+  // may have taken its address), and the modified stamps tell us when
+  // it must be packed again.
+  class DataEntry {
+  public:
+    WCPT(GeomVertexData) _data;
+    UpdateSeq _modified;
+    int _base_vertex;
+    int _num_rows;
+  };
+  typedef pmap<const GeomVertexData *, DataEntry> DataEntries;
+  DataEntries _data_entries;
+
+  class PrimitiveEntry {
+  public:
+    WCPT(GeomPrimitive) _primitive;
+    UpdateSeq _modified;
+    int _first_index;
+    int _num_indices;
+  };
+  typedef pmap<const GeomPrimitive *, PrimitiveEntry> PrimitiveEntries;
+  PrimitiveEntries _primitive_entries;
+
+  // One buffer object per array in the format.
+  class ArrayBuffer {
+  public:
+    GLuint _index;
+    size_t _stride;
+    pvector<unsigned char> _shadow;
+    size_t _uploaded;
+    size_t _capacity;
+  };
+  typedef pvector<ArrayBuffer> Arrays;
+  Arrays _arrays;
+  int _num_rows;
+
+  GLuint _index_buffer;
+  pvector<GLuint> _indices;
+  size_t _indices_uploaded;
+  size_t _indices_capacity;
+
+  GLuint _indirect_buffer;
+
+  // The sizes of the pool right after it was last compacted.
+  int _compacted_rows;
+  size_t _compacted_indices;
+};
+
+#include "glGeomPool_src.I"
+
+#endif  // OPENGLES
@@ -82,6 +82,8 @@ PStatCollector CLP(GraphicsStateGuardian)::_vertex_array_update_pcollector("Draw
 PStatCollector CLP(GraphicsStateGuardian)::_texture_update_pcollector("Draw:Update texture");
 PStatCollector CLP(GraphicsStateGuardian)::_fbo_bind_pcollector("Draw:Bind FBO");
 PStatCollector CLP(GraphicsStateGuardian)::_check_error_pcollector("Draw:Check errors");
+PStatCollector CLP(GraphicsStateGuardian)::_data_streamed_pcollector("Data transferred:Streamed");
+PStatCollector CLP(GraphicsStateGuardian)::_stream_buffer_wait_pcollector("Wait:Stream buffer");
 
 #ifndef OPENGLES_1
 PT(Shader) CLP(GraphicsStateGuardian)::_default_shader = NULL;
@@ -361,6 +363,13 @@ CLP(GraphicsStateGuardian)(GraphicsEngine *engine, GraphicsPipe *pipe) :
 
   _white_texture = 0;
 
+  _vertex_stream_buffer = NULL;
+  _index_stream_buffer = NULL;
+
+#ifndef OPENGLES
+  _current_geom_pool = NULL;
+#endif
+
 #ifdef HAVE_CG
   _cg_context = 0;
 #endif
@@ -386,6 +395,18 @@ CLP(GraphicsStateGuardian)::
   }
 
   close_gsg();
+
+  // The GL will clean up the buffer objects themselves.
+  delete _vertex_stream_buffer;
+  delete _index_stream_buffer;
+
+#ifndef OPENGLES
+  GeomPools::iterator gpi;
+  for (gpi = _geom_pools.begin(); gpi != _geom_pools.end(); ++gpi) {
+    delete (*gpi).second;
+  }
+  _geom_pools.clear();
+#endif
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -1227,6 +1248,74 @@ reset() {
   }
 #endif
 
+#ifndef OPENGLES
+  _glMapBufferRange = NULL;
+  _glUnmapBuffer = NULL;
+  if (_supports_buffers &&
+      (is_at_least_gl_version(3, 0) || has_extension("GL_ARB_map_buffer_range"))) {
+    _glMapBufferRange = (PFNGLMAPBUFFERRANGEPROC)
+      get_extension_func("glMapBufferRange");
+    _glUnmapBuffer = (PFNGLUNMAPBUFFERPROC)
+      get_extension_func("glUnmapBuffer");
+
+    if (_glMapBufferRange == NULL || _glUnmapBuffer == NULL) {
+      GLCAT.warning()
+        << "glMapBufferRange advertised as supported by OpenGL runtime, but could not get pointers to extension functions.\n";
+      _glMapBufferRange = NULL;
+    }
+  }
+
+  _supports_buffer_storage = false;
+  if (_glMapBufferRange != NULL &&
+      (is_at_least_gl_version(4, 4) || has_extension("GL_ARB_buffer_storage"))) {
+    _glBufferStorage = (PFNGLBUFFERSTORAGEPROC)
+      get_extension_func("glBufferStorage");
+
+    if (_glBufferStorage != NULL) {
+      _supports_buffer_storage = true;
+    } else {
+      GLCAT.warning()
+        << "Buffer storage advertised as supported by OpenGL runtime, but could not get pointers to extension function.\n";
+    }
+  }
+
+  _supports_sync = false;
+  if (is_at_least_gl_version(3, 2) || has_extension("GL_ARB_sync")) {
+    _glFenceSync = (PFNGLFENCESYNCPROC)
+      get_extension_func("glFenceSync");
+    _glDeleteSync = (PFNGLDELETESYNCPROC)
+      get_extension_func("glDeleteSync");
+    _glClientWaitSync = (PFNGLCLIENTWAITSYNCPROC)
+      get_extension_func("glClientWaitSync");
+
+    if (_glFenceSync != NULL && _glDeleteSync != NULL &&
+        _glClientWaitSync != NULL) {
+      _supports_sync = true;
+    } else {
+      GLCAT.warning()
+        << "Sync objects advertised as supported by OpenGL runtime, but could not get pointers to extension functions.\n";
+    }
+  }
+
+  _glMultiDrawElementsIndirect = NULL;
+  if (_supports_buffers &&
+      (is_at_least_gl_version(4, 3) || has_extension("GL_ARB_multi_draw_indirect"))) {
+    _glMultiDrawElementsIndirect = (PFNGLMULTIDRAWELEMENTSINDIRECTPROC)
+      get_extension_func("glMultiDrawElementsIndirect");
+
+    if (_glMultiDrawElementsIndirect == NULL) {
+      GLCAT.warning()
+        << "Multi-draw indirect advertised as supported by OpenGL runtime, but could not get pointers to extension function.\n";
+    }
+  }
+
+  // The batches are drawn from pooled buffer objects, which don't mix
+  // with display lists.
+  _supports_multi_draw_indirect =
+    gl_multi_draw_indirect && _glMultiDrawElementsIndirect != NULL &&
+    vertex_buffers && !display_lists;
+#endif  // OPENGLES
+
   _supports_vao = false;
 
   if (is_at_least_gl_version(3, 0) || has_extension("GL_ARB_vertex_array_object")) {
@@ -2588,6 +2677,36 @@ reset() {
   }
 #endif
 
+  // Set up the ring buffers for streaming dynamic vertex and index
+  // data.  Any left over from a previous context belong to that
+  // context, so we simply drop them.
+  delete _vertex_stream_buffer;
+  delete _index_stream_buffer;
+  _vertex_stream_buffer = NULL;
+  _index_stream_buffer = NULL;
+
+  if (_supports_buffers && vertex_buffers && gl_stream_buffer_size > 0) {
+    bool persistent = false;
+#ifndef OPENGLES
+    persistent = gl_persistent_stream_buffers &&
+      _supports_buffer_storage && _supports_sync;
+#endif
+    _vertex_stream_buffer = new CLP(StreamBuffer)
+      (this, GL_ARRAY_BUFFER, gl_stream_buffer_size, persistent);
+    _index_stream_buffer = new CLP(StreamBuffer)
+      (this, GL_ELEMENT_ARRAY_BUFFER, gl_stream_buffer_size, persistent);
+  }
+
+#ifndef OPENGLES
+  // Likewise for the geom pools used for multi-draw batches.
+  GeomPools::iterator gpi;
+  for (gpi = _geom_pools.begin(); gpi != _geom_pools.end(); ++gpi) {
+    delete (*gpi).second;
+  }
+  _geom_pools.clear();
+  _current_geom_pool = NULL;
+#endif
+
   // Now that the GSG has been initialized, make it available for
   // optimizations.
   add_gsg(this);
@@ -3044,6 +3163,7 @@ begin_frame(Thread *current_thread) {
   _vertices_display_list_pcollector.clear_level();
   _vertices_immediate_pcollector.clear_level();
   _primitive_batches_display_list_pcollector.clear_level();
+  _data_streamed_pcollector.clear_level();
 #endif
 
 #ifndef NDEBUG
@@ -3194,6 +3314,20 @@ end_frame(Thread *current_thread) {
   //if (_force_flush || _current_properties->is_single_buffered()) {
   //  gl_flush();
   //}
+  // Fence off the data streamed during this frame, so we know when
+  // it is safe to overwrite it.
+  if (_vertex_stream_buffer != NULL) {
+    _vertex_stream_buffer->end_frame();
+    _index_stream_buffer->end_frame();
+  }
+
+#ifndef OPENGLES
+  GeomPools::iterator gpi;
+  for (gpi = _geom_pools.begin(); gpi != _geom_pools.end(); ++gpi) {
+    (*gpi).second->end_frame();
+  }
+#endif
+
   maybe_gl_finish();
 
   GraphicsStateGuardian::end_frame(current_thread);
@@ -3204,6 +3338,7 @@ end_frame(Thread *current_thread) {
   _primitive_batches_display_list_pcollector.flush_level();
   _vertices_display_list_pcollector.flush_level();
   _vertices_immediate_pcollector.flush_level();
+  _data_streamed_pcollector.flush_level();
 
   // Now is a good time to delete any pending display lists.
 #ifndef OPENGLES
@@ -4390,6 +4525,98 @@ end_draw_primitives() {
   report_my_gl_errors();
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: GLGraphicsStateGuardian::draw_batch
+//       Access: Public, Virtual
+//  Description: Draws a run of objects that share the same state and
+//               transform.  If multi-draw indirect is available, the
+//               static triangle geometry among them is packed into
+//               a geom pool for its vertex format, and drawn with a
+//               single call per format; the rest is drawn one object
+//               at a time, as usual.
+////////////////////////////////////////////////////////////////////
+void CLP(GraphicsStateGuardian)::
+draw_batch(CullableObject *const *objects, int num_objects, bool force,
+           Thread *current_thread) {
+#ifndef OPENGLES
+  if (!_supports_multi_draw_indirect || num_objects < 2) {
+    GraphicsStateGuardian::draw_batch(objects, num_objects, force, current_thread);
+    return;
+  }
+
+  set_state_and_transform(objects[0]->_state, objects[0]->_internal_transform);
+  if (_instance_count > 0) {
+    // Instanced objects are drawn with their own instance count, which
+    // the pooled draw commands don't account for.
+    GraphicsStateGuardian::draw_batch(objects, num_objects, force, current_thread);
+    return;
+  }
+
+  // Sort the objects into a list of draw commands for each pool,
+  // remembering the first object of each, from which we set up the
+  // vertex arrays.
+  typedef pair<const CullableObject *, CLP(GeomPool)::Commands> Batch;
+  typedef pmap<CLP(GeomPool) *, Batch> Batches;
+  Batches batches;
+
+  for (int i = 0; i < num_objects; ++i) {
+    const CullableObject *object = objects[i];
+    if (!CLP(GeomPool)::is_eligible(object)) {
+      objects[i]->draw(this, force, current_thread);
+      continue;
+    }
+
+    const GeomVertexFormat *format = object->_munged_data->get_format();
+    CLP(GeomPool) *&pool = _geom_pools[format];
+    if (pool == (CLP(GeomPool) *)NULL) {
+      pool = new CLP(GeomPool)(this, format);
+    }
+
+    Batch &batch = batches[pool];
+    if (batch.first == (const CullableObject *)NULL) {
+      batch.first = object;
+    }
+    if (!pool->add_object(object, batch.second, current_thread)) {
+      objects[i]->draw(this, force, current_thread);
+    }
+  }
+
+  Batches::iterator bi;
+  for (bi = batches.begin(); bi != batches.end(); ++bi) {
+    CLP(GeomPool) *pool = (*bi).first;
+    const CullableObject *object = (*bi).second.first;
+    const CLP(GeomPool)::Commands &commands = (*bi).second.second;
+    if (commands.empty()) {
+      continue;
+    }
+
+    GeomPipelineReader geom_reader(object->_geom, current_thread);
+    geom_reader.check_usage_hint();
+    GeomVertexDataPipelineReader data_reader(object->_munged_data, current_thread);
+    data_reader.check_array_readers();
+
+    // While the pool is current, setup_array_data() binds the pool's
+    // buffers rather than those of the object's own vertex data.
+    _current_geom_pool = pool;
+    if (begin_draw_primitives(&geom_reader, object->_munger, &data_reader, force)) {
+      pool->draw(commands);
+
+      CLP(GeomPool)::Commands::const_iterator ci;
+      for (ci = commands.begin(); ci != commands.end(); ++ci) {
+        _vertices_tri_pcollector.add_level((*ci)._count);
+      }
+      _primitive_batches_tri_pcollector.add_level(1);
+
+      end_draw_primitives();
+    }
+    _current_geom_pool = NULL;
+  }
+
+#else
+  GraphicsStateGuardian::draw_batch(objects, num_objects, force, current_thread);
+#endif  // OPENGLES
+}
+
 #ifndef OPENGLES
 ////////////////////////////////////////////////////////////////////
 //     Function: GLGraphicsStateGuardian::issue_memory_barrier
@@ -4887,6 +5114,37 @@ apply_vertex_buffer(VertexBufferContext *vbc,
 
   CLP(VertexBufferContext) *gvbc = DCAST(CLP(VertexBufferContext), vbc);
 
+  if (_vertex_stream_buffer != NULL &&
+      _vertex_stream_buffer->can_stream(reader->get_usage_hint(),
+                                        reader->get_data_size_bytes())) {
+    // This array changes often enough that we copy it into the
+    // stream buffer rather than respecifying a buffer of its own.
+    // The copy is reused until the data changes or the ring comes
+    // around to overwrite it.
+    gvbc->_streamed = true;
+    if (gvbc->_stream_modified != reader->get_modified() ||
+        !_vertex_stream_buffer->is_resident(gvbc->_stream_position)) {
+      const unsigned char *client_pointer = reader->get_read_pointer(force);
+      if (client_pointer == NULL) {
+        return false;
+      }
+
+      int num_bytes = reader->get_data_size_bytes();
+      PStatGPUTimer timer(this, _load_vertex_buffer_pcollector, reader->get_current_thread());
+      gvbc->_stream_position = _vertex_stream_buffer->upload(client_pointer, num_bytes);
+      gvbc->_stream_modified = reader->get_modified();
+      _data_streamed_pcollector.add_level(num_bytes);
+    } else {
+      _vertex_stream_buffer->reuse(gvbc->_stream_position);
+    }
+    _vertex_stream_buffer->bind();
+
+    maybe_gl_finish();
+    report_my_gl_errors();
+    return true;
+  }
+  gvbc->_streamed = false;
+
   if (_current_vbuffer_index != gvbc->_index) {
     if (GLCAT.is_spam() && gl_debug_buffers) {
       GLCAT.spam()
@@ -4983,7 +5241,10 @@ release_vertex_buffer(VertexBufferContext *vbc) {
 //               buffer object in server memory); if the buffer object
 //               is not bound, this function sets client_pointer the
 //               pointer to the data array in client memory, that is,
-//               the data array passed in.
+//               the data array passed in.  If the data was copied
+//               into the stream buffer, the stream buffer is bound
+//               and client_pointer is set to the data's offset
+//               within it.
 //
 //               If force is not true, the function may return false
 //               indicating the data is not currently available.
@@ -4992,6 +5253,15 @@ bool CLP(GraphicsStateGuardian)::
 setup_array_data(const unsigned char *&client_pointer,
                  const GeomVertexArrayDataHandle *array_reader,
                  bool force) {
+#ifndef OPENGLES
+  if (_current_geom_pool != NULL) {
+    // We are drawing a multi-draw batch; the vertices come from the
+    // pool's buffers instead.
+    return _current_geom_pool->setup_array_data(client_pointer, array_reader,
+                                                _data_reader);
+  }
+#endif
+
   if (!_supports_buffers) {
     // No support for buffer objects; always render from client.
     client_pointer = array_reader->get_read_pointer(force);
@@ -5020,6 +5290,14 @@ setup_array_data(const unsigned char *&client_pointer,
     return false;
   }
 
+  CLP(VertexBufferContext) *gvbc = DCAST(CLP(VertexBufferContext), vbc);
+  if (gvbc->_streamed) {
+    // The data is somewhere in the middle of the stream buffer.
+    size_t offset = _vertex_stream_buffer->get_offset(gvbc->_stream_position);
+    client_pointer = (const unsigned char *)offset;
+    return true;
+  }
+
   // NULL is the OpenGL convention for the first byte of the buffer object.
   client_pointer = NULL;
   return true;
@@ -5081,6 +5359,35 @@ apply_index_buffer(IndexBufferContext *ibc,
 
   CLP(IndexBufferContext) *gibc = DCAST(CLP(IndexBufferContext), ibc);
 
+  if (_index_stream_buffer != NULL &&
+      _index_stream_buffer->can_stream(reader->get_usage_hint(),
+                                       reader->get_data_size_bytes())) {
+    // As in apply_vertex_buffer(), frequently-changing index data is
+    // copied into the stream buffer.
+    gibc->_streamed = true;
+    if (gibc->_stream_modified != reader->get_modified() ||
+        !_index_stream_buffer->is_resident(gibc->_stream_position)) {
+      const unsigned char *client_pointer = reader->get_read_pointer(force);
+      if (client_pointer == NULL) {
+        return false;
+      }
+
+      int num_bytes = reader->get_data_size_bytes();
+      PStatGPUTimer timer(this, _load_index_buffer_pcollector, reader->get_current_thread());
+      gibc->_stream_position = _index_stream_buffer->upload(client_pointer, num_bytes);
+      gibc->_stream_modified = reader->get_modified();
+      _data_streamed_pcollector.add_level(num_bytes);
+    } else {
+      _index_stream_buffer->reuse(gibc->_stream_position);
+    }
+    _index_stream_buffer->bind();
+
+    maybe_gl_finish();
+    report_my_gl_errors();
+    return true;
+  }
+  gibc->_streamed = false;
+
   if (_current_ibuffer_index != gibc->_index) {
     if (GLCAT.is_spam() && gl_debug_buffers) {
       GLCAT.spam()
@@ -5177,7 +5484,9 @@ release_index_buffer(IndexBufferContext *ibc) {
 //               buffer object in server memory); if the buffer object
 //               is not bound, this function sets client_pointer to to
 //               the data array in client memory, that is, the data
-//               array passed in.
+//               array passed in.  If the indices were copied into the
+//               stream buffer, the stream buffer is bound and
+//               client_pointer is set to their offset within it.
 //
 //               If force is not true, the function may return false
 //               indicating the data is not currently available.
@@ -5214,6 +5523,14 @@ setup_primitive(const unsigned char *&client_pointer,
     return false;
   }
 
+  CLP(IndexBufferContext) *gibc = DCAST(CLP(IndexBufferContext), ibc);
+  if (gibc->_streamed) {
+    // The indices are somewhere in the middle of the stream buffer.
+    size_t offset = _index_stream_buffer->get_offset(gibc->_stream_position);
+    client_pointer = (const unsigned char *)offset;
+    return true;
+  }
+
   // NULL is the OpenGL convention for the first byte of the buffer object.
   client_pointer = NULL;
   return true;
@@ -5926,6 +6243,7 @@ do_issue_shader(bool state_has_changed) {
       if (_current_shader_context != 0) {
         _current_shader_context->unbind();
       }
+      DO_PSTATS_STUFF(_shader_state_pcollector.add_level(1));
       context->bind();
       _current_shader = shader;
       _current_shader_context = context;
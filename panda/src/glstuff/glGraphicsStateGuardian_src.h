@@ -222,9 +222,19 @@ typedef GLboolean (APIENTRYP PFNGLISIMAGEHANDLERESIDENTPROC) (GLuint64 handle);
 typedef void (APIENTRYP PFNGLVERTEXATTRIBL1UI64PROC) (GLuint index, GLuint64EXT x);
 typedef void (APIENTRYP PFNGLVERTEXATTRIBL1UI64VPROC) (GLuint index, const GLuint64EXT *v);
 typedef void (APIENTRYP PFNGLGETVERTEXATTRIBLUI64VPROC) (GLuint index, GLenum pname, GLuint64EXT *params);
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC) (GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+typedef void (APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTPROC) (GLenum mode, GLenum type, const void *indirect, GLsizei drawcount, GLsizei stride);
 #endif  // OPENGLES
 #endif  // __EDG__
 
+#ifndef OPENGLES
+// ARB_buffer_storage is more recent than our copy of glext.h.
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT             0x0040
+#define GL_MAP_COHERENT_BIT               0x0080
+#endif
+#endif  // OPENGLES
+
 ////////////////////////////////////////////////////////////////////
 //       Class : GLGraphicsStateGuardian
 // Description : A GraphicsStateGuardian specialized for rendering
@@ -281,6 +291,9 @@ public:
                            bool force);
   virtual void end_draw_primitives();
 
+  virtual void draw_batch(CullableObject *const *objects, int num_objects,
+                          bool force, Thread *current_thread);
+
 #ifndef OPENGLES
   void issue_memory_barrier(GLbitfield barrier);
 #endif
@@ -727,6 +740,36 @@ public:
   PFNGLBUFFERSUBDATAPROC _glBufferSubData;
   PFNGLDELETEBUFFERSPROC _glDeleteBuffers;
 
+#ifndef OPENGLES
+  PFNGLMAPBUFFERRANGEPROC _glMapBufferRange;
+  PFNGLUNMAPBUFFERPROC _glUnmapBuffer;
+
+  bool _supports_buffer_storage;
+  PFNGLBUFFERSTORAGEPROC _glBufferStorage;
+
+  bool _supports_sync;
+  PFNGLFENCESYNCPROC _glFenceSync;
+  PFNGLDELETESYNCPROC _glDeleteSync;
+  PFNGLCLIENTWAITSYNCPROC _glClientWaitSync;
+#endif  // OPENGLES
+
+  // Frequently-changing vertex and index arrays are streamed through
+  // these ring buffers rather than given buffer objects of their own.
+  CLP(StreamBuffer) *_vertex_stream_buffer;
+  CLP(StreamBuffer) *_index_stream_buffer;
+
+#ifndef OPENGLES
+  PFNGLMULTIDRAWELEMENTSINDIRECTPROC _glMultiDrawElementsIndirect;
+
+  // Static Geoms drawn with draw_batch() are packed into one of these
+  // pools, according to their vertex format.  While a batch from a
+  // pool is being drawn, _current_geom_pool points to it, so that
+  // setup_array_data() binds the pool's buffers.
+  typedef pmap<const GeomVertexFormat *, CLP(GeomPool) *> GeomPools;
+  GeomPools _geom_pools;
+  CLP(GeomPool) *_current_geom_pool;
+#endif  // OPENGLES
+
   PFNGLBLENDEQUATIONPROC _glBlendEquation;
   PFNGLBLENDCOLORPROC _glBlendColor;
 
@@ -934,6 +977,8 @@ public:
   static PStatCollector _texture_update_pcollector;
   static PStatCollector _fbo_bind_pcollector;
   static PStatCollector _check_error_pcollector;
+  static PStatCollector _data_streamed_pcollector;
+  static PStatCollector _stream_buffer_wait_pcollector;
 
 public:
   virtual TypeHandle get_type() const {
@@ -957,6 +1002,8 @@ private:
 
   friend class CLP(VertexBufferContext);
   friend class CLP(IndexBufferContext);
+  friend class CLP(StreamBuffer);
+  friend class CLP(GeomPool);
   friend class CLP(ShaderContext);
   friend class CLP(CgShaderContext);
   friend class CLP(GraphicsBuffer);
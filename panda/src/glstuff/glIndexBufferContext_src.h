@@ -15,6 +15,7 @@
 #include "pandabase.h"
 #include "indexBufferContext.h"
 #include "deletedChain.h"
+#include "updateSeq.h"
 
 ////////////////////////////////////////////////////////////////////
 //       Class : GLIndexBufferContext
@@ -35,6 +36,13 @@ public:
   // This is the GL "name" of the data object.
   GLuint _index;
 
+  // If the data is streamed through the GSG's index stream buffer
+  // instead, this is where it was last copied, and the modification
+  // count of the data at the time.
+  bool _streamed;
+  PN_uint64 _stream_position;
+  UpdateSeq _stream_modified;
+
 public:
   static TypeHandle get_class_type() {
     return _type_handle;
@@ -0,0 +1,344 @@
+// Filename: glStreamBuffer_src.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "pStatTimer.h"
+
+////////////////////////////////////////////////////////////////////
+//     Function: GLStreamBuffer::Constructor
+//       Access: Public
+//  Description: Creates the buffer object and allocates its storage.
+//               The GSG's context must be current.
+////////////////////////////////////////////////////////////////////
+CLP(StreamBuffer)::
+CLP(StreamBuffer)(CLP(GraphicsStateGuardian) *glgsg, GLenum target,
+                  size_t size, bool persistent) :
+  _glgsg(glgsg),
+  _target(target),
+  _index(0),
+  _size(size & ~(size_t)15),
+  _head(0),
+  _valid_position(0)
+{
+#ifndef OPENGLES
+  _mapped = (unsigned char *)NULL;
+  _unfenced_low = 0;
+#endif
+
+  _glgsg->_glGenBuffers(1, &_index);
+  bind();
+
+#ifndef OPENGLES
+  if (persistent) {
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    _glgsg->_glBufferStorage(_target, _size, NULL, flags);
+    _mapped = (unsigned char *)_glgsg->_glMapBufferRange(_target, 0, _size, flags);
+
+    if (_mapped == (unsigned char *)NULL) {
+      GLCAT.warning()
+        << "Could not map stream buffer persistently; it will be orphaned instead.\n";
+
+      // The storage of the old buffer is immutable, so we need a new
+      // buffer object to fall back to glBufferData().
+      release();
+      _glgsg->_glGenBuffers(1, &_index);
+      bind();
+    }
+  }
+
+  if (_mapped == (unsigned char *)NULL)
+#endif  // OPENGLES
+  {
+    _glgsg->_glBufferData(_target, _size, NULL,
+                          _glgsg->get_usage(Geom::UH_stream));
+  }
+
+  if (GLCAT.is_debug() && gl_debug_buffers) {
+    GLCAT.debug()
+      << "creating " << (is_persistent() ? "persistent " : "")
+      << ((_target == GL_ELEMENT_ARRAY_BUFFER) ? "index" : "vertex")
+      << " stream buffer " << (int)_index << ": " << _size << " bytes\n";
+  }
+
+  _glgsg->report_my_gl_errors();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: GLStreamBuffer::Destructor
+//       Access: Public
+//  Description: Note that the destructor does not free the GL
+//               resources, since the context may no longer be
+//               current (or may already be gone).  Call release()
+//               first if the buffer should be freed explicitly.
+////////////////////////////////////////////////////////////////////
+CLP(StreamBuffer)::
+~CLP(StreamBuffer)() {
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: GLStreamBuffer::bind
+//       Access: Public
+//  Description: Binds the buffer object to its target, if it is not
+//               already bound.
+////////////////////////////////////////////////////////////////////
+void CLP(StreamBuffer)::
+bind() {
+  GLuint &current_index = (_target == GL_ELEMENT_ARRAY_BUFFER) ?
+    _glgsg->_current_ibuffer_index : _glgsg->_current_vbuffer_index;
+
+  if (current_index != _index) {
+    if (GLCAT.is_spam() && gl_debug_buffers) {
+      GLCAT.spam()
+        << "binding stream buffer " << (int)_index << "\n";
+    }
+    _glgsg->_glBindBuffer(_target, _index);
+    current_index = _index;
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: GLStreamBuffer::upload
+//       Access: Public
+//  Description: Copies the indicated data into a newly allocated
+//               region of the buffer, and returns the stream position
+//               of the region.  Use get_offset() to convert this to
+//               an offset within the buffer object.
+//
+//               The buffer may or may not be bound after this call;
+//               call bind() before drawing from it.
+////////////////////////////////////////////////////////////////////
+PN_uint64 CLP(StreamBuffer)::
+upload(const unsigned char *data, size_t num_bytes) {
+  nassertr(num_bytes <= _size, _head);
+
+  PN_uint64 position = allocate(num_bytes);
+  size_t offset = get_offset(position);
+
+#ifndef OPENGLES
+  if (_mapped != (unsigned char *)NULL) {
+    memcpy(_mapped + offset, data, num_bytes);
+    return position;
+  }
+
+  if (_glgsg->_glMapBufferRange != NULL) {
+    // Nothing has been drawn from this region since the buffer was
+    // last orphaned, so there is no need for the driver to wait.
+    bind();
+    void *ptr = _glgsg->_glMapBufferRange(_target, offset, num_bytes,
+                                          GL_MAP_WRITE_BIT |
+                                          GL_MAP_INVALIDATE_RANGE_BIT |
+                                          GL_MAP_UNSYNCHRONIZED_BIT);
+    if (ptr != NULL) {
+      memcpy(ptr, data, num_bytes);
+      _glgsg->_glUnmapBuffer(_target);
+      return position;
+    }
+  }
+#endif  // OPENGLES
+
+  bind();
+  _glgsg->_glBufferSubData(_target, offset, num_bytes, data);
+  return position;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: GLStreamBuffer::end_frame
+//       Access: Public
+//  Description: Called by the GSG at the end of each frame.  For a
+//               persistent buffer, this inserts a fence guarding the
+//               data that was written during the frame.
+////////////////////////////////////////////////////////////////////
+void CLP(StreamBuffer)::
+end_frame() {
+#ifndef OPENGLES
+  if (_mapped != (unsigned char *)NULL && _unfenced_low < _head) {
+    insert_fence();
+  }
+#endif
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: GLStreamBuffer::release
+//       Access: Public
+//  Description: Frees the GL resources held by the buffer.  The
+//               GSG's context must be current.
+////////////////////////////////////////////////////////////////////
+void CLP(StreamBuffer)::
+release() {
+#ifndef OPENGLES
+  Fences::iterator fi;
+  for (fi = _fences.begin(); fi != _fences.end(); ++fi) {
+    _glgsg->_glDeleteSync((*fi)._sync);
+  }
+  _fences.clear();
+
+  if (_mapped != (unsigned char *)NULL) {
+    bind();
+    _glgsg->_glUnmapBuffer(_target);
+    _mapped = (unsigned char *)NULL;
+  }
+  _unfenced_low = _head;
+#endif  // OPENGLES
+
+  if (_index != 0) {
+    GLuint &current_index = (_target == GL_ELEMENT_ARRAY_BUFFER) ?
+      _glgsg->_current_ibuffer_index : _glgsg->_current_vbuffer_index;
+    if (current_index == _index) {
+      _glgsg->_glBindBuffer(_target, 0);
+      current_index = 0;
+    }
+
+    if (GLCAT.is_debug() && gl_debug_buffers) {
+      GLCAT.debug()
+        << "deleting stream buffer " << (int)_index << "\n";
+    }
+    _glgsg->_glDeleteBuffers(1, &_index);
+    _index = 0;
+  }
+
+  _valid_position = _head;
+  _glgsg->report_my_gl_errors();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: GLStreamBuffer::allocate
+//       Access: Private
+//  Description: Reserves the indicated number of bytes at the head
+//               of the ring, wrapping around to the beginning of the
+//               buffer if they do not fit in the remainder of it, and
+//               returns the stream position of the reserved region.
+//               The region is aligned to 16 bytes, which satisfies
+//               the alignment needs of any vertex or index format.
+////////////////////////////////////////////////////////////////////
+PN_uint64 CLP(StreamBuffer)::
+allocate(size_t num_bytes) {
+  PN_uint64 position = (_head + 15) & ~(PN_uint64)15;
+  size_t offset = get_offset(position);
+
+  bool wrapped = false;
+  if (offset + num_bytes > _size) {
+    // Skip the remainder of the buffer.
+    position += _size - offset;
+    wrapped = true;
+  }
+  PN_uint64 head = position + num_bytes;
+
+#ifndef OPENGLES
+  if (_mapped != (unsigned char *)NULL) {
+    // Make sure the GPU is done with the data we are about to
+    // overwrite, which was written one full ring earlier, but may
+    // have been drawn from again more recently.  This must be done
+    // before advancing _head, so that a fence inserted here does not
+    // claim to guard the region we are now handing out.
+    if (head > _size) {
+      wait_fences(head - _size);
+    }
+    _head = head;
+    return position;
+  }
+#endif
+
+  _head = head;
+  if (wrapped) {
+    orphan();
+    _valid_position = position;
+  }
+  return position;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: GLStreamBuffer::orphan
+//       Access: Private
+//  Description: Respecifies the storage of a non-persistent buffer,
+//               so that the driver can hand us fresh memory while the
+//               GPU keeps reading from the old storage.
+////////////////////////////////////////////////////////////////////
+void CLP(StreamBuffer)::
+orphan() {
+  if (GLCAT.is_spam() && gl_debug_buffers) {
+    GLCAT.spam()
+      << "orphaning stream buffer " << (int)_index << "\n";
+  }
+  bind();
+  _glgsg->_glBufferData(_target, _size, NULL,
+                        _glgsg->get_usage(Geom::UH_stream));
+}
+
+#ifndef OPENGLES
+////////////////////////////////////////////////////////////////////
+//     Function: GLStreamBuffer::insert_fence
+//       Access: Private
+//  Description: Inserts a fence guarding all of the data written to
+//               or drawn from the buffer since the last fence.
+////////////////////////////////////////////////////////////////////
+void CLP(StreamBuffer)::
+insert_fence() {
+  Fence fence;
+  fence._sync = _glgsg->_glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  fence._low = _unfenced_low;
+  _fences.push_back(fence);
+  _unfenced_low = _head;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: GLStreamBuffer::wait_fences
+//       Access: Private
+//  Description: Blocks until the GPU has finished with all of the
+//               data before the indicated stream position, whether it
+//               was written or only drawn from again since.
+////////////////////////////////////////////////////////////////////
+void CLP(StreamBuffer)::
+wait_fences(PN_uint64 position) {
+  if (_unfenced_low < position) {
+    // Some of this data has been written or drawn from during this
+    // very frame.  This only happens if a frame streams more data
+    // than fits in the buffer, or draws from a region that is about
+    // to be overwritten.  It will cost us a stall, but we must fence
+    // it now.
+    insert_fence();
+  }
+
+  // Fences complete in order, so we need only wait for the last one
+  // that guards anything before the position.
+  Fences::iterator last = _fences.end();
+  Fences::iterator fi;
+  for (fi = _fences.begin(); fi != _fences.end(); ++fi) {
+    if ((*fi)._low < position) {
+      last = fi;
+    }
+  }
+  if (last == _fences.end()) {
+    return;
+  }
+
+  PStatTimer timer(CLP(GraphicsStateGuardian)::_stream_buffer_wait_pcollector);
+  GLenum result;
+  do {
+    result = _glgsg->_glClientWaitSync((*last)._sync, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                       1000000);
+  } while (result == GL_TIMEOUT_EXPIRED);
+
+  if (result == GL_WAIT_FAILED) {
+    GLCAT.error()
+      << "Failed to wait for stream buffer fence.\n";
+  }
+
+  // Waiting for this fence also implies that all of the earlier ones
+  // have passed.
+  ++last;
+  for (fi = _fences.begin(); fi != last; ++fi) {
+    _glgsg->_glDeleteSync((*fi)._sync);
+  }
+  _fences.erase(_fences.begin(), last);
+}
+#endif  // OPENGLES
@@ -0,0 +1,107 @@
+// Filename: glStreamBuffer_src.h
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "pandabase.h"
+#include "geomEnums.h"
+#include "pdeque.h"
+
+class CLP(GraphicsStateGuardian);
+
+////////////////////////////////////////////////////////////////////
+//       Class : GLStreamBuffer
+// Description : A large buffer object, used as a ring buffer, from
+//               which the GSG sub-allocates space for vertex or index
+//               arrays that change frequently.  Copying such an array
+//               into a fresh region of the ring avoids the implicit
+//               synchronization the driver would otherwise perform
+//               when respecifying a buffer object that the GPU may
+//               still be reading from.
+//
+//               If ARB_buffer_storage is available, the buffer is
+//               kept persistently mapped, and a fence is inserted at
+//               the end of each frame so that a region is not
+//               overwritten until the GPU has finished with it.  A
+//               context that draws again from a region written in an
+//               earlier frame must call reuse(), so that the region
+//               is guarded by the fence of the current frame too.
+//               Otherwise, the buffer is orphaned each time the ring
+//               wraps around, and the data is written with
+//               unsynchronized mappings or glBufferSubData.
+//
+//               Space is allocated in terms of an ever-increasing
+//               stream position, which modulo the size of the buffer
+//               gives the offset within the buffer.  A context can
+//               keep a position around and check is_resident() to
+//               see whether its data is still there to be reused.
+////////////////////////////////////////////////////////////////////
+class EXPCL_GL CLP(StreamBuffer) {
+public:
+  CLP(StreamBuffer)(CLP(GraphicsStateGuardian) *glgsg, GLenum target,
+                    size_t size, bool persistent);
+  ~CLP(StreamBuffer)();
+
+  INLINE GLuint get_index() const;
+  INLINE size_t get_size() const;
+  INLINE bool is_persistent() const;
+
+  INLINE bool can_stream(GeomEnums::UsageHint usage_hint,
+                         size_t num_bytes) const;
+  INLINE bool is_resident(PN_uint64 position) const;
+  INLINE size_t get_offset(PN_uint64 position) const;
+
+  void bind();
+  PN_uint64 upload(const unsigned char *data, size_t num_bytes);
+  INLINE void reuse(PN_uint64 position);
+  void end_frame();
+  void release();
+
+private:
+  PN_uint64 allocate(size_t num_bytes);
+  void orphan();
+#ifndef OPENGLES
+  void insert_fence();
+  void wait_fences(PN_uint64 position);
+#endif
+
+  CLP(GraphicsStateGuardian) *_glgsg;
+  GLenum _target;
+  GLuint _index;
+  size_t _size;
+
+  // The stream position at which the next allocation will be made.
+  // Data written before _valid_position is gone, either because the
+  // buffer has since been orphaned or because the ring has come
+  // around and overwritten it.
+  PN_uint64 _head;
+  PN_uint64 _valid_position;
+
+#ifndef OPENGLES
+  unsigned char *_mapped;
+
+  // Each fence guards the data that was written or drawn from
+  // between the previous fence and itself, none of which lies before
+  // _low.  _unfenced_low is the lowest position written or drawn from
+  // since the last fence; it equals _head if there is none.
+  class Fence {
+  public:
+    GLsync _sync;
+    PN_uint64 _low;
+  };
+  typedef pdeque<Fence> Fences;
+  Fences _fences;
+  PN_uint64 _unfenced_low;
+#endif  // OPENGLES
+};
+
+#include "glStreamBuffer_src.I"
@@ -15,6 +15,7 @@
 #include "pandabase.h"
 #include "vertexBufferContext.h"
 #include "deletedChain.h"
+#include "updateSeq.h"
 
 class CLP(GraphicsStateGuardian);
 
@@ -37,6 +38,13 @@ public:
   // This is the GL "name" of the data object.
   GLuint _index;
 
+  // If the data is streamed through the GSG's vertex stream buffer
+  // instead, this is where it was last copied, and the modification
+  // count of the data at the time.
+  bool _streamed;
+  PN_uint64 _stream_position;
+  UpdateSeq _stream_modified;
+
 public:
   static TypeHandle get_class_type() {
     return _type_handle;
@@ -136,6 +136,42 @@ ConfigVariableEnum<GeomEnums::UsageHint> gl_min_buffer_usage_hint
             "of reusing the same buffers.  Consider increasing "
             "released-vbuffer-cache-size instead."));
 
+ConfigVariableInt gl_stream_buffer_size
+  ("gl-stream-buffer-size", 4194304,
+   PRC_DESC("This is the size in bytes of each of the two ring buffers "
+            "(one for vertices, one for indices) through which "
+            "frequently-changing vertex and index data are streamed to "
+            "the graphics card, instead of giving each such array its "
+            "own buffer object that is respecified whenever it changes.  "
+            "Arrays larger than a quarter of this size are not streamed.  "
+            "Set this to 0 to disable stream buffers altogether."));
+
+ConfigVariableEnum<GeomEnums::UsageHint> gl_stream_buffer_usage_hint
+  ("gl-stream-buffer-usage-hint", GeomEnums::UH_dynamic,
+   PRC_DESC("Vertex and index arrays with this usage hint or a more "
+            "dynamic one are uploaded through the stream buffers "
+            "described by gl-stream-buffer-size.  Set this to \"stream\" "
+            "to stream only arrays that change every frame."));
+
+ConfigVariableBool gl_persistent_stream_buffers
+  ("gl-persistent-stream-buffers", true,
+   PRC_DESC("If this is true and the driver supports ARB_buffer_storage, "
+            "the stream buffers are kept permanently mapped, and fences "
+            "are used to avoid overwriting data the GPU is still reading.  "
+            "If false, or if the extension is not available, a stream "
+            "buffer is instead orphaned each time it wraps around."));
+
+ConfigVariableBool gl_multi_draw_indirect
+  ("gl-multi-draw-indirect", false,
+   PRC_DESC("Set this true to pack static triangle Geoms that share a "
+            "vertex format into shared buffers, and draw each run of "
+            "them that shares the same state and transform with a "
+            "single call to glMultiDrawElementsIndirect.  This can "
+            "greatly reduce the CPU cost of drawing large static scenes "
+            "made up of many separate Geoms, at the cost of keeping an "
+            "extra copy of their vertex data in system memory.  It "
+            "requires ARB_multi_draw_indirect."));
+
 ConfigVariableBool gl_debug
   ("gl-debug", false,
    PRC_DESC("Setting this to true will cause OpenGL to emit more useful "
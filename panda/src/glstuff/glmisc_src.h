@@ -58,6 +58,10 @@ extern ConfigVariableBool gl_interleaved_arrays;
 extern ConfigVariableBool gl_parallel_arrays;
 extern ConfigVariableInt gl_max_errors;
 extern ConfigVariableEnum<GeomEnums::UsageHint> gl_min_buffer_usage_hint;
+extern ConfigVariableInt gl_stream_buffer_size;
+extern ConfigVariableEnum<GeomEnums::UsageHint> gl_stream_buffer_usage_hint;
+extern ConfigVariableBool gl_persistent_stream_buffers;
+extern ConfigVariableBool gl_multi_draw_indirect;
 extern ConfigVariableBool gl_debug;
 extern ConfigVariableBool gl_debug_synchronous;
 extern ConfigVariableEnum<NotifySeverity> gl_debug_abort_level;
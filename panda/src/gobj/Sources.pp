@@ -6,7 +6,8 @@
 #begin lib_target
   #define TARGET p3gobj
   #define LOCAL_LIBS \
-    p3pstatclient p3event p3linmath p3mathutil p3pnmimage p3gsgbase p3putil
+    p3pstatclient p3event p3linmath p3mathutil p3pnmimage p3gsgbase p3putil \
+    p3downloader
 
   #define COMBINED_SOURCES $[TARGET]_composite1.cxx $[TARGET]_composite2.cxx \
                            $[TARGET]_ext_composite.cxx
@@ -65,6 +66,7 @@
     textureCollection.I textureCollection.h \
     textureCollection_ext.h \
     textureContext.I textureContext.h \
+    textureDecoder.I textureDecoder.h \
     texturePeeker.I texturePeeker.h \
     texturePool.I texturePool.h \
     texturePoolFilter.I texturePoolFilter.h \
@@ -141,6 +143,7 @@
     textureCollection.cxx \
     textureCollection_ext.cxx \
     textureContext.cxx \
+    textureDecoder.cxx \
     texturePeeker.cxx \
     texturePool.cxx \
     texturePoolFilter.cxx \
@@ -216,6 +219,7 @@
     texture.I texture.h \
     textureCollection.I textureCollection.h \
     textureContext.I textureContext.h \
+    textureDecoder.I textureDecoder.h \
     texturePeeker.I texturePeeker.h \
     texturePool.I texturePool.h \
     texturePoolFilter.I texturePoolFilter.h \
@@ -253,3 +257,25 @@
 
 #end test_bin_target
 
+#begin test_bin_target
+  #define TARGET test_textureDecoder
+  #define LOCAL_LIBS \
+    p3gobj p3pnmimagetypes p3putil
+  #define OTHER_LIBS $[OTHER_LIBS] p3pystub
+
+  #define SOURCES \
+    test_textureDecoder.cxx
+
+#end test_bin_target
+
+#begin test_bin_target
+  #define TARGET test_ktx
+  #define LOCAL_LIBS \
+    p3gobj p3putil
+  #define OTHER_LIBS $[OTHER_LIBS] p3pystub
+
+  #define SOURCES \
+    test_ktx.cxx
+
+#end test_bin_target
+
@@ -344,6 +344,20 @@ ConfigVariableBool textures_header_only
           "number of channels and so forth.  The texture images themselves "
           "will be generated in a default blue color."));
 
+ConfigVariableInt texture_decode_threads
+("texture-decode-threads", 4,
+ PRC_DESC("The number of threads that may decode the image files of a "
+          "cube map, 3-D texture or mipmap sequence at the same time, when "
+          "it is loaded from a sequence of files.  The files themselves are "
+          "read by one more thread.  Set this to 0 or 1 to read and decode "
+          "the files one at a time on the loading thread."));
+
+ConfigVariableInt texture_decode_read_ahead
+("texture-decode-read-ahead", 8,
+ PRC_DESC("The number of image files that may be held in memory, read but "
+          "not yet decoded, while the pages of a texture are decoded by "
+          "texture-decode-threads."));
+
 ConfigVariableInt simple_image_size
 ("simple-image-size", "16 16",
  PRC_DESC("This is an x y pair that specifies the maximum size of an "
@@ -13,6 +13,7 @@
 #include "texture.cxx"
 #include "textureCollection.cxx"
 #include "textureContext.cxx"
+#include "textureDecoder.cxx"
 #include "texturePeeker.cxx"
 #include "texturePool.cxx"
 #include "texturePoolFilter.cxx"
@@ -0,0 +1,216 @@
+// Filename: test_ktx.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "pandabase.h"
+#include "texture.h"
+#include "config_gobj.h"
+#include "testCheck.h"
+
+// This program writes textures of various types and formats to KTX
+// files in memory, reads them back, and checks that they come back
+// the same, mipmaps and all.  It also checks that a file whose mipmap
+// level size does not agree with its header is rejected.
+
+static TestCheck check;
+
+////////////////////////////////////////////////////////////////////
+//     Function: fill_image
+//  Description: Fills an image with a pattern that depends on the
+//               seed, so that no two levels look alike.
+////////////////////////////////////////////////////////////////////
+static void
+fill_image(PTA_uchar image, int seed) {
+  for (size_t i = 0; i < image.size(); ++i) {
+    image[i] = (unsigned char)((i * 7 + seed * 31) & 0xff);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: fill_uncompressed
+//  Description: Fills in the ram image of the texture, and generates
+//               its mipmap levels.
+////////////////////////////////////////////////////////////////////
+static void
+fill_uncompressed(Texture *tex) {
+  fill_image(tex->make_ram_image(), 0);
+  if (tex->get_component_type() == Texture::T_float) {
+    // Random bytes may be NaNs, which don't filter well.
+    PTA_uchar image = tex->modify_ram_image();
+    float *p = (float *)image.p();
+    for (size_t i = 0; i < image.size() / sizeof(float); ++i) {
+      p[i] = (float)i * 0.25f;
+    }
+  }
+  tex->generate_ram_mipmap_images();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: fill_compressed
+//  Description: Fills in the ram image of the texture with fake
+//               compressed data of the given size per page, for
+//               each mipmap level.
+////////////////////////////////////////////////////////////////////
+static void
+fill_compressed(Texture *tex, Texture::CompressionMode compression,
+                const size_t *page_sizes, int num_levels) {
+  for (int n = 0; n < num_levels; ++n) {
+    size_t size = page_sizes[n] * tex->get_expected_mipmap_z_size(n);
+    PTA_uchar image = PTA_uchar::empty_array(size);
+    fill_image(image, n + 1);
+    if (n == 0) {
+      tex->set_ram_image(image, compression, page_sizes[n]);
+    } else {
+      tex->set_ram_mipmap_image(n, image, page_sizes[n]);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: round_trip
+//  Description: Writes the texture to a KTX file and reads it back,
+//               checking that the result matches.  Returns the file.
+////////////////////////////////////////////////////////////////////
+static string
+round_trip(Texture *tex, const string &description) {
+  ostringstream out;
+  check(tex->write_ktx(out, description), description + ": write");
+  string data = out.str();
+
+  istringstream in(data);
+  PT(Texture) result = new Texture;
+  if (!result->read_ktx(in, description)) {
+    check(false, description + ": read");
+    return data;
+  }
+
+  check(result->get_texture_type() == tex->get_texture_type(),
+        description + ": texture type");
+  check(result->get_x_size() == tex->get_x_size() &&
+        result->get_y_size() == tex->get_y_size() &&
+        result->get_z_size() == tex->get_z_size(),
+        description + ": size");
+  check(result->get_format() == tex->get_format(),
+        description + ": format");
+  check(result->get_component_type() == tex->get_component_type(),
+        description + ": component type");
+  check(result->get_ram_image_compression() == tex->get_ram_image_compression(),
+        description + ": compression");
+  check(result->get_num_ram_mipmap_images() == tex->get_num_ram_mipmap_images(),
+        description + ": number of mipmap levels");
+
+  int num_levels = min(result->get_num_ram_mipmap_images(),
+                       tex->get_num_ram_mipmap_images());
+  for (int n = 0; n < num_levels; ++n) {
+    CPTA_uchar a = tex->get_ram_mipmap_image(n);
+    CPTA_uchar b = result->get_ram_mipmap_image(n);
+    ostringstream strm;
+    strm << description << ": mipmap level " << n;
+    check(a.size() == b.size() && memcmp(a.p(), b.p(), a.size()) == 0,
+          strm.str());
+    check(result->get_ram_mipmap_page_size(n) == tex->get_ram_mipmap_page_size(n),
+          strm.str() + " page size");
+  }
+  return data;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: check_rejected
+//  Description: Replaces the size of the first mipmap level in the
+//               KTX file with the given value, and checks that the
+//               file can no longer be read.
+////////////////////////////////////////////////////////////////////
+static void
+check_rejected(string data, PN_uint32 image_size, const string &description) {
+  // The key/value data size is the last field of the 64-byte header,
+  // and the first image size follows the key/value data.
+  PN_uint32 kv_size;
+  memcpy(&kv_size, data.data() + 60, 4);
+  nassertv(data.size() >= 68 + kv_size);
+  memcpy(&data[64 + kv_size], &image_size, 4);
+
+  istringstream in(data);
+  PT(Texture) result = new Texture;
+  check(!result->read_ktx(in, description), description + ": rejected");
+}
+
+int
+main(int argc, char *argv[]) {
+  // Rows of 5 RGB bytes are padded to 16 bytes in the file.
+  {
+    PT(Texture) tex = new Texture("rgb");
+    tex->setup_2d_texture(5, 3, Texture::T_unsigned_byte, Texture::F_rgb);
+    fill_uncompressed(tex);
+    round_trip(tex, "2-d rgb");
+  }
+  {
+    PT(Texture) tex = new Texture("rgba16");
+    tex->setup_2d_texture(7, 4, Texture::T_unsigned_short, Texture::F_rgba16);
+    fill_uncompressed(tex);
+    round_trip(tex, "2-d rgba16");
+  }
+  {
+    PT(Texture) tex = new Texture("r32");
+    tex->setup_2d_texture(3, 3, Texture::T_float, Texture::F_r32);
+    fill_uncompressed(tex);
+    round_trip(tex, "2-d r32");
+  }
+  {
+    PT(Texture) tex = new Texture("cube");
+    tex->setup_cube_map(4, Texture::T_unsigned_byte, Texture::F_rgba);
+    fill_uncompressed(tex);
+    round_trip(tex, "cube map");
+  }
+  {
+    PT(Texture) tex = new Texture("array");
+    tex->setup_2d_texture_array(4, 4, 3, Texture::T_unsigned_byte,
+                                Texture::F_luminance_alpha);
+    fill_uncompressed(tex);
+    round_trip(tex, "2-d array");
+  }
+  {
+    PT(Texture) tex = new Texture("3d");
+    tex->setup_3d_texture(4, 4, 4, Texture::T_unsigned_byte, Texture::F_rgb);
+    fill_uncompressed(tex);
+    round_trip(tex, "3-d");
+  }
+
+  {
+    // DXT1 stores 8 bytes per 4x4 block, with at least one block.
+    static const size_t page_sizes[] = { 32, 8, 8, 8 };
+    PT(Texture) tex = new Texture("dxt1");
+    tex->setup_2d_texture(8, 8, Texture::T_unsigned_byte, Texture::F_rgb);
+    fill_compressed(tex, Texture::CM_dxt1, page_sizes, 4);
+    string data = round_trip(tex, "dxt1");
+    check_rejected(data, 31, "dxt1 short level");
+    check_rejected(data, 64, "dxt1 long level");
+  }
+  {
+    static const size_t page_sizes[] = { 16, 16, 16 };
+    PT(Texture) tex = new Texture("dxt5 cube");
+    tex->setup_cube_map(4, Texture::T_unsigned_byte, Texture::F_rgba);
+    fill_compressed(tex, Texture::CM_dxt5, page_sizes, 3);
+    string data = round_trip(tex, "dxt5 cube map");
+    check_rejected(data, 96, "dxt5 cube map with level size");
+    check_rejected(data, 0xffffffff, "dxt5 cube map with huge face");
+  }
+  {
+    PT(Texture) tex = new Texture("rgb");
+    tex->setup_2d_texture(5, 3, Texture::T_unsigned_byte, Texture::F_rgb);
+    fill_uncompressed(tex);
+    string data = round_trip(tex, "2-d rgb");
+    check_rejected(data, 45, "rgb without row padding");
+  }
+
+  return check.report();
+}
@@ -0,0 +1,132 @@
+// Filename: test_textureDecoder.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "pandabase.h"
+#include "texture.h"
+#include "config_gobj.h"
+#include "config_pnmimagetypes.h"
+#include "pnmImage.h"
+#include "filename.h"
+#include "testCheck.h"
+
+// This program writes the six faces of a cube map to a sequence of
+// image files, reads them back with texture-decode-threads set to 1
+// (one at a time, on this thread) and to 4 (with a TextureDecoder),
+// and checks that both give the same RAM image, with the expected
+// color on each face.  It does this once for plain image files, and
+// once for files compressed with a .pz extension, which the decoding
+// threads unwrap.
+
+static const int image_size = 32;
+static const int num_faces = 6;
+
+static TestCheck check;
+
+////////////////////////////////////////////////////////////////////
+//     Function: write_faces
+//  Description: Writes one image file per face, each filled with a
+//               color that identifies the face, and returns the
+//               pattern filename that names them.
+////////////////////////////////////////////////////////////////////
+static Filename
+write_faces(const Filename &dir, const string &extension) {
+  for (int z = 0; z < num_faces; ++z) {
+    PNMImage image(image_size, image_size, 3);
+    image.fill_val(z * 40, 255 - z * 40, (z * 97) & 0xff);
+    image.set_xel_val(0, 0, z, z, z);
+
+    ostringstream name;
+    name << "face_" << z << extension;
+    check(image.write(Filename(dir, name.str())), "write " + name.str());
+  }
+  return Filename(dir, "face_#" + extension);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: read_cube_map
+//  Description: Reads the faces named by the pattern into a new cube
+//               map, with the indicated number of decoding threads,
+//               and returns its RAM image.
+////////////////////////////////////////////////////////////////////
+static CPTA_uchar
+read_cube_map(const Filename &pattern, int num_threads) {
+  texture_decode_threads = num_threads;
+
+  PT(Texture) tex = new Texture("cube");
+  tex->setup_cube_map();
+  if (!tex->read(pattern, 0, 0, true, false)) {
+    return CPTA_uchar(Texture::get_class_type());
+  }
+  check(tex->get_z_size() == num_faces, "cube map has six faces");
+  tex->set_keep_ram_image(true);
+  return tex->get_ram_image();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: check_sequence
+//  Description: Reads the faces with and without the decoder, and
+//               checks the results.
+////////////////////////////////////////////////////////////////////
+static void
+check_sequence(const Filename &pattern, const string &description) {
+  CPTA_uchar serial = read_cube_map(pattern, 1);
+  CPTA_uchar threaded = read_cube_map(pattern, 4);
+
+  size_t face_bytes = image_size * image_size * 3;
+  check(serial.size() == face_bytes * num_faces,
+        description + ": serial read size");
+  check(threaded.size() == serial.size(),
+        description + ": threaded read size");
+  if (serial.size() != face_bytes * num_faces ||
+      threaded.size() != serial.size()) {
+    return;
+  }
+
+  check(memcmp(serial.p(), threaded.p(), serial.size()) == 0,
+        description + ": threaded read matches serial read");
+
+  // Each face is identified by the pixel in its lower-left corner,
+  // which is the last row of the image.  Textures are stored in BGR
+  // order.
+  for (int z = 0; z < num_faces; ++z) {
+    const unsigned char *corner =
+      threaded.p() + face_bytes * z + (image_size - 1) * image_size * 3;
+    ostringstream strm;
+    strm << description << ": face " << z << " in place";
+    check(corner[0] == z && corner[1] == z && corner[2] == z, strm.str());
+  }
+}
+
+int
+main(int argc, char *argv[]) {
+  init_libpnmimagetypes();
+
+  Filename dir = Filename::temporary("", "texdecode_");
+  dir.mkdir();
+
+  check_sequence(write_faces(dir, ".ppm"), "ppm");
+#ifdef HAVE_ZLIB
+  check_sequence(write_faces(dir, ".ppm.pz"), "ppm.pz");
+#endif
+
+  for (int z = 0; z < num_faces; ++z) {
+    ostringstream name;
+    name << "face_" << z;
+    Filename(dir, name.str() + ".ppm").unlink();
+    Filename(dir, name.str() + ".ppm.pz").unlink();
+  }
+  dir.rmdir();
+
+  return check.report();
+}
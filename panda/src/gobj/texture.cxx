@@ -40,7 +40,9 @@
 #include "pStatTimer.h"
 #include "pbitops.h"
 #include "streamReader.h"
+#include "streamWriter.h"
 #include "texturePeeker.h"
+#include "textureDecoder.h"
 #include "convert_srgb.h"
 
 #ifdef HAVE_SQUISH
@@ -132,6 +134,116 @@ struct DDSHeader {
   DDSCaps2 caps;
 };
 
+// Stuff to read and write KTX files.  A KTX file is laid out so that
+// each mipmap level is stored contiguously, 4-byte aligned, in exactly
+// the form OpenGL expects it; we choose the GL formats so that this is
+// also exactly the form of Panda's own ram image, and a level can be
+// read straight into its final buffer.
+
+static const unsigned char ktx_identifier[12] = {
+  0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+};
+
+#define KTX_ENDIANNESS              0x04030201
+
+//  The GL enums that appear in a KTX header.
+#define KTX_GL_UNSIGNED_BYTE        0x1401
+#define KTX_GL_UNSIGNED_SHORT       0x1403
+#define KTX_GL_FLOAT                0x1406
+
+#define KTX_GL_DEPTH_COMPONENT      0x1902
+#define KTX_GL_RED                  0x1903
+#define KTX_GL_GREEN                0x1904
+#define KTX_GL_BLUE                 0x1905
+#define KTX_GL_ALPHA                0x1906
+#define KTX_GL_RGB                  0x1907
+#define KTX_GL_RGBA                 0x1908
+#define KTX_GL_LUMINANCE            0x1909
+#define KTX_GL_LUMINANCE_ALPHA      0x190A
+#define KTX_GL_BGR                  0x80E0
+#define KTX_GL_BGRA                 0x80E1
+#define KTX_GL_RG                   0x8227
+
+#define KTX_GL_RGB8                 0x8051
+#define KTX_GL_RGB16                0x8054
+#define KTX_GL_RGBA8                0x8058
+#define KTX_GL_RGBA16               0x805B
+#define KTX_GL_R8                   0x8229
+#define KTX_GL_R16                  0x822A
+#define KTX_GL_RG8                  0x822B
+#define KTX_GL_RG16                 0x822C
+#define KTX_GL_R32F                 0x822E
+#define KTX_GL_RG32F                0x8230
+#define KTX_GL_RGBA32F              0x8814
+#define KTX_GL_RGB32F               0x8815
+
+//  The metadata key under which we record the Panda texture format,
+//  which is more specific than the GL formats.
+#define KTX_PANDA_FORMAT_KEY        "panda.format"
+
+struct KTXCompressedFormat {
+  unsigned int gl_internal_format;
+  unsigned int gl_base_internal_format;
+  Texture::CompressionMode compression;
+  Texture::Format format;
+};
+
+static const KTXCompressedFormat ktx_compressed_formats[] = {
+  { 0x83F0, KTX_GL_RGB,  Texture::CM_dxt1, Texture::F_rgb },         // S3TC_DXT1
+  { 0x83F1, KTX_GL_RGBA, Texture::CM_dxt1, Texture::F_rgbm },        // S3TC_DXT1, alpha
+  { 0x83F2, KTX_GL_RGBA, Texture::CM_dxt3, Texture::F_rgba },        // S3TC_DXT3
+  { 0x83F3, KTX_GL_RGBA, Texture::CM_dxt5, Texture::F_rgba },        // S3TC_DXT5
+  { 0x8C4C, KTX_GL_RGB,  Texture::CM_dxt1, Texture::F_srgb },        // SRGB_S3TC_DXT1
+  { 0x8C4D, KTX_GL_RGBA, Texture::CM_dxt1, Texture::F_srgb_alpha },  // SRGB_ALPHA_S3TC_DXT1
+  { 0x8C4E, KTX_GL_RGBA, Texture::CM_dxt3, Texture::F_srgb_alpha },  // SRGB_ALPHA_S3TC_DXT3
+  { 0x8C4F, KTX_GL_RGBA, Texture::CM_dxt5, Texture::F_srgb_alpha },  // SRGB_ALPHA_S3TC_DXT5
+  { 0x86B0, KTX_GL_RGB,  Texture::CM_fxt1, Texture::F_rgb },         // RGB_FXT1_3DFX
+  { 0x86B1, KTX_GL_RGBA, Texture::CM_fxt1, Texture::F_rgba },        // RGBA_FXT1_3DFX
+  { 0x8C00, KTX_GL_RGB,  Texture::CM_pvr1_4bpp, Texture::F_rgb },    // RGB_PVRTC_4BPPV1
+  { 0x8C01, KTX_GL_RGB,  Texture::CM_pvr1_2bpp, Texture::F_rgb },    // RGB_PVRTC_2BPPV1
+  { 0x8C02, KTX_GL_RGBA, Texture::CM_pvr1_4bpp, Texture::F_rgba },   // RGBA_PVRTC_4BPPV1
+  { 0x8C03, KTX_GL_RGBA, Texture::CM_pvr1_2bpp, Texture::F_rgba },   // RGBA_PVRTC_2BPPV1
+};
+static const int num_ktx_compressed_formats =
+  sizeof(ktx_compressed_formats) / sizeof(KTXCompressedFormat);
+
+////////////////////////////////////////////////////////////////////
+//     Function: get_ktx_compressed_page_size
+//  Description: Returns the number of bytes a single page of the
+//               indicated size takes in one of the compressed
+//               formats we read from KTX files.  Returns 0 if the
+//               size is not known.
+////////////////////////////////////////////////////////////////////
+static PN_uint64
+get_ktx_compressed_page_size(Texture::CompressionMode compression,
+                             PN_uint64 x_size, PN_uint64 y_size) {
+  switch (compression) {
+  case Texture::CM_dxt1:
+    // 4x4 blocks of 8 bytes.
+    return ((x_size + 3) / 4) * ((y_size + 3) / 4) * 8;
+
+  case Texture::CM_dxt3:
+  case Texture::CM_dxt5:
+    // 4x4 blocks of 16 bytes.
+    return ((x_size + 3) / 4) * ((y_size + 3) / 4) * 16;
+
+  case Texture::CM_fxt1:
+    // 8x4 blocks of 16 bytes.
+    return ((x_size + 7) / 8) * ((y_size + 3) / 4) * 16;
+
+  case Texture::CM_pvr1_4bpp:
+    // At least 8x8 pixels, at 4 bits per pixel.
+    return max(x_size, (PN_uint64)8) * max(y_size, (PN_uint64)8) / 2;
+
+  case Texture::CM_pvr1_2bpp:
+    // At least 16x8 pixels, at 2 bits per pixel.
+    return max(x_size, (PN_uint64)16) * max(y_size, (PN_uint64)8) / 4;
+
+  default:
+    return 0;
+  }
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: Texture::Constructor
 //       Access: Published
@@ -759,6 +871,44 @@ read_dds(istream &in, const string &filename, bool header_only) {
   return do_read_dds(cdata, in, filename, header_only);
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: Texture::read_ktx
+//       Access: Published
+//  Description: Reads the texture from a KTX file object.  This is a
+//               Khronos-defined file format, similar in principle to
+//               a DDS file, which stores each mipmap level in the form
+//               in which it is handed to the graphics API.  Panda
+//               writes these files so that each level may be read
+//               directly into the texture's ram image, with no
+//               conversion at all.
+//
+//               As with read_txo, the filename is just for reference.
+////////////////////////////////////////////////////////////////////
+bool Texture::
+read_ktx(istream &in, const string &filename, bool header_only) {
+  CDWriter cdata(_cycler, true);
+  cdata->inc_properties_modified();
+  cdata->inc_image_modified();
+  return do_read_ktx(cdata, in, filename, header_only);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: Texture::write_ktx
+//       Access: Published
+//  Description: Writes the texture's ram image, including all of its
+//               mipmap levels, to a KTX file object.  The image is
+//               written in whatever compression mode it is currently
+//               in; call compress_ram_image() first to write a
+//               pre-compressed texture.
+//
+//               The filename is just for reference.
+////////////////////////////////////////////////////////////////////
+bool Texture::
+write_ktx(ostream &out, const string &filename) const {
+  CDReader cdata(_cycler);
+  return do_write_ktx(cdata, out, filename);
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: Texture::load_related
 //       Access: Published
@@ -2668,6 +2818,13 @@ do_read(CData *cdata, const Filename &fullpath, const Filename &alpha_fullpath,
     return do_read_dds_file(cdata, fullpath, header_only);
   }
 
+  if (is_ktx_filename(fullpath)) {
+    if (record != (BamCacheRecord *)NULL) {
+      record->add_dependent_file(fullpath);
+    }
+    return do_read_ktx_file(cdata, fullpath, header_only);
+  }
+
   // If read_pages or read_mipmaps is specified, then z and n actually
   // indicate z_size and n_size, respectively--the numerical limits on
   // which to search for filenames.
@@ -2706,6 +2863,12 @@ do_read(CData *cdata, const Filename &fullpath, const Filename &alpha_fullpath,
 
   VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
 
+  // A sequence of pages or mipmap levels may be decoded on several
+  // threads at once.
+  bool decode_pages = (!header_only && !textures_header_only &&
+                       TextureDecoder::get_num_threads() != 0 &&
+                       do_can_decode_pages(cdata));
+
   if (read_pages && read_mipmaps) {
     // Read a sequence of pages * mipmap levels.
     Filename fullpath_pattern = Filename::pattern_filename(fullpath);
@@ -2744,11 +2907,15 @@ do_read(CData *cdata, const Filename &fullpath, const Filename &alpha_fullpath,
         break;
       }
 
+      // All of the pages of one mipmap level must be loaded before
+      // we can know the number of pages of the next.
+      TextureDecoder decoder(options);
       int num_pages = z_size * num_views;
       while ((num_pages == 0 && (vfs->exists(file) || z == 0)) ||
              (num_pages != 0 && z < num_pages)) {
-        if (!do_read_one(cdata, file, alpha_file, z, n, primary_file_num_channels,
-                         alpha_file_channel, options, header_only, record)) {
+        if (!do_read_page(cdata, decode_pages ? &decoder : NULL,
+                          file, alpha_file, z, n, primary_file_num_channels,
+                          alpha_file_channel, options, header_only, record)) {
           return false;
         }
         ++z;
@@ -2757,6 +2924,10 @@ do_read(CData *cdata, const Filename &fullpath, const Filename &alpha_fullpath,
         file = n_pattern.get_filename_index(n);
         alpha_file = alpha_n_pattern.get_filename_index(n);
       }
+      if (!do_read_decoded_pages(cdata, decoder, primary_file_num_channels,
+                                 alpha_file_channel, options, record)) {
+        return false;
+      }
 
       if (n == 0 && n_size == 0) {
         // If n_size is not specified, it gets implicitly set after we
@@ -2785,11 +2956,13 @@ do_read(CData *cdata, const Filename &fullpath, const Filename &alpha_fullpath,
     Filename file = fullpath_pattern.get_filename_index(z);
     Filename alpha_file = alpha_fullpath_pattern.get_filename_index(z);
 
+    TextureDecoder decoder(options);
     int num_pages = z_size * num_views;
     while ((num_pages == 0 && (vfs->exists(file) || z == 0)) ||
            (num_pages != 0 && z < num_pages)) {
-      if (!do_read_one(cdata, file, alpha_file, z, 0, primary_file_num_channels,
-                       alpha_file_channel, options, header_only, record)) {
+      if (!do_read_page(cdata, decode_pages ? &decoder : NULL,
+                        file, alpha_file, z, 0, primary_file_num_channels,
+                        alpha_file_channel, options, header_only, record)) {
         return false;
       }
       ++z;
@@ -2797,6 +2970,10 @@ do_read(CData *cdata, const Filename &fullpath, const Filename &alpha_fullpath,
       file = fullpath_pattern.get_filename_index(z);
       alpha_file = alpha_fullpath_pattern.get_filename_index(z);
     }
+    if (!do_read_decoded_pages(cdata, decoder, primary_file_num_channels,
+                               alpha_file_channel, options, record)) {
+      return false;
+    }
     cdata->_fullpath = fullpath_pattern;
     cdata->_alpha_fullpath = alpha_fullpath_pattern;
 
@@ -2815,11 +2992,13 @@ do_read(CData *cdata, const Filename &fullpath, const Filename &alpha_fullpath,
     Filename file = fullpath_pattern.get_filename_index(n);
     Filename alpha_file = alpha_fullpath_pattern.get_filename_index(n);
 
+    TextureDecoder decoder(options);
     while ((n_size == 0 && (vfs->exists(file) || n == 0)) ||
            (n_size != 0 && n < n_size)) {
-      if (!do_read_one(cdata, file, alpha_file, z, n,
-                       primary_file_num_channels, alpha_file_channel,
-                       options, header_only, record)) {
+      if (!do_read_page(cdata, decode_pages ? &decoder : NULL,
+                        file, alpha_file, z, n,
+                        primary_file_num_channels, alpha_file_channel,
+                        options, header_only, record)) {
         return false;
       }
       ++n;
@@ -2833,6 +3012,10 @@ do_read(CData *cdata, const Filename &fullpath, const Filename &alpha_fullpath,
       file = fullpath_pattern.get_filename_index(n);
       alpha_file = alpha_fullpath_pattern.get_filename_index(n);
     }
+    if (!do_read_decoded_pages(cdata, decoder, primary_file_num_channels,
+                               alpha_file_channel, options, record)) {
+      return false;
+    }
     cdata->_fullpath = fullpath_pattern;
     cdata->_alpha_fullpath = alpha_fullpath_pattern;
 
@@ -2894,27 +3077,8 @@ do_read_one(CData *cdata, const Filename &fullpath, const Filename &alpha_fullpa
 
   AutoTextureScale auto_texture_scale = do_get_auto_texture_scale(cdata);
 
-  // If it's a floating-point image file, read it by default into a
-  // floating-point texture.
-  bool read_floating_point;
-  int texture_load_type = (options.get_texture_flags() & (LoaderOptions::TF_integer | LoaderOptions::TF_float));
-  switch (texture_load_type) {
-  case LoaderOptions::TF_integer:
-    read_floating_point = false;
-    break;
-
-  case LoaderOptions::TF_float:
-    read_floating_point = true;
-    break;
-
-  default:
-    // Neither TF_integer nor TF_float was specified; determine which
-    // way the texture wants to be loaded.
-    read_floating_point = (image_reader->is_floating_point());
-    if (!alpha_fullpath.empty()) {
-      read_floating_point = false;
-    }
-  }
+  bool read_floating_point =
+    TextureDecoder::choose_floating_point(options, image_reader, alpha_fullpath);
 
   if (header_only || textures_header_only) {
     int x_size = image.get_x_size();
@@ -3033,6 +3197,129 @@ do_read_one(CData *cdata, const Filename &fullpath, const Filename &alpha_fullpa
     }
   }
 
+  return do_finish_read_one(cdata, fullpath, alpha_fullpath, z, n,
+                            primary_file_num_channels, alpha_file_channel,
+                            options, read_floating_point,
+                            image, pfm, alpha_image);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: Texture::do_can_decode_pages
+//       Access: Protected, Virtual
+//  Description: Returns true if the pages and mipmap levels of this
+//               texture may be read from a sequence of files by a
+//               TextureDecoder, which reads and decodes them on other
+//               threads, or false if each must be read by
+//               do_read_one().  A Texture that overrides
+//               do_read_one() should also override this to return
+//               false.
+////////////////////////////////////////////////////////////////////
+bool Texture::
+do_can_decode_pages(const CData *cdata) const {
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: Texture::do_read_page
+//       Access: Protected
+//  Description: Called only from do_read(), this method reads a
+//               single page or mipmap level of a sequence.  If a
+//               TextureDecoder is given, the file is added to it to
+//               be decoded later by do_read_decoded_pages(), unless
+//               it is the base image, which determines the size of
+//               the rest and so is read immediately.
+////////////////////////////////////////////////////////////////////
+bool Texture::
+do_read_page(CData *cdata, TextureDecoder *decoder,
+             const Filename &fullpath, const Filename &alpha_fullpath,
+             int z, int n, int primary_file_num_channels, int alpha_file_channel,
+             const LoaderOptions &options, bool header_only, BamCacheRecord *record) {
+  if (decoder == (TextureDecoder *)NULL || (z == 0 && n == 0)) {
+    return do_read_one(cdata, fullpath, alpha_fullpath, z, n,
+                       primary_file_num_channels, alpha_file_channel,
+                       options, header_only, record);
+  }
+
+  decoder->add_page(fullpath, alpha_fullpath, z, n,
+                    do_get_expected_mipmap_x_size(cdata, n),
+                    do_get_expected_mipmap_y_size(cdata, n));
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: Texture::do_read_decoded_pages
+//       Access: Protected
+//  Description: Decodes all of the pages that do_read_page() has
+//               added to the indicated TextureDecoder, and loads each
+//               one into the texture, in order, as soon as it is
+//               ready.
+////////////////////////////////////////////////////////////////////
+bool Texture::
+do_read_decoded_pages(CData *cdata, TextureDecoder &decoder,
+                      int primary_file_num_channels, int alpha_file_channel,
+                      const LoaderOptions &options, BamCacheRecord *record) {
+  int num_pages = decoder.get_num_pages();
+  if (num_pages == 0) {
+    return true;
+  }
+
+  decoder.start();
+  for (int i = 0; i < num_pages; ++i) {
+    TextureDecoder::Page &page = decoder.wait_page(i);
+
+    if (record != (BamCacheRecord *)NULL) {
+      record->add_dependent_file(page._fullpath);
+    }
+    if (!page._success) {
+      gobj_cat.error()
+        << "Texture::read() - couldn't read: " << page._fullpath << endl;
+      return false;
+    }
+
+    if (!page._alpha_fullpath.empty()) {
+      if (record != (BamCacheRecord *)NULL) {
+        record->add_dependent_file(page._alpha_fullpath);
+      }
+      if (!page._alpha_success) {
+        gobj_cat.error()
+          << "Texture::read() - couldn't read (alpha): " << page._alpha_fullpath << endl;
+        return false;
+      }
+    }
+
+    bool success =
+      do_finish_read_one(cdata, page._fullpath, page._alpha_fullpath,
+                         page._z, page._n, primary_file_num_channels,
+                         alpha_file_channel, options, page._read_floating_point,
+                         page._image, page._pfm, page._alpha_image);
+
+    // The decoded images aren't needed once they have been copied
+    // into the texture.
+    page._image.clear();
+    page._pfm.clear();
+    page._alpha_image.clear();
+
+    if (!success) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: Texture::do_finish_read_one
+//       Access: Protected
+//  Description: The second half of do_read_one(): given the image
+//               (or pfm) and the alpha image, which have been read
+//               from the indicated files, combines them and loads the
+//               result into the indicated page and mipmap level.
+////////////////////////////////////////////////////////////////////
+bool Texture::
+do_finish_read_one(CData *cdata, const Filename &fullpath, const Filename &alpha_fullpath,
+                   int z, int n, int primary_file_num_channels, int alpha_file_channel,
+                   const LoaderOptions &options, bool read_floating_point,
+                   PNMImage &image, PfmFile &pfm, PNMImage &alpha_image) {
   if (z == 0 && n == 0) {
     if (!has_name()) {
       set_name(fullpath.get_basename_wo_extension());
@@ -3716,6 +4003,357 @@ do_read_dds(CData *cdata, istream &in, const string &filename, bool header_only)
   return true;
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: Texture::do_read_ktx_file
+//       Access: Private
+//  Description: Called internally when read() detects a KTX file.
+//               Assumes the lock is already held.
+////////////////////////////////////////////////////////////////////
+bool Texture::
+do_read_ktx_file(CData *cdata, const Filename &fullpath, bool header_only) {
+  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+
+  Filename filename = Filename::binary_filename(fullpath);
+  PT(VirtualFile) file = vfs->get_file(filename);
+  if (file == (VirtualFile *)NULL) {
+    // No such file.
+    gobj_cat.error()
+      << "Could not find " << fullpath << "\n";
+    return false;
+  }
+
+  if (gobj_cat.is_debug()) {
+    gobj_cat.debug()
+      << "Reading KTX file " << filename << "\n";
+  }
+
+  istream *in = file->open_read_file(true);
+  bool success = do_read_ktx(cdata, *in, fullpath, header_only);
+  vfs->close_read_file(in);
+
+  if (!has_name()) {
+    set_name(fullpath.get_basename_wo_extension());
+  }
+
+  cdata->_fullpath = fullpath;
+  cdata->_alpha_fullpath = Filename();
+
+  // There is no need to keep the ram image around once it has been
+  // uploaded; it is cheap to read it again from the file.
+  cdata->_keep_ram_image = false;
+
+  return success;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: Texture::do_read_ktx
+//       Access: Protected
+//  Description:
+////////////////////////////////////////////////////////////////////
+bool Texture::
+do_read_ktx(CData *cdata, istream &in, const string &filename, bool header_only) {
+  unsigned char identifier[12];
+  in.read((char *)identifier, 12);
+  if (in.fail() || in.eof() || memcmp(identifier, ktx_identifier, 12) != 0) {
+    gobj_cat.error()
+      << filename << " is not a KTX file.\n";
+    return false;
+  }
+
+  StreamReader ktx(in);
+  if (ktx.get_uint32() != KTX_ENDIANNESS) {
+    gobj_cat.error()
+      << filename << ": big-endian KTX files are not supported.\n";
+    return false;
+  }
+
+  unsigned int gl_type = ktx.get_uint32();
+  ktx.get_uint32();  // glTypeSize
+  unsigned int gl_format = ktx.get_uint32();
+  unsigned int gl_internal_format = ktx.get_uint32();
+  ktx.get_uint32();  // glBaseInternalFormat
+  unsigned int width = ktx.get_uint32();
+  unsigned int height = ktx.get_uint32();
+  unsigned int depth = ktx.get_uint32();
+  unsigned int num_array_elements = ktx.get_uint32();
+  unsigned int num_faces = ktx.get_uint32();
+  unsigned int num_levels = ktx.get_uint32();
+  unsigned int key_value_size = ktx.get_uint32();
+
+  // Look through the metadata for the Panda format, if it's there.
+  string panda_format;
+  while (key_value_size >= 4 && !in.fail() && !in.eof()) {
+    unsigned int pair_size = ktx.get_uint32();
+    unsigned int padded_size = (pair_size + 3) & ~3;
+    key_value_size -= 4;
+    if (padded_size > key_value_size) {
+      break;
+    }
+    key_value_size -= padded_size;
+
+    string pair = ktx.extract_bytes(pair_size);
+    ktx.skip_bytes(padded_size - pair_size);
+
+    size_t null = pair.find('\0');
+    if (null != string::npos && pair.substr(0, null) == KTX_PANDA_FORMAT_KEY) {
+      panda_format = pair.substr(null + 1);
+      null = panda_format.find('\0');
+      if (null != string::npos) {
+        panda_format = panda_format.substr(0, null);
+      }
+    }
+  }
+  ktx.skip_bytes(key_value_size);
+
+  if (in.fail() || in.eof()) {
+    gobj_cat.error()
+      << filename << ": truncated KTX file.\n";
+    return false;
+  }
+
+  TextureType texture_type;
+  int z_size = 1;
+  if (num_faces == 6 && num_array_elements == 0 && depth == 0) {
+    texture_type = TT_cube_map;
+    z_size = 6;
+
+  } else if (num_faces != 1 || (num_array_elements != 0 && depth != 0) ||
+             (height == 0 && (num_array_elements != 0 || depth != 0))) {
+    gobj_cat.error()
+      << filename << ": unsupported KTX texture type.\n";
+    return false;
+
+  } else if (num_array_elements != 0) {
+    texture_type = TT_2d_texture_array;
+    z_size = num_array_elements;
+
+  } else if (depth != 0) {
+    texture_type = TT_3d_texture;
+    z_size = depth;
+
+  } else if (height == 0) {
+    texture_type = TT_1d_texture;
+
+  } else {
+    texture_type = TT_2d_texture;
+  }
+
+  ComponentType component_type = T_unsigned_byte;
+  Format format = F_rgb;
+  CompressionMode compression = CM_off;
+
+  // Panda stores RGB data in BGR order.  Files written by other tools
+  // will often have the red and blue components the other way around;
+  // we have to swap them back as we read.
+  bool swap_red_blue = false;
+
+  if (gl_type == 0) {
+    // A compressed format.
+    int i = 0;
+    while (i < num_ktx_compressed_formats &&
+           ktx_compressed_formats[i].gl_internal_format != gl_internal_format) {
+      ++i;
+    }
+    if (i >= num_ktx_compressed_formats) {
+      gobj_cat.error()
+        << filename << ": unsupported texture compression 0x" << hex
+        << gl_internal_format << dec << ".\n";
+      return false;
+    }
+    compression = ktx_compressed_formats[i].compression;
+    format = ktx_compressed_formats[i].format;
+
+  } else {
+    switch (gl_type) {
+    case KTX_GL_UNSIGNED_BYTE:
+      component_type = T_unsigned_byte;
+      break;
+    case KTX_GL_UNSIGNED_SHORT:
+      component_type = T_unsigned_short;
+      break;
+    case KTX_GL_FLOAT:
+      component_type = T_float;
+      break;
+    default:
+      gobj_cat.error()
+        << filename << ": unsupported component type 0x" << hex
+        << gl_type << dec << ".\n";
+      return false;
+    }
+
+    switch (gl_format) {
+    case KTX_GL_DEPTH_COMPONENT:
+      format = (component_type == T_float) ? F_depth_component32 : F_depth_component;
+      break;
+    case KTX_GL_RED:
+      format = (component_type == T_float) ? F_r32 :
+        (component_type == T_unsigned_short) ? F_r16 : F_red;
+      break;
+    case KTX_GL_GREEN:
+      format = F_green;
+      break;
+    case KTX_GL_BLUE:
+      format = F_blue;
+      break;
+    case KTX_GL_ALPHA:
+      format = F_alpha;
+      break;
+    case KTX_GL_LUMINANCE:
+      format = F_luminance;
+      break;
+    case KTX_GL_LUMINANCE_ALPHA:
+      format = F_luminance_alpha;
+      break;
+    case KTX_GL_RG:
+      format = (component_type == T_float) ? F_rg32 :
+        (component_type == T_unsigned_short) ? F_rg16 : F_luminance_alpha;
+      break;
+    case KTX_GL_RGB:
+      swap_red_blue = true;
+      // fall through
+    case KTX_GL_BGR:
+      format = (component_type == T_float) ? F_rgb32 :
+        (component_type == T_unsigned_short) ? F_rgb16 : F_rgb;
+      break;
+    case KTX_GL_RGBA:
+      swap_red_blue = true;
+      // fall through
+    case KTX_GL_BGRA:
+      format = (component_type == T_float) ? F_rgba32 :
+        (component_type == T_unsigned_short) ? F_rgba16 : F_rgba;
+      break;
+    default:
+      gobj_cat.error()
+        << filename << ": unsupported pixel format 0x" << hex
+        << gl_format << dec << ".\n";
+      return false;
+    }
+  }
+
+  do_setup_texture(cdata, texture_type, width, max(height, 1U), z_size,
+                   component_type, format);
+
+  if (!panda_format.empty()) {
+    // The file was written by Panda, and records the precise format.
+    // For an uncompressed image, it must still agree with the pixel
+    // layout, though.
+    int num_components = cdata->_num_components;
+    do_set_format(cdata, string_format(panda_format));
+    if (compression == CM_off && cdata->_num_components != num_components) {
+      do_set_format(cdata, format);
+    }
+  }
+
+  cdata->_orig_file_x_size = cdata->_x_size;
+  cdata->_orig_file_y_size = cdata->_y_size;
+  cdata->_compression = compression;
+  cdata->_ram_image_compression = compression;
+
+  if (!header_only) {
+    // Each mipmap level is stored as a 32-bit size followed by all of
+    // the pages of that level, in the same order Panda keeps them.
+    // Most of the time, we can read the level in one go, directly into
+    // the buffer that becomes the ram image.
+    int num_components = cdata->_num_components;
+    int component_width = cdata->_component_width;
+    int n;
+    for (n = 0; n < (int)max(num_levels, 1U); ++n) {
+      unsigned int image_size = ktx.get_uint32();
+      int z_size_n = do_get_expected_mipmap_z_size(cdata, n);
+
+      // For a cube map, the size is that of just one face.  The sizes
+      // are checked in 64 bits, so that a bad header can't make us
+      // allocate a buffer smaller than the data we then read into it.
+      PN_uint64 level_size = image_size;
+      if (texture_type == TT_cube_map) {
+        level_size *= 6;
+      }
+
+      PN_uint64 x_size_n = do_get_expected_mipmap_x_size(cdata, n);
+      PN_uint64 y_size_n = do_get_expected_mipmap_y_size(cdata, n);
+
+      PTA_uchar image;
+      size_t page_size;
+      if (compression != CM_off) {
+        PN_uint64 expected_page_size =
+          get_ktx_compressed_page_size(compression, x_size_n, y_size_n);
+        if (expected_page_size == 0 ||
+            level_size != expected_page_size * z_size_n ||
+            level_size > (PN_uint64)(size_t)-1) {
+          gobj_cat.error()
+            << filename << ": mipmap level " << n << " has the wrong size.\n";
+          return false;
+        }
+        page_size = (size_t)expected_page_size;
+        image = PTA_uchar::empty_array((size_t)level_size);
+        ktx.extract_bytes(image.p(), (size_t)level_size);
+
+      } else {
+        // Uncompressed rows are padded to a multiple of 4 bytes.
+        PN_uint64 row_size = x_size_n * num_components * component_width;
+        PN_uint64 padded_row_size = (row_size + 3) & ~(PN_uint64)3;
+        PN_uint64 num_rows = y_size_n * z_size_n;
+        if (level_size != padded_row_size * num_rows ||
+            level_size > (PN_uint64)(size_t)-1) {
+          gobj_cat.error()
+            << filename << ": mipmap level " << n << " has the wrong size.\n";
+          return false;
+        }
+
+        page_size = (size_t)(row_size * y_size_n);
+        image = PTA_uchar::empty_array((size_t)(row_size * num_rows));
+        if (padded_row_size == row_size) {
+          ktx.extract_bytes(image.p(), (size_t)level_size);
+        } else {
+          unsigned char *p = image.p();
+          for (PN_uint64 r = 0; r < num_rows; ++r) {
+            ktx.extract_bytes(p, (size_t)row_size);
+            ktx.skip_bytes((size_t)(padded_row_size - row_size));
+            p += row_size;
+          }
+        }
+
+        if (swap_red_blue) {
+          unsigned char *p = image.p();
+          unsigned char *end = p + image.size();
+          size_t pixel_size = num_components * component_width;
+          for (; p < end; p += pixel_size) {
+            swap_ranges(p, p + component_width, p + 2 * component_width);
+          }
+        }
+      }
+
+      // Each level is padded to a multiple of 4 bytes.
+      ktx.skip_bytes((4 - (image_size & 3)) & 3);
+
+      if (in.fail() || in.eof()) {
+        break;
+      }
+      do_set_ram_mipmap_image(cdata, n, image, page_size);
+    }
+
+    if (n == 0) {
+      gobj_cat.error()
+        << filename << ": truncated KTX file.\n";
+      return false;
+    }
+    if (n < (int)num_levels) {
+      gobj_cat.warning()
+        << filename << ": truncated KTX file; only " << n << " of "
+        << num_levels << " mipmap levels are available.\n";
+    }
+
+    cdata->_has_read_pages = true;
+    cdata->_has_read_mipmaps = true;
+    cdata->_num_mipmap_levels_read = cdata->_ram_images.size();
+  }
+
+  cdata->_loaded_from_image = true;
+  cdata->_loaded_from_txo = true;
+
+  return true;
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: Texture::do_write
 //       Access: Protected
@@ -3733,6 +4371,14 @@ do_write(CData *cdata,
     return do_write_txo_file(cdata, fullpath);
   }
 
+  if (is_ktx_filename(fullpath)) {
+    if (!do_has_ram_image(cdata)) {
+      do_get_ram_image(cdata);
+    }
+    nassertr(do_has_ram_image(cdata), false);
+    return do_write_ktx_file(cdata, fullpath);
+  }
+
   if (!do_has_uncompressed_ram_image(cdata)) {
     do_get_uncompressed_ram_image(cdata);
   }
@@ -3993,6 +4639,290 @@ do_write_txo(const CData *cdata, ostream &out, const string &filename) const {
   return true;
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: Texture::do_write_ktx_file
+//       Access: Private
+//  Description: Called internally when write() detects a KTX
+//               filename.
+////////////////////////////////////////////////////////////////////
+bool Texture::
+do_write_ktx_file(const CData *cdata, const Filename &fullpath) const {
+  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+  Filename filename = Filename::binary_filename(fullpath);
+  ostream *out = vfs->open_write_file(filename, true, true);
+  if (out == NULL) {
+    gobj_cat.error()
+      << "Unable to open " << filename << "\n";
+    return false;
+  }
+
+  bool success = do_write_ktx(cdata, *out, fullpath);
+  vfs->close_write_file(out);
+  return success;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: Texture::do_write_ktx
+//       Access: Protected
+//  Description:
+////////////////////////////////////////////////////////////////////
+bool Texture::
+do_write_ktx(const CData *cdata, ostream &out, const string &filename) const {
+  if (!do_has_ram_image(cdata)) {
+    gobj_cat.error()
+      << get_name() << " does not have ram image\n";
+    return false;
+  }
+
+  if (cdata->_num_views != 1) {
+    gobj_cat.error()
+      << filename << ": cannot write a multiview texture to a KTX file.\n";
+    return false;
+  }
+
+  unsigned int gl_type = 0;
+  unsigned int gl_type_size = 1;
+  unsigned int gl_format = 0;
+  unsigned int gl_internal_format = 0;
+  unsigned int gl_base_internal_format = 0;
+
+  if (cdata->_ram_image_compression != CM_off) {
+    // Choose the compressed format that matches the Panda format most
+    // closely.  An exact match is best; failing that, one with alpha
+    // if the texture has alpha.
+    bool want_alpha = (cdata->_num_components == 2 || cdata->_num_components == 4);
+    int best_score = 0;
+    for (int i = 0; i < num_ktx_compressed_formats; ++i) {
+      const KTXCompressedFormat &cf = ktx_compressed_formats[i];
+      if (cf.compression != cdata->_ram_image_compression) {
+        continue;
+      }
+      int score = 1;
+      if (cf.format == cdata->_format) {
+        score = 3;
+      } else if ((cf.gl_base_internal_format == KTX_GL_RGBA) == want_alpha) {
+        score = 2;
+      }
+      if (score > best_score) {
+        best_score = score;
+        gl_internal_format = cf.gl_internal_format;
+        gl_base_internal_format = cf.gl_base_internal_format;
+      }
+    }
+    if (best_score == 0) {
+      gobj_cat.error()
+        << filename << ": cannot write a texture with compression "
+        << cdata->_ram_image_compression << " to a KTX file.\n";
+      return false;
+    }
+
+  } else {
+    switch (cdata->_component_type) {
+    case T_unsigned_byte:
+      gl_type = KTX_GL_UNSIGNED_BYTE;
+      break;
+    case T_unsigned_short:
+      gl_type = KTX_GL_UNSIGNED_SHORT;
+      break;
+    case T_float:
+      gl_type = KTX_GL_FLOAT;
+      break;
+    default:
+      gobj_cat.error()
+        << filename << ": cannot write a texture with component type "
+        << cdata->_component_type << " to a KTX file.\n";
+      return false;
+    }
+    gl_type_size = cdata->_component_width;
+
+    // The GL formats are chosen to match Panda's own component order,
+    // so that the image can be written (and read) without conversion.
+    switch (cdata->_num_components) {
+    case 1:
+      switch (cdata->_format) {
+      case F_depth_component:
+      case F_depth_component16:
+      case F_depth_component24:
+      case F_depth_component32:
+        gl_format = KTX_GL_DEPTH_COMPONENT;
+        break;
+      case F_green:
+        gl_format = KTX_GL_GREEN;
+        break;
+      case F_blue:
+        gl_format = KTX_GL_BLUE;
+        break;
+      case F_alpha:
+        gl_format = KTX_GL_ALPHA;
+        break;
+      case F_luminance:
+      case F_sluminance:
+        gl_format = KTX_GL_LUMINANCE;
+        break;
+      default:
+        gl_format = KTX_GL_RED;
+      }
+      gl_base_internal_format = gl_format;
+      break;
+
+    case 2:
+      switch (cdata->_format) {
+      case F_rg16:
+      case F_rg32:
+      case F_rg8i:
+        gl_format = KTX_GL_RG;
+        break;
+      default:
+        gl_format = KTX_GL_LUMINANCE_ALPHA;
+      }
+      gl_base_internal_format = gl_format;
+      break;
+
+    case 3:
+      gl_format = KTX_GL_BGR;
+      gl_base_internal_format = KTX_GL_RGB;
+      break;
+
+    case 4:
+      gl_format = KTX_GL_BGRA;
+      gl_base_internal_format = KTX_GL_RGBA;
+      break;
+    }
+
+    // Use a sized internal format where there is an obvious one.
+    gl_internal_format = gl_base_internal_format;
+    switch (gl_base_internal_format) {
+    case KTX_GL_RED:
+      gl_internal_format = (gl_type == KTX_GL_FLOAT) ? KTX_GL_R32F :
+        (gl_type == KTX_GL_UNSIGNED_SHORT) ? KTX_GL_R16 : KTX_GL_R8;
+      break;
+    case KTX_GL_RG:
+      gl_internal_format = (gl_type == KTX_GL_FLOAT) ? KTX_GL_RG32F :
+        (gl_type == KTX_GL_UNSIGNED_SHORT) ? KTX_GL_RG16 : KTX_GL_RG8;
+      break;
+    case KTX_GL_RGB:
+      gl_internal_format = (gl_type == KTX_GL_FLOAT) ? KTX_GL_RGB32F :
+        (gl_type == KTX_GL_UNSIGNED_SHORT) ? KTX_GL_RGB16 : KTX_GL_RGB8;
+      break;
+    case KTX_GL_RGBA:
+      gl_internal_format = (gl_type == KTX_GL_FLOAT) ? KTX_GL_RGBA32F :
+        (gl_type == KTX_GL_UNSIGNED_SHORT) ? KTX_GL_RGBA16 : KTX_GL_RGBA8;
+      break;
+    }
+  }
+
+  unsigned int height = cdata->_y_size;
+  unsigned int depth = 0;
+  unsigned int num_array_elements = 0;
+  unsigned int num_faces = 1;
+  switch (cdata->_texture_type) {
+  case TT_1d_texture:
+    height = 0;
+    break;
+  case TT_2d_texture:
+    break;
+  case TT_3d_texture:
+    depth = cdata->_z_size;
+    break;
+  case TT_2d_texture_array:
+    num_array_elements = cdata->_z_size;
+    break;
+  case TT_cube_map:
+    num_faces = 6;
+    break;
+  default:
+    gobj_cat.error()
+      << filename << ": cannot write a " << cdata->_texture_type
+      << " to a KTX file.\n";
+    return false;
+  }
+
+  // Only a complete chain of mipmap levels, from the top, is written.
+  int num_levels = 1;
+  while (num_levels < (int)cdata->_ram_images.size() &&
+         do_has_ram_mipmap_image(cdata, num_levels)) {
+    ++num_levels;
+  }
+
+  // The metadata: the image orientation, and the precise Panda format.
+  Datagram key_values;
+  string orientation("KTXorientation\0S=r,T=u", 22);
+  if (cdata->_texture_type == TT_3d_texture) {
+    orientation = string("KTXorientation\0S=r,T=u,R=i", 26);
+  }
+  string panda_format = string(KTX_PANDA_FORMAT_KEY) + '\0' + format_format(cdata->_format);
+  string pairs[2] = { orientation + '\0', panda_format + '\0' };
+  for (int i = 0; i < 2; ++i) {
+    key_values.add_uint32(pairs[i].size());
+    key_values.append_data(pairs[i]);
+    key_values.pad_bytes((4 - (pairs[i].size() & 3)) & 3);
+  }
+
+  out.write((const char *)ktx_identifier, 12);
+  StreamWriter ktx(out);
+  ktx.add_uint32(KTX_ENDIANNESS);
+  ktx.add_uint32(gl_type);
+  ktx.add_uint32(gl_type_size);
+  ktx.add_uint32(gl_format);
+  ktx.add_uint32(gl_internal_format);
+  ktx.add_uint32(gl_base_internal_format);
+  ktx.add_uint32(cdata->_x_size);
+  ktx.add_uint32(height);
+  ktx.add_uint32(depth);
+  ktx.add_uint32(num_array_elements);
+  ktx.add_uint32(num_faces);
+  ktx.add_uint32(num_levels);
+  ktx.add_uint32(key_values.get_length());
+  ktx.append_data(key_values.get_data(), key_values.get_length());
+
+  for (int n = 0; n < num_levels; ++n) {
+    const RamImage &ram_image = cdata->_ram_images[n];
+    int z_size_n = do_get_expected_mipmap_z_size(cdata, n);
+    size_t page_size = do_get_ram_mipmap_page_size(cdata, n);
+
+    if (cdata->_ram_image_compression != CM_off) {
+      size_t level_size = page_size * z_size_n;
+      nassertr(ram_image._image.size() >= level_size, false);
+      ktx.add_uint32((cdata->_texture_type == TT_cube_map) ? page_size : level_size);
+      ktx.append_data(ram_image._image.p(), level_size);
+      ktx.pad_bytes((4 - (level_size & 3)) & 3);
+
+    } else {
+      // Uncompressed rows are padded to a multiple of 4 bytes.
+      size_t row_size = (size_t)do_get_expected_mipmap_x_size(cdata, n) *
+        cdata->_num_components * cdata->_component_width;
+      size_t padded_row_size = (row_size + 3) & ~3;
+      int y_size = do_get_expected_mipmap_y_size(cdata, n);
+      int num_rows = y_size * z_size_n;
+      nassertr(ram_image._image.size() >= row_size * num_rows, false);
+
+      size_t image_size = padded_row_size * num_rows;
+      if (cdata->_texture_type == TT_cube_map) {
+        image_size = padded_row_size * y_size;
+      }
+      ktx.add_uint32(image_size);
+      if (padded_row_size == row_size) {
+        ktx.append_data(ram_image._image.p(), row_size * num_rows);
+      } else {
+        const unsigned char *p = ram_image._image.p();
+        for (int r = 0; r < num_rows; ++r) {
+          ktx.append_data(p, row_size);
+          ktx.pad_bytes(padded_row_size - row_size);
+          p += row_size;
+        }
+      }
+    }
+  }
+
+  if (out.fail()) {
+    gobj_cat.error()
+      << "Unable to write to " << filename << "\n";
+    return false;
+  }
+
+  return true;
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: Texture::unlocked_ensure_ram_image
 //       Access: Protected, Virtual
@@ -53,6 +53,7 @@ class PreparedGraphicsObjects;
 class CullTraverser;
 class CullTraverserData;
 class TexturePeeker;
+class TextureDecoder;
 struct DDSHeader;
 
 ////////////////////////////////////////////////////////////////////
@@ -274,6 +275,8 @@ PUBLISHED:
   BLOCKING static PT(Texture) make_from_txo(istream &in, const string &filename = "");
   BLOCKING bool write_txo(ostream &out, const string &filename = "") const;
   BLOCKING bool read_dds(istream &in, const string &filename = "", bool header_only = false);
+  BLOCKING bool read_ktx(istream &in, const string &filename = "", bool header_only = false);
+  BLOCKING bool write_ktx(ostream &out, const string &filename = "") const;
 
   BLOCKING INLINE bool load(const PNMImage &pnmimage, const LoaderOptions &options = LoaderOptions());
   BLOCKING INLINE bool load(const PNMImage &pnmimage, int z, int n, const LoaderOptions &options = LoaderOptions());
@@ -559,6 +562,20 @@ protected:
                            int z, int n, int primary_file_num_channels, int alpha_file_channel,
                            const LoaderOptions &options,
                            bool header_only, BamCacheRecord *record);
+  virtual bool do_can_decode_pages(const CData *cdata) const;
+  bool do_read_page(CData *cdata, TextureDecoder *decoder,
+                    const Filename &fullpath, const Filename &alpha_fullpath,
+                    int z, int n, int primary_file_num_channels, int alpha_file_channel,
+                    const LoaderOptions &options,
+                    bool header_only, BamCacheRecord *record);
+  bool do_read_decoded_pages(CData *cdata, TextureDecoder &decoder,
+                             int primary_file_num_channels, int alpha_file_channel,
+                             const LoaderOptions &options, BamCacheRecord *record);
+  bool do_finish_read_one(CData *cdata,
+                          const Filename &fullpath, const Filename &alpha_fullpath,
+                          int z, int n, int primary_file_num_channels, int alpha_file_channel,
+                          const LoaderOptions &options, bool read_floating_point,
+                          PNMImage &image, PfmFile &pfm, PNMImage &alpha_image);
   virtual bool do_load_one(CData *cdata,
                            const PNMImage &pnmimage, const string &name,
                            int z, int n, const LoaderOptions &options);
@@ -571,6 +588,8 @@ protected:
   bool do_read_txo(CData *cdata, istream &in, const string &filename);
   bool do_read_dds_file(CData *cdata, const Filename &fullpath, bool header_only);
   bool do_read_dds(CData *cdata, istream &in, const string &filename, bool header_only);
+  bool do_read_ktx_file(CData *cdata, const Filename &fullpath, bool header_only);
+  bool do_read_ktx(CData *cdata, istream &in, const string &filename, bool header_only);
 
   bool do_write(CData *cdata, const Filename &fullpath, int z, int n,
                 bool write_pages, bool write_mipmaps);
@@ -579,6 +598,8 @@ protected:
   bool do_store_one(CData *cdata, PfmFile &pfm, int z, int n);
   bool do_write_txo_file(const CData *cdata, const Filename &fullpath) const;
   bool do_write_txo(const CData *cdata, ostream &out, const string &filename) const;
+  bool do_write_ktx_file(const CData *cdata, const Filename &fullpath) const;
+  bool do_write_ktx(const CData *cdata, ostream &out, const string &filename) const;
 
   virtual CData *unlocked_ensure_ram_image(bool allow_compression);
   virtual void do_reload_ram_image(CData *cdata, bool allow_compression);
@@ -735,6 +756,7 @@ private:
 
   INLINE static bool is_txo_filename(const Filename &fullpath);
   INLINE static bool is_dds_filename(const Filename &fullpath);
+  INLINE static bool is_ktx_filename(const Filename &fullpath);
 
   void do_filter_2d_mipmap_pages(const CData *cdata,
                                  RamImage &to, const RamImage &from,
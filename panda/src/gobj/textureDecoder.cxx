@@ -0,0 +1,426 @@
+// Filename: textureDecoder.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "textureDecoder.h"
+#include "config_gobj.h"
+#include "virtualFileSystem.h"
+#include "pnmReader.h"
+#include "pnmFileType.h"
+#include "stringStream.h"
+#include "zStream.h"
+#include "mutexHolder.h"
+#include "pStatCollector.h"
+#include "pStatTimer.h"
+
+static PStatCollector texture_file_read_pcollector("*:Texture:Read:File");
+static PStatCollector texture_decode_pcollector("*:Texture:Read:Decode");
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureDecoder::Constructor
+//       Access: Public
+//  Description:
+////////////////////////////////////////////////////////////////////
+TextureDecoder::
+TextureDecoder(const LoaderOptions &options) :
+  _options(options),
+  _cvar(_lock),
+  _num_read(0),
+  _next_decode(0),
+  _num_in_flight(0),
+  _shutdown(false)
+{
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureDecoder::Destructor
+//       Access: Public
+//  Description:
+////////////////////////////////////////////////////////////////////
+TextureDecoder::
+~TextureDecoder() {
+  stop();
+
+  Pages::iterator pi;
+  for (pi = _pages.begin(); pi != _pages.end(); ++pi) {
+    delete (*pi);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureDecoder::add_page
+//       Access: Public
+//  Description: Adds another file to be read and decoded.  The
+//               alpha_fullpath may be empty.  This must be called
+//               before start().
+////////////////////////////////////////////////////////////////////
+void TextureDecoder::
+add_page(const Filename &fullpath, const Filename &alpha_fullpath,
+         int z, int n, int read_x_size, int read_y_size) {
+  nassertv(_threads.empty());
+
+  // The pages are allocated individually, since an empty PNMImage
+  // cannot be copied.
+  Page *page_ptr = new Page;
+  _pages.push_back(page_ptr);
+  Page &page = *page_ptr;
+  page._fullpath = fullpath;
+  page._alpha_fullpath = alpha_fullpath;
+  page._z = z;
+  page._n = n;
+  page._read_x_size = read_x_size;
+  page._read_y_size = read_y_size;
+  page._read_floating_point = false;
+  page._success = false;
+  page._alpha_success = false;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureDecoder::start
+//       Access: Public
+//  Description: Starts the reading thread and the decoding threads.
+////////////////////////////////////////////////////////////////////
+void TextureDecoder::
+start() {
+  nassertv(_threads.empty());
+  _decoded.assign(_pages.size(), false);
+
+  PT(GenericThread) thread =
+    new GenericThread("TextureRead", "TextureRead", &st_read_main, this);
+  if (!thread->start(TP_normal, true)) {
+    // No threads are available; wait_page() will do the work instead.
+    return;
+  }
+  _threads.push_back(thread);
+
+  int num_threads = max(min(get_num_threads(), (int)_pages.size()), 1);
+  for (int i = 0; i < num_threads; ++i) {
+    ostringstream name_strm;
+    name_strm << "TextureDecode" << i;
+    thread = new GenericThread(name_strm.str(), "TextureDecode",
+                               &st_decode_main, this);
+    if (thread->start(TP_normal, true)) {
+      _threads.push_back(thread);
+    }
+  }
+
+  if (_threads.size() == 1) {
+    // We couldn't start any decoders, so give up on the reader too.
+    stop();
+    _shutdown = false;
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureDecoder::wait_page
+//       Access: Public
+//  Description: Waits for the ith page to be decoded, and returns
+//               it.  The caller may then take the images from it.
+//               Pages must be waited for in order.
+////////////////////////////////////////////////////////////////////
+TextureDecoder::Page &TextureDecoder::
+wait_page(int i) {
+  nassertr(i >= 0 && i < (int)_pages.size(), *_pages[0]);
+
+  if (_threads.empty()) {
+    // There are no threads; read and decode the page right now.
+    if (!_decoded[i]) {
+      Thread *current_thread = Thread::get_current_thread();
+      read_page(*_pages[i], current_thread);
+      decode_page(*_pages[i], current_thread);
+      _decoded[i] = true;
+    }
+    return *_pages[i];
+  }
+
+  MutexHolder holder(_lock);
+  while (!_decoded[i]) {
+    _cvar.wait();
+  }
+  return *_pages[i];
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureDecoder::stop
+//       Access: Public
+//  Description: Abandons any pages not yet read or decoded, and waits
+//               for all of the threads to finish.
+////////////////////////////////////////////////////////////////////
+void TextureDecoder::
+stop() {
+  {
+    MutexHolder holder(_lock);
+    _shutdown = true;
+    _cvar.notify_all();
+  }
+
+  Threads::iterator ti;
+  for (ti = _threads.begin(); ti != _threads.end(); ++ti) {
+    (*ti)->join();
+  }
+  _threads.clear();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureDecoder::get_num_threads
+//       Access: Public, Static
+//  Description: Returns the number of decoding threads a
+//               TextureDecoder will use, or 0 if the pages of a
+//               texture should be read one at a time on the calling
+//               thread instead.
+////////////////////////////////////////////////////////////////////
+int TextureDecoder::
+get_num_threads() {
+  if (!Thread::is_true_threads() || texture_decode_threads <= 1) {
+    return 0;
+  }
+  return texture_decode_threads;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureDecoder::choose_floating_point
+//       Access: Public, Static
+//  Description: Returns true if the image file opened by the
+//               indicated reader should be read into a floating-point
+//               texture, according to the options and the type of
+//               the file.
+////////////////////////////////////////////////////////////////////
+bool TextureDecoder::
+choose_floating_point(const LoaderOptions &options, PNMReader *reader,
+                      const Filename &alpha_fullpath) {
+  int texture_load_type = (options.get_texture_flags() & (LoaderOptions::TF_integer | LoaderOptions::TF_float));
+  switch (texture_load_type) {
+  case LoaderOptions::TF_integer:
+    return false;
+
+  case LoaderOptions::TF_float:
+    return true;
+
+  default:
+    // Neither TF_integer nor TF_float was specified; if it's a
+    // floating-point image file, read it by default into a
+    // floating-point texture.
+    return reader->is_floating_point() && alpha_fullpath.empty();
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureDecoder::read_main
+//       Access: Private
+//  Description: The body of the reading thread.  Reads the files of
+//               each page in turn into memory, staying no more than
+//               texture-decode-read-ahead pages ahead of the
+//               decoders.
+////////////////////////////////////////////////////////////////////
+void TextureDecoder::
+read_main() {
+  Thread *current_thread = Thread::get_current_thread();
+  int read_ahead = max((int)texture_decode_read_ahead, 1);
+
+  for (int i = 0; i < (int)_pages.size(); ++i) {
+    {
+      MutexHolder holder(_lock);
+      while (_num_in_flight >= read_ahead && !_shutdown) {
+        _cvar.wait();
+      }
+      if (_shutdown) {
+        return;
+      }
+    }
+
+    read_page(*_pages[i], current_thread);
+
+    MutexHolder holder(_lock);
+    ++_num_read;
+    ++_num_in_flight;
+    _cvar.notify_all();
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureDecoder::decode_main
+//       Access: Private
+//  Description: The body of each decoding thread.  Decodes pages as
+//               they are read, until all of them are done.
+////////////////////////////////////////////////////////////////////
+void TextureDecoder::
+decode_main() {
+  Thread *current_thread = Thread::get_current_thread();
+
+  while (true) {
+    int i;
+    {
+      MutexHolder holder(_lock);
+      while (_next_decode >= _num_read &&
+             _next_decode < (int)_pages.size() && !_shutdown) {
+        _cvar.wait();
+      }
+      if (_shutdown || _next_decode >= (int)_pages.size()) {
+        return;
+      }
+      i = _next_decode;
+      ++_next_decode;
+    }
+
+    decode_page(*_pages[i], current_thread);
+
+    MutexHolder holder(_lock);
+    --_num_in_flight;
+    _decoded[i] = true;
+    _cvar.notify_all();
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureDecoder::read_page
+//       Access: Private
+//  Description: Reads the files of the indicated page into memory.
+////////////////////////////////////////////////////////////////////
+void TextureDecoder::
+read_page(Page &page, Thread *current_thread) {
+  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+  PStatTimer timer(texture_file_read_pcollector, current_thread);
+
+  // We don't unwrap .pz files here, since that would leave the
+  // decompression to this one thread; make_reader() does it instead.
+  page._success =
+    vfs->read_file(Filename::binary_filename(page._fullpath), page._data, false);
+  if (page._success && !page._alpha_fullpath.empty()) {
+    page._alpha_success =
+      vfs->read_file(Filename::binary_filename(page._alpha_fullpath),
+                     page._alpha_data, false);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureDecoder::decode_page
+//       Access: Private
+//  Description: Decodes the files of the indicated page, which have
+//               already been read into memory, and releases the file
+//               data.  This is the threaded equivalent of the reading
+//               half of Texture::do_read_one().
+////////////////////////////////////////////////////////////////////
+void TextureDecoder::
+decode_page(Page &page, Thread *current_thread) {
+  if (!page._success) {
+    return;
+  }
+  page._success = false;
+
+  PNMReader *reader = make_reader(page._image, page._data, page._fullpath);
+  if (reader != (PNMReader *)NULL) {
+    PStatCollector collector(texture_decode_pcollector,
+                             reader->get_type()->get_name());
+    PStatTimer timer(collector, current_thread);
+
+    page._image.copy_header_from(*reader);
+    page._read_floating_point =
+      choose_floating_point(_options, reader, page._alpha_fullpath);
+
+    page._image.set_read_size(page._read_x_size, page._read_y_size);
+    if (page._image.get_x_size() != page._image.get_read_x_size() ||
+        page._image.get_y_size() != page._image.get_read_y_size()) {
+      gobj_cat.info()
+        << "Implicitly rescaling " << page._fullpath.get_basename() << " from "
+        << page._image.get_x_size() << " by " << page._image.get_y_size() << " to "
+        << page._image.get_read_x_size() << " by " << page._image.get_read_y_size()
+        << "\n";
+    }
+
+    if (page._read_floating_point) {
+      page._success = page._pfm.read(reader);
+    } else {
+      page._success = page._image.read(reader);
+    }
+  }
+  page._data.clear();
+
+  if (!page._success || page._alpha_fullpath.empty()) {
+    return;
+  }
+
+  if (page._alpha_success) {
+    page._alpha_success = false;
+
+    PNMReader *alpha_reader =
+      make_reader(page._alpha_image, page._alpha_data, page._alpha_fullpath);
+    if (alpha_reader != (PNMReader *)NULL) {
+      PStatCollector collector(texture_decode_pcollector,
+                               alpha_reader->get_type()->get_name());
+      PStatTimer timer(collector, current_thread);
+
+      page._alpha_image.copy_header_from(*alpha_reader);
+      if (page._image.get_x_size() != page._alpha_image.get_x_size() ||
+          page._image.get_y_size() != page._alpha_image.get_y_size()) {
+        gobj_cat.info()
+          << "Implicitly rescaling " << page._alpha_fullpath.get_basename()
+          << " from " << page._alpha_image.get_x_size() << " by "
+          << page._alpha_image.get_y_size() << " to " << page._image.get_x_size()
+          << " by " << page._image.get_y_size() << "\n";
+        page._alpha_image.set_read_size(page._image.get_x_size(),
+                                        page._image.get_y_size());
+      }
+
+      page._alpha_success = page._alpha_image.read(alpha_reader);
+    }
+  }
+  page._alpha_data.clear();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureDecoder::make_reader
+//       Access: Private, Static
+//  Description: Returns a new PNMReader that reads the image from the
+//               indicated file data, decompressing it first if the
+//               filename ends in .pz, or NULL if the image type
+//               cannot be determined.  The data is swapped into the
+//               reader's stream rather than copied, so it is left
+//               empty.
+////////////////////////////////////////////////////////////////////
+PNMReader *TextureDecoder::
+make_reader(PNMImageHeader &header, pvector<unsigned char> &data,
+            const Filename &fullpath) {
+  StringStream *in = new StringStream;
+  in->swap_data(data);
+
+  istream *stream = in;
+#ifdef HAVE_ZLIB
+  if (fullpath.get_extension() == "pz") {
+    stream = new IDecompressStream(in, true);
+  }
+#endif  // HAVE_ZLIB
+
+  // The reader takes ownership of the stream, and deletes it when it
+  // is done.
+  return header.make_reader(stream, true, fullpath);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureDecoder::st_read_main
+//       Access: Private, Static
+//  Description: The thread function for read_main().
+////////////////////////////////////////////////////////////////////
+void TextureDecoder::
+st_read_main(void *data) {
+  ((TextureDecoder *)data)->read_main();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureDecoder::st_decode_main
+//       Access: Private, Static
+//  Description: The thread function for decode_main().
+////////////////////////////////////////////////////////////////////
+void TextureDecoder::
+st_decode_main(void *data) {
+  ((TextureDecoder *)data)->decode_main();
+}
@@ -0,0 +1,121 @@
+// Filename: textureDecoder.h
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef TEXTUREDECODER_H
+#define TEXTUREDECODER_H
+
+#include "pandabase.h"
+#include "filename.h"
+#include "loaderOptions.h"
+#include "pnmImage.h"
+#include "pfmFile.h"
+#include "pmutex.h"
+#include "conditionVarFull.h"
+#include "genericThread.h"
+#include "pointerTo.h"
+#include "pvector.h"
+
+////////////////////////////////////////////////////////////////////
+//       Class : TextureDecoder
+// Description : Reads and decodes the image files for several pages
+//               or mipmap levels of a Texture at once.  One thread
+//               reads the files from disk, in order, while a pool of
+//               threads decodes them as they arrive; the caller
+//               collects the decoded images, in the same order, with
+//               wait_page().
+//
+//               The reading thread stays no more than
+//               texture-decode-read-ahead files ahead of the
+//               decoders, so that the undecoded files of a very long
+//               sequence are not all held in memory at once.
+//
+//               This is used internally by Texture::do_read().
+////////////////////////////////////////////////////////////////////
+class EXPCL_PANDA_GOBJ TextureDecoder {
+public:
+  TextureDecoder(const LoaderOptions &options);
+  ~TextureDecoder();
+
+  class Page {
+  public:
+    Filename _fullpath;
+    Filename _alpha_fullpath;
+    int _z, _n;
+
+    // The size to which the image should be scaled while reading.
+    int _read_x_size, _read_y_size;
+
+    // The remaining members are filled in by the threads.  The file
+    // data is read as it is on disk; a .pz file is decompressed by
+    // the decoding thread, not the reading thread.
+    pvector<unsigned char> _data;
+    pvector<unsigned char> _alpha_data;
+    bool _read_floating_point;
+    PNMImage _image;
+    PfmFile _pfm;
+    PNMImage _alpha_image;
+    bool _success;
+    bool _alpha_success;
+  };
+
+  void add_page(const Filename &fullpath, const Filename &alpha_fullpath,
+                int z, int n, int read_x_size, int read_y_size);
+  INLINE int get_num_pages() const;
+
+  void start();
+  Page &wait_page(int i);
+  void stop();
+
+  static int get_num_threads();
+  static bool choose_floating_point(const LoaderOptions &options,
+                                    PNMReader *reader,
+                                    const Filename &alpha_fullpath);
+
+private:
+  void read_main();
+  void decode_main();
+  void read_page(Page &page, Thread *current_thread);
+  void decode_page(Page &page, Thread *current_thread);
+  static PNMReader *make_reader(PNMImageHeader &header,
+                                pvector<unsigned char> &data,
+                                const Filename &fullpath);
+
+  static void st_read_main(void *data);
+  static void st_decode_main(void *data);
+
+  LoaderOptions _options;
+
+  typedef pvector<Page *> Pages;
+  Pages _pages;
+
+  // The remaining members are protected by _lock.
+  Mutex _lock;
+
+  // Signaled whenever a file has been read or decoded, or _shutdown
+  // is set.
+  ConditionVarFull _cvar;
+
+  int _num_read;
+  int _next_decode;
+  int _num_in_flight;
+  pvector<bool> _decoded;
+  bool _shutdown;
+
+  typedef pvector<PT(GenericThread) > Threads;
+  Threads _threads;
+};
+
+#include "textureDecoder.I"
+
+#endif
@@ -233,6 +233,17 @@ do_adjust_this_size(const Texture::CData *cdata_tex,
   return adjust_size(x_size, y_size, name, for_padding, ats);
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: MovieTexture::do_can_decode_pages
+//       Access: Protected, Virtual
+//  Description: Returns false, since the pages of this texture must
+//               each be read by do_read_one().
+////////////////////////////////////////////////////////////////////
+bool MovieTexture::
+do_can_decode_pages(const Texture::CData *cdata) const {
+  return false;
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: MovieTexture::do_read_one
 //       Access: Protected, Virtual
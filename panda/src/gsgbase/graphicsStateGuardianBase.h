@@ -48,6 +48,7 @@ class GeomLines;
 class GeomLinestrips;
 class GeomPoints;
 class GeomMunger;
+class CullableObject;
 
 class SceneSetup;
 class PreparedGraphicsObjects;
@@ -125,6 +126,8 @@ PUBLISHED:
   virtual bool get_supports_multisample() const=0;
   virtual int get_supported_geom_rendering() const=0;
   virtual bool get_supports_shadow_filter() const=0;
+  virtual bool get_supports_geometry_instancing() const=0;
+  virtual bool get_supports_multi_draw_indirect() const=0;
 
   virtual bool get_supports_texture_srgb() const=0;
 
@@ -198,6 +201,11 @@ public:
   // inconvenient to declare each of those types to be friends of this
   // class.
 
+  // Draws a run of objects that share the same state and transform,
+  // as grouped together by a state-sorted cull bin.
+  virtual void draw_batch(CullableObject *const *objects, int num_objects,
+                          bool force, Thread *current_thread)=0;
+
   virtual bool begin_draw_primitives(const GeomPipelineReader *geom_reader,
                                      const GeomMunger *munger,
                                      const GeomVertexDataPipelineReader *data_reader,
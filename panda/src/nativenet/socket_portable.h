@@ -356,6 +356,15 @@ const long LOCAL_NONBLOCK = 1;
 const int LOCAL_BLOCKING_ERROR = EAGAIN;
 const int LOCAL_CONNECT_BLOCKING = EINPROGRESS;
 
+#if defined(IS_LINUX)
+// Linux can send or receive a batch of UDP packets with one system
+// call, recvmmsg() or sendmmsg(); see Socket_UDP_Incoming::GetPackets()
+// and Socket_UDP::SendPackets().  We pass at most this many packets to
+// each call.
+#define HAVE_MMSG 1
+const int MMSG_BATCH_SIZE = 64;
+#endif
+
 #else 
 /************************************************************************
 * NO DEFINITION => GIVE COMPILATION ERROR
@@ -44,6 +44,11 @@ public:
 PUBLISHED:
     inline bool SendTo(const string &data, const Socket_Address & address);
     inline bool SetToBroadCast();
+
+public:
+    inline int SendPackets(const char *const *headers, int header_len,
+                           const char *const *data, const int *lengths,
+                           const Socket_Address *addresses, int num_packets);
   
 public:
   static TypeHandle get_class_type() {
@@ -162,4 +167,80 @@ inline bool Socket_UDP::SendTo(const string &data, const Socket_Address & addres
   return SendTo(data.data(), data.size(), address);
 }
 
+////////////////////////////////////////////////////////////////////
+// Function name : Socket_UDP::SendPackets
+// Description   : Sends num_packets packets, each made of header_len
+//                 bytes from headers[i] followed by lengths[i] bytes
+//                 from data[i], to addresses[i].  Where sendmmsg() is
+//                 available, the packets go in batches, with one
+//                 system call each, and nothing is copied.
+//
+// Return type   : int, the number of packets sent, which is less
+//                 than num_packets if there was an error.
+////////////////////////////////////////////////////////////////////
+inline int Socket_UDP::SendPackets(const char *const *headers, int header_len,
+                                   const char *const *data, const int *lengths,
+                                   const Socket_Address *addresses, int num_packets)
+{
+#ifdef HAVE_MMSG
+    struct mmsghdr msgs[MMSG_BATCH_SIZE];
+    struct iovec iov[MMSG_BATCH_SIZE * 2];
+
+    int num_sent = 0;
+    while (num_sent < num_packets)
+    {
+        int count = num_packets - num_sent;
+        if (count > MMSG_BATCH_SIZE)
+            count = MMSG_BATCH_SIZE;
+
+        memset(msgs, 0, count * sizeof(struct mmsghdr));
+        for (int i = 0; i < count; ++i)
+        {
+            int p = num_sent + i;
+            struct iovec *v = &iov[i * 2];
+            int num_iov = 0;
+            if (header_len > 0)
+            {
+                v[num_iov].iov_base = (void *)headers[p];
+                v[num_iov].iov_len = header_len;
+                ++num_iov;
+            }
+            v[num_iov].iov_base = (void *)data[p];
+            v[num_iov].iov_len = lengths[p];
+            ++num_iov;
+
+            msgs[i].msg_hdr.msg_name = (void *)&addresses[p].GetAddressInfo();
+            msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr);
+            msgs[i].msg_hdr.msg_iov = v;
+            msgs[i].msg_hdr.msg_iovlen = num_iov;
+        }
+
+        int val = sendmmsg(_socket, msgs, count, 0);
+        if (val <= 0)
+        {
+            if (val < 0 && GetLastError() == EINTR)
+                continue;
+            break;
+        }
+        num_sent += val;
+    }
+    return num_sent;
+
+#else
+    // Without sendmmsg(), we send one packet at a time, and must copy
+    // each header and its data together.
+    std::string packet;
+    for (int p = 0; p < num_packets; ++p)
+    {
+        packet.clear();
+        if (header_len > 0)
+            packet.append(headers[p], header_len);
+        packet.append(data[p], lengths[p]);
+        if (!SendTo(packet, addresses[p]))
+            return p;
+    }
+    return num_packets;
+#endif  // HAVE_MMSG
+}
+
 #endif //__SOCKET_UDP_H__
@@ -22,6 +22,11 @@ PUBLISHED:
     inline bool SendTo(const char * data, int len, const Socket_Address & address);
     inline bool InitNoAddress();
     inline bool SetToBroadCast();
+
+public:
+    inline int GetPackets(char *const *headers, int header_len,
+                          char *const *data, int max_len, int *lengths,
+                          Socket_Address *addresses, int max_packets);
   
 public:
   static TypeHandle get_class_type() {
@@ -149,6 +154,96 @@ inline bool Socket_UDP_Incoming::GetPacket(char * data, int *max_len, Socket_Add
     return true;
 }
 
+////////////////////////////////////////////////////////////////////
+// Function name : Socket_UDP_Incoming::GetPackets
+// Description   : Reads up to max_packets packets, as many as are
+//                 waiting, with a single recvmmsg() call where that is
+//                 available.  Like GetPacket(), this waits for the
+//                 first packet if the socket is blocking, but not for
+//                 any of the rest.
+//
+//                 The first header_len bytes of packet i are stored
+//                 in headers[i], and the next max_len bytes in
+//                 data[i].  lengths[i] receives the total number of
+//                 bytes in the packet, and addresses[i] the address
+//                 it came from.  If the packet was too big for its
+//                 buffers, so that some of it was lost, lengths[i] is
+//                 greater than header_len + max_len.
+//
+// Return type   : int, the number of packets read, or -1 on error.
+//                 As with GetPacket(), a blocking error reads no
+//                 packets.
+////////////////////////////////////////////////////////////////////
+inline int Socket_UDP_Incoming::GetPackets(char *const *headers, int header_len,
+                                           char *const *data, int max_len, int *lengths,
+                                           Socket_Address *addresses, int max_packets)
+{
+#ifdef HAVE_MMSG
+    struct mmsghdr msgs[MMSG_BATCH_SIZE];
+    struct iovec iov[MMSG_BATCH_SIZE * 2];
+
+    int count = (max_packets < MMSG_BATCH_SIZE) ? max_packets : MMSG_BATCH_SIZE;
+    memset(msgs, 0, count * sizeof(struct mmsghdr));
+    for (int i = 0; i < count; ++i)
+    {
+        struct iovec *v = &iov[i * 2];
+        int num_iov = 0;
+        if (header_len > 0)
+        {
+            v[num_iov].iov_base = headers[i];
+            v[num_iov].iov_len = header_len;
+            ++num_iov;
+        }
+        v[num_iov].iov_base = data[i];
+        v[num_iov].iov_len = max_len;
+        ++num_iov;
+
+        msgs[i].msg_hdr.msg_name = &addresses[i].GetAddressInfo();
+        msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr);
+        msgs[i].msg_hdr.msg_iov = v;
+        msgs[i].msg_hdr.msg_iovlen = num_iov;
+    }
+
+    int val = recvmmsg(_socket, msgs, count, MSG_WAITFORONE, NULL);
+    if (val < 0)
+    {
+        if (GetLastError() != LOCAL_BLOCKING_ERROR)
+            return -1;
+        return 0;
+    }
+
+    for (int i = 0; i < val; ++i)
+    {
+        lengths[i] = msgs[i].msg_len;
+        if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC)
+            lengths[i] = header_len + max_len + 1;
+    }
+    return val;
+
+#else
+    // Without recvmmsg(), we read just one packet, and copy it apart.
+    // The buffer has room for one byte more than we want, so that we
+    // can tell if the packet was too big.
+    if (max_packets < 1)
+        return 0;
+
+    std::string buffer(header_len + max_len + 1, '\0');
+    int len = (int)buffer.size();
+    if (!GetPacket(&buffer[0], &len, addresses[0]))
+        return -1;
+    if (len == 0)
+        return 0;
+
+    int hl = (len < header_len) ? len : header_len;
+    int dl = (len - hl < max_len) ? len - hl : max_len;
+    if (hl > 0)
+        memcpy(headers[0], buffer.data(), hl);
+    memcpy(data[0], buffer.data() + hl, dl);
+    lengths[0] = len;
+    return 1;
+#endif  // HAVE_MMSG
+}
+
 ////////////////////////////////////////////////////////////////////
 // Function name : SocketUDP_Outgoing::SendTo
 // Description     : Send data to specified address
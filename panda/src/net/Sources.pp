@@ -87,6 +87,46 @@
 
 #end test_bin_target
 
+#begin test_bin_target
+  #define TARGET test_spam_load
+  #define LOCAL_LIBS p3net p3putil
+  #define OTHER_LIBS $[OTHER_LIBS] p3pystub
+
+  #define SOURCES \
+    test_spam_load.cxx
+
+#end test_bin_target
+
+#begin test_bin_target
+  #define TARGET test_write_batch
+  #define LOCAL_LIBS p3net p3putil
+  #define OTHER_LIBS $[OTHER_LIBS] p3pystub
+
+  #define SOURCES \
+    test_write_batch.cxx
+
+#end test_bin_target
+
+#begin test_bin_target
+  #define TARGET test_receive_alloc
+  #define LOCAL_LIBS p3net p3putil
+  #define OTHER_LIBS $[OTHER_LIBS] p3pystub
+
+  #define SOURCES \
+    test_receive_alloc.cxx
+
+#end test_bin_target
+
+#begin test_bin_target
+  #define TARGET test_udp_batch
+  #define LOCAL_LIBS p3net p3putil
+  #define OTHER_LIBS $[OTHER_LIBS] p3pystub
+
+  #define SOURCES \
+    test_udp_batch.cxx
+
+#end test_bin_target
+
 #begin test_bin_target
   #define TARGET test_tcp_client
   #define LOCAL_LIBS p3net
@@ -143,6 +143,59 @@ ConfigVariableEnum<ThreadPriority> net_thread_priority
  PRC_DESC("The default thread priority when creating threaded readers "
           "or writers."));
 
+ConfigVariableInt net_max_write_batch
+("net-max-write-batch", 64,
+ PRC_DESC("The maximum number of datagrams a threaded ConnectionWriter "
+          "takes from its queue at once.  The datagrams it takes for "
+          "the same TCP connection are written with a single system "
+          "call."));
+
+ConfigVariableDouble net_write_batch_window
+("net-write-batch-window", 0.0,
+ PRC_DESC("The default time, in seconds, that a threaded "
+          "ConnectionWriter waits for more datagrams to be queued "
+          "before it writes the ones it has, up to net-max-write-batch.  "
+          "A longer window means fewer, larger writes, at the cost of "
+          "latency.  If this is 0, the writer writes whatever is "
+          "queued at the time without waiting.  See "
+          "ConnectionWriter::set_batch_window()."));
+
+ConfigVariableInt net_receive_buffer_pool_size
+("net-receive-buffer-pool-size", 1024,
+ PRC_DESC("The number of buffers each ConnectionReader keeps for the "
+          "TCP datagrams it receives.  A datagram is read directly into "
+          "one of these, and the buffer is shared, not copied, by every "
+          "Datagram it is handed to; once the last of these is gone, the "
+          "buffer is reused for another datagram.  Set this to 0 to "
+          "allocate a new buffer for each datagram."));
+
+ConfigVariableInt net_max_datagram_size
+("net-max-datagram-size", 16777216,
+ PRC_DESC("The largest TCP datagram, in bytes, that a ConnectionReader "
+          "accepts.  A connection whose next datagram header claims a "
+          "larger size than this is closed, rather than trusted to "
+          "send that many bytes.  Buffers for datagrams larger than "
+          "16 KB grow as the data arrives, so memory is not committed "
+          "on the strength of the header alone."));
+
+ConfigVariableInt net_udp_read_batch
+("net-udp-read-batch", 32,
+ PRC_DESC("The most UDP datagrams a ConnectionReader reads from a socket "
+          "at once.  On Linux, these are read with a single recvmmsg() "
+          "call; elsewhere, only one datagram is read at a time.  Set "
+          "this to 1 to read each datagram with its own call on Linux "
+          "too."));
+
+ConfigVariableBool net_use_epoll
+("net-use-epoll", true,
+ PRC_DESC("On Linux, set this true to have each ConnectionReader wait "
+          "for activity on its sockets with epoll, rather than with "
+          "select().  Unlike select(), this has no limit on the number "
+          "of sockets, and its cost does not grow with the number of "
+          "sockets that are idle.  This is checked when each "
+          "ConnectionReader is created; it has no effect on other "
+          "platforms."));
+
 
 ////////////////////////////////////////////////////////////////////
 //     Function: init_libnet
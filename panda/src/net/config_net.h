@@ -38,6 +38,12 @@ extern ConfigVariableInt net_max_read_per_epoch;
 extern ConfigVariableInt net_max_write_per_epoch;
 
 extern ConfigVariableEnum<ThreadPriority> net_thread_priority;
+extern ConfigVariableBool net_use_epoll;
+extern ConfigVariableInt net_max_write_batch;
+extern ConfigVariableDouble net_write_batch_window;
+extern ConfigVariableInt net_receive_buffer_pool_size;
+extern ConfigVariableInt net_max_datagram_size;
+extern ConfigVariableInt net_udp_read_batch;
 
 extern EXPCL_PANDA_NET void init_libnet();
 
@@ -27,6 +27,15 @@
 #include "socket_udp.h"
 #include "dcast.h"
 
+#if !defined(_WIN32) && !(defined(HAVE_THREADS) && defined(SIMPLE_THREADS))
+// We can hand a batch of TCP datagrams to the kernel with a single
+// writev() call, without copying them together first.
+#define HAVE_WRITEV 1
+#include <sys/uio.h>
+#include <limits.h>
+#include <errno.h>
+#endif
+
 
 ////////////////////////////////////////////////////////////////////
 //     Function: Connection::Constructor
@@ -474,6 +483,201 @@ send_raw_datagram(const NetDatagram &datagram) {
   return true;
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: Connection::send_datagrams
+//       Access: Private
+//  Description: This method is intended only to be called by
+//               ConnectionWriter.  It writes the indicated TCP
+//               datagrams to the socket, in order, with a single
+//               system call if possible.  A tcp_header_size of 0
+//               sends the datagrams raw, as send_raw_datagram() does.
+//               Returns true on success, false on failure.
+////////////////////////////////////////////////////////////////////
+bool Connection::
+send_datagrams(const NetDatagram *const *datagrams, int num_datagrams,
+               int tcp_header_size) {
+  nassertr(_socket != (Socket_IP *)NULL, false);
+  nassertr(_socket->is_exact_type(Socket_TCP::get_class_type()), false);
+
+  int i;
+  if (tcp_header_size == 2) {
+    for (i = 0; i < num_datagrams; ++i) {
+      if (datagrams[i]->get_length() >= 0x10000) {
+        net_cat.error()
+          << "Attempt to send TCP datagram of " << datagrams[i]->get_length()
+          << " bytes--too long!\n";
+        nassert_raise("Datagram too long");
+        return false;
+      }
+    }
+  }
+
+  // All of the headers go into one string, each followed in the
+  // output by its datagram.
+  string headers;
+  headers.reserve(num_datagrams * tcp_header_size);
+  for (i = 0; i < num_datagrams; ++i) {
+    DatagramTCPHeader header(*datagrams[i], tcp_header_size);
+    headers += header.get_header();
+  }
+
+  LightReMutexHolder holder(_write_mutex);
+
+#ifdef HAVE_WRITEV
+  if (!_collect_tcp) {
+    // Anything queued before must go out first.
+    if (!_queued_data.empty() && !do_flush()) {
+      return false;
+    }
+
+    pvector<struct iovec> iov;
+    iov.reserve(num_datagrams * 2);
+    size_t total_bytes = 0;
+    for (i = 0; i < num_datagrams; ++i) {
+      if (tcp_header_size != 0) {
+        struct iovec v;
+        v.iov_base = (void *)(headers.data() + i * tcp_header_size);
+        v.iov_len = tcp_header_size;
+        iov.push_back(v);
+      }
+      if (datagrams[i]->get_length() != 0) {
+        struct iovec v;
+        v.iov_base = (void *)datagrams[i]->get_data();
+        v.iov_len = datagrams[i]->get_length();
+        iov.push_back(v);
+      }
+      total_bytes += tcp_header_size + datagrams[i]->get_length();
+    }
+
+    if (net_cat.is_spam()) {
+      net_cat.spam()
+        << "Sending " << num_datagrams << " TCP datagram(s) with "
+        << total_bytes << " total bytes to " << (void *)this << "\n";
+    }
+
+    // writev() may write less than all of it, in which case we pick
+    // up where it left off.
+    bool okflag = true;
+    size_t vi = 0;
+    while (vi < iov.size()) {
+      int count = (int)min(iov.size() - vi, (size_t)IOV_MAX);
+      ssize_t sent = ::writev(_socket->GetSocket(), &iov[vi], count);
+      if (sent < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        okflag = false;
+        break;
+      }
+      if (sent == 0) {
+        okflag = false;
+        break;
+      }
+      while (sent > 0) {
+        if ((size_t)sent >= iov[vi].iov_len) {
+          sent -= iov[vi].iov_len;
+          ++vi;
+        } else {
+          iov[vi].iov_base = (char *)iov[vi].iov_base + sent;
+          iov[vi].iov_len -= sent;
+          sent = 0;
+        }
+      }
+    }
+
+    _queued_data_start = TrueClock::get_global_ptr()->get_short_time();
+    return check_send_error(okflag);
+  }
+#endif  // HAVE_WRITEV
+
+  // Without writev(), or in collect-tcp mode, we copy the datagrams
+  // into the queue and send them all at once.
+  for (i = 0; i < num_datagrams; ++i) {
+    _queued_data.append(headers, i * tcp_header_size, tcp_header_size);
+    _queued_data += datagrams[i]->get_message();
+    _queued_count++;
+  }
+
+  if (!_collect_tcp ||
+      TrueClock::get_global_ptr()->get_short_time() - _queued_data_start >= _collect_tcp_interval) {
+    return do_flush();
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: Connection::send_udp_datagrams
+//       Access: Private
+//  Description: This method is intended only to be called by
+//               ConnectionWriter.  It sends the indicated UDP
+//               datagrams, each to its own address, in as few system
+//               calls as possible (see Socket_UDP::SendPackets()).
+//               If raw_mode is true, the datagrams are sent without
+//               headers, as send_raw_datagram() does.  Returns true
+//               on success, false on failure.
+////////////////////////////////////////////////////////////////////
+bool Connection::
+send_udp_datagrams(const NetDatagram *const *datagrams, int num_datagrams,
+                   bool raw_mode) {
+  nassertr(_socket != (Socket_IP *)NULL, false);
+  Socket_UDP *udp;
+  DCAST_INTO_R(udp, _socket, false);
+
+  int header_size = raw_mode ? 0 : datagram_udp_header_size;
+  string headers;
+  headers.reserve(num_datagrams * header_size);
+  pvector<const char *> header_ptrs(num_datagrams, (const char *)NULL);
+  pvector<const char *> data_ptrs(num_datagrams);
+  pvector<int> lengths(num_datagrams);
+  pvector<Socket_Address> addresses(num_datagrams);
+
+  int i;
+  for (i = 0; i < num_datagrams; ++i) {
+    const NetDatagram &datagram = *datagrams[i];
+    if (!raw_mode) {
+      DatagramUDPHeader header(datagram);
+      headers += header.get_header();
+    }
+    data_ptrs[i] = (const char *)datagram.get_data();
+    lengths[i] = (int)datagram.get_length();
+    addresses[i] = datagram.get_address().get_addr();
+  }
+  if (!raw_mode) {
+    for (i = 0; i < num_datagrams; ++i) {
+      header_ptrs[i] = headers.data() + i * header_size;
+    }
+  }
+
+  LightReMutexHolder holder(_write_mutex);
+
+  int num_sent = 0;
+  while (num_sent < num_datagrams) {
+    int sent = udp->SendPackets(&header_ptrs[num_sent], header_size,
+                                &data_ptrs[num_sent], &lengths[num_sent],
+                                &addresses[num_sent],
+                                num_datagrams - num_sent);
+    num_sent += sent;
+    if (num_sent < num_datagrams) {
+#if defined(HAVE_THREADS) && defined(SIMPLE_THREADS)
+      if (udp->GetLastError() == LOCAL_BLOCKING_ERROR && udp->Active()) {
+        Thread::force_yield();
+        continue;
+      }
+#endif  // SIMPLE_THREADS
+      break;
+    }
+  }
+
+  if (net_cat.is_spam()) {
+    net_cat.spam()
+      << "Sent " << num_sent << " of " << num_datagrams
+      << " UDP datagrams to " << (void *)this << "\n";
+  }
+
+  return check_send_error(num_sent == num_datagrams);
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: Connection::do_flush
 //       Access: Private
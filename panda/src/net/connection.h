@@ -62,6 +62,10 @@ PUBLISHED:
 private:
   bool send_datagram(const NetDatagram &datagram, int tcp_header_size);
   bool send_raw_datagram(const NetDatagram &datagram);
+  bool send_datagrams(const NetDatagram *const *datagrams, int num_datagrams,
+                      int tcp_header_size);
+  bool send_udp_datagrams(const NetDatagram *const *datagrams,
+                          int num_datagrams, bool raw_mode);
   bool do_flush();
   bool check_send_error(bool okflag);
 
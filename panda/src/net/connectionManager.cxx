@@ -23,6 +23,10 @@
 #include "lightMutexHolder.h"
 #include "trueClock.h"
 
+#ifdef IS_LINUX
+#include <poll.h>
+#endif
+
 #if defined(WIN32_VC) || defined(WIN64_VC)
 #include <winsock2.h>  // For gethostname()
 #include <Iphlpapi.h> // For GetAdaptersAddresses()
@@ -259,6 +263,28 @@ open_TCP_server_rendezvous(const NetAddress &address, int backlog) {
   return connection;
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: poll_for_write
+//  Description: Returns nonzero if the indicated socket is ready for
+//               writing, without waiting.
+////////////////////////////////////////////////////////////////////
+static int
+poll_for_write(Socket_IP *socket) {
+#ifdef IS_LINUX
+  // A process with many connections may have sockets numbered beyond
+  // FD_SETSIZE, which can't be put in a Socket_fdset.
+  struct pollfd pfd;
+  pfd.fd = socket->GetSocket();
+  pfd.events = POLLOUT;
+  pfd.revents = 0;
+  return ::poll(&pfd, 1, 0);
+#else
+  Socket_fdset fset;
+  fset.setForSocket(*socket);
+  return fset.WaitForWrite(true, 0);
+#endif
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: ConnectionManager::open_TCP_client_connection
 //       Access: Published
@@ -279,9 +305,7 @@ open_TCP_client_connection(const NetAddress &address, int timeout_ms) {
     TrueClock *clock = TrueClock::get_global_ptr();
     double start = clock->get_short_time();
     Thread::force_yield();
-    Socket_fdset fset;
-    fset.setForSocket(*socket);
-    int ready = fset.WaitForWrite(true, 0);
+    int ready = poll_for_write(socket);
     while (ready == 0) {
       double elapsed = clock->get_short_time() - start;
       if (elapsed * 1000.0 > timeout_ms) {
@@ -290,8 +314,7 @@ open_TCP_client_connection(const NetAddress &address, int timeout_ms) {
         break;
       }
       Thread::force_yield();
-      fset.setForSocket(*socket);
-      ready = fset.WaitForWrite(true, 0);
+      ready = poll_for_write(socket);
     }
   }
 
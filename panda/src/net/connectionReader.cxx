@@ -28,8 +28,31 @@
 #include "atomicAdjust.h"
 #include "config_downloader.h"
 
+#ifdef IS_LINUX
+#include <unistd.h>
+#include <poll.h>
+#include <errno.h>
+#endif
+
 static const int read_buffer_size = maximum_udp_datagram + datagram_udp_header_size;
 
+// TCP datagrams larger than this are read into a buffer of their
+// own, rather than one from the pool, so that the pool does not hold
+// on to a lot of memory.  That buffer starts at this size, and grows
+// as the datagram arrives.
+static const size_t max_pooled_receive_buffer = 16384;
+
+// The most buffers get_receive_buffer() examines for one that is free.
+static const size_t max_receive_buffer_tries = 8;
+
+// The most UDP datagrams process_incoming_udp_data() reads at once.
+static const int max_udp_read_batch = 64;
+
+#ifdef IS_LINUX
+// The most sockets we learn about from a single epoll_wait() call.
+static const int max_epoll_events = 256;
+#endif
+
 ////////////////////////////////////////////////////////////////////
 //     Function: ConnectionReader::SocketInfo::Constructor
 //       Access: Public
@@ -41,6 +64,11 @@ SocketInfo(const PT(Connection) &connection) :
 {
   _busy = false;
   _error = false;
+  _in_epoll = false;
+
+  if (!is_udp()) {
+    _peer_address = NetAddress(get_socket()->GetPeerName());
+  }
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -125,6 +153,24 @@ ConnectionReader(ConnectionManager *manager, int num_threads,
 
   _currently_polling_thread = -1;
 
+  _next_receive_buffer = 0;
+  _max_receive_buffers = net_receive_buffer_pool_size;
+
+#ifdef IS_LINUX
+  _epoll_fd = -1;
+  _epoll_one_shot = (num_threads > 1);
+  if (net_use_epoll) {
+    _epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (_epoll_fd == -1) {
+      net_cat.warning()
+        << "Unable to create epoll instance (errno " << errno
+        << "); using select() instead.\n";
+    } else {
+      _epoll_events.resize(max_epoll_events);
+    }
+  }
+#endif  // IS_LINUX
+
   string reader_thread_name = thread_name;
   if (thread_name.empty()) {
     reader_thread_name = "ReaderThread";
@@ -154,6 +200,13 @@ ConnectionReader::
 
   shutdown();
 
+#ifdef IS_LINUX
+  if (_epoll_fd != -1) {
+    close(_epoll_fd);
+    _epoll_fd = -1;
+  }
+#endif
+
   // Delete all of our old sockets.
   Sockets::iterator si;
   for (si = _sockets.begin(); si != _sockets.end(); ++si) {
@@ -206,7 +259,13 @@ add_connection(Connection *connection) {
     }
   }
 
-  _sockets.push_back(new SocketInfo(connection));
+  SocketInfo *sinfo = new SocketInfo(connection);
+  _sockets.push_back(sinfo);
+#ifdef IS_LINUX
+  if (_epoll_fd != -1) {
+    epoll_add(sinfo);
+  }
+#endif
 
   return true;
 }
@@ -236,6 +295,11 @@ remove_connection(Connection *connection) {
     return false;
   }
 
+#ifdef IS_LINUX
+  if (_epoll_fd != -1) {
+    epoll_remove(*si);
+  }
+#endif
   _removed_sockets.push_back(*si);
   _sockets.erase(si);
 
@@ -442,6 +506,22 @@ flush_read_connection(Connection *connection) {
   // right here in this thread, since we've already removed this
   // connection from the reader.
 
+#ifdef IS_LINUX
+  // A server with many connections may have sockets numbered beyond
+  // FD_SETSIZE, which can't be put in a Socket_fdset.
+  struct pollfd pfd;
+  pfd.fd = sinfo.get_socket()->GetSocket();
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+  int num_results = ::poll(&pfd, 1, 0);
+  while (num_results > 0) {
+    sinfo._busy = true;
+    if (!process_incoming_data(&sinfo)) {
+      break;
+    }
+    num_results = ::poll(&pfd, 1, 0);
+  }
+#else
   Socket_fdset fdset;
   fdset.clear();
   fdset.setForSocket(*(sinfo.get_socket()));
@@ -454,6 +534,7 @@ flush_read_connection(Connection *connection) {
     fdset.setForSocket(*(sinfo.get_socket()));
     num_results = fdset.WaitForRead(true, 0);
   }
+#endif  // IS_LINUX
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -484,6 +565,12 @@ finish_socket(SocketInfo *sinfo) {
   // By marking the SocketInfo nonbusy, we make it available for
   // future polls.
   sinfo->_busy = false;
+
+#ifdef IS_LINUX
+  if (_epoll_fd != -1 && _epoll_one_shot) {
+    epoll_rearm(sinfo);
+  }
+#endif
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -521,19 +608,38 @@ bool ConnectionReader::
 process_incoming_udp_data(SocketInfo *sinfo) {
   Socket_UDP *socket;
   DCAST_INTO_R(socket, sinfo->get_socket(), false);
-  Socket_Address addr;
 
-  // Read as many bytes as we can.
-  char buffer[read_buffer_size];
-  int bytes_read = read_buffer_size;
+  // We read as many datagrams as are waiting, up to
+  // net-udp-read-batch, each one directly into the buffer its
+  // NetDatagram will keep.  The headers go off to one side.
+  int max_datagrams = max(1, min((int)net_udp_read_batch, max_udp_read_batch));
+  SocketInfo::UDPBuffers &buffers = sinfo->_udp_buffers;
+  buffers.resize(max_datagrams);
 
-  bool okflag = socket->GetPacket(buffer, &bytes_read, addr);
+  char headers[max_udp_read_batch][datagram_udp_header_size];
+  char *header_ptrs[max_udp_read_batch];
+  char *data_ptrs[max_udp_read_batch];
+  int lengths[max_udp_read_batch];
+  Socket_Address addrs[max_udp_read_batch];
 
-  if (!okflag) {
+  int i;
+  for (i = 0; i < max_datagrams; ++i) {
+    if (buffers[i].is_null()) {
+      buffers[i] = get_receive_buffer(maximum_udp_datagram);
+    }
+    header_ptrs[i] = headers[i];
+    data_ptrs[i] = (char *)buffers[i].p();
+  }
+
+  int num_read = socket->GetPackets(header_ptrs, datagram_udp_header_size,
+                                    data_ptrs, maximum_udp_datagram, lengths,
+                                    addrs, max_datagrams);
+
+  if (num_read < 0) {
     finish_socket(sinfo);
     return false;
 
-  } else if (bytes_read == 0) {
+  } else if (num_read == 0) {
     // The socket was closed (!).  This shouldn't happen with a UDP
     // connection.  Oh well.  Report that and return.
     if (_manager != (ConnectionManager *)NULL) {
@@ -543,23 +649,14 @@ process_incoming_udp_data(SocketInfo *sinfo) {
     return false;
   }
 
-  // Since we are not running in raw mode, we decode the header to
-  // determine how big the datagram is.  This means we must have read
-  // at least a full header.
-  if (bytes_read < datagram_udp_header_size) {
-    net_cat.error()
-      << "Did not read entire header, discarding UDP datagram.\n";
-    finish_socket(sinfo);
-    return true;
+  // Take the filled buffers before we finish the socket, since
+  // another thread may then read it.
+  PTA_uchar data[max_udp_read_batch];
+  for (i = 0; i < num_read; ++i) {
+    data[i] = buffers[i];
+    buffers[i].clear();
   }
-  
-  DatagramUDPHeader header(buffer);
-  
-  char *dp = buffer + datagram_udp_header_size;
-  bytes_read -= datagram_udp_header_size;
-  
-  NetDatagram datagram(dp, bytes_read);
-  
+
   // Now that we've read all the data, it's time to finish the socket
   // so another thread can read the next datagram.
   finish_socket(sinfo);
@@ -567,24 +664,50 @@ process_incoming_udp_data(SocketInfo *sinfo) {
   if (_shutdown) {
     return false;
   }
-  
-  // And now do whatever we need to do to process the datagram.
-  if (!header.verify_datagram(datagram)) {
-    net_cat.error()
-      << "Ignoring invalid UDP datagram.\n";
-  } else {
-    datagram.set_connection(sinfo->_connection);
-    datagram.set_address(NetAddress(addr));
 
-    if (net_cat.is_spam()) {
-      net_cat.spam()
-        << "Received UDP datagram with " 
-        << datagram_udp_header_size + datagram.get_length() 
-        << " bytes on " << (void *)datagram.get_connection()
-        << " from " << datagram.get_address() << "\n";
+  for (i = 0; i < num_read; ++i) {
+    // Since we are not running in raw mode, we decode the header to
+    // determine how big the datagram is.  This means we must have
+    // read at least a full header.
+    int bytes_read = lengths[i];
+    if (bytes_read < datagram_udp_header_size) {
+      net_cat.error()
+        << "Did not read entire header, discarding UDP datagram.\n";
+      continue;
+    }
+    if (bytes_read > datagram_udp_header_size + maximum_udp_datagram) {
+      // The datagram didn't fit in our buffer (the socket reported it
+      // truncated), so we don't have all of it.
+      net_cat.error()
+        << "Discarding truncated UDP datagram, larger than the maximum of "
+        << datagram_udp_header_size + maximum_udp_datagram << " bytes.\n";
+      continue;
     }
 
-    receive_datagram(datagram);
+    DatagramUDPHeader header(headers[i]);
+    data[i].v().resize(bytes_read - datagram_udp_header_size);
+
+    NetDatagram datagram;
+    datagram.set_array(data[i]);
+
+    // And now do whatever we need to do to process the datagram.
+    if (!header.verify_datagram(datagram)) {
+      net_cat.error()
+        << "Ignoring invalid UDP datagram.\n";
+    } else {
+      datagram.set_connection(sinfo->_connection);
+      datagram.set_address(NetAddress(addrs[i]));
+
+      if (net_cat.is_spam()) {
+        net_cat.spam()
+          << "Received UDP datagram with " 
+          << datagram_udp_header_size + datagram.get_length() 
+          << " bytes on " << (void *)datagram.get_connection()
+          << " from " << datagram.get_address() << "\n";
+      }
+
+      receive_datagram(datagram);
+    }
   }
 
   return true;
@@ -601,7 +724,8 @@ process_incoming_tcp_data(SocketInfo *sinfo) {
   DCAST_INTO_R(socket, sinfo->get_socket(), false);
 
   // Read only the header bytes to start with.
-  char buffer[read_buffer_size];
+  char buffer[sizeof(PN_uint32)];
+  nassertr(_tcp_header_size <= (int)sizeof(buffer), false);
   int header_bytes_read = 0;
 
   // First, we have to read the first _tcp_header_size bytes.
@@ -645,35 +769,61 @@ process_incoming_tcp_data(SocketInfo *sinfo) {
   DatagramTCPHeader header(buffer, _tcp_header_size);
   int size = header.get_datagram_size(_tcp_header_size);
 
-  // We have to loop until the entire datagram is read.
-  NetDatagram datagram;
+  if (size < 0 || size > net_max_datagram_size) {
+    // The header is garbage, or the other end is trying to make us
+    // allocate more memory than we are willing to.  Either way, we
+    // can't find the next datagram in the stream, so we have to give
+    // up on the connection.
+    net_cat.error()
+      << "TCP datagram header gives a size of " << size
+      << " bytes; closing connection.\n";
+    sinfo->_error = true;
+    if (_manager != (ConnectionManager *)NULL) {
+      _manager->connection_reset(sinfo->_connection, 0);
+    }
+    finish_socket(sinfo);
+    return false;
+  }
+
+  // The datagram is read directly into the buffer that the
+  // NetDatagram will keep; it is not copied again on its way through
+  // the queue.  A small datagram gets a buffer from the pool.  For a
+  // larger one, we don't take the header's word for its size: the
+  // buffer starts at the pool's size and grows as the bytes actually
+  // arrive.  We have to loop until the entire datagram is read.
+  PTA_uchar data;
+  if ((size_t)size <= max_pooled_receive_buffer) {
+    data = get_receive_buffer(size);
+  } else {
+    data = PTA_uchar::empty_array(max_pooled_receive_buffer);
+  }
+  int bytes_received = 0;
 
-  while (!_shutdown && (int)datagram.get_length() < size) {
+  while (!_shutdown && bytes_received < size) {
     int bytes_read;
 
-    int read_bytes = read_buffer_size;
+    if (bytes_received == (int)data.size()) {
+      data.v().resize(min((size_t)size, data.size() * 2));
+    }
+
+    int read_bytes = (int)data.size() - bytes_received;
 #ifdef SIMPLE_THREADS
     // In the SIMPLE_THREADS case, we want to limit the number of
     // bytes we read in a single epoch, to minimize the impact on the
     // other threads.
-    read_bytes = min(read_buffer_size, (int)net_max_read_per_epoch);
+    read_bytes = min(read_bytes, (int)net_max_read_per_epoch);
 #endif
 
-    bytes_read =
-      socket->RecvData(buffer, min(read_bytes,
-                                   (int)(size - datagram.get_length())));
+    char *dp = (char *)data.p() + bytes_received;
+    bytes_read = socket->RecvData(dp, read_bytes);
 #if defined(HAVE_THREADS) && defined(SIMPLE_THREADS)
     while (bytes_read < 0 && socket->GetLastError() == LOCAL_BLOCKING_ERROR &&
            socket->Active()) {
       Thread::force_yield();
-      bytes_read =
-        socket->RecvData(buffer, min(read_bytes,
-                                     (int)(size - datagram.get_length())));
+      bytes_read = socket->RecvData(dp, read_bytes);
     }
 #endif  // SIMPLE_THREADS
 
-    char *dp = buffer;
-
     if (bytes_read <= 0) {
       // The socket was closed.  Report that and return.
       if (_manager != (ConnectionManager *)NULL) {
@@ -683,17 +833,7 @@ process_incoming_tcp_data(SocketInfo *sinfo) {
       return false;
     }
 
-    int datagram_bytes =
-      min(bytes_read, (int)(size - datagram.get_length()));
-    datagram.append_data(dp, datagram_bytes);
-
-    if (bytes_read > datagram_bytes) {
-      // There were some extra bytes at the end of the datagram.  Maybe
-      // the beginning of the next datagram?  Huh.
-      net_cat.error()
-        << "Discarding " << bytes_read - datagram_bytes
-        << " bytes following TCP datagram.\n";
-    }
+    bytes_received += bytes_read;
     Thread::consider_yield();
   }
 
@@ -705,13 +845,16 @@ process_incoming_tcp_data(SocketInfo *sinfo) {
     return false;
   }
 
+  NetDatagram datagram;
+  datagram.set_array(data);
+
   // And now do whatever we need to do to process the datagram.
   if (!header.verify_datagram(datagram, _tcp_header_size)) {
     net_cat.error()
       << "Ignoring invalid TCP datagram.\n";
   } else {
     datagram.set_connection(sinfo->_connection);
-    datagram.set_address(NetAddress(socket->GetPeerName()));
+    datagram.set_address(sinfo->_peer_address);
 
     if (net_cat.is_spam()) {
       net_cat.spam()
@@ -842,6 +985,50 @@ process_raw_incoming_tcp_data(SocketInfo *sinfo) {
   return true;
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: ConnectionReader::get_receive_buffer
+//       Access: Protected
+//  Description: Returns an array of the indicated size to read a
+//               received datagram into, which the datagram may then
+//               keep as its own.  If possible, this is one of the
+//               buffers in the pool that no Datagram refers to any
+//               more, so that receiving a datagram needs no memory
+//               allocation.  The contents of the array are undefined.
+//
+//               Since the datagrams are generally released in the
+//               order they were received, the buffers are reused in
+//               turn, starting with the one handed out the longest
+//               ago.
+////////////////////////////////////////////////////////////////////
+PTA_uchar ConnectionReader::
+get_receive_buffer(size_t size) {
+  if (size <= max_pooled_receive_buffer) {
+    LightMutexHolder holder(_receive_buffers_mutex);
+
+    size_t num_buffers = _receive_buffers.size();
+    size_t num_tries = min(num_buffers, max_receive_buffer_tries);
+    size_t bi = _next_receive_buffer;
+    for (size_t i = 0; i < num_tries; ++i) {
+      PTA_uchar &buffer = _receive_buffers[bi];
+      bi = (bi + 1) % num_buffers;
+      if (buffer.get_ref_count() == 1) {
+        // No one else has this buffer; the only reference is ours.
+        _next_receive_buffer = bi;
+        buffer.v().resize(size);
+        return buffer;
+      }
+    }
+
+    if ((int)num_buffers < _max_receive_buffers) {
+      PTA_uchar buffer = PTA_uchar::empty_array(size);
+      _receive_buffers.push_back(buffer);
+      return buffer;
+    }
+  }
+
+  return PTA_uchar::empty_array(size);
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: ConnectionReader::thread_run
 //       Access: Private
@@ -879,6 +1066,12 @@ thread_run(int thread_index) {
 ////////////////////////////////////////////////////////////////////
 ConnectionReader::SocketInfo *ConnectionReader::
 get_next_available_socket(bool allow_block, int current_thread_index) {
+#ifdef IS_LINUX
+  if (_epoll_fd != -1) {
+    return get_next_epoll_socket(allow_block, current_thread_index);
+  }
+#endif
+
   // Go to sleep on the select() mutex.  This guarantees that only one
   // thread is in this function at a time.
   MutexHolder holder(_select_mutex);
@@ -971,19 +1164,37 @@ rebuild_select_list() {
   _fdset.clear();
   _selecting_sockets.clear();
 
-  LightMutexHolder holder(_sockets_mutex);
-  Sockets::const_iterator si;
-  for (si = _sockets.begin(); si != _sockets.end(); ++si) {
-    SocketInfo *sinfo = (*si);
-    if (!sinfo->_busy && !sinfo->_error) {
-      _fdset.setForSocket(*sinfo->get_socket());
-      _selecting_sockets.push_back(sinfo);
+  {
+    LightMutexHolder holder(_sockets_mutex);
+    Sockets::const_iterator si;
+    for (si = _sockets.begin(); si != _sockets.end(); ++si) {
+      SocketInfo *sinfo = (*si);
+      if (!sinfo->_busy && !sinfo->_error) {
+        _fdset.setForSocket(*sinfo->get_socket());
+        _selecting_sockets.push_back(sinfo);
+      }
     }
   }
 
   // This is also a fine time to delete the contents of the
   // _removed_sockets list.
+  delete_removed_sockets();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: ConnectionReader::delete_removed_sockets
+//       Access: Private
+//  Description: Deletes the SocketInfo of each removed connection
+//               that is no longer being read.  This must be called
+//               only by the thread that is about to poll the sockets,
+//               when no results from the previous poll remain to be
+//               handed out.
+////////////////////////////////////////////////////////////////////
+void ConnectionReader::
+delete_removed_sockets() {
+  LightMutexHolder holder(_sockets_mutex);
   if (!_removed_sockets.empty()) {
+    Sockets::const_iterator si;
     Sockets still_busy_sockets;
     for (si = _removed_sockets.begin(); si != _removed_sockets.end(); ++si) {
       SocketInfo *sinfo = (*si);
@@ -1016,3 +1227,143 @@ accumulate_fdset(Socket_fdset &fdset) {
     }
   }
 }
+
+#ifdef IS_LINUX
+////////////////////////////////////////////////////////////////////
+//     Function: ConnectionReader::get_next_epoll_socket
+//       Access: Private
+//  Description: The epoll flavor of get_next_available_socket().
+////////////////////////////////////////////////////////////////////
+ConnectionReader::SocketInfo *ConnectionReader::
+get_next_epoll_socket(bool allow_block, int current_thread_index) {
+  MutexHolder holder(_select_mutex);
+
+  do {
+    // First, hand out the results from the previous epoll_wait()
+    // call.  A socket reported there may have been removed since.
+    while (!_shutdown && _next_index < _num_results) {
+      SocketInfo *sinfo = (SocketInfo *)_epoll_events[_next_index].data.ptr;
+      _next_index++;
+
+      LightMutexHolder sholder(_sockets_mutex);
+      if (sinfo->_in_epoll) {
+        // Some noise on this socket.  It won't be reported again
+        // until finish_socket() arms it again.
+        sinfo->_busy = true;
+        return sinfo;
+      }
+    }
+
+    bool interrupted;
+    do {
+      interrupted = false;
+      AtomicAdjust::set(_currently_polling_thread, current_thread_index);
+
+      // No events refer to the removed sockets any more.
+      delete_removed_sockets();
+
+      _num_results = 0;
+      _next_index = 0;
+
+      if (!_shutdown) {
+        int timeout = (int)(get_net_max_block() * 1000.0);
+        if (!allow_block) {
+          timeout = 0;
+        }
+#if defined(HAVE_THREADS) && defined(SIMPLE_THREADS)
+        timeout = 0;
+#endif
+
+        _num_results = epoll_wait(_epoll_fd, &_epoll_events[0],
+                                  (int)_epoll_events.size(), timeout);
+      }
+
+      if (_num_results == 0 && allow_block) {
+        interrupted = true;
+        Thread::force_yield();
+
+      } else if (_num_results < 0) {
+        _num_results = 0;
+        Thread::force_yield();
+        return (SocketInfo *)NULL;
+      }
+    } while (!_shutdown && interrupted);
+
+    AtomicAdjust::set(_currently_polling_thread, current_thread_index);
+  } while (!_shutdown && _num_results > 0);
+
+  return (SocketInfo *)NULL;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: ConnectionReader::epoll_add
+//       Access: Private
+//  Description: Registers a newly-added socket with the epoll
+//               instance.  _sockets_mutex must be held.
+//
+//               If there is only one thread to read the sockets, it
+//               never waits while a socket is being read, so the
+//               socket is simply registered level-triggered.  With
+//               more threads, the socket is registered edge-triggered
+//               and one-shot, so that it is reported to only one of
+//               them: once it is reported, it is disabled until
+//               finish_socket() has read the datagram and arms it
+//               again, which reports it at once if there is more data
+//               waiting.  Either way, we can read the sockets without
+//               making them non-blocking.
+////////////////////////////////////////////////////////////////////
+void ConnectionReader::
+epoll_add(SocketInfo *sinfo) {
+  struct epoll_event event;
+  event.events = EPOLLIN;
+  if (_epoll_one_shot) {
+    event.events |= EPOLLET | EPOLLONESHOT;
+  }
+  event.data.ptr = sinfo;
+  if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, sinfo->get_socket()->GetSocket(),
+                &event) == 0) {
+    sinfo->_in_epoll = true;
+  } else {
+    net_cat.error()
+      << "Unable to add socket to epoll instance (errno " << errno << ").\n";
+    sinfo->_error = true;
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: ConnectionReader::epoll_remove
+//       Access: Private
+//  Description: Removes a socket from the epoll instance.
+//               _sockets_mutex must be held.
+////////////////////////////////////////////////////////////////////
+void ConnectionReader::
+epoll_remove(SocketInfo *sinfo) {
+  if (sinfo->_in_epoll) {
+    sinfo->_in_epoll = false;
+
+    // This may fail if the socket has already been closed, which
+    // removes it anyway.
+    struct epoll_event event;
+    epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, sinfo->get_socket()->GetSocket(),
+              &event);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: ConnectionReader::epoll_rearm
+//       Access: Private
+//  Description: Enables a socket to be reported again after it has
+//               been read, in the one-shot mode.  See epoll_add().
+////////////////////////////////////////////////////////////////////
+void ConnectionReader::
+epoll_rearm(SocketInfo *sinfo) {
+  LightMutexHolder holder(_sockets_mutex);
+  if (sinfo->_in_epoll) {
+    struct epoll_event event;
+    event.events = EPOLLIN | EPOLLET | EPOLLONESHOT;
+    event.data.ptr = sinfo;
+    epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, sinfo->get_socket()->GetSocket(),
+              &event);
+  }
+}
+#endif  // IS_LINUX
@@ -18,6 +18,7 @@
 #include "pandabase.h"
 
 #include "connection.h"
+#include "netAddress.h"
 
 #include "pointerTo.h"
 #include "pmutex.h"
@@ -26,6 +27,11 @@
 #include "pset.h"
 #include "socket_fdset.h"
 #include "atomicAdjust.h"
+#include "pta_uchar.h"
+
+#ifdef IS_LINUX
+#include <sys/epoll.h>
+#endif
 
 class NetDatagram;
 class ConnectionManager;
@@ -79,6 +85,7 @@ PUBLISHED:
 
   ConnectionManager *get_manager() const;
   INLINE bool is_polling() const;
+  INLINE bool is_using_epoll() const;
   int get_num_threads() const;
 
   void set_raw_mode(bool mode);
@@ -102,6 +109,17 @@ protected:
     PT(Connection) _connection;
     bool _busy;
     bool _error;
+    bool _in_epoll;
+
+    // The address of the other end of a TCP connection, which is
+    // stamped on every datagram received from it.
+    NetAddress _peer_address;
+
+    // The buffers the next UDP datagrams will be read into.  Those
+    // that are filled are handed on with their datagrams, and
+    // replaced the next time.
+    typedef pvector<PTA_uchar> UDPBuffers;
+    UDPBuffers _udp_buffers;
   };
   typedef pvector<SocketInfo *> Sockets;
 
@@ -114,6 +132,8 @@ protected:
   virtual bool process_raw_incoming_udp_data(SocketInfo *sinfo);
   virtual bool process_raw_incoming_tcp_data(SocketInfo *sinfo);
 
+  PTA_uchar get_receive_buffer(size_t size);
+
 protected:
   ConnectionManager *_manager;
 
@@ -133,8 +153,17 @@ private:
                                         int current_thread_index);
 
   void rebuild_select_list();
+  void delete_removed_sockets();
   void accumulate_fdset(Socket_fdset &fdset);
 
+#ifdef IS_LINUX
+  SocketInfo *get_next_epoll_socket(bool allow_block,
+                                    int current_thread_index);
+  void epoll_add(SocketInfo *sinfo);
+  void epoll_remove(SocketInfo *sinfo);
+  void epoll_rearm(SocketInfo *sinfo);
+#endif
+
 private:
   bool _raw_mode;
   int _tcp_header_size;
@@ -164,6 +193,28 @@ private:
   // read a socket.
   Mutex _select_mutex;
 
+#ifdef IS_LINUX
+  // If this is not -1, we wait on this epoll instance instead of on
+  // _fdset; see net-use-epoll.  If _epoll_one_shot is true, each
+  // socket is registered one-shot, so that it is reported to only one
+  // thread, and it is armed again by finish_socket().  _epoll_events
+  // holds the results of the last epoll_wait(), of which _num_results
+  // were filled in and _next_index have been handed out.
+  int _epoll_fd;
+  bool _epoll_one_shot;
+  typedef pvector<struct epoll_event> EpollEvents;
+  EpollEvents _epoll_events;
+#endif
+
+  // The buffers that received datagrams are read into; see
+  // get_receive_buffer().  A buffer whose only reference is the one
+  // held here is free to be used again.
+  typedef pvector<PTA_uchar> ReceiveBuffers;
+  ReceiveBuffers _receive_buffers;
+  size_t _next_receive_buffer;
+  int _max_receive_buffers;
+  LightMutex _receive_buffers_mutex;
+
   // This is atomically updated with the index (in _threads) of the
   // thread that is currently waiting on the PR_Poll() call.  It
   // contains -1 if no thread is so waiting.
@@ -20,6 +20,7 @@
 #include "socket_udp.h"
 #include "pnotify.h"
 #include "config_downloader.h"
+#include "pmap.h"
 
 ////////////////////////////////////////////////////////////////////
 //     Function: ConnectionWriter::WriterThread::Constructor
@@ -77,6 +78,9 @@ ConnectionWriter(ConnectionManager *manager, int num_threads,
   _tcp_header_size = tcp_header_size;
   _immediate = (num_threads <= 0);
   _shutdown = false;
+  _batch_window = net_write_batch_window;
+  _num_datagrams_written = 0;
+  _num_writes = 0;
 
   string writer_thread_name = thread_name;
   if (thread_name.empty()) {
@@ -172,6 +176,8 @@ send(const Datagram &datagram, const PT(Connection) &connection, bool block) {
   copy.set_connection(connection);
 
   if (_immediate) {
+    AtomicAdjust::inc(_num_datagrams_written);
+    AtomicAdjust::inc(_num_writes);
     if (_raw_mode) {
       return connection->send_raw_datagram(copy);
     } else {
@@ -222,6 +228,8 @@ send(const Datagram &datagram, const PT(Connection) &connection,
   copy.set_address(address);
 
   if (_immediate) {
+    AtomicAdjust::inc(_num_datagrams_written);
+    AtomicAdjust::inc(_num_writes);
     if (_raw_mode) {
       return connection->send_raw_datagram(copy);
     } else {
@@ -331,6 +339,67 @@ get_tcp_header_size() const {
   return _tcp_header_size;
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: ConnectionWriter::set_batch_window
+//       Access: Published
+//  Description: Specifies the time, in seconds, that each thread
+//               waits for more datagrams to be queued before it
+//               writes the ones it has.  All of the datagrams a
+//               thread takes from the queue for the same TCP
+//               connection are written with one system call, so a
+//               longer window means fewer, larger writes, at the cost
+//               of holding each datagram up to that much longer.
+//
+//               If this is 0, the default, each thread writes
+//               whatever has accumulated in the queue while it was
+//               writing the last batch, without waiting.  This only
+//               has an effect when using threads.  See also
+//               net-max-write-batch.
+////////////////////////////////////////////////////////////////////
+void ConnectionWriter::
+set_batch_window(double window) {
+  _batch_window = window;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: ConnectionWriter::get_batch_window
+//       Access: Published
+//  Description: Returns the time the threads wait for more datagrams
+//               to write.  See set_batch_window().
+////////////////////////////////////////////////////////////////////
+double ConnectionWriter::
+get_batch_window() const {
+  return _batch_window;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: ConnectionWriter::get_num_datagrams_written
+//       Access: Published
+//  Description: Returns the total number of datagrams that have been
+//               written to their sockets by this ConnectionWriter.
+//               Divided by get_num_writes(), this gives the average
+//               number of datagrams per write.
+////////////////////////////////////////////////////////////////////
+PN_uint64 ConnectionWriter::
+get_num_datagrams_written() const {
+  return (PN_uint64)AtomicAdjust::get(_num_datagrams_written);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: ConnectionWriter::get_num_writes
+//       Access: Published
+//  Description: Returns the total number of writes this
+//               ConnectionWriter has made to its sockets, each of
+//               which delivered one or more datagrams.  (If
+//               Connection::set_collect_tcp() is in effect, the
+//               Connection may in turn combine several of these
+//               writes into one.)
+////////////////////////////////////////////////////////////////////
+PN_uint64 ConnectionWriter::
+get_num_writes() const {
+  return (PN_uint64)AtomicAdjust::get(_num_writes);
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: ConnectionWriter::shutdown
 //       Access: Published
@@ -383,13 +452,72 @@ void ConnectionWriter::
 thread_run(int thread_index) {
   nassertv(!_immediate);
 
-  NetDatagram datagram;
-  while (_queue.extract(datagram)) {
-    if (_raw_mode) {
-      datagram.get_connection()->send_raw_datagram(datagram);
+  DatagramQueue::Datagrams batch;
+  while (_queue.extract_batch(batch, max((int)net_max_write_batch, 1),
+                              _batch_window)) {
+    write_batch(batch);
+    batch.clear();
+    Thread::consider_yield();
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: ConnectionWriter::write_batch
+//       Access: Private
+//  Description: Writes a batch of datagrams taken from the queue.
+//               The datagrams for each connection are written
+//               together, in the order they were queued: with one
+//               system call for a TCP connection, or with as few as
+//               the platform allows for UDP.
+////////////////////////////////////////////////////////////////////
+void ConnectionWriter::
+write_batch(const DatagramQueue::Datagrams &batch) {
+  typedef pvector<const NetDatagram *> Pointers;
+  typedef pmap<Connection *, Pointers> Groups;
+  Groups groups;
+  pvector<Connection *> order;
+
+  DatagramQueue::Datagrams::const_iterator di;
+  for (di = batch.begin(); di != batch.end(); ++di) {
+    const NetDatagram &datagram = (*di);
+    Connection *connection = datagram.get_connection();
+    Pointers &group = groups[connection];
+    if (group.empty()) {
+      order.push_back(connection);
+    }
+    group.push_back(&datagram);
+  }
+
+  int tcp_header_size = _raw_mode ? 0 : _tcp_header_size;
+  pvector<Connection *>::const_iterator ci;
+  for (ci = order.begin(); ci != order.end(); ++ci) {
+    Connection *connection = (*ci);
+    const Pointers &group = groups[connection];
+    int num_datagrams = (int)group.size();
+    AtomicAdjust::add(_num_datagrams_written, num_datagrams);
+
+    if (connection->get_socket()->is_exact_type(Socket_UDP::get_class_type())) {
+#ifdef HAVE_MMSG
+      AtomicAdjust::add(_num_writes, (num_datagrams + MMSG_BATCH_SIZE - 1) / MMSG_BATCH_SIZE);
+#else
+      AtomicAdjust::add(_num_writes, num_datagrams);
+#endif
+      connection->send_udp_datagrams(&group[0], num_datagrams, _raw_mode);
+
+    } else if (connection->get_socket()->is_exact_type(Socket_TCP::get_class_type())) {
+      AtomicAdjust::inc(_num_writes);
+      connection->send_datagrams(&group[0], num_datagrams, tcp_header_size);
+
     } else {
-      datagram.get_connection()->send_datagram(datagram, _tcp_header_size);
+      AtomicAdjust::add(_num_writes, num_datagrams);
+      Pointers::const_iterator pi;
+      for (pi = group.begin(); pi != group.end(); ++pi) {
+        if (_raw_mode) {
+          connection->send_raw_datagram(*(*pi));
+        } else {
+          connection->send_datagram(*(*pi), _tcp_header_size);
+        }
+      }
     }
-    Thread::consider_yield();
   }
 }
@@ -21,6 +21,7 @@
 #include "pointerTo.h"
 #include "thread.h"
 #include "pvector.h"
+#include "atomicAdjust.h"
 
 class ConnectionManager;
 class NetAddress;
@@ -66,6 +67,12 @@ PUBLISHED:
   void set_tcp_header_size(int tcp_header_size);
   int get_tcp_header_size() const;
 
+  void set_batch_window(double window);
+  double get_batch_window() const;
+
+  PN_uint64 get_num_datagrams_written() const;
+  PN_uint64 get_num_writes() const;
+
   void shutdown();
 
 protected:
@@ -74,6 +81,7 @@ protected:
 private:
   void thread_run(int thread_index);
   bool send_datagram(const NetDatagram &datagram);
+  void write_batch(const DatagramQueue::Datagrams &batch);
 
 protected:
   ConnectionManager *_manager;
@@ -83,6 +91,10 @@ private:
   int _tcp_header_size;
   DatagramQueue _queue;
   bool _shutdown;
+  double _batch_window;
+
+  AtomicAdjust::Integer _num_datagrams_written;
+  AtomicAdjust::Integer _num_writes;
 
   class WriterThread : public Thread {
   public:
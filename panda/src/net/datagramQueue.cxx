@@ -15,6 +15,7 @@
 #include "datagramQueue.h"
 #include "config_net.h"
 #include "mutexHolder.h"
+#include "trueClock.h"
 
 ////////////////////////////////////////////////////////////////////
 //     Function: DatagramQueue::Constructor
@@ -141,6 +142,57 @@ extract(NetDatagram &result) {
   return true;
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: DatagramQueue::extract_batch
+//       Access: Public
+//  Description: Extracts up to max_count datagrams from the head of
+//               the queue and appends them to result.  Like
+//               extract(), this blocks until at least one datagram is
+//               available.  Then, if window is greater than zero and
+//               fewer than max_count datagrams are available, it
+//               waits up to window seconds for more to arrive, so
+//               that they may be written together.
+//
+//               The return value is true if any datagrams were
+//               extracted, or false if the queue was destroyed while
+//               waiting.
+////////////////////////////////////////////////////////////////////
+bool DatagramQueue::
+extract_batch(Datagrams &result, int max_count, double window) {
+  MutexHolder holder(_cvlock);
+
+  while (_queue.empty() && !_shutdown) {
+    _cv.wait();
+  }
+
+  if (window > 0.0 && (int)_queue.size() < max_count && !_shutdown) {
+    TrueClock *clock = TrueClock::get_global_ptr();
+    double stop = clock->get_short_time() + window;
+    double remaining = window;
+    while ((int)_queue.size() < max_count && !_shutdown && remaining > 0.0) {
+      _cv.wait(remaining);
+      remaining = stop - clock->get_short_time();
+    }
+  }
+
+  if (_shutdown) {
+    return false;
+  }
+
+  nassertr(!_queue.empty(), false);
+  int count = min((int)_queue.size(), max_count);
+  result.reserve(result.size() + count);
+  for (int i = 0; i < count; ++i) {
+    result.push_back(_queue.front());
+    _queue.pop_front();
+  }
+
+  // Wake up any threads waiting to stuff things into the queue.
+  _cv.notify_all();
+
+  return true;
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: DatagramQueue::set_max_queue_size
 //       Access: Public
@@ -21,6 +21,7 @@
 #include "pmutex.h"
 #include "conditionVarFull.h"
 #include "pdeque.h"
+#include "pvector.h"
 
 ////////////////////////////////////////////////////////////////////
 //       Class : DatagramQueue
@@ -37,6 +38,9 @@ public:
   bool insert(const NetDatagram &data, bool block = false);
   bool extract(NetDatagram &result);
 
+  typedef pvector<NetDatagram> Datagrams;
+  bool extract_batch(Datagrams &result, int max_count, double window);
+
   void set_max_queue_size(int max_size);
   int get_max_queue_size() const;
   int get_current_queue_size() const;
@@ -26,25 +26,31 @@
 //               already-constructed NetDatagram.
 ////////////////////////////////////////////////////////////////////
 DatagramTCPHeader::
-DatagramTCPHeader(const NetDatagram &datagram, int header_size) {
-  const string &str = datagram.get_message();
+DatagramTCPHeader(const NetDatagram &datagram, int header_size) :
+  _header_size(0)
+{
+  size_t length = datagram.get_length();
   switch (header_size) {
   case 0:
     break;
 
   case datagram_tcp16_header_size:
     {
-      PN_uint16 size = str.length();
-      nassertv(size == str.length());
-      _header.add_uint16(size);
+      PN_uint16 size = length;
+      nassertv(size == length);
+      LittleEndian s(&size, sizeof(size));
+      memcpy(_header, s.get_data(), sizeof(size));
+      _header_size = sizeof(size);
     }
     break;
 
   case datagram_tcp32_header_size:
     {
-      PN_uint32 size = str.length();
-      nassertv(size == str.length());
-      _header.add_uint32(size);
+      PN_uint32 size = length;
+      nassertv(size == length);
+      LittleEndian s(&size, sizeof(size));
+      memcpy(_header, s.get_data(), sizeof(size));
+      _header_size = sizeof(size);
     }
     break;
 
@@ -52,7 +58,7 @@ DatagramTCPHeader(const NetDatagram &datagram, int header_size) {
     nassertv(false);
   }
 
-  nassertv((int)_header.get_length() == header_size);
+  nassertv(_header_size == header_size);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -63,9 +69,12 @@ DatagramTCPHeader(const NetDatagram &datagram, int header_size) {
 //               just read from a socket.
 ////////////////////////////////////////////////////////////////////
 DatagramTCPHeader::
-DatagramTCPHeader(const void *data, int header_size) : 
-  _header(data, header_size) 
+DatagramTCPHeader(const void *data, int header_size) :
+  _header_size(0)
 {
+  nassertv(header_size >= 0 && header_size <= (int)sizeof(_header));
+  memcpy(_header, data, header_size);
+  _header_size = header_size;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -76,16 +85,26 @@ DatagramTCPHeader(const void *data, int header_size) :
 ////////////////////////////////////////////////////////////////////
 int DatagramTCPHeader::
 get_datagram_size(int header_size) const {
-  DatagramIterator di(_header);
+  nassertr(header_size <= _header_size, -1);
   switch (header_size) {
   case 0:
     return 0;
 
   case datagram_tcp16_header_size:
-    return di.get_uint16();
+    {
+      PN_uint16 size;
+      LittleEndian s(_header, sizeof(size));
+      s.store_value(&size, sizeof(size));
+      return size;
+    }
 
   case datagram_tcp32_header_size:
-    return di.get_uint32();
+    {
+      PN_uint32 size;
+      LittleEndian s(_header, sizeof(size));
+      s.store_value(&size, sizeof(size));
+      return size;
+    }
   }
 
   return -1;
@@ -105,8 +124,7 @@ verify_datagram(const NetDatagram &datagram, int header_size) const {
     return true;
   }
 
-  const string &str = datagram.get_message();
-  int actual_size = str.length();
+  int actual_size = datagram.get_length();
   int expected_size = get_datagram_size(header_size);
   if (actual_size == expected_size) {
     return true;
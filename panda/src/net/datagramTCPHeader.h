@@ -46,10 +46,12 @@ public:
   bool verify_datagram(const NetDatagram &datagram, int header_size) const;
 
 private:
-  // The actual data for the header is stored (somewhat recursively)
-  // in its own NetDatagram object.  This is just for convenience of
-  // packing and unpacking the header.
-  NetDatagram _header;
+  // The header is no more than four bytes, which are stored here as
+  // they appear on the wire.  We used to keep them in a NetDatagram,
+  // but that cost a memory allocation for every datagram sent or
+  // received.
+  unsigned char _header[datagram_tcp32_header_size];
+  int _header_size;
 };
 
 #include "datagramTCPHeader.I"
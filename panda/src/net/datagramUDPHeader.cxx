@@ -27,15 +27,11 @@
 ////////////////////////////////////////////////////////////////////
 DatagramUDPHeader::
 DatagramUDPHeader(const NetDatagram &datagram) {
-  const string &str = datagram.get_message();
-  PN_uint16 checksum = 0;
-  for (size_t p = 0; p < str.size(); p++) {
-    checksum += (PN_uint16)(PN_uint8)str[p];
-  }
+  PN_uint16 checksum = compute_checksum(datagram);
 
   // Now pack the header.
-  _header.add_uint16(checksum);
-  nassertv((int)_header.get_length() == datagram_udp_header_size);
+  LittleEndian s(&checksum, sizeof(checksum));
+  memcpy(_header, s.get_data(), sizeof(checksum));
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -46,7 +42,8 @@ DatagramUDPHeader(const NetDatagram &datagram) {
 //               just read from a socket.
 ////////////////////////////////////////////////////////////////////
 DatagramUDPHeader::
-DatagramUDPHeader(const void *data) : _header(data, datagram_udp_header_size) {
+DatagramUDPHeader(const void *data) {
+  memcpy(_header, data, datagram_udp_header_size);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -58,12 +55,7 @@ DatagramUDPHeader(const void *data) : _header(data, datagram_udp_header_size) {
 ////////////////////////////////////////////////////////////////////
 bool DatagramUDPHeader::
 verify_datagram(const NetDatagram &datagram) const {
-  const string &str = datagram.get_message();
-
-  PN_uint16 checksum = 0;
-  for (size_t p = 0; p < str.size(); p++) {
-    checksum += (PN_uint16)(PN_uint8)str[p];
-  }
+  PN_uint16 checksum = compute_checksum(datagram);
 
   if (checksum == get_datagram_checksum()) {
     return true;
@@ -89,3 +81,21 @@ verify_datagram(const NetDatagram &datagram) const {
 
   return false;
 }
+
+////////////////////////////////////////////////////////////////////
+//     Function: DatagramUDPHeader::compute_checksum
+//       Access: Private, Static
+//  Description: Returns the checksum of the bytes of the datagram,
+//               which is simply their sum.
+////////////////////////////////////////////////////////////////////
+PN_uint16 DatagramUDPHeader::
+compute_checksum(const NetDatagram &datagram) {
+  const PN_uint8 *data = (const PN_uint8 *)datagram.get_data();
+  size_t length = datagram.get_length();
+
+  PN_uint16 checksum = 0;
+  for (size_t p = 0; p < length; p++) {
+    checksum += (PN_uint16)data[p];
+  }
+  return checksum;
+}
@@ -45,10 +45,11 @@ public:
   bool verify_datagram(const NetDatagram &datagram) const;
 
 private:
-  // The actual data for the header is stored (somewhat recursively)
-  // in its own NetDatagram object.  This is just for convenience of
-  // packing and unpacking the header.
-  NetDatagram _header;
+  static PN_uint16 compute_checksum(const NetDatagram &datagram);
+
+  // The two bytes of the header, as they appear on the wire.  See
+  // DatagramTCPHeader.
+  unsigned char _header[datagram_udp_header_size];
 };
 
 #include "datagramUDPHeader.I"
@@ -0,0 +1,189 @@
+// Filename: test_receive_alloc.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "pandabase.h"
+
+#include "queuedConnectionManager.h"
+#include "queuedConnectionListener.h"
+#include "queuedConnectionReader.h"
+#include "connectionWriter.h"
+#include "netAddress.h"
+#include "connection.h"
+#include "netDatagram.h"
+#include "datagramIterator.h"
+#include "trueClock.h"
+#include "thread.h"
+#include "atomicAdjust.h"
+#include "load_prc_file.h"
+
+// This program counts the memory allocations made for each TCP
+// datagram received through a QueuedConnectionReader, from the
+// socket to the application, and times them.  It sends itself a
+// burst of datagrams, waits for them to arrive, and then receives
+// and reads each one in turn, as CConnectionRepository does.
+//
+// Usage: test_receive_alloc [-n] port [datagrams [bytes]]
+//
+// -n disables the pool of receive buffers (see
+// net-receive-buffer-pool-size).  Allocations can only be counted
+// with the GNU C library.
+
+static const int num_rounds = 10;
+
+static AtomicAdjust::Integer num_allocations = 0;
+
+#ifdef __GLIBC__
+// We count every call to malloc(), through which all of Panda's
+// allocations eventually go.
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t num, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+
+extern "C" void *
+malloc(size_t size) {
+  AtomicAdjust::inc(num_allocations);
+  return __libc_malloc(size);
+}
+
+extern "C" void *
+calloc(size_t num, size_t size) {
+  AtomicAdjust::inc(num_allocations);
+  return __libc_calloc(num, size);
+}
+
+extern "C" void *
+realloc(void *ptr, size_t size) {
+  AtomicAdjust::inc(num_allocations);
+  return __libc_realloc(ptr, size);
+}
+#endif  // __GLIBC__
+
+int
+main(int argc, char *argv[]) {
+  int i = 1;
+  if (i < argc && strcmp(argv[i], "-n") == 0) {
+    load_prc_file_data("test_receive_alloc", "net-receive-buffer-pool-size 0");
+    ++i;
+  }
+  if (i >= argc) {
+    nout << "test_receive_alloc [-n] port [datagrams [bytes]]\n";
+    exit(1);
+  }
+
+  int port = atoi(argv[i]);
+  int burst = (i + 1 < argc) ? atoi(argv[i + 1]) : 200;
+  int num_bytes = (i + 2 < argc) ? atoi(argv[i + 2]) : 64;
+  num_bytes = max(num_bytes, 4);
+
+  QueuedConnectionManager cm;
+  PT(Connection) rendezvous = cm.open_TCP_server_rendezvous(port, 5);
+  if (rendezvous.is_null()) {
+    nout << "Cannot grab port " << port << ".\n";
+    exit(1);
+  }
+
+  QueuedConnectionListener listener(&cm, 0);
+  listener.add_connection(rendezvous);
+  QueuedConnectionReader reader(&cm, 0);
+  ConnectionWriter writer(&cm, 0);
+
+  NetAddress host;
+  host.set_localhost(port);
+  PT(Connection) client = cm.open_TCP_client_connection(host, 5000);
+  if (client.is_null()) {
+    nout << "Unable to connect.\n";
+    exit(1);
+  }
+
+  PT(Connection) server;
+  while (server.is_null()) {
+    PT(Connection) rv;
+    NetAddress address;
+    if (listener.new_connection_available()) {
+      listener.get_new_connection(rv, address, server);
+    } else {
+      Thread::sleep(0.001);
+    }
+  }
+  reader.add_connection(server);
+
+  TrueClock *clock = TrueClock::get_global_ptr();
+
+  PN_uint32 next_send = 0;
+  PN_uint32 next_receive = 0;
+  int steady_allocations = 0;
+  double steady_time = 0.0;
+
+  for (int round = 0; round < num_rounds; ++round) {
+    for (int n = 0; n < burst; ++n) {
+      NetDatagram datagram;
+      datagram.add_uint32(next_send);
+      for (int b = 4; b < num_bytes; ++b) {
+        datagram.add_uint8((PN_uint8)(next_send + b));
+      }
+      writer.send(datagram, client);
+      ++next_send;
+    }
+
+    // Give the datagrams a moment to arrive, so that we time only the
+    // receiving of them.
+    Thread::sleep(0.05);
+
+    int allocations_before = AtomicAdjust::get(num_allocations);
+    double start = clock->get_short_time();
+
+    int num_received = 0;
+    while (num_received < burst) {
+      if (!reader.data_available()) {
+        continue;
+      }
+      NetDatagram datagram;
+      if (!reader.get_data(datagram)) {
+        continue;
+      }
+      ++num_received;
+
+      DatagramIterator scan(datagram);
+      PN_uint32 seq = scan.get_uint32();
+      bool ok = (seq == next_receive &&
+                 (int)datagram.get_length() == num_bytes);
+      for (int b = 4; ok && b < num_bytes; ++b) {
+        ok = (scan.get_uint8() == (PN_uint8)(seq + b));
+      }
+      if (!ok) {
+        nout << "Datagram " << next_receive << " arrived corrupted.\n";
+        exit(1);
+      }
+      ++next_receive;
+    }
+
+    double elapsed = clock->get_short_time() - start;
+    int allocations = AtomicAdjust::get(num_allocations) - allocations_before;
+    if (round != 0) {
+      steady_allocations += allocations;
+      steady_time += elapsed;
+    }
+
+    nout << "round " << round << ": "
+         << (double)allocations / burst << " allocations, "
+         << elapsed * 1000000.0 / burst << " us per datagram\n";
+  }
+
+  int steady_datagrams = burst * (num_rounds - 1);
+  nout << "after the first round: "
+       << (double)steady_allocations / steady_datagrams << " allocations, "
+       << steady_time * 1000000.0 / steady_datagrams << " us per datagram\n";
+
+  return 0;
+}
@@ -0,0 +1,213 @@
+// Filename: test_spam_load.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "pandabase.h"
+
+#include "queuedConnectionManager.h"
+#include "queuedConnectionListener.h"
+#include "queuedConnectionReader.h"
+#include "connectionWriter.h"
+#include "netAddress.h"
+#include "connection.h"
+#include "netDatagram.h"
+#include "trueClock.h"
+#include "thread.h"
+#include "load_prc_file.h"
+#include "pvector.h"
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+// This program measures how many datagrams per second a
+// QueuedConnectionReader can take in, as a function of the number of
+// connections it is reading.  Like test_spam_server and
+// test_spam_client, but both ends are in the one process: it opens
+// the indicated numbers of TCP connections to itself in turn, and
+// for each number, spams the server end from every client end for a
+// few seconds.
+//
+// Usage: test_spam_load [-s] [-t threads] port [connections ...]
+//
+// -s reads the sockets with select() instead of epoll (see
+// net-use-epoll); select() cannot handle more than FD_SETSIZE
+// sockets.  Each connection takes two file descriptors, so the
+// process limit on open files may need raising for the larger
+// counts.
+
+static const double test_time = 3.0;
+
+// We stop sending while this many datagrams are on their way, so as
+// not to overflow the reader's queue.
+static const int max_in_flight = 10000;
+
+////////////////////////////////////////////////////////////////////
+//     Function: raise_file_limit
+//  Description: Raises the limit on open files as far as we are
+//               allowed to.
+////////////////////////////////////////////////////////////////////
+static void
+raise_file_limit() {
+#ifndef _WIN32
+  struct rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) == 0 &&
+      limit.rlim_cur < limit.rlim_max) {
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+#endif
+}
+
+int
+main(int argc, char *argv[]) {
+  int num_threads = 1;
+  int i = 1;
+  while (i < argc && argv[i][0] == '-') {
+    if (strcmp(argv[i], "-s") == 0) {
+      load_prc_file_data("test_spam_load", "net-use-epoll 0");
+      ++i;
+    } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+      num_threads = atoi(argv[i + 1]);
+      i += 2;
+    } else {
+      break;
+    }
+  }
+  if (i >= argc) {
+    nout << "test_spam_load [-s] [-t threads] port [connections ...]\n";
+    exit(1);
+  }
+
+  int port = atoi(argv[i]);
+  ++i;
+
+  pvector<int> counts;
+  for (; i < argc; ++i) {
+    counts.push_back(atoi(argv[i]));
+  }
+  if (counts.empty()) {
+    counts.push_back(10);
+    counts.push_back(100);
+    counts.push_back(500);
+    counts.push_back(1000);
+    counts.push_back(2000);
+    counts.push_back(5000);
+  }
+
+  raise_file_limit();
+
+  QueuedConnectionManager cm;
+  PT(Connection) rendezvous = cm.open_TCP_server_rendezvous(port, 1024);
+  if (rendezvous.is_null()) {
+    nout << "Cannot grab port " << port << ".\n";
+    exit(1);
+  }
+
+  QueuedConnectionListener listener(&cm, 1);
+  listener.add_connection(rendezvous);
+
+  QueuedConnectionReader reader(&cm, num_threads);
+  ConnectionWriter writer(&cm, 0);
+
+  nout << "Reading with " << num_threads << " threads, using "
+       << (reader.is_using_epoll() ? "epoll" : "select()") << "\n";
+
+  NetAddress host;
+  host.set_localhost(port);
+
+  typedef pvector< PT(Connection) > Connections;
+  Connections clients;
+  int num_accepted = 0;
+
+  NetDatagram datagram;
+  datagram.add_string("This is a spam datagram of moderate size.");
+
+  TrueClock *clock = TrueClock::get_global_ptr();
+
+  pvector<int>::const_iterator ci;
+  for (ci = counts.begin(); ci != counts.end(); ++ci) {
+    int count = (*ci);
+
+    // Open more connections, and wait for the server end of each.
+    while ((int)clients.size() < count) {
+      PT(Connection) c = cm.open_TCP_client_connection(host, 5000);
+      if (c.is_null()) {
+        nout << "Could only open " << clients.size() << " connections.\n";
+        return 1;
+      }
+      clients.push_back(c);
+    }
+    while (num_accepted < count) {
+      PT(Connection) rv;
+      NetAddress address;
+      PT(Connection) new_connection;
+      if (listener.new_connection_available() &&
+          listener.get_new_connection(rv, address, new_connection)) {
+        reader.add_connection(new_connection);
+        ++num_accepted;
+      } else {
+        Thread::sleep(0.001);
+      }
+    }
+
+    // Drain anything left over from the previous count.
+    while (reader.data_available()) {
+      NetDatagram received;
+      reader.get_data(received);
+    }
+
+    int num_sent = 0;
+    int num_received = 0;
+    double start = clock->get_short_time();
+    double now = start;
+    while (now - start < test_time) {
+      Connections::const_iterator wi;
+      for (wi = clients.begin();
+           wi != clients.end() && num_sent - num_received < max_in_flight;
+           ++wi) {
+        if (writer.send(datagram, (*wi))) {
+          ++num_sent;
+        }
+      }
+
+      while (reader.data_available()) {
+        NetDatagram received;
+        if (reader.get_data(received)) {
+          ++num_received;
+        }
+      }
+      now = clock->get_short_time();
+    }
+
+    // Collect the stragglers that were sent during the test.
+    double stop = now + 1.0;
+    while (num_received < num_sent && now < stop) {
+      while (reader.data_available()) {
+        NetDatagram received;
+        if (reader.get_data(received)) {
+          ++num_received;
+        }
+      }
+      Thread::sleep(0.001);
+      now = clock->get_short_time();
+    }
+
+    double elapsed = now - start;
+    nout << count << " connections: sent " << num_sent << ", received "
+         << num_received << " in " << elapsed << " s, "
+         << (int)(num_received / elapsed) << " datagrams/s\n";
+  }
+
+  return 0;
+}
@@ -0,0 +1,123 @@
+// Filename: test_udp_batch.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "pandabase.h"
+
+#include "queuedConnectionManager.h"
+#include "queuedConnectionReader.h"
+#include "connectionWriter.h"
+#include "netAddress.h"
+#include "connection.h"
+#include "netDatagram.h"
+#include "datagramIterator.h"
+#include "trueClock.h"
+#include "thread.h"
+#include "load_prc_file.h"
+
+// This program times sending and receiving bursts of UDP datagrams
+// through the loopback interface.  The datagrams are sent by a
+// threaded ConnectionWriter, which writes each burst in batches (with
+// sendmmsg() on Linux), and read by a polling QueuedConnectionReader,
+// which reads up to net-udp-read-batch at once (with recvmmsg()).
+//
+// Usage: test_udp_batch [-n] port [datagrams [bytes]]
+//
+// -n writes and reads one datagram per system call instead, for
+// comparison.  Each burst must fit in the socket's receive buffer, or
+// some of it will be dropped.
+
+static const int num_bursts = 500;
+
+int
+main(int argc, char *argv[]) {
+  bool batch = true;
+  int i = 1;
+  if (i < argc && strcmp(argv[i], "-n") == 0) {
+    load_prc_file_data("test_udp_batch",
+                       "net-udp-read-batch 1\n"
+                       "net-max-write-batch 1\n");
+    batch = false;
+    ++i;
+  }
+  if (i >= argc) {
+    nout << "test_udp_batch [-n] port [datagrams [bytes]]\n";
+    exit(1);
+  }
+
+  int port = atoi(argv[i]);
+  int burst = (i + 1 < argc) ? atoi(argv[i + 1]) : 100;
+  int num_bytes = (i + 2 < argc) ? atoi(argv[i + 2]) : 64;
+  num_bytes = max(num_bytes, 4);
+
+  QueuedConnectionManager cm;
+  PT(Connection) server = cm.open_UDP_connection(port);
+  PT(Connection) client = cm.open_UDP_connection();
+  if (server.is_null() || client.is_null()) {
+    nout << "Cannot open UDP port " << port << ".\n";
+    exit(1);
+  }
+
+  QueuedConnectionReader reader(&cm, 0);
+  reader.add_connection(server);
+
+  ConnectionWriter writer(&cm, 1);
+
+  NetAddress host;
+  host.set_localhost(port);
+
+  TrueClock *clock = TrueClock::get_global_ptr();
+
+  int num_sent = 0;
+  int num_received = 0;
+  double send_time = 0.0;
+  double receive_time = 0.0;
+
+  for (int b = 0; b < num_bursts; ++b) {
+    double start = clock->get_short_time();
+    PN_uint64 target = writer.get_num_datagrams_written() + burst;
+    for (int n = 0; n < burst; ++n) {
+      NetDatagram datagram;
+      datagram.add_uint32(num_sent);
+      datagram.pad_bytes(num_bytes - 4);
+      writer.send(datagram, client, host, true);
+      ++num_sent;
+    }
+    while (writer.get_num_datagrams_written() < target) {
+      Thread::force_yield();
+    }
+    send_time += clock->get_short_time() - start;
+
+    // Wait for the burst to arrive, then time reading it.
+    Thread::sleep(0.002);
+
+    start = clock->get_short_time();
+    while (reader.data_available()) {
+      NetDatagram datagram;
+      if (reader.get_data(datagram)) {
+        ++num_received;
+      }
+    }
+    receive_time += clock->get_short_time() - start;
+  }
+
+  nout << (batch ? "batched" : "unbatched") << ": "
+       << num_sent << " datagrams of " << num_bytes << " bytes in bursts of "
+       << burst << ", " << num_sent - num_received << " lost\n"
+       << "  send " << send_time * 1000000.0 / num_sent
+       << " us per datagram, receive "
+       << receive_time * 1000000.0 / max(num_received, 1)
+       << " us per datagram\n";
+
+  return 0;
+}
@@ -0,0 +1,173 @@
+// Filename: test_write_batch.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "pandabase.h"
+
+#include "queuedConnectionManager.h"
+#include "queuedConnectionListener.h"
+#include "queuedConnectionReader.h"
+#include "connectionWriter.h"
+#include "netAddress.h"
+#include "connection.h"
+#include "netDatagram.h"
+#include "datagramIterator.h"
+#include "trueClock.h"
+#include "thread.h"
+#include "pvector.h"
+
+// This program measures the latency and throughput of a threaded
+// ConnectionWriter fanning out many small datagrams to many TCP
+// connections, for each of several batch windows (see
+// ConnectionWriter::set_batch_window()).  Each frame, it queues a few
+// time-stamped datagrams for each connection in turn, much as a
+// server sends a burst of state updates to each of its clients; the other end of each
+// connection is read in the same process, which reports how long
+// each datagram took to arrive.
+//
+// Usage: test_write_batch port [connections [per-frame [window ...]]]
+
+static const double test_time = 3.0;
+static const double frame_time = 0.01;
+static const int max_in_flight = 10000;
+
+int
+main(int argc, char *argv[]) {
+  if (argc < 2) {
+    nout << "test_write_batch port [connections [per-frame [window ...]]]\n";
+    exit(1);
+  }
+
+  int port = atoi(argv[1]);
+  int num_connections = (argc > 2) ? atoi(argv[2]) : 100;
+  int per_frame = (argc > 3) ? atoi(argv[3]) : 4;
+
+  pvector<double> windows;
+  for (int i = 4; i < argc; ++i) {
+    windows.push_back(atof(argv[i]));
+  }
+  if (windows.empty()) {
+    windows.push_back(0.0);
+    windows.push_back(0.0005);
+    windows.push_back(0.002);
+    windows.push_back(0.005);
+  }
+
+  QueuedConnectionManager cm;
+  PT(Connection) rendezvous = cm.open_TCP_server_rendezvous(port, 1024);
+  if (rendezvous.is_null()) {
+    nout << "Cannot grab port " << port << ".\n";
+    exit(1);
+  }
+
+  QueuedConnectionListener listener(&cm, 1);
+  listener.add_connection(rendezvous);
+  QueuedConnectionReader reader(&cm, 0);
+  ConnectionWriter writer(&cm, 1);
+
+  NetAddress host;
+  host.set_localhost(port);
+
+  typedef pvector< PT(Connection) > Connections;
+  Connections clients;
+  while ((int)clients.size() < num_connections) {
+    PT(Connection) c = cm.open_TCP_client_connection(host, 5000);
+    if (c.is_null()) {
+      nout << "Could only open " << clients.size() << " connections.\n";
+      return 1;
+    }
+    clients.push_back(c);
+  }
+  int num_accepted = 0;
+  while (num_accepted < num_connections) {
+    PT(Connection) rv;
+    NetAddress address;
+    PT(Connection) new_connection;
+    if (listener.new_connection_available() &&
+        listener.get_new_connection(rv, address, new_connection)) {
+      reader.add_connection(new_connection);
+      ++num_accepted;
+    } else {
+      Thread::sleep(0.001);
+    }
+  }
+
+  nout << num_connections << " connections, " << per_frame
+       << " datagrams per connection every " << frame_time * 1000.0
+       << " ms\n";
+
+  TrueClock *clock = TrueClock::get_global_ptr();
+
+  pvector<double>::const_iterator wi;
+  for (wi = windows.begin(); wi != windows.end(); ++wi) {
+    writer.set_batch_window(*wi);
+    PN_uint64 datagrams_before = writer.get_num_datagrams_written();
+    PN_uint64 writes_before = writer.get_num_writes();
+
+    int num_sent = 0;
+    int num_received = 0;
+    double total_latency = 0.0;
+    double max_latency = 0.0;
+
+    double start = clock->get_short_time();
+    double now = start;
+    double next_frame = start;
+    while (now - start < test_time || num_received < num_sent) {
+      if (now >= next_frame && now - start < test_time) {
+        next_frame += frame_time;
+        Connections::const_iterator ci;
+        for (ci = clients.begin();
+             ci != clients.end() && num_sent - num_received < max_in_flight;
+             ++ci) {
+          for (int f = 0; f < per_frame; ++f) {
+            NetDatagram datagram;
+            datagram.add_float64(clock->get_short_time());
+            datagram.add_uint32(num_sent);
+            if (writer.send(datagram, (*ci))) {
+              ++num_sent;
+            }
+          }
+        }
+      }
+
+      while (reader.data_available()) {
+        NetDatagram received;
+        if (reader.get_data(received)) {
+          DatagramIterator scan(received);
+          double latency = clock->get_short_time() - scan.get_float64();
+          total_latency += latency;
+          max_latency = max(max_latency, latency);
+          ++num_received;
+        }
+      }
+      Thread::sleep(0.0001);
+      now = clock->get_short_time();
+      if (now - start > test_time + 5.0) {
+        nout << "Gave up waiting for " << num_sent - num_received
+             << " datagrams.\n";
+        break;
+      }
+    }
+
+    PN_uint64 datagrams = writer.get_num_datagrams_written() - datagrams_before;
+    PN_uint64 writes = writer.get_num_writes() - writes_before;
+    double elapsed = now - start;
+    nout << "window " << *wi * 1000.0 << " ms: "
+         << (int)(num_received / elapsed) << " datagrams/s, "
+         << "latency mean " << total_latency * 1000.0 / max(num_received, 1)
+         << " ms, max " << max_latency * 1000.0 << " ms, "
+         << (double)datagrams / max(writes, (PN_uint64)1) << " datagrams per write\n";
+  }
+
+  return 0;
+}
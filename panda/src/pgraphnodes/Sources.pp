@@ -18,6 +18,7 @@
     config_pgraphnodes.h \
     directionalLight.h directionalLight.I \
     fadeLodNode.I fadeLodNode.h fadeLodNodeData.h \
+    instancedNode.h instancedNode.I \
     lightLensNode.h lightLensNode.I \
     lightNode.h lightNode.I \
     lodNode.I lodNode.h lodNodeType.h \
@@ -38,6 +39,7 @@
     config_pgraphnodes.cxx \
     directionalLight.cxx \
     fadeLodNode.cxx fadeLodNodeData.cxx \
+    instancedNode.cxx \
     lightLensNode.cxx \
     lightNode.cxx \
     lodNode.cxx lodNodeType.cxx \
@@ -58,6 +60,7 @@
     config_pgraphnodes.h \
     directionalLight.h directionalLight.I \
     fadeLodNode.I fadeLodNode.h fadeLodNodeData.h \
+    instancedNode.h instancedNode.I \
     lightLensNode.h lightLensNode.I \
     lightNode.h lightNode.I \
     lodNode.I lodNode.h lodNodeType.h \
@@ -74,3 +77,14 @@
   #define IGATESCAN all
 
 #end lib_target
+
+#begin test_bin_target
+  #define TARGET test_instancedNode
+
+  #define SOURCES \
+    test_instancedNode.cxx
+
+  #define LOCAL_LIBS $[LOCAL_LIBS] p3pgraphnodes p3display
+  #define OTHER_LIBS $[OTHER_LIBS] p3pystub
+
+#end test_bin_target
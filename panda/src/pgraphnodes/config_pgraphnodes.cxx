@@ -22,6 +22,7 @@
 #include "directionalLight.h"
 #include "fadeLodNode.h"
 #include "fadeLodNodeData.h"
+#include "instancedNode.h"
 #include "lightLensNode.h"
 #include "lightNode.h"
 #include "lodNode.h"
@@ -83,6 +84,14 @@ ConfigVariableBool verify_lods
           "actual size of their geometry.  This test is only made in NDEBUG "
           "mode (the variable is ignored in a production build)."));
 
+ConfigVariableBool hardware_instancing
+("hardware-instancing", true,
+ PRC_DESC("When this is true, an InstancedNode that has a shader applied "
+          "will render all of its instances with a single instanced draw "
+          "call per Geom, if the GSG supports it.  Set it false to make "
+          "InstancedNodes always traverse their children once per "
+          "instance instead."));
+
 ConfigVariableInt parallax_mapping_samples
 ("parallax-mapping-samples", 3,
  PRC_DESC("Sets the amount of samples to use in the parallax mapping "
@@ -118,6 +127,7 @@ init_libpgraphnodes() {
   DirectionalLight::init_type();
   FadeLODNode::init_type();
   FadeLODNodeData::init_type();
+  InstancedNode::init_type();
   LightLensNode::init_type();
   LightNode::init_type();
   LODNode::init_type();
@@ -135,6 +145,7 @@ init_libpgraphnodes() {
   ComputeNode::register_with_read_factory();
   DirectionalLight::register_with_read_factory();
   FadeLODNode::register_with_read_factory();
+  InstancedNode::register_with_read_factory();
   LightNode::register_with_read_factory();
   LODNode::register_with_read_factory();
   PointLight::register_with_read_factory();
@@ -37,6 +37,7 @@ extern ConfigVariableString lod_fade_bin_name;
 extern ConfigVariableInt lod_fade_bin_draw_order;
 extern ConfigVariableInt lod_fade_state_override;
 extern ConfigVariableBool verify_lods;
+extern ConfigVariableBool hardware_instancing;
 
 extern ConfigVariableInt parallax_mapping_samples;
 extern ConfigVariableDouble parallax_mapping_scale;
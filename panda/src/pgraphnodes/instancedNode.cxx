@@ -0,0 +1,674 @@
+// Filename: instancedNode.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "instancedNode.h"
+#include "config_pgraphnodes.h"
+#include "cullTraverser.h"
+#include "cullTraverserData.h"
+#include "graphicsStateGuardianBase.h"
+#include "geomNode.h"
+#include "geom.h"
+#include "geomVertexData.h"
+#include "geomVertexFormat.h"
+#include "geomVertexWriter.h"
+#include "shaderAttrib.h"
+#include "renderEffects.h"
+#include "boundingSphere.h"
+#include "bamReader.h"
+#include "bamWriter.h"
+#include "datagram.h"
+#include "datagramIterator.h"
+#include "pStatCollector.h"
+#include "pStatTimer.h"
+
+TypeHandle InstancedNode::_type_handle;
+PT(InternalName) InstancedNode::_instance_matrix_name;
+CPT(GeomVertexArrayFormat) InstancedNode::_instance_array_format;
+
+static PStatCollector instance_array_pcollector("Cull:Instancing:Build array");
+static PStatCollector copy_subgraph_pcollector("Cull:Instancing:Copy subgraph");
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::Constructor
+//       Access: Published
+//  Description:
+////////////////////////////////////////////////////////////////////
+InstancedNode::
+InstancedNode(const string &name) :
+  PandaNode(name),
+  _instance_array_stale(false)
+{
+  set_cull_callback();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::Copy Constructor
+//       Access: Protected
+//  Description: The private copy of the children is not copied; it
+//               will be rebuilt for the new node as needed.
+////////////////////////////////////////////////////////////////////
+InstancedNode::
+InstancedNode(const InstancedNode &copy) :
+  PandaNode(copy),
+  _instance_array_stale(false)
+{
+  LightMutexHolder holder(copy._lock);
+  _instances = copy._instances;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::Destructor
+//       Access: Published, Virtual
+//  Description:
+////////////////////////////////////////////////////////////////////
+InstancedNode::
+~InstancedNode() {
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::add_instance
+//       Access: Published
+//  Description: Adds a new instance of the children, at the indicated
+//               transform relative to this node.  Returns the index
+//               of the new instance.
+////////////////////////////////////////////////////////////////////
+int InstancedNode::
+add_instance(const TransformState *transform) {
+  nassertr(transform != (TransformState *)NULL, -1);
+  int index;
+  {
+    LightMutexHolder holder(_lock);
+    index = (int)_instances.size();
+    _instances.push_back(transform);
+    _instance_array_stale = true;
+  }
+  mark_internal_bounds_stale();
+  return index;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::set_instance
+//       Access: Published
+//  Description: Replaces the transform of the nth instance.
+////////////////////////////////////////////////////////////////////
+void InstancedNode::
+set_instance(int n, const TransformState *transform) {
+  nassertv(transform != (TransformState *)NULL);
+  {
+    LightMutexHolder holder(_lock);
+    nassertv(n >= 0 && n < (int)_instances.size());
+    _instances[n] = transform;
+    _instance_array_stale = true;
+  }
+  mark_internal_bounds_stale();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::remove_instance
+//       Access: Published
+//  Description: Removes the nth instance.  The indices of all
+//               subsequent instances are shifted down by one.
+////////////////////////////////////////////////////////////////////
+void InstancedNode::
+remove_instance(int n) {
+  {
+    LightMutexHolder holder(_lock);
+    nassertv(n >= 0 && n < (int)_instances.size());
+    _instances.erase(_instances.begin() + n);
+    _instance_array_stale = true;
+  }
+  mark_internal_bounds_stale();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::clear_instances
+//       Access: Published
+//  Description: Removes all instances.  Nothing will be rendered
+//               until new instances are added.
+////////////////////////////////////////////////////////////////////
+void InstancedNode::
+clear_instances() {
+  {
+    LightMutexHolder holder(_lock);
+    _instances.clear();
+    _instance_array_stale = true;
+  }
+  mark_internal_bounds_stale();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::get_instance_matrix_name
+//       Access: Published, Static
+//  Description: Returns the name of the vertex column that receives
+//               the per-instance transform matrix, "instance_matrix".
+//               A shader should declare this as a mat4 vertex input.
+////////////////////////////////////////////////////////////////////
+InternalName *InstancedNode::
+get_instance_matrix_name() {
+  if (_instance_matrix_name == (InternalName *)NULL) {
+    _instance_matrix_name = InternalName::make("instance_matrix");
+  }
+  return _instance_matrix_name;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::get_instance_array_format
+//       Access: Published, Static
+//  Description: Returns the format of the per-instance vertex array
+//               that is appended to each Geom when hardware
+//               instancing is in use.  It has a single 4x4 matrix
+//               column and a divisor of 1.
+////////////////////////////////////////////////////////////////////
+const GeomVertexArrayFormat *InstancedNode::
+get_instance_array_format() {
+  if (_instance_array_format == (GeomVertexArrayFormat *)NULL) {
+    PT(GeomVertexArrayFormat) format = new GeomVertexArrayFormat;
+    format->add_column(get_instance_matrix_name(), 4,
+                       Geom::NT_stdfloat, Geom::C_matrix);
+    format->set_divisor(1);
+    _instance_array_format = GeomVertexArrayFormat::register_format(format);
+  }
+  return _instance_array_format;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::make_copy
+//       Access: Public, Virtual
+//  Description: Returns a newly-allocated Node that is a shallow copy
+//               of this one.  It will be a different Node pointer,
+//               but its internal data may or may not be shared with
+//               that of the original Node.
+////////////////////////////////////////////////////////////////////
+PandaNode *InstancedNode::
+make_copy() const {
+  return new InstancedNode(*this);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::safe_to_flatten
+//       Access: Public, Virtual
+//  Description: Returns true if it is generally safe to flatten out
+//               this particular kind of PandaNode by duplicating
+//               instances (by calling dupe_for_flatten()), false
+//               otherwise (for instance, a Camera cannot be safely
+//               flattened, because the Camera pointer itself is
+//               meaningful).
+////////////////////////////////////////////////////////////////////
+bool InstancedNode::
+safe_to_flatten() const {
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::safe_to_combine
+//       Access: Public, Virtual
+//  Description: Returns true if it is generally safe to combine this
+//               particular kind of PandaNode with other kinds of
+//               PandaNodes of compatible type, adding children or
+//               whatever.  For instance, an LODNode should not be
+//               combined with any other PandaNode, because its set
+//               of children is meaningful.
+////////////////////////////////////////////////////////////////////
+bool InstancedNode::
+safe_to_combine() const {
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::safe_to_flatten_below
+//       Access: Public, Virtual
+//  Description: Returns true if a flatten operation may safely
+//               continue past this node, or false if nodes below this
+//               node may not be molested.  The children of an
+//               InstancedNode must keep their own coordinate space,
+//               since each instance transform is relative to it.
+////////////////////////////////////////////////////////////////////
+bool InstancedNode::
+safe_to_flatten_below() const {
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::cull_callback
+//       Access: Public, Virtual
+//  Description: This function will be called during the cull
+//               traversal to perform any additional operations that
+//               should be performed at cull time.  This may include
+//               additional manipulation of render state or additional
+//               visible/invisible decisions, or any other arbitrary
+//               operation.
+//
+//               Note that this function will *not* be called unless
+//               set_cull_callback() is called in the constructor of
+//               the derived class.  It is necessary to call
+//               set_cull_callback() to indicated that we require
+//               cull_callback() to be called.
+//
+//               By the time this function is called, the node has
+//               already passed the bounding-volume test for the
+//               viewing frustum, and the node's transform and state
+//               have already been applied to the indicated
+//               CullTraverserData object.
+//
+//               The return value is true if this node should be
+//               visible, or false if it should be culled.
+////////////////////////////////////////////////////////////////////
+bool InstancedNode::
+cull_callback(CullTraverser *trav, CullTraverserData &data) {
+  if (is_instancing_possible(trav, data)) {
+    cull_instanced(trav, data);
+  } else {
+    cull_individually(trav, data);
+  }
+
+  // We have already traversed the children ourselves.
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::output
+//       Access: Public, Virtual
+//  Description:
+////////////////////////////////////////////////////////////////////
+void InstancedNode::
+output(ostream &out) const {
+  PandaNode::output(out);
+  out << " (" << get_num_instances() << " instances)";
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::compute_internal_bounds
+//       Access: Protected, Virtual
+//  Description: Computes the bounding volume of the children, as
+//               replicated at each of the instance transforms.
+////////////////////////////////////////////////////////////////////
+void InstancedNode::
+compute_internal_bounds(CPT(BoundingVolume) &internal_bounds,
+                        int &internal_vertices,
+                        int pipeline_stage,
+                        Thread *current_thread) const {
+  PT(BoundingSphere) bound = new BoundingSphere;
+  internal_vertices = 0;
+
+  Instances instances;
+  {
+    LightMutexHolder holder(_lock);
+    instances = _instances;
+  }
+
+  Children children = get_children(current_thread);
+  int num_children = children.get_num_children();
+  for (int ci = 0; ci < num_children; ++ci) {
+    PandaNode *child = children.get_child(ci);
+    const GeometricBoundingVolume *child_gbv;
+    DCAST_INTO_V(child_gbv, child->get_bounds(current_thread));
+    if (child_gbv->is_empty()) {
+      continue;
+    }
+
+    internal_vertices += child->get_nested_vertices(current_thread) * (int)instances.size();
+
+    Instances::const_iterator ii;
+    for (ii = instances.begin(); ii != instances.end(); ++ii) {
+      PT(GeometricBoundingVolume) gbv = DCAST(GeometricBoundingVolume, child_gbv->make_copy());
+      gbv->xform((*ii)->get_mat());
+      bound->extend_by(gbv);
+    }
+  }
+
+  internal_bounds = bound;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::children_changed
+//       Access: Protected, Virtual
+//  Description: Called after a scene graph update that either adds or
+//               remove children from this node.
+////////////////////////////////////////////////////////////////////
+void InstancedNode::
+children_changed() {
+  {
+    LightMutexHolder holder(_lock);
+    invalidate_instanced_copy();
+  }
+  mark_internal_bounds_stale();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::is_instancing_possible
+//       Access: Private
+//  Description: Returns true if the children may be rendered with
+//               hardware instancing in the current traversal.  This
+//               requires GSG support, and a shader that can consume
+//               the instance matrix, since the fixed-function
+//               pipeline has no way to apply it.
+////////////////////////////////////////////////////////////////////
+bool InstancedNode::
+is_instancing_possible(CullTraverser *trav, const CullTraverserData &data) const {
+  if (!hardware_instancing) {
+    return false;
+  }
+
+  GraphicsStateGuardianBase *gsg = trav->get_gsg();
+  if (gsg == (GraphicsStateGuardianBase *)NULL ||
+      !gsg->get_supports_geometry_instancing()) {
+    return false;
+  }
+
+  const ShaderAttrib *sa;
+  if (!data._state->get_attrib(sa) || !sa->has_shader() || sa->auto_shader()) {
+    return false;
+  }
+
+  // An instance count that was set explicitly by the application
+  // takes precedence; we don't try to combine the two.
+  return sa->get_instance_count() == 0;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::cull_instanced
+//       Access: Private
+//  Description: Traverses a private copy of the children just once,
+//               with the instance array attached to their Geoms and
+//               the instance count set on the ShaderAttrib, so that
+//               the GSG renders all instances in one draw call per
+//               Geom.
+////////////////////////////////////////////////////////////////////
+void InstancedNode::
+cull_instanced(CullTraverser *trav, CullTraverserData &data) {
+  int num_instances = get_num_instances();
+  if (num_instances == 0) {
+    return;
+  }
+
+  PandaNode *copy = get_instanced_copy(trav->get_current_thread());
+  if (copy == (PandaNode *)NULL) {
+    return;
+  }
+
+  const ShaderAttrib *sa;
+  data._state->get_attrib_def(sa);
+
+  CullTraverserData next_data(data, copy);
+  next_data._state = next_data._state->set_attrib(sa->set_instance_count(num_instances));
+  trav->traverse(next_data);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::cull_individually
+//       Access: Private
+//  Description: Traverses the children once for each instance, with
+//               the instance transform applied.  This is the fallback
+//               for GSG's and states that don't allow hardware
+//               instancing.
+////////////////////////////////////////////////////////////////////
+void InstancedNode::
+cull_individually(CullTraverser *trav, CullTraverserData &data) {
+  Instances instances;
+  {
+    LightMutexHolder holder(_lock);
+    instances = _instances;
+  }
+
+  PandaNode::Children children = data.node_reader()->get_children();
+  int num_children = children.get_num_children();
+  if (num_children == 0) {
+    return;
+  }
+
+  CPT(RenderState) empty_state = RenderState::make_empty();
+  CPT(RenderEffects) empty_effects = RenderEffects::make_empty();
+
+  Instances::const_iterator ii;
+  for (ii = instances.begin(); ii != instances.end(); ++ii) {
+    CullTraverserData instance_data(data);
+    instance_data.apply_transform_and_state(trav, *ii, empty_state,
+                                            empty_effects, NULL);
+
+    for (int ci = 0; ci < num_children; ++ci) {
+      CullTraverserData next_data(instance_data, children.get_child(ci));
+      trav->traverse(next_data);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::get_instanced_copy
+//       Access: Private
+//  Description: Returns the private copy of the children with the
+//               instance array attached to each Geom.  The copy is
+//               rebuilt only if the children have changed since it
+//               was last built; if only the instances have changed,
+//               the shared instance array is refilled in place.
+////////////////////////////////////////////////////////////////////
+PandaNode *InstancedNode::
+get_instanced_copy(Thread *current_thread) {
+  // This must be fetched before we grab the lock, since it may call
+  // compute_internal_bounds().
+  CPT(BoundingVolume) internal_bounds = get_internal_bounds(current_thread);
+
+  LightMutexHolder holder(_lock);
+
+  Children children = get_children(current_thread);
+  int num_children = children.get_num_children();
+
+  // A change anywhere below a child replaces its bounding volume, so
+  // this is a cheap way to detect that the copy is out of date.
+  if (_instanced_copy != (PandaNode *)NULL &&
+      (int)_copied_child_bounds.size() == num_children) {
+    bool stale = false;
+    for (int ci = 0; ci < num_children && !stale; ++ci) {
+      stale = (children.get_child(ci)->get_bounds(current_thread) != _copied_child_bounds[ci]);
+    }
+    if (!stale) {
+      if (_instance_array_stale) {
+        PStatTimer timer(instance_array_pcollector, current_thread);
+        fill_instance_array(_instance_array);
+        _instanced_copy->set_bounds(internal_bounds);
+        _instance_array_stale = false;
+      }
+      return _instanced_copy;
+    }
+  }
+
+  PStatTimer timer(copy_subgraph_pcollector, current_thread);
+
+  _instance_array =
+    new GeomVertexArrayData(get_instance_array_format(), Geom::UH_dynamic);
+  fill_instance_array(_instance_array);
+  _instance_array_stale = false;
+  _instanced_copy = new PandaNode(get_name());
+  _copied_child_bounds.clear();
+  for (int ci = 0; ci < num_children; ++ci) {
+    PandaNode *child = children.get_child(ci);
+    _copied_child_bounds.push_back(child->get_bounds(current_thread));
+    _instanced_copy->add_child(child->copy_subgraph(current_thread));
+  }
+  r_attach_instance_array(_instanced_copy, current_thread);
+
+  // The Geoms now cover all instances, so we don't want the copy to
+  // be culled against the bounds of the prototype.  Our own bounds
+  // have already been tested against the frustum.
+  _instanced_copy->set_bounds(internal_bounds);
+  _instanced_copy->set_final(true);
+
+  return _instanced_copy;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::r_attach_instance_array
+//       Access: Private
+//  Description: Walks the copied subgraph, replacing each Geom with
+//               one whose vertex data has the instance array appended
+//               as an additional array.  The original vertex arrays
+//               are shared, not copied.
+////////////////////////////////////////////////////////////////////
+void InstancedNode::
+r_attach_instance_array(PandaNode *node, Thread *current_thread) {
+  if (node->is_geom_node()) {
+    GeomNode *gnode = DCAST(GeomNode, node);
+    int num_geoms = gnode->get_num_geoms();
+    for (int gi = 0; gi < num_geoms; ++gi) {
+      CPT(Geom) orig_geom = gnode->get_geom(gi);
+      CPT(GeomVertexData) orig_data = orig_geom->get_vertex_data(current_thread);
+      const GeomVertexFormat *orig_format = orig_data->get_format();
+      if (orig_format->has_column(get_instance_matrix_name())) {
+        // Someone already supplied instance data.  Leave it alone.
+        continue;
+      }
+
+      PT(GeomVertexFormat) format = new GeomVertexFormat(*orig_format);
+      int instance_index = format->add_array(get_instance_array_format());
+
+      PT(GeomVertexData) data =
+        new GeomVertexData(*orig_data, GeomVertexFormat::register_format(format));
+      for (int ai = 0; ai < instance_index; ++ai) {
+        data->set_array(ai, orig_data->get_array(ai));
+      }
+      data->set_array(instance_index, _instance_array);
+
+      PT(Geom) geom = orig_geom->make_copy();
+      geom->set_vertex_data(data);
+      gnode->set_geom(gi, geom);
+    }
+  }
+
+  Children children = node->get_children(current_thread);
+  int num_children = children.get_num_children();
+  for (int ci = 0; ci < num_children; ++ci) {
+    r_attach_instance_array(children.get_child(ci), current_thread);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::fill_instance_array
+//       Access: Private
+//  Description: Fills the indicated vertex array with one matrix per
+//               instance, resizing it as needed.  Since the same
+//               array is shared by all the Geoms of the private copy,
+//               this updates all of them at once.  Assumes the lock
+//               is held.
+////////////////////////////////////////////////////////////////////
+void InstancedNode::
+fill_instance_array(GeomVertexArrayData *array) const {
+  array->unclean_set_num_rows((int)_instances.size());
+
+  GeomVertexWriter writer(array, 0);
+  Instances::const_iterator ii;
+  for (ii = _instances.begin(); ii != _instances.end(); ++ii) {
+    writer.set_matrix4((*ii)->get_mat());
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::invalidate_instanced_copy
+//       Access: Private
+//  Description: Discards the private copy of the children, so that
+//               it will be rebuilt the next time it is needed.
+//               Assumes the lock is held.
+////////////////////////////////////////////////////////////////////
+void InstancedNode::
+invalidate_instanced_copy() {
+  _instanced_copy.clear();
+  _instance_array.clear();
+  _copied_child_bounds.clear();
+  _instance_array_stale = false;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::register_with_read_factory
+//       Access: Public, Static
+//  Description: Tells the BamReader how to create objects of type
+//               InstancedNode.
+////////////////////////////////////////////////////////////////////
+void InstancedNode::
+register_with_read_factory() {
+  BamReader::get_factory()->register_factory(get_class_type(), make_from_bam);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::write_datagram
+//       Access: Public, Virtual
+//  Description: Writes the contents of this object to the datagram
+//               for shipping out to a Bam file.
+////////////////////////////////////////////////////////////////////
+void InstancedNode::
+write_datagram(BamWriter *manager, Datagram &dg) {
+  PandaNode::write_datagram(manager, dg);
+
+  LightMutexHolder holder(_lock);
+  dg.add_uint32(_instances.size());
+  Instances::const_iterator ii;
+  for (ii = _instances.begin(); ii != _instances.end(); ++ii) {
+    manager->write_pointer(dg, (*ii));
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::complete_pointers
+//       Access: Public, Virtual
+//  Description: Receives an array of pointers, one for each time
+//               manager->read_pointer() was called in fillin().
+//               Returns the number of pointers processed.
+////////////////////////////////////////////////////////////////////
+int InstancedNode::
+complete_pointers(TypedWritable **p_list, BamReader *manager) {
+  int pi = PandaNode::complete_pointers(p_list, manager);
+
+  Instances::iterator ii;
+  for (ii = _instances.begin(); ii != _instances.end(); ++ii) {
+    (*ii) = DCAST(TransformState, p_list[pi++]);
+  }
+
+  return pi;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::make_from_bam
+//       Access: Protected, Static
+//  Description: This function is called by the BamReader's factory
+//               when a new object of type InstancedNode is encountered
+//               in the Bam file.  It should create the InstancedNode
+//               and extract its information from the file.
+////////////////////////////////////////////////////////////////////
+TypedWritable *InstancedNode::
+make_from_bam(const FactoryParams &params) {
+  InstancedNode *node = new InstancedNode("");
+  DatagramIterator scan;
+  BamReader *manager;
+
+  parse_params(params, scan, manager);
+  node->fillin(scan, manager);
+
+  return node;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::fillin
+//       Access: Protected
+//  Description: This internal function is called by make_from_bam to
+//               read in all of the relevant data from the BamFile for
+//               the new InstancedNode.
+////////////////////////////////////////////////////////////////////
+void InstancedNode::
+fillin(DatagramIterator &scan, BamReader *manager) {
+  PandaNode::fillin(scan, manager);
+
+  size_t num_instances = scan.get_uint32();
+  _instances.clear();
+  _instances.resize(num_instances);
+  for (size_t i = 0; i < num_instances; ++i) {
+    manager->read_pointer(scan);
+  }
+}
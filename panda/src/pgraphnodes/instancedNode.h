@@ -0,0 +1,149 @@
+// Filename: instancedNode.h
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef INSTANCEDNODE_H
+#define INSTANCEDNODE_H
+
+#include "pandabase.h"
+
+#include "pandaNode.h"
+#include "transformState.h"
+#include "boundingVolume.h"
+#include "geomVertexArrayData.h"
+#include "geomVertexArrayFormat.h"
+#include "internalName.h"
+#include "lightMutex.h"
+#include "lightMutexHolder.h"
+#include "pvector.h"
+
+////////////////////////////////////////////////////////////////////
+//       Class : InstancedNode
+// Description : This node renders its children once for each of a
+//               list of transforms, relative to the node itself.  It
+//               is intended for drawing many copies of the same
+//               prop, such as trees or rocks.
+//
+//               When the GSG supports hardware geometry instancing
+//               and a shader is in effect on this node, the children
+//               are drawn only once per Geom, with the instance
+//               count set on the ShaderAttrib.  The per-instance
+//               transforms are provided to the shader in a vertex
+//               array with a divisor of 1, as the mat4 vertex input
+//               named by get_instance_matrix_name(); the shader is
+//               responsible for applying it to p3d_Vertex.
+//
+//               Otherwise, the children are simply traversed once
+//               per instance, which is equivalent to (but cheaper
+//               to set up than) instancing the children under one
+//               node per transform.
+////////////////////////////////////////////////////////////////////
+class EXPCL_PANDA_PGRAPHNODES InstancedNode : public PandaNode {
+PUBLISHED:
+  InstancedNode(const string &name);
+
+protected:
+  InstancedNode(const InstancedNode &copy);
+
+PUBLISHED:
+  virtual ~InstancedNode();
+
+  INLINE int get_num_instances() const;
+  INLINE CPT(TransformState) get_instance(int n) const;
+  MAKE_SEQ(get_instances, get_num_instances, get_instance);
+
+  int add_instance(const TransformState *transform);
+  void set_instance(int n, const TransformState *transform);
+  void remove_instance(int n);
+  void clear_instances();
+
+  static InternalName *get_instance_matrix_name();
+  static const GeomVertexArrayFormat *get_instance_array_format();
+
+public:
+  virtual PandaNode *make_copy() const;
+  virtual bool safe_to_flatten() const;
+  virtual bool safe_to_combine() const;
+  virtual bool safe_to_flatten_below() const;
+
+  virtual bool cull_callback(CullTraverser *trav, CullTraverserData &data);
+
+  virtual void output(ostream &out) const;
+
+protected:
+  virtual void compute_internal_bounds(CPT(BoundingVolume) &internal_bounds,
+                                       int &internal_vertices,
+                                       int pipeline_stage,
+                                       Thread *current_thread) const;
+  virtual void children_changed();
+
+private:
+  bool is_instancing_possible(CullTraverser *trav,
+                              const CullTraverserData &data) const;
+  void cull_instanced(CullTraverser *trav, CullTraverserData &data);
+  void cull_individually(CullTraverser *trav, CullTraverserData &data);
+
+  PandaNode *get_instanced_copy(Thread *current_thread);
+  void r_attach_instance_array(PandaNode *node, Thread *current_thread);
+  void fill_instance_array(GeomVertexArrayData *array) const;
+  void invalidate_instanced_copy();
+
+  typedef pvector< CPT(TransformState) > Instances;
+  Instances _instances;
+
+  typedef pvector< CPT(BoundingVolume) > ChildBounds;
+
+  // The instance list is read by the cull thread, so it is protected
+  // by _lock, as is the private copy of the children with the
+  // instance array attached to each of its Geoms.  That copy is
+  // rebuilt lazily, only when the bounding volumes of the children
+  // change; a change to the instance list just refills the array.
+  LightMutex _lock;
+  PT(PandaNode) _instanced_copy;
+  PT(GeomVertexArrayData) _instance_array;
+  ChildBounds _copied_child_bounds;
+  bool _instance_array_stale;
+
+  static PT(InternalName) _instance_matrix_name;
+  static CPT(GeomVertexArrayFormat) _instance_array_format;
+
+public:
+  static void register_with_read_factory();
+  virtual void write_datagram(BamWriter *manager, Datagram &dg);
+  virtual int complete_pointers(TypedWritable **plist, BamReader *manager);
+
+protected:
+  static TypedWritable *make_from_bam(const FactoryParams &params);
+  void fillin(DatagramIterator &scan, BamReader *manager);
+
+public:
+  static TypeHandle get_class_type() {
+    return _type_handle;
+  }
+  static void init_type() {
+    PandaNode::init_type();
+    register_type(_type_handle, "InstancedNode",
+                  PandaNode::get_class_type());
+  }
+  virtual TypeHandle get_type() const {
+    return get_class_type();
+  }
+  virtual TypeHandle force_init_type() {init_type(); return get_class_type();}
+
+private:
+  static TypeHandle _type_handle;
+};
+
+#include "instancedNode.I"
+
+#endif
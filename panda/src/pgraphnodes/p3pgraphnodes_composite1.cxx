@@ -5,5 +5,6 @@
 #include "directionalLight.cxx"
 #include "fadeLodNode.cxx"
 #include "fadeLodNodeData.cxx"
+#include "instancedNode.cxx"
 #include "lightLensNode.cxx"
 #include "lightNode.cxx"
@@ -0,0 +1,349 @@
+// Filename: test_instancedNode.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "pandabase.h"
+#include "instancedNode.h"
+#include "config_pgraphnodes.h"
+#include "geomNode.h"
+#include "geomPoints.h"
+#include "geomVertexData.h"
+#include "geomVertexFormat.h"
+#include "geomVertexWriter.h"
+#include "geomVertexReader.h"
+#include "boundingSphere.h"
+#include "transformState.h"
+#include "graphicsStateGuardian.h"
+#include "cullTraverser.h"
+#include "cullHandler.h"
+#include "cullableObject.h"
+#include "sceneSetup.h"
+#include "camera.h"
+#include "shader.h"
+#include "shaderAttrib.h"
+#include "nodePath.h"
+#include "pvector.h"
+#include "testCheck.h"
+
+// This program checks that the bounding volume of an InstancedNode
+// covers its children replicated at each of its instances, and that it
+// follows the instance list as instances are added, moved and removed.
+//
+// It also culls an InstancedNode, and checks that it produces one
+// object per child per instance when it can't use hardware
+// instancing, and otherwise one object per Geom, drawn from the
+// private copy of the children, with the instance count set and the
+// instance matrices in an extra vertex array.
+
+static TestCheck check;
+
+static PT(GeomNode)
+make_point() {
+  PT(GeomVertexData) vdata =
+    new GeomVertexData("point", GeomVertexFormat::get_v3(), Geom::UH_static);
+  GeomVertexWriter vertex(vdata, InternalName::get_vertex());
+  vertex.add_data3(0.0f, 0.0f, 0.0f);
+
+  PT(GeomPoints) points = new GeomPoints(Geom::UH_static);
+  points->add_vertex(0);
+
+  PT(Geom) geom = new Geom(vdata);
+  geom->add_primitive(points);
+
+  PT(GeomNode) gnode = new GeomNode("point");
+  gnode->add_geom(geom);
+  return gnode;
+}
+
+// A GSG that doesn't render anything; it just reports whether it
+// supports hardware instancing.
+class FakeGSG : public GraphicsStateGuardian {
+public:
+  FakeGSG(bool supports_instancing) :
+    GraphicsStateGuardian(CS_default, NULL, NULL)
+  {
+    _supports_geometry_instancing = supports_instancing;
+  }
+  virtual TextureContext *prepare_texture(Texture *tex, int view) {
+    return NULL;
+  }
+};
+
+// A CullHandler that keeps the objects it is given.
+class ObjectCollector : public CullHandler {
+public:
+  virtual ~ObjectCollector() {
+    clear();
+  }
+  virtual void record_object(CullableObject *object,
+                             const CullTraverser *traverser) {
+    _objects.push_back(object);
+  }
+  void clear() {
+    for (size_t i = 0; i < _objects.size(); ++i) {
+      delete _objects[i];
+    }
+    _objects.clear();
+  }
+
+  pvector<CullableObject *> _objects;
+};
+
+static const char *const vertex_shader =
+  "#version 330\n"
+  "uniform mat4 p3d_ModelViewProjectionMatrix;\n"
+  "in vec4 p3d_Vertex;\n"
+  "in mat4 instance_matrix;\n"
+  "void main() {\n"
+  "  gl_Position = p3d_ModelViewProjectionMatrix * instance_matrix * p3d_Vertex;\n"
+  "}\n";
+
+static const char *const fragment_shader =
+  "#version 330\n"
+  "out vec4 color;\n"
+  "void main() {\n"
+  "  color = vec4(1);\n"
+  "}\n";
+
+////////////////////////////////////////////////////////////////////
+//     Function: cull_scene
+//  Description: Culls the scene below root with the indicated GSG,
+//               collecting the objects in the indicated collector.
+////////////////////////////////////////////////////////////////////
+static void
+cull_scene(const NodePath &root, GraphicsStateGuardian *gsg,
+           ObjectCollector &collector) {
+  collector.clear();
+
+  PT(Camera) camera = new Camera("camera");
+  CPT(TransformState) identity = TransformState::make_identity();
+  PT(SceneSetup) scene = new SceneSetup;
+  scene->set_scene_root(root);
+  scene->set_camera_path(NodePath(camera));
+  scene->set_camera_node(camera);
+  scene->set_lens(camera->get_lens());
+  scene->set_initial_state(RenderState::make_empty());
+  scene->set_camera_transform(identity);
+  scene->set_world_transform(identity);
+  scene->set_cs_transform(identity);
+  scene->set_cs_world_transform(identity);
+
+  CullTraverser trav;
+  trav.set_scene(scene, gsg, false);
+  trav.set_cull_handler(&collector);
+  trav.traverse(root);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: check_instance_array
+//  Description: Checks that the object's vertex data is the original
+//               vertex data with the instance matrices appended in
+//               an array of their own, and that the original arrays
+//               are shared rather than copied.
+////////////////////////////////////////////////////////////////////
+static void
+check_instance_array(const CullableObject *object, const Geom *orig_geom,
+                     InstancedNode *inode, const string &description) {
+  CPT(GeomVertexData) orig_data = orig_geom->get_vertex_data();
+  CPT(GeomVertexData) data = object->_geom->get_vertex_data();
+  int num_arrays = orig_data->get_num_arrays();
+
+  check(object->_geom != orig_geom, description + ": geom copied");
+  if (!check(data->get_num_arrays() == num_arrays + 1,
+             description + ": instance array appended")) {
+    return;
+  }
+  for (int ai = 0; ai < num_arrays; ++ai) {
+    check(data->get_array(ai) == orig_data->get_array(ai),
+          description + ": vertex array shared");
+  }
+  check(object->_geom->get_num_primitives() == orig_geom->get_num_primitives() &&
+        object->_geom->get_primitive(0) == orig_geom->get_primitive(0),
+        description + ": primitives shared");
+  check(data->get_format()->get_array(num_arrays) ==
+        InstancedNode::get_instance_array_format(),
+        description + ": instance array format");
+
+  CPT(GeomVertexArrayData) array = data->get_array(num_arrays);
+  if (!check(array->get_num_rows() == inode->get_num_instances(),
+             description + ": one row per instance")) {
+    return;
+  }
+  GeomVertexReader reader(array, 0);
+  for (int i = 0; i < inode->get_num_instances(); ++i) {
+    check(reader.get_matrix4().almost_equal(inode->get_instance(i)->get_mat()),
+          description + ": instance matrix");
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: test_cull
+//  Description: Culls an InstancedNode with and without hardware
+//               instancing.
+////////////////////////////////////////////////////////////////////
+static void
+test_cull() {
+  NodePath root("root");
+  PT(InstancedNode) inode = new InstancedNode("inode");
+  NodePath inode_np = root.attach_new_node(inode);
+  PT(GeomNode) child = make_point();
+  inode->add_child(child);
+  CPT(Geom) orig_geom = child->get_geom(0);
+
+  static const int num_instances = 3;
+  for (int i = 0; i < num_instances; ++i) {
+    inode->add_instance(TransformState::make_pos(LPoint3(i * 10.0f, 5.0f, 0.0f)));
+  }
+
+  PT(FakeGSG) plain_gsg = new FakeGSG(false);
+  PT(FakeGSG) instancing_gsg = new FakeGSG(true);
+  ObjectCollector collector;
+
+  // Without instancing support, or without a shader to apply the
+  // instance matrix, the child is traversed once per instance.
+  cull_scene(root, plain_gsg, collector);
+  if (check(collector._objects.size() == num_instances,
+            "individual: one object per instance")) {
+    for (int i = 0; i < num_instances; ++i) {
+      const CullableObject *object = collector._objects[i];
+      check(object->_geom == orig_geom, "individual: original geom");
+      check(object->_internal_transform->get_pos() ==
+            inode->get_instance(i)->get_pos(),
+            "individual: instance transform");
+    }
+  }
+  cull_scene(root, instancing_gsg, collector);
+  check(collector._objects.size() == num_instances,
+        "no shader: one object per instance");
+
+  PT(Shader) shader = Shader::make(Shader::SL_GLSL, vertex_shader,
+                                   fragment_shader);
+  inode_np.set_attrib(ShaderAttrib::make(shader));
+  cull_scene(root, plain_gsg, collector);
+  check(collector._objects.size() == num_instances,
+        "no GSG support: one object per instance");
+
+  // With both, the GSG gets a single object with an instance count.
+  cull_scene(root, instancing_gsg, collector);
+  if (check(collector._objects.size() == 1, "instanced: one object")) {
+    const CullableObject *object = collector._objects[0];
+    const ShaderAttrib *sa;
+    check(object->_state->get_attrib(sa) &&
+          sa->get_instance_count() == num_instances,
+          "instanced: instance count");
+    check(object->_internal_transform->is_identity(),
+          "instanced: no instance transform");
+    check_instance_array(object, orig_geom, inode, "instanced");
+  }
+  check(child->get_geom(0) == orig_geom &&
+        orig_geom->get_vertex_data()->get_num_arrays() == 1,
+        "instanced: children unchanged");
+
+  // Moving an instance refills the array of the same copy.
+  CPT(Geom) copied_geom = collector._objects[0]->_geom;
+  inode->set_instance(1, TransformState::make_pos(LPoint3(0.0f, 0.0f, 50.0f)));
+  cull_scene(root, instancing_gsg, collector);
+  if (check(collector._objects.size() == 1, "moved: one object")) {
+    check(collector._objects[0]->_geom == copied_geom, "moved: copy reused");
+    check_instance_array(collector._objects[0], orig_geom, inode, "moved");
+  }
+
+  // So does adding one.
+  inode->add_instance(TransformState::make_pos(LPoint3(0.0f, -30.0f, 0.0f)));
+  cull_scene(root, instancing_gsg, collector);
+  if (check(collector._objects.size() == 1, "added: one object")) {
+    const ShaderAttrib *sa;
+    check(collector._objects[0]->_state->get_attrib(sa) &&
+          sa->get_instance_count() == num_instances + 1,
+          "added: instance count");
+    check_instance_array(collector._objects[0], orig_geom, inode, "added");
+  }
+
+  // Changing the children makes a new copy, with one Geom each.
+  PT(GeomNode) child2 = make_point();
+  child2->set_transform(TransformState::make_pos(LPoint3(0.0f, 0.0f, 1.0f)));
+  inode->add_child(child2);
+  cull_scene(root, instancing_gsg, collector);
+  if (check(collector._objects.size() == 2, "new child: one object each")) {
+    check(collector._objects[0]->_geom != copied_geom,
+          "new child: copy rebuilt");
+    check_instance_array(collector._objects[0], orig_geom, inode,
+                         "new child, first");
+    check_instance_array(collector._objects[1], child2->get_geom(0), inode,
+                         "new child, second");
+    check(collector._objects[1]->_internal_transform->get_pos() ==
+          LPoint3(0.0f, 0.0f, 1.0f),
+          "new child: child transform kept");
+  }
+
+  // With no instances, nothing is drawn either way.
+  inode->clear_instances();
+  cull_scene(root, instancing_gsg, collector);
+  check(collector._objects.empty(), "no instances: instanced");
+  cull_scene(root, plain_gsg, collector);
+  check(collector._objects.empty(), "no instances: individual");
+}
+
+static bool
+bounds_contain(PandaNode *node, const LPoint3 &point) {
+  CPT(BoundingVolume) bounds = node->get_bounds();
+  const GeometricBoundingVolume *gbv;
+  DCAST_INTO_R(gbv, bounds, false);
+  return (gbv->contains(point) & BoundingVolume::IF_some) != 0;
+}
+
+int
+main(int argc, char *argv[]) {
+  init_libpgraphnodes();
+
+  PT(InstancedNode) inode = new InstancedNode("inode");
+  inode->add_child(make_point());
+
+  LPoint3 a(10.0f, 0.0f, 0.0f);
+  LPoint3 b(0.0f, -20.0f, 0.0f);
+  LPoint3 c(0.0f, 0.0f, 100.0f);
+
+  inode->add_instance(TransformState::make_pos(a));
+  int bi = inode->add_instance(TransformState::make_pos(b));
+  check(inode->get_num_instances() == 2, "two instances added");
+  check(bounds_contain(inode, a) && bounds_contain(inode, b),
+        "bounds cover both instances");
+  check(!bounds_contain(inode, c), "bounds exclude unused position");
+
+  // Moving an instance must update the bounds, even though the
+  // children themselves have not changed.
+  inode->set_instance(bi, TransformState::make_pos(c));
+  check(inode->get_instance(bi)->get_pos() == c, "instance moved");
+  check(bounds_contain(inode, a) && bounds_contain(inode, c),
+        "bounds follow moved instance");
+
+  inode->remove_instance(0);
+  check(inode->get_num_instances() == 1, "instance removed");
+  check(inode->get_instance(0)->get_pos() == c, "remaining instance shifted");
+
+  // Adding a child replicates it at each instance too.
+  inode->add_instance(TransformState::make_pos(a));
+  PT(GeomNode) offset = make_point();
+  offset->set_transform(TransformState::make_pos(LPoint3(0.0f, 5.0f, 0.0f)));
+  inode->add_child(offset);
+  check(bounds_contain(inode, a + LVector3(0.0f, 5.0f, 0.0f)) &&
+        bounds_contain(inode, c + LVector3(0.0f, 5.0f, 0.0f)),
+        "bounds cover new child at each instance");
+
+  inode->clear_instances();
+  check(inode->get_num_instances() == 0, "instances cleared");
+
+  test_cull();
+
+  return check.report();
+}
@@ -50,6 +50,7 @@
     mutexHolder.h mutexHolder.I \
     mutexSimpleImpl.h mutexSimpleImpl.I \
     mutexTrueImpl.h \
+    parallelBands.h \
     pipeline.h pipeline.I \
     pipelineCycler.h pipelineCycler.I \
     pipelineCyclerLinks.h pipelineCyclerLinks.I \
@@ -111,6 +112,7 @@
     mutexDirect.cxx \
     mutexHolder.cxx \
     mutexSimpleImpl.cxx \
+    parallelBands.cxx \
     pipeline.cxx \
     pipelineCycler.cxx \
     pipelineCyclerDummyImpl.cxx \
@@ -170,6 +172,7 @@
     mutexHolder.h mutexHolder.I \
     mutexSimpleImpl.h mutexSimpleImpl.I \
     mutexTrueImpl.h \
+    parallelBands.h \
     pipeline.h pipeline.I \
     pipelineCycler.h pipelineCycler.I \
     pipelineCyclerLinks.h pipelineCyclerLinks.I \
@@ -38,9 +38,9 @@ wait(double timeout) {
 
   int seconds = (int)floor(timeout);
   ts.tv_sec += seconds;
-  ts.tv_nsec += (int)((timeout - seconds) * 1000000.0);
-  if (ts.tv_nsec > 1000000) {
-    ts.tv_nsec -= 1000000;
+  ts.tv_nsec += (long)((timeout - seconds) * 1000000000.0);
+  if (ts.tv_nsec >= 1000000000) {
+    ts.tv_nsec -= 1000000000;
     ++ts.tv_sec;
   }
 
@@ -3,6 +3,7 @@
 #include "mutexDirect.cxx"
 #include "mutexHolder.cxx"
 #include "mutexSimpleImpl.cxx"
+#include "parallelBands.cxx"
 #include "pipeline.cxx"
 #include "pipelineCycler.cxx"
 #include "pipelineCyclerDummyImpl.cxx"
@@ -0,0 +1,87 @@
+// Filename: parallelBands.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "parallelBands.h"
+#include "genericThread.h"
+#include "pvector.h"
+
+// One band of the work, as handed to a GenericThread.
+class ParallelBand {
+public:
+  ParallelBandFunc *_function;
+  void *_user_data;
+  int _begin;
+  int _end;
+
+  static void thread_main(void *data) {
+    ParallelBand *band = (ParallelBand *)data;
+    (*band->_function)(band->_user_data, band->_begin, band->_end);
+  }
+};
+
+////////////////////////////////////////////////////////////////////
+//     Function: run_parallel_bands
+//  Description: Calls the indicated function on the items 0 through
+//               num_items - 1, divided into at most max_bands bands
+//               of at least min_items_per_band items each.  Each band
+//               beyond the first runs on a new thread; the function
+//               must therefore be safe to call on different bands at
+//               the same time.
+////////////////////////////////////////////////////////////////////
+void
+run_parallel_bands(ParallelBandFunc *function, void *user_data,
+                   int num_items, int max_bands, int min_items_per_band) {
+  if (num_items <= 0) {
+    return;
+  }
+
+  int num_bands = 1;
+  if (Thread::is_true_threads()) {
+    num_bands = num_items / max(min_items_per_band, 1);
+    num_bands = max(min(num_bands, max_bands), 1);
+  }
+
+  if (num_bands == 1) {
+    (*function)(user_data, 0, num_items);
+    return;
+  }
+
+  pvector<ParallelBand> bands(num_bands);
+  for (int i = 0; i < num_bands; ++i) {
+    bands[i]._function = function;
+    bands[i]._user_data = user_data;
+    bands[i]._begin = (int)((PN_int64)num_items * i / num_bands);
+    bands[i]._end = (int)((PN_int64)num_items * (i + 1) / num_bands);
+  }
+
+  pvector<PT(GenericThread)> threads;
+  threads.reserve(num_bands - 1);
+  for (int i = 1; i < num_bands; ++i) {
+    PT(GenericThread) thread =
+      new GenericThread("band", "band", &ParallelBand::thread_main, &bands[i]);
+    if (thread->start(TP_normal, true)) {
+      threads.push_back(thread);
+    } else {
+      // Couldn't start a thread; do the work here instead.
+      ParallelBand::thread_main(&bands[i]);
+    }
+  }
+
+  ParallelBand::thread_main(&bands[0]);
+
+  pvector<PT(GenericThread)>::iterator ti;
+  for (ti = threads.begin(); ti != threads.end(); ++ti) {
+    (*ti)->join();
+  }
+}
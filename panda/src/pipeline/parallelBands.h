@@ -0,0 +1,36 @@
+// Filename: parallelBands.h
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef PARALLELBANDS_H
+#define PARALLELBANDS_H
+
+#include "pandabase.h"
+
+// run_parallel_bands() divides a range of independent work items (for
+// instance, the rows of an image) into contiguous bands, and calls the
+// indicated function on each band, each on a thread of its own.  It
+// returns when all of the bands have been processed.
+//
+// The first band is always processed on the calling thread.  If true
+// threads are not available, or the work is too small to be worth
+// dividing, the whole range is processed on the calling thread in a
+// single call.
+
+typedef void ParallelBandFunc(void *user_data, int begin, int end);
+
+EXPCL_PANDA_PIPELINE void
+run_parallel_bands(ParallelBandFunc *function, void *user_data,
+                   int num_items, int max_bands, int min_items_per_band = 1);
+
+#endif
@@ -53,3 +53,13 @@
 
 #end lib_target
 
+
+#begin test_bin_target
+  #define TARGET test_pnmfilter
+  #define LOCAL_LIBS p3pnmimage p3putil p3express
+  #define OTHER_LIBS $[OTHER_LIBS] p3pystub
+
+  #define SOURCES \
+    test_pnmfilter.cxx
+
+#end test_bin_target
@@ -59,6 +59,20 @@ ConfigVariableDouble pfm_resize_radius
           "always call box_filter() or gaussian_filter() explicitly with "
           "a specific radius."));
 
+ConfigVariableInt pnmimage_num_threads
+("pnmimage-num-threads", 4,
+ PRC_DESC("The maximum number of threads that the PNMImage resizing "
+          "filters, and the bulk operations on PfmFile, may use to process "
+          "a large image.  The image is divided into bands of rows, each of "
+          "which is processed on its own thread.  Set this to 1 to do all "
+          "of the work on the calling thread."));
+
+ConfigVariableInt pnmimage_min_band_size
+("pnmimage-min-band-size", 65536,
+ PRC_DESC("The smallest number of pixels that is worth handing to a thread "
+          "of its own, when an image is divided among pnmimage-num-threads "
+          "threads."));
+
 ////////////////////////////////////////////////////////////////////
 //     Function: init_libpnmimage
 //  Description: Initializes the library.  This must be called at
@@ -77,3 +91,20 @@ init_libpnmimage() {
 
   PNMFileType::init_type();
 }
+
+////////////////////////////////////////////////////////////////////
+//     Function: run_pnmimage_bands
+//  Description: Calls the indicated function on the rows 0 through
+//               num_rows - 1 of an image, divided among as many
+//               threads as pnmimage-num-threads and
+//               pnmimage-min-band-size allow.  row_len is the number
+//               of pixels in each row (or some other measure of the
+//               work it represents).
+////////////////////////////////////////////////////////////////////
+void
+run_pnmimage_bands(ParallelBandFunc *function, void *user_data,
+                   int num_rows, int row_len) {
+  int min_rows = pnmimage_min_band_size / max(row_len, 1);
+  run_parallel_bands(function, user_data, num_rows, pnmimage_num_threads,
+                     max(min_rows, 1));
+}
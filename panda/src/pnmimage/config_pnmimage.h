@@ -19,6 +19,8 @@
 #include "notifyCategoryProxy.h"
 #include "configVariableBool.h"
 #include "configVariableDouble.h"
+#include "configVariableInt.h"
+#include "parallelBands.h"
 
 NotifyCategoryDecl(pnmimage, EXPCL_PANDA_PNMIMAGE, EXPTP_PANDA_PNMIMAGE);
 
@@ -27,7 +29,13 @@ extern ConfigVariableBool pfm_reverse_dimensions;
 extern ConfigVariableBool pfm_resize_gaussian;
 extern ConfigVariableBool pfm_resize_quick;
 extern ConfigVariableDouble pfm_resize_radius;
+extern ConfigVariableInt pnmimage_num_threads;
+extern ConfigVariableInt pnmimage_min_band_size;
 
 extern EXPCL_PANDA_PNMIMAGE void init_libpnmimage();
 
+extern EXPCL_PANDA_PNMIMAGE void
+run_pnmimage_bands(ParallelBandFunc *function, void *user_data,
+                   int num_rows, int row_len);
+
 #endif
@@ -24,6 +24,48 @@
 #include "pnmWriter.h"
 #include "string_utils.h"
 #include "look_at.h"
+#include "lightMutexHolder.h"
+#include "thread.h"
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+// These carry the arguments of the PfmFile bulk operations to the
+// functions that perform them on each band of rows.
+class PfmQuickFilterBand {
+public:
+  PN_float32 *_dest;
+  int _x_size, _num_channels;
+  const PfmFile *_from;
+  PN_float32 _x_scale, _y_scale;
+};
+
+class PfmXformBand {
+public:
+  PfmFile *_pfm;
+  LMatrix4f _transform;
+};
+
+class PfmMergeBand {
+public:
+  PfmFile *_pfm;
+  const PfmFile *_other;
+};
+
+class PfmScaleBand {
+public:
+  PfmFile *_pfm;
+  PN_float32 _factors[4];
+};
+
+class PfmMinMaxBand {
+public:
+  const PfmFile *_pfm;
+  LightMutex _lock;
+  bool _any_points;
+  LVecBase3f _min_depth, _max_depth;
+};
 
 ////////////////////////////////////////////////////////////////////
 //     Function: PfmFile::Constructor
@@ -207,6 +249,85 @@ read(PNMReader *reader) {
   return success;
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: PfmFile::read_rows
+//       Access: Published
+//  Description: Reads only the rows y_begin through y_end - 1 of the
+//               indicated file, so that a file too large to hold in
+//               memory at once may be processed a tile of rows at a
+//               time.  This PfmFile is resized to hold just those
+//               rows; use PNMImageHeader::read_header() to learn the
+//               size of the whole file.  Returns true on success,
+//               false on failure.
+////////////////////////////////////////////////////////////////////
+bool PfmFile::
+read_rows(const Filename &fullpath, int y_begin, int y_end) {
+  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+
+  Filename filename = Filename::binary_filename(fullpath);
+  PT(VirtualFile) file = vfs->get_file(filename);
+  if (file == (VirtualFile *)NULL) {
+    // No such file.
+    pnmimage_cat.error()
+      << "Could not find " << fullpath << "\n";
+    return false;
+  }
+
+  if (pnmimage_cat.is_debug()) {
+    pnmimage_cat.debug()
+      << "Reading rows " << y_begin << " to " << y_end
+      << " of PFM file " << filename << "\n";
+  }
+
+  istream *in = file->open_read_file(true);
+  PNMReader *reader = make_reader(in, false, fullpath);
+  bool success = read_rows(reader, y_begin, y_end);
+  vfs->close_read_file(in);
+
+  return success;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: PfmFile::read_rows
+//       Access: Published
+//  Description: Reads only the rows y_begin through y_end - 1 using
+//               the indicated PNMReader.  If the file type cannot
+//               read a range of rows directly, the whole file is read
+//               and cropped.
+//
+//               The PNMReader is always deleted upon completion,
+//               whether successful or not.
+////////////////////////////////////////////////////////////////////
+bool PfmFile::
+read_rows(PNMReader *reader, int y_begin, int y_end) {
+  clear();
+
+  if (reader == NULL) {
+    return false;
+  }
+
+  if (!reader->is_valid()) {
+    delete reader;
+    return false;
+  }
+
+  if (!reader->is_floating_point()) {
+    // Not a floating-point file.  Quietly convert it, and keep just
+    // the requested rows.
+    if (!read(reader)) {
+      return false;
+    }
+    y_begin = max(y_begin, 0);
+    y_end = min(y_end, _y_size);
+    apply_crop(0, _x_size, y_begin, max(y_begin, y_end));
+    return true;
+  }
+
+  bool success = reader->read_pfm_rows(*this, y_begin, y_end);
+  delete reader;
+  return success;
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: PfmFile::write
 //       Access: Published
@@ -757,34 +878,16 @@ calc_bilinear_point(LPoint3f &result, PN_float32 x, PN_float32 y) const {
 ////////////////////////////////////////////////////////////////////
 bool PfmFile::
 calc_min_max(LVecBase3f &min_depth, LVecBase3f &max_depth) const {
-  bool any_points = false;
+  PfmMinMaxBand band;
+  band._pfm = this;
+  band._any_points = false;
+  band._min_depth = LVecBase3f::zero();
+  band._max_depth = LVecBase3f::zero();
+  run_pnmimage_bands(&calc_min_max_band, &band, _y_size, _x_size);
 
-  min_depth = LVecBase3f::zero();
-  max_depth = LVecBase3f::zero();
-
-  for (int yi = 0; yi < _y_size; ++yi) {
-    for (int xi = 0; xi < _x_size; ++xi) {
-      if (!has_point(xi, yi)) {
-        continue;
-      }
-
-      const LPoint3f &p = get_point(xi, yi);
-      if (!any_points) {
-        min_depth = p;
-        max_depth = p;
-        any_points = true;
-      } else {
-        min_depth[0] = min(min_depth[0], p[0]);
-        min_depth[1] = min(min_depth[1], p[1]);
-        min_depth[2] = min(min_depth[2], p[2]);
-        max_depth[0] = max(max_depth[0], p[0]);
-        max_depth[1] = max(max_depth[1], p[1]);
-        max_depth[2] = max(max_depth[2], p[2]);
-      }
-    }
-  }
-
-  return any_points;
+  min_depth = band._min_depth;
+  max_depth = band._max_depth;
+  return band._any_points;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -1042,142 +1145,30 @@ quick_filter_from(const PfmFile &from) {
   if (_x_size == 0 || _y_size == 0) {
     return;
   }
+  nassertv(_num_channels >= 1 && _num_channels <= 4);
 
-  Table new_data;
-  new_data.reserve(_table.size());
-
-  PN_float32 from_x0, from_x1, from_y0, from_y1;
+  // The extra buffer at the end of the new table is left zero.
+  Table new_data(_table.size(), (PN_float32)0.0);
 
-  int orig_x_size = from.get_x_size();
-  int orig_y_size = from.get_y_size();
-
-  PN_float32 x_scale = 1.0;
-  PN_float32 y_scale = 1.0;
+  PfmQuickFilterBand band;
+  band._dest = &new_data[0];
+  band._x_size = _x_size;
+  band._num_channels = _num_channels;
+  band._from = &from;
+  band._x_scale = 1.0;
+  band._y_scale = 1.0;
 
   if (_x_size > 1) {
-    x_scale = (PN_float32)orig_x_size / (PN_float32)_x_size;
+    band._x_scale = (PN_float32)from.get_x_size() / (PN_float32)_x_size;
   }
   if (_y_size > 1) {
-    y_scale = (PN_float32)orig_y_size / (PN_float32)_y_size;
-  }
-
-  switch (_num_channels) {
-  case 1:
-    {
-      from_y0 = 0.0;
-      for (int to_y = 0; to_y < _y_size; ++to_y) {
-        from_y1 = (to_y + 1.0) * y_scale;
-        from_y1 = min(from_y1, (PN_float32)orig_y_size);
-
-        from_x0 = 0.0;
-        for (int to_x = 0; to_x < _x_size; ++to_x) {
-          from_x1 = (to_x + 1.0) * x_scale;
-          from_x1 = min(from_x1, (PN_float32)orig_x_size);
-
-          // Now the box from (from_x0, from_y0) - (from_x1, from_y1)
-          // but not including (from_x1, from_y1) maps to the pixel (to_x, to_y).
-          PN_float32 result;
-          from.box_filter_region(result, from_x0, from_y0, from_x1, from_y1);
-          new_data.push_back(result);
-
-          from_x0 = from_x1;
-        }
-        from_y0 = from_y1;
-      }
-    }
-    break;
-
-  case 2:
-    {
-      from_y0 = 0.0;
-      for (int to_y = 0; to_y < _y_size; ++to_y) {
-        from_y1 = (to_y + 1.0) * y_scale;
-        from_y1 = min(from_y1, (PN_float32)orig_y_size);
-
-        from_x0 = 0.0;
-        for (int to_x = 0; to_x < _x_size; ++to_x) {
-          from_x1 = (to_x + 1.0) * x_scale;
-          from_x1 = min(from_x1, (PN_float32)orig_x_size);
-
-          // Now the box from (from_x0, from_y0) - (from_x1, from_y1)
-          // but not including (from_x1, from_y1) maps to the pixel (to_x, to_y).
-          LPoint2f result;
-          from.box_filter_region(result, from_x0, from_y0, from_x1, from_y1);
-          new_data.push_back(result[0]);
-          new_data.push_back(result[1]);
-
-          from_x0 = from_x1;
-        }
-        from_y0 = from_y1;
-      }
-    }
-    break;
-
-  case 3:
-    {
-      from_y0 = 0.0;
-      for (int to_y = 0; to_y < _y_size; ++to_y) {
-        from_y1 = (to_y + 1.0) * y_scale;
-        from_y1 = min(from_y1, (PN_float32)orig_y_size);
-
-        from_x0 = 0.0;
-        for (int to_x = 0; to_x < _x_size; ++to_x) {
-          from_x1 = (to_x + 1.0) * x_scale;
-          from_x1 = min(from_x1, (PN_float32)orig_x_size);
-
-          // Now the box from (from_x0, from_y0) - (from_x1, from_y1)
-          // but not including (from_x1, from_y1) maps to the pixel (to_x, to_y).
-          LPoint3f result;
-          from.box_filter_region(result, from_x0, from_y0, from_x1, from_y1);
-          new_data.push_back(result[0]);
-          new_data.push_back(result[1]);
-          new_data.push_back(result[2]);
-
-          from_x0 = from_x1;
-        }
-        from_y0 = from_y1;
-      }
-    }
-    break;
-
-  case 4:
-    {
-      from_y0 = 0.0;
-      for (int to_y = 0; to_y < _y_size; ++to_y) {
-        from_y1 = (to_y + 1.0) * y_scale;
-        from_y1 = min(from_y1, (PN_float32)orig_y_size);
-
-        from_x0 = 0.0;
-        for (int to_x = 0; to_x < _x_size; ++to_x) {
-          from_x1 = (to_x + 1.0) * x_scale;
-          from_x1 = min(from_x1, (PN_float32)orig_x_size);
-
-          // Now the box from (from_x0, from_y0) - (from_x1, from_y1)
-          // but not including (from_x1, from_y1) maps to the pixel (to_x, to_y).
-          LPoint4f result;
-          from.box_filter_region(result, from_x0, from_y0, from_x1, from_y1);
-          new_data.push_back(result[0]);
-          new_data.push_back(result[1]);
-          new_data.push_back(result[2]);
-          new_data.push_back(result[3]);
-
-          from_x0 = from_x1;
-        }
-        from_y0 = from_y1;
-      }
-    }
-    break;
-
-  default:
-    nassertv(false);
+    band._y_scale = (PN_float32)from.get_y_size() / (PN_float32)_y_size;
   }
 
-  new_data.push_back(0.0);
-  new_data.push_back(0.0);
-  new_data.push_back(0.0);
-  new_data.push_back(0.0);
+  // Each destination row reads about x_size * y_scale source points.
+  int row_len = (int)(from.get_x_size() * max(band._y_scale, (PN_float32)1.0));
+  run_pnmimage_bands(&quick_filter_band, &band, _y_size, row_len);
 
-  nassertv(new_data.size() == _table.size());
   _table.swap(new_data);
 }
 
@@ -1273,15 +1264,25 @@ void PfmFile::
 xform(const LMatrix4f &transform) {
   nassertv(is_valid());
 
-  for (int yi = 0; yi < _y_size; ++yi) {
-    for (int xi = 0; xi < _x_size; ++xi) {
-      if (!has_point(xi, yi)) {
-        continue;
+  if (_num_channels < 3) {
+    // The points of a 1- or 2-channel file overlap each other when
+    // treated as 3-component points, so they must be done in order.
+    for (int yi = 0; yi < _y_size; ++yi) {
+      for (int xi = 0; xi < _x_size; ++xi) {
+        if (!has_point(xi, yi)) {
+          continue;
+        }
+        LPoint3f &p = modify_point(xi, yi);
+        transform.xform_point_general_in_place(p);
       }
-      LPoint3f &p = modify_point(xi, yi);
-      transform.xform_point_general_in_place(p);
     }
+    return;
   }
+
+  PfmXformBand band;
+  band._pfm = this;
+  band._transform = transform;
+  run_pnmimage_bands(&xform_band, &band, _y_size, _x_size);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -1457,13 +1458,10 @@ merge(const PfmFile &other) {
     return;
   }
 
-  for (int yi = 0; yi < _y_size; ++yi) {
-    for (int xi = 0; xi < _x_size; ++xi) {
-      if (!has_point(xi, yi) && other.has_point(xi, yi)) {
-        set_point(xi, yi, other.get_point(xi, yi));
-      }
-    }
-  }
+  PfmMergeBand band;
+  band._pfm = this;
+  band._other = &other;
+  run_pnmimage_bands(&merge_band, &band, _y_size, _x_size);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -1487,13 +1485,10 @@ apply_mask(const PfmFile &other) {
     return;
   }
 
-  for (int yi = 0; yi < _y_size; ++yi) {
-    for (int xi = 0; xi < _x_size; ++xi) {
-      if (!other.has_point(xi, yi)) {
-        set_point4(xi, yi, _no_data_value);
-      }
-    }
-  }
+  PfmMergeBand band;
+  band._pfm = this;
+  band._other = &other;
+  run_pnmimage_bands(&apply_mask_band, &band, _y_size, _x_size);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -2202,60 +2197,13 @@ void PfmFile::
 operator *= (float multiplier) {
   nassertv(is_valid());
 
-  switch (_num_channels) {
-  case 1:
-    {
-      for (int y = 0; y < _y_size; ++y) {
-        for (int x = 0; x < _x_size; ++x) {
-          if (has_point(x, y)) {
-            PN_float32 p = get_point1(x, y);
-            p *= multiplier;
-            set_point1(x, y, p);
-          }
-        }
-      }
-    }
-    break;
-
-  case 2:
-    {
-      for (int y = 0; y < _y_size; ++y) {
-        for (int x = 0; x < _x_size; ++x) {
-          if (has_point(x, y)) {
-            LPoint2f &p = modify_point2(x, y);
-            p *= multiplier;
-          }
-        }
-      }
-    }
-    break;
-
-  case 3:
-    {
-      for (int y = 0; y < _y_size; ++y) {
-        for (int x = 0; x < _x_size; ++x) {
-          if (has_point(x, y)) {
-            LPoint3f &p = modify_point3(x, y);
-            p *= multiplier;
-          }
-        }
-      }
-    }
-    break;
-
-  case 4:
-    {
-      for (int y = 0; y < _y_size; ++y) {
-        for (int x = 0; x < _x_size; ++x) {
-          if (has_point(x, y)) {
-            LPoint4f &p = modify_point4(x, y);
-            p *= multiplier;
-          }
-        }
-      }
-    }
-    break;
-  }
+  PfmScaleBand band;
+  band._pfm = this;
+  band._factors[0] = multiplier;
+  band._factors[1] = multiplier;
+  band._factors[2] = multiplier;
+  band._factors[3] = multiplier;
+  run_pnmimage_bands(&scale_band, &band, _y_size, _x_size);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -2268,57 +2216,13 @@ operator *= (float multiplier) {
 void PfmFile::
 apply_exponent(float c0_exponent, float c1_exponent, float c2_exponent,
                float c3_exponent) {
-  switch (_num_channels) {
-  case 1:
-    {
-      for (int yi = 0; yi < _y_size; ++yi) {
-        for (int xi = 0; xi < _x_size; ++xi) {
-          float *val = &_table[(yi * _x_size + xi)];
-          val[0] = cpow(val[0], c0_exponent);
-        }
-      }
-    }
-    break;
-
-  case 2:
-    {
-      for (int yi = 0; yi < _y_size; ++yi) {
-        for (int xi = 0; xi < _x_size; ++xi) {
-          float *val = &_table[(yi * _x_size + xi) * _num_channels];
-          val[0] = cpow(val[0], c0_exponent);
-          val[1] = cpow(val[1], c1_exponent);
-        }
-      }
-    }
-    break;
-
-  case 3:
-    {
-      for (int yi = 0; yi < _y_size; ++yi) {
-        for (int xi = 0; xi < _x_size; ++xi) {
-          float *val = &_table[(yi * _x_size + xi) * _num_channels];
-          val[0] = cpow(val[0], c0_exponent);
-          val[1] = cpow(val[1], c1_exponent);
-          val[2] = cpow(val[2], c2_exponent);
-        }
-      }
-    }
-    break;
-
-  case 4:
-    {
-      for (int yi = 0; yi < _y_size; ++yi) {
-        for (int xi = 0; xi < _x_size; ++xi) {
-          float *val = &_table[(yi * _x_size + xi) * _num_channels];
-          val[0] = cpow(val[0], c0_exponent);
-          val[1] = cpow(val[1], c1_exponent);
-          val[2] = cpow(val[2], c2_exponent);
-          val[3] = cpow(val[3], c3_exponent);
-        }
-      }
-    }
-    break;
-  }
+  PfmScaleBand band;
+  band._pfm = this;
+  band._factors[0] = c0_exponent;
+  band._factors[1] = c1_exponent;
+  band._factors[2] = c2_exponent;
+  band._factors[3] = c3_exponent;
+  run_pnmimage_bands(&apply_exponent_band, &band, _y_size, _x_size);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -2728,6 +2632,307 @@ fill_mini_grid(MiniGridCell *mini_grid, int x_size, int y_size,
   }
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: PfmFile::quick_filter_band
+//       Access: Private, Static
+//  Description: Performs quick_filter_from() on the indicated rows of
+//               the destination table.
+////////////////////////////////////////////////////////////////////
+void PfmFile::
+quick_filter_band(void *data, int y_begin, int y_end) {
+  PfmQuickFilterBand *band = (PfmQuickFilterBand *)data;
+  const PfmFile &from = *band->_from;
+  int num_channels = band->_num_channels;
+
+  PN_float32 orig_x_size = (PN_float32)from.get_x_size();
+  PN_float32 orig_y_size = (PN_float32)from.get_y_size();
+
+  PN_float32 *dest = band->_dest + (size_t)y_begin * band->_x_size * num_channels;
+
+  PN_float32 from_y0 = min(y_begin * band->_y_scale, orig_y_size);
+  for (int to_y = y_begin; to_y < y_end; ++to_y) {
+    PN_float32 from_y1 = (to_y + 1.0) * band->_y_scale;
+    from_y1 = min(from_y1, orig_y_size);
+
+    PN_float32 from_x0 = 0.0;
+    for (int to_x = 0; to_x < band->_x_size; ++to_x) {
+      PN_float32 from_x1 = (to_x + 1.0) * band->_x_scale;
+      from_x1 = min(from_x1, orig_x_size);
+
+      // Now the box from (from_x0, from_y0) - (from_x1, from_y1)
+      // but not including (from_x1, from_y1) maps to the pixel (to_x, to_y).
+      switch (num_channels) {
+      case 1:
+        from.box_filter_region(dest[0], from_x0, from_y0, from_x1, from_y1);
+        break;
+
+      case 2:
+        from.box_filter_region(*(LPoint2f *)dest, from_x0, from_y0, from_x1, from_y1);
+        break;
+
+      case 3:
+        from.box_filter_region(*(LPoint3f *)dest, from_x0, from_y0, from_x1, from_y1);
+        break;
+
+      case 4:
+        from.box_filter_region(*(LPoint4f *)dest, from_x0, from_y0, from_x1, from_y1);
+        break;
+      }
+      dest += num_channels;
+
+      from_x0 = from_x1;
+    }
+    from_y0 = from_y1;
+    Thread::consider_yield();
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: PfmFile::xform_band
+//       Access: Private, Static
+//  Description: Performs xform() on the indicated rows, of a file
+//               with three or four channels.
+////////////////////////////////////////////////////////////////////
+void PfmFile::
+xform_band(void *data, int y_begin, int y_end) {
+  PfmXformBand *band = (PfmXformBand *)data;
+  PfmFile *self = band->_pfm;
+  const LMatrix4f &mat = band->_transform;
+  int num_channels = self->_num_channels;
+  bool check_points = self->_has_no_data_value;
+
+  PN_float32 *p = &self->_table[(size_t)y_begin * self->_x_size * num_channels];
+
+#ifdef __SSE__
+  __m128 row0 = _mm_setr_ps(mat(0, 0), mat(0, 1), mat(0, 2), mat(0, 3));
+  __m128 row1 = _mm_setr_ps(mat(1, 0), mat(1, 1), mat(1, 2), mat(1, 3));
+  __m128 row2 = _mm_setr_ps(mat(2, 0), mat(2, 1), mat(2, 2), mat(2, 3));
+  __m128 row3 = _mm_setr_ps(mat(3, 0), mat(3, 1), mat(3, 2), mat(3, 3));
+#endif
+
+  for (int yi = y_begin; yi < y_end; ++yi) {
+    for (int xi = 0; xi < self->_x_size; ++xi, p += num_channels) {
+      if (check_points && !self->has_point(xi, yi)) {
+        continue;
+      }
+
+#ifdef __SSE__
+      // This is xform_point_general(), four components at a time.
+      __m128 v = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p[0]), row0),
+                            _mm_mul_ps(_mm_set1_ps(p[1]), row1));
+      v = _mm_add_ps(v, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p[2]), row2), row3));
+      v = _mm_div_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3)));
+
+      // A 3-channel point is followed immediately by the next one, so
+      // we can't store all four components.
+      float result[4];
+      _mm_storeu_ps(result, v);
+      p[0] = result[0];
+      p[1] = result[1];
+      p[2] = result[2];
+#else
+      mat.xform_point_general_in_place(*(LPoint3f *)p);
+#endif
+    }
+    Thread::consider_yield();
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: PfmFile::merge_band
+//       Access: Private, Static
+//  Description: Performs merge() on the indicated rows.
+////////////////////////////////////////////////////////////////////
+void PfmFile::
+merge_band(void *data, int y_begin, int y_end) {
+  PfmMergeBand *band = (PfmMergeBand *)data;
+  PfmFile *self = band->_pfm;
+  const PfmFile *other = band->_other;
+  int num_channels = min(self->_num_channels, other->_num_channels);
+
+  for (int yi = y_begin; yi < y_end; ++yi) {
+    PN_float32 *p = &self->_table[(size_t)yi * self->_x_size * self->_num_channels];
+    const PN_float32 *q = &other->_table[(size_t)yi * other->_x_size * other->_num_channels];
+    for (int xi = 0; xi < self->_x_size; ++xi) {
+      if (!self->has_point(xi, yi) && other->has_point(xi, yi)) {
+        for (int c = 0; c < num_channels; ++c) {
+          p[c] = q[c];
+        }
+      }
+      p += self->_num_channels;
+      q += other->_num_channels;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: PfmFile::apply_mask_band
+//       Access: Private, Static
+//  Description: Performs apply_mask() on the indicated rows.
+////////////////////////////////////////////////////////////////////
+void PfmFile::
+apply_mask_band(void *data, int y_begin, int y_end) {
+  PfmMergeBand *band = (PfmMergeBand *)data;
+  PfmFile *self = band->_pfm;
+  const PfmFile *other = band->_other;
+  int num_channels = self->_num_channels;
+
+  for (int yi = y_begin; yi < y_end; ++yi) {
+    PN_float32 *p = &self->_table[(size_t)yi * self->_x_size * num_channels];
+    for (int xi = 0; xi < self->_x_size; ++xi) {
+      if (!other->has_point(xi, yi)) {
+        for (int c = 0; c < num_channels; ++c) {
+          p[c] = self->_no_data_value[c];
+        }
+      }
+      p += num_channels;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: PfmFile::scale_band
+//       Access: Private, Static
+//  Description: Performs operator *= on the indicated rows.
+////////////////////////////////////////////////////////////////////
+void PfmFile::
+scale_band(void *data, int y_begin, int y_end) {
+  PfmScaleBand *band = (PfmScaleBand *)data;
+  PfmFile *self = band->_pfm;
+  int num_channels = self->_num_channels;
+  PN_float32 multiplier = band->_factors[0];
+
+  PN_float32 *p = &self->_table[(size_t)y_begin * self->_x_size * num_channels];
+  if (!self->_has_no_data_value) {
+    // Every point is present, so the rows are just a run of floats.
+    size_t count = (size_t)(y_end - y_begin) * self->_x_size * num_channels;
+    for (size_t i = 0; i < count; ++i) {
+      p[i] *= multiplier;
+    }
+    return;
+  }
+
+  for (int yi = y_begin; yi < y_end; ++yi) {
+    for (int xi = 0; xi < self->_x_size; ++xi, p += num_channels) {
+      if (self->has_point(xi, yi)) {
+        for (int c = 0; c < num_channels; ++c) {
+          p[c] *= multiplier;
+        }
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: PfmFile::apply_exponent_band
+//       Access: Private, Static
+//  Description: Performs apply_exponent() on the indicated rows.
+////////////////////////////////////////////////////////////////////
+void PfmFile::
+apply_exponent_band(void *data, int y_begin, int y_end) {
+  PfmScaleBand *band = (PfmScaleBand *)data;
+  PfmFile *self = band->_pfm;
+  int num_channels = self->_num_channels;
+
+  PN_float32 *p = &self->_table[(size_t)y_begin * self->_x_size * num_channels];
+  size_t num_points = (size_t)(y_end - y_begin) * self->_x_size;
+  for (size_t i = 0; i < num_points; ++i, p += num_channels) {
+    for (int c = 0; c < num_channels; ++c) {
+      p[c] = cpow(p[c], band->_factors[c]);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: PfmFile::calc_min_max_band
+//       Access: Private, Static
+//  Description: Performs calc_min_max() on the indicated rows, and
+//               folds the result into the totals in the band data.
+////////////////////////////////////////////////////////////////////
+void PfmFile::
+calc_min_max_band(void *data, int y_begin, int y_end) {
+  PfmMinMaxBand *band = (PfmMinMaxBand *)data;
+  const PfmFile *self = band->_pfm;
+  int num_channels = self->_num_channels;
+  bool check_points = self->_has_no_data_value;
+  bool any_points = false;
+
+  // Thanks to the extra buffer at the end of the table, we can always
+  // read four floats at each point, and ignore the last.
+  const PN_float32 *p = &self->_table[(size_t)y_begin * self->_x_size * num_channels];
+
+#ifdef __SSE__
+  __m128 min_v = _mm_setzero_ps();
+  __m128 max_v = _mm_setzero_ps();
+#else
+  LVecBase3f min_v = LVecBase3f::zero();
+  LVecBase3f max_v = LVecBase3f::zero();
+#endif
+
+  for (int yi = y_begin; yi < y_end; ++yi) {
+    for (int xi = 0; xi < self->_x_size; ++xi, p += num_channels) {
+      if (check_points && !self->has_point(xi, yi)) {
+        continue;
+      }
+
+#ifdef __SSE__
+      __m128 v = _mm_loadu_ps(p);
+      if (!any_points) {
+        min_v = v;
+        max_v = v;
+        any_points = true;
+      } else {
+        min_v = _mm_min_ps(min_v, v);
+        max_v = _mm_max_ps(max_v, v);
+      }
+#else
+      const LPoint3f &v = *(const LPoint3f *)p;
+      if (!any_points) {
+        min_v = v;
+        max_v = v;
+        any_points = true;
+      } else {
+        min_v[0] = min(min_v[0], v[0]);
+        min_v[1] = min(min_v[1], v[1]);
+        min_v[2] = min(min_v[2], v[2]);
+        max_v[0] = max(max_v[0], v[0]);
+        max_v[1] = max(max_v[1], v[1]);
+        max_v[2] = max(max_v[2], v[2]);
+      }
+#endif
+    }
+  }
+
+  if (!any_points) {
+    return;
+  }
+
+#ifdef __SSE__
+  float min_f[4], max_f[4];
+  _mm_storeu_ps(min_f, min_v);
+  _mm_storeu_ps(max_f, max_v);
+  LVecBase3f min_depth(min_f[0], min_f[1], min_f[2]);
+  LVecBase3f max_depth(max_f[0], max_f[1], max_f[2]);
+#else
+  const LVecBase3f &min_depth = min_v;
+  const LVecBase3f &max_depth = max_v;
+#endif
+
+  LightMutexHolder holder(band->_lock);
+  if (!band->_any_points) {
+    band->_min_depth = min_depth;
+    band->_max_depth = max_depth;
+    band->_any_points = true;
+  } else {
+    band->_min_depth[0] = min(band->_min_depth[0], min_depth[0]);
+    band->_min_depth[1] = min(band->_min_depth[1], min_depth[1]);
+    band->_min_depth[2] = min(band->_min_depth[2], min_depth[2]);
+    band->_max_depth[0] = max(band->_max_depth[0], max_depth[0]);
+    band->_max_depth[1] = max(band->_max_depth[1], max_depth[1]);
+    band->_max_depth[2] = max(band->_max_depth[2], max_depth[2]);
+  }
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: PfmFile::has_point_noop
 //       Access: Private, Static
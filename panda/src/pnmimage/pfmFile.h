@@ -43,6 +43,8 @@ PUBLISHED:
   BLOCKING bool read(const Filename &fullpath);
   BLOCKING bool read(istream &in, const Filename &fullpath = Filename());
   BLOCKING bool read(PNMReader *reader);
+  BLOCKING bool read_rows(const Filename &fullpath, int y_begin, int y_end);
+  BLOCKING bool read_rows(PNMReader *reader, int y_begin, int y_end);
   BLOCKING bool write(const Filename &fullpath);
   BLOCKING bool write(ostream &out, const Filename &fullpath = Filename());
   BLOCKING bool write(PNMWriter *writer);
@@ -215,6 +217,17 @@ private:
   void fill_mini_grid(MiniGridCell *mini_grid, int x_size, int y_size,
                       int xi, int yi, int dist, int sxi, int syi) const;
 
+  // These perform the bulk operations on a band of rows at a time, so
+  // that a large file may be divided among threads with
+  // run_pnmimage_bands().
+  static void quick_filter_band(void *data, int y_begin, int y_end);
+  static void xform_band(void *data, int y_begin, int y_end);
+  static void merge_band(void *data, int y_begin, int y_end);
+  static void apply_mask_band(void *data, int y_begin, int y_end);
+  static void scale_band(void *data, int y_begin, int y_end);
+  static void apply_exponent_band(void *data, int y_begin, int y_end);
+  static void calc_min_max_band(void *data, int y_begin, int y_end);
+
   static bool has_point_noop(const PfmFile *file, int x, int y);
   static bool has_point_1(const PfmFile *file, int x, int y);
   static bool has_point_2(const PfmFile *file, int x, int y);
@@ -29,8 +29,9 @@
 // convolve twice with a one-dimensional kernel than once with a two-
 // dimensional kernel.  In the interim, a temporary matrix of type StoreType
 // (a numeric type, described below) is built which contains the results
-// from the first convolution.  The entire process is then repeated for
-// each channel in the image.
+// from the first convolution.  All of the channels of a pixel are
+// filtered together, except for sparse PfmFiles, for which the entire
+// process is repeated for each channel in the image.
 
 #include "pandabase.h"
 #include <math.h>
@@ -39,6 +40,13 @@
 
 #include "pnmImage.h"
 #include "pfmFile.h"
+#include "config_pnmimage.h"
+#include "mathNumbers.h"
+#include "pvector.h"
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
 
 // WorkType is an abstraction that allows the filtering process to be
 // recompiled to use either floating-point or integer arithmetic.  On SGI
@@ -94,80 +102,19 @@ static const WorkType source_max = 255;
 static const WorkType filter_max = 255;
 */
 
-// filter_row() filters a single row by convolving with a one-dimensional
-// kernel filter.  The kernel is defined by an array of weights in filter[],
-// where the ith element of filter corresponds to abs(d * scale), if scale>1.0,
-// and abs(d), if scale<=1.0, where d is the offset from the center and varies
-// from -filter_width to filter_width.
+// filter_sparse_row() filters a single row by convolving with a
+// one-dimensional kernel filter.  The kernel is defined by an array of
+// weights in filter[], where the ith element of filter corresponds to
+// abs(d * scale), if scale>1.0, and abs(d), if scale<=1.0, where d is
+// the offset from the center and varies from -filter_width to
+// filter_width.
 
 // Note that filter_width is not necessarily the length of the array; it is
 // the radius of interest of the filter function.  The array may need to be
 // larger (by a factor of scale), to adequately cover all the values.
 
-static void
-filter_row(StoreType dest[], int dest_len,
-           const StoreType source[], int source_len,
-           float scale,                    //  == dest_len / source_len
-           const WorkType filter[],
-           float filter_width) {
-  // If we are expanding the row (scale > 1.0), we need to look at a
-  // fractional granularity.  Hence, we scale our filter index by
-  // scale.  If we are compressing (scale < 1.0), we don't need to
-  // fiddle with the filter index, so we leave it at one.
-
-  float iscale;
-  if (scale < 1.0f) {
-    iscale = 1.0f;
-    filter_width /= scale;
-  } else {
-    iscale = scale;
-  }
-
-  for (int dest_x = 0; dest_x < dest_len; dest_x++) {
-    // The additional offset of 0.5 keeps the pixel centered.
-    float center = (dest_x + 0.5f) / scale - 0.5f;
-
-    // left and right are the starting and ending ranges of the radius of
-    // interest of the filter function.  We need to apply the filter to each
-    // value in this range.
-    int left = max((int)cfloor(center - filter_width), 0);
-    int right = min((int)cceil(center + filter_width), source_len - 1);
-
-    // right_center is the point just to the right of the center.  This
-    // allows us to flip the sign of the offset when we cross the center point.
-    int right_center = (int)cceil(center);
-
-    WorkType net_weight = 0;
-    WorkType net_value = 0;
-
-    int index, source_x;
-
-    // This loop is broken into two pieces--the left of center and the right
-    // of center--so we don't have to incur the overhead of calling fabs()
-    // each time through the loop.
-    for (source_x = left; source_x < right_center; source_x++) {
-      index = (int)(iscale * (center - source_x) + 0.5f);
-      net_value += filter[index] * source[source_x];
-      net_weight += filter[index];
-    }
-
-    for (; source_x <= right; source_x++) {
-      index = (int)(iscale * (source_x - center) + 0.5f);
-      net_value += filter[index] * source[source_x];
-      net_weight += filter[index];
-    }
-
-    if (net_weight > 0) {
-      dest[dest_x] = (StoreType)(net_value / net_weight);
-    } else {
-      dest[dest_x] = 0;
-    }
-  }
-  Thread::consider_yield();
-}
-
-// As above, but we also accept an array of weight values per
-// element, to support scaling a sparse array (as in a PfmFile).
+// It also accepts an array of weight values per element, to support
+// scaling a sparse array (as in a PfmFile).
 static void
 filter_sparse_row(StoreType dest[], StoreType dest_weight[], int dest_len,
                   const StoreType source[], const StoreType source_weight[], int source_len,
@@ -290,7 +237,7 @@ gaussian_filter_impl(float scale, float width,
 
   float sigma = width/2;
   filter_width = 3.0 * sigma;
-  int actual_width = (int)cceil((filter_width + 1) * fscale);
+  int actual_width = (int)cceil((filter_width + 1) * fscale) + 1;
 
   // G(x, y) = (1/(2 pi sigma^2)) * exp( - (x^2 + y^2) / (2 sigma^2))
 
@@ -310,217 +257,546 @@ gaussian_filter_impl(float scale, float width,
   }
 }
 
+static void
+lanczos_filter_impl(float scale, float width,
+                    WorkType *&filter, float &filter_width) {
+  float fscale;
+  if (scale < 1.0) {
+    // As above, expand the range of the filter function when
+    // compressing, and increase its granularity when expanding.
+    fscale = 1.0 / scale;
+  } else {
+    fscale = scale;
+  }
 
-// We have a function, defined in pnm-image-filter-core.cxx, that will scale
-// an image in both X and Y directions for a particular channel, by setting
-// up the temporary matrix appropriately and calling the above functions.
+  // The Lanczos kernel is the sinc function, windowed by the central
+  // lobe of a sinc function stretched to the radius a:
+  //   L(x) = sinc(x) * sinc(x / a), for |x| < a.
+  // Its negative lobes sharpen the result somewhat compared to the
+  // Gaussian filter.  A radius of 2 or 3 is typical.
+  float a = max(width, 1.0f);
+  filter_width = a;
+  int actual_width = (int)cceil((filter_width + 1) * fscale) + 1;
 
-// What we really need is a series of such functions, one for each channel,
-// and also one to scale by X first, and one to scale by Y first.  This sounds
-// a lot like a C++ template: we want to compile the same function several
-// times to work on slightly different sorts of things each time.  However,
-// the things we want to vary are the particular member functions of PNMImage
-// that we call (e.g. Red(), Green(), etc.), and we can't declare a template
-// of member functions, only of types.
+  filter = (WorkType *)PANDA_MALLOC_ARRAY(actual_width * sizeof(WorkType));
 
-// It's doable using templates.  It would involve the declaration of
-// lots of silly little functor objects.  This is much more compact
-// and no more difficult to read.
+  for (int i = 0; i < actual_width; i++) {
+    float x = i / fscale;
+    if (x == 0.0f) {
+      filter[i] = filter_max;
+    } else if (x < a) {
+      float px = MathNumbers::pi_f * x;
+      filter[i] = (WorkType)(filter_max * a * csin(px) * csin(px / a) / (px * px));
+    } else {
+      filter[i] = 0;
+    }
+  }
+}
 
-// The function in pnm-image-filter-core.cxx uses macros to access the member
-// functions of PNMImage.  Hence, we only need to redefine those macros
-// with each instance of the function to cause each instance to operate on
-// the correct member.
+static void
+mitchell_filter_impl(float scale, float width,
+                     WorkType *&filter, float &filter_width) {
+  float fscale;
+  if (scale < 1.0) {
+    fscale = 1.0 / scale;
+  } else {
+    fscale = scale;
+  }
 
+  // This is the cubic filter of Mitchell and Netravali, with their
+  // recommended B = C = 1/3.  The kernel is defined over |x| < 2; we
+  // stretch it to the requested radius, so a radius of 2 gives the
+  // standard filter.
+  static const float B = 1.0f / 3.0f;
+  static const float C = 1.0f / 3.0f;
 
-// These instances scale by X first, then by Y.
+  filter_width = max(width, 0.5f);
+  float kscale = 2.0f / filter_width;
+  int actual_width = (int)cceil((filter_width + 1) * fscale) + 1;
 
-#define FUNCTION_NAME filter_red_xy
-#define IMAGETYPE PNMImage
-#define ASIZE get_x_size
-#define BSIZE get_y_size
-#define GETVAL(a, b, channel) get_red(a, b)
-#define SETVAL(a, b, channel, v) set_red(a, b, v)
-#include "pnm-image-filter-core.cxx"
-#undef SETVAL
-#undef GETVAL
-#undef BSIZE
-#undef ASIZE
-#undef IMAGETYPE
-#undef FUNCTION_NAME
+  filter = (WorkType *)PANDA_MALLOC_ARRAY(actual_width * sizeof(WorkType));
 
-#define FUNCTION_NAME filter_green_xy
-#define IMAGETYPE PNMImage
-#define ASIZE get_x_size
-#define BSIZE get_y_size
-#define GETVAL(a, b, channel) get_green(a, b)
-#define SETVAL(a, b, channel, v) set_green(a, b, v)
-#include "pnm-image-filter-core.cxx"
-#undef SETVAL
-#undef GETVAL
-#undef BSIZE
-#undef ASIZE
-#undef IMAGETYPE
-#undef FUNCTION_NAME
+  for (int i = 0; i < actual_width; i++) {
+    float x = i * kscale / fscale;
+    float k;
+    if (x < 1.0f) {
+      k = ((12.0f - 9.0f * B - 6.0f * C) * x * x * x +
+           (-18.0f + 12.0f * B + 6.0f * C) * x * x +
+           (6.0f - 2.0f * B)) / 6.0f;
+    } else if (x < 2.0f) {
+      k = ((-B - 6.0f * C) * x * x * x +
+           (6.0f * B + 30.0f * C) * x * x +
+           (-12.0f * B - 48.0f * C) * x +
+           (8.0f * B + 24.0f * C)) / 6.0f;
+    } else {
+      k = 0.0f;
+    }
+    filter[i] = (WorkType)(filter_max * k);
+  }
+}
 
-#define FUNCTION_NAME filter_blue_xy
-#define IMAGETYPE PNMImage
-#define ASIZE get_x_size
-#define BSIZE get_y_size
-#define GETVAL(a, b, channel) get_blue(a, b)
-#define SETVAL(a, b, channel, v) set_blue(a, b, v)
-#include "pnm-image-filter-core.cxx"
-#undef SETVAL
-#undef GETVAL
-#undef BSIZE
-#undef ASIZE
-#undef IMAGETYPE
-#undef FUNCTION_NAME
 
-#define FUNCTION_NAME filter_gray_xy
-#define IMAGETYPE PNMImage
-#define ASIZE get_x_size
-#define BSIZE get_y_size
-#define GETVAL(a, b, channel) get_bright(a, b)
-#define SETVAL(a, b, channel, v) set_xel(a, b, v)
-#include "pnm-image-filter-core.cxx"
-#undef SETVAL
-#undef GETVAL
-#undef BSIZE
-#undef ASIZE
-#undef IMAGETYPE
-#undef FUNCTION_NAME
+// The PNMImage filters, and the PfmFile filters for images without a
+// no-data value, use the filter functions above, but not
+// filter_sparse_row().  Rather than filtering one channel at a time, they
+// filter all four channels of a pixel at once, which means the image
+// is only traversed once, and lets us use SIMD instructions on the four
+// channels together.  The work of each pass is also divided into bands
+// of rows, which are filtered in parallel on multiple threads.
+
+// A FilterTable is the result of the computation in
+// filter_sparse_row(), above, without the per-element weights, done in advance for each pixel of the destination row: the
+// range of source pixels that contribute to it, and the normalized
+// weight of each.  This is computed once for each axis, instead of
+// once for each row.
+class FilterTable {
+public:
+  void compute(int dest_len, int source_len, float width,
+               FilterFunction *make_filter);
+
+  class Entry {
+  public:
+    int _first;
+    int _count;
+    int _weights;
+  };
+  typedef pvector<Entry> Entries;
+  Entries _entries;
+  pvector<float> _weights;
+};
 
-#define FUNCTION_NAME filter_alpha_xy
-#define IMAGETYPE PNMImage
-#define ASIZE get_x_size
-#define BSIZE get_y_size
-#define GETVAL(a, b, channel) get_alpha(a, b)
-#define SETVAL(a, b, channel, v) set_alpha(a, b, v)
-#include "pnm-image-filter-core.cxx"
-#undef SETVAL
-#undef GETVAL
-#undef BSIZE
-#undef ASIZE
-#undef IMAGETYPE
-#undef FUNCTION_NAME
+////////////////////////////////////////////////////////////////////
+//     Function: FilterTable::compute
+//  Description: Builds the table for scaling a row of source_len
+//               pixels to dest_len pixels with the indicated filter.
+////////////////////////////////////////////////////////////////////
+void FilterTable::
+compute(int dest_len, int source_len, float width,
+        FilterFunction *make_filter) {
+  float scale = (float)dest_len / (float)source_len;
 
+  WorkType *filter;
+  float filter_width;
+  make_filter(scale, width, filter, filter_width);
 
-// These instances scale by Y first, then by X.
+  float iscale;
+  if (scale < 1.0f) {
+    iscale = 1.0f;
+    filter_width /= scale;
+  } else {
+    iscale = scale;
+  }
 
-#define FUNCTION_NAME filter_red_yx
-#define IMAGETYPE PNMImage
-#define ASIZE get_y_size
-#define BSIZE get_x_size
-#define GETVAL(a, b, channel) get_red(b, a)
-#define SETVAL(a, b, channel, v) set_red(b, a, v)
-#include "pnm-image-filter-core.cxx"
-#undef SETVAL
-#undef GETVAL
-#undef BSIZE
-#undef ASIZE
-#undef IMAGETYPE
-#undef FUNCTION_NAME
+  _entries.resize(dest_len);
+  _weights.clear();
 
-#define FUNCTION_NAME filter_green_yx
-#define IMAGETYPE PNMImage
-#define ASIZE get_y_size
-#define BSIZE get_x_size
-#define GETVAL(a, b, channel) get_green(b, a)
-#define SETVAL(a, b, channel, v) set_green(b, a, v)
-#include "pnm-image-filter-core.cxx"
-#undef SETVAL
-#undef GETVAL
-#undef BSIZE
-#undef ASIZE
-#undef IMAGETYPE
-#undef FUNCTION_NAME
+  for (int dest_x = 0; dest_x < dest_len; dest_x++) {
+    float center = (dest_x + 0.5f) / scale - 0.5f;
+    int left = max((int)cfloor(center - filter_width), 0);
+    int right = min((int)cceil(center + filter_width), source_len - 1);
+    int right_center = (int)cceil(center);
 
-#define FUNCTION_NAME filter_blue_yx
-#define IMAGETYPE PNMImage
-#define ASIZE get_y_size
-#define BSIZE get_x_size
-#define GETVAL(a, b, channel) get_blue(b, a)
-#define SETVAL(a, b, channel, v) set_blue(b, a, v)
-#include "pnm-image-filter-core.cxx"
-#undef SETVAL
-#undef GETVAL
-#undef BSIZE
-#undef ASIZE
-#undef IMAGETYPE
-#undef FUNCTION_NAME
+    Entry &entry = _entries[dest_x];
+    entry._first = left;
+    entry._weights = (int)_weights.size();
 
-#define FUNCTION_NAME filter_gray_yx
-#define IMAGETYPE PNMImage
-#define ASIZE get_y_size
-#define BSIZE get_x_size
-#define GETVAL(a, b, channel) get_bright(b, a)
-#define SETVAL(a, b, channel, v) set_xel(b, a, v)
-#include "pnm-image-filter-core.cxx"
-#undef SETVAL
-#undef GETVAL
-#undef BSIZE
-#undef ASIZE
-#undef IMAGETYPE
-#undef FUNCTION_NAME
+    WorkType net_weight = 0;
+    int index, source_x;
+    for (source_x = left; source_x < right_center; source_x++) {
+      index = (int)(iscale * (center - source_x) + 0.5f);
+      _weights.push_back((float)filter[index]);
+      net_weight += filter[index];
+    }
+    for (; source_x <= right; source_x++) {
+      index = (int)(iscale * (source_x - center) + 0.5f);
+      _weights.push_back((float)filter[index]);
+      net_weight += filter[index];
+    }
 
-#define FUNCTION_NAME filter_alpha_yx
-#define IMAGETYPE PNMImage
-#define ASIZE get_y_size
-#define BSIZE get_x_size
-#define GETVAL(a, b, channel) get_alpha(b, a)
-#define SETVAL(a, b, channel, v) set_alpha(b, a, v)
-#include "pnm-image-filter-core.cxx"
-#undef SETVAL
-#undef GETVAL
-#undef BSIZE
-#undef ASIZE
-#undef IMAGETYPE
-#undef FUNCTION_NAME
+    entry._count = (int)_weights.size() - entry._weights;
+    if (net_weight > 0) {
+      for (int i = entry._weights; i < (int)_weights.size(); ++i) {
+        _weights[i] /= (float)net_weight;
+      }
+    } else {
+      // As in filter_sparse_row(), a pixel with no weight comes out zero.
+      _weights.resize(entry._weights);
+      entry._count = 0;
+    }
+  }
 
+  PANDA_FREE_ARRAY(filter);
+}
 
-// filter_image pulls everything together, and filters one image into
-// another.  Both images can be the same with no ill effects.
+// filter_row4() filters a row of pixels of four floats each.  The weights have already been normalized, so
+// this is simply a weighted sum for each destination pixel.
 static void
-filter_image(PNMImage &dest, const PNMImage &source,
-             float width, FilterFunction *make_filter) {
+filter_row4(float *dest, const float *source, const FilterTable &table) {
+  if (table._weights.empty()) {
+    memset(dest, 0, table._entries.size() * 4 * sizeof(float));
+    return;
+  }
 
-  // We want to scale by the smallest destination axis first, for a
-  // slight performance gain.
+  const float *weights = &table._weights[0];
+  FilterTable::Entries::const_iterator ei;
+  for (ei = table._entries.begin(); ei != table._entries.end(); ++ei) {
+    const FilterTable::Entry &entry = (*ei);
+    const float *sp = source + entry._first * 4;
+    const float *wp = weights + entry._weights;
+
+#ifdef __SSE__
+    __m128 acc = _mm_setzero_ps();
+    for (int i = 0; i < entry._count; ++i) {
+      acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(wp[i]),
+                                       _mm_loadu_ps(sp + i * 4)));
+    }
+    _mm_storeu_ps(dest, acc);
+#else
+    float r = 0.0f, g = 0.0f, b = 0.0f, a = 0.0f;
+    for (int i = 0; i < entry._count; ++i) {
+      float w = wp[i];
+      r += w * sp[i * 4];
+      g += w * sp[i * 4 + 1];
+      b += w * sp[i * 4 + 2];
+      a += w * sp[i * 4 + 3];
+    }
+    dest[0] = r;
+    dest[1] = g;
+    dest[2] = b;
+    dest[3] = a;
+#endif  // __SSE__
+
+    dest += 4;
+  }
+}
 
-  // In the PNMImage case (unlike the PfmFile case), the channel
-  // parameter is not used.  We *could* use it to avoid the
-  // replication of quite so many functions, but we replicate them
-  // anyway, for another tiny performance gain.
+// An ImageFilter scales an image along both axes.  As in
+// pnm-image-filter-sparse-core.cxx, we refer to the axis that is scaled first
+// as A, and the other as B; the intermediate matrix is stored in
+// column-major order, so that each pass reads contiguous rows.  Each
+// pixel is carried through as four floats, whatever its channels
+// mean; the subclasses below take care of reading and writing lines of
+// pixels to and from a particular kind of image.
+class ImageFilter {
+public:
+  ImageFilter(int source_x_size, int source_y_size,
+              int dest_x_size, int dest_y_size, bool a_is_x,
+              float width, FilterFunction *make_filter);
+  virtual ~ImageFilter();
+
+  void run();
+
+  void filter_a(int begin, int end);
+  void filter_b(int begin, int end);
+  static void filter_a_band(void *data, int begin, int end);
+  static void filter_b_band(void *data, int begin, int end);
+
+protected:
+  virtual void get_line(int b, float *pixels) const=0;
+  virtual void set_line(int a, const float *pixels)=0;
+
+  bool _a_is_x;
+  int _source_asize, _source_bsize;
+  int _dest_asize, _dest_bsize;
+
+private:
+  FilterTable _a_table, _b_table;
+  float *_matrix;
+};
 
-  if (dest.get_x_size() <= dest.get_y_size()) {
-    if (dest.is_grayscale() || source.is_grayscale()) {
-      filter_gray_xy(dest, source, width, make_filter, 0);
-    } else {
-      filter_red_xy(dest, source, width, make_filter, 0);
-      filter_green_xy(dest, source, width, make_filter, 0);
-      filter_blue_xy(dest, source, width, make_filter, 0);
+////////////////////////////////////////////////////////////////////
+//     Function: ImageFilter::Constructor
+//  Description:
+////////////////////////////////////////////////////////////////////
+ImageFilter::
+ImageFilter(int source_x_size, int source_y_size,
+            int dest_x_size, int dest_y_size, bool a_is_x,
+            float width, FilterFunction *make_filter) :
+  _a_is_x(a_is_x)
+{
+  if (a_is_x) {
+    _source_asize = source_x_size;
+    _source_bsize = source_y_size;
+    _dest_asize = dest_x_size;
+    _dest_bsize = dest_y_size;
+  } else {
+    _source_asize = source_y_size;
+    _source_bsize = source_x_size;
+    _dest_asize = dest_y_size;
+    _dest_bsize = dest_x_size;
+  }
+
+  _a_table.compute(_dest_asize, _source_asize, width, make_filter);
+  _b_table.compute(_dest_bsize, _source_bsize, width, make_filter);
+
+  size_t matrix_size = (size_t)_dest_asize * (size_t)_source_bsize * 4;
+  _matrix = (float *)PANDA_MALLOC_ARRAY(matrix_size * sizeof(float));
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: ImageFilter::Destructor
+//  Description:
+////////////////////////////////////////////////////////////////////
+ImageFilter::
+~ImageFilter() {
+  PANDA_FREE_ARRAY(_matrix);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: ImageFilter::run
+//  Description: Scales the source image into the destination image.
+//               Each pass must be finished before the next can begin,
+//               since the second pass reads columns written by all
+//               of the bands of the first.
+////////////////////////////////////////////////////////////////////
+void ImageFilter::
+run() {
+  run_pnmimage_bands(&filter_a_band, this, _source_bsize, _dest_asize);
+  run_pnmimage_bands(&filter_b_band, this, _dest_asize, _dest_bsize);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: ImageFilter::filter_a_band
+//  Description: The ParallelBandFunc for filter_a().
+////////////////////////////////////////////////////////////////////
+void ImageFilter::
+filter_a_band(void *data, int begin, int end) {
+  ((ImageFilter *)data)->filter_a(begin, end);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: ImageFilter::filter_b_band
+//  Description: The ParallelBandFunc for filter_b().
+////////////////////////////////////////////////////////////////////
+void ImageFilter::
+filter_b_band(void *data, int begin, int end) {
+  ((ImageFilter *)data)->filter_b(begin, end);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: ImageFilter::filter_a
+//  Description: Scales the indicated range of source rows in the A
+//               direction, into the intermediate matrix.
+////////////////////////////////////////////////////////////////////
+void ImageFilter::
+filter_a(int begin, int end) {
+  float *temp_source = (float *)PANDA_MALLOC_ARRAY(_source_asize * 4 * sizeof(float));
+  float *temp_dest = (float *)PANDA_MALLOC_ARRAY(_dest_asize * 4 * sizeof(float));
+
+  for (int b = begin; b < end; b++) {
+    get_line(b, temp_source);
+
+    filter_row4(temp_dest, temp_source, _a_table);
+
+    for (int a = 0; a < _dest_asize; a++) {
+      float *mp = _matrix + ((size_t)a * _source_bsize + b) * 4;
+      mp[0] = temp_dest[a * 4];
+      mp[1] = temp_dest[a * 4 + 1];
+      mp[2] = temp_dest[a * 4 + 2];
+      mp[3] = temp_dest[a * 4 + 3];
     }
+    Thread::consider_yield();
+  }
 
-    if (dest.has_alpha() && source.has_alpha()) {
-      filter_alpha_xy(dest, source, width, make_filter, 0);
+  PANDA_FREE_ARRAY(temp_source);
+  PANDA_FREE_ARRAY(temp_dest);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: ImageFilter::filter_b
+//  Description: Scales the indicated range of columns of the
+//               intermediate matrix in the B direction, into the
+//               destination image.
+////////////////////////////////////////////////////////////////////
+void ImageFilter::
+filter_b(int begin, int end) {
+  float *temp_dest = (float *)PANDA_MALLOC_ARRAY(_dest_bsize * 4 * sizeof(float));
+
+  for (int a = begin; a < end; a++) {
+    filter_row4(temp_dest, _matrix + (size_t)a * _source_bsize * 4, _b_table);
+    set_line(a, temp_dest);
+    Thread::consider_yield();
+  }
+
+  PANDA_FREE_ARRAY(temp_dest);
+}
+
+// A PNMImageFilter carries each pixel of a PNMImage as red, green,
+// blue and alpha, or as the gray value in the first float and alpha in
+// the last.
+class PNMImageFilter : public ImageFilter {
+public:
+  PNMImageFilter(PNMImage &dest, const PNMImage &source, bool a_is_x,
+                 float width, FilterFunction *make_filter);
+
+protected:
+  virtual void get_line(int b, float *pixels) const;
+  virtual void set_line(int a, const float *pixels);
+
+private:
+  PNMImage &_dest;
+  const PNMImage &_source;
+  bool _gray;
+  bool _alpha;
+};
+
+////////////////////////////////////////////////////////////////////
+//     Function: PNMImageFilter::Constructor
+//  Description:
+////////////////////////////////////////////////////////////////////
+PNMImageFilter::
+PNMImageFilter(PNMImage &dest, const PNMImage &source, bool a_is_x,
+               float width, FilterFunction *make_filter) :
+  ImageFilter(source.get_x_size(), source.get_y_size(),
+              dest.get_x_size(), dest.get_y_size(), a_is_x,
+              width, make_filter),
+  _dest(dest),
+  _source(source)
+{
+  _gray = (dest.is_grayscale() || source.is_grayscale());
+  _alpha = (dest.has_alpha() && source.has_alpha());
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: PNMImageFilter::get_line
+//  Description: Reads the line of source pixels at the indicated B
+//               position into four floats per pixel.
+////////////////////////////////////////////////////////////////////
+void PNMImageFilter::
+get_line(int b, float *pixels) const {
+  for (int a = 0; a < _source_asize; a++) {
+    int x = _a_is_x ? a : b;
+    int y = _a_is_x ? b : a;
+    float *pixel = pixels + a * 4;
+
+    if (_gray) {
+      pixel[0] = _source.get_bright(x, y);
+      pixel[1] = 0.0f;
+      pixel[2] = 0.0f;
+      pixel[3] = _alpha ? _source.get_alpha(x, y) : 0.0f;
+    } else {
+      LColorf color = _source.get_xel_a(x, y);
+      pixel[0] = color[0];
+      pixel[1] = color[1];
+      pixel[2] = color[2];
+      pixel[3] = _alpha ? color[3] : 0.0f;
     }
+  }
+}
 
-  } else {
-    if (dest.is_grayscale() || source.is_grayscale()) {
-      filter_gray_yx(dest, source, width, make_filter, 0);
+////////////////////////////////////////////////////////////////////
+//     Function: PNMImageFilter::set_line
+//  Description: Stores a line of pixels, as returned by get_line(),
+//               into the destination image at the indicated A
+//               position.  Alpha is left alone unless both images
+//               have it.
+////////////////////////////////////////////////////////////////////
+void PNMImageFilter::
+set_line(int a, const float *pixels) {
+  for (int b = 0; b < _dest_bsize; b++) {
+    int x = _a_is_x ? a : b;
+    int y = _a_is_x ? b : a;
+    const float *pixel = pixels + b * 4;
+
+    if (_gray) {
+      _dest.set_xel(x, y, pixel[0]);
+      if (_alpha) {
+        _dest.set_alpha(x, y, pixel[3]);
+      }
+    } else if (_alpha) {
+      _dest.set_xel_a(x, y, LColorf(pixel[0], pixel[1], pixel[2], pixel[3]));
     } else {
-      filter_red_yx(dest, source, width, make_filter, 0);
-      filter_green_yx(dest, source, width, make_filter, 0);
-      filter_blue_yx(dest, source, width, make_filter, 0);
+      _dest.set_xel(x, y, LRGBColorf(pixel[0], pixel[1], pixel[2]));
     }
+  }
+}
+
+// A PfmImageFilter carries the (up to four) channels of a PfmFile that
+// both files have in common; the remaining floats are zero.
+class PfmImageFilter : public ImageFilter {
+public:
+  PfmImageFilter(PfmFile &dest, const PfmFile &source, bool a_is_x,
+                 float width, FilterFunction *make_filter);
+
+protected:
+  virtual void get_line(int b, float *pixels) const;
+  virtual void set_line(int a, const float *pixels);
+
+private:
+  PfmFile &_dest;
+  const PfmFile &_source;
+  int _num_channels;
+};
+
+////////////////////////////////////////////////////////////////////
+//     Function: PfmImageFilter::Constructor
+//  Description:
+////////////////////////////////////////////////////////////////////
+PfmImageFilter::
+PfmImageFilter(PfmFile &dest, const PfmFile &source, bool a_is_x,
+               float width, FilterFunction *make_filter) :
+  ImageFilter(source.get_x_size(), source.get_y_size(),
+              dest.get_x_size(), dest.get_y_size(), a_is_x,
+              width, make_filter),
+  _dest(dest),
+  _source(source)
+{
+  _num_channels = min(dest.get_num_channels(), source.get_num_channels());
+}
 
-    if (dest.has_alpha() && source.has_alpha()) {
-      filter_alpha_yx(dest, source, width, make_filter, 0);
+////////////////////////////////////////////////////////////////////
+//     Function: PfmImageFilter::get_line
+//  Description: Reads the line of source points at the indicated B
+//               position into four floats per point.
+////////////////////////////////////////////////////////////////////
+void PfmImageFilter::
+get_line(int b, float *pixels) const {
+  memset(pixels, 0, _source_asize * 4 * sizeof(float));
+  for (int a = 0; a < _source_asize; a++) {
+    int x = _a_is_x ? a : b;
+    int y = _a_is_x ? b : a;
+    float *pixel = pixels + a * 4;
+    for (int c = 0; c < _num_channels; ++c) {
+      pixel[c] = _source.get_channel(x, y, c);
     }
   }
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: PfmImageFilter::set_line
+//  Description: Stores a line of points, as returned by get_line(),
+//               into the destination file at the indicated A
+//               position.
+////////////////////////////////////////////////////////////////////
+void PfmImageFilter::
+set_line(int a, const float *pixels) {
+  for (int b = 0; b < _dest_bsize; b++) {
+    int x = _a_is_x ? a : b;
+    int y = _a_is_x ? b : a;
+    const float *pixel = pixels + b * 4;
+    for (int c = 0; c < _num_channels; ++c) {
+      _dest.set_channel(x, y, c, pixel[c]);
+    }
+  }
+}
+
+// filter_image pulls everything together, and filters one image into
+// another.  Both images can be the same with no ill effects.
+static void
+filter_image(PNMImage &dest, const PNMImage &source,
+             float width, FilterFunction *make_filter) {
+  if (!dest.is_valid() || !source.is_valid()) {
+    return;
+  }
+
+  // We want to scale by the smallest destination axis first, for a
+  // slight performance gain.
+  bool a_is_x = (dest.get_x_size() <= dest.get_y_size());
+
+  PNMImageFilter filter(dest, source, a_is_x, width, make_filter);
+  filter.run();
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: PNMImage::box_filter_from
 //       Access: Public
@@ -549,39 +825,38 @@ gaussian_filter_from(float width, const PNMImage &copy) {
   filter_image(*this, copy, width, &gaussian_filter_impl);
 }
 
-// Now we do it again, this time for PfmFile.  In this case we also
-// need to support the sparse variants, since PfmFiles can be
-// incomplete.  However, we don't need to have a different function
-// for each channel.
-
-#define FUNCTION_NAME filter_pfm_xy
-#define IMAGETYPE PfmFile
-#define ASIZE get_x_size
-#define BSIZE get_y_size
-#define GETVAL(a, b, channel) get_channel(a, b, channel)
-#define SETVAL(a, b, channel, v) set_channel(a, b, channel, v)
-#include "pnm-image-filter-core.cxx"
-#undef SETVAL
-#undef GETVAL
-#undef BSIZE
-#undef ASIZE
-#undef IMAGETYPE
-#undef FUNCTION_NAME
+////////////////////////////////////////////////////////////////////
+//     Function: PNMImage::lanczos_filter_from
+//       Access: Public
+//  Description: Makes a resized copy of the indicated image into this
+//               one using a Lanczos filter of the indicated radius
+//               (the number of lobes; 2 or 3 is typical).  This
+//               gives a sharper result than the Gaussian filter,
+//               at the cost of some ringing near hard edges.
+////////////////////////////////////////////////////////////////////
+void PNMImage::
+lanczos_filter_from(float width, const PNMImage &copy) {
+  filter_image(*this, copy, width, &lanczos_filter_impl);
+}
 
-#define FUNCTION_NAME filter_pfm_yx
-#define IMAGETYPE PfmFile
-#define ASIZE get_y_size
-#define BSIZE get_x_size
-#define GETVAL(a, b, channel) get_channel(b, a, channel)
-#define SETVAL(a, b, channel, v) set_channel(b, a, channel, v)
-#include "pnm-image-filter-core.cxx"
-#undef SETVAL
-#undef GETVAL
-#undef BSIZE
-#undef ASIZE
-#undef IMAGETYPE
-#undef FUNCTION_NAME
+////////////////////////////////////////////////////////////////////
+//     Function: PNMImage::mitchell_filter_from
+//       Access: Public
+//  Description: Makes a resized copy of the indicated image into this
+//               one using the Mitchell-Netravali cubic filter.  The
+//               standard filter has a radius of 2; other values
+//               stretch or squash it accordingly.
+////////////////////////////////////////////////////////////////////
+void PNMImage::
+mitchell_filter_from(float width, const PNMImage &copy) {
+  filter_image(*this, copy, width, &mitchell_filter_impl);
+}
 
+// A PfmFile with a no-data value may be incomplete, and the missing
+// points must not contribute to the result.  These are filtered one
+// channel at a time, with the sparse variant of the function defined
+// in pnm-image-filter-sparse-core.cxx; we need two instances of it, one
+// to scale by X first, and one to scale by Y first.
 
 #define FUNCTION_NAME filter_pfm_sparse_xy
 #define IMAGETYPE PfmFile
@@ -636,17 +911,10 @@ filter_image(PfmFile &dest, const PfmFile &source,
       }
     }
   } else {
-    // We can use the slightly faster fully-specified variant.
-    if (dest.get_x_size() <= dest.get_y_size()) {
-      for (int ci = 0; ci < num_channels; ++ci) {
-        filter_pfm_xy(dest, source, width, make_filter, ci);
-      }
-      
-    } else {
-      for (int ci = 0; ci < num_channels; ++ci) {
-        filter_pfm_yx(dest, source, width, make_filter, ci);
-      }
-    }
+    // We can filter all of the channels at once.
+    bool a_is_x = (dest.get_x_size() <= dest.get_y_size());
+    PfmImageFilter filter(dest, source, a_is_x, width, make_filter);
+    filter.run();
   }
 }
 
@@ -756,6 +1024,68 @@ box_filter_region(const PNMImage &image,
   return color;
 }
 
+// A QuickFilter performs quick_filter_from() on a band of rows at a
+// time, so that the rows may be divided among threads.
+class QuickFilter {
+public:
+  PNMImage *_dest;
+  const PNMImage *_from;
+  int _to_xs, _to_ys;
+  int _to_xoff, _to_yoff;
+  float _x_scale, _y_scale;
+
+  void filter_rows(int begin, int end);
+  static void filter_rows_band(void *data, int begin, int end);
+};
+
+////////////////////////////////////////////////////////////////////
+//     Function: QuickFilter::filter_rows
+//  Description: Fills in the destination rows begin through end - 1,
+//               counted from the first row to which quick_filter_from()
+//               writes.
+////////////////////////////////////////////////////////////////////
+void QuickFilter::
+filter_rows(int begin, int end) {
+  int first_to_y = max(0, -_to_yoff);
+  int first_to_x = max(0, -_to_xoff);
+  int last_to_x = min(_to_xs, _dest->get_x_size() - _to_xoff);
+
+  float from_x0, from_x1, from_y0, from_y1;
+  int to_x, to_y;
+
+  LColorf color;
+
+  from_y0 = (first_to_y + begin) * _y_scale;
+  for (to_y = first_to_y + begin; to_y < first_to_y + end; to_y++) {
+    from_y1 = (to_y+1) * _y_scale;
+
+    from_x0 = first_to_x * _x_scale;
+    for (to_x = first_to_x; to_x < last_to_x; to_x++) {
+      from_x1 = (to_x+1) * _x_scale;
+
+      // Now the box from (from_x0, from_y0) - (from_x1, from_y1)
+      // but not including (from_x1, from_y1) maps to the pixel (to_x, to_y).
+      color = box_filter_region(*_from,
+                                from_x0, from_y0, from_x1, from_y1);
+
+      _dest->set_xel_a(_to_xoff + to_x, _to_yoff + to_y, color);
+
+      from_x0 = from_x1;
+    }
+    from_y0 = from_y1;
+    Thread::consider_yield();
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: QuickFilter::filter_rows_band
+//  Description: The ParallelBandFunc for filter_rows().
+////////////////////////////////////////////////////////////////////
+void QuickFilter::
+filter_rows_band(void *data, int begin, int end) {
+  ((QuickFilter *)data)->filter_rows(begin, end);
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: PNMImage::quick_filter_from
 //       Access: Public
@@ -770,45 +1100,31 @@ box_filter_region(const PNMImage &image,
 ////////////////////////////////////////////////////////////////////
 void PNMImage::
 quick_filter_from(const PNMImage &from, int xborder, int yborder) {
+  QuickFilter filter;
+  filter._dest = this;
+  filter._from = &from;
+
   int from_xs = from.get_x_size();
   int from_ys = from.get_y_size();
 
-  int to_xs = get_x_size() - xborder;
-  int to_ys = get_y_size() - yborder;
+  filter._to_xs = get_x_size() - xborder;
+  filter._to_ys = get_y_size() - yborder;
 
-  int to_xoff = xborder / 2;
-  int to_yoff = yborder / 2;
-
-  float from_x0, from_x1, from_y0, from_y1;
-  int to_x, to_y;
-
-  float x_scale = (float)from_xs / (float)to_xs;
-  float y_scale = (float)from_ys / (float)to_ys;
-
-  LColorf color;
+  filter._to_xoff = xborder / 2;
+  filter._to_yoff = yborder / 2;
 
-  from_y0 = max(0, -to_yoff) * y_scale;
-  for (to_y = max(0, -to_yoff);
-       to_y < min(to_ys, get_y_size()-to_yoff);
-       to_y++) {
-    from_y1 = (to_y+1) * y_scale;
+  filter._x_scale = (float)from_xs / (float)filter._to_xs;
+  filter._y_scale = (float)from_ys / (float)filter._to_ys;
 
-    from_x0 = max(0, -to_xoff) * x_scale;
-    for (to_x = max(0, -to_xoff);
-         to_x < min(to_xs, get_x_size()-to_xoff);
-         to_x++) {
-      from_x1 = (to_x+1) * x_scale;
-
-      // Now the box from (from_x0, from_y0) - (from_x1, from_y1)
-      // but not including (from_x1, from_y1) maps to the pixel (to_x, to_y).
-      color = box_filter_region(from,
-                                from_x0, from_y0, from_x1, from_y1);
-
-      set_xel_a(to_xoff + to_x, to_yoff + to_y, color);
-
-      from_x0 = from_x1;
-    }
-    from_y0 = from_y1;
-    Thread::consider_yield();
+  int first_to_y = max(0, -filter._to_yoff);
+  int last_to_y = min(filter._to_ys, get_y_size() - filter._to_yoff);
+  int num_rows = last_to_y - first_to_y;
+  if (num_rows <= 0) {
+    return;
   }
+
+  // Each destination pixel covers about x_scale * y_scale source
+  // pixels; that is the real measure of the work per row.
+  int row_len = (int)(get_x_size() * max(filter._x_scale * filter._y_scale, 1.0f));
+  run_pnmimage_bands(&QuickFilter::filter_rows_band, &filter, num_rows, row_len);
 }
@@ -257,6 +257,8 @@ PUBLISHED:
   void unfiltered_stretch_from(const PNMImage &copy);
   void box_filter_from(float radius, const PNMImage &copy);
   void gaussian_filter_from(float radius, const PNMImage &copy);
+  void lanczos_filter_from(float radius, const PNMImage &copy);
+  void mitchell_filter_from(float radius, const PNMImage &copy);
   void quick_filter_from(const PNMImage &copy,
                          int xborder = 0, int yborder = 0);
 
@@ -13,6 +13,7 @@
 ////////////////////////////////////////////////////////////////////
 
 #include "pnmReader.h"
+#include "pfmFile.h"
 #include "virtualFileSystem.h"
 #include "thread.h"
 
@@ -94,6 +95,31 @@ read_pfm(PfmFile &pfm) {
   return false;
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: PNMReader::read_pfm_rows
+//       Access: Public, Virtual
+//  Description: Reads only the rows y_begin through y_end - 1 of the
+//               floating-point data into the indicated PfmFile, which
+//               is resized to hold just those rows.  Returns true on
+//               success, false on failure.
+//
+//               The default implementation reads the whole file with
+//               read_pfm() and discards the other rows; derived
+//               classes that can skip directly to a row should
+//               override it.
+////////////////////////////////////////////////////////////////////
+bool PNMReader::
+read_pfm_rows(PfmFile &pfm, int y_begin, int y_end) {
+  if (!read_pfm(pfm)) {
+    return false;
+  }
+
+  y_begin = max(y_begin, 0);
+  y_end = min(y_end, pfm.get_y_size());
+  pfm.apply_crop(0, pfm.get_x_size(), y_begin, max(y_begin, y_end));
+  return true;
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: PNMReader::read_data
 //       Access: Public, Virtual
@@ -41,6 +41,7 @@ public:
   virtual void prepare_read();
   virtual bool is_floating_point();
   virtual bool read_pfm(PfmFile &pfm);
+  virtual bool read_pfm_rows(PfmFile &pfm, int y_begin, int y_end);
   virtual int read_data(xel *array, xelval *alpha);
   virtual bool supports_read_row() const;
   virtual bool read_row(xel *array, xelval *alpha, int x_size, int y_size);
@@ -0,0 +1,430 @@
+// Filename: test_pnmfilter.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "pandabase.h"
+#include "pnmImage.h"
+#include "pfmFile.h"
+#include "config_pnmimage.h"
+#include "trueClock.h"
+#include "randomizer.h"
+#include "load_prc_file.h"
+
+// This program measures the throughput of each of the PNMImage
+// resizing filters, in megapixels of source image per second, when
+// halving and when doubling an RGBA image.  Each measurement is taken
+// both on one thread and on as many as pnmimage-num-threads allows,
+// and the two results are compared pixel for pixel, since dividing
+// the work among threads must not change the output.  The PfmFile
+// operations that are divided among threads are checked the same way.
+//
+// Before any of that, it filters a small fixed image with each of the
+// filters that existed before they were rewritten to filter all
+// channels at once, and compares the results to the output of the
+// old code, to show that the rewrite doesn't change them.
+//
+// The program exits with a nonzero status if any result differs.
+//
+// Usage: test_pnmfilter [size [threads]]
+
+static const int num_iterations = 3;
+
+enum FilterType {
+  FT_box,
+  FT_gaussian,
+  FT_lanczos,
+  FT_mitchell,
+  FT_quick
+};
+
+static const char *const filter_names[] = {
+  "box", "gaussian", "lanczos", "mitchell", "quick",
+};
+static const int num_filter_types = 5;
+
+// The expected results of filtering the reference images, as
+// produced by the filter code before the rewrite: one RGBA pixel per
+// eight hex digits, in rows from the top.
+static const char *const box_reduce_expected =
+  "11177d95331768aa55178c9580176ca0aa1783aacc178b95ee1777aa11458baa"
+  "33455a9555457eaa804588a0aa457595cc457daaee458595117f8fa0337f7ba0"
+  "557f66a0807f8ca0aa7f88a0cc7f73a0ee7f89a011b9779533b99baa55b96a95"
+  "80b990a0aab97daaccb98595eeb970aa11e785aa33e78d9555e778aa80e782a0"
+  "aae78c95cce793aaeee76295";
+
+static const char *const gaussian_reduce_expected =
+  "141c7697331c78a5551c889a7f1c759faa1c87a5cc1c909aeb1c7ba814457ca5"
+  "3345739c554581a3804587a0aa457b9ccc458aa3eb45889a147f86a0337f7ba0"
+  "557f73a0807f88a0aa7f80a0cc7f7fa0eb7f8fa014b9799a33b983a355b97b9c"
+  "80b97ba0aab985a3ccb97d9cebb97ea514e283a833e2829a55e27fa580e278a0"
+  "aae2869acce282a5ebe27197";
+
+static const char *const quick_reduce_expected =
+  "090c62402b0c78ff4d0c8e406f0c64ff910c7a40b30c90ffd50ca640f70c7cff"
+  "093a94ff2b3a6a404d3a80ff6f3a9640913a6cffb33a8240d53a98fff73a6e40"
+  "096886402b689cff4d6872406f6888ff91685e40b36874ffd5688a40f768a0ff"
+  "099778ff2b978e404d9764ff6f977a40919790ffb3976640d5977cfff7979240"
+  "09c56a402bc580ff4dc596406fc56cff91c58240b3c598ffd5c56e40f7c584ff"
+  "09f39cff2bf372404df388ff6ff39e4091f374ffb3f38a40d5f360fff7f37640";
+
+static const char *const box_enlarge_expected =
+  "00000040000000002400cb40480096ff6d0061ff0000000091002c40b600f740"
+  "da00c2ff00000000ff008dff0000000000000000000000000000000000000000"
+  "0000000000000000000000000000000000000000000000000000000000000000"
+  "0000000000000000000000000000000000000000000000000000000000000000"
+  "000000000066f2ff000000002466bdff486688406d6653400000000091661eff"
+  "b666e9ffda66b44000000000ff667f4000996bff00000000249936ff48990140"
+  "6d99cc4000000000919997ffb69962ffda992d4000000000ff99f84000000000"
+  "0000000000000000000000000000000000000000000000000000000000000000"
+  "0000000000000000000000000000000000000000000000000000000000000000"
+  "000000000000000000000000000000000000000000ff5d400000000024ff2840"
+  "48fff3ff6dffbeff0000000091ff8940b6ff5440daff1fff00000000ffffeaff";
+
+static const char *const gaussian_enlarge_expected =
+  "01010440130166442d01b972480195d8630170fb7f014d9f9b016244b601c267"
+  "d101cccdeb01a8fbfe018cff011b4143131b64472d1b7a74481b6dd6631b89f8"
+  "7f1b829f9b1b7c47b61b9a69d11b8ccbeb1b67f8fe1b4bfc014cb19f134d97a0"
+  "2d4c74a0484d66a0634d83a07f4c7c9f9b4c759fb64d92a0d14d84a0eb4d61a0"
+  "fe4d47a00172cffd1372b4fa2d728ecc4872736863726f467f725aa09b7261f9"
+  "b672a0d7d1729f73eb729845fe729b42018d8cfd138d71fa2d8d4ccc488d4a68"
+  "638d89467f8d90a09b8d7bf9b68d77d7d18d5e73eb8d9445fe8dd74201b3a79f"
+  "13b38ba02db367a048b35aa063b376a07fb36e9f9bb3679fb6b384a0d1b377a0"
+  "ebb38fa0feb3b3a001e49f4313e486472de47e7448e49bd663e48ef87fe46b9f"
+  "9be46147b6e47d69d1e470cbebe488f8fee4aefc01fe5e4013fe48442dfe5e72"
+  "48febed863fec8fb7ffea29f9bfe7a44b6fe5567d1fe31cdebfe84fbfefee6ff";
+
+////////////////////////////////////////////////////////////////////
+//     Function: make_reference_image
+//  Description: Fills an RGBA image of the indicated size with the
+//               fixed pattern from which the expected results above
+//               were computed.
+////////////////////////////////////////////////////////////////////
+static void
+make_reference_image(PNMImage &image, int x_size, int y_size) {
+  image.clear(x_size, y_size, 4, 255);
+  for (int y = 0; y < y_size; ++y) {
+    for (int x = 0; x < x_size; ++x) {
+      image.set_xel_val(x, y, (x * 255) / (x_size - 1),
+                        (y * 255) / (y_size - 1),
+                        ((x * 7 + y * 13) * 29) % 256);
+      image.set_alpha_val(x, y, ((x ^ y) & 2) ? 255 : 64);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: compare_reference
+//  Description: Compares the image to the indicated expected result.
+//               Since the old code added up the weights in a
+//               different order, a channel may be off by one.
+//               Returns true if the image matches.
+////////////////////////////////////////////////////////////////////
+static bool
+compare_reference(const char *name, const PNMImage &image,
+                  const char *expected) {
+  int num_channels = image.get_x_size() * image.get_y_size() * 4;
+  nassertr((int)strlen(expected) == num_channels * 2, false);
+
+  int num_exact = 0;
+  int num_off = 0;
+  for (int y = 0; y < image.get_y_size(); ++y) {
+    for (int x = 0; x < image.get_x_size(); ++x) {
+      int values[4] = {
+        image.get_red_val(x, y), image.get_green_val(x, y),
+        image.get_blue_val(x, y), image.get_alpha_val(x, y),
+      };
+      for (int c = 0; c < 4; ++c) {
+        const char *p = expected + ((y * image.get_x_size() + x) * 4 + c) * 2;
+        int want = (int)strtol(string(p, 2).c_str(), NULL, 16);
+        int diff = abs(values[c] - want);
+        if (diff == 0) {
+          ++num_exact;
+        } else if (diff > 1) {
+          ++num_off;
+        }
+      }
+    }
+  }
+
+  cerr << "  " << name << ": " << num_exact << " of " << num_channels
+       << " channels exactly as before";
+  if (num_off != 0) {
+    cerr << "; " << num_off << " differ by more than 1\n";
+    return false;
+  }
+  cerr << "\n";
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: check_reference
+//  Description: Filters the reference images with the old filters,
+//               and returns the number of results that don't match
+//               those of the old code.
+////////////////////////////////////////////////////////////////////
+static int
+check_reference() {
+  PNMImage large, small;
+  make_reference_image(large, 16, 12);
+  make_reference_image(small, 8, 6);
+
+  cerr << "Comparing to the results before the filters were rewritten:\n";
+  int num_failed = 0;
+
+  PNMImage dest(7, 5, 4, 255);
+  dest.box_filter_from(0.5f, large);
+  num_failed += !compare_reference("box reduce", dest, box_reduce_expected);
+  dest.gaussian_filter_from(1.0f, large);
+  num_failed += !compare_reference("gaussian reduce", dest,
+                                   gaussian_reduce_expected);
+
+  dest.clear(8, 6, 4, 255);
+  dest.quick_filter_from(large);
+  num_failed += !compare_reference("quick reduce", dest, quick_reduce_expected);
+
+  dest.clear(11, 8, 4, 255);
+  dest.box_filter_from(0.5f, small);
+  num_failed += !compare_reference("box enlarge", dest, box_enlarge_expected);
+  dest.gaussian_filter_from(1.0f, small);
+  num_failed += !compare_reference("gaussian enlarge", dest,
+                                   gaussian_enlarge_expected);
+
+  cerr << "\n";
+  return num_failed;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: make_image
+//  Description: Fills an RGBA image of the indicated size with a
+//               pattern of gradients and noise, so that no filter gets
+//               an unrealistically easy time of it.
+////////////////////////////////////////////////////////////////////
+static void
+make_image(PNMImage &image, int size) {
+  Randomizer random(1);
+  image.clear(size, size, 4);
+  for (int y = 0; y < size; ++y) {
+    for (int x = 0; x < size; ++x) {
+      float fx = (float)x / (float)size;
+      float fy = (float)y / (float)size;
+      image.set_xel_a(x, y, fx, fy, (float)random.random_real(1.0),
+                      ((x ^ y) & 8) ? 1.0f : 0.5f);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: run_filter
+//  Description: Filters the source image into the destination image
+//               once with the indicated filter.
+////////////////////////////////////////////////////////////////////
+static void
+run_filter(FilterType type, PNMImage &dest, const PNMImage &source) {
+  switch (type) {
+  case FT_box:
+    dest.box_filter_from(0.5f, source);
+    break;
+
+  case FT_gaussian:
+    dest.gaussian_filter_from(1.0f, source);
+    break;
+
+  case FT_lanczos:
+    dest.lanczos_filter_from(3.0f, source);
+    break;
+
+  case FT_mitchell:
+    dest.mitchell_filter_from(2.0f, source);
+    break;
+
+  case FT_quick:
+    dest.quick_filter_from(source);
+    break;
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: time_filter
+//  Description: Filters the source image into the destination image
+//               several times, and returns the throughput of the
+//               indicated filter in megapixels of source image per
+//               second.
+////////////////////////////////////////////////////////////////////
+static double
+time_filter(FilterType type, PNMImage &dest, const PNMImage &source) {
+  TrueClock *clock = TrueClock::get_global_ptr();
+  double start = clock->get_short_time();
+  for (int i = 0; i < num_iterations; ++i) {
+    run_filter(type, dest, source);
+  }
+  double elapsed = clock->get_short_time() - start;
+
+  double megapixels = (double)source.get_x_size() * (double)source.get_y_size()
+    * num_iterations / 1000000.0;
+  return megapixels / max(elapsed, 0.000001);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: count_image_mismatches
+//  Description: Returns the number of pixels that differ between the
+//               two images, in any channel.
+////////////////////////////////////////////////////////////////////
+static int
+count_image_mismatches(const PNMImage &a, const PNMImage &b) {
+  nassertr(a.get_x_size() == b.get_x_size() &&
+           a.get_y_size() == b.get_y_size(), -1);
+  int count = 0;
+  for (int y = 0; y < a.get_y_size(); ++y) {
+    for (int x = 0; x < a.get_x_size(); ++x) {
+      if (a.get_red_val(x, y) != b.get_red_val(x, y) ||
+          a.get_green_val(x, y) != b.get_green_val(x, y) ||
+          a.get_blue_val(x, y) != b.get_blue_val(x, y) ||
+          a.get_alpha_val(x, y) != b.get_alpha_val(x, y)) {
+        ++count;
+      }
+    }
+  }
+  return count;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: count_pfm_mismatches
+//  Description: Returns the number of points that differ between the
+//               two PfmFiles, in any channel.
+////////////////////////////////////////////////////////////////////
+static int
+count_pfm_mismatches(const PfmFile &a, const PfmFile &b) {
+  nassertr(a.get_x_size() == b.get_x_size() &&
+           a.get_y_size() == b.get_y_size(), -1);
+  int count = 0;
+  for (int y = 0; y < a.get_y_size(); ++y) {
+    for (int x = 0; x < a.get_x_size(); ++x) {
+      if (a.get_point4(x, y) != b.get_point4(x, y)) {
+        ++count;
+      }
+    }
+  }
+  return count;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: check_pfm
+//  Description: Runs the PfmFile operations that are divided among
+//               threads, once on one thread and once on up to
+//               max_threads, and returns the number of operations
+//               whose results differ.
+////////////////////////////////////////////////////////////////////
+static int
+check_pfm(const PNMImage &image, int max_threads) {
+  PfmFile source;
+  source.load(image);
+
+  LMatrix4f transform = LMatrix4f::scale_mat(2.0f, 3.0f, 4.0f) *
+    LMatrix4f::translate_mat(1.0f, -1.0f, 0.5f);
+
+  PfmFile results[2][3];
+  for (int pass = 0; pass < 2; ++pass) {
+    pnmimage_num_threads = (pass == 0) ? 1 : max_threads;
+
+    results[pass][0].clear(source.get_x_size() / 2, source.get_y_size() / 2,
+                           source.get_num_channels());
+    results[pass][0].quick_filter_from(source);
+
+    results[pass][1] = source;
+    results[pass][1].xform(transform);
+
+    results[pass][2] = source;
+    results[pass][2].apply_exponent(2.0f, 0.5f, 1.5f, 1.0f);
+  }
+  pnmimage_num_threads = max_threads;
+
+  static const char *const names[] = {
+    "quick_filter_from", "xform", "apply_exponent"
+  };
+  int num_failed = 0;
+  for (int i = 0; i < 3; ++i) {
+    int mismatches = count_pfm_mismatches(results[0][i], results[1][i]);
+    if (mismatches != 0) {
+      cerr << "  PfmFile " << names[i] << ": " << mismatches
+           << " points differ between 1 and " << max_threads
+           << " threads\n";
+      ++num_failed;
+    }
+  }
+  return num_failed;
+}
+
+int
+main(int argc, char *argv[]) {
+  int size = 2048;
+  if (argc > 1) {
+    size = max(atoi(argv[1]), 16);
+  }
+  if (argc > 2) {
+    load_prc_file_data("test_pnmfilter",
+                       string("pnmimage-num-threads ") + argv[2]);
+  }
+  int max_threads = pnmimage_num_threads;
+
+  int num_failed = check_reference();
+
+  PNMImage source;
+  make_image(source, size);
+
+  cerr << "Filtering a " << size << "x" << size << " RGBA image, "
+       << num_iterations << " iterations each; MP/s of source image, "
+       << "1 thread vs. up to " << max_threads << " threads:\n\n";
+
+  for (int t = 0; t < num_filter_types; ++t) {
+    FilterType type = (FilterType)t;
+
+    for (int pass = 0; pass < 2; ++pass) {
+      // Halve, then double the image.
+      int dest_size = (pass == 0) ? size / 2 : size * 2;
+      if (type == FT_quick && pass == 1) {
+        // The quick filter is only meant for reducing.
+        continue;
+      }
+
+      PNMImage single_dest(dest_size, dest_size, source.get_num_channels(),
+                           source.get_maxval());
+      PNMImage multi_dest(dest_size, dest_size, source.get_num_channels(),
+                          source.get_maxval());
+
+      pnmimage_num_threads = 1;
+      double single = time_filter(type, single_dest, source);
+      pnmimage_num_threads = max_threads;
+      double multi = time_filter(type, multi_dest, source);
+
+      cerr << "  " << filter_names[t] << " "
+           << ((pass == 0) ? "halve " : "double") << ": "
+           << single << " MP/s, " << multi << " MP/s ("
+           << multi / single << "x)";
+
+      int mismatches = count_image_mismatches(single_dest, multi_dest);
+      if (mismatches != 0) {
+        cerr << "; " << mismatches << " pixels differ";
+        ++num_failed;
+      }
+      cerr << "\n";
+    }
+  }
+
+  num_failed += check_pfm(source, max_threads);
+
+  if (num_failed != 0) {
+    cerr << "\n" << num_failed << " results differ.\n";
+    return 1;
+  }
+  return (0);
+}
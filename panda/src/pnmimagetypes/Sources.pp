@@ -41,3 +41,13 @@
 
 #end lib_target
 
+#begin test_bin_target
+  #define TARGET test_pfmRows
+  #define LOCAL_LIBS p3pnmimagetypes p3pnmimage p3putil p3express
+  #define OTHER_LIBS $[OTHER_LIBS] p3pystub
+
+  #define SOURCES \
+    test_pfmRows.cxx
+
+#end test_bin_target
+
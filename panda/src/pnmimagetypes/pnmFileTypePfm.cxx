@@ -205,19 +205,7 @@ read_pfm(PfmFile &pfm) {
     return false;
   }
 
-  bool little_endian = false;
-  if (_scale < 0) {
-    _scale = -_scale;
-    little_endian = true;
-  }
-  if (pfm_force_littleendian) {
-    little_endian = true;
-  }
-  if (pfm_reverse_dimensions) {
-    int t = _x_size;
-    _x_size = _y_size;
-    _y_size = t;
-  }
+  bool endian_reversed = setup_read();
 
   pfm.clear(_x_size, _y_size, _num_channels);
   pfm.set_scale(_scale);
@@ -234,24 +222,118 @@ read_pfm(PfmFile &pfm) {
     return false;
   }
 
-  // Now we may have to endian-reverse the data.
-#ifdef WORDS_BIGENDIAN
-  bool endian_reversed = little_endian;
-#else
-  bool endian_reversed = !little_endian;
-#endif
-
   if (endian_reversed) {
-    for (int ti = 0; ti < size; ++ti) {
-      ReversedNumericData nd(&table[ti], sizeof(PN_float32));
-      nd.store_value(&table[ti], sizeof(PN_float32));
+    reverse_data(&table[0], size);
+  }
+
+  pfm.swap_table(table);
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: PNMFileTypePfm::Reader::read_pfm_rows
+//       Access: Public, Virtual
+//  Description: Reads only the rows y_begin through y_end - 1 of the
+//               floating-point data into the indicated PfmFile, which
+//               is resized to hold just those rows.  The rows before
+//               y_begin are skipped with a seek where the stream
+//               allows it.  Returns true on success, false on
+//               failure.
+////////////////////////////////////////////////////////////////////
+bool PNMFileTypePfm::Reader::
+read_pfm_rows(PfmFile &pfm, int y_begin, int y_end) {
+  if (!is_valid()) {
+    return false;
+  }
+
+  bool endian_reversed = setup_read();
+
+  y_begin = max(y_begin, 0);
+  y_end = min(y_end, _y_size);
+  if (y_end < y_begin) {
+    y_end = y_begin;
+  }
+
+  pfm.clear(_x_size, y_end - y_begin, _num_channels);
+  pfm.set_scale(_scale);
+
+  int size = _x_size * (y_end - y_begin) * _num_channels;
+  if (size == 0) {
+    // No rows requested; there's nothing to read.
+    return true;
+  }
+
+  streamoff row_size = (streamoff)_x_size * _num_channels * sizeof(PN_float32);
+  if (y_begin != 0) {
+    (*_file).seekg(row_size * y_begin, ios::cur);
+    if ((*_file).fail()) {
+      // Not a seekable stream; read past the rows instead.
+      (*_file).clear();
+      (*_file).ignore(row_size * y_begin);
     }
   }
 
+  pvector<PN_float32> table;
+  pfm.swap_table(table);
+
+  (*_file).read((char *)&table[0], sizeof(PN_float32) * size);
+  if ((*_file).fail() && !(*_file).eof()) {
+    pfm.clear();
+    return false;
+  }
+
+  if (endian_reversed) {
+    reverse_data(&table[0], size);
+  }
+
   pfm.swap_table(table);
   return true;
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: PNMFileTypePfm::Reader::setup_read
+//       Access: Private
+//  Description: Applies the endianness and dimension conventions of
+//               the file, and of the pfm-* config variables, before
+//               the data is read.  Returns true if the data must be
+//               endian-reversed after reading.
+////////////////////////////////////////////////////////////////////
+bool PNMFileTypePfm::Reader::
+setup_read() {
+  bool little_endian = false;
+  if (_scale < 0) {
+    _scale = -_scale;
+    little_endian = true;
+  }
+  if (pfm_force_littleendian) {
+    little_endian = true;
+  }
+  if (pfm_reverse_dimensions) {
+    int t = _x_size;
+    _x_size = _y_size;
+    _y_size = t;
+  }
+
+#ifdef WORDS_BIGENDIAN
+  return little_endian;
+#else
+  return !little_endian;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: PNMFileTypePfm::Reader::reverse_data
+//       Access: Private, Static
+//  Description: Endian-reverses the indicated array of floats in
+//               place.
+////////////////////////////////////////////////////////////////////
+void PNMFileTypePfm::Reader::
+reverse_data(PN_float32 *data, int size) {
+  for (int ti = 0; ti < size; ++ti) {
+    ReversedNumericData nd(&data[ti], sizeof(PN_float32));
+    nd.store_value(&data[ti], sizeof(PN_float32));
+  }
+}
 
 ////////////////////////////////////////////////////////////////////
 //     Function: PNMFileTypePfm::Writer::Constructor
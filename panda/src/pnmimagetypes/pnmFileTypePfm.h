@@ -51,8 +51,12 @@ public:
     
     virtual bool is_floating_point();
     virtual bool read_pfm(PfmFile &pfm);
+    virtual bool read_pfm_rows(PfmFile &pfm, int y_begin, int y_end);
 
   private:
+    bool setup_read();
+    static void reverse_data(PN_float32 *data, int size);
+
     PN_float32 _scale;
   };
 
@@ -0,0 +1,122 @@
+// Filename: test_pfmRows.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "pandabase.h"
+#include "pfmFile.h"
+#include "pnmReader.h"
+#include "config_pnmimagetypes.h"
+#include "testCheck.h"
+
+// This program writes a small PFM file in memory, and reads various
+// ranges of its rows back with PfmFile::read_rows(), checking that
+// each comes back with just the requested rows.  The ranges include
+// an empty one, and ones that extend past either end of the file.
+
+static TestCheck check;
+
+static const int x_size = 5;
+static const int y_size = 7;
+static const int num_channels = 3;
+
+////////////////////////////////////////////////////////////////////
+//     Function: point_value
+//  Description: Returns the value stored in the indicated channel of
+//               the indicated point of the test file.
+////////////////////////////////////////////////////////////////////
+static PN_float32
+point_value(int x, int y, int c) {
+  return (PN_float32)(y * 100 + x * 10 + c) + 0.25f;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: check_rows
+//  Description: Reads rows y_begin through y_end - 1 of the file, and
+//               checks that the result holds the rows expected_begin
+//               through expected_end - 1 of the original.
+////////////////////////////////////////////////////////////////////
+static void
+check_rows(const string &data, int y_begin, int y_end,
+           int expected_begin, int expected_end) {
+  ostringstream strm;
+  strm << "rows " << y_begin << " to " << y_end;
+  string name = strm.str();
+
+  PfmFile pfm;
+  PNMReader *reader =
+    pfm.make_reader(new istringstream(data), true, Filename("rows.pfm"));
+  if (!check(reader != (PNMReader *)NULL, name + ": make reader")) {
+    return;
+  }
+  if (!check(pfm.read_rows(reader, y_begin, y_end), name + ": read")) {
+    return;
+  }
+
+  int num_rows = expected_end - expected_begin;
+  check(pfm.get_x_size() == x_size, name + ": x size");
+  check(pfm.get_y_size() == num_rows, name + ": y size");
+  check(pfm.get_num_channels() == num_channels, name + ": channels");
+  check(pfm.get_scale() == 1.0f, name + ": scale");
+  if (pfm.get_y_size() != num_rows) {
+    return;
+  }
+
+  int num_wrong = 0;
+  for (int y = 0; y < num_rows; ++y) {
+    for (int x = 0; x < x_size; ++x) {
+      const LPoint3f &point = pfm.get_point(x, y);
+      for (int c = 0; c < num_channels; ++c) {
+        if (point[c] != point_value(x, y + expected_begin, c)) {
+          ++num_wrong;
+        }
+      }
+    }
+  }
+  check(num_wrong == 0, name + ": values");
+}
+
+int
+main(int argc, char *argv[]) {
+  init_libpnmimagetypes();
+
+  PfmFile source;
+  source.clear(x_size, y_size, num_channels);
+  for (int y = 0; y < y_size; ++y) {
+    for (int x = 0; x < x_size; ++x) {
+      source.set_point(x, y, LPoint3f(point_value(x, y, 0),
+                                      point_value(x, y, 1),
+                                      point_value(x, y, 2)));
+    }
+  }
+
+  ostringstream out;
+  if (!check(source.write(out, Filename("rows.pfm")), "write")) {
+    return check.report();
+  }
+  string data = out.str();
+
+  check_rows(data, 0, y_size, 0, y_size);
+  check_rows(data, 2, 5, 2, 5);
+  check_rows(data, y_size - 1, y_size, y_size - 1, y_size);
+  check_rows(data, -3, 2, 0, 2);
+  check_rows(data, 4, y_size + 10, 4, y_size);
+
+  // Empty ranges come back as a file with no rows.
+  check_rows(data, 3, 3, 3, 3);
+  check_rows(data, 0, 0, 0, 0);
+  check_rows(data, y_size, y_size, y_size, y_size);
+  check_rows(data, 5, 2, 5, 5);
+  check_rows(data, y_size + 2, y_size + 4, y_size + 2, y_size + 2);
+
+  return check.report();
+}
@@ -114,6 +114,7 @@ static TimeCollectorProperties time_properties[] = {
   { 1, "Wait:Flip",                        { 1.0, 0.6, 0.3 } },
   { 1, "Wait:Flip:Begin",                  { 0.3, 0.3, 0.9 } },
   { 1, "Wait:Flip:End",                    { 0.9, 0.3, 0.6 } },
+  { 1, "Wait:Stream buffer",               { 0.7, 0.3, 0.1 } },
   { 1, "App",                              { 0.0, 0.4, 0.8 },  1.0 / 30.0 },
   { 1, "App:Collisions",                   { 1.0, 0.5, 0.0 } },
   { 1, "App:Collisions:Reset",             { 0.0, 0.0, 0.5 } },
@@ -173,6 +174,7 @@ static LevelCollectorProperties level_properties[] = {
   { 1, "Geom cache operations:erase",      { 0.4, 0.8, 0.2 } },
   { 1, "Geom cache operations:evict",      { 0.8, 0.2, 0.4 } },
   { 1, "Data transferred",                 { 0.0, 0.2, 0.4 },  "MB", 12, 1048576 },
+  { 1, "Data transferred:Streamed",        { 0.4, 0.7, 0.9 } },
   { 1, "Primitive batches",                { 0.2, 0.5, 0.9 },  "", 500 },
   { 1, "Primitive batches:Other",          { 0.2, 0.2, 0.2 } },
   { 1, "Primitive batches:Triangles",      { 0.8, 0.8, 0.8 } },
@@ -198,6 +200,7 @@ static LevelCollectorProperties level_properties[] = {
   { 1, "State changes:Other",              { 0.2, 0.2, 0.2 } },
   { 1, "State changes:Transforms",         { 0.2, 0.2, 0.8 } },
   { 1, "State changes:Textures",           { 0.8, 0.2, 0.2 } },
+  { 1, "State changes:Shaders",            { 0.2, 0.8, 0.2 } },
   { 1, "Occlusion tests",                  { 0.9, 0.8, 0.3 },  "", 500.0 },
   { 1, "Occlusion results",                { 0.3, 0.9, 0.8 },  "", 500.0 },
   { 1, "System memory",                    { 0.5, 1.0, 0.5 },  "MB", 64, 1048576 },
@@ -38,3 +38,8 @@
   #define TARGET test_map
   #define SOURCES test_map.cxx
 #end test_bin_target
+
+#begin test_bin_target
+  #define TARGET test_multidraw
+  #define SOURCES test_multidraw.cxx
+#end test_bin_target
@@ -0,0 +1,300 @@
+// Filename: test_multidraw.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "pandaFramework.h"
+#include "geomNode.h"
+#include "geomTriangles.h"
+#include "geomVertexData.h"
+#include "geomVertexWriter.h"
+#include "graphicsEngine.h"
+#include "graphicsOutput.h"
+#include "graphicsStateGuardian.h"
+#include "displayRegion.h"
+#include "camera.h"
+#include "pnmImage.h"
+#include "configVariableBool.h"
+
+// This program draws a large grid of small cubes, each in a GeomNode
+// of its own but all with the same state, as a benchmark for drawing
+// many small static Geoms.  Run it with -m to batch the cubes with
+// glMultiDrawElementsIndirect (gl-multi-draw-indirect), and compare
+// the frame rate reported on exit to that of a run without.
+//
+// Run it with -c instead to check that batching doesn't change what
+// is drawn: the same grid, with some dynamic cubes mixed in that
+// can't be batched, is rendered into an offscreen buffer with and
+// without gl-multi-draw-indirect, and the two images are compared.
+// The program exits with status 1 if they differ.
+
+PandaFramework framework;
+
+static const int default_num_cubes_side = 64;
+static const int check_num_cubes_side = 16;
+static const int check_image_size = 256;
+
+static ConfigVariableBool multi_draw_indirect("gl-multi-draw-indirect");
+
+PT(GeomNode)
+make_cube(const LPoint3 &center, PN_stdfloat size, const LColor &color,
+          Geom::UsageHint usage_hint) {
+  static const PN_stdfloat normals[6][3] = {
+    { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 },
+    { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 },
+  };
+
+  PT(GeomVertexData) vdata = new GeomVertexData
+    ("cube", GeomVertexFormat::get_v3n3c4(), usage_hint);
+  vdata->unclean_set_num_rows(24);
+  GeomVertexWriter vertex(vdata, InternalName::get_vertex());
+  GeomVertexWriter normal(vdata, InternalName::get_normal());
+  GeomVertexWriter vcolor(vdata, InternalName::get_color());
+
+  PT(GeomTriangles) tris = new GeomTriangles(usage_hint);
+  PN_stdfloat h = size * 0.5f;
+
+  for (int f = 0; f < 6; ++f) {
+    LVector3 n(normals[f][0], normals[f][1], normals[f][2]);
+
+    // Find two axes perpendicular to the normal, forming a
+    // right-handed basis with it.
+    LVector3 u(n[1], n[2], n[0]);
+    LVector3 v = n.cross(u);
+
+    LPoint3 c = center + n * h;
+    vertex.add_data3(c - u * h - v * h);
+    vertex.add_data3(c + u * h - v * h);
+    vertex.add_data3(c + u * h + v * h);
+    vertex.add_data3(c - u * h + v * h);
+    for (int i = 0; i < 4; ++i) {
+      normal.add_data3(n);
+      vcolor.add_data4(color);
+    }
+
+    int b = f * 4;
+    tris->add_vertices(b, b + 1, b + 2);
+    tris->add_vertices(b, b + 2, b + 3);
+  }
+
+  PT(Geom) geom = new Geom(vdata);
+  geom->add_primitive(tris);
+
+  PT(GeomNode) node = new GeomNode("cube");
+  node->add_geom(geom);
+  return node;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: make_grid
+//  Description: Adds a square grid of cubes to the indicated node,
+//               each a different color.  Every dynamic_every'th cube
+//               is given dynamic geometry, if dynamic_every is not 0.
+////////////////////////////////////////////////////////////////////
+void
+make_grid(NodePath &parent, int num_cubes_side, int dynamic_every) {
+  // The vertices are generated in world space, so that the cubes all
+  // share the same (identity) transform, and may be batched.
+  PN_stdfloat spacing = 2.0f;
+  PN_stdfloat offset = (num_cubes_side - 1) * spacing * 0.5f;
+  int n = 0;
+  for (int yi = 0; yi < num_cubes_side; ++yi) {
+    for (int xi = 0; xi < num_cubes_side; ++xi) {
+      LPoint3 center(xi * spacing - offset, yi * spacing - offset, 0.0f);
+      LColor color((PN_stdfloat)xi / num_cubes_side,
+                   (PN_stdfloat)yi / num_cubes_side,
+                   (PN_stdfloat)(n % 3) / 2.0f, 1.0f);
+      bool dynamic = (dynamic_every != 0 && n % dynamic_every == 0);
+      parent.attach_new_node
+        (make_cube(center, 1.0f, color,
+                   dynamic ? Geom::UH_dynamic : Geom::UH_static));
+      ++n;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: render_offscreen
+//  Description: Renders the scene into an offscreen buffer with a
+//               GSG of its own, created with gl-multi-draw-indirect
+//               set as indicated, and copies the result into image.
+//               Returns true on success.  supported is set to whether
+//               the GSG actually batched with multi-draw indirect.
+////////////////////////////////////////////////////////////////////
+bool
+render_offscreen(const NodePath &scene, bool multi_draw,
+                 PNMImage &image, bool &supported) {
+  GraphicsEngine *engine = framework.get_graphics_engine();
+  GraphicsPipe *pipe = framework.get_default_pipe();
+  if (pipe == (GraphicsPipe *)NULL) {
+    return false;
+  }
+
+  // The GSG reads this when it is reset, as the buffer is opened.
+  multi_draw_indirect.set_value(multi_draw);
+
+  FrameBufferProperties fb_props;
+  fb_props.set_rgb_color(true);
+  fb_props.set_depth_bits(1);
+  GraphicsOutput *buffer = engine->make_output
+    (pipe, multi_draw ? "multi-draw" : "single-draw", 0, fb_props,
+     WindowProperties::size(check_image_size, check_image_size),
+     GraphicsPipe::BF_refuse_window, NULL, NULL);
+  if (buffer == (GraphicsOutput *)NULL) {
+    return false;
+  }
+  buffer->set_clear_color(LColor(0.0f, 0.0f, 0.0f, 1.0f));
+
+  NodePath render("render");
+  scene.instance_to(render);
+  PT(Camera) camera = new Camera("camera");
+  NodePath camera_np = render.attach_new_node(camera);
+  camera_np.set_pos(0.0f, -check_num_cubes_side * 2.5f,
+                    check_num_cubes_side * 2.0f);
+  camera_np.look_at(0.0f, 0.0f, 0.0f);
+  DisplayRegion *dr = buffer->make_display_region();
+  dr->set_camera(camera_np);
+
+  // The first frame opens the buffer.
+  engine->render_frame();
+  engine->render_frame();
+
+  bool success = buffer->is_valid() && buffer->get_screenshot(image);
+  GraphicsStateGuardian *gsg = buffer->get_gsg();
+  supported = (gsg != (GraphicsStateGuardian *)NULL &&
+               gsg->get_supports_multi_draw_indirect());
+
+  engine->remove_window(buffer);
+  return success;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: check_multi_draw
+//  Description: Renders the check scene with and without multi-draw
+//               indirect, and compares the results.  Returns the exit
+//               status for the program.
+////////////////////////////////////////////////////////////////////
+int
+check_multi_draw() {
+  NodePath scene("scene");
+  make_grid(scene, check_num_cubes_side, 7);
+
+  PNMImage single_image, multi_image;
+  bool single_supported, multi_supported;
+  if (!render_offscreen(scene, false, single_image, single_supported) ||
+      !render_offscreen(scene, true, multi_image, multi_supported)) {
+    nout << "FAILED: could not render offscreen.\n";
+    return 1;
+  }
+  if (single_supported) {
+    nout << "FAILED: multi-draw indirect used although turned off.\n";
+    return 1;
+  }
+  if (!multi_supported) {
+    nout << "This GSG doesn't support multi-draw indirect; nothing to check.\n";
+    return 0;
+  }
+
+  if (single_image.get_x_size() != multi_image.get_x_size() ||
+      single_image.get_y_size() != multi_image.get_y_size()) {
+    nout << "FAILED: images are different sizes.\n";
+    return 1;
+  }
+
+  // The same triangles are rasterized either way, so apart from
+  // rounding, every pixel should be the same.
+  int num_drawn = 0;
+  int num_different = 0;
+  for (int y = 0; y < single_image.get_y_size(); ++y) {
+    for (int x = 0; x < single_image.get_x_size(); ++x) {
+      xel a = single_image.get_xel_val(x, y);
+      xel b = multi_image.get_xel_val(x, y);
+      if (a.r != 0 || a.g != 0 || a.b != 0) {
+        ++num_drawn;
+      }
+      if (abs((int)a.r - (int)b.r) > 1 ||
+          abs((int)a.g - (int)b.g) > 1 ||
+          abs((int)a.b - (int)b.b) > 1) {
+        ++num_different;
+      }
+    }
+  }
+
+  if (num_drawn == 0) {
+    nout << "FAILED: nothing was drawn.\n";
+    return 1;
+  }
+  if (num_different != 0) {
+    nout << "FAILED: " << num_different << " of " << num_drawn
+         << " drawn pixels differ with multi-draw indirect.\n";
+    single_image.write("test_multidraw_single.png");
+    multi_image.write("test_multidraw_multi.png");
+    return 1;
+  }
+
+  nout << "Multi-draw indirect matches single draws in all " << num_drawn
+       << " drawn pixels.\n";
+  return 0;
+}
+
+int
+main(int argc, char *argv[]) {
+  bool multi_draw = false;
+  bool check = false;
+  int num_cubes_side = default_num_cubes_side;
+
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-m") == 0) {
+      multi_draw = true;
+    } else if (strcmp(argv[i], "-c") == 0) {
+      check = true;
+    } else {
+      num_cubes_side = max(atoi(argv[i]), 1);
+    }
+  }
+
+  framework.open_framework(argc, argv);
+
+  if (check) {
+    int status = check_multi_draw();
+    framework.close_framework();
+    return status;
+  }
+
+  // This must be set before the window is opened.
+  multi_draw_indirect.set_value(multi_draw);
+
+  framework.set_window_title("Multi-draw Test");
+
+  WindowFramework *window = framework.open_window();
+  if (window != (WindowFramework *)NULL) {
+    // We've successfully opened a window.
+
+    window->enable_keyboard();
+    window->setup_trackball();
+    framework.get_models().instance_to(window->get_render());
+
+    NodePath models = framework.get_models();
+    make_grid(models, num_cubes_side, 0);
+
+    nout << "Drawing " << num_cubes_side * num_cubes_side << " cubes with"
+         << (multi_draw ? "" : "out") << " multi-draw indirect.\n";
+
+    window->center_trackball(models);
+
+    framework.enable_default_keys();
+    framework.main_loop();
+  }
+
+  framework.report_frame_rate(nout);
+  return (0);
+}
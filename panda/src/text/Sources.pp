@@ -18,6 +18,7 @@
     dynamicTextFont.I dynamicTextFont.h \
     dynamicTextGlyph.I dynamicTextGlyph.h \
     dynamicTextPage.I dynamicTextPage.h \
+    dynamicTextRasterizer.I dynamicTextRasterizer.h \
     fontPool.I fontPool.h \
     geomTextGlyph.I geomTextGlyph.h \
     staticTextFont.I staticTextFont.h \
@@ -35,6 +36,7 @@
     dynamicTextFont.cxx \
     dynamicTextGlyph.cxx \
     dynamicTextPage.cxx \
+    dynamicTextRasterizer.cxx \
     fontPool.cxx \
     geomTextGlyph.cxx \
     staticTextFont.cxx \
@@ -51,6 +53,7 @@
     dynamicTextFont.I dynamicTextFont.h \
     dynamicTextGlyph.I dynamicTextGlyph.h \
     dynamicTextPage.I dynamicTextPage.h \
+    dynamicTextRasterizer.I dynamicTextRasterizer.h \
     fontPool.I fontPool.h \
     geomTextGlyph.I geomTextGlyph.h \
     staticTextFont.I staticTextFont.h \
@@ -66,3 +69,26 @@
   #define IGATESCAN all
 
 #end lib_target
+
+#begin test_bin_target
+  #define TARGET test_textNode
+
+  #define SOURCES \
+    test_textNode.cxx
+
+  #define LOCAL_LIBS $[LOCAL_LIBS] p3text
+  #define OTHER_LIBS $[OTHER_LIBS] p3pystub
+
+#end test_bin_target
+
+#begin test_bin_target
+  #define TARGET test_distanceField
+  #define USE_PACKAGES freetype
+
+  #define SOURCES \
+    test_distanceField.cxx
+
+  #define LOCAL_LIBS $[LOCAL_LIBS] p3text
+  #define OTHER_LIBS $[OTHER_LIBS] p3pystub
+
+#end test_bin_target
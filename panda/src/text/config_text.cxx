@@ -78,6 +78,22 @@ ConfigVariableInt text_page_size
  PRC_DESC("This is the default size for new textures created for dynamic "
           "fonts."));
 
+ConfigVariableBool text_async_rasterize
+("text-async-rasterize", false,
+ PRC_DESC("Set this true to render the glyphs of dynamic fonts on a "
+          "background thread, showing a blank space in place of each "
+          "glyph until it is ready, rather than pausing to render it the "
+          "first time it is used.  This is the default setting for "
+          "DynamicTextFont::set_async_rasterize()."));
+
+ConfigVariableInt text_distance_field_spread
+("text-distance-field-spread", 4,
+ PRC_DESC("The number of texels beyond the edge of each glyph that "
+          "the distance field extends, for dynamic fonts in "
+          "RM_distance_field mode.  This limits how wide an outline can "
+          "be drawn around the text, and how far the text can be "
+          "minified before its edges lose their antialiasing."));
+
 ConfigVariableBool text_small_caps
 ("text-small-caps", false,
  PRC_DESC("This controls the default setting for "
@@ -35,6 +35,8 @@ extern ConfigVariableInt text_anisotropic_degree;
 extern ConfigVariableInt text_texture_margin;
 extern ConfigVariableDouble text_poly_margin;
 extern ConfigVariableInt text_page_size;
+extern ConfigVariableBool text_async_rasterize;
+extern ConfigVariableInt text_distance_field_spread;
 extern ConfigVariableBool text_small_caps;
 extern EXPCL_PANDA_TEXT ConfigVariableDouble text_small_caps_scale;
 extern ConfigVariableFilename text_default_font;
@@ -38,6 +38,8 @@
 #include "geomLinestrips.h"
 #include "geomTriangles.h"
 #include "renderState.h"
+#include "shaderAttrib.h"
+#include "cmath.h"
 #include "string_utils.h"
 #include "triangulator.h"
 #include "nurbsCurveEvaluator.h"
@@ -46,6 +48,7 @@
 //#include "antialiasAttrib.h"
 
 TypeHandle DynamicTextFont::_type_handle;
+PT(Shader) DynamicTextFont::_distance_field_shader;
 
 
 ////////////////////////////////////////////////////////////////////
@@ -125,7 +128,10 @@ DynamicTextFont(const DynamicTextFont &copy) :
   _has_outline(copy._has_outline),
   _tex_format(copy._tex_format),
   _needs_image_processing(copy._needs_image_processing),
-  _preferred_page(0)
+  _distance_field_spread(copy._distance_field_spread),
+  _preferred_page(0),
+  _async_rasterize(copy._async_rasterize),
+  _rasterize_seq(0)
 {
 }
 
@@ -233,6 +239,57 @@ clear() {
   _cache.clear();
   _pages.clear();
   _empty_glyphs.clear();
+  _pending.clear();
+  _pinned.clear();
+  ++_rasterize_seq;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: DynamicTextFont::preload_glyphs
+//       Access: Published
+//  Description: Renders the glyphs for each of the characters in the
+//               indicated string into the font pages now, if they
+//               have not been already, so that no time need be spent
+//               rendering them later when text that uses them is
+//               first displayed.
+//
+//               If set_async_rasterize() is in effect, the glyphs are
+//               instead queued to be rendered on the background
+//               thread, and this returns immediately.
+////////////////////////////////////////////////////////////////////
+void DynamicTextFont::
+preload_glyphs(const wstring &text) {
+  if (!_is_valid) {
+    return;
+  }
+
+  wstring::const_iterator ti;
+  for (ti = text.begin(); ti != text.end(); ++ti) {
+    preload_glyph(*ti);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: DynamicTextFont::preload_glyph_range
+//       Access: Published
+//  Description: Renders the glyphs for all of the characters from
+//               first_character to last_character, inclusive, that
+//               are defined by the font.  This may be used to warm
+//               up the pages with an entire Unicode block, for
+//               instance the CJK ideographs an application expects to
+//               show.  See preload_glyphs().
+////////////////////////////////////////////////////////////////////
+void DynamicTextFont::
+preload_glyph_range(int first_character, int last_character) {
+  if (!_is_valid) {
+    return;
+  }
+
+  for (int character = first_character;
+       character <= last_character;
+       ++character) {
+    preload_glyph(character);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -301,6 +358,14 @@ get_glyph(int character, const TextGlyph *&glyph) {
   Cache::iterator ci = _cache.find(glyph_index);
   if (ci != _cache.end()) {
     glyph = (*ci).second;
+    if (!_pinned.empty() && _pinned.erase(glyph_index) != 0) {
+      // It is about to be used, so it no longer needs to be pinned.
+      (*ci).second->_geom_count--;
+    }
+  } else if (request_glyph(character, glyph_index)) {
+    // The glyph is being rendered in the background; stand in an
+    // empty glyph of the same width until it is ready.
+    glyph = get_placeholder(character, face, glyph_index);
   } else {
     DynamicTextGlyph *dynamic_glyph = make_glyph(character, face, glyph_index);
     _cache.insert(Cache::value_type(glyph_index, dynamic_glyph));
@@ -343,8 +408,12 @@ initialize() {
 
   _render_mode = text_render_mode;
   _winding_order = WO_default;
+  _distance_field_spread = max((int)text_distance_field_spread, 1);
 
   _preferred_page = 0;
+
+  _async_rasterize = text_async_rasterize;
+  _rasterize_seq = 0;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -377,6 +446,16 @@ determine_tex_format() {
   nassertv(get_num_pages() == 0);
 
   _has_outline = (_outline_color != _bg && _outline_width > 0.0f);
+  _distance_field_attrib.clear();
+
+  if (_render_mode == RM_distance_field) {
+    // The pages hold only the distance to the edge of each glyph.  The
+    // colors, and the outline, are applied later by the shader.
+    _tex_format = Texture::F_alpha;
+    _needs_image_processing = false;
+    return;
+  }
+
   _needs_image_processing = true;
 
   bool needs_color = false;
@@ -462,7 +541,7 @@ make_glyph(int character, FT_Face face, int glyph_index) {
 
   PN_stdfloat advance = slot->advance.x / 64.0;
 
-  if (_render_mode != RM_texture && 
+  if (_render_mode != RM_texture && _render_mode != RM_distance_field &&
       slot->format == ft_glyph_format_outline) {
     // Re-stroke the glyph to make it an outline glyph.
     /*
@@ -540,6 +619,7 @@ make_glyph(int character, FT_Face face, int glyph_index) {
       return glyph;
 
     case RM_texture:
+    case RM_distance_field:
     default:
       break;
     }
@@ -565,9 +645,20 @@ make_glyph(int character, FT_Face face, int glyph_index) {
     PN_stdfloat tex_y_size = bitmap.rows;
 
     int outline = 0;
-
-    if (_tex_pixels_per_unit == _font_pixels_per_unit &&
-        !_needs_image_processing) {
+    DynamicTextRasterizer::Params params;
+    get_raster_params(params);
+
+    if (_render_mode == RM_distance_field) {
+      // The padding around the distance field takes the place of the
+      // outline padding.
+      PNMImage image;
+      make_distance_field(bitmap, params, image, outline,
+                          tex_x_size, tex_y_size);
+      glyph = slot_glyph(character, image.get_x_size(), image.get_y_size());
+      copy_pnmimage_to_texture(image, glyph);
+
+    } else if (_tex_pixels_per_unit == _font_pixels_per_unit &&
+               !_needs_image_processing) {
       // If the bitmap produced from the font doesn't require scaling
       // or any other processing before it goes to the texture, we can
       // just copy it directly into the texture.
@@ -578,38 +669,10 @@ make_glyph(int character, FT_Face face, int glyph_index) {
       // Otherwise, we need to copy to a PNMImage first, so we can
       // scale it and/or process it; and then copy it to the texture
       // from there.
-      tex_x_size /= _scale_factor;
-      tex_y_size /= _scale_factor;
-      int int_x_size = (int)ceil(tex_x_size);
-      int int_y_size = (int)ceil(tex_y_size);
-      int bmp_x_size = (int)(int_x_size * _scale_factor + 0.5f);
-      int bmp_y_size = (int)(int_y_size * _scale_factor + 0.5f);
-
-      PNMImage image(bmp_x_size, bmp_y_size, PNMImage::CT_grayscale);
-      copy_bitmap_to_pnmimage(bitmap, image);
-
-      PNMImage reduced(int_x_size, int_y_size, PNMImage::CT_grayscale);
-      reduced.quick_filter_from(image);
-
-      // convert the outline width from points to tex_pixels.
-      PN_stdfloat outline_pixels = _outline_width / _points_per_unit * _tex_pixels_per_unit;
-      outline = (int)ceil(outline_pixels);
-
-      int_x_size += outline * 2;
-      int_y_size += outline * 2;
-      tex_x_size += outline * 2;
-      tex_y_size += outline * 2;
-      glyph = slot_glyph(character, int_x_size, int_y_size);
-
-      if (outline != 0) {
-        // Pad the glyph image to make room for the outline.
-        PNMImage padded(int_x_size, int_y_size, PNMImage::CT_grayscale);
-        padded.copy_sub_image(reduced, outline, outline);
-        copy_pnmimage_to_texture(padded, glyph);
-
-      } else {
-        copy_pnmimage_to_texture(reduced, glyph);
-      }
+      PNMImage image;
+      reduce_bitmap(bitmap, params, image, outline, tex_x_size, tex_y_size);
+      glyph = slot_glyph(character, image.get_x_size(), image.get_y_size());
+      copy_pnmimage_to_texture(image, glyph);
     }
 
     glyph->make_geom((int)floor(slot->bitmap_top + outline * _scale_factor + 0.5f),
@@ -617,10 +680,85 @@ make_glyph(int character, FT_Face face, int glyph_index) {
                      advance, _poly_margin,
                      tex_x_size, tex_y_size,
                      _font_pixels_per_unit, _tex_pixels_per_unit);
+    if (_render_mode == RM_distance_field) {
+      glyph->add_state_attrib(get_distance_field_attrib());
+    }
     return glyph;
   }
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: DynamicTextFont::get_raster_params
+//       Access: Private
+//  Description: Fills in the font settings that determine how a
+//               glyph is rendered to an image.
+////////////////////////////////////////////////////////////////////
+void DynamicTextFont::
+get_raster_params(DynamicTextRasterizer::Params &params) const {
+  params._face = _face;
+  params._char_size = _char_size;
+  params._dpi = _dpi;
+  params._pixel_width = _pixel_width;
+  params._pixel_height = _pixel_height;
+  params._render_mode = _render_mode;
+  params._tex_pixels_per_unit = _tex_pixels_per_unit;
+  params._font_pixels_per_unit = _font_pixels_per_unit;
+  params._scale_factor = _scale_factor;
+  params._outline_width = _outline_width;
+  params._outline_feather = _outline_feather;
+  params._needs_image_processing = _needs_image_processing;
+  params._has_outline = _has_outline;
+  params._distance_field_spread = _distance_field_spread;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: DynamicTextFont::reduce_bitmap
+//       Access: Private
+//  Description: Copies a bitmap as rendered by FreeType into a
+//               PNMImage, filtering it down by the scale factor, and
+//               padding it with room for the outline, if any.  Fills
+//               in the final size of the image in texels, and the
+//               width of the outline padding in pixels.
+////////////////////////////////////////////////////////////////////
+void DynamicTextFont::
+reduce_bitmap(const FT_Bitmap &bitmap,
+              const DynamicTextRasterizer::Params &params,
+              PNMImage &result, int &outline,
+              PN_stdfloat &tex_x_size, PN_stdfloat &tex_y_size) {
+  PN_stdfloat scale_factor = params._scale_factor;
+  tex_x_size = bitmap.width / scale_factor;
+  tex_y_size = bitmap.rows / scale_factor;
+  int int_x_size = (int)ceil(tex_x_size);
+  int int_y_size = (int)ceil(tex_y_size);
+  int bmp_x_size = (int)(int_x_size * scale_factor + 0.5f);
+  int bmp_y_size = (int)(int_y_size * scale_factor + 0.5f);
+
+  PNMImage image(bmp_x_size, bmp_y_size, PNMImage::CT_grayscale);
+  copy_bitmap_to_pnmimage(bitmap, image);
+
+  PNMImage reduced(int_x_size, int_y_size, PNMImage::CT_grayscale);
+  reduced.quick_filter_from(image);
+
+  // convert the outline width from points to tex_pixels.
+  PN_stdfloat outline_pixels = params._outline_width / _points_per_unit *
+    params._tex_pixels_per_unit;
+  outline = (int)ceil(outline_pixels);
+
+  int_x_size += outline * 2;
+  int_y_size += outline * 2;
+  tex_x_size += outline * 2;
+  tex_y_size += outline * 2;
+
+  if (outline != 0) {
+    // Pad the glyph image to make room for the outline.
+    result.clear(int_x_size, int_y_size, PNMImage::CT_grayscale);
+    result.copy_sub_image(reduced, outline, outline);
+
+  } else {
+    result = reduced;
+  }
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: DynamicTextFont::copy_bitmap_to_texture
 //       Access: Private
@@ -710,33 +848,12 @@ copy_pnmimage_to_texture(const PNMImage &image, DynamicTextGlyph *glyph) {
 
   } else {
     if (_has_outline) {
-      // Gaussian blur the glyph to generate an outline.
-      PNMImage outline(image.get_x_size(), image.get_y_size(), PNMImage::CT_grayscale);
-      PN_stdfloat outline_pixels = _outline_width / _points_per_unit * _tex_pixels_per_unit;
-      outline.gaussian_filter_from(outline_pixels * 0.707, image);
-
-      // Filter the resulting outline to make a harder edge.  Square
-      // _outline_feather first to make the range more visually linear
-      // (this approximately compensates for the Gaussian falloff of
-      // the feathered edge).
-      PN_stdfloat f = _outline_feather * _outline_feather;
-
-      for (int yi = 0; yi < outline.get_y_size(); yi++) {
-        for (int xi = 0; xi < outline.get_x_size(); xi++) {
-          PN_stdfloat v = outline.get_gray(xi, yi);
-          if (v == 0.0f) {
-            // Do nothing.
-          } else if (v >= f) {
-            // Clamp to 1.
-            outline.set_gray(xi, yi, 1.0);
-          } else {
-            // Linearly scale the range 0 .. f onto 0 .. 1.
-            outline.set_gray(xi, yi, v / f);
-          }
-        }
-      }
-
-      // Now blend that into the texture.
+      // Blur the glyph to generate an outline, and blend that into
+      // the texture.
+      DynamicTextRasterizer::Params params;
+      get_raster_params(params);
+      PNMImage outline;
+      make_outline_image(image, params, outline);
       blend_pnmimage_to_texture(outline, glyph, _outline_color);
     }
 
@@ -747,6 +864,299 @@ copy_pnmimage_to_texture(const PNMImage &image, DynamicTextGlyph *glyph) {
   }    
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: DynamicTextFont::make_outline_image
+//       Access: Private, Static
+//  Description: Generates the image of the outline that surrounds the
+//               indicated glyph image, which should already have been
+//               padded to make room for it.
+////////////////////////////////////////////////////////////////////
+void DynamicTextFont::
+make_outline_image(const PNMImage &image,
+                   const DynamicTextRasterizer::Params &params,
+                   PNMImage &outline) {
+  // Gaussian blur the glyph to generate an outline.
+  outline.clear(image.get_x_size(), image.get_y_size(), PNMImage::CT_grayscale);
+  PN_stdfloat outline_pixels = params._outline_width / _points_per_unit *
+    params._tex_pixels_per_unit;
+  outline.gaussian_filter_from(outline_pixels * 0.707, image);
+
+  // Filter the resulting outline to make a harder edge.  Square
+  // the feather first to make the range more visually linear (this
+  // approximately compensates for the Gaussian falloff of the
+  // feathered edge).
+  PN_stdfloat f = params._outline_feather * params._outline_feather;
+
+  for (int yi = 0; yi < outline.get_y_size(); yi++) {
+    for (int xi = 0; xi < outline.get_x_size(); xi++) {
+      PN_stdfloat v = outline.get_gray(xi, yi);
+      if (v == 0.0f) {
+        // Do nothing.
+      } else if (v >= f) {
+        // Clamp to 1.
+        outline.set_gray(xi, yi, 1.0);
+      } else {
+        // Linearly scale the range 0 .. f onto 0 .. 1.
+        outline.set_gray(xi, yi, v / f);
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: DynamicTextFont::make_distance_field
+//       Access: Public
+//  Description: Converts a bitmap as rendered by FreeType into a
+//               signed distance field in a PNMImage, for
+//               RM_distance_field mode.  The distance from each
+//               texel to the edge of the glyph is measured on the
+//               full-resolution bitmap, and stored so that 0.5 lies
+//               on the edge, 1.0 lies spread texels inside it, and
+//               0.0 lies spread texels outside it; the image is
+//               padded by spread texels on each side to hold the
+//               outside of the field.  Fills in the final size of
+//               the image in texels, and the spread.
+////////////////////////////////////////////////////////////////////
+void DynamicTextFont::
+make_distance_field(const FT_Bitmap &bitmap,
+                    const DynamicTextRasterizer::Params &params,
+                    PNMImage &result, int &spread,
+                    PN_stdfloat &tex_x_size, PN_stdfloat &tex_y_size) {
+  PN_stdfloat scale_factor = params._scale_factor;
+  spread = params._distance_field_spread;
+  tex_x_size = bitmap.width / scale_factor + spread * 2;
+  tex_y_size = bitmap.rows / scale_factor + spread * 2;
+  int int_x_size = (int)ceil(bitmap.width / scale_factor) + spread * 2;
+  int int_y_size = (int)ceil(bitmap.rows / scale_factor) + spread * 2;
+
+  PNMImage image(bitmap.width, bitmap.rows, PNMImage::CT_grayscale);
+  copy_bitmap_to_pnmimage(bitmap, image);
+
+  // The distances are measured on a grid of font pixels that covers
+  // the whole of the padded image.
+  int pad = (int)floor(spread * scale_factor + 0.5f);
+  int grid_x_size = (int)(int_x_size * scale_factor + 0.5f);
+  int grid_y_size = (int)(int_y_size * scale_factor + 0.5f);
+  int num_cells = grid_x_size * grid_y_size;
+  float far_away = (float)(grid_x_size + grid_y_size);
+  far_away *= far_away;
+
+  pvector<float> to_inside(num_cells);
+  pvector<float> to_outside(num_cells);
+  pvector<bool> inside(num_cells);
+  for (int gy = 0; gy < grid_y_size; ++gy) {
+    int by = gy - pad;
+    for (int gx = 0; gx < grid_x_size; ++gx) {
+      int bx = gx - pad;
+      int i = gy * grid_x_size + gx;
+      inside[i] = (bx >= 0 && bx < bitmap.width && by >= 0 && by < bitmap.rows &&
+                   image.get_gray(bx, by) >= 0.5f);
+      to_inside[i] = inside[i] ? 0.0f : far_away;
+      to_outside[i] = inside[i] ? far_away : 0.0f;
+    }
+  }
+
+  distance_transform_2d(&to_inside[0], grid_x_size, grid_y_size);
+  distance_transform_2d(&to_outside[0], grid_x_size, grid_y_size);
+
+  // Combine the two into a single field, in font pixels, positive
+  // inside the glyph.  The edge lies halfway between the centers of
+  // the nearest inside and outside pixels.
+  pvector<float> field(num_cells);
+  for (int i = 0; i < num_cells; ++i) {
+    if (inside[i]) {
+      field[i] = csqrt(to_outside[i]) - 0.5f;
+    } else {
+      field[i] = 0.5f - csqrt(to_inside[i]);
+    }
+  }
+
+  // Now sample the field at the center of each texel.
+  PN_stdfloat scale = 1.0f / (scale_factor * spread * 2);
+  result.clear(int_x_size, int_y_size, PNMImage::CT_grayscale);
+  for (int yi = 0; yi < int_y_size; ++yi) {
+    float gy = (yi + 0.5f) * scale_factor - 0.5f;
+    gy = max(0.0f, min(gy, (float)(grid_y_size - 1)));
+    int y0 = (int)gy;
+    int y1 = min(y0 + 1, grid_y_size - 1);
+    float fy = gy - y0;
+
+    for (int xi = 0; xi < int_x_size; ++xi) {
+      float gx = (xi + 0.5f) * scale_factor - 0.5f;
+      gx = max(0.0f, min(gx, (float)(grid_x_size - 1)));
+      int x0 = (int)gx;
+      int x1 = min(x0 + 1, grid_x_size - 1);
+      float fx = gx - x0;
+
+      float top = field[y0 * grid_x_size + x0] * (1.0f - fx) +
+        field[y0 * grid_x_size + x1] * fx;
+      float bottom = field[y1 * grid_x_size + x0] * (1.0f - fx) +
+        field[y1 * grid_x_size + x1] * fx;
+      float distance = top * (1.0f - fy) + bottom * fy;
+
+      PN_stdfloat value = 0.5f + distance * scale;
+      result.set_gray(xi, yi, max((PN_stdfloat)0.0f, min(value, (PN_stdfloat)1.0f)));
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: DynamicTextFont::distance_transform_2d
+//       Access: Public, Static
+//  Description: Replaces each cell of the grid with the squared
+//               distance to the nearest cell that was 0, using the
+//               separable algorithm of Felzenszwalb and Huttenlocher:
+//               the columns are transformed first, and then the rows.
+//               The cells that are not 0 should initially hold some
+//               suitably large value.
+////////////////////////////////////////////////////////////////////
+void DynamicTextFont::
+distance_transform_2d(float *grid, int x_size, int y_size) {
+  int n = max(x_size, y_size);
+  pvector<float> f(n);
+  pvector<float> d(n);
+  pvector<float> z(n + 1);
+  pvector<int> v(n);
+
+  for (int x = 0; x < x_size; ++x) {
+    for (int y = 0; y < y_size; ++y) {
+      f[y] = grid[y * x_size + x];
+    }
+    distance_transform_1d(&f[0], &d[0], &v[0], &z[0], y_size);
+    for (int y = 0; y < y_size; ++y) {
+      grid[y * x_size + x] = d[y];
+    }
+  }
+
+  for (int y = 0; y < y_size; ++y) {
+    float *row = grid + y * x_size;
+    distance_transform_1d(row, &d[0], &v[0], &z[0], x_size);
+    memcpy(row, &d[0], x_size * sizeof(float));
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: DynamicTextFont::distance_transform_1d
+//       Access: Public, Static
+//  Description: The one-dimensional pass of distance_transform_2d().
+//               Computes into d the lower envelope of the parabolas
+//               rooted at each of the n values of f.  v and z are
+//               scratch arrays of n and n + 1 elements.
+////////////////////////////////////////////////////////////////////
+void DynamicTextFont::
+distance_transform_1d(const float *f, float *d, int *v, float *z, int n) {
+  int k = 0;
+  v[0] = 0;
+  z[0] = -make_inf(0.0f);
+  z[1] = make_inf(0.0f);
+
+  for (int q = 1; q < n; ++q) {
+    float s;
+    while (true) {
+      int p = v[k];
+      s = ((f[q] + q * q) - (f[p] + p * p)) / (2 * (q - p));
+      if (s > z[k] || k == 0) {
+        break;
+      }
+      --k;
+    }
+    ++k;
+    v[k] = q;
+    z[k] = s;
+    z[k + 1] = make_inf(0.0f);
+  }
+
+  k = 0;
+  for (int q = 0; q < n; ++q) {
+    while (z[k + 1] < q) {
+      ++k;
+    }
+    int p = v[k];
+    d[q] = (float)((q - p) * (q - p)) + f[p];
+  }
+}
+
+// The shader used to draw the glyphs in RM_distance_field mode.  It
+// finds the edge of the glyph at 0.5 in the distance field, and
+// antialiases it over the width of one screen pixel.
+static const string distance_field_vshader =
+  "#version 120\n"
+  "attribute vec4 p3d_Vertex;\n"
+  "attribute vec4 p3d_Color;\n"
+  "attribute vec2 p3d_MultiTexCoord0;\n"
+  "uniform mat4 p3d_ModelViewProjectionMatrix;\n"
+  "uniform vec4 p3d_ColorScale;\n"
+  "varying vec2 texcoord;\n"
+  "varying vec4 color;\n"
+  "void main(void) {\n"
+  "  gl_Position = p3d_ModelViewProjectionMatrix * p3d_Vertex;\n"
+  "  texcoord = p3d_MultiTexCoord0;\n"
+  "  color = p3d_Color * p3d_ColorScale;\n"
+  "}\n";
+
+static const string distance_field_fshader =
+  "#version 120\n"
+  "uniform sampler2D p3d_Texture0;\n"
+  "uniform vec4 text_fg;\n"
+  "uniform vec4 text_outline_color;\n"
+  "uniform vec4 text_outline;\n"
+  "varying vec2 texcoord;\n"
+  "varying vec4 color;\n"
+  "void main(void) {\n"
+  "  float dist = texture2D(p3d_Texture0, texcoord).a;\n"
+  "  float aa = max(fwidth(dist) * 0.75, 0.0001);\n"
+  "  float fill = smoothstep(0.5 - aa, 0.5 + aa, dist);\n"
+  "  float outline = smoothstep(text_outline.x - aa - text_outline.y,\n"
+  "                             text_outline.x + aa, dist);\n"
+  "  float fill_a = fill * text_fg.a;\n"
+  "  float outline_a = outline * text_outline_color.a * (1.0 - fill_a);\n"
+  "  float a = fill_a + outline_a;\n"
+  "  vec3 rgb = (text_fg.rgb * fill_a + text_outline_color.rgb * outline_a) / max(a, 0.0001);\n"
+  "  gl_FragColor = vec4(rgb, a) * color;\n"
+  "}\n";
+
+////////////////////////////////////////////////////////////////////
+//     Function: DynamicTextFont::get_distance_field_attrib
+//       Access: Private
+//  Description: Returns the ShaderAttrib that is applied to each
+//               glyph in RM_distance_field mode, with the shader
+//               inputs that describe the font's fg color and
+//               outline.
+////////////////////////////////////////////////////////////////////
+CPT(RenderAttrib) DynamicTextFont::
+get_distance_field_attrib() {
+  if (_distance_field_attrib != (RenderAttrib *)NULL) {
+    return _distance_field_attrib;
+  }
+
+  if (_distance_field_shader == (Shader *)NULL) {
+    _distance_field_shader =
+      Shader::make(Shader::SL_GLSL, distance_field_vshader, distance_field_fshader);
+  }
+
+  // Convert the outline width from points to the units of the
+  // distance field; the outline can't extend beyond the field.
+  LColor outline_color(_fg[0], _fg[1], _fg[2], 0.0f);
+  PN_stdfloat outline_size = 0.0f;
+  if (_has_outline) {
+    outline_color = _outline_color;
+    PN_stdfloat outline_pixels = _outline_width / _points_per_unit * _tex_pixels_per_unit;
+    outline_size = min(outline_pixels / (_distance_field_spread * 2), (PN_stdfloat)0.5f);
+  }
+
+  CPT(RenderAttrib) attrib = ShaderAttrib::make(_distance_field_shader);
+  attrib = DCAST(ShaderAttrib, attrib)->set_shader_input
+    (InternalName::make("text_fg"), LVecBase4(_fg));
+  attrib = DCAST(ShaderAttrib, attrib)->set_shader_input
+    (InternalName::make("text_outline_color"), LVecBase4(outline_color));
+  attrib = DCAST(ShaderAttrib, attrib)->set_shader_input
+    (InternalName::make("text_outline"),
+     LVecBase4(0.5f - outline_size, outline_size * _outline_feather, 0.0f, 0.0f));
+
+  _distance_field_attrib = attrib;
+  return _distance_field_attrib;
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: DynamicTextFont::blend_pnmimage_to_texture
 //       Access: Private
@@ -886,6 +1296,251 @@ slot_glyph(int character, int x_size, int y_size) {
   }
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: DynamicTextFont::preload_glyph
+//       Access: Private
+//  Description: Renders (or queues) the glyph for the indicated
+//               character, if it is defined by the font and not
+//               already rendered.
+////////////////////////////////////////////////////////////////////
+void DynamicTextFont::
+preload_glyph(int character) {
+  // We acquire the face anew for each glyph, so that the background
+  // thread may take its turn in between.
+  FT_Face face = acquire_face();
+  int glyph_index = FT_Get_Char_Index(face, character);
+  if (glyph_index != 0 && _cache.find(glyph_index) == _cache.end() &&
+      !request_glyph(character, glyph_index)) {
+    DynamicTextGlyph *glyph = make_glyph(character, face, glyph_index);
+    _cache.insert(Cache::value_type(glyph_index, glyph));
+    pin_glyph(glyph_index, glyph);
+  }
+  release_face(face);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: DynamicTextFont::pin_glyph
+//       Access: Private
+//  Description: Protects a glyph that has been rendered before it is
+//               needed from being removed by garbage_collect() to
+//               make room for other glyphs, until get_glyph() first
+//               returns it.  Otherwise, a large preload, or a large
+//               batch of glyphs from the DynamicTextRasterizer, would
+//               evict its own glyphs as soon as the page filled up.
+////////////////////////////////////////////////////////////////////
+void DynamicTextFont::
+pin_glyph(int glyph_index, DynamicTextGlyph *glyph) {
+  if (glyph != (DynamicTextGlyph *)NULL &&
+      glyph->_page != (DynamicTextPage *)NULL &&
+      _pinned.insert(glyph_index).second) {
+    glyph->_geom_count++;
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: DynamicTextFont::request_glyph
+//       Access: Private
+//  Description: Asks the DynamicTextRasterizer to render the
+//               indicated glyph, if async rasterization is in effect
+//               and it has not been asked already.  Returns true if
+//               the glyph is (or already was) being rendered in the
+//               background, or false if it should be rendered
+//               immediately instead.
+////////////////////////////////////////////////////////////////////
+bool DynamicTextFont::
+request_glyph(int character, int glyph_index) {
+  if (!_async_rasterize ||
+      (_render_mode != RM_texture && _render_mode != RM_distance_field)) {
+    return false;
+  }
+
+  if (_pending.find(glyph_index) != _pending.end()) {
+    return true;
+  }
+
+  // The thread renders the glyph with a copy of the current settings,
+  // which it may read while this thread goes on changing the font.
+  DynamicTextRasterizer::Params params;
+  get_raster_params(params);
+
+  DynamicTextRasterizer *rasterizer = DynamicTextRasterizer::get_global_ptr();
+  if (!rasterizer->add_glyph(this, character, glyph_index, _rasterize_seq,
+                             params)) {
+    return false;
+  }
+
+  _pending.insert(Pending::value_type(glyph_index, NULL));
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: DynamicTextFont::get_placeholder
+//       Access: Private
+//  Description: Returns the empty glyph that stands in for the
+//               indicated pending glyph until it has been rendered.
+//               The placeholder has the same advance as the real
+//               glyph will have, so the text will not change its
+//               layout when the glyph arrives.
+////////////////////////////////////////////////////////////////////
+DynamicTextGlyph *DynamicTextFont::
+get_placeholder(int character, FT_Face face, int glyph_index) {
+  Pending::iterator pi = _pending.find(glyph_index);
+  nassertr(pi != _pending.end(), (DynamicTextGlyph *)NULL);
+
+  if ((*pi).second == (DynamicTextGlyph *)NULL) {
+    // Loading the glyph outline to measure its advance is much
+    // cheaper than rendering it.
+    PN_stdfloat advance = 0.0f;
+    if (load_glyph(face, glyph_index, false)) {
+      advance = face->glyph->advance.x / 64.0;
+    }
+    (*pi).second = new DynamicTextGlyph(character, advance / _font_pixels_per_unit);
+  }
+
+  DynamicTextRasterizer::get_global_ptr()->note_placeholder();
+  return (*pi).second;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: DynamicTextFont::rasterize_glyph
+//       Access: Private
+//  Description: Renders the indicated glyph into the images of the
+//               DynamicTextRasterizer::Glyph, ready to be copied into
+//               a page by place_rasterized_glyph().  This is the
+//               first half of make_glyph(), in RM_texture or
+//               RM_distance_field mode; it is called on the
+//               DynamicTextRasterizer's thread.  It reads the font
+//               settings only from the copy in the Glyph, and does
+//               not touch the pages or the cache.
+////////////////////////////////////////////////////////////////////
+void DynamicTextFont::
+rasterize_glyph(DynamicTextRasterizer::Glyph *raster) {
+  const DynamicTextRasterizer::Params &params = raster->_params;
+  FreetypeFace *ft_face = params._face;
+  nassertv(ft_face != (FreetypeFace *)NULL);
+
+  FT_Face face = ft_face->acquire_face(params._char_size, params._dpi,
+                                       params._pixel_width,
+                                       params._pixel_height);
+  if (!load_glyph(face, raster->_glyph_index, false)) {
+    ft_face->release_face(face);
+    return;
+  }
+
+  FT_GlyphSlot slot = face->glyph;
+  FT_Bitmap &bitmap = slot->bitmap;
+
+  if ((bitmap.width == 0 || bitmap.rows == 0) && (raster->_glyph_index == 0)) {
+    // As in make_glyph(), an empty invalid glyph is replaced with
+    // Panda's invalid glyph.
+    ft_face->release_face(face);
+    return;
+  }
+
+  raster->_valid = true;
+  raster->_advance = slot->advance.x / 64.0;
+
+  if (slot->format != ft_glyph_format_bitmap) {
+    FT_Render_Glyph(slot, ft_render_mode_normal);
+  }
+
+  if (bitmap.width == 0 || bitmap.rows == 0) {
+    // An empty glyph, such as a space.  We leave the image empty.
+    ft_face->release_face(face);
+    return;
+  }
+
+  int outline = 0;
+  if (params._render_mode == RM_distance_field) {
+    make_distance_field(bitmap, params, raster->_image, outline,
+                        raster->_tex_x_size, raster->_tex_y_size);
+
+  } else if (params._tex_pixels_per_unit == params._font_pixels_per_unit &&
+             !params._needs_image_processing) {
+    raster->_image.clear(bitmap.width, bitmap.rows, PNMImage::CT_grayscale);
+    copy_bitmap_to_pnmimage(bitmap, raster->_image);
+    raster->_tex_x_size = bitmap.width;
+    raster->_tex_y_size = bitmap.rows;
+
+  } else {
+    reduce_bitmap(bitmap, params, raster->_image, outline,
+                  raster->_tex_x_size, raster->_tex_y_size);
+  }
+
+  raster->_top = (int)floor(slot->bitmap_top + outline * params._scale_factor + 0.5f);
+  raster->_left = (int)floor(slot->bitmap_left - outline * params._scale_factor + 0.5f);
+  ft_face->release_face(face);
+
+  // The outline is the most expensive part, and doesn't need the face.
+  if (params._needs_image_processing && params._has_outline) {
+    make_outline_image(raster->_image, params, raster->_outline);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: DynamicTextFont::place_rasterized_glyph
+//       Access: Private
+//  Description: Slots a glyph rendered by rasterize_glyph() into the
+//               pages, and adds it to the cache in place of its
+//               placeholder.  This is the second half of
+//               make_glyph(), called by DynamicTextRasterizer::flush()
+//               on the main thread.
+////////////////////////////////////////////////////////////////////
+void DynamicTextFont::
+place_rasterized_glyph(DynamicTextRasterizer::Glyph *raster) {
+  if (raster->_font_seq != _rasterize_seq) {
+    // The font has been cleared since this glyph was requested.
+    return;
+  }
+
+  Pending::iterator pi = _pending.find(raster->_glyph_index);
+  if (pi == _pending.end()) {
+    return;
+  }
+  _pending.erase(pi);
+
+  if (_cache.find(raster->_glyph_index) != _cache.end()) {
+    // It has been rendered some other way in the meantime.
+    return;
+  }
+
+  DynamicTextGlyph *glyph = (DynamicTextGlyph *)NULL;
+  if (!raster->_valid) {
+    // Leave it NULL, to show the invalid glyph.
+
+  } else if (!raster->_image.is_valid()) {
+    PT(DynamicTextGlyph) empty_glyph =
+      new DynamicTextGlyph(raster->_character,
+                           raster->_advance / _font_pixels_per_unit);
+    _empty_glyphs.push_back(empty_glyph);
+    glyph = empty_glyph;
+
+  } else {
+    glyph = slot_glyph(raster->_character, raster->_image.get_x_size(),
+                       raster->_image.get_y_size());
+    if (glyph != (DynamicTextGlyph *)NULL) {
+      if (!_needs_image_processing) {
+        copy_pnmimage_to_texture(raster->_image, glyph);
+      } else {
+        if (raster->_outline.is_valid()) {
+          blend_pnmimage_to_texture(raster->_outline, glyph, _outline_color);
+        }
+        blend_pnmimage_to_texture(raster->_image, glyph, _fg);
+      }
+
+      glyph->make_geom(raster->_top, raster->_left, raster->_advance,
+                       _poly_margin, raster->_tex_x_size, raster->_tex_y_size,
+                       _font_pixels_per_unit, _tex_pixels_per_unit);
+      if (_render_mode == RM_distance_field) {
+        glyph->add_state_attrib(get_distance_field_attrib());
+      }
+    }
+  }
+
+  _cache.insert(Cache::value_type(raster->_glyph_index, glyph));
+  pin_glyph(raster->_glyph_index, glyph);
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: DynamicTextFont::render_wireframe_contours
 //       Access: Private
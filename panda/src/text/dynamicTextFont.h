@@ -23,9 +23,13 @@
 #include "freetypeFont.h"
 #include "dynamicTextGlyph.h"
 #include "dynamicTextPage.h"
+#include "dynamicTextRasterizer.h"
+#include "renderAttrib.h"
+#include "shader.h"
 #include "filename.h"
 #include "pvector.h"
 #include "pmap.h"
+#include "pset.h"
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
@@ -100,6 +104,12 @@ PUBLISHED:
   INLINE PN_stdfloat get_outline_feather() const;
   INLINE Texture::Format get_tex_format() const;
 
+  INLINE void set_async_rasterize(bool async_rasterize);
+  INLINE bool get_async_rasterize() const;
+
+  void preload_glyphs(const wstring &text);
+  void preload_glyph_range(int first_character, int last_character);
+
   int get_num_pages() const;
   DynamicTextPage *get_page(int n) const;
   MAKE_SEQ(get_pages, get_num_pages, get_page);
@@ -112,17 +122,42 @@ PUBLISHED:
 public:
   virtual bool get_glyph(int character, const TextGlyph *&glyph);
 
+  void make_distance_field(const FT_Bitmap &bitmap,
+                           const DynamicTextRasterizer::Params &params,
+                           PNMImage &result, int &spread,
+                           PN_stdfloat &tex_x_size, PN_stdfloat &tex_y_size);
+  static void distance_transform_2d(float *grid, int x_size, int y_size);
+  static void distance_transform_1d(const float *f, float *d, int *v,
+                                    float *z, int n);
+
 private:
   void initialize();
   void update_filters();
   void determine_tex_format();
   DynamicTextGlyph *make_glyph(int character, FT_Face face, int glyph_index);
+  void get_raster_params(DynamicTextRasterizer::Params &params) const;
+  void reduce_bitmap(const FT_Bitmap &bitmap,
+                     const DynamicTextRasterizer::Params &params,
+                     PNMImage &result, int &outline,
+                     PN_stdfloat &tex_x_size, PN_stdfloat &tex_y_size);
   void copy_bitmap_to_texture(const FT_Bitmap &bitmap, DynamicTextGlyph *glyph);
   void copy_pnmimage_to_texture(const PNMImage &image, DynamicTextGlyph *glyph);
+  static void make_outline_image(const PNMImage &image,
+                                 const DynamicTextRasterizer::Params &params,
+                                 PNMImage &outline);
+  CPT(RenderAttrib) get_distance_field_attrib();
   void blend_pnmimage_to_texture(const PNMImage &image, DynamicTextGlyph *glyph,
                                  const LColor &fg);
   DynamicTextGlyph *slot_glyph(int character, int x_size, int y_size);
 
+  void preload_glyph(int character);
+  void pin_glyph(int glyph_index, DynamicTextGlyph *glyph);
+  bool request_glyph(int character, int glyph_index);
+  DynamicTextGlyph *get_placeholder(int character, FT_Face face,
+                                    int glyph_index);
+  void rasterize_glyph(DynamicTextRasterizer::Glyph *raster);
+  void place_rasterized_glyph(DynamicTextRasterizer::Glyph *raster);
+
   void render_wireframe_contours(DynamicTextGlyph *glyph);
   void render_polygon_contours(DynamicTextGlyph *glyph, bool face, bool extrude);
 
@@ -153,6 +188,14 @@ private:
   Texture::Format _tex_format;
   bool _needs_image_processing;
 
+  // In RM_distance_field mode, the pages store the distance to the
+  // edge of each glyph out to this many texels, and each glyph is
+  // drawn with this attrib, which applies the shader and the font's
+  // colors.  The attrib is rebuilt whenever the colors change.
+  int _distance_field_spread;
+  CPT(RenderAttrib) _distance_field_attrib;
+  static PT(Shader) _distance_field_shader;
+
   typedef pvector< PT(DynamicTextPage) > Pages;
   Pages _pages;
   int _preferred_page;
@@ -169,6 +212,24 @@ private:
   typedef pvector< PT(DynamicTextGlyph) > EmptyGlyphs;
   EmptyGlyphs _empty_glyphs;
 
+  // These are the glyphs that have been handed to the
+  // DynamicTextRasterizer, but not yet placed on a page, along with
+  // the placeholder we return for each in the meantime (or NULL if
+  // none has been asked for yet).  _rasterize_seq is incremented by
+  // clear(), so that glyphs rendered for an earlier generation of
+  // the font can be recognized and discarded.
+  bool _async_rasterize;
+  typedef pmap<int, PT(DynamicTextGlyph) > Pending;
+  Pending _pending;
+  int _rasterize_seq;
+
+  // These are the glyphs that were rendered ahead of time, by
+  // preload_glyphs() or the DynamicTextRasterizer, and have not been
+  // used yet.  Each holds an extra count in its _geom_count, so that
+  // garbage_collect() will not remove it before it is ever shown.
+  typedef pset<int> Pinned;
+  Pinned _pinned;
+
   class ContourPoint {
   public:
     INLINE ContourPoint(const LPoint2 &p, const LVector2 &in, 
@@ -209,6 +270,7 @@ private:
   static TypeHandle _type_handle;
 
   friend class TextNode;
+  friend class DynamicTextRasterizer;
 };
 
 INLINE ostream &operator << (ostream &out, const DynamicTextFont &dtf);
@@ -64,6 +64,7 @@ public:
   void make_geom(int top, int left, PN_stdfloat advance, PN_stdfloat poly_margin,
                  PN_stdfloat tex_x_size, PN_stdfloat tex_y_size,
                  PN_stdfloat font_pixels_per_unit, PN_stdfloat tex_pixels_per_unit);
+  INLINE void add_state_attrib(const RenderAttrib *attrib);
   void set_geom(GeomVertexData *vdata, GeomPrimitive *prim, 
                 const RenderState *state);
   virtual bool is_whitespace() const;
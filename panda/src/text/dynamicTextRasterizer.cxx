@@ -0,0 +1,198 @@
+// Filename: dynamicTextRasterizer.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "dynamicTextRasterizer.h"
+
+#ifdef HAVE_FREETYPE
+
+#include "dynamicTextFont.h"
+#include "mutexHolder.h"
+#include "pStatCollector.h"
+#include "pStatTimer.h"
+#include <algorithm>
+
+DynamicTextRasterizer *DynamicTextRasterizer::_global_ptr = NULL;
+
+static PStatCollector text_rasterize_pcollector("*:Rasterize Text");
+static PStatCollector text_flush_glyphs_pcollector("*:Generate Text:Flush Glyphs");
+
+////////////////////////////////////////////////////////////////////
+//     Function: DynamicTextRasterizer::Constructor
+//       Access: Protected
+//  Description: Use get_global_ptr() to get the one rasterizer.
+////////////////////////////////////////////////////////////////////
+DynamicTextRasterizer::
+DynamicTextRasterizer() :
+  _num_pending(0),
+  _num_placeholders(0),
+  _cvar(_lock)
+{
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: DynamicTextRasterizer::flush
+//       Access: Published
+//  Description: Copies all of the glyphs that the thread has finished
+//               rendering into their font pages, where they replace
+//               the placeholders their fonts have been returning.
+//               Returns true if any glyphs were copied, false if none
+//               were ready.
+//
+//               This must be called on the thread that assembles the
+//               text, and not while any text is being assembled.
+////////////////////////////////////////////////////////////////////
+bool DynamicTextRasterizer::
+flush() {
+  Results results;
+  {
+    MutexHolder holder(_lock);
+    if (_results.empty()) {
+      return false;
+    }
+    _results.swap(results);
+  }
+
+  PStatTimer timer(text_flush_glyphs_pcollector);
+
+  sort(results.begin(), results.end(), SortGlyphs());
+
+  Results::const_iterator ri;
+  for (ri = results.begin(); ri != results.end(); ++ri) {
+    Glyph *glyph = (*ri);
+    glyph->_font->place_rasterized_glyph(glyph);
+    --_num_pending;
+  }
+
+  ++_flush_seq;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: DynamicTextRasterizer::get_global_ptr
+//       Access: Published, Static
+//  Description: Returns the one DynamicTextRasterizer in the system.
+////////////////////////////////////////////////////////////////////
+DynamicTextRasterizer *DynamicTextRasterizer::
+get_global_ptr() {
+  if (_global_ptr == (DynamicTextRasterizer *)NULL) {
+    _global_ptr = new DynamicTextRasterizer;
+  }
+  return _global_ptr;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: DynamicTextRasterizer::add_glyph
+//       Access: Public
+//  Description: Asks the thread to render the indicated glyph of the
+//               font.  When it is done, a later call to flush() will
+//               pass it to DynamicTextFont::place_rasterized_glyph().
+//
+//               The params are the font's current settings, which
+//               the thread renders the glyph with.
+//
+//               Returns true if the glyph has been queued, or false if
+//               no thread is available, in which case the font should
+//               render the glyph itself.
+////////////////////////////////////////////////////////////////////
+bool DynamicTextRasterizer::
+add_glyph(DynamicTextFont *font, int character, int glyph_index,
+          int font_seq, const Params &params) {
+  if (_thread == (GenericThread *)NULL && !start_thread()) {
+    return false;
+  }
+
+  PT(Glyph) glyph = new Glyph;
+  glyph->_font = font;
+  glyph->_character = character;
+  glyph->_glyph_index = glyph_index;
+  glyph->_font_seq = font_seq;
+  glyph->_params = params;
+  glyph->_valid = false;
+  glyph->_advance = 0.0f;
+  glyph->_top = 0;
+  glyph->_left = 0;
+  glyph->_tex_x_size = 0.0f;
+  glyph->_tex_y_size = 0.0f;
+  ++_num_pending;
+
+  MutexHolder holder(_lock);
+  _requests.push_back(glyph);
+  _cvar.notify();
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: DynamicTextRasterizer::start_thread
+//       Access: Private
+//  Description: Starts the rendering thread, if it can be started.
+//               Returns true on success.
+////////////////////////////////////////////////////////////////////
+bool DynamicTextRasterizer::
+start_thread() {
+  if (!Thread::is_true_threads()) {
+    return false;
+  }
+
+  PT(GenericThread) thread =
+    new GenericThread("DynamicTextRasterizer", "DynamicTextRasterizer",
+                      &st_thread_main, this);
+  if (!thread->start(TP_low, false)) {
+    return false;
+  }
+  _thread = thread;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: DynamicTextRasterizer::thread_main
+//       Access: Private
+//  Description: The body of the rendering thread.  Renders each
+//               requested glyph in turn, forever.
+////////////////////////////////////////////////////////////////////
+void DynamicTextRasterizer::
+thread_main() {
+  Thread *current_thread = Thread::get_current_thread();
+
+  while (true) {
+    PT(Glyph) glyph;
+    {
+      MutexHolder holder(_lock);
+      while (_requests.empty()) {
+        _cvar.wait();
+      }
+      glyph = _requests.front();
+      _requests.pop_front();
+    }
+
+    {
+      PStatTimer timer(text_rasterize_pcollector, current_thread);
+      glyph->_font->rasterize_glyph(glyph);
+    }
+
+    MutexHolder holder(_lock);
+    _results.push_back(glyph);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: DynamicTextRasterizer::st_thread_main
+//       Access: Private, Static
+//  Description: The thread function for thread_main().
+////////////////////////////////////////////////////////////////////
+void DynamicTextRasterizer::
+st_thread_main(void *data) {
+  ((DynamicTextRasterizer *)data)->thread_main();
+}
+
+#endif  // HAVE_FREETYPE
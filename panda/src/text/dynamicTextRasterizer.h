@@ -0,0 +1,156 @@
+// Filename: dynamicTextRasterizer.h
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef DYNAMICTEXTRASTERIZER_H
+#define DYNAMICTEXTRASTERIZER_H
+
+#include "pandabase.h"
+
+#ifdef HAVE_FREETYPE
+
+#include "pnmImage.h"
+#include "textFont.h"
+#include "freetypeFace.h"
+#include "pmutex.h"
+#include "conditionVar.h"
+#include "genericThread.h"
+#include "referenceCount.h"
+#include "pointerTo.h"
+#include "pdeque.h"
+#include "pvector.h"
+#include "updateSeq.h"
+
+class DynamicTextFont;
+
+////////////////////////////////////////////////////////////////////
+//       Class : DynamicTextRasterizer
+// Description : Renders the glyphs of DynamicTextFonts on a
+//               background thread, on behalf of fonts for which
+//               set_async_rasterize() has been enabled.
+//
+//               The thread renders each requested glyph into a
+//               PNMImage, including any scaling and outline
+//               processing; the glyphs are copied into the font
+//               pages only by flush(), on the main thread, so that
+//               all of the texture updates for a frame are made at
+//               once, and the text being assembled never sees a page
+//               change beneath it.
+//
+//               There is only one of these, shared by all fonts.
+//               TextNode calls flush() while it has any text waiting
+//               on a glyph; an application that renders text some
+//               other way may call it once per frame.
+////////////////////////////////////////////////////////////////////
+class EXPCL_PANDA_TEXT DynamicTextRasterizer {
+protected:
+  DynamicTextRasterizer();
+
+PUBLISHED:
+  bool flush();
+
+  INLINE int get_num_pending() const;
+  INLINE int get_num_placeholders() const;
+  INLINE UpdateSeq get_flush_seq() const;
+
+  static DynamicTextRasterizer *get_global_ptr();
+
+public:
+  ////////////////////////////////////////////////////////////////////
+  //       Class : DynamicTextRasterizer::Params
+  // Description : A copy of the font settings that determine how a
+  //               glyph is rendered, taken on the main thread when
+  //               the glyph is requested.  The thread reads only
+  //               this copy, never the font itself, whose settings
+  //               the main thread may change at any time.
+  ////////////////////////////////////////////////////////////////////
+  class Params {
+  public:
+    PT(FreetypeFace) _face;
+    int _char_size;
+    int _dpi;
+    int _pixel_width;
+    int _pixel_height;
+
+    TextFont::RenderMode _render_mode;
+    PN_stdfloat _tex_pixels_per_unit;
+    PN_stdfloat _font_pixels_per_unit;
+    PN_stdfloat _scale_factor;
+    PN_stdfloat _outline_width;
+    PN_stdfloat _outline_feather;
+    bool _needs_image_processing;
+    bool _has_outline;
+    int _distance_field_spread;
+  };
+
+  ////////////////////////////////////////////////////////////////////
+  //       Class : DynamicTextRasterizer::Glyph
+  // Description : One glyph requested of the thread, and the image
+  //               it rendered.
+  ////////////////////////////////////////////////////////////////////
+  class Glyph : public ReferenceCount {
+  public:
+    PT(DynamicTextFont) _font;
+    int _character;
+    int _glyph_index;
+    int _font_seq;
+    Params _params;
+
+    // The remaining members are filled in by the thread.
+    bool _valid;
+    PN_stdfloat _advance;
+    int _top, _left;
+    PN_stdfloat _tex_x_size, _tex_y_size;
+    PNMImage _image;
+    PNMImage _outline;
+  };
+
+  bool add_glyph(DynamicTextFont *font, int character, int glyph_index,
+                 int font_seq, const Params &params);
+  INLINE void note_placeholder();
+
+private:
+  bool start_thread();
+  void thread_main();
+  static void st_thread_main(void *data);
+
+  class SortGlyphs {
+  public:
+    INLINE bool operator () (const Glyph *a, const Glyph *b) const;
+  };
+
+  // These are only touched by the main thread.
+  int _num_pending;
+  int _num_placeholders;
+  UpdateSeq _flush_seq;
+  PT(GenericThread) _thread;
+
+  // The remaining members are protected by _lock.
+  Mutex _lock;
+
+  // Signaled whenever a glyph is added to _requests.
+  ConditionVar _cvar;
+
+  typedef pdeque<PT(Glyph) > Requests;
+  Requests _requests;
+  typedef pvector<PT(Glyph) > Results;
+  Results _results;
+
+  static DynamicTextRasterizer *_global_ptr;
+};
+
+#include "dynamicTextRasterizer.I"
+
+#endif  // HAVE_FREETYPE
+
+#endif
@@ -184,6 +184,25 @@ count_geom(const Geom *other) {
   }
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: GeomTextGlyph::clear_glyphs
+//       Access: Public
+//  Description: Releases the references recorded by count_geom() or
+//               copy_primitives_from(), as when the Geom is about to
+//               be filled again with new primitives.
+////////////////////////////////////////////////////////////////////
+void GeomTextGlyph::
+clear_glyphs() {
+  Glyphs::iterator gi;
+  for (gi = _glyphs.begin(); gi != _glyphs.end(); ++gi) {
+    DynamicTextGlyph *glyph = (*gi);
+    nassertv(glyph != (DynamicTextGlyph *)NULL);
+    glyph->_geom_count--;
+    nassertv(glyph->_geom_count >= 0);
+  }
+  _glyphs.clear();
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: GeomTextGlyph::output
 //       Access: Public, Virtual
@@ -44,6 +44,7 @@ public:
   virtual Geom *make_copy() const;
   virtual bool copy_primitives_from(const Geom *other);
   void count_geom(const Geom *other);
+  void clear_glyphs();
 
   virtual void output(ostream &out) const;
   virtual void write(ostream &out, int indent_level = 0) const;
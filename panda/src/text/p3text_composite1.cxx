@@ -3,6 +3,7 @@
 #include "dynamicTextFont.cxx"
 #include "dynamicTextGlyph.cxx"
 #include "dynamicTextPage.cxx"
+#include "dynamicTextRasterizer.cxx"
 #include "fontPool.cxx"
 #include "geomTextGlyph.cxx"
 #include "staticTextFont.cxx"
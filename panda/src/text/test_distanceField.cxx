@@ -0,0 +1,446 @@
+// Filename: test_distanceField.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "pandabase.h"
+#include "testCheck.h"
+
+#ifdef HAVE_FREETYPE
+
+#include "dynamicTextFont.h"
+#include "dynamicTextGlyph.h"
+#include "default_font.h"
+#include "config_text.h"
+#include "shaderAttrib.h"
+#include "randomizer.h"
+#include "pnmImage.h"
+#include "cmath.h"
+
+// This program checks the signed distance fields made by
+// DynamicTextFont in RM_distance_field mode against distances
+// computed by brute force.  It checks the distance transform on
+// its own, then the fields made from a few small bitmaps, including
+// an empty one and one that is entirely inside the glyph, and
+// finally a glyph rasterized from a font, whose field is compared
+// to one computed from the same glyph rasterized in RM_texture mode.
+// It also checks that the glyph is drawn with the shader inputs that
+// describe the font's colors.
+
+static TestCheck check;
+
+typedef pvector<unsigned char> Bitmap;
+
+////////////////////////////////////////////////////////////////////
+//     Function: brute_force_distance
+//  Description: Returns the squared distance from (x, y) to the
+//               nearest cell of the grid that is true, or far_away if
+//               there is no such cell.
+////////////////////////////////////////////////////////////////////
+static float
+brute_force_distance(const pvector<bool> &grid, int x_size, int y_size,
+                     int x, int y, float far_away) {
+  float best = far_away;
+  for (int gy = 0; gy < y_size; ++gy) {
+    for (int gx = 0; gx < x_size; ++gx) {
+      if (grid[gy * x_size + gx]) {
+        float d = (float)((gx - x) * (gx - x) + (gy - y) * (gy - y));
+        best = min(best, d);
+      }
+    }
+  }
+  return best;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: check_transform
+//  Description: Runs distance_transform_2d() on a grid whose zero
+//               cells are the ones that are true in the indicated
+//               pattern, and compares the result to the brute-force
+//               distance for each cell.  The distances are sums of
+//               squared integers, so they must match exactly.
+////////////////////////////////////////////////////////////////////
+static void
+check_transform(const string &name, const pvector<bool> &zeros,
+                int x_size, int y_size) {
+  float far_away = (float)((x_size + y_size) * (x_size + y_size));
+  pvector<float> grid(x_size * y_size);
+  for (int i = 0; i < x_size * y_size; ++i) {
+    grid[i] = zeros[i] ? 0.0f : far_away;
+  }
+
+  DynamicTextFont::distance_transform_2d(&grid[0], x_size, y_size);
+
+  int num_wrong = 0;
+  for (int y = 0; y < y_size; ++y) {
+    for (int x = 0; x < x_size; ++x) {
+      float expected = brute_force_distance(zeros, x_size, y_size, x, y, far_away);
+      if (grid[y * x_size + x] != expected) {
+        ++num_wrong;
+      }
+    }
+  }
+  check(num_wrong == 0, "distance transform: " + name);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: test_transform
+//  Description: Checks distance_transform_2d() on a few grids.
+////////////////////////////////////////////////////////////////////
+static void
+test_transform() {
+  Randomizer random(17);
+  for (int n = 0; n < 4; ++n) {
+    int x_size = random.random_int(12) + 1;
+    int y_size = random.random_int(12) + 1;
+    pvector<bool> zeros(x_size * y_size);
+    for (int i = 0; i < x_size * y_size; ++i) {
+      zeros[i] = (random.random_int(5) == 0);
+    }
+    ostringstream strm;
+    strm << "random " << x_size << "x" << y_size;
+    check_transform(strm.str(), zeros, x_size, y_size);
+  }
+
+  pvector<bool> one(9 * 7, false);
+  one[3 * 9 + 5] = true;
+  check_transform("one point", one, 9, 7);
+
+  pvector<bool> corners(8 * 5, false);
+  corners[0] = true;
+  corners[8 * 5 - 1] = true;
+  check_transform("opposite corners", corners, 8, 5);
+
+  check_transform("all zero", pvector<bool>(6 * 4, true), 6, 4);
+  check_transform("no zeros", pvector<bool>(6 * 4, false), 6, 4);
+  check_transform("one row", pvector<bool>(10, false), 10, 1);
+
+  pvector<bool> column(11, false);
+  column[4] = true;
+  check_transform("one column", column, 1, 11);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: expected_field
+//  Description: Computes by brute force the distance field that
+//               make_distance_field() should produce for the indicated
+//               8-bit bitmap, with a scale factor of 1: padded by
+//               spread texels on each side, with 0.5 on the edge of
+//               the glyph, 1.0 at spread texels inside it, and 0.0 at
+//               spread texels outside it.
+////////////////////////////////////////////////////////////////////
+static void
+expected_field(PNMImage &result, const Bitmap &bitmap,
+               int width, int rows, int spread) {
+  int x_size = width + spread * 2;
+  int y_size = rows + spread * 2;
+  pvector<bool> inside(x_size * y_size, false);
+  pvector<bool> outside(x_size * y_size, true);
+  for (int by = 0; by < rows; ++by) {
+    for (int bx = 0; bx < width; ++bx) {
+      int i = (by + spread) * x_size + (bx + spread);
+      inside[i] = (bitmap[by * width + bx] >= 128);
+      outside[i] = !inside[i];
+    }
+  }
+
+  float far_away = (float)((x_size + y_size) * (x_size + y_size));
+  result.clear(x_size, y_size, PNMImage::CT_grayscale);
+  for (int y = 0; y < y_size; ++y) {
+    for (int x = 0; x < x_size; ++x) {
+      float distance;
+      if (inside[y * x_size + x]) {
+        distance = csqrt(brute_force_distance(outside, x_size, y_size, x, y, far_away)) - 0.5f;
+      } else {
+        distance = 0.5f - csqrt(brute_force_distance(inside, x_size, y_size, x, y, far_away));
+      }
+      float value = 0.5f + distance / (spread * 2);
+      result.set_gray(x, y, max(0.0f, min(value, 1.0f)));
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: count_mismatches
+//  Description: Returns the number of texels of the image that differ
+//               from the expected field by more than one step, which
+//               allows for rounding.
+////////////////////////////////////////////////////////////////////
+static int
+count_mismatches(const PNMImage &expected, const PNMImage &image) {
+  if (image.get_x_size() != expected.get_x_size() ||
+      image.get_y_size() != expected.get_y_size()) {
+    return expected.get_x_size() * expected.get_y_size();
+  }
+
+  int num_wrong = 0;
+  for (int y = 0; y < expected.get_y_size(); ++y) {
+    for (int x = 0; x < expected.get_x_size(); ++x) {
+      if (abs((int)image.get_gray_val(x, y) - (int)expected.get_gray_val(x, y)) > 1) {
+        ++num_wrong;
+      }
+    }
+  }
+  return num_wrong;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: make_field
+//  Description: Calls make_distance_field() on the indicated 8-bit
+//               bitmap, with the indicated scale factor and spread.
+////////////////////////////////////////////////////////////////////
+static void
+make_field(DynamicTextFont *font, PNMImage &result, Bitmap &bitmap,
+           int width, int rows, PN_stdfloat scale_factor, int spread,
+           int &result_spread, PN_stdfloat &tex_x_size,
+           PN_stdfloat &tex_y_size) {
+  FT_Bitmap ft_bitmap;
+  memset(&ft_bitmap, 0, sizeof(ft_bitmap));
+  ft_bitmap.width = width;
+  ft_bitmap.rows = rows;
+  ft_bitmap.pitch = width;
+  ft_bitmap.buffer = bitmap.empty() ? NULL : &bitmap[0];
+  ft_bitmap.num_grays = 256;
+  ft_bitmap.pixel_mode = ft_pixel_mode_grays;
+
+  DynamicTextRasterizer::Params params;
+  params._render_mode = TextFont::RM_distance_field;
+  params._scale_factor = scale_factor;
+  params._distance_field_spread = spread;
+
+  font->make_distance_field(ft_bitmap, params, result, result_spread,
+                            tex_x_size, tex_y_size);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: check_field
+//  Description: Makes the distance field of the indicated 8-bit
+//               bitmap at a scale factor of 1, and compares it to the
+//               brute-force field.
+////////////////////////////////////////////////////////////////////
+static void
+check_field(DynamicTextFont *font, const string &name, Bitmap bitmap,
+            int width, int rows, int spread) {
+  PNMImage image;
+  int result_spread;
+  PN_stdfloat tex_x_size, tex_y_size;
+  make_field(font, image, bitmap, width, rows, 1.0f, spread,
+             result_spread, tex_x_size, tex_y_size);
+
+  check(result_spread == spread, name + ": spread");
+  check(image.get_x_size() == width + spread * 2 &&
+        image.get_y_size() == rows + spread * 2, name + ": padded size");
+  check(tex_x_size == width + spread * 2 &&
+        tex_y_size == rows + spread * 2, name + ": texel size");
+
+  PNMImage expected;
+  expected_field(expected, bitmap, width, rows, spread);
+  check(count_mismatches(expected, image) == 0, name + ": field");
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: test_fields
+//  Description: Checks make_distance_field() on a few bitmaps.
+////////////////////////////////////////////////////////////////////
+static void
+test_fields(DynamicTextFont *font) {
+  // A disk, with soft edges that must be thresholded at half.
+  Bitmap disk(11 * 9);
+  for (int y = 0; y < 9; ++y) {
+    for (int x = 0; x < 11; ++x) {
+      float d = csqrt((float)((x - 5) * (x - 5) + (y - 4) * (y - 4)));
+      disk[y * 11 + x] = (unsigned char)max(0.0f, min(255.0f, (4.0f - d) * 128.0f));
+    }
+  }
+  check_field(font, "disk", disk, 11, 9, 4);
+  check_field(font, "disk, spread 2", disk, 11, 9, 2);
+
+  // A ring has inside cells that are far from the outside of the
+  // image, and outside cells that are enclosed by the glyph.
+  Bitmap ring(13 * 13);
+  for (int y = 0; y < 13; ++y) {
+    for (int x = 0; x < 13; ++x) {
+      int d2 = (x - 6) * (x - 6) + (y - 6) * (y - 6);
+      ring[y * 13 + x] = (d2 >= 9 && d2 <= 36) ? 255 : 0;
+    }
+  }
+  check_field(font, "ring", ring, 13, 13, 3);
+
+  // With nothing inside, the whole field is as far outside as it
+  // goes.
+  check_field(font, "empty", Bitmap(6 * 5, 0), 6, 5, 4);
+
+  // With the whole bitmap inside, only the padding is outside.
+  check_field(font, "all inside", Bitmap(7 * 6, 255), 7, 6, 3);
+
+  {
+    PNMImage image;
+    Bitmap bitmap(20 * 20, 255);
+    int spread;
+    PN_stdfloat tex_x_size, tex_y_size;
+    make_field(font, image, bitmap, 20, 20, 1.0f, 4, spread,
+               tex_x_size, tex_y_size);
+    check(image.get_gray_val(14, 14) == 255, "all inside: center is 1.0");
+    check(image.get_gray_val(0, 0) == 0, "all inside: corner is 0.0");
+  }
+
+  // At a scale factor of 2, the field is measured on the bitmap but
+  // stored at half the size, with the padding in texels.
+  {
+    PNMImage image;
+    Bitmap bitmap(9 * 7, 255);
+    int spread;
+    PN_stdfloat tex_x_size, tex_y_size;
+    make_field(font, image, bitmap, 9, 7, 2.0f, 3, spread,
+               tex_x_size, tex_y_size);
+    check(spread == 3, "scale factor 2: spread");
+    check(image.get_x_size() == 5 + 6 && image.get_y_size() == 4 + 6,
+          "scale factor 2: padded size");
+    check(tex_x_size == 4.5f + 6 && tex_y_size == 3.5f + 6,
+          "scale factor 2: texel size");
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: get_glyph_image
+//  Description: Copies the texels of the glyph from its page into
+//               the image.
+////////////////////////////////////////////////////////////////////
+static void
+get_glyph_image(DynamicTextGlyph *glyph, PNMImage &image) {
+  int x_size = glyph->_x_size - glyph->_margin * 2;
+  int y_size = glyph->_y_size - glyph->_margin * 2;
+  image.clear(x_size, y_size, PNMImage::CT_grayscale);
+  for (int y = 0; y < y_size; ++y) {
+    const unsigned char *row = glyph->get_row(y);
+    for (int x = 0; x < x_size; ++x) {
+      image.set_gray_val(x, y, row[x]);
+    }
+  }
+}
+
+#ifdef COMPILE_IN_DEFAULT_FONT
+////////////////////////////////////////////////////////////////////
+//     Function: make_font
+//  Description: Returns a new instance of the compiled-in font, with
+//               the indicated render mode, at a scale factor of 1.
+////////////////////////////////////////////////////////////////////
+static PT(DynamicTextFont)
+make_font(TextFont::RenderMode render_mode) {
+  PT(DynamicTextFont) font =
+    new DynamicTextFont((const char *)default_font_data, default_font_size, 0);
+  font->set_scale_factor(1.0f);
+  font->set_render_mode(render_mode);
+  return font;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: load_glyph
+//  Description: Returns the indicated glyph of the font, or NULL if
+//               it can't be had.
+////////////////////////////////////////////////////////////////////
+static DynamicTextGlyph *
+load_glyph(DynamicTextFont *font, int character) {
+  const TextGlyph *glyph;
+  if (!font->get_glyph(character, glyph) || glyph == (TextGlyph *)NULL ||
+      !glyph->is_of_type(DynamicTextGlyph::get_class_type())) {
+    return NULL;
+  }
+  return (DynamicTextGlyph *)glyph;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: test_glyph
+//  Description: Rasterizes a glyph of the compiled-in font in
+//               RM_distance_field mode, and compares its field to the
+//               brute-force field of the same glyph rasterized in
+//               RM_texture mode.
+////////////////////////////////////////////////////////////////////
+static void
+test_glyph() {
+  PT(DynamicTextFont) texture_font = make_font(TextFont::RM_texture);
+  PT(DynamicTextFont) field_font = make_font(TextFont::RM_distance_field);
+
+  // In RM_distance_field mode, the color doesn't change the pages, only
+  // the shader inputs.
+  field_font->set_fg(LColor(1.0f, 0.5f, 0.25f, 1.0f));
+
+  DynamicTextGlyph *texture_glyph = load_glyph(texture_font, 'R');
+  DynamicTextGlyph *field_glyph = load_glyph(field_font, 'R');
+  if (!check(texture_glyph != NULL && field_glyph != NULL, "glyph: rasterize")) {
+    return;
+  }
+  check(texture_glyph->get_page()->get_format() == Texture::F_alpha &&
+        field_glyph->get_page()->get_format() == Texture::F_alpha,
+        "glyph: page format");
+
+  PNMImage bitmap_image, field_image;
+  get_glyph_image(texture_glyph, bitmap_image);
+  get_glyph_image(field_glyph, field_image);
+
+  int width = bitmap_image.get_x_size();
+  int rows = bitmap_image.get_y_size();
+  Bitmap bitmap(width * rows);
+  for (int y = 0; y < rows; ++y) {
+    for (int x = 0; x < width; ++x) {
+      bitmap[y * width + x] = (unsigned char)bitmap_image.get_gray_val(x, y);
+    }
+  }
+
+  PNMImage expected;
+  expected_field(expected, bitmap, width, rows, text_distance_field_spread);
+  check(count_mismatches(expected, field_image) == 0, "glyph: field");
+
+  // The glyph is drawn with the distance field shader, which gets the
+  // font's colors from its inputs.
+  const ShaderAttrib *sattr;
+  if (!check(field_glyph->get_state()->get_attrib(sattr), "glyph: shader attrib")) {
+    return;
+  }
+  check(sattr->get_shader() != (Shader *)NULL, "glyph: shader");
+  check(sattr->has_shader_input(InternalName::make("text_fg")), "glyph: text_fg");
+  check(sattr->has_shader_input(InternalName::make("text_outline_color")),
+        "glyph: text_outline_color");
+  check(sattr->has_shader_input(InternalName::make("text_outline")),
+        "glyph: text_outline");
+  check(sattr->get_shader_input(InternalName::make("text_fg"))->get_vector() ==
+        LVecBase4(1.0f, 0.5f, 0.25f, 1.0f), "glyph: text_fg value");
+
+  const ShaderAttrib *texture_sattr;
+  check(!texture_glyph->get_state()->get_attrib(texture_sattr),
+        "glyph: no shader in RM_texture mode");
+}
+#endif  // COMPILE_IN_DEFAULT_FONT
+
+int
+main(int argc, char *argv[]) {
+  test_transform();
+
+#ifdef COMPILE_IN_DEFAULT_FONT
+  test_fields(make_font(TextFont::RM_distance_field));
+  test_glyph();
+#else
+  nout << "No compiled-in font; testing only the distance transform.\n";
+#endif  // COMPILE_IN_DEFAULT_FONT
+
+  return check.report();
+}
+
+#else  // HAVE_FREETYPE
+
+int
+main(int argc, char *argv[]) {
+  nout << "Not compiled with FreeType; nothing to test.\n";
+  return 0;
+}
+
+#endif  // HAVE_FREETYPE
@@ -0,0 +1,207 @@
+// Filename: test_textNode.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "pandabase.h"
+#include "textNode.h"
+#include "config_text.h"
+#include "geomNode.h"
+#include "geomTriangles.h"
+#include "geomVertexReader.h"
+#include "textureAttrib.h"
+#include "nodePath.h"
+#include "pvector.h"
+#include "pset.h"
+#include "indent.h"
+#include "testCheck.h"
+
+// This program changes the text of a TextNode that is rebuilt
+// incrementally (with a dynamic usage hint and FF_dynamic_merge) a
+// number of times, and checks each time that it produces the same
+// triangles as a TextNode that is built from scratch.  It also checks
+// that the incremental TextNode keeps its GeomTriangles from one
+// rebuild to the next.
+
+static TestCheck check;
+
+typedef pvector<string> Triangles;
+// We hold a reference to each primitive, so that a new one can't be
+// allocated at the address of one that was freed.
+typedef pset<CPT(GeomPrimitive)> Primitives;
+
+////////////////////////////////////////////////////////////////////
+//     Function: describe_vertex
+//  Description: Writes the position and texture coordinates of the
+//               vertex, rounded so that it can be compared between
+//               TextNodes that arrived at it by different transforms.
+////////////////////////////////////////////////////////////////////
+static void
+describe_vertex(ostream &out, const LPoint3 &point, const LTexCoord &uv) {
+  out << " (" << floor(point[0] * 1000.0f + 0.5f)
+      << " " << floor(point[1] * 1000.0f + 0.5f)
+      << " " << floor(point[2] * 1000.0f + 0.5f)
+      << " / " << floor(uv[0] * 1000.0f + 0.5f)
+      << " " << floor(uv[1] * 1000.0f + 0.5f) << ")";
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: collect_triangles
+//  Description: Adds a description of each triangle below the node,
+//               in the coordinate space of the root, to the list.
+//               Also records each GeomTriangles found.
+////////////////////////////////////////////////////////////////////
+static void
+collect_triangles(const NodePath &root, const NodePath &np,
+                  Triangles &triangles, Primitives &primitives) {
+  if (np.node()->is_geom_node()) {
+    GeomNode *gnode = DCAST(GeomNode, np.node());
+    LMatrix4 mat = np.get_transform(root)->get_mat();
+
+    for (int i = 0; i < gnode->get_num_geoms(); ++i) {
+      const Geom *geom = gnode->get_geom(i);
+      string texture;
+      const TextureAttrib *ta;
+      if (gnode->get_geom_state(i)->get_attrib(ta) &&
+          ta->get_texture() != (Texture *)NULL) {
+        texture = ta->get_texture()->get_name();
+      }
+
+      CPT(GeomVertexData) vdata = geom->get_vertex_data();
+      GeomVertexReader vertex(vdata, InternalName::get_vertex());
+      GeomVertexReader texcoord(vdata, InternalName::get_texcoord());
+
+      for (int p = 0; p < geom->get_num_primitives(); ++p) {
+        CPT(GeomPrimitive) orig_prim = geom->get_primitive(p);
+        if (!orig_prim->is_of_type(GeomTriangles::get_class_type())) {
+          continue;
+        }
+        primitives.insert(orig_prim);
+
+        CPT(GeomPrimitive) prim = orig_prim->decompose();
+        for (int t = 0; t < prim->get_num_primitives(); ++t) {
+          ostringstream strm;
+          strm << texture << ":";
+          for (int v = prim->get_primitive_start(t);
+               v < prim->get_primitive_end(t);
+               ++v) {
+            int vi = prim->get_vertex(v);
+            vertex.set_row(vi);
+            LPoint3 point = mat.xform_point(vertex.get_data3());
+            LTexCoord uv(0.0f, 0.0f);
+            if (texcoord.has_column()) {
+              texcoord.set_row(vi);
+              uv = texcoord.get_data2();
+            }
+            describe_vertex(strm, point, uv);
+          }
+          triangles.push_back(strm.str());
+        }
+      }
+    }
+  }
+
+  for (int i = 0; i < np.get_num_children(); ++i) {
+    collect_triangles(root, np.get_child(i), triangles, primitives);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: get_triangles
+//  Description: Returns the sorted list of triangles generated by the
+//               TextNode for its current text.
+////////////////////////////////////////////////////////////////////
+static Triangles
+get_triangles(TextNode *node, Primitives &primitives) {
+  NodePath root(node->get_internal_geom());
+  Triangles triangles;
+  collect_triangles(root, root, triangles, primitives);
+  sort(triangles.begin(), triangles.end());
+  return triangles;
+}
+
+int
+main(int argc, char *argv[]) {
+  init_libtext();
+
+  static const char *const texts[] = {
+    "Score: 100\nTime: 0:59",
+    "Score: 105\nTime: 0:59",
+    "Score: 105\nTime: 0:58\nBonus!",
+    "Score: 105\nTime: 0:58\nBonus!",
+    "Time: 0:58\nScore: 105",
+    "A much longer line that will be wrapped onto several rows",
+    "Hi",
+    "",
+    "Score: 110\nTime: 0:57",
+  };
+  static const int num_texts = sizeof(texts) / sizeof(texts[0]);
+
+  PT(TextNode) incremental = new TextNode("incremental");
+  incremental->set_usage_hint(Geom::UH_dynamic);
+  incremental->set_flatten_flags(TextNode::FF_dynamic_merge);
+  incremental->set_wordwrap(12.0f);
+
+  PT(TextNode) reference = new TextNode("reference");
+  reference->set_flatten_flags(TextNode::FF_strong);
+  reference->set_wordwrap(12.0f);
+
+  Primitives prev_primitives;
+  for (int i = 0; i < num_texts; ++i) {
+    incremental->set_text(texts[i]);
+    reference->set_text(texts[i]);
+
+    Primitives primitives, reference_primitives;
+    Triangles triangles = get_triangles(incremental, primitives);
+    Triangles expected = get_triangles(reference, reference_primitives);
+
+    ostringstream strm;
+    strm << "text " << i << " '" << texts[i] << "'";
+    check(triangles == expected, strm.str() + ": same triangles");
+    check(incremental->get_num_rows() == reference->get_num_rows(),
+          strm.str() + ": same number of rows");
+    check(incremental->get_width() == reference->get_width(),
+          strm.str() + ": same width");
+    if (texts[i][0] != '\0') {
+      check(!triangles.empty(), strm.str() + ": has triangles");
+    }
+
+    // Each GeomTriangles made for the previous text is used again,
+    // rather than replaced, as long as the text still needs one of
+    // its kind.
+    if (!prev_primitives.empty() && !primitives.empty()) {
+      Primitives::const_iterator pi;
+      for (pi = primitives.begin(); pi != primitives.end(); ++pi) {
+        check(prev_primitives.count(*pi) != 0,
+              strm.str() + ": GeomTriangles reused");
+      }
+    }
+    if (!primitives.empty()) {
+      prev_primitives = primitives;
+    }
+  }
+
+  // Turning off incremental assembly goes back to building from
+  // scratch.
+  incremental->set_usage_hint(Geom::UH_static);
+  incremental->set_flatten_flags(TextNode::FF_strong);
+  incremental->set_text(texts[0]);
+  reference->set_text(texts[0]);
+  {
+    Primitives primitives, reference_primitives;
+    check(get_triangles(incremental, primitives) ==
+          get_triangles(reference, reference_primitives),
+          "static text: same triangles");
+  }
+
+  return check.report();
+}
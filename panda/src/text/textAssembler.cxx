@@ -33,6 +33,10 @@
 #include "geom.h"
 #include "modelNode.h"
 
+#ifdef HAVE_FREETYPE
+#include "dynamicTextRasterizer.h"
+#endif
+
 #include <ctype.h>
 #include <stdio.h>  // for sprintf
   
@@ -90,7 +94,9 @@ TextAssembler(TextEncoder *encoder) :
   _usage_hint(Geom::UH_static),
   _max_rows(0),
   _dynamic_merge(text_dynamic_merge),
-  _multiline_mode(true)
+  _multiline_mode(true),
+  _wtext_valid(false),
+  _all_set(true)
 {
   _initial_cprops = new ComputedProperties(TextProperties());
   clear();
@@ -113,8 +119,12 @@ TextAssembler(const TextAssembler &copy) :
   _usage_hint(copy._usage_hint),
   _max_rows(copy._max_rows),
   _dynamic_merge(copy._dynamic_merge),
-  _multiline_mode(copy._multiline_mode)
+  _multiline_mode(copy._multiline_mode),
+  _wtext_valid(false),
+  _all_set(copy._all_set)
 {
+  // The cache of incremental assembly is not copied; the Geoms in it
+  // may only be rewritten by the TextAssembler that made them.
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -135,6 +145,9 @@ operator = (const TextAssembler &copy) {
   _max_rows = copy._max_rows;
   _dynamic_merge = copy._dynamic_merge;
   _multiline_mode = copy._multiline_mode;
+  _wtext_valid = false;
+  _all_set = copy._all_set;
+  clear_cache();
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -144,6 +157,7 @@ operator = (const TextAssembler &copy) {
 ////////////////////////////////////////////////////////////////////
 TextAssembler::
 ~TextAssembler() {
+  clear_cache();
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -159,6 +173,7 @@ clear() {
 
   _text_string.clear();
   _text_block.clear();
+  _wtext_valid = false;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -175,6 +190,12 @@ clear() {
 ////////////////////////////////////////////////////////////////////
 bool TextAssembler::
 set_wtext(const wstring &wtext) {
+  if (_wtext_valid && is_incremental() && wtext == _wtext) {
+    // Nothing has changed since the last call, so the layout we
+    // already have is still good.
+    return _all_set;
+  }
+
   clear();
 
   // First, expand all of the embedded TextProperties references
@@ -193,7 +214,13 @@ set_wtext(const wstring &wtext) {
   }
 
   // Then apply any wordwrap requirements.
-  return wordwrap_text();
+  _all_set = wordwrap_text();
+
+  if (is_incremental()) {
+    _wtext = wtext;
+    _wtext_valid = true;
+  }
+  return _all_set;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -231,8 +258,10 @@ set_wsubstr(const wstring &wtext, int start, int count) {
 
   _text_string.erase(_text_string.begin() + start, _text_string.begin() + start + count);
   _text_string.insert(_text_string.begin() + start, substr.begin(), substr.end());
+  _wtext_valid = false;
 
-  return wordwrap_text();
+  _all_set = wordwrap_text();
+  return _all_set;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -577,8 +606,24 @@ assemble_text() {
 
   bool any_shadow = false;
 
-  GeomCollectorMap geom_collector_map;
-  GeomCollectorMap geom_shadow_collector_map;
+  // When assembling incrementally, we write into the same Geoms we
+  // made last time, rather than allocating new ones.
+  GeomCollectorMap local_collector_map;
+  GeomCollectorMap local_shadow_collector_map;
+  GeomCollectorMap &geom_collector_map =
+    is_incremental() ? _text_collectors : local_collector_map;
+  GeomCollectorMap &geom_shadow_collector_map =
+    is_incremental() ? _shadow_collectors : local_shadow_collector_map;
+
+  GeomCollectorMap::iterator gc;
+  for (gc = geom_collector_map.begin(); gc != geom_collector_map.end(); ++gc) {
+    (*gc).second.reset();
+  }
+  for (gc = geom_shadow_collector_map.begin(); 
+       gc != geom_shadow_collector_map.end();
+       ++gc) {
+    (*gc).second.reset();
+  }
 
   PlacedGlyphs::const_iterator pgi;
   for (pgi = placed_glyphs.begin(); pgi != placed_glyphs.end(); ++pgi) {
@@ -622,7 +667,8 @@ assemble_text() {
     // vertices.
     if (properties->has_shadow()) {
       if (_dynamic_merge) {
-        placement->assign_append_to(geom_shadow_collector_map, shadow_state, shadow_xform);
+        placement->assign_append_to(geom_shadow_collector_map, shadow_state,
+                                    shadow_xform, _usage_hint);
       } else {
         placement->assign_copy_to(shadow_geom_node, shadow_state, shadow_xform);
       }
@@ -635,7 +681,8 @@ assemble_text() {
     }
 
     if (_dynamic_merge) {
-      placement->assign_append_to(geom_collector_map, text_state, LMatrix4::ident_mat());
+      placement->assign_append_to(geom_collector_map, text_state,
+                                  LMatrix4::ident_mat(), _usage_hint);
     } else {
       placement->assign_to(text_geom_node, text_state);
     }
@@ -650,16 +697,25 @@ assemble_text() {
     parent_node->add_child(shadow_node);
   }
 
-  GeomCollectorMap::iterator gc;
-  for (gc = geom_collector_map.begin(); gc != geom_collector_map.end(); ++gc) {
-    (*gc).second.append_geom(text_geom_node, (*gc).first._state);
+  // Any collector that received nothing this time is no longer
+  // needed.
+  gc = geom_collector_map.begin();
+  while (gc != geom_collector_map.end()) {
+    if ((*gc).second.is_empty()) {
+      geom_collector_map.erase(gc++);
+    } else {
+      (*gc).second.append_geom(text_geom_node, (*gc).first._state);
+      ++gc;
+    }
   }
 
-  if (any_shadow) {
-    for (gc = geom_shadow_collector_map.begin(); 
-         gc != geom_shadow_collector_map.end();
-         ++gc) {
+  gc = geom_shadow_collector_map.begin();
+  while (gc != geom_shadow_collector_map.end()) {
+    if ((*gc).second.is_empty()) {
+      geom_shadow_collector_map.erase(gc++);
+    } else {
       (*gc).second.append_geom(shadow_geom_node, (*gc).first._state);
+      ++gc;
     }
   }
   
@@ -1226,6 +1282,10 @@ assemble_paragraph(TextAssembler::PlacedGlyphs &placed_glyphs) {
   _lr.set(0.0f, 0.0f);
   int num_rows = 0;
 
+  bool incremental = is_incremental();
+  RowCache new_cache;
+  size_t next_cached_row = 0;
+
   PN_stdfloat ypos = 0.0f;
   _next_row_ypos = 0.0f;
   TextBlock::iterator bi;
@@ -1236,8 +1296,13 @@ assemble_paragraph(TextAssembler::PlacedGlyphs &placed_glyphs) {
     PlacedGlyphs row_placed_glyphs;
     PN_stdfloat row_width, line_height, wordwrap;
     TextProperties::Alignment align;
-    assemble_row(row, row_placed_glyphs,
-                 row_width, line_height, align, wordwrap);
+    if (incremental) {
+      assemble_cached_row(row, new_cache, next_cached_row, row_placed_glyphs,
+                          row_width, line_height, align, wordwrap);
+    } else {
+      assemble_row(row, row_placed_glyphs,
+                   row_width, line_height, align, wordwrap);
+    }
     // Now move the row to its appropriate position.  This might
     // involve a horizontal as well as a vertical translation.
     LMatrix4 mat = LMatrix4::ident_mat();
@@ -1308,6 +1373,15 @@ assemble_paragraph(TextAssembler::PlacedGlyphs &placed_glyphs) {
     _next_row_ypos = ypos - line_height;
   }
 
+  if (incremental) {
+    // Any rows we didn't use again are gone from the text.
+    RowCache::iterator ri;
+    for (ri = _row_cache.begin(); ri != _row_cache.end(); ++ri) {
+      delete (*ri);
+    }
+    _row_cache.swap(new_cache);
+  }
+
   // num_rows may be smaller than _text_block.size(), if there are
   // trailing newlines on the string.
 }
@@ -1571,6 +1645,99 @@ assemble_row(TextAssembler::TextRow &row,
   }
 }
   
+////////////////////////////////////////////////////////////////////
+//     Function: TextAssembler::assemble_cached_row
+//       Access: Private
+//  Description: Does the same thing as assemble_row(), but first
+//               looks for the same row among the rows that were
+//               assembled by the previous call, and if it is there,
+//               copies its glyphs instead of assembling it again.
+//               Either way, the row is added to new_cache.
+//
+//               next_cached_row is where the search begins; it is
+//               updated to follow the row that was found, since
+//               unchanged rows tend to keep their order even as rows
+//               are added or removed around them.
+////////////////////////////////////////////////////////////////////
+void TextAssembler::
+assemble_cached_row(TextAssembler::TextRow &row,
+                    TextAssembler::RowCache &new_cache,
+                    size_t &next_cached_row,
+                    TextAssembler::PlacedGlyphs &row_placed_glyphs,
+                    PN_stdfloat &row_width, PN_stdfloat &line_height,
+                    TextProperties::Alignment &align, PN_stdfloat &wordwrap) {
+  CachedRow *cached = (CachedRow *)NULL;
+  size_t num_cached = _row_cache.size();
+  for (size_t i = 0; i < num_cached && cached == (CachedRow *)NULL; ++i) {
+    size_t ci = (next_cached_row + i) % num_cached;
+    if (_row_cache[ci] != (CachedRow *)NULL && _row_cache[ci]->matches(row)) {
+      cached = _row_cache[ci];
+      _row_cache[ci] = (CachedRow *)NULL;
+      next_cached_row = ci + 1;
+    }
+  }
+
+  if (cached == (CachedRow *)NULL) {
+    cached = new CachedRow;
+    cached->_string = row._string;
+    cached->_eol_cprops = row._eol_cprops;
+
+#ifdef HAVE_FREETYPE
+    // If a font returns a placeholder for a glyph that is still being
+    // rendered, the row will have to be assembled again later, so
+    // there's no point in keeping it.
+    DynamicTextRasterizer *rasterizer = DynamicTextRasterizer::get_global_ptr();
+    int num_placeholders = rasterizer->get_num_placeholders();
+#endif
+    assemble_row(row, cached->_placed_glyphs, cached->_row_width,
+                 cached->_line_height, cached->_align, cached->_wordwrap);
+#ifdef HAVE_FREETYPE
+    if (rasterizer->get_num_placeholders() != num_placeholders) {
+      row_placed_glyphs.swap(cached->_placed_glyphs);
+      row_width = cached->_row_width;
+      line_height = cached->_line_height;
+      align = cached->_align;
+      wordwrap = cached->_wordwrap;
+      delete cached;
+      return;
+    }
+#endif
+  }
+
+  // The caller will move the glyphs into place, so it gets its own
+  // copies.
+  PlacedGlyphs::const_iterator pi;
+  for (pi = cached->_placed_glyphs.begin();
+       pi != cached->_placed_glyphs.end();
+       ++pi) {
+    row_placed_glyphs.push_back(new GlyphPlacement(*(*pi)));
+  }
+  row_width = cached->_row_width;
+  line_height = cached->_line_height;
+  align = cached->_align;
+  wordwrap = cached->_wordwrap;
+
+  new_cache.push_back(cached);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextAssembler::clear_cache
+//       Access: Private
+//  Description: Discards the rows and Geoms kept for incremental
+//               assembly.  See set_usage_hint().
+////////////////////////////////////////////////////////////////////
+void TextAssembler::
+clear_cache() {
+  RowCache::iterator ri;
+  for (ri = _row_cache.begin(); ri != _row_cache.end(); ++ri) {
+    delete (*ri);
+  }
+  _row_cache.clear();
+  _text_collectors.clear();
+  _shadow_collectors.clear();
+  _wtext_valid = false;
+}
+  
 ////////////////////////////////////////////////////////////////////
 //     Function: TextAssembler::draw_underscore
 //       Access: Private, Static
@@ -2155,6 +2322,68 @@ append_delta(wstring &wtext, TextAssembler::ComputedProperties *other) {
   }
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: TextAssembler::CachedRow::Destructor
+//       Access: Public
+//  Description: 
+////////////////////////////////////////////////////////////////////
+TextAssembler::CachedRow::
+~CachedRow() {
+  PlacedGlyphs::iterator pi;
+  for (pi = _placed_glyphs.begin(); pi != _placed_glyphs.end(); ++pi) {
+    delete (*pi);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextAssembler::CachedRow::matches
+//       Access: Public
+//  Description: Returns true if the indicated row has the same
+//               characters, with the same properties, as the row
+//               that was cached, so that it would be assembled the
+//               same way.
+////////////////////////////////////////////////////////////////////
+bool TextAssembler::CachedRow::
+matches(const TextAssembler::TextRow &row) const {
+  if (row._string.size() != _string.size()) {
+    return false;
+  }
+  if ((row._eol_cprops == (ComputedProperties *)NULL) != 
+      (_eol_cprops == (ComputedProperties *)NULL)) {
+    return false;
+  }
+  if (_eol_cprops != (ComputedProperties *)NULL &&
+      _eol_cprops != row._eol_cprops &&
+      _eol_cprops->_properties != row._eol_cprops->_properties) {
+    return false;
+  }
+
+  // The properties usually change seldom within a row, so we only
+  // need to compare them when they do.
+  const ComputedProperties *last_a = NULL;
+  const ComputedProperties *last_b = NULL;
+
+  TextString::const_iterator ai = _string.begin();
+  TextString::const_iterator bi = row._string.begin();
+  for (; ai != _string.end(); ++ai, ++bi) {
+    const TextCharacter &a = (*ai);
+    const TextCharacter &b = (*bi);
+    if (a._character != b._character || a._graphic != b._graphic) {
+      return false;
+    }
+    if (a._cprops != b._cprops &&
+        (a._cprops != last_a || b._cprops != last_b)) {
+      if (a._cprops->_properties != b._cprops->_properties) {
+        return false;
+      }
+      last_a = a._cprops;
+      last_b = b._cprops;
+    }
+  }
+
+  return true;
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: TextAssembler::GlyphPlacement::calc_tight_bounds
 //       Access: Private
@@ -2217,12 +2446,14 @@ assign_copy_to(GeomNode *geom_node, const RenderState *state,
 //  Description: Puts the pieces of the GlyphPlacement in the
 //               indicated GeomNode.  This flavor will append the
 //               Geoms with the additional transform applied to the
-//               vertices.
+//               vertices.  The usage_hint is applied to any new
+//               GeomCollector that must be created.
 ////////////////////////////////////////////////////////////////////
 void TextAssembler::GlyphPlacement::
 assign_append_to(GeomCollectorMap &geom_collector_map, 
                  const RenderState *state,
-                 const LMatrix4 &extra_xform) const {
+                 const LMatrix4 &extra_xform,
+                 Geom::UsageHint usage_hint) const {
   LMatrix4 new_xform = _xform * extra_xform;
   Pieces::const_iterator pi;
 
@@ -2235,7 +2466,7 @@ assign_append_to(GeomCollectorMap &geom_collector_map,
 
     GeomCollectorMap::iterator mi = geom_collector_map.find(key);
     if (mi == geom_collector_map.end()) {
-      mi = geom_collector_map.insert(GeomCollectorMap::value_type(key, GeomCollector(vdata->get_format()))).first;
+      mi = geom_collector_map.insert(GeomCollectorMap::value_type(key, GeomCollector(vdata->get_format(), usage_hint))).first;
     }
     GeomCollector &geom_collector = (*mi).second;
     geom_collector.count_geom(geom);
@@ -2315,9 +2546,14 @@ copy_graphic_to(PandaNode *node, const RenderState *state,
 //               (Geom, GeomTriangles, vertexWriter, texcoordWriter..)
 ////////////////////////////////////////////////////////////////////
 TextAssembler::GeomCollector::
-GeomCollector(const GeomVertexFormat *format) :
-  _vdata(new GeomVertexData("merged_geom", format, Geom::UH_static)),
-  _geom(new GeomTextGlyph(_vdata))
+GeomCollector(const GeomVertexFormat *format, Geom::UsageHint usage_hint) :
+  _vdata(new GeomVertexData("merged_geom", format, usage_hint)),
+  _geom(new GeomTextGlyph(_vdata)),
+  _added_triangles(false),
+  _added_lines(false),
+  _added_points(false),
+  _usage_hint(usage_hint),
+  _num_rows(0)
 {
 }
 
@@ -2329,7 +2565,15 @@ GeomCollector(const GeomVertexFormat *format) :
 TextAssembler::GeomCollector::
 GeomCollector(const TextAssembler::GeomCollector &copy) :
   _vdata(copy._vdata),
-  _geom(copy._geom)
+  _geom(copy._geom),
+  _triangles(copy._triangles),
+  _lines(copy._lines),
+  _points(copy._points),
+  _added_triangles(copy._added_triangles),
+  _added_lines(copy._added_lines),
+  _added_points(copy._added_points),
+  _usage_hint(copy._usage_hint),
+  _num_rows(copy._num_rows)
 {
 }
 
@@ -2339,28 +2583,38 @@ GeomCollector(const TextAssembler::GeomCollector &copy) :
 //  Description: Returns a GeomPrimitive of the appropriate type.  If
 //               one has not yet been created, returns a newly-created
 //               one; if one has previously been created of this type,
-//               returns the previously-created one.
+//               returns the previously-created one, which has been
+//               emptied by reset() if it was used before.
 ////////////////////////////////////////////////////////////////////
 GeomPrimitive *TextAssembler::GeomCollector::
 get_primitive(TypeHandle prim_type) {
   if (prim_type == GeomTriangles::get_class_type()) {
     if (_triangles == (GeomPrimitive *)NULL) {
-      _triangles = new GeomTriangles(Geom::UH_static);
+      _triangles = new GeomTriangles(_usage_hint);
+    }
+    if (!_added_triangles) {
       _geom->add_primitive(_triangles);
+      _added_triangles = true;
     }
     return _triangles;
 
   } else if (prim_type == GeomLines::get_class_type()) {
     if (_lines == (GeomPrimitive *)NULL) {
-      _lines = new GeomLines(Geom::UH_static);
+      _lines = new GeomLines(_usage_hint);
+    }
+    if (!_added_lines) {
       _geom->add_primitive(_lines);
+      _added_lines = true;
     }
     return _lines;
 
   } else if (prim_type == GeomPoints::get_class_type()) {
     if (_points == (GeomPrimitive *)NULL) {
-      _points = new GeomPoints(Geom::UH_static);
+      _points = new GeomPoints(_usage_hint);
+    }
+    if (!_added_points) {
       _geom->add_primitive(_points);
+      _added_points = true;
     }
     return _points;
   }
@@ -2378,7 +2632,7 @@ get_primitive(TypeHandle prim_type) {
 int TextAssembler::GeomCollector::
 append_vertex(const GeomVertexData *orig_vdata, int orig_row,
               const LMatrix4 &xform) {
-  int new_row = _vdata->get_num_rows();
+  int new_row = _num_rows++;
   _vdata->copy_row_from(new_row, orig_vdata, orig_row, Thread::get_current_thread());
 
   GeomVertexRewriter vertex_rewriter(_vdata, InternalName::get_vertex());
@@ -2398,8 +2652,55 @@ append_vertex(const GeomVertexData *orig_vdata, int orig_row,
 ////////////////////////////////////////////////////////////////////
 void TextAssembler::GeomCollector::
 append_geom(GeomNode *geom_node, const RenderState *state) {
+  if (_vdata->get_num_rows() != _num_rows) {
+    // Drop any rows left over from a longer text assembled earlier.
+    _vdata->set_num_rows(_num_rows);
+  }
   if (_geom->get_num_primitives() > 0) {
     geom_node->add_geom(_geom, state);
   }
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: TextAssembler::GeomCollector::reset
+//       Access: Public
+//  Description: Empties the collector so that it may be filled
+//               again, keeping the same Geom, GeomVertexData and
+//               GeomPrimitives.  The vertices already in the
+//               GeomVertexData are overwritten in place, rather than
+//               reallocated, and each primitive's index table is
+//               reserved at its previous size, so that it is
+//               allocated only once as it fills up again.
+////////////////////////////////////////////////////////////////////
+void TextAssembler::GeomCollector::
+reset() {
+  _num_rows = 0;
+  _geom->clear_primitives();
+  reset_primitive(_triangles);
+  reset_primitive(_lines);
+  reset_primitive(_points);
+  _added_triangles = false;
+  _added_lines = false;
+  _added_points = false;
+#ifdef HAVE_FREETYPE
+  _geom->clear_glyphs();
+#endif
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextAssembler::GeomCollector::reset_primitive
+//       Access: Private, Static
+//  Description: Removes the vertices from the indicated primitive, if
+//               it is not NULL, and reserves room for as many
+//               vertices as it had before.
+////////////////////////////////////////////////////////////////////
+void TextAssembler::GeomCollector::
+reset_primitive(GeomPrimitive *prim) {
+  if (prim != (GeomPrimitive *)NULL) {
+    int num_vertices = prim->get_num_vertices();
+    prim->clear_vertices();
+    if (num_vertices != 0) {
+      prim->reserve_num_vertices(num_vertices);
+    }
+  }
+}
@@ -108,6 +108,9 @@ PUBLISHED:
   static bool is_whitespace(wchar_t character, const TextProperties &properties);
 
 private:
+  INLINE bool is_incremental() const;
+  void clear_cache();
+
   class ComputedProperties : public ReferenceCount {
   public:
     INLINE ComputedProperties(const TextProperties &orig_properties);
@@ -200,7 +203,7 @@ private:
 
   class GeomCollector {
   public:
-    GeomCollector(const GeomVertexFormat *format);
+    GeomCollector(const GeomVertexFormat *format, Geom::UsageHint usage_hint);
     GeomCollector(const GeomCollector &copy);
 
     INLINE void count_geom(const Geom *geom);
@@ -208,13 +211,22 @@ private:
     int append_vertex(const GeomVertexData *orig_vdata, int orig_row,
                       const LMatrix4 &xform);
     void append_geom(GeomNode *geom_node, const RenderState *state);
+    void reset();
+    INLINE bool is_empty() const;
 
   private:
+    static void reset_primitive(GeomPrimitive *prim);
+
     PT(GeomVertexData) _vdata;
     PT(GeomTextGlyph) _geom;
     PT(GeomTriangles) _triangles;
     PT(GeomLines) _lines;
     PT(GeomPoints) _points;
+    bool _added_triangles;
+    bool _added_lines;
+    bool _added_points;
+    Geom::UsageHint _usage_hint;
+    int _num_rows;
   };
   typedef pmap<GeomCollectorKey, GeomCollector> GeomCollectorMap;
 
@@ -228,7 +240,8 @@ private:
                         const LMatrix4 &extra_xform) const;
 
     void assign_append_to(GeomCollectorMap &geom_collector_map, const RenderState *state,
-                          const LMatrix4 &extra_xform) const;
+                          const LMatrix4 &extra_xform,
+                          Geom::UsageHint usage_hint) const;
     void copy_graphic_to(PandaNode *node, const RenderState *state,
                          const LMatrix4 &extra_xform) const;
 
@@ -239,7 +252,32 @@ private:
   };
   typedef pvector<GlyphPlacement *> PlacedGlyphs;
 
+  // When the text is assembled incrementally (see is_incremental()),
+  // the glyphs placed for each row are kept from one call to
+  // assemble_text() to the next, so that a row that has not changed
+  // need not be assembled again.  The glyphs are kept relative to
+  // the start of the row.
+  class CachedRow {
+  public:
+    ~CachedRow();
+    bool matches(const TextRow &row) const;
+
+    TextString _string;
+    PT(ComputedProperties) _eol_cprops;
+    PlacedGlyphs _placed_glyphs;
+    PN_stdfloat _row_width;
+    PN_stdfloat _line_height;
+    TextProperties::Alignment _align;
+    PN_stdfloat _wordwrap;
+  };
+  typedef pvector<CachedRow *> RowCache;
+
   void assemble_paragraph(PlacedGlyphs &placed_glyphs);
+  void assemble_cached_row(TextRow &row, RowCache &new_cache,
+                           size_t &next_cached_row,
+                           PlacedGlyphs &row_placed_glyphs,
+                           PN_stdfloat &row_width, PN_stdfloat &line_height,
+                           TextProperties::Alignment &align, PN_stdfloat &wordwrap);
   void assemble_row(TextRow &row,
                     PlacedGlyphs &row_placed_glyphs,
                     PN_stdfloat &row_width, PN_stdfloat &line_height, 
@@ -310,6 +348,18 @@ private:
   bool _dynamic_merge;
   bool _multiline_mode;
 
+  // These are kept between calls when the text is assembled
+  // incrementally: the string most recently passed to set_wtext()
+  // (if _wtext_valid is true, the current layout still reflects it),
+  // the rows most recently assembled, and the merged Geoms, whose
+  // vertex buffers are rewritten in place by each assemble_text().
+  wstring _wtext;
+  bool _wtext_valid;
+  bool _all_set;
+  RowCache _row_cache;
+  GeomCollectorMap _text_collectors;
+  GeomCollectorMap _shadow_collectors;
+
 };
 
 #include "textAssembler.I"
@@ -112,6 +112,9 @@ string_render_mode(const string &string) {
     return RM_extruded;
   } else if (cmp_nocase_uh(string, "solid") == 0) {
     return RM_solid;
+  } else if (cmp_nocase_uh(string, "distance-field") == 0 ||
+             cmp_nocase_uh(string, "distance_field") == 0) {
+    return RM_distance_field;
   } else {
     return RM_invalid;
   }
@@ -184,6 +187,8 @@ operator << (ostream &out, TextFont::RenderMode rm) {
     return out << "extruded";
   case TextFont::RM_solid:
     return out << "solid";
+  case TextFont::RM_distance_field:
+    return out << "distance-field";
 
   case TextFont::RM_invalid:
     return out << "invalid";
@@ -57,6 +57,10 @@ PUBLISHED:
     // combination of RM_extruded and RM_polygon
     RM_solid,
 
+    // Each glyph is a textured rectangle, but the texture stores the
+    // distance to the edge of the glyph, and a shader draws the edge
+    RM_distance_field,
+
     // Returned by string_render_mode() for an invalid match.
     RM_invalid,
   };
@@ -47,6 +47,7 @@
 #include "pStatCollector.h"
 #include "pStatTimer.h"
 #include "boundingSphere.h"
+#include "dynamicTextRasterizer.h"
 
 #include <stdio.h>
 
@@ -60,7 +61,7 @@ PStatCollector TextNode::_text_generate_pcollector("*:Generate Text");
 //  Description:
 ////////////////////////////////////////////////////////////////////
 TextNode::
-TextNode(const string &name) : PandaNode(name) {
+TextNode(const string &name) : PandaNode(name), _assembler(NULL) {
   set_cull_callback();
 
   _flags = 0;
@@ -104,7 +105,7 @@ TextNode(const string &name) : PandaNode(name) {
 ////////////////////////////////////////////////////////////////////
 TextNode::
 TextNode(const string &name, const TextProperties &copy) : 
-  PandaNode(name), TextProperties(copy) 
+  PandaNode(name), TextProperties(copy), _assembler(NULL)
 {
   _flags = 0;
   _max_rows = 0;
@@ -153,7 +154,8 @@ TextNode(const TextNode &copy) :
   _transform(copy._transform),
   _coordinate_system(copy._coordinate_system),
   _ul3d(copy._ul3d),
-  _lr3d(copy._lr3d)
+  _lr3d(copy._lr3d),
+  _assembler(NULL)
 {
   invalidate_with_measure();
 }
@@ -178,6 +180,7 @@ make_copy() const {
 ////////////////////////////////////////////////////////////////////
 TextNode::
 ~TextNode() {
+  delete _assembler;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -343,6 +346,23 @@ write(ostream &out, int indent_level) const {
 ////////////////////////////////////////////////////////////////////
 PT(PandaNode) TextNode::
 generate() {
+  TextAssembler assembler(this);
+  return do_generate(assembler, false);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextNode::do_generate
+//       Access: Private
+//  Description: The implementation of generate(), using the
+//               indicated TextAssembler.  If incremental is true,
+//               the assembler is the TextNode's own, which keeps the
+//               rows and Geoms of the previous text so that it can
+//               reuse them; in this case the result is not
+//               flattened, since that would copy the Geoms away from
+//               the assembler.
+////////////////////////////////////////////////////////////////////
+PT(PandaNode) TextNode::
+do_generate(TextAssembler &assembler, bool incremental) {
   PStatTimer timer(_text_generate_pcollector);
   if (text_cat.is_debug()) {
     text_cat.debug()
@@ -393,7 +413,6 @@ generate() {
   wstring wtext = get_wtext();
 
   // Assemble the text.
-  TextAssembler assembler(this);
   assembler.set_properties(*this);
   assembler.set_max_rows(_max_rows);
   assembler.set_usage_hint(_usage_hint);
@@ -435,7 +454,10 @@ generate() {
   // applying them to the vertices.
 
   NodePath root_np(root);
-  if (_flatten_flags & FF_strong) {
+  if (incremental) {
+    // The assembler has already merged the glyphs into as few Geoms
+    // as it can.
+  } else if (_flatten_flags & FF_strong) {
     root_np.flatten_strong();
   } else if (_flatten_flags & FF_medium) {
     root_np.flatten_medium();
@@ -683,6 +705,9 @@ calc_tight_bounds(LPoint3 &min_point, LPoint3 &max_point, bool &found_any,
 ////////////////////////////////////////////////////////////////////
 bool TextNode::
 cull_callback(CullTraverser *trav, CullTraverserData &data) {
+  if ((_flags & F_pending_glyphs) != 0) {
+    check_pending_glyphs();
+  }
   check_rebuild();
   if (_internal_geom != (PandaNode *)NULL) {
     // Render the text with this node.
@@ -778,8 +803,63 @@ r_prepare_scene(GraphicsStateGuardianBase *gsg, const RenderState *node_state,
 ////////////////////////////////////////////////////////////////////
 void TextNode::
 do_rebuild() {
-  _flags &= ~(F_needs_rebuild | F_needs_measure);
-  _internal_geom = generate();
+  _flags &= ~(F_needs_rebuild | F_needs_measure | F_pending_glyphs);
+
+#ifdef HAVE_FREETYPE
+  // Take in any glyphs that have been rendered in the background
+  // since the last time, and note whether any of the glyphs we need
+  // are still missing.
+  DynamicTextRasterizer *rasterizer = DynamicTextRasterizer::get_global_ptr();
+  rasterizer->flush();
+  int num_placeholders = rasterizer->get_num_placeholders();
+#endif  // HAVE_FREETYPE
+
+  if (is_incremental()) {
+    // We keep our own TextAssembler, with the rows and Geoms of the
+    // previous text, only as long as we are rebuilt incrementally.
+    if (_assembler == (TextAssembler *)NULL) {
+      _assembler = new TextAssembler(this);
+    }
+    _internal_geom = do_generate(*_assembler, true);
+
+  } else {
+    if (_assembler != (TextAssembler *)NULL) {
+      delete _assembler;
+      _assembler = NULL;
+    }
+    TextAssembler assembler(this);
+    _internal_geom = do_generate(assembler, false);
+  }
+
+#ifdef HAVE_FREETYPE
+  if (rasterizer->get_num_placeholders() != num_placeholders) {
+    _flags |= F_pending_glyphs;
+    _glyph_seq = rasterizer->get_flush_seq();
+  }
+#endif  // HAVE_FREETYPE
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextNode::check_pending_glyphs
+//       Access: Private
+//  Description: Called each frame while the text is showing
+//               placeholders for glyphs that are being rendered in
+//               the background (see
+//               DynamicTextFont::set_async_rasterize()).  Takes in
+//               the glyphs that are ready, and marks the text to be
+//               regenerated if there are any new ones.
+////////////////////////////////////////////////////////////////////
+void TextNode::
+check_pending_glyphs() {
+#ifdef HAVE_FREETYPE
+  DynamicTextRasterizer *rasterizer = DynamicTextRasterizer::get_global_ptr();
+  rasterizer->flush();
+  if (rasterizer->get_flush_seq() != _glyph_seq) {
+    // The placeholders have the same size as the glyphs they stand
+    // for, so there's no need to measure the text again.
+    invalidate_no_measure();
+  }
+#endif  // HAVE_FREETYPE
 }
 
 
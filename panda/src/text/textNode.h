@@ -25,6 +25,7 @@
 #include "pandaNode.h"
 #include "luse.h"
 #include "geom.h"
+#include "updateSeq.h"
 
 ////////////////////////////////////////////////////////////////////
 //       Class : TextNode
@@ -270,8 +271,11 @@ private:
   INLINE void check_rebuild() const;
   INLINE void check_measure() const;
 
+  INLINE bool is_incremental() const;
+  PT(PandaNode) do_generate(TextAssembler &assembler, bool incremental);
   void do_rebuild();
   void do_measure();
+  void check_pending_glyphs();
 
   PT(PandaNode) make_frame();
   PT(PandaNode) make_card();
@@ -298,9 +302,11 @@ private:
     F_needs_measure    =  0x0200,
     F_has_overflow     =  0x0400,
     F_card_decal       =  0x0800,
+    F_pending_glyphs   =  0x1000,
   };
 
   int _flags;
+  UpdateSeq _glyph_seq;
   int _max_rows;
   GeomEnums::UsageHint _usage_hint;
   int _flatten_flags;
@@ -322,6 +328,10 @@ private:
   int _num_rows;
   wstring _wordwrapped_wtext;
 
+  // Kept from one rebuild to the next while the text is rebuilt
+  // incrementally; see set_usage_hint().  NULL otherwise.
+  TextAssembler *_assembler;
+
   static PStatCollector _text_generate_pcollector;
 
 public:
@@ -392,6 +392,17 @@ do_update_frame(Texture::CData *cdata, int frame, int z) {
   }
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: OpenCVTexture::do_can_decode_pages
+//       Access: Protected, Virtual
+//  Description: Returns false, since the pages of this texture must
+//               each be read by do_read_one().
+////////////////////////////////////////////////////////////////////
+bool OpenCVTexture::
+do_can_decode_pages(const Texture::CData *cdata) const {
+  return false;
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: OpenCVTexture::do_read_one
 //       Access: Protected, Virtual
@@ -72,6 +72,7 @@ protected:
                            int z, int n, int primary_file_num_channels, int alpha_file_channel,
                            const LoaderOptions &options,
                            bool header_only, BamCacheRecord *record);
+  virtual bool do_can_decode_pages(const Texture::CData *cdata) const;
   virtual bool do_load_one(Texture::CData *cdata,
                            const PNMImage &pnmimage, const string &name,
                            int z, int n, const LoaderOptions &options);
@@ -2,7 +2,7 @@
   p3imagebase p3progbase
 
 #define OTHER_LIBS \
-    p3pipeline:c p3event:c p3pstatclient:c p3grutil:c \
+    p3pipeline:c p3event:c p3pstatclient:c p3grutil:c p3gobj:c \
     panda:m \
     p3pandabase:c p3pnmimage:c p3pnmimagetypes:c \
     p3mathutil:c p3linmath:c p3putil:c p3express:c \
@@ -43,3 +43,9 @@
     imageInfo.cxx imageInfo.h
 #end bin_target
 
+#begin bin_target
+  #define TARGET tex2ktx
+  #define SOURCES \
+    texToKtx.cxx texToKtx.h
+#end bin_target
+
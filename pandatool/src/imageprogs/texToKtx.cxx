@@ -0,0 +1,255 @@
+// Filename: texToKtx.cxx
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "texToKtx.h"
+#include "loaderOptions.h"
+#include "string_utils.h"
+#include "pystub.h"
+
+////////////////////////////////////////////////////////////////////
+//     Function: TexToKtx::Constructor
+//       Access: Public
+//  Description:
+////////////////////////////////////////////////////////////////////
+TexToKtx::
+TexToKtx() : WithOutputFile(true, false, true)
+{
+  set_program_brief("convert a texture into a .ktx file");
+  set_program_description
+    ("This program reads a texture in any form that Panda can load, "
+     "including an ordinary image file, a .txo or .dds file, or a numbered "
+     "sequence of image files, and writes it out as a KTX file.  The "
+     "mipmap levels of the texture may be generated, and the texture "
+     "compressed, ahead of time, so that Panda can later load the file "
+     "directly into the texture's memory and hand it to the graphics "
+     "card with no further processing.");
+
+  clear_runlines();
+  add_runline("[opts] input output.ktx");
+  add_runline("[opts] -o output.ktx input");
+
+  add_option
+    ("o", "filename", 0,
+     "Specify the filename to which the resulting .ktx file will be written.  "
+     "If this option is omitted, the last parameter name is taken to be the "
+     "name of the output file.",
+     &TexToKtx::dispatch_filename, &_got_output_filename, &_output_filename);
+
+  add_option
+    ("type", "type", 0,
+     "Specify the type of texture to read: 1d_texture, 2d_texture, "
+     "3d_texture, 2d_texture_array, or cube_map.  For the last three, the "
+     "input filename should contain a sequence of hash marks, which are "
+     "filled in with the number of each page to read, starting from 0.  "
+     "The default is 2d_texture.",
+     &TexToKtx::dispatch_texture_type, NULL, &_texture_type);
+
+  add_option
+    ("c", "compression", 0,
+     "Compress the texture with the indicated compression mode, for "
+     "instance dxt1 or dxt5, before writing it.  Panda can only "
+     "compress textures itself if it was built with the squish library.  "
+     "The default is to write the texture in the compression mode in "
+     "which it was read, which is usually uncompressed.",
+     &TexToKtx::dispatch_compression, &_got_compression, &_compression);
+
+  add_option
+    ("q", "quality", 0,
+     "Specify the quality level to use when compressing: fastest, normal, "
+     "or best.  The default is the value of texture-quality-level.",
+     &TexToKtx::dispatch_quality_level, NULL, &_quality_level);
+
+  add_option
+    ("m", "", 0,
+     "Generate all of the mipmap levels of the texture, and write them "
+     "to the file along with the base image.",
+     &TexToKtx::dispatch_none, &_mipmaps);
+
+  _preferred_extension = ".ktx";
+  _texture_type = Texture::TT_2d_texture;
+  _compression = Texture::CM_off;
+  _quality_level = Texture::QL_default;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TexToKtx::run
+//       Access: Public
+//  Description:
+////////////////////////////////////////////////////////////////////
+void TexToKtx::
+run() {
+  PT(Texture) tex = new Texture(_input_filename.get_basename_wo_extension());
+
+  bool read_pages = false;
+  switch (_texture_type) {
+  case Texture::TT_1d_texture:
+    tex->setup_1d_texture();
+    break;
+
+  case Texture::TT_3d_texture:
+    tex->setup_3d_texture();
+    read_pages = true;
+    break;
+
+  case Texture::TT_2d_texture_array:
+    tex->setup_2d_texture_array();
+    read_pages = true;
+    break;
+
+  case Texture::TT_cube_map:
+    tex->setup_cube_map();
+    read_pages = true;
+    break;
+
+  default:
+    break;
+  }
+
+  LoaderOptions options;
+  options.set_texture_flags(LoaderOptions::TF_preload);
+  if (!tex->read(_input_filename, Filename(), 0, 0, 0, 0,
+                 read_pages, false, NULL, options)) {
+    nout << "Unable to read " << _input_filename << "\n";
+    exit(1);
+  }
+
+  if (_mipmaps) {
+    if (tex->get_ram_image_compression() != Texture::CM_off) {
+      tex->uncompress_ram_image();
+    }
+    tex->generate_ram_mipmap_images();
+  }
+
+  if (_got_compression && _compression != tex->get_ram_image_compression()) {
+    if (_compression == Texture::CM_off) {
+      if (!tex->uncompress_ram_image()) {
+        nout << "Unable to uncompress " << _input_filename << "\n";
+        exit(1);
+      }
+    } else {
+      if (tex->get_ram_image_compression() != Texture::CM_off) {
+        tex->uncompress_ram_image();
+      }
+      if (!tex->compress_ram_image(_compression, _quality_level)) {
+        nout << "Unable to compress " << _input_filename << " with "
+             << _compression << "\n";
+        exit(1);
+      }
+    }
+  }
+
+  // This should be guaranteed because we pass false to the
+  // constructor, above.
+  nassertv(has_output_filename());
+
+  Filename filename = get_output_filename();
+  nout << "Writing " << filename << ": " << tex->get_x_size() << " x "
+       << tex->get_y_size() << " x " << tex->get_z_size() << ", "
+       << tex->get_num_ram_mipmap_images() << " mipmap levels, compression "
+       << tex->get_ram_image_compression() << "\n";
+
+  if (!tex->write_ktx(get_output(), filename)) {
+    nout << "Error in writing.\n";
+    exit(1);
+  }
+  close_output();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TexToKtx::handle_args
+//       Access: Protected, Virtual
+//  Description:
+////////////////////////////////////////////////////////////////////
+bool TexToKtx::
+handle_args(ProgramBase::Args &args) {
+  if (!check_last_arg(args, 1)) {
+    return false;
+  }
+
+  if (args.empty()) {
+    nout << "You must specify the texture to read on the command line.\n";
+    return false;
+  }
+
+  if (args.size() > 1) {
+    nout << "Specify only one texture on the command line.\n";
+    return false;
+  }
+
+  _input_filename = Filename::from_os_specific(args[0]);
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TexToKtx::dispatch_texture_type
+//       Access: Private, Static
+//  Description: Reads a texture type for the -type option.
+////////////////////////////////////////////////////////////////////
+bool TexToKtx::
+dispatch_texture_type(const string &opt, const string &arg, void *var) {
+  Texture::TextureType *ip = (Texture::TextureType *)var;
+  (*ip) = Texture::string_texture_type(arg);
+  if ((*ip) == Texture::TT_2d_texture && cmp_nocase(arg, "2d_texture") != 0) {
+    nout << "Invalid texture type for -" << opt << ": " << arg << "\n";
+    return false;
+  }
+  if ((*ip) == Texture::TT_buffer_texture) {
+    nout << "Cannot write a buffer texture to a KTX file.\n";
+    return false;
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TexToKtx::dispatch_compression
+//       Access: Private, Static
+//  Description: Reads a compression mode for the -c option.
+////////////////////////////////////////////////////////////////////
+bool TexToKtx::
+dispatch_compression(const string &opt, const string &arg, void *var) {
+  Texture::CompressionMode *ip = (Texture::CompressionMode *)var;
+  (*ip) = Texture::string_compression_mode(arg);
+  if ((*ip) == Texture::CM_default && arg != "default") {
+    nout << "Invalid compression mode for -" << opt << ": " << arg << "\n";
+    return false;
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TexToKtx::dispatch_quality_level
+//       Access: Private, Static
+//  Description: Reads a quality level for the -q option.
+////////////////////////////////////////////////////////////////////
+bool TexToKtx::
+dispatch_quality_level(const string &opt, const string &arg, void *var) {
+  Texture::QualityLevel *ip = (Texture::QualityLevel *)var;
+  (*ip) = Texture::string_quality_level(arg);
+
+  return true;
+}
+
+
+int main(int argc, char *argv[]) {
+  // A call to pystub() to force libpystub.so to be linked in.
+  pystub();
+
+  TexToKtx prog;
+  prog.parse_command_line(argc, argv);
+  prog.run();
+  return 0;
+}
@@ -0,0 +1,58 @@
+// Filename: texToKtx.h
+// Created by:  kestred (19Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef TEXTOKTX_H
+#define TEXTOKTX_H
+
+#include "pandatoolbase.h"
+
+#include "programBase.h"
+#include "withOutputFile.h"
+#include "filename.h"
+#include "texture.h"
+
+////////////////////////////////////////////////////////////////////
+//       Class : TexToKtx
+// Description : This program reads a texture in any format Panda can
+//               load--an image file, a txo or dds file, or a
+//               numbered sequence of image files for a cube map or a
+//               3-d texture--and writes it out as a KTX file, with
+//               its mipmap levels optionally generated and
+//               pre-compressed, so that it can be loaded at runtime
+//               with no further processing.
+////////////////////////////////////////////////////////////////////
+class TexToKtx : public ProgramBase, public WithOutputFile {
+public:
+  TexToKtx();
+
+  void run();
+
+protected:
+  virtual bool handle_args(Args &args);
+
+private:
+  static bool dispatch_texture_type(const string &opt, const string &arg, void *var);
+  static bool dispatch_compression(const string &opt, const string &arg, void *var);
+  static bool dispatch_quality_level(const string &opt, const string &arg, void *var);
+
+private:
+  Filename _input_filename;
+  Texture::TextureType _texture_type;
+  Texture::CompressionMode _compression;
+  Texture::QualityLevel _quality_level;
+  bool _got_compression;
+  bool _mipmaps;
+};
+
+#endif